@@ -43,7 +43,10 @@ GOBJ_DEFINE_EVENT(EV_DISCONNECT);
 GOBJ_DEFINE_EVENT(EV_DISCONNECTED);
 GOBJ_DEFINE_EVENT(EV_RX_DATA);
 GOBJ_DEFINE_EVENT(EV_TX_DATA);
+GOBJ_DEFINE_EVENT(EV_TX_FILE);
 GOBJ_DEFINE_EVENT(EV_TX_READY);
+GOBJ_DEFINE_EVENT(EV_PAUSE_RX);
+GOBJ_DEFINE_EVENT(EV_RESUME_RX);
 GOBJ_DEFINE_EVENT(EV_STOPPED);
 
 GOBJ_DEFINE_EVENT(EV_EDIT_CONFIG);
@@ -49,7 +49,10 @@ GOBJ_DECLARE_EVENT(EV_DISCONNECT);
 GOBJ_DECLARE_EVENT(EV_DISCONNECTED);
 GOBJ_DECLARE_EVENT(EV_RX_DATA);
 GOBJ_DECLARE_EVENT(EV_TX_DATA);
+GOBJ_DECLARE_EVENT(EV_TX_FILE);         // {path, offset, length}: transmit a file range
 GOBJ_DECLARE_EVENT(EV_TX_READY);
+GOBJ_DECLARE_EVENT(EV_PAUSE_RX);       // flow control: stop reading the transport
+GOBJ_DECLARE_EVENT(EV_RESUME_RX);
 GOBJ_DECLARE_EVENT(EV_STOPPED);
 
 GOBJ_DECLARE_EVENT(EV_EDIT_CONFIG);
@@ -88,6 +88,8 @@ PUBLIC gbuffer_t *gbuffer_create(
 
     gbuf->tail = 0;
     gbuf->curp = 0;
+    gbuf->utf8_curp = 0;
+    gbuf->utf8_tail = 0;
     gbuf->refcount = 1;
 
     /*----------------------------*
@@ -269,6 +271,35 @@ PUBLIC char *gbuffer_getline(gbuffer_t *gbuf, char separator)
     return begin;
 }
 
+/***************************************************************************
+ *  Validate the readable data as UTF-8, remember the validated range
+ ***************************************************************************/
+PUBLIC BOOL gbuffer_utf8_validate(gbuffer_t *gbuf)
+{
+    if(!gbuf) {
+        gobj_log_error(0, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "gbuf is NULL",
+            NULL
+        );
+        return FALSE;
+    }
+    if(gbuf->utf8_tail &&
+            gbuf->utf8_tail == gbuf->tail &&
+            gbuf->utf8_curp == gbuf->curp) {
+        return TRUE;
+    }
+
+    if(!utf8_validate(gbuf->data + gbuf->curp, gbuf->tail - gbuf->curp)) {
+        return FALSE;
+    }
+    gbuf->utf8_curp = gbuf->curp;
+    gbuf->utf8_tail = gbuf->tail;
+    return TRUE;
+}
+
+
 
 
 
@@ -297,6 +328,7 @@ PUBLIC int gbuffer_set_wr(gbuffer_t *gbuf, size_t offset)
         return -1;
     }
     gbuf->tail = offset;
+    gbuf->utf8_tail = 0;
 
     /*
      *  Put final null
@@ -1164,6 +1196,7 @@ PUBLIC json_t *gbuf2json(
 {
     size_t flags = JSON_DECODE_ANY|JSON_ALLOW_NUL;
     json_error_t jn_error;
+
     char *p = gbuffer_cur_rd_pointer(gbuf);
     json_t *jn_msg = json_loads(p, flags, &jn_error);
 
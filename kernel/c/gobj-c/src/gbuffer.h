@@ -46,6 +46,13 @@ typedef struct gbuffer_s {
     size_t tail;    /* write pointer */
     size_t curp;    /* read pointer */
 
+    /*
+     *  Readable range [utf8_curp, utf8_tail) validated by gbuffer_utf8_validate().
+     *  utf8_tail 0 is not validated.
+     */
+    size_t utf8_curp;
+    size_t utf8_tail;
+
     /*
      *  Data dynamically allocated
      *  In file_mode this buffer only is for read from file.
@@ -137,6 +144,7 @@ static inline int gbuffer_ungetc(gbuffer_t *gbuf, char c) /* Unget char */
         gbuf->curp--;
 
         *(gbuf->data + gbuf->curp) = c;
+        gbuf->utf8_tail = 0;
     }
 
     return 0;
@@ -169,6 +177,19 @@ static inline size_t gbuffer_chunk(gbuffer_t *gbuf) /* return the chunk of data
 
 PUBLIC char *gbuffer_getline(gbuffer_t *gbuf, char separator); /* Separator is not included */
 
+/*
+ *  Return TRUE if the readable data is valid UTF-8.
+ *  The result is cached: validating again an unchanged gbuffer costs nothing.
+ *  WARNING if you modify data in place (not through gbuffer_append/set_wr)
+ *  reset the cache with gbuffer_utf8_invalidate().
+ */
+PUBLIC BOOL gbuffer_utf8_validate(gbuffer_t *gbuf);
+
+static inline void gbuffer_utf8_invalidate(gbuffer_t *gbuf)
+{
+    gbuf->utf8_tail = 0;
+}
+
 /*
  *  WRITING
  */
@@ -190,6 +211,7 @@ static inline void gbuffer_reset_wr(gbuffer_t *gbuf) /* reset write pointer (emp
 {
     gbuf->tail = 0;
     gbuf->curp = 0;
+    gbuf->utf8_tail = 0;
     *(gbuf->data + gbuf->tail) = 0; /* Put final null */
 }
 
@@ -82,6 +82,8 @@ typedef struct gclass_s {
     const LMETHOD *lmt;
 
     const sdata_desc_t *attrs_table;
+    json_t *jn_attrs_index;         // attr name -> slot (index in attrs_table)
+    int attrs_slots;                // items in attrs_table
     size_t priv_size;
     const sdata_desc_t *authz_table; // acl
     /*
@@ -94,6 +96,9 @@ typedef struct gclass_s {
     const trace_level_t *s_user_trace_level;    // up to 16
     gclass_flag_t gclass_flag;
 
+    const sdata_desc_t *stats_table; // native stat slots, see gclass_set_stats_table()
+    int stats_slots;
+
     int32_t instances;              // instances of this gclass
     uint32_t trace_level;
     uint32_t no_trace_level;
@@ -121,7 +126,9 @@ typedef struct gobj_s {
     // Data allocated
     char *gobj_name;
     json_t *jn_attrs;
+    json_t **attr_values;   // by attr slot, values of jn_attrs (NOT owned)
     json_t *jn_stats;
+    json_int_t *stat_slots; // one per item of gclass->stats_table
     json_t *jn_user_data;
     const char *full_name;
     const char *short_name;
@@ -199,6 +206,12 @@ PRIVATE int rc_walk_by_level(
 );
 
 PRIVATE int set_default(gobj_t *gobj, json_t *sdata, const sdata_desc_t *it);
+PRIVATE int attr_set_new(
+    gobj_t *gobj,
+    json_t *sdata,
+    const sdata_desc_t *it,
+    json_t *jn_value // owned
+);
 PUBLIC void trace_vjson(
     hgobj gobj,
     int priority,
@@ -236,6 +249,9 @@ PRIVATE hgobj gobj_create_tree0(
     json_t *jn_tree, // owned
     BOOL top_service
 );
+PRIVATE json_t *gbuffer_payload_json(void *ptr);
+PRIVATE void gbuffer_iov_payload_free(void *ptr);
+PRIVATE json_t *gbuffer_iov_payload_json(void *ptr);
 
 /***************************************************************
  *              Data
@@ -279,6 +295,9 @@ PUBLIC const char *event_flag_names[] = { // Strings of event_flag_t type
     "EVF_OUTPUT_EVENT",
     "EVF_SYSTEM_EVENT",
     "EVF_PUBLIC_EVENT",
+    "EVF_AUTHZ_INJECT",
+    "EVF_AUTHZ_SUBSCRIBE",
+    "EVF_PAYLOAD",
     0
 };
 
@@ -310,6 +329,28 @@ PRIVATE const char *gobj_flag_names[] = {
 PRIVATE dl_list_t dl_global_event_types;
 
 PRIVATE int  __inside__ = 0;  // it's a counter
+
+/*
+ *  Typed event payloads
+ */
+struct gobj_payload_s {
+    int refcount;
+    payload_type_t type;
+    void *ptr;
+};
+
+#define MAX_PAYLOAD_TYPES 32
+typedef struct {
+    const char *name;
+    payload_free_fn_t free_fn;
+    payload_json_fn_t json_fn;
+} payload_type_desc_t;
+
+PRIVATE payload_type_desc_t payload_types[MAX_PAYLOAD_TYPES+1]; // type 0 not used
+PRIVATE int max_payload_type = 0;
+PRIVATE payload_type_t payload_type_gbuffer = 0;
+PRIVATE payload_type_t payload_type_gbuffer_iov = 0;
+PRIVATE gobj_payload_t *__event_payload__ = 0; // payload of the event in execution
 PRIVATE volatile int  __shutdowning__ = 0;
 PRIVATE int  __exit_code__ = 0;
 PRIVATE json_t * (*__global_command_parser_fn__)(
@@ -598,6 +639,17 @@ PUBLIC int gobj_start_up(
         (decref_fn_t)gbuffer_decref
     );
 
+    payload_type_gbuffer = gobj_payload_type_register(
+        "gbuffer",
+        (payload_free_fn_t)gbuffer_decref,
+        gbuffer_payload_json
+    );
+    payload_type_gbuffer_iov = gobj_payload_type_register(
+        "gbuffer_iov",
+        gbuffer_iov_payload_free,
+        gbuffer_iov_payload_json
+    );
+
     __initialized__ = TRUE;
 
     return 0;
@@ -696,6 +748,11 @@ PUBLIC void gobj_end(void)
         GBMEM_FREE(event_type);
     }
 
+    memset(payload_types, 0, sizeof(payload_types));
+    max_payload_type = 0;
+    payload_type_gbuffer = 0;
+    payload_type_gbuffer_iov = 0;
+
     JSON_DECREF(__jn_services__)
     JSON_DECREF(__jn_extra_global_vars__)
     JSON_DECREF(__jn_global_settings__)
@@ -805,6 +862,31 @@ PUBLIC hgclass gclass_create( // create and register gclass
     gclass->s_user_trace_level = s_user_trace_level;
     gclass->gclass_flag = gclass_flag;
 
+    /*----------------------------------------*
+     *  Index attrs: name -> slot
+     *----------------------------------------*/
+    gclass->jn_attrs_index = json_object();
+    if(!gclass->jn_attrs_index) {
+        gobj_log_error(NULL, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY,
+            "msg",          "%s", "No memory",
+            "gclass_name",  "%s", gclass_name,
+            NULL
+        );
+        gclass_unregister(gclass);
+        return NULL;
+    }
+    const sdata_desc_t *it = attrs_table;
+    while(it && it->name) {
+        int slot = (int)(it - attrs_table);
+        if(!json_object_get(gclass->jn_attrs_index, it->name)) { // the first one wins, as before
+            json_object_set_new(gclass->jn_attrs_index, it->name, json_integer(slot));
+        }
+        gclass->attrs_slots = slot + 1;
+        it++;
+    }
+
     /*----------------------------------------*
      *          Build States
      *----------------------------------------*/
@@ -867,6 +949,60 @@ PUBLIC hgclass gclass_create( // create and register gclass
     return gclass;
 }
 
+/***************************************************************************
+ *  Set the native stat slots of the gclass.
+ *  The slot of a stat is its index in stats_table.
+ *  Set it before creating instances.
+ ***************************************************************************/
+PUBLIC int gclass_set_stats_table(
+    hgclass hgclass,
+    const sdata_desc_t *stats_table
+) {
+    gclass_t *gclass = (gclass_t *)hgclass;
+    if(!gclass) {
+        gobj_log_error(NULL, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "hgclass NULL",
+            NULL
+        );
+        return -1;
+    }
+    if(gclass->instances > 0) {
+        gobj_log_error(NULL, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "gclass with instances, cannot change the stats table",
+            "gclass",       "%s", gclass->gclass_name,
+            "instances",    "%d", (int)gclass->instances,
+            NULL
+        );
+        return -1;
+    }
+
+    int n = 0;
+    const sdata_desc_t *it = stats_table;
+    while(it && it->name) {
+        if(!DTP_IS_INTEGER(it->type)) {
+            gobj_log_error(NULL, LOG_OPT_TRACE_STACK,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PARAMETER,
+                "msg",          "%s", "stat slot must be DTP_INTEGER",
+                "gclass",       "%s", gclass->gclass_name,
+                "stat",         "%s", it->name,
+                NULL
+            );
+            return -1;
+        }
+        n++;
+        it++;
+    }
+
+    gclass->stats_table = stats_table;
+    gclass->stats_slots = n;
+    return 0;
+}
+
 /***************************************************************************
  *
  ***************************************************************************/
@@ -1123,6 +1259,8 @@ PUBLIC void gclass_unregister(hgclass hgclass)
         GBMEM_FREE(event_type);
     }
 
+    JSON_DECREF(gclass->jn_attrs_index)
+
     dl_delete(&dl_gclass, gclass, gbmem_free);
 }
 
@@ -1689,12 +1827,33 @@ PUBLIC hgobj gobj_create2(
 
     gobj->gobj_name = gbmem_strdup(gobj_name);
     gobj->jn_attrs = gobj_sdata_create(gobj, gclass->attrs_table);
+    if(gobj->jn_attrs && gclass->attrs_slots > 0) {
+        gobj->attr_values = GBMEM_MALLOC(gclass->attrs_slots * sizeof(json_t *));
+        if(gobj->attr_values) {
+            for(int i=0; i<gclass->attrs_slots; i++) {
+                gobj->attr_values[i] = json_object_get(
+                    gobj->jn_attrs, gclass->attrs_table[i].name
+                );
+            }
+        }
+    }
     gobj->jn_stats = json_object();
     gobj->jn_user_data = json_object();
     gobj->priv = gclass->priv_size? GBMEM_MALLOC(gclass->priv_size):NULL;
+    if(gclass->stats_slots > 0) {
+        gobj->stat_slots = GBMEM_MALLOC(gclass->stats_slots * sizeof(json_int_t));
+        if(gobj->stat_slots) {
+            for(int i=0; i<gclass->stats_slots; i++) {
+                const char *default_value = gclass->stats_table[i].default_value;
+                gobj->stat_slots[i] = default_value? atoll(default_value):0;
+            }
+        }
+    }
 
     if(!gobj->gobj_name || !gobj->jn_user_data || !gobj->jn_stats ||
-            !gobj->jn_attrs || (gclass->priv_size && !gobj->priv)) {
+            !gobj->jn_attrs || (gclass->attrs_slots > 0 && !gobj->attr_values) ||
+            (gclass->priv_size && !gobj->priv) ||
+            (gclass->stats_slots > 0 && !gobj->stat_slots)) {
         gobj_log_error(0, LOG_OPT_TRACE_STACK,
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_MEMORY,
@@ -2494,6 +2653,7 @@ PUBLIC void gobj_destroy(hgobj hgobj)
      *      Dealloc data
      *--------------------------------*/
     JSON_DECREF(gobj->jn_attrs)
+    EXEC_AND_RESET(gbmem_free, gobj->attr_values)
     JSON_DECREF(gobj->jn_stats)
     JSON_DECREF(gobj->jn_user_data)
     JSON_DECREF(gobj->dl_subscribings)
@@ -2503,6 +2663,7 @@ PUBLIC void gobj_destroy(hgobj hgobj)
     EXEC_AND_RESET(gbmem_free, gobj->full_name)
     EXEC_AND_RESET(gbmem_free, gobj->short_name)
     EXEC_AND_RESET(gbmem_free, gobj->priv)
+    EXEC_AND_RESET(gbmem_free, gobj->stat_slots)
 
     if(gobj->obflag & obflag_created) {
         gobj->gclass->instances--;
@@ -3205,7 +3366,7 @@ PRIVATE int set_default(gobj_t *gobj, json_t *sdata, const sdata_desc_t *it)
         jn_value = json_null();
     }
 
-    if(json_object_set_new(sdata, it->name, jn_value)<0) {
+    if(attr_set_new(gobj, sdata, it, jn_value)<0) {
         gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_JSON,
@@ -3350,7 +3511,7 @@ PRIVATE int json2item(
             break;
     }
 
-    if(json_object_set_new(sdata, it->name, jn_value2)<0) {
+    if(attr_set_new(gobj, sdata, it, jn_value2)<0) {
         gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_JSON,
@@ -3390,6 +3551,77 @@ PRIVATE json_t *gobj_hsdata(hgobj gobj_) // Return is NOT YOURS
     return gobj?gobj->jn_attrs:NULL;
 }
 
+/***************************************************************************
+ *  Slot of `it` if sdata is the gobj's jn_attrs, else -1
+ ***************************************************************************/
+PRIVATE int attr_cached_slot(gobj_t *gobj, json_t *sdata, const sdata_desc_t *it)
+{
+    const sdata_desc_t *attrs_table = gobj->gclass->attrs_table;
+    if(sdata == gobj->jn_attrs && gobj->attr_values &&
+            it >= attrs_table && it < attrs_table + gobj->gclass->attrs_slots) {
+        return (int)(it - attrs_table);
+    }
+    return -1;
+}
+
+/***************************************************************************
+ *  Set the value of an attribute in sdata.
+ *  If sdata is the gobj's jn_attrs then keep the slot value in sync.
+ ***************************************************************************/
+PRIVATE int attr_set_new(
+    gobj_t *gobj,
+    json_t *sdata,
+    const sdata_desc_t *it,
+    json_t *jn_value // owned
+)
+{
+    int ret = json_object_set_new(sdata, it->name, jn_value);
+
+    int slot = attr_cached_slot(gobj, sdata, it);
+    if(slot >= 0) {
+        gobj->attr_values[slot] = (ret < 0)? json_object_get(sdata, it->name) : jn_value;
+    }
+    return ret;
+}
+
+/***************************************************************************
+ *  Current value of an attribute in sdata, NOT YOURS
+ ***************************************************************************/
+PRIVATE json_t *attr_get(gobj_t *gobj, json_t *sdata, const sdata_desc_t *it)
+{
+    int slot = attr_cached_slot(gobj, sdata, it);
+    if(slot >= 0) {
+        return gobj->attr_values[slot];
+    }
+    return json_object_get(sdata, it->name);
+}
+
+/***************************************************************************
+ *  Integers (and pointers) are updated in place, without alloc,
+ *  when the value is not shared with anybody.
+ ***************************************************************************/
+PRIVATE int attr_set_integer(gobj_t *gobj, json_t *sdata, const sdata_desc_t *it, json_int_t value)
+{
+    json_t *jn_value = attr_get(gobj, sdata, it);
+    if(json_is_integer(jn_value) && jn_value->refcount == 1) {
+        return json_integer_set(jn_value, value);
+    }
+    return attr_set_new(gobj, sdata, it, json_integer(value));
+}
+
+/***************************************************************************
+ *  Reals are updated in place, without alloc,
+ *  when the value is not shared with anybody.
+ ***************************************************************************/
+PRIVATE int attr_set_real(gobj_t *gobj, json_t *sdata, const sdata_desc_t *it, double value)
+{
+    json_t *jn_value = attr_get(gobj, sdata, it);
+    if(json_is_real(jn_value) && jn_value->refcount == 1) {
+        return json_real_set(jn_value, value);
+    }
+    return attr_set_new(gobj, sdata, it, json_real(value));
+}
+
 /***************************************************************************
  *
  ***************************************************************************/
@@ -3426,12 +3658,9 @@ PUBLIC const sdata_desc_t *gclass_attr_desc(hgclass gclass_, const char *attr, B
     if(!attr) {
         return gclass->attrs_table;
     }
-    const sdata_desc_t *it = gclass->attrs_table;
-    while(it->name) {
-        if(strcmp(it->name, attr)==0) {
-            return it;
-        }
-        it++;
+    json_t *jn_slot = json_object_get(gclass->jn_attrs_index, attr);
+    if(jn_slot) {
+        return &gclass->attrs_table[json_integer_value(jn_slot)];
     }
 
     if(verbose) {
@@ -3544,8 +3773,20 @@ PUBLIC int gobj_reset_volatil_attrs(hgobj gobj)
  *  ATTR: write
  *  Reset rstats attributes
  ***************************************************************************/
-PUBLIC int gobj_reset_rstats_attrs(hgobj gobj)
+PUBLIC int gobj_reset_rstats_attrs(hgobj gobj_)
 {
+    gobj_t *gobj = gobj_;
+
+    /*
+     *  The SDF_RSTATS native stat slots too
+     */
+    for(int i=0; gobj->stat_slots && i<gobj->gclass->stats_slots; i++) {
+        const sdata_desc_t *it = &gobj->gclass->stats_table[i];
+        if(it->flag & SDF_RSTATS) {
+            gobj->stat_slots[i] = it->default_value? atoll(it->default_value):0;
+        }
+    }
+
     return sdata_write_default_values(
         gobj,
         SDF_RSTATS,     // include_flag
@@ -3815,7 +4056,7 @@ PUBLIC const char *gobj_read_str_attr(hgobj gobj_, const char *name)
 {
     gobj_t *gobj = gobj_;
 
-    if(name && strcasecmp(name, "__state__")==0) {
+    if(name && name[0]=='_' && strcasecmp(name, "__state__")==0) {
         return gobj_current_state(gobj);
     }
 
@@ -3851,7 +4092,7 @@ PUBLIC BOOL gobj_read_bool_attr(hgobj gobj_, const char *name)
 {
     gobj_t *gobj = gobj_;
 
-    if(name) {
+    if(name && name[0]=='_') { // quick skip of the common case
         if(strcasecmp(name, "__disabled__")==0) {
             return gobj_is_disabled(gobj);
         } else if(strcasecmp(name, "__running__")==0) {
@@ -3895,7 +4136,7 @@ PUBLIC json_int_t gobj_read_integer_attr(hgobj gobj_, const char *name)
 {
     gobj_t *gobj = gobj_;
 
-    if(name && strcasecmp(name, "__trace_level__")==0) {
+    if(name && name[0]=='_' && strcasecmp(name, "__trace_level__")==0) {
         return gobj_trace_level(gobj);
     }
 
@@ -4029,8 +4270,9 @@ PUBLIC int gobj_write_str_attr(hgobj gobj_, const char *name, const char *value)
 
     json_t *hs = gobj_hsdata2(gobj, name, &gobj);
     if(hs) {
+        const sdata_desc_t *it = gclass_attr_desc(gobj->gclass, name, FALSE);
         // WARNING value == 0  -> json_null()
-        int ret = json_object_set_new(hs, name, value?json_string(value):json_null());
+        int ret = attr_set_new(gobj, hs, it, value?json_string(value):json_null());
         if(gobj->gclass->gmt->mt_writing) {
             if((gobj->obflag & obflag_created) && !(gobj->obflag & obflag_destroyed)) {
                 // Avoid call to mt_writing before mt_create!
@@ -4060,6 +4302,7 @@ PUBLIC int gobj_write_strn_attr(hgobj gobj_, const char *name, const char *value
 
     json_t *hs = gobj_hsdata2(gobj, name, &gobj);
     if(hs) {
+        const sdata_desc_t *it = gclass_attr_desc(gobj->gclass, name, FALSE);
         char *value = gbmem_strndup(value_, len);
         if(!value) {
             gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
@@ -4074,7 +4317,7 @@ PUBLIC int gobj_write_strn_attr(hgobj gobj_, const char *name, const char *value
             return -1;
         }
 
-        int ret = json_object_set_new(hs, name, json_string(value));
+        int ret = attr_set_new(gobj, hs, it, json_string(value));
         if(gobj->gclass->gmt->mt_writing) {
             if((gobj->obflag & obflag_created) && !(gobj->obflag & obflag_destroyed)) {
                 // Avoid call to mt_writing before mt_create!
@@ -4107,7 +4350,8 @@ PUBLIC int gobj_write_bool_attr(hgobj gobj_, const char *name, BOOL value)
 
     json_t *hs = gobj_hsdata2(gobj, name, &gobj);
     if(hs) {
-        int ret = json_object_set_new(hs, name, json_boolean(value));
+        const sdata_desc_t *it = gclass_attr_desc(gobj->gclass, name, FALSE);
+        int ret = attr_set_new(gobj, hs, it, json_boolean(value));
         if(gobj->gclass->gmt->mt_writing) {
             if((gobj->obflag & obflag_created) && !(gobj->obflag & obflag_destroyed)) {
                 // Avoid call to mt_writing before mt_create!
@@ -4137,7 +4381,8 @@ PUBLIC int gobj_write_integer_attr(hgobj gobj_, const char *name, json_int_t val
 
     json_t *hs = gobj_hsdata2(gobj, name, &gobj);
     if(hs) {
-        int ret = json_object_set_new(hs, name, json_integer(value));
+        const sdata_desc_t *it = gclass_attr_desc(gobj->gclass, name, FALSE);
+        int ret = attr_set_integer(gobj, hs, it, value);
         if(gobj->gclass->gmt->mt_writing) {
             if((gobj->obflag & obflag_created) && !(gobj->obflag & obflag_destroyed)) {
                 // Avoid call to mt_writing before mt_create!
@@ -4167,7 +4412,8 @@ PUBLIC int gobj_write_real_attr(hgobj gobj_, const char *name, double value)
 
     json_t *hs = gobj_hsdata2(gobj, name, &gobj);
     if(hs) {
-        int ret = json_object_set_new(hs, name, json_real(value));
+        const sdata_desc_t *it = gclass_attr_desc(gobj->gclass, name, FALSE);
+        int ret = attr_set_real(gobj, hs, it, value);
         if(gobj->gclass->gmt->mt_writing) {
             if((gobj->obflag & obflag_created) && !(gobj->obflag & obflag_destroyed)) {
                 // Avoid call to mt_writing before mt_create!
@@ -4197,7 +4443,8 @@ PUBLIC int gobj_write_json_attr(hgobj gobj_, const char *name, json_t *jn_value)
 
     json_t *hs = gobj_hsdata2(gobj, name, &gobj);
     if(hs) {
-        int ret = json_object_set(hs, name, jn_value);
+        const sdata_desc_t *it = gclass_attr_desc(gobj->gclass, name, FALSE);
+        int ret = attr_set_new(gobj, hs, it, json_incref(jn_value));
         if(gobj->gclass->gmt->mt_writing) {
             if((gobj->obflag & obflag_created) && !(gobj->obflag & obflag_destroyed)) {
                 // Avoid call to mt_writing before mt_create!
@@ -4228,7 +4475,8 @@ PUBLIC int gobj_write_new_json_attr(hgobj gobj_, const char *name, json_t *jn_va
 
     json_t *hs = gobj_hsdata2(gobj, name, &gobj);
     if(hs) {
-        int ret = json_object_set_new(hs, name, jn_value);
+        const sdata_desc_t *it = gclass_attr_desc(gobj->gclass, name, FALSE);
+        int ret = attr_set_new(gobj, hs, it, jn_value);
         if(gobj->gclass->gmt->mt_writing) {
             if((gobj->obflag & obflag_created) && !(gobj->obflag & obflag_destroyed)) {
                 // Avoid call to mt_writing before mt_create!
@@ -4259,7 +4507,8 @@ PUBLIC int gobj_write_pointer_attr(hgobj gobj_, const char *name, void *value)
 
     json_t *hs = gobj_hsdata2(gobj, name, &gobj);
     if(hs) {
-        int ret = json_object_set_new(hs, name, json_integer((json_int_t)(uintptr_t)value));
+        const sdata_desc_t *it = gclass_attr_desc(gobj->gclass, name, FALSE);
+        int ret = attr_set_integer(gobj, hs, it, (json_int_t)(uintptr_t)value);
         if(gobj->gclass->gmt->mt_writing) {
             if((gobj->obflag & obflag_created) && !(gobj->obflag & obflag_destroyed)) {
                 // Avoid call to mt_writing before mt_create!
@@ -4280,140 +4529,402 @@ PUBLIC int gobj_write_pointer_attr(hgobj gobj_, const char *name, void *value)
     return -1;
 }
 
-
-
-
-                    /*---------------------------------*
-                     *  Operational functions
-                     *---------------------------------*/
-
-
-
+/*
+ *  Attribute slots: the index of the attribute in the gclass's attrs_table.
+ *  WITHOUT bottom inheritance, resolve the slot once and then
+ *  read/write without name lookup.
+ */
 
 /***************************************************************************
- *
+ *  Return the slot of the attribute `name` of gobj, -1 if not found
  ***************************************************************************/
-PRIVATE json_t *gobj_check_required_attrs(gobj_t *gobj)
+PUBLIC int gobj_attr_slot(hgobj gobj_, const char *name)
 {
-    json_t *hs = gobj_hsdata(gobj);
-    json_t *jn_required_attrs = json_array();
-
-    const sdata_desc_t *it = gobj->gclass->attrs_table;
-    while(it->name) {
-        if(it->flag & SDF_REQUIRED) {
-            const json_t *jn_value = json_object_get(hs, it->name);
-            switch(it->type) {
-                case DTP_STRING:
-                    if(empty_string(json_string_value(jn_value))) {
-                        json_array_append_new(jn_required_attrs, json_string(it->name));
-                    }
-                    break;
-                case DTP_LIST:
-                case DTP_DICT:
-                case DTP_JSON:
-                    if(empty_json(jn_value)) {
-                        json_array_append_new(jn_required_attrs, json_string(it->name));
-                    }
-                    break;
-                case DTP_POINTER:
-                    if(!json_integer_value(jn_value)) {
-                        json_array_append_new(jn_required_attrs, json_string(it->name));
-                    }
-                    break;
-                case DTP_BOOLEAN:
-                case DTP_INTEGER:
-                case DTP_REAL:
-                    break;
-            }
-        }
-        it++;
+    gobj_t *gobj = gobj_;
+    if(!gobj || empty_string(name)) { // WARNING must be a silence function!
+        return -1;
     }
-    if(json_array_size(jn_required_attrs)==0) {
-        JSON_DECREF(jn_required_attrs)
+    json_t *jn_slot = json_object_get(gobj->gclass->jn_attrs_index, name);
+    if(!jn_slot) {
+        return -1;
     }
-    return jn_required_attrs;
+    return (int)json_integer_value(jn_slot);
 }
 
 /***************************************************************************
- *  Execute internal method
+ *  Check the slot of an attribute
  ***************************************************************************/
-PUBLIC json_t *gobj_local_method(
-    hgobj gobj_,
-    const char *lmethod,
-    json_t *kw, // must be owned
-    hgobj src
-)
+PRIVATE const sdata_desc_t *attr_slot_desc(gobj_t *gobj, int slot)
 {
-    gobj_t * gobj = gobj_;
-    register const LMETHOD *lmt;
-
-    if(!gobj || gobj->obflag & obflag_destroyed) {
-        gobj_log_error(0, 0,
-            "gobj",         "%s", __FILE__,
+    if(!gobj || !gobj->attr_values || slot < 0 || slot >= gobj->gclass->attrs_slots) {
+        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_PARAMETER,
-            "msg",          "%s", "hgobj NULL or DESTROYED",
+            "msg",          "%s", "attr slot NOT FOUND",
+            "gclass",       "%s", gobj? gobj->gclass->gclass_name:"",
+            "slot",         "%d", slot,
             NULL
         );
-        KW_DECREF(kw)
-        return 0;
+        return NULL;
     }
+    return &gobj->gclass->attrs_table[slot];
+}
 
-    lmt = gobj->gclass->lmt;
-    while(lmt && lmt->lname != 0) {
-        /*
-         *  Exact name, NOT a prefix. With strncasecmp() over the length of
-         *  the TABLE entry, a table holding "do_it" and "do_it_result"
-         *  answered both lookups with the first one: the second method was
-         *  unreachable and its job silently ran the first one again.
-         */
-        if(strcasecmp(lmt->lname, lmethod)==0) {
-            if(lmt->lm) {
-                return (*lmt->lm)(gobj, lmethod, kw, src);
-            }
+/***************************************************************************
+ *  Value from mt_reading, if the gclass has it
+ ***************************************************************************/
+PRIVATE BOOL attr_slot_reading(gobj_t *gobj, const sdata_desc_t *it, SData_Value_t *v)
+{
+    if(gobj->gclass->gmt->mt_reading) {
+        if(!(gobj->obflag & obflag_destroyed)) {
+            *v = gobj->gclass->gmt->mt_reading(gobj, it->name);
+            return v->found?TRUE:FALSE;
         }
-        lmt++;
     }
-
-    gobj_log_error(gobj, 0,
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_INTERNAL,
-        "msg",          "%s", "internal method NOT EXIST",
-        "full-name",    "%s", gobj_full_name(gobj),
-        "lmethod",      "%s", lmethod,
-        NULL
-    );
-
-    KW_DECREF(kw)
-    return 0;
+    return FALSE;
 }
 
 /***************************************************************************
- *  Execute gclass method "start" of the gobj
+ *  Call mt_writing, if the gclass has it
  ***************************************************************************/
-PUBLIC int gobj_start(hgobj gobj_)
+PRIVATE void attr_slot_writing(gobj_t *gobj, const sdata_desc_t *it)
 {
-    gobj_t * gobj = gobj_;
+    if(gobj->gclass->gmt->mt_writing) {
+        if((gobj->obflag & obflag_created) && !(gobj->obflag & obflag_destroyed)) {
+            // Avoid call to mt_writing before mt_create!
+            gobj->gclass->gmt->mt_writing(gobj, it->name);
+        }
+    }
+}
 
-    if(!gobj) {
-        gobj_log_error(0, LOG_OPT_TRACE_STACK,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER,
-            "msg",          "%s", "gobj NULL",
-            NULL
-        );
-        return -1;
+/***************************************************************************
+ *  ATTR: read str by slot
+ ***************************************************************************/
+PUBLIC const char *gobj_read_str_attr_slot(hgobj gobj_, int slot)
+{
+    gobj_t *gobj = gobj_;
+    const sdata_desc_t *it = attr_slot_desc(gobj, slot);
+    if(!it) {
+        return NULL;
     }
-    if(gobj->running) {
-        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_OPERATIONAL,
-            "msg",          "%s", "GObj ALREADY RUNNING",
-            NULL
-        );
-        return -1;
+    SData_Value_t v;
+    if(attr_slot_reading(gobj, it, &v)) {
+        return v.v.s;
     }
-    if(gobj->disabled) {
+    return json_string_value(gobj->attr_values[slot]);
+}
+
+/***************************************************************************
+ *  ATTR: read bool by slot
+ ***************************************************************************/
+PUBLIC BOOL gobj_read_bool_attr_slot(hgobj gobj_, int slot)
+{
+    gobj_t *gobj = gobj_;
+    const sdata_desc_t *it = attr_slot_desc(gobj, slot);
+    if(!it) {
+        return 0;
+    }
+    SData_Value_t v;
+    if(attr_slot_reading(gobj, it, &v)) {
+        return v.v.b;
+    }
+    return json_boolean_value(gobj->attr_values[slot]);
+}
+
+/***************************************************************************
+ *  ATTR: read integer by slot
+ ***************************************************************************/
+PUBLIC json_int_t gobj_read_integer_attr_slot(hgobj gobj_, int slot)
+{
+    gobj_t *gobj = gobj_;
+    const sdata_desc_t *it = attr_slot_desc(gobj, slot);
+    if(!it) {
+        return 0;
+    }
+    SData_Value_t v;
+    if(attr_slot_reading(gobj, it, &v)) {
+        return v.v.i;
+    }
+    return json_integer_value(gobj->attr_values[slot]);
+}
+
+/***************************************************************************
+ *  ATTR: read real by slot
+ ***************************************************************************/
+PUBLIC double gobj_read_real_attr_slot(hgobj gobj_, int slot)
+{
+    gobj_t *gobj = gobj_;
+    const sdata_desc_t *it = attr_slot_desc(gobj, slot);
+    if(!it) {
+        return 0;
+    }
+    SData_Value_t v;
+    if(attr_slot_reading(gobj, it, &v)) {
+        return v.v.f;
+    }
+    return json_real_value(gobj->attr_values[slot]);
+}
+
+/***************************************************************************
+ *  ATTR: read json by slot. WARNING return its NOT YOURS
+ ***************************************************************************/
+PUBLIC json_t *gobj_read_json_attr_slot(hgobj gobj_, int slot)
+{
+    gobj_t *gobj = gobj_;
+    const sdata_desc_t *it = attr_slot_desc(gobj, slot);
+    if(!it) {
+        return 0;
+    }
+    SData_Value_t v;
+    if(attr_slot_reading(gobj, it, &v)) {
+        return v.v.j;
+    }
+    return gobj->attr_values[slot];
+}
+
+/***************************************************************************
+ *  ATTR: read pointer by slot
+ ***************************************************************************/
+PUBLIC void *gobj_read_pointer_attr_slot(hgobj gobj_, int slot)
+{
+    gobj_t *gobj = gobj_;
+    const sdata_desc_t *it = attr_slot_desc(gobj, slot);
+    if(!it) {
+        return 0;
+    }
+    SData_Value_t v;
+    if(attr_slot_reading(gobj, it, &v)) {
+        return v.v.p;
+    }
+    return (void *)(uintptr_t)json_integer_value(gobj->attr_values[slot]);
+}
+
+/***************************************************************************
+ *  ATTR: write str by slot
+ ***************************************************************************/
+PUBLIC int gobj_write_str_attr_slot(hgobj gobj_, int slot, const char *value)
+{
+    gobj_t *gobj = gobj_;
+    const sdata_desc_t *it = attr_slot_desc(gobj, slot);
+    if(!it) {
+        return -1;
+    }
+    // WARNING value == 0  -> json_null()
+    int ret = attr_set_new(gobj, gobj->jn_attrs, it, value?json_string(value):json_null());
+    attr_slot_writing(gobj, it);
+    return ret;
+}
+
+/***************************************************************************
+ *  ATTR: write bool by slot
+ ***************************************************************************/
+PUBLIC int gobj_write_bool_attr_slot(hgobj gobj_, int slot, BOOL value)
+{
+    gobj_t *gobj = gobj_;
+    const sdata_desc_t *it = attr_slot_desc(gobj, slot);
+    if(!it) {
+        return -1;
+    }
+    int ret = attr_set_new(gobj, gobj->jn_attrs, it, json_boolean(value));
+    attr_slot_writing(gobj, it);
+    return ret;
+}
+
+/***************************************************************************
+ *  ATTR: write integer by slot
+ ***************************************************************************/
+PUBLIC int gobj_write_integer_attr_slot(hgobj gobj_, int slot, json_int_t value)
+{
+    gobj_t *gobj = gobj_;
+    const sdata_desc_t *it = attr_slot_desc(gobj, slot);
+    if(!it) {
+        return -1;
+    }
+    int ret = attr_set_integer(gobj, gobj->jn_attrs, it, value);
+    attr_slot_writing(gobj, it);
+    return ret;
+}
+
+/***************************************************************************
+ *  ATTR: write real by slot
+ ***************************************************************************/
+PUBLIC int gobj_write_real_attr_slot(hgobj gobj_, int slot, double value)
+{
+    gobj_t *gobj = gobj_;
+    const sdata_desc_t *it = attr_slot_desc(gobj, slot);
+    if(!it) {
+        return -1;
+    }
+    int ret = attr_set_real(gobj, gobj->jn_attrs, it, value);
+    attr_slot_writing(gobj, it);
+    return ret;
+}
+
+/***************************************************************************
+ *  ATTR: write json by slot.  WARNING json is NOT incref
+ ***************************************************************************/
+PUBLIC int gobj_write_new_json_attr_slot(hgobj gobj_, int slot, json_t *jn_value)
+{
+    gobj_t *gobj = gobj_;
+    const sdata_desc_t *it = attr_slot_desc(gobj, slot);
+    if(!it) {
+        JSON_DECREF(jn_value)
+        return -1;
+    }
+    int ret = attr_set_new(gobj, gobj->jn_attrs, it, jn_value);
+    attr_slot_writing(gobj, it);
+    return ret;
+}
+
+/***************************************************************************
+ *  ATTR: write pointer by slot
+ ***************************************************************************/
+PUBLIC int gobj_write_pointer_attr_slot(hgobj gobj_, int slot, void *value)
+{
+    gobj_t *gobj = gobj_;
+    const sdata_desc_t *it = attr_slot_desc(gobj, slot);
+    if(!it) {
+        return -1;
+    }
+    int ret = attr_set_integer(gobj, gobj->jn_attrs, it, (json_int_t)(uintptr_t)value);
+    attr_slot_writing(gobj, it);
+    return ret;
+}
+
+
+
+
+                    /*---------------------------------*
+                     *  Operational functions
+                     *---------------------------------*/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE json_t *gobj_check_required_attrs(gobj_t *gobj)
+{
+    json_t *hs = gobj_hsdata(gobj);
+    json_t *jn_required_attrs = json_array();
+
+    const sdata_desc_t *it = gobj->gclass->attrs_table;
+    while(it->name) {
+        if(it->flag & SDF_REQUIRED) {
+            const json_t *jn_value = json_object_get(hs, it->name);
+            switch(it->type) {
+                case DTP_STRING:
+                    if(empty_string(json_string_value(jn_value))) {
+                        json_array_append_new(jn_required_attrs, json_string(it->name));
+                    }
+                    break;
+                case DTP_LIST:
+                case DTP_DICT:
+                case DTP_JSON:
+                    if(empty_json(jn_value)) {
+                        json_array_append_new(jn_required_attrs, json_string(it->name));
+                    }
+                    break;
+                case DTP_POINTER:
+                    if(!json_integer_value(jn_value)) {
+                        json_array_append_new(jn_required_attrs, json_string(it->name));
+                    }
+                    break;
+                case DTP_BOOLEAN:
+                case DTP_INTEGER:
+                case DTP_REAL:
+                    break;
+            }
+        }
+        it++;
+    }
+    if(json_array_size(jn_required_attrs)==0) {
+        JSON_DECREF(jn_required_attrs)
+    }
+    return jn_required_attrs;
+}
+
+/***************************************************************************
+ *  Execute internal method
+ ***************************************************************************/
+PUBLIC json_t *gobj_local_method(
+    hgobj gobj_,
+    const char *lmethod,
+    json_t *kw, // must be owned
+    hgobj src
+)
+{
+    gobj_t * gobj = gobj_;
+    register const LMETHOD *lmt;
+
+    if(!gobj || gobj->obflag & obflag_destroyed) {
+        gobj_log_error(0, 0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "hgobj NULL or DESTROYED",
+            NULL
+        );
+        KW_DECREF(kw)
+        return 0;
+    }
+
+    lmt = gobj->gclass->lmt;
+    while(lmt && lmt->lname != 0) {
+        /*
+         *  Exact name, NOT a prefix. With strncasecmp() over the length of
+         *  the TABLE entry, a table holding "do_it" and "do_it_result"
+         *  answered both lookups with the first one: the second method was
+         *  unreachable and its job silently ran the first one again.
+         */
+        if(strcasecmp(lmt->lname, lmethod)==0) {
+            if(lmt->lm) {
+                return (*lmt->lm)(gobj, lmethod, kw, src);
+            }
+        }
+        lmt++;
+    }
+
+    gobj_log_error(gobj, 0,
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_INTERNAL,
+        "msg",          "%s", "internal method NOT EXIST",
+        "full-name",    "%s", gobj_full_name(gobj),
+        "lmethod",      "%s", lmethod,
+        NULL
+    );
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Execute gclass method "start" of the gobj
+ ***************************************************************************/
+PUBLIC int gobj_start(hgobj gobj_)
+{
+    gobj_t * gobj = gobj_;
+
+    if(!gobj) {
+        gobj_log_error(0, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "gobj NULL",
+            NULL
+        );
+        return -1;
+    }
+    if(gobj->running) {
+        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_OPERATIONAL,
+            "msg",          "%s", "GObj ALREADY RUNNING",
+            NULL
+        );
+        return -1;
+    }
+    if(gobj->disabled) {
         gobj_log_warning(gobj, LOG_OPT_TRACE_STACK,
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_OPERATIONAL,
@@ -7519,20 +8030,305 @@ PUBLIC json_t *gobj_view_tree(  // Return tree with gobj's tree.
 
 
 /***************************************************************************
- *
+ *  Register a payload type, idempotent by name
  ***************************************************************************/
-PUBLIC int gobj_send_event(
-    hgobj dst_,
-    gobj_event_t event,
-    json_t *kw,
-    hgobj src_
+PUBLIC payload_type_t gobj_payload_type_register(
+    const char *name,
+    payload_free_fn_t free_fn,
+    payload_json_fn_t json_fn
 ) {
-#ifdef CONFIG_DEBUG_PRINT_YEV_LOOP_TIMES
-    if(measuring_cur_type) {
-        MT_PRINT_TIME(yev_time_measure, "⏩ gobj_send_event()");
+    if(empty_string(name)) {
+        gobj_log_error(0, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "payload type name EMPTY",
+            NULL
+        );
+        return 0;
+    }
+
+    for(int type=1; type<=max_payload_type; type++) {
+        if(strcmp(payload_types[type].name, name)==0) {
+            return type;
+        }
+    }
+
+    if(max_payload_type >= MAX_PAYLOAD_TYPES) {
+        gobj_log_error(0, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "Too many payload types",
+            "name",         "%s", name,
+            "max",          "%d", MAX_PAYLOAD_TYPES,
+            NULL
+        );
+        return 0;
+    }
+
+    max_payload_type++;
+    payload_types[max_payload_type].name = name;
+    payload_types[max_payload_type].free_fn = free_fn;
+    payload_types[max_payload_type].json_fn = json_fn;
+    return max_payload_type;
+}
+
+/***************************************************************************
+ *  ptr is owned: it's freed with the free_fn of the type
+ *  when the last reference goes, also if this function fails.
+ ***************************************************************************/
+PUBLIC gobj_payload_t *gobj_payload_create(payload_type_t type, void *ptr)
+{
+    if(type <= 0 || type > max_payload_type) {
+        gobj_log_error(0, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "payload type NOT registered",
+            "type",         "%d", type,
+            NULL
+        );
+        return NULL;
+    }
+
+    gobj_payload_t *payload = GBMEM_MALLOC(sizeof(*payload));
+    if(!payload) {
+        gobj_log_error(0, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY,
+            "msg",          "%s", "no memory for payload",
+            NULL
+        );
+        if(ptr && payload_types[type].free_fn) {
+            payload_types[type].free_fn(ptr);
+        }
+        return NULL;
+    }
+    payload->refcount = 1;
+    payload->type = type;
+    payload->ptr = ptr;
+    return payload;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC gobj_payload_t *gobj_payload_incref(gobj_payload_t *payload)
+{
+    if(payload) {
+        payload->refcount++;
+    }
+    return payload;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC void gobj_payload_decref(gobj_payload_t *payload)
+{
+    if(!payload) {
+        return;
+    }
+    if(payload->refcount <= 0) {
+        gobj_log_error(0, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "BAD payload refcount",
+            "type",         "%s", payload_types[payload->type].name,
+            "refcount",     "%d", payload->refcount,
+            NULL
+        );
+        return;
+    }
+    if(--payload->refcount == 0) {
+        if(payload->ptr && payload_types[payload->type].free_fn) {
+            payload_types[payload->type].free_fn(payload->ptr);
+        }
+        GBMEM_FREE(payload)
+    }
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC payload_type_t gobj_payload_type(gobj_payload_t *payload)
+{
+    return payload? payload->type : 0;
+}
+
+/***************************************************************************
+ *  Return the pointer if the payload is of this type
+ ***************************************************************************/
+PUBLIC void *gobj_payload_ptr(gobj_payload_t *payload, payload_type_t type)
+{
+    if(!payload || payload->type != type) {
+        return NULL;
+    }
+    return payload->ptr;
+}
+
+/***************************************************************************
+ *  Return a new json view of the payload
+ ***************************************************************************/
+PUBLIC json_t *gobj_payload_json(gobj_payload_t *payload)
+{
+    if(!payload || !payload->ptr || !payload_types[payload->type].json_fn) {
+        return NULL;
+    }
+    return payload_types[payload->type].json_fn(payload->ptr);
+}
+
+/***************************************************************************
+ *  Payload of the event in execution
+ ***************************************************************************/
+PUBLIC gobj_payload_t *gobj_event_payload(void)
+{
+    return __event_payload__;
+}
+
+/***************************************************************************
+ *  kw for receivers that don't read the payload
+ ***************************************************************************/
+PRIVATE json_t *payload_kw(gobj_payload_t *payload)
+{
+    json_t *kw = gobj_payload_json(payload);
+    if(!kw) {
+        kw = json_object();
+    }
+    return kw;
+}
+
+/***************************************************************************
+ *  Does the action of dst read the payload?
+ ***************************************************************************/
+PRIVATE BOOL payload_aware(gobj_t *dst, gobj_event_t event)
+{
+    event_type_t *event_type = gobj_event_type(dst, event, FALSE);
+    return (event_type && (event_type->event_flag & EVF_PAYLOAD))? TRUE:FALSE;
+}
+
+/***************************************************************************
+ *  Json view of the built-in gbuffer type, same as the kw convention
+ ***************************************************************************/
+PRIVATE json_t *gbuffer_payload_json(void *ptr)
+{
+    gbuffer_incref(ptr);
+    return json_pack("{s:I}",
+        "gbuffer", (json_int_t)(uintptr_t)ptr
+    );
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC payload_type_t gobj_payload_type_gbuffer(void)
+{
+    return payload_type_gbuffer;
+}
+
+/***************************************************************************
+ *  gbuf is owned
+ ***************************************************************************/
+PUBLIC gobj_payload_t *gobj_payload_create_gbuffer(gbuffer_t *gbuf)
+{
+    return gobj_payload_create(payload_type_gbuffer, gbuf);
+}
+
+/***************************************************************************
+ *  gbuffer of the payload of the event in execution,
+ *  or "gbuffer" of kw (the old way). NOT yours.
+ ***************************************************************************/
+PUBLIC gbuffer_t *gobj_event_gbuffer(hgobj gobj, json_t *kw)
+{
+    gbuffer_t *gbuf = gobj_payload_ptr(__event_payload__, payload_type_gbuffer);
+    if(gbuf || !kw) {
+        return gbuf;
+    }
+    return (gbuffer_t *)(uintptr_t)kw_get_int(gobj, kw, "gbuffer", 0, 0);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void gbuffer_iov_payload_free(void *ptr)
+{
+    gbuffer_iov_t *iov = ptr;
+    GBUFFER_DECREF(iov->head)
+    GBUFFER_DECREF(iov->body)
+    GBMEM_FREE(iov)
+}
+
+/***************************************************************************
+ *  Json view of the built-in gbuffer_iov type: head and body in one gbuffer
+ ***************************************************************************/
+PRIVATE json_t *gbuffer_iov_payload_json(void *ptr)
+{
+    gbuffer_iov_t *iov = ptr;
+    size_t head_len = iov->head? gbuffer_leftbytes(iov->head):0;
+    size_t body_len = iov->body? gbuffer_leftbytes(iov->body):0;
+
+    gbuffer_t *gbuf = gbuffer_create(head_len + body_len, head_len + body_len);
+    if(!gbuf) {
+        // Error already logged
+        return NULL;
+    }
+    if(head_len) {
+        gbuffer_append(gbuf, gbuffer_cur_rd_pointer(iov->head), head_len);
+    }
+    if(body_len) {
+        gbuffer_append(gbuf, gbuffer_cur_rd_pointer(iov->body), body_len);
+    }
+    return json_pack("{s:I}",
+        "gbuffer", (json_int_t)(uintptr_t)gbuf
+    );
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC payload_type_t gobj_payload_type_gbuffer_iov(void)
+{
+    return payload_type_gbuffer_iov;
+}
+
+/***************************************************************************
+ *  head and body are owned, body can be shared by several payloads
+ ***************************************************************************/
+PUBLIC gobj_payload_t *gobj_payload_create_gbuffer_iov(gbuffer_t *head, gbuffer_t *body)
+{
+    gbuffer_iov_t *iov = GBMEM_MALLOC(sizeof(*iov));
+    if(!iov) {
+        gobj_log_error(0, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY,
+            "msg",          "%s", "no memory for gbuffer_iov",
+            NULL
+        );
+        GBUFFER_DECREF(head)
+        GBUFFER_DECREF(body)
+        return NULL;
+    }
+    iov->head = head;
+    iov->body = body;
+    return gobj_payload_create(payload_type_gbuffer_iov, iov);
+}
+
+/***************************************************************************
+ *  Dispatch an event, with optional typed payload (owned).
+ *  The payload is visible to the action through gobj_event_payload()
+ *  only while the action runs: a nested send without payload hides it.
+ ***************************************************************************/
+PRIVATE int send_event(
+    gobj_t *dst,
+    gobj_event_t event,
+    json_t *kw,
+    gobj_payload_t *payload,
+    gobj_t *src
+) {
+#ifdef CONFIG_DEBUG_PRINT_YEV_LOOP_TIMES
+    if(measuring_cur_type) {
+        MT_PRINT_TIME(yev_time_measure, "⏩ gobj_send_event()");
     }
 #endif
-    if(dst_ == NULL) {
+    if(dst == NULL) {
         gobj_log_error(NULL, LOG_OPT_TRACE_STACK,
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_PARAMETER,
@@ -7541,11 +8337,10 @@ PUBLIC int gobj_send_event(
             NULL
         );
         KW_DECREF(kw)
+        gobj_payload_decref(payload);
         return -1;
     }
 
-    gobj_t *src = (gobj_t *)src_;
-    gobj_t *dst = (gobj_t *)dst_;
     if(dst->obflag & (obflag_destroyed|obflag_destroying)) {
         gobj_log_error(dst, LOG_OPT_TRACE_STACK,
             "function",     "%s", __FUNCTION__,
@@ -7555,6 +8350,7 @@ PUBLIC int gobj_send_event(
             NULL
         );
         KW_DECREF(kw)
+        gobj_payload_decref(payload);
         return -1;
     }
 
@@ -7569,6 +8365,7 @@ PUBLIC int gobj_send_event(
             NULL
         );
         KW_DECREF(kw)
+        gobj_payload_decref(payload);
         return -1;
     }
 
@@ -7615,7 +8412,15 @@ PUBLIC int gobj_send_event(
                     }
                 }
             }
-            return dst->gclass->gmt->mt_inject_event(dst, event, kw, src);
+            if(payload && !kw && !payload_aware(dst, event)) {
+                kw = payload_kw(payload);
+            }
+            gobj_payload_t *prev_payload = __event_payload__;
+            __event_payload__ = payload;
+            int ret = dst->gclass->gmt->mt_inject_event(dst, event, kw, src);
+            __event_payload__ = prev_payload;
+            gobj_payload_decref(payload);
+            return ret;
         }
 
         if(tracea) {
@@ -7643,6 +8448,7 @@ PUBLIC int gobj_send_event(
         __inside__ --;
 
         KW_DECREF(kw)
+        gobj_payload_decref(payload);
         return -1;
     }
 
@@ -7705,12 +8511,20 @@ PUBLIC int gobj_send_event(
 
     int ret = -1;
     if(event_action->action) {
+        if(payload && !kw && !payload_aware(dst, event)) {
+            // The receiver only knows kw: give it the json view
+            kw = payload_kw(payload);
+        }
         // Execute the action
+        gobj_payload_t *prev_payload = __event_payload__;
+        __event_payload__ = payload;
         ret = (*event_action->action)(dst, event, kw, src);
+        __event_payload__ = prev_payload;
     } else {
         // No action, there is nothing amiss!.
         KW_DECREF(kw)
     }
+    gobj_payload_decref(payload);
 
     if(tracea && !(dst->obflag & obflag_destroyed)) {
         if(trace_machine_format==1) {
@@ -7737,6 +8551,31 @@ PUBLIC int gobj_send_event(
     return ret;
 }
 
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC int gobj_send_event(
+    hgobj dst,
+    gobj_event_t event,
+    json_t *kw,
+    hgobj src
+) {
+    return send_event((gobj_t *)dst, event, kw, NULL, (gobj_t *)src);
+}
+
+/***************************************************************************
+ *  Like gobj_send_event() but with a typed payload (owned)
+ ***************************************************************************/
+PUBLIC int gobj_send_event_payload(
+    hgobj dst,
+    gobj_event_t event,
+    json_t *kw,                 // owned, can be NULL
+    gobj_payload_t *payload,    // owned
+    hgobj src
+) {
+    return send_event((gobj_t *)dst, event, kw, payload, (gobj_t *)src);
+}
+
 /***************************************************************************
  *  Send the event to all children of first level supporting the event
  ***************************************************************************/
@@ -9152,14 +9991,15 @@ PUBLIC json_t *gobj_list_subscribings(
 
 /***************************************************************************
  *  Return the sum of returns of gobj_send_event
+ *  With payload the kw can be NULL, the json view of the payload
+ *  is built only if somebody (method, filter, subscription keys) needs it.
  ***************************************************************************/
-PUBLIC int gobj_publish_event(
-    hgobj publisher_,
+PRIVATE int publish_event(
+    gobj_t *publisher,
     gobj_event_t event,
-    json_t *kw)
-{
-    gobj_t * publisher = publisher_;
-
+    json_t *kw,                 // owned
+    gobj_payload_t *payload     // owned
+) {
 #ifdef CONFIG_DEBUG_PRINT_YEV_LOOP_TIMES
     if(measuring_cur_type) {
         MT_PRINT_TIME(yev_time_measure, "⏩ gobj_publish_event()");
@@ -9167,7 +10007,13 @@ PUBLIC int gobj_publish_event(
 #endif
 
     if(!kw) {
-        kw = json_object();
+        if(!payload) {
+            kw = json_object();
+        } else if(publisher && !(publisher->obflag & obflag_destroyed) &&
+                (publisher->gclass->gmt->mt_publish_event ||
+                 publisher->gclass->gmt->mt_publication_pre_filter)) {
+            kw = payload_kw(payload);
+        }
     }
 
     /*---------------------*
@@ -9181,6 +10027,7 @@ PUBLIC int gobj_publish_event(
             NULL
         );
         KW_DECREF(kw)
+        gobj_payload_decref(payload);
         return -1;
     }
     if(publisher->obflag & obflag_destroyed) {
@@ -9191,6 +10038,7 @@ PUBLIC int gobj_publish_event(
             NULL
         );
         KW_DECREF(kw)
+        gobj_payload_decref(payload);
         return -1;
     }
     if(empty_string(event)) {
@@ -9201,6 +10049,7 @@ PUBLIC int gobj_publish_event(
             NULL
         );
         KW_DECREF(kw)
+        gobj_payload_decref(payload);
         return -1;
     }
 
@@ -9224,6 +10073,7 @@ PUBLIC int gobj_publish_event(
                 NULL
             );
             KW_DECREF(kw)
+            gobj_payload_decref(payload);
             return -1;
         }
     }
@@ -9274,6 +10124,7 @@ PUBLIC int gobj_publish_event(
         );
         if(topublish<=0) {
             KW_DECREF(kw)
+            gobj_payload_decref(payload);
             return topublish;
         }
     }
@@ -9345,6 +10196,17 @@ PUBLIC int gobj_publish_event(
                 event_name = event;
             }
 
+            /*
+             *  Filters and subscription keys work on json:
+             *  build the view of the payload the first time it's needed
+             */
+            if(payload && !kw) {
+                if(publisher->gclass->gmt->mt_publication_filter || json_size(__filter__)>0 ||
+                        json_size(__local__)>0 || json_size(__global__)>0) {
+                    kw = payload_kw(payload);
+                }
+            }
+
             /*
              *  Duplicate the kw to publish if not shared
              *  NOW always shared
@@ -9474,10 +10336,11 @@ PUBLIC int gobj_publish_event(
             }
 
             sent_count++;
-            int ret_ = gobj_send_event(
+            int ret_ = send_event(
                 subscriber,
                 event_name,
                 kw2publish,
+                gobj_payload_incref(payload),
                 publisher
             );
             if(ret_ < 0 && (subs_flag & __own_event__)) {
@@ -9512,6 +10375,7 @@ PUBLIC int gobj_publish_event(
 
     JSON_DECREF(dl_subs)
     KW_DECREF(kw)
+    gobj_payload_decref(payload);
 
 #ifdef CONFIG_DEBUG_PRINT_YEV_LOOP_TIMES
     if(measuring_cur_type) {
@@ -9532,6 +10396,30 @@ PUBLIC int gobj_publish_event(
 
 
 
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC int gobj_publish_event(
+    hgobj publisher,
+    gobj_event_t event,
+    json_t *kw)
+{
+    return publish_event((gobj_t *)publisher, event, kw, NULL);
+}
+
+/***************************************************************************
+ *  Like gobj_publish_event() but with a typed payload (owned),
+ *  each subscriber receives a reference.
+ ***************************************************************************/
+PUBLIC int gobj_publish_event_payload(
+    hgobj publisher,
+    gobj_event_t event,
+    json_t *kw,                 // owned, can be NULL
+    gobj_payload_t *payload     // owned
+) {
+    return publish_event((gobj_t *)publisher, event, kw, payload);
+}
+
 /***************************************************************************
  *  Authenticate
  *  Return json response
@@ -9875,7 +10763,38 @@ PUBLIC json_t *gobj_build_authzs_doc(
 
 
 /***************************************************************************
- *
+ *  Return the native stat slot of the name, -1 if not found
+ ***************************************************************************/
+PUBLIC int gobj_stat_slot(hgobj gobj_, const char *name)
+{
+    gobj_t *gobj = gobj_;
+    if(!gobj || !gobj->stat_slots || !name) {
+        return -1;
+    }
+    const sdata_desc_t *stats_table = gobj->gclass->stats_table;
+    for(int i=0; i<gobj->gclass->stats_slots; i++) {
+        if(strcmp(stats_table[i].name, name)==0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/***************************************************************************
+ *  Write a stat of jn_stats, in place if it already exists
+ ***************************************************************************/
+PRIVATE void jn_stats_write(gobj_t *gobj, const char *path, json_int_t value)
+{
+    json_t *jn_value = kw_get_dict_value(gobj, gobj->jn_stats, path, 0, 0);
+    if(json_is_integer(jn_value)) {
+        json_integer_set(jn_value, value);
+    } else {
+        kw_set_dict_value(gobj, gobj->jn_stats, path, json_integer(value));
+    }
+}
+
+/***************************************************************************
+ *  Native stat slot or jn_stats
  ***************************************************************************/
 PUBLIC json_int_t gobj_set_stat(hgobj gobj_, const char *path, json_int_t value)
 {
@@ -9883,14 +10802,19 @@ PUBLIC json_int_t gobj_set_stat(hgobj gobj_, const char *path, json_int_t value)
     if(!gobj) {
         return 0;
     }
+    int slot = gobj_stat_slot(gobj, path);
+    if(slot >= 0) {
+        return gobj_set_stat_slot(gobj, slot, value);
+    }
+
     json_int_t old_value = kw_get_int(gobj, gobj->jn_stats, path, 0, 0);
-    kw_set_dict_value(gobj, gobj->jn_stats, path, json_integer(value));
+    jn_stats_write(gobj, path, value);
 
     return old_value;
 }
 
 /***************************************************************************
- *
+ *  Native stat slot or jn_stats
  ***************************************************************************/
 PUBLIC json_int_t gobj_incr_stat(hgobj gobj_, const char *path, json_int_t value)
 {
@@ -9898,16 +10822,20 @@ PUBLIC json_int_t gobj_incr_stat(hgobj gobj_, const char *path, json_int_t value
     if(!gobj) {
         return 0;
     }
+    int slot = gobj_stat_slot(gobj, path);
+    if(slot >= 0) {
+        return gobj_incr_stat_slot(gobj, slot, value);
+    }
 
     json_int_t cur_value = kw_get_int(gobj, gobj->jn_stats, path, 0, 0);
     cur_value += value;
-    kw_set_dict_value(gobj, gobj->jn_stats, path, json_integer(cur_value));
+    jn_stats_write(gobj, path, cur_value);
 
     return cur_value;
 }
 
 /***************************************************************************
- *
+ *  Native stat slot or jn_stats
  ***************************************************************************/
 PUBLIC json_int_t gobj_decr_stat(hgobj gobj_, const char *path, json_int_t value)
 {
@@ -9915,24 +10843,115 @@ PUBLIC json_int_t gobj_decr_stat(hgobj gobj_, const char *path, json_int_t value
     if(!gobj) {
         return 0;
     }
+    int slot = gobj_stat_slot(gobj, path);
+    if(slot >= 0) {
+        return gobj_decr_stat_slot(gobj, slot, value);
+    }
+
     json_int_t cur_value = kw_get_int(gobj, gobj->jn_stats, path, 0, 0);
     cur_value -= value;
-    kw_set_dict_value(gobj, gobj->jn_stats, path, json_integer(cur_value));
+    jn_stats_write(gobj, path, cur_value);
 
     return cur_value;
 }
 
 /***************************************************************************
- *
+ *  Native stat slot or jn_stats
  ***************************************************************************/
 PUBLIC json_int_t gobj_get_stat(hgobj gobj, const char *path)
 {
     if(!gobj) {
         return 0;
     }
+    int slot = gobj_stat_slot(gobj, path);
+    if(slot >= 0) {
+        return gobj_get_stat_slot(gobj, slot);
+    }
     return kw_get_int(gobj, ((gobj_t *)gobj)->jn_stats, path, 0, 0);
 }
 
+/***************************************************************************
+ *  Check the slot of a native stat
+ ***************************************************************************/
+PRIVATE json_int_t *stat_slot(gobj_t *gobj, int slot)
+{
+    if(!gobj || !gobj->stat_slots || slot < 0 || slot >= gobj->gclass->stats_slots) {
+        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "stat slot NOT FOUND",
+            "gclass",       "%s", gobj? gobj->gclass->gclass_name:"",
+            "slot",         "%d", slot,
+            NULL
+        );
+        return NULL;
+    }
+    return &gobj->stat_slots[slot];
+}
+
+/***************************************************************************
+ *  Native stat slot, return old value
+ ***************************************************************************/
+PUBLIC json_int_t gobj_set_stat_slot(hgobj gobj, int slot, json_int_t value)
+{
+    json_int_t *p = stat_slot(gobj, slot);
+    if(!p) {
+        return 0;
+    }
+    json_int_t old_value = *p;
+    *p = value;
+    return old_value;
+}
+
+/***************************************************************************
+ *  Native stat slot, return new value
+ ***************************************************************************/
+PUBLIC json_int_t gobj_incr_stat_slot(hgobj gobj, int slot, json_int_t value)
+{
+    json_int_t *p = stat_slot(gobj, slot);
+    if(!p) {
+        return 0;
+    }
+    *p += value;
+    return *p;
+}
+
+/***************************************************************************
+ *  Native stat slot, return new value
+ ***************************************************************************/
+PUBLIC json_int_t gobj_decr_stat_slot(hgobj gobj, int slot, json_int_t value)
+{
+    json_int_t *p = stat_slot(gobj, slot);
+    if(!p) {
+        return 0;
+    }
+    *p -= value;
+    return *p;
+}
+
+/***************************************************************************
+ *  Native stat slot
+ ***************************************************************************/
+PUBLIC json_int_t gobj_get_stat_slot(hgobj gobj, int slot)
+{
+    json_int_t *p = stat_slot(gobj, slot);
+    if(!p) {
+        return 0;
+    }
+    return *p;
+}
+
+/***************************************************************************
+ *  Description of the native stat slots (gclass_set_stats_table())
+ ***************************************************************************/
+PUBLIC const sdata_desc_t *gobj_stats_desc(hgobj gobj)
+{
+    if(!gobj) {
+        return NULL;
+    }
+    return ((gobj_t *)gobj)->gclass->stats_table;
+}
+
 /***************************************************************************
  *  WARNING the json return is NOT YOURS!
  ***************************************************************************/
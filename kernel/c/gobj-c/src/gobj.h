@@ -331,8 +331,14 @@ typedef enum { // HACK strict ascendant value!, strings in event_flag_names[]
     EVF_PUBLIC_EVENT    = 0x0008,   // You should document a public event, it's the API
     EVF_AUTHZ_INJECT    = 0x0010,   // Event needs '__inject_event__' authorization to be injected
     EVF_AUTHZ_SUBSCRIBE = 0x0020,   // Event needs '__subscribe_event__' authorization to be subscribed
+    EVF_PAYLOAD         = 0x0040,   // Action reads gobj_event_payload(), don't build kw from the payload
 } event_flag_t;
 
+typedef int payload_type_t;
+typedef struct gobj_payload_s gobj_payload_t;
+typedef void (*payload_free_fn_t)(void *ptr);
+typedef json_t *(*payload_json_fn_t)(void *ptr); // Return a new kw, viewing ptr
+
 typedef struct event_type_s {
     gobj_event_t event_name;
     event_flag_t event_flag;
@@ -852,6 +858,17 @@ PUBLIC int gclass_add_state(
     hgclass gclass,
     gobj_state_t state_name
 );
+
+/*
+ *  Native stat slots: DTP_INTEGER counters (SDF_RSTATS, reset by "__reset__")
+ *  or gauges (SDF_STATS), kept in a json_int_t array of each gobj and rendered
+ *  to json only when the stats are queried. The slot is the index in stats_table.
+ *  Call it after gclass_create(), before creating instances.
+ */
+PUBLIC int gclass_set_stats_table(
+    hgclass gclass,
+    const sdata_desc_t *stats_table
+);
 PUBLIC int gclass_add_ev_action(
     hgclass gclass,
     gobj_state_t state_name,
@@ -1141,6 +1158,28 @@ PUBLIC int gobj_write_json_attr(hgobj gobj, const char *name, json_t *value);
 PUBLIC int gobj_write_new_json_attr(hgobj gobj, const char *name, json_t *value);
 PUBLIC int gobj_write_pointer_attr(hgobj gobj, const char *name, void *value);
 
+/*
+ *  Attribute slots, WITHOUT bottom inheritance.
+ *  The slot is the index of the attribute in the gclass's attrs_table,
+ *  resolve it once (in mt_create or with an enum matching the table)
+ *  and use it in hot paths: no name lookup, and integer/real/pointer
+ *  writes are done in place.
+ *  mt_reading/mt_writing are called as in the name versions.
+ */
+PUBLIC int gobj_attr_slot(hgobj gobj, const char *name); // -1 if not found
+PUBLIC const char *gobj_read_str_attr_slot(hgobj gobj, int slot);
+PUBLIC BOOL gobj_read_bool_attr_slot(hgobj gobj, int slot);
+PUBLIC json_int_t gobj_read_integer_attr_slot(hgobj gobj, int slot);
+PUBLIC double gobj_read_real_attr_slot(hgobj gobj, int slot);
+PUBLIC json_t *gobj_read_json_attr_slot(hgobj gobj, int slot); // WARNING return its NOT YOURS
+PUBLIC void *gobj_read_pointer_attr_slot(hgobj gobj, int slot);
+PUBLIC int gobj_write_str_attr_slot(hgobj gobj, int slot, const char *value); // WARNING value == 0  -> json_null()
+PUBLIC int gobj_write_bool_attr_slot(hgobj gobj, int slot, BOOL value);
+PUBLIC int gobj_write_integer_attr_slot(hgobj gobj, int slot, json_int_t value);
+PUBLIC int gobj_write_real_attr_slot(hgobj gobj, int slot, double value);
+PUBLIC int gobj_write_new_json_attr_slot(hgobj gobj, int slot, json_t *value); // value is NOT incref
+PUBLIC int gobj_write_pointer_attr_slot(hgobj gobj, int slot, void *value);
+
 /*--------------------------------------------*
  *  Operational functions
  *--------------------------------------------*/
@@ -1385,6 +1424,67 @@ PUBLIC int gobj_send_event(
     hgobj src
 );
 
+/*--------------------------------------------------------------------------*
+ *  Typed event payloads
+ *
+ *  A payload is a small refcounted box with a registered type and a pointer,
+ *  sent alongside the kw (or instead of it) to carry binary data (frames,
+ *  gbuffers, structs) without building json on the hot path.
+ *
+ *  The payload is visible to the action only while it runs, with
+ *  gobj_event_payload(). Incref it to keep it beyond the action.
+ *  Events whose action reads the payload are marked EVF_PAYLOAD in the
+ *  event_types of the receiver. If the receiver doesn't mark it and kw is NULL,
+ *  the kw is built with the json view of the payload type, so old receivers
+ *  keep working. gobj_post_event() doesn't carry payloads.
+ *--------------------------------------------------------------------------*/
+PUBLIC payload_type_t gobj_payload_type_register( // Return the type id (>0), the same if name is already registered
+    const char *name,           // must be a static string
+    payload_free_fn_t free_fn,  // called with ptr when the last reference goes
+    payload_json_fn_t json_fn   // build the json view of ptr, can be NULL
+);
+PUBLIC gobj_payload_t *gobj_payload_create(payload_type_t type, void *ptr); // ptr is owned
+PUBLIC gobj_payload_t *gobj_payload_incref(gobj_payload_t *payload);
+PUBLIC void gobj_payload_decref(gobj_payload_t *payload);
+PUBLIC payload_type_t gobj_payload_type(gobj_payload_t *payload);
+PUBLIC void *gobj_payload_ptr(gobj_payload_t *payload, payload_type_t type); // NULL if not of this type
+PUBLIC json_t *gobj_payload_json(gobj_payload_t *payload); // Return a new json view, NULL if type has not json_fn
+PUBLIC gobj_payload_t *gobj_event_payload(void); // Payload of the event in execution, NOT yours
+
+PUBLIC int gobj_send_event_payload(
+    hgobj dst,
+    gobj_event_t event,
+    json_t *kw,                 // owned, can be NULL
+    gobj_payload_t *payload,    // owned
+    hgobj src
+);
+
+/*
+ *  Built-in "gbuffer" payload type, the json view is {"gbuffer": gbuf}
+ */
+PUBLIC payload_type_t gobj_payload_type_gbuffer(void);
+PUBLIC gobj_payload_t *gobj_payload_create_gbuffer(gbuffer_t *gbuf); // gbuf is owned
+PUBLIC gbuffer_t *gobj_event_gbuffer( // gbuffer of the event payload, or "gbuffer" of kw. NOT yours
+    hgobj gobj,
+    json_t *kw  // not owned
+);
+
+/*
+ *  Built-in "gbuffer_iov" payload type, for fan-out: a small own head followed by
+ *  a body shared by many receivers. Receivers must not move the read pointer of body.
+ *  The json view is {"gbuffer": head and body copied in a new gbuffer}
+ */
+typedef struct gbuffer_iov_s {
+    gbuffer_t *head;
+    gbuffer_t *body;
+} gbuffer_iov_t;
+
+PUBLIC payload_type_t gobj_payload_type_gbuffer_iov(void);
+PUBLIC gobj_payload_t *gobj_payload_create_gbuffer_iov(
+    gbuffer_t *head,    // owned
+    gbuffer_t *body     // owned
+);
+
 PUBLIC int gobj_send_event_to_children(  // Send the event to all children of first level supporting the event
     hgobj gobj,
     gobj_event_t event,
@@ -1602,6 +1702,12 @@ PUBLIC int gobj_publish_event( //  Return the sum of returns of gobj_send_event
     gobj_event_t event,
     json_t *kw  // this kw extends kw_request.
 );
+PUBLIC int gobj_publish_event_payload( // Same with a typed payload, each subscriber gets a reference
+    hgobj publisher,
+    gobj_event_t event,
+    json_t *kw,                 // owned, can be NULL
+    gobj_payload_t *payload     // owned
+);
 
 /*--------------------------------------------*
  *      AUTHZ Authorization functions
@@ -1703,6 +1809,17 @@ PUBLIC json_int_t gobj_decr_stat(hgobj gobj, const char *path, json_int_t value)
 PUBLIC json_int_t gobj_get_stat(hgobj gobj, const char *path);
 PUBLIC json_t *gobj_jn_stats(hgobj gobj);  // WARNING the json return is NOT YOURS!
 
+/*
+ *  Native stat slots (gclass_set_stats_table()), incremented in place.
+ *  The name functions above use the slot when the name is in the stats table.
+ */
+PUBLIC int gobj_stat_slot(hgobj gobj, const char *name); // return -1 if not found
+PUBLIC json_int_t gobj_set_stat_slot(hgobj gobj, int slot, json_int_t value); // return old value
+PUBLIC json_int_t gobj_incr_stat_slot(hgobj gobj, int slot, json_int_t value); // return new value
+PUBLIC json_int_t gobj_decr_stat_slot(hgobj gobj, int slot, json_int_t value); // return new value
+PUBLIC json_int_t gobj_get_stat_slot(hgobj gobj, int slot);
+PUBLIC const sdata_desc_t *gobj_stats_desc(hgobj gobj);
+
 
 /*-----------------------------------------------------*
  *  Resource functions
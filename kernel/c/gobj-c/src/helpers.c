@@ -53,6 +53,11 @@
 #endif
 #endif
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  #define UTF8_VALIDATE_SIMD 1
+  #include <immintrin.h>
+#endif
+
 #if defined(__APPLE__) || defined(__FreeBSD__)
   #include <copyfile.h>
 #elif defined(__linux__)
@@ -1503,6 +1508,327 @@ PUBLIC BOOL str_in_list(const char **list, const char *str, BOOL ignore_case)
     return FALSE;
 }
 
+/***************************************************************************
+ *  Scalar UTF-8 validation, runs of ascii are skipped 8 bytes at a time.
+ ***************************************************************************/
+PRIVATE BOOL utf8_validate_scalar(const uint8_t *s, size_t len)
+{
+    size_t i = 0;
+
+    while(i < len) {
+        while(i + 8 <= len) {
+            uint64_t v;
+            memcpy(&v, s + i, 8);
+            if(v & 0x8080808080808080ULL) {
+                break;
+            }
+            i += 8;
+        }
+        if(i >= len) {
+            break;
+        }
+
+        uint8_t c = s[i];
+        if(c < 0x80) {
+            i++;
+            continue;
+        }
+
+        size_t n;               // continuation bytes
+        uint8_t lo = 0x80;      // range of the first continuation byte
+        uint8_t hi = 0xBF;
+        if(c >= 0xC2 && c <= 0xDF) {
+            n = 1;
+        } else if(c == 0xE0) {
+            n = 2; lo = 0xA0;   // overlong
+        } else if(c == 0xED) {
+            n = 2; hi = 0x9F;   // surrogates
+        } else if(c >= 0xE1 && c <= 0xEF) {
+            n = 2;
+        } else if(c == 0xF0) {
+            n = 3; lo = 0x90;   // overlong
+        } else if(c >= 0xF1 && c <= 0xF3) {
+            n = 3;
+        } else if(c == 0xF4) {
+            n = 3; hi = 0x8F;   // > U+10FFFF
+        } else {
+            return FALSE;
+        }
+
+        if(len - i - 1 < n) {
+            return FALSE;
+        }
+        if(s[i+1] < lo || s[i+1] > hi) {
+            return FALSE;
+        }
+        for(size_t k = 2; k <= n; k++) {
+            if((s[i+k] & 0xC0) != 0x80) {
+                return FALSE;
+            }
+        }
+        i += n + 1;
+    }
+    return TRUE;
+}
+
+#ifdef UTF8_VALIDATE_SIMD
+/*
+ *  Lookup algorithm of "Validating UTF-8 In Less Than One Instruction Per Byte",
+ *  John Keiser and Daniel Lemire, Software: Practice and Experience 51 (5), 2021.
+ *  Three nibble lookups classify every pair of consecutive bytes,
+ *  the 3rd/4th byte of long sequences are checked with saturated subtractions.
+ */
+#define U8_TOO_SHORT        (1<<0)
+#define U8_TOO_LONG         (1<<1)
+#define U8_OVERLONG_3       (1<<2)
+#define U8_TOO_LARGE        (1<<3)
+#define U8_SURROGATE        (1<<4)
+#define U8_OVERLONG_2       (1<<5)
+#define U8_TOO_LARGE_1000   (1<<6)
+#define U8_OVERLONG_4       (1<<6)
+#define U8_TWO_CONTS        (1<<7)
+#define U8_CARRY            (U8_TOO_SHORT | U8_TOO_LONG | U8_TWO_CONTS)
+
+#define U8_TABLE_BYTE_1_HIGH                                                \
+    /* 0_______ ascii */                                                    \
+    U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG,                     \
+    U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG,                     \
+    /* 10______ continuation */                                             \
+    (char)U8_TWO_CONTS, (char)U8_TWO_CONTS,                                 \
+    (char)U8_TWO_CONTS, (char)U8_TWO_CONTS,                                 \
+    /* 1100____ 1101____ two bytes lead */                                  \
+    U8_TOO_SHORT | U8_OVERLONG_2,                                           \
+    U8_TOO_SHORT,                                                           \
+    /* 1110____ three bytes lead */                                         \
+    U8_TOO_SHORT | U8_OVERLONG_3 | U8_SURROGATE,                            \
+    /* 1111____ four bytes lead */                                          \
+    U8_TOO_SHORT | U8_TOO_LARGE | U8_TOO_LARGE_1000 | U8_OVERLONG_4
+
+#define U8_TABLE_BYTE_1_LOW                                                 \
+    /* ____0000 */                                                          \
+    (char)(U8_CARRY | U8_OVERLONG_3 | U8_OVERLONG_2 | U8_OVERLONG_4),       \
+    /* ____0001 */                                                          \
+    (char)(U8_CARRY | U8_OVERLONG_2),                                       \
+    /* ____001_ */                                                          \
+    (char)U8_CARRY,                                                         \
+    (char)U8_CARRY,                                                         \
+    /* ____0100 */                                                          \
+    (char)(U8_CARRY | U8_TOO_LARGE),                                        \
+    /* ____0101 ____011_ ____1___ */                                        \
+    (char)(U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000),                    \
+    (char)(U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000),                    \
+    (char)(U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000),                    \
+    (char)(U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000),                    \
+    (char)(U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000),                    \
+    (char)(U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000),                    \
+    (char)(U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000),                    \
+    (char)(U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000),                    \
+    /* ____1101 */                                                          \
+    (char)(U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000 | U8_SURROGATE),     \
+    (char)(U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000),                    \
+    (char)(U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000)
+
+#define U8_TABLE_BYTE_2_HIGH                                                \
+    /* 0_______ ascii */                                                    \
+    U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT,                 \
+    U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT,                 \
+    /* 1000____ */                                                          \
+    (char)(U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_OVERLONG_3 |     \
+        U8_TOO_LARGE_1000 | U8_OVERLONG_4),                                 \
+    /* 1001____ */                                                          \
+    (char)(U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_OVERLONG_3 |     \
+        U8_TOO_LARGE),                                                      \
+    /* 101_____ */                                                          \
+    (char)(U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_SURROGATE |      \
+        U8_TOO_LARGE),                                                      \
+    (char)(U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_SURROGATE |      \
+        U8_TOO_LARGE),                                                      \
+    /* 11______ lead */                                                     \
+    U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT
+
+/***************************************************************************
+ *  SSSE3 UTF-8 validation, 16 bytes per step
+ ***************************************************************************/
+__attribute__((target("ssse3")))
+PRIVATE BOOL utf8_validate_ssse3(const uint8_t *s, size_t len)
+{
+    const __m128i table_1_high = _mm_setr_epi8(U8_TABLE_BYTE_1_HIGH);
+    const __m128i table_1_low = _mm_setr_epi8(U8_TABLE_BYTE_1_LOW);
+    const __m128i table_2_high = _mm_setr_epi8(U8_TABLE_BYTE_2_HIGH);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i third_byte = _mm_set1_epi8((char)(0xE0 - 0x80));
+    const __m128i fourth_byte = _mm_set1_epi8((char)(0xF0 - 0x80));
+    const __m128i high_bit = _mm_set1_epi8((char)0x80);
+    const __m128i max_complete = _mm_setr_epi8( // lead bytes in the last 3 positions
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1)
+    );
+
+    __m128i error = _mm_setzero_si128();
+    __m128i prev_input = _mm_setzero_si128();
+    __m128i prev_incomplete = _mm_setzero_si128();
+    uint8_t last[16];
+
+    for(size_t i = 0; i < len; i += 16) {
+        __m128i input;
+        if(len - i >= 16) {
+            input = _mm_loadu_si128((const __m128i *)(s + i));
+        } else {
+            /*
+             *  Pad the last block with ascii nulls,
+             *  a truncated sequence is caught as TOO_SHORT.
+             */
+            memset(last, 0, sizeof(last));
+            memcpy(last, s + i, len - i);
+            input = _mm_loadu_si128((const __m128i *)last);
+        }
+
+        if(_mm_movemask_epi8(input) == 0) {
+            error = _mm_or_si128(error, prev_incomplete);
+        } else {
+            __m128i prev1 = _mm_alignr_epi8(input, prev_input, 16 - 1);
+            __m128i byte_1_high = _mm_shuffle_epi8(
+                table_1_high, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)
+            );
+            __m128i byte_1_low = _mm_shuffle_epi8(
+                table_1_low, _mm_and_si128(prev1, nibble)
+            );
+            __m128i byte_2_high = _mm_shuffle_epi8(
+                table_2_high, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)
+            );
+            __m128i special_cases = _mm_and_si128(
+                _mm_and_si128(byte_1_high, byte_1_low), byte_2_high
+            );
+
+            __m128i prev2 = _mm_alignr_epi8(input, prev_input, 16 - 2);
+            __m128i prev3 = _mm_alignr_epi8(input, prev_input, 16 - 3);
+            __m128i must23 = _mm_or_si128(
+                _mm_subs_epu8(prev2, third_byte),
+                _mm_subs_epu8(prev3, fourth_byte)
+            );
+            __m128i must23_80 = _mm_and_si128(must23, high_bit);
+            error = _mm_or_si128(error, _mm_xor_si128(must23_80, special_cases));
+
+            prev_incomplete = _mm_subs_epu8(input, max_complete);
+        }
+        prev_input = input;
+    }
+    error = _mm_or_si128(error, prev_incomplete);
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+
+/***************************************************************************
+ *  AVX2 UTF-8 validation, 32 bytes per step
+ ***************************************************************************/
+__attribute__((target("avx2")))
+PRIVATE BOOL utf8_validate_avx2(const uint8_t *s, size_t len)
+{
+    const __m256i table_1_high = _mm256_setr_epi8(
+        U8_TABLE_BYTE_1_HIGH, U8_TABLE_BYTE_1_HIGH
+    );
+    const __m256i table_1_low = _mm256_setr_epi8(
+        U8_TABLE_BYTE_1_LOW, U8_TABLE_BYTE_1_LOW
+    );
+    const __m256i table_2_high = _mm256_setr_epi8(
+        U8_TABLE_BYTE_2_HIGH, U8_TABLE_BYTE_2_HIGH
+    );
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i third_byte = _mm256_set1_epi8((char)(0xE0 - 0x80));
+    const __m256i fourth_byte = _mm256_set1_epi8((char)(0xF0 - 0x80));
+    const __m256i high_bit = _mm256_set1_epi8((char)0x80);
+    const __m256i max_complete = _mm256_setr_epi8( // lead bytes in the last 3 positions
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1)
+    );
+
+    __m256i error = _mm256_setzero_si256();
+    __m256i prev_input = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    uint8_t last[32];
+
+    for(size_t i = 0; i < len; i += 32) {
+        __m256i input;
+        if(len - i >= 32) {
+            input = _mm256_loadu_si256((const __m256i *)(s + i));
+        } else {
+            memset(last, 0, sizeof(last));
+            memcpy(last, s + i, len - i);
+            input = _mm256_loadu_si256((const __m256i *)last);
+        }
+
+        if(_mm256_movemask_epi8(input) == 0) {
+            error = _mm256_or_si256(error, prev_incomplete);
+        } else {
+            /*
+             *  alignr works by 128 bits lanes,
+             *  feed it with the high lane of the previous block.
+             */
+            __m256i prev_cross = _mm256_permute2x128_si256(prev_input, input, 0x21);
+            __m256i prev1 = _mm256_alignr_epi8(input, prev_cross, 16 - 1);
+            __m256i byte_1_high = _mm256_shuffle_epi8(
+                table_1_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)
+            );
+            __m256i byte_1_low = _mm256_shuffle_epi8(
+                table_1_low, _mm256_and_si256(prev1, nibble)
+            );
+            __m256i byte_2_high = _mm256_shuffle_epi8(
+                table_2_high, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)
+            );
+            __m256i special_cases = _mm256_and_si256(
+                _mm256_and_si256(byte_1_high, byte_1_low), byte_2_high
+            );
+
+            __m256i prev2 = _mm256_alignr_epi8(input, prev_cross, 16 - 2);
+            __m256i prev3 = _mm256_alignr_epi8(input, prev_cross, 16 - 3);
+            __m256i must23 = _mm256_or_si256(
+                _mm256_subs_epu8(prev2, third_byte),
+                _mm256_subs_epu8(prev3, fourth_byte)
+            );
+            __m256i must23_80 = _mm256_and_si256(must23, high_bit);
+            error = _mm256_or_si256(error, _mm256_xor_si256(must23_80, special_cases));
+
+            prev_incomplete = _mm256_subs_epu8(input, max_complete);
+        }
+        prev_input = input;
+    }
+    error = _mm256_or_si256(error, prev_incomplete);
+
+    return _mm256_testz_si256(error, error);
+}
+#endif /* UTF8_VALIDATE_SIMD */
+
+/***************************************************************************
+ *  Return TRUE if `s` is valid UTF-8 (RFC 3629), same rules as jansson:
+ *  overlong forms, surrogates and code points above U+10FFFF are rejected,
+ *  nulls are accepted.
+ *  On x86_64 the AVX2 or SSSE3 version is selected at first use.
+ ***************************************************************************/
+PUBLIC BOOL utf8_validate(const char *s, size_t len)
+{
+#ifdef UTF8_VALIDATE_SIMD
+    static BOOL (*validate_fn)(const uint8_t *s, size_t len) = 0;
+
+    if(len < 16) {
+        return utf8_validate_scalar((const uint8_t *)s, len);
+    }
+    if(!validate_fn) {
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx2")) {
+            validate_fn = utf8_validate_avx2;
+        } else if(__builtin_cpu_supports("ssse3")) {
+            validate_fn = utf8_validate_ssse3;
+        } else {
+            validate_fn = utf8_validate_scalar;
+        }
+    }
+    return validate_fn((const uint8_t *)s, len);
+#else
+    return utf8_validate_scalar((const uint8_t *)s, len);
+#endif
+}
+
 
 
 
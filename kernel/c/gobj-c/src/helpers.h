@@ -270,6 +270,12 @@ PUBLIC int idx_in_list(const char **list, const char *str, BOOL ignore_case);
 **rst**/
 PUBLIC BOOL str_in_list(const char **list, const char *str, BOOL ignore_case);
 
+/**rst**
+    Return TRUE if the `len` bytes of `s` are valid UTF-8.
+    Vectorized (AVX2/SSSE3) on x86_64, scalar elsewhere.
+**rst**/
+PUBLIC BOOL utf8_validate(const char *s, size_t len);
+
 /*------------------------------------*
  *  json_config
  *------------------------------------*/
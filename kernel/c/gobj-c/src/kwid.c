@@ -52,7 +52,34 @@ typedef struct serialize_fields_s {
     decref_fn_t decref_fn;
 } serialize_fields_t;
 
+typedef struct {
+    const char *key;    // nul terminated, inside of kw_path_s
+    int idx;            // atoi(key), used when walking a list
+} kw_path_segment_t;
+
+struct kw_path_s {
+    const char *path;   // the original path, to log and to fall back to string functions
+    int n_segments;
+    kw_path_segment_t segments[];
+};
+
 PRIVATE json_t * _duplicate_object(json_t *kw, const char **keys, int underscores, BOOL serialize);
+PRIVATE json_int_t kw_int_value(
+    hgobj gobj,
+    json_t *kw,
+    const char *path,
+    json_t *jn_int,
+    json_int_t default_value,
+    kw_flag_t flag
+);
+PRIVATE const char *kw_str_value(
+    hgobj gobj,
+    json_t *kw,
+    const char *path,
+    json_t *jn_str,
+    const char *default_value,
+    kw_flag_t flag
+);
 
 /***************************************************************
  *              Data
@@ -539,33 +566,21 @@ PRIVATE const char *search_delimiter(const char *s, char delimiter_)
 }
 
 /***************************************************************************
-    Return the json's value find by path, walking over lists and dicts
+ *  Copy a path segment (not nul terminated) to bf, to log it
  ***************************************************************************/
-PRIVATE json_t *kw_find_path_depth(
-    hgobj gobj, json_t *kw, const char *path, BOOL verbose, int depth)
+PRIVATE const char *segment2str(char *bf, size_t bfsize, const char *segment, size_t len)
 {
-    if(depth >= KW_MAX_PATH_DEPTH) {
-        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER,
-            "msg",          "%s", "kw_find_path: max nesting depth exceeded",
-            "path",         "%s", path?path:"",
-            "depth",        "%d", depth,
-            NULL
-        );
-        return 0;
-    }
+    snprintf(bf, bfsize, "%.*s", (int)len, segment);
+    return bf;
+}
 
-    if(!(json_is_object(kw) || json_is_array(kw))) {
-        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER,
-            "msg",          "%s", "kw must be list or dict",
-            "path",         "%s", path?path:"",
-            NULL
-        );
-        return 0;
-    }
+/***************************************************************************
+    Return the json's value find by the first `path_len` bytes of path,
+    walking over lists and dicts. Without allocating.
+ ***************************************************************************/
+PRIVATE json_t *kw_find_pathn(
+    hgobj gobj, json_t *kw, const char *path, size_t path_len, BOOL verbose)
+{
     if(!path) {
         gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
             "function",     "%s", __FUNCTION__,
@@ -575,110 +590,122 @@ PRIVATE json_t *kw_find_path_depth(
         );
         return 0;
     }
-    if(kw->refcount <=0) {
-        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER,
-            "msg",          "%s", "json refcount 0",
-            "path",         "%s", path,
-            NULL
-        );
-        return 0;
-    }
 
-    const char *p = search_delimiter(path, delimiter[0]);
-    if(!p) {
-        if(json_is_object(kw)) {
-            // Dict
-            json_t *value = json_object_get(kw, path);
-            if(!value && verbose) {
-                gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
-                    "function",     "%s", __FUNCTION__,
-                    "msgset",       "%s", MSGSET_PARAMETER,
-                    "msg",          "%s", "path not found",
-                    "path",         "%s", path,
-                    NULL
-                );
-            }
-            return value;
+    char bf[256];
+    const char *full_path = path;
+    const char *end = path + path_len;
+
+    for(int depth=0; ; depth++) {
+        if(depth >= KW_MAX_PATH_DEPTH) {
+            gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PARAMETER,
+                "msg",          "%s", "kw_find_path: max nesting depth exceeded",
+                "path",         "%s", segment2str(bf, sizeof(bf), full_path, path_len),
+                "depth",        "%d", depth,
+                NULL
+            );
+            return 0;
+        }
+
+        if(!(json_is_object(kw) || json_is_array(kw))) {
+            gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PARAMETER,
+                "msg",          "%s", "kw must be list or dict",
+                "path",         "%s", segment2str(bf, sizeof(bf), full_path, path_len),
+                NULL
+            );
+            return 0;
+        }
+        if(kw->refcount <=0) {
+            gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PARAMETER,
+                "msg",          "%s", "json refcount 0",
+                "path",         "%s", segment2str(bf, sizeof(bf), full_path, path_len),
+                NULL
+            );
+            return 0;
+        }
 
+        const char *p = delimiter[0]? memchr(path, delimiter[0], (size_t)(end-path)) : NULL;
+        size_t len = p? (size_t)(p-path) : (size_t)(end-path);
+
+        /*
+         *  atoi() stops at the delimiter or at the end of the path,
+         *  the segment needs no copy.
+         */
+        json_t *value;
+        if(json_is_object(kw)) {
+            value = json_object_getn(kw, path, len);
         } else {
-            // Array
-            int idx = atoi(path);
-            json_t *value = json_array_get(kw, idx);
+            value = json_array_get(kw, (size_t)atoi(path));
+        }
+
+        if(!p) {
+            // Last segment
             if(!value && verbose) {
                 gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
                     "function",     "%s", __FUNCTION__,
                     "msgset",       "%s", MSGSET_PARAMETER,
                     "msg",          "%s", "path not found",
-                    "path",         "%s", path,
-                    "idx",          "%d", idx,
+                    "path",         "%s", segment2str(bf, sizeof(bf), full_path, path_len),
                     NULL
                 );
             }
             return value;
         }
-    }
-
-    char segment[256];
-    if(snprintf(segment, sizeof(segment), "%.*s", (int)(size_t)(p-path), path)>=sizeof(segment)) {
-        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_INTERNAL,
-            "msg",          "%s", "buffer too small",
-            "path",         "%s", path,
-            NULL
-        );
-    }
 
-    json_t *next_json = 0;
-    if(json_is_object(kw)) {
-        // Dict
-        next_json = json_object_get(kw, segment);
-        if(!next_json || json_is_null(next_json)) {
-            if(verbose) {
-                gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
-                    "function",     "%s", __FUNCTION__,
-                    "msgset",       "%s", MSGSET_PARAMETER,
-                    "msg",          "%s", "Dict segment not found",
-                    "path",         "%s", path,
-                    "segment",      "%s", segment,
-                    NULL
-                );
-            }
-            return 0;
-        }
-    } else {
-        // Array
-        int idx = atoi(segment);
-        next_json = json_array_get(kw, idx);
-        if(!next_json || json_is_null(next_json)) {
+        if(!value || json_is_null(value)) {
             if(verbose) {
+                char segment[256];
                 gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
                     "function",     "%s", __FUNCTION__,
                     "msgset",       "%s", MSGSET_PARAMETER,
-                    "msg",          "%s", "List segment not found",
-                    "path",         "%s", path,
-                    "segment",      "%s", segment,
-                    "idx",          "%d", idx,
+                    "msg",          "%s", json_is_object(kw)?
+                                            "Dict segment not found":"List segment not found",
+                    "path",         "%s", segment2str(bf, sizeof(bf), full_path, path_len),
+                    "segment",      "%s", segment2str(segment, sizeof(segment), path, len),
                     NULL
                 );
             }
             return 0;
         }
-    }
 
-    return kw_find_path_depth(gobj, next_json, p+1, verbose, depth+1);
+        kw = value;
+        path = p + 1;
+    }
 }
 
 PUBLIC json_t *kw_find_path(hgobj gobj, json_t *kw, const char *path, BOOL verbose)
 {
-    return kw_find_path_depth(gobj, kw, path, verbose, 0);
+    return kw_find_pathn(gobj, kw, path, path?strlen(path):0, verbose);
+}
+
+/***************************************************************************
+ *  Next not empty segment of path (empty ones are skipped, like split2()).
+ *  Return NULL if no more segments.
+ ***************************************************************************/
+PRIVATE const char *next_path_segment(const char *s, size_t *len)
+{
+    if(delimiter[0]) {
+        while(*s == delimiter[0]) {
+            s++;
+        }
+    }
+    if(!*s) {
+        return NULL;
+    }
+    const char *p = search_delimiter(s, delimiter[0]);
+    *len = p? (size_t)(p-s) : strlen(s);
+    return s;
 }
 
 /***************************************************************************
  *  Like json_object_set but with a path
  *  (doesn't create arrays, only objects)
+ *  Walk the path in place, without split2()
  ***************************************************************************/
 PUBLIC int kw_set_dict_value(
     hgobj gobj,
@@ -710,23 +737,23 @@ PUBLIC int kw_set_dict_value(
         return 0;
     }
 
-    int list_size = 0;
-    const char **segments = split2(path, delimiter, &list_size);
-
+    char bf[256];
     json_t *v = kw;
     BOOL fin = FALSE;
-    int i;
-    const char *segment = 0;
+    size_t len = 0;
+    const char *segment = path? next_path_segment(path, &len) : NULL;
     json_t *next = 0;
-    for(i=0; i<list_size && !fin; i++) {
-        segment = *(segments +i);
+    while(segment && !fin) {
+        size_t next_len = 0;
+        const char *next_segment = next_path_segment(segment + len, &next_len);
+
         if(!v) {
             gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
                 "function",     "%s", __FUNCTION__,
                 "msgset",       "%s", MSGSET_PARAMETER,
                 "msg",          "%s", "short path",
                 "path",         "%s", path,
-                "segment",      "%s", segment,
+                "segment",      "%s", segment2str(bf, sizeof(bf), segment, len),
                 NULL
             );
             break;
@@ -734,13 +761,13 @@ PUBLIC int kw_set_dict_value(
 
         switch(json_typeof(v)) {
         case JSON_OBJECT:
-            next = json_object_get(v, segment);
+            next = json_object_getn(v, segment, len);
             if(!next) {
-                if(i < list_size-1) {
+                if(next_segment) {
                     next = json_object();
-                    json_object_set_new(v, segment, next);
+                    json_object_setn_new(v, segment, len, next);
                 } else {
-                    json_object_set(v, segment, value);
+                    json_object_setn(v, segment, len, value);
                 }
             }
             v = next;
@@ -757,7 +784,7 @@ PUBLIC int kw_set_dict_value(
                         "msgset",       "%s", MSGSET_PARAMETER,
                         "msg",          "%s", "path not found",
                         "path",         "%s", path,
-                        "segment",      "%s", segment,
+                        "segment",      "%s", segment2str(bf, sizeof(bf), segment, len),
                         "idx",          "%d", idx,
                         NULL
                     );
@@ -770,24 +797,260 @@ PUBLIC int kw_set_dict_value(
             fin = TRUE;
             break;
         }
+
+        segment = next_segment;
+        len = next_len;
     }
 
-    if(i<list_size) {
+    if(segment) {
         gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_PARAMETER,
             "msg",          "%s", "long path",
             "path",         "%s", path,
-            "segment",      "%s", segment,
+            "segment",      "%s", segment2str(bf, sizeof(bf), segment, len),
             NULL
         );
     }
     JSON_DECREF(value)
-    split_free2(segments);
 
     return 0;
 }
 
+/***************************************************************************
+ *  Compile a path, with the current delimiter, in one allocation.
+ ***************************************************************************/
+PUBLIC kw_path_t *kw_path_create(hgobj gobj, const char *path)
+{
+    if(!path) {
+        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "path NULL",
+            NULL
+        );
+        return NULL;
+    }
+
+    size_t path_len = strlen(path);
+    int n_segments = 1;
+    for(const char *p=path; delimiter[0] && (p=strchr(p, delimiter[0])); p++) {
+        n_segments++;
+    }
+
+    size_t size = sizeof(kw_path_t) +
+        (size_t)n_segments * sizeof(kw_path_segment_t) +
+        2 * (path_len + 1); // the original path and its segments
+    kw_path_t *kw_path = GBMEM_MALLOC(size);
+    if(!kw_path) {
+        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY,
+            "msg",          "%s", "No memory",
+            "path",         "%s", path,
+            "size",         "%d", (int)size,
+            NULL
+        );
+        return NULL;
+    }
+
+    char *original = (char *)&kw_path->segments[n_segments];
+    char *keys = original + path_len + 1;
+    memcpy(original, path, path_len + 1);
+    memcpy(keys, path, path_len + 1);
+    kw_path->path = original;
+    kw_path->n_segments = n_segments;
+
+    char *key = keys;
+    for(int i=0; i<n_segments; i++) {
+        char *p = delimiter[0]? strchr(key, delimiter[0]) : NULL;
+        if(p) {
+            *p = 0;
+        }
+        kw_path->segments[i].key = key;
+        kw_path->segments[i].idx = atoi(key);
+        key = p? p + 1 : key + strlen(key);
+    }
+
+    return kw_path;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC void kw_path_destroy(kw_path_t *kw_path)
+{
+    GBMEM_FREE(kw_path);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC const char *kw_path_str(const kw_path_t *kw_path)
+{
+    return kw_path? kw_path->path : NULL;
+}
+
+/***************************************************************************
+ *  Like kw_find_path() with a compiled path
+ ***************************************************************************/
+PUBLIC json_t *kw_path_find(hgobj gobj, json_t *kw, const kw_path_t *kw_path, BOOL verbose)
+{
+    if(!kw_path) {
+        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "kw_path NULL",
+            NULL
+        );
+        return 0;
+    }
+
+    for(int i=0; i<kw_path->n_segments; i++) {
+        if(!(json_is_object(kw) || json_is_array(kw))) {
+            gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PARAMETER,
+                "msg",          "%s", "kw must be list or dict",
+                "path",         "%s", kw_path->path,
+                NULL
+            );
+            return 0;
+        }
+        if(kw->refcount <=0) {
+            gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PARAMETER,
+                "msg",          "%s", "json refcount 0",
+                "path",         "%s", kw_path->path,
+                NULL
+            );
+            return 0;
+        }
+
+        const kw_path_segment_t *segment = &kw_path->segments[i];
+        json_t *value;
+        if(json_is_object(kw)) {
+            value = json_object_get(kw, segment->key);
+        } else {
+            value = json_array_get(kw, (size_t)segment->idx);
+        }
+
+        if(i == kw_path->n_segments - 1) {
+            if(!value && verbose) {
+                gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+                    "function",     "%s", __FUNCTION__,
+                    "msgset",       "%s", MSGSET_PARAMETER,
+                    "msg",          "%s", "path not found",
+                    "path",         "%s", kw_path->path,
+                    NULL
+                );
+            }
+            return value;
+        }
+
+        if(!value || json_is_null(value)) {
+            if(verbose) {
+                gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+                    "function",     "%s", __FUNCTION__,
+                    "msgset",       "%s", MSGSET_PARAMETER,
+                    "msg",          "%s", json_is_object(kw)?
+                                            "Dict segment not found":"List segment not found",
+                    "path",         "%s", kw_path->path,
+                    "segment",      "%s", segment->key,
+                    NULL
+                );
+            }
+            return 0;
+        }
+        kw = value;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *  Like kw_set_dict_value() with a compiled path
+ ***************************************************************************/
+PUBLIC int kw_path_set_dict_value(
+    hgobj gobj,
+    json_t *kw,
+    const kw_path_t *kw_path,
+    json_t *value // owned
+)
+{
+    if(!kw_path) {
+        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "kw_path NULL",
+            NULL
+        );
+        JSON_DECREF(value)
+        return -1;
+    }
+
+    /*
+     *  Hot case: the parent dict exists, set the key.
+     *  Otherwise the string version creates the missing dicts and logs.
+     */
+    int n = kw_path->n_segments;
+    if(json_is_object(kw) && kw->refcount > 0 && *kw_path->segments[n-1].key) {
+        json_t *parent = kw;
+        for(int i=0; i<n-1 && parent; i++) {
+            const char *key = kw_path->segments[i].key;
+            if(!*key) {
+                continue; // empty segments are skipped, as in kw_set_dict_value()
+            }
+            parent = json_is_object(parent)? json_object_get(parent, key) : NULL;
+        }
+        if(json_is_object(parent)) {
+            const char *key = kw_path->segments[n-1].key;
+            if(!json_object_get(parent, key)) {
+                json_object_set(parent, key, value);
+            }
+            JSON_DECREF(value)
+            return 0;
+        }
+    }
+
+    return kw_set_dict_value(gobj, kw, kw_path->path, value);
+}
+
+/***************************************************************************
+ *  Like kw_get_int() with a compiled path
+ ***************************************************************************/
+PUBLIC json_int_t kw_path_get_int(
+    hgobj gobj,
+    json_t *kw,
+    const kw_path_t *kw_path,
+    json_int_t default_value,
+    kw_flag_t flag)
+{
+    json_t *jn_int = kw_path_find(gobj, kw, kw_path, FALSE);
+    if(!kw_path) {
+        return default_value; // Error already logged
+    }
+    return kw_int_value(gobj, kw, kw_path_str(kw_path), jn_int, default_value, flag);
+}
+
+/***************************************************************************
+ *  Like kw_get_str() with a compiled path
+ ***************************************************************************/
+PUBLIC const char *kw_path_get_str(
+    hgobj gobj,
+    json_t *kw,
+    const kw_path_t *kw_path,
+    const char *default_value,
+    kw_flag_t flag)
+{
+    json_t *jn_str = kw_path_find(gobj, kw, kw_path, FALSE);
+    if(!kw_path) {
+        return default_value; // Error already logged
+    }
+    return kw_str_value(gobj, kw, kw_path_str(kw_path), jn_str, default_value, flag);
+}
+
 /***************************************************************************
  *  Like json_object_set but with a path and subdict.
  ***************************************************************************/
@@ -827,12 +1090,11 @@ PUBLIC int kw_delete(
     const char *path
 ) {
     int ret = 0;
-    char *s = gbmem_strdup(path);
-    char *k = strrchr(s, delimiter[0]);
+    const char *k = delimiter[0]? strrchr(path, delimiter[0]) : NULL;
     if(k) {
-        *k = 0;
+        // Parent found by the path prefix, without copying the path
+        json_t *v = kw_find_pathn(gobj, kw, path, (size_t)(k-path), TRUE);
         k++;
-        json_t *v = kw_find_path(gobj, kw, s, TRUE);
         json_t *jn_item = json_object_get(v, k);
         if(jn_item) {
             json_object_del(v, k);
@@ -841,7 +1103,7 @@ PUBLIC int kw_delete(
                 "function",     "%s", __FUNCTION__,
                 "msgset",       "%s", MSGSET_PARAMETER,
                 "msg",          "%s", "path not found",
-                "path",         "%s", s,
+                "path",         "%s", path,
                 NULL
             );
             gobj_trace_json(gobj, kw, "path not found");
@@ -865,7 +1127,6 @@ PUBLIC int kw_delete(
         }
     }
 
-    GBMEM_FREE(s);
     return ret;
 }
 
@@ -1858,6 +2119,20 @@ PUBLIC json_int_t kw_get_int(
     kw_flag_t flag)
 {
     json_t *jn_int = kw_find_path(gobj, kw, path, FALSE);
+    return kw_int_value(gobj, kw, path, jn_int, default_value, flag);
+}
+
+/***************************************************************************
+ *  Int value of jn_int, the value found by path in kw
+ ***************************************************************************/
+PRIVATE json_int_t kw_int_value(
+    hgobj gobj,
+    json_t *kw,
+    const char *path,
+    json_t *jn_int,
+    json_int_t default_value,
+    kw_flag_t flag)
+{
     if(!jn_int) {
         if((flag & KW_CREATE) && kw) {
             json_t *jn_new = json_integer(default_value);
@@ -2086,6 +2361,20 @@ PUBLIC const char *kw_get_str(
     kw_flag_t flag)
 {
     json_t *jn_str = kw_find_path(gobj, kw, path, FALSE);
+    return kw_str_value(gobj, kw, path, jn_str, default_value, flag);
+}
+
+/***************************************************************************
+ *  String value of jn_str, the value found by path in kw
+ ***************************************************************************/
+PRIVATE const char *kw_str_value(
+    hgobj gobj,
+    json_t *kw,
+    const char *path,
+    json_t *jn_str,
+    const char *default_value,
+    kw_flag_t flag)
+{
     if(!jn_str) {
         if((flag & KW_CREATE) && kw) {
             json_t *jn_new;
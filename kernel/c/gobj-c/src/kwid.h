@@ -146,7 +146,7 @@ PUBLIC char kw_set_path_delimiter(char delimiter);
 
 /**rst**
     Return the json value find by path
-    Walk over dicts and lists
+    Walk over dicts and lists, without allocating
 **rst**/
 PUBLIC json_t *kw_find_path(hgobj gobj, json_t *kw, const char *path, BOOL verbose);
 
@@ -168,6 +168,41 @@ PUBLIC int kw_set_subdict_value(
     json_t *value // owned
 );
 
+/**rst**
+    Compiled path: the path split once, with the delimiter current at creation,
+    to reuse it in hot code without parsing the string on each call.
+    Create it in mt_create() and destroy it in mt_destroy().
+    Segments are NOT copied per call; missing parents (KW_CREATE) fall back
+    to the string functions.
+**rst**/
+typedef struct kw_path_s kw_path_t;
+
+PUBLIC kw_path_t *kw_path_create(hgobj gobj, const char *path);
+PUBLIC void kw_path_destroy(kw_path_t *kw_path);
+PUBLIC const char *kw_path_str(const kw_path_t *kw_path); // the original path
+
+PUBLIC json_t *kw_path_find(hgobj gobj, json_t *kw, const kw_path_t *kw_path, BOOL verbose);
+PUBLIC int kw_path_set_dict_value(
+    hgobj gobj,
+    json_t *kw,
+    const kw_path_t *kw_path,
+    json_t *value // owned
+);
+PUBLIC json_int_t kw_path_get_int(
+    hgobj gobj,
+    json_t *kw,
+    const kw_path_t *kw_path,
+    json_int_t default_value,
+    kw_flag_t flag
+);
+PUBLIC const char *kw_path_get_str(
+    hgobj gobj,
+    json_t *kw,
+    const kw_path_t *kw_path,
+    const char *default_value,
+    kw_flag_t flag
+);
+
 /**rst**
    Delete value searched by path
 **rst**/
@@ -164,6 +164,19 @@ PRIVATE json_t *_build_stats(hgobj gobj, const char *stats, json_t *kw, hgobj sr
         it++;
     }
 
+    /*----------------------------*
+     *      Native stat slots
+     *----------------------------*/
+    it = gobj_stats_desc(gobj);
+    for(int slot=0; it && it->name; slot++, it++) {
+        if(!empty_string(stats)) {
+            if(strstr(stats, it->name)==0) {
+                continue;
+            }
+        }
+        json_object_set_new(jn_data, it->name, json_integer(gobj_get_stat_slot(gobj, slot)));
+    }
+
     /*----------------------------*
      *      Stats in jn_stats
      *----------------------------*/
@@ -4,7 +4,9 @@
  *
  *          Gossamer UDP Server
  *
-    TODO review, dl_list is not a good choice for performance
+            Channels (one per peer "ip:port") are found by a hash table,
+            and kept in a list ordered by last activity:
+            the inactivity timeout only visits the expired channels.
 
             Api Gossamer
             ------------
@@ -54,6 +56,7 @@ PRIVATE UDP_CHANNEL *find_udp_channel(hgobj gobj, const char *name);
 PRIVATE UDP_CHANNEL *new_udp_channel(hgobj gobj, const char *name);
 PRIVATE void del_udp_channel(hgobj gobj, UDP_CHANNEL *ch);
 PRIVATE void free_channels(hgobj gobj);
+PRIVATE void touch_udp_channel(hgobj gobj, UDP_CHANNEL *ch);
 
 
 /***************************************************************************
@@ -68,6 +71,8 @@ SDATA (DTP_STRING,      "url",                  SDF_RD, 0, "url of udp server"),
 SDATA (DTP_INTEGER,     "timeout_base",         SDF_RD,  "5000", "timeout base"),
 SDATA (DTP_INTEGER,     "seconds_inactivity",   SDF_RD,  "300", "Seconds to consider a gossamer close"),
 SDATA (DTP_BOOLEAN,     "disable_end_of_frame", SDF_RD|SDF_STATS, 0, "Disable null as end of frame"),
+SDATA (DTP_INTEGER,     "rx_events",            SDF_RD,  "8", "Outstanding recvmsg events of the udp server"),
+SDATA (DTP_INTEGER,     "channels",             SDF_VOLATIL|SDF_STATS, "0", "Current channels"),
 SDATA (DTP_POINTER,     "user_data",            0,  0, "user data"),
 SDATA (DTP_POINTER,     "user_data2",           0,  0, "more user data"),
 SDATA (DTP_POINTER,     "subscriber",           0,  0, "subscriber of output-events. Default if null is parent."),
@@ -98,7 +103,8 @@ typedef struct _PRIVATE_DATA {
 
     hgobj gobj_udp_s;
     hgobj timer;
-    dl_list_t dl_channel;
+    dl_list_t dl_channel;   // ordered by last activity, the oldest first
+    json_t *jn_channels;    // name: UDP_CHANNEL *
 } PRIVATE_DATA;
 
 
@@ -128,12 +134,14 @@ PRIVATE void mt_create(hgobj gobj)
     SET_PRIV(seconds_inactivity,    gobj_read_integer_attr)
     SET_PRIV(disable_end_of_frame,  gobj_read_bool_attr)
 
-    json_t *kw_udps = json_pack("{s:s}",
-        "url", gobj_read_str_attr(gobj, "url")
+    json_t *kw_udps = json_pack("{s:s, s:I}",
+        "url", gobj_read_str_attr(gobj, "url"),
+        "rx_events", (json_int_t)gobj_read_integer_attr(gobj, "rx_events")
     );
     priv->gobj_udp_s = gobj_create("", C_UDP_S, kw_udps, gobj);
 
     dl_init(&priv->dl_channel, gobj);
+    priv->jn_channels = json_object();
 
     /*
      *  CHILD subscription model
@@ -183,6 +191,10 @@ PRIVATE int mt_stop(hgobj gobj)
  ***************************************************************************/
 PRIVATE void mt_destroy(hgobj gobj)
 {
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    free_channels(gobj);
+    JSON_DECREF(priv->jn_channels)
 }
 
 
@@ -216,6 +228,8 @@ PRIVATE UDP_CHANNEL *new_udp_channel(hgobj gobj, const char *name)
     }
     GBMEM_STRDUP(ch->name, name);
     dl_add(&priv->dl_channel, ch);
+    json_object_set_new(priv->jn_channels, name, json_integer((json_int_t)(uintptr_t)ch));
+    gobj_write_integer_attr(gobj, "channels", (json_int_t)dl_size(&priv->dl_channel));
 
     return ch;
 }
@@ -239,7 +253,9 @@ PRIVATE void del_udp_channel(hgobj gobj, UDP_CHANNEL *ch)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
+    json_object_del(priv->jn_channels, ch->name);
     dl_delete(&priv->dl_channel, ch, 0);
+    gobj_write_integer_attr(gobj, "channels", (json_int_t)dl_size(&priv->dl_channel));
     GBUFFER_DECREF(ch->gbuf);
     GBMEM_FREE(ch->name);
     GBMEM_FREE(ch);
@@ -251,19 +267,27 @@ PRIVATE void del_udp_channel(hgobj gobj, UDP_CHANNEL *ch)
 PRIVATE UDP_CHANNEL *find_udp_channel(hgobj gobj, const char *name)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
-    UDP_CHANNEL *ch;
 
     if(!name) {
         return 0;
     }
-    ch = dl_first(&priv->dl_channel);
-    while(ch) {
-        if(strcmp(ch->name, name)==0) {
-            return ch;
-        }
-        ch = dl_next(ch);
+    return (UDP_CHANNEL *)(uintptr_t)json_integer_value(
+        json_object_get(priv->jn_channels, name)
+    );
+}
+
+/***************************************************************************
+ *  Refresh the inactivity of the channel, moving it to the end of the list
+ ***************************************************************************/
+PRIVATE void touch_udp_channel(hgobj gobj, UDP_CHANNEL *ch)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    ch->t_inactivity = start_sectimer(priv->seconds_inactivity);
+    if(dl_last(&priv->dl_channel) != ch) {
+        dl_delete(&priv->dl_channel, ch, 0);
+        dl_add(&priv->dl_channel, ch);
     }
-    return 0;
 }
 
 
@@ -297,10 +321,15 @@ PRIVATE int ac_rx_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
             );
         }
         ch = new_udp_channel(gobj, udp_channel);
+        if(!ch) {
+            // Error already logged
+            KW_DECREF(kw);
+            return -1;
+        }
 
         gobj_publish_event(gobj, EV_ON_OPEN, 0);
     }
-    ch->t_inactivity = start_sectimer(priv->seconds_inactivity);
+    touch_udp_channel(gobj, ch);
 
     if(gobj_trace_level(gobj) & TRACE_DEBUG) {
         gobj_log_debug(gobj, 0,
@@ -413,16 +442,18 @@ PRIVATE int ac_transmit_ready(hgobj gobj, gobj_event_t event, json_t *kw, hgobj
 PRIVATE int ac_timeout(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
-    UDP_CHANNEL *ch, *nx;
-
-    ch = dl_first(&priv->dl_channel);
-    while(ch) {
-        nx = dl_next(ch);
-        if(test_sectimer(ch->t_inactivity)) {
-            gobj_publish_event(gobj, EV_ON_CLOSE, 0);
-            del_udp_channel(gobj, ch);
+    UDP_CHANNEL *ch;
+
+    /*
+     *  The list is ordered by last activity (all channels have the same inactivity),
+     *  stop at the first one not expired.
+     */
+    while((ch = dl_first(&priv->dl_channel))) {
+        if(!test_sectimer(ch->t_inactivity)) {
+            break;
         }
-        ch = nx;
+        gobj_publish_event(gobj, EV_ON_CLOSE, 0);
+        del_udp_channel(gobj, ch);
     }
 
     KW_DECREF(kw);
@@ -129,6 +129,9 @@ typedef struct _PRIVATE_DATA {
 
     uint64_t last_ms;
 
+    kw_path_t *path_temp_channel;       // "__temp__`channel", read on every message
+    kw_path_t *path_temp_channel_gobj;  // "__temp__`channel_gobj"
+
 } PRIVATE_DATA;
 
 
@@ -165,6 +168,20 @@ PRIVATE void mt_create(hgobj gobj)
      *  HACK The writable attributes must be repeated in mt_writing method.
      */
     SET_PRIV(send_type,                 gobj_read_integer_attr)
+
+    priv->path_temp_channel = kw_path_create(gobj, "__temp__`channel");
+    priv->path_temp_channel_gobj = kw_path_create(gobj, "__temp__`channel_gobj");
+}
+
+/***************************************************************************
+ *      Framework Method destroy
+ ***************************************************************************/
+PRIVATE void mt_destroy(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    kw_path_destroy(priv->path_temp_channel);
+    kw_path_destroy(priv->path_temp_channel_gobj);
 }
 
 /***************************************************************************
@@ -773,8 +790,8 @@ PRIVATE int send_one_rotate(hgobj gobj, gobj_event_t event, json_t *kw, hgobj sr
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    const char *channel = kw_get_str(gobj, kw, "__temp__`channel", "", 0);
-    hgobj channel_gobj = (hgobj)(size_t)kw_get_int(gobj, kw, "__temp__`channel_gobj", 0, 0);
+    const char *channel = kw_path_get_str(gobj, kw, priv->path_temp_channel, "", 0);
+    hgobj channel_gobj = (hgobj)(size_t)kw_path_get_int(gobj, kw, priv->path_temp_channel_gobj, 0, 0);
     if(!channel_gobj) {
         if(!empty_string(channel)) {
             channel_gobj = gobj_child_by_name(gobj, channel);
@@ -1170,12 +1187,14 @@ PRIVATE int ac_send_iev(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
  ***************************************************************************/
 PRIVATE int ac_drop(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
 {
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
     hgobj channel_gobj = gobj_bottom_gobj(gobj); // See firstly if it's a tube
     if(!channel_gobj) {
-        channel_gobj = (hgobj)(size_t)kw_get_int(gobj, kw, "__temp__`channel_gobj", 0, 0);
+        channel_gobj = (hgobj)(size_t)kw_path_get_int(gobj, kw, priv->path_temp_channel_gobj, 0, 0);
     }
     if(!channel_gobj) {
-        const char *channel = kw_get_str(gobj, kw, "__temp__`channel", "", 0);
+        const char *channel = kw_path_get_str(gobj, kw, priv->path_temp_channel, "", 0);
         if(!empty_string(channel)) {
             channel_gobj = gobj_child_by_name(gobj, channel);
             if(!channel_gobj) {
@@ -1255,6 +1274,7 @@ PRIVATE int ac_stopped(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
  *---------------------------------------------*/
 PRIVATE const GMETHODS gmt = {
     .mt_create = mt_create,
+    .mt_destroy = mt_destroy,
     .mt_start = mt_start,
     .mt_stop = mt_stop,
     .mt_stats = mt_stats,
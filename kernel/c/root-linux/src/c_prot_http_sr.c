@@ -4,10 +4,30 @@
  *
  *          Protocol http as server
  *
+ *          Persistent connections (HTTP/1.1 keep-alive) and pipelining:
+ *          - the connection is closed after answering a request
+ *            that doesn't want keep-alive (HTTP/1.0, Connection: close)
+ *            or the request number `max_requests_per_connection`.
+ *            Requests pipelined after that one are ignored.
+ *          - between requests the idle timeout is `timeout_keep_alive`.
+ *          - each request is published with "__http_seq__",
+ *            the responses (EV_SEND_MESSAGE) echoing it are written
+ *            in the order of the requests, whatever the order of answering.
+ *            A response without "__http_seq__" is the answer of the oldest
+ *            request not answered yet (FIFO), as if it had echoed its seq.
+ *
+ *          File responses: EV_SEND_MESSAGE with "file" (path) instead of "body".
+ *          The file is sent by the transport (EV_TX_FILE), without copies
+ *          in user space when there is no TLS. ETag, If-None-Match,
+ *          single Range (and If-Range) and HEAD are supported.
+ *
  *          Copyright (c) 2018-2021 Niyamaka.
  *          All Rights Reserved.
  ***********************************************************************/
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
 
 #include <gobj.h>
 #include <g_ev_kernel.h>
@@ -25,10 +45,21 @@
 /***************************************************************************
  *              Structures
  ***************************************************************************/
+typedef struct {
+    DL_ITEM_FIELDS
+
+    uint64_t seq;       // __http_seq__ of the request
+    gbuffer_t *gbuf;    // response ready to write
+    json_t *jn_file;    // file to send after gbuf, kw of EV_TX_FILE
+} HELD_RESPONSE;
 
 /***************************************************************************
  *              Prototypes
  ***************************************************************************/
+PRIVATE GHTTP_PARSER *create_request_parser(hgobj gobj);
+PRIVATE void reset_connection_state(hgobj gobj);
+PRIVATE void free_held_response(void *item);
+PRIVATE void remember_request(hgobj gobj, json_t *kw, uint64_t seq);
 
 
 /***************************************************************************
@@ -41,6 +72,9 @@
 PRIVATE sdata_desc_t attrs_table[] = {
 /*-ATTR-type------------name----------------flag------------default---------description---------- */
 SDATA (DTP_INTEGER,     "timeout_inactivity",SDF_WR,        "300",          "Timeout inactivity, in seconds"),
+SDATA (DTP_INTEGER,     "timeout_keep_alive",SDF_WR,        "60",           "Idle timeout between requests of a persistent connection, in seconds. 0: use timeout_inactivity"),
+SDATA (DTP_INTEGER,     "max_requests_per_connection",SDF_WR,"0",           "Close the connection after answering this number of requests. 0: unlimited"),
+SDATA (DTP_BOOLEAN,     "raw_body_data",    SDF_RD,         "FALSE",        "Publish the headers (EV_ON_HEADER) and raw partial data of body (EV_ON_MESSAGE with __pbf__) instead of the full request at the end"),
 SDATA (DTP_POINTER,     "user_data",        0,              0,              "user data"),
 SDATA (DTP_POINTER,     "user_data2",       0,              0,              "more user data"),
 SDATA (DTP_POINTER,     "subscriber",       0,              0,              "subscriber of output-events. If it's null then subscriber is the parent."),
@@ -66,6 +100,21 @@ typedef struct _PRIVATE_DATA {
     GHTTP_PARSER *parsing_request;      // A request parser instance
 
     int timeout_inactivity;
+    int timeout_keep_alive;
+    int max_requests_per_connection;
+    BOOL raw_body_data;
+
+    /*
+     *  Persistent connection, reset in each connection
+     */
+    uint64_t rx_seq;            // __http_seq__ of the last request == requests received
+    uint64_t tx_seq;            // __http_seq__ of the last response written in order
+    uint64_t responses;         // responses sent
+    uint64_t close_seq;         // __http_seq__ of the request closing the connection
+    BOOL close_pending;         // close when all the responses are sent
+    BOOL ignoring_request;      // pipelined after the closing request
+    json_t *jn_requests;        // {__http_seq__: {method, range headers}} for file responses
+    dl_list_t dl_held;          // responses waiting for the previous ones, HELD_RESPONSE
 } PRIVATE_DATA;
 
 
@@ -86,15 +135,12 @@ PRIVATE void mt_create(hgobj gobj)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
+    dl_init(&priv->dl_held, gobj);
+    priv->jn_requests = json_object();
+
     priv->timer = gobj_create_pure_child(gobj_name(gobj), C_TIMER, 0, gobj);
-    priv->parsing_request = ghttp_parser_create(
-        gobj,
-        HTTP_REQUEST,
-        NULL,                   // on_header_event
-        NULL,                   // on_body_event
-        EV_ON_MESSAGE,
-        gobj_is_service(gobj)?FALSE:TRUE // TRUE: use gobj_send_event, FALSE: use gobj_publish_event
-    );
+    SET_PRIV(raw_body_data,         gobj_read_bool_attr)
+    priv->parsing_request = create_request_parser(gobj);
 
     /*
      *  CHILD subscription model
@@ -110,6 +156,8 @@ PRIVATE void mt_create(hgobj gobj)
      *  HACK The writable attributes must be repeated in mt_writing method.
      */
     SET_PRIV(timeout_inactivity,    gobj_read_integer_attr)
+    SET_PRIV(timeout_keep_alive,    gobj_read_integer_attr)
+    SET_PRIV(max_requests_per_connection, gobj_read_integer_attr)
 }
 
 /***************************************************************************
@@ -120,6 +168,8 @@ PRIVATE void mt_writing(hgobj gobj, const char *path)
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
     IF_EQ_SET_PRIV(timeout_inactivity,          gobj_read_integer_attr)
+    ELIF_EQ_SET_PRIV(timeout_keep_alive,        gobj_read_integer_attr)
+    ELIF_EQ_SET_PRIV(max_requests_per_connection, gobj_read_integer_attr)
     END_EQ_SET_PRIV()
 }
 
@@ -158,6 +208,8 @@ PRIVATE void mt_destroy(hgobj gobj)
         ghttp_parser_destroy(priv->parsing_request);
         priv->parsing_request = 0;
     }
+    dl_flush(&priv->dl_held, free_held_response);
+    JSON_DECREF(priv->jn_requests)
 }
 
 
@@ -170,6 +222,440 @@ PRIVATE void mt_destroy(hgobj gobj)
 
 
 
+/***************************************************************************
+ *  Build the request parser.
+ *  With raw_body_data the body is not accumulated in memory:
+ *  the headers go in EV_ON_HEADER and each chunk of body in EV_ON_MESSAGE
+ *  with the original buffer pointer (__pbf__, __pbf_size__).
+ *  The last EV_ON_MESSAGE without __pbf__ indicates the end of the request.
+ ***************************************************************************/
+PRIVATE GHTTP_PARSER *create_request_parser(hgobj gobj)
+{
+    /*
+     *  Send the events to self, not publish them:
+     *  the requests must be counted before being published.
+     */
+    BOOL send_event = TRUE; // TRUE: use gobj_send_event, FALSE: use gobj_publish_event
+
+    if(!gobj_read_bool_attr(gobj, "raw_body_data")) {
+        return ghttp_parser_create(
+            gobj,
+            HTTP_REQUEST,   // http_parser_type
+            NULL,           // on_header_event
+            NULL,           // on_body_event
+            EV_ON_MESSAGE,  // on_message_event ==> publish the full message in a gbuffer
+            send_event
+        );
+    } else {
+        return ghttp_parser_create(
+            gobj,
+            HTTP_REQUEST,   // http_parser_type
+            EV_ON_HEADER,   // on_header_event
+            EV_ON_MESSAGE,  // on_body_event  ==> publish the partial message with original buffer pointer
+            NULL,           // on_message_event
+            send_event
+        );
+    }
+}
+
+/***************************************************************************
+ *  New connection, new persistent connection state
+ ***************************************************************************/
+PRIVATE void reset_connection_state(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->rx_seq = 0;
+    priv->tx_seq = 0;
+    priv->responses = 0;
+    priv->close_seq = 0;
+    priv->close_pending = FALSE;
+    priv->ignoring_request = FALSE;
+    dl_flush(&priv->dl_held, free_held_response);
+    json_object_clear(priv->jn_requests);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void free_held_response(void *item)
+{
+    HELD_RESPONSE *held = item;
+    GBUFFER_DECREF(held->gbuf)
+    JSON_DECREF(held->jn_file)
+    GBMEM_FREE(held);
+}
+
+/***************************************************************************
+ *  Write a response to the transport, jn_file (owned) can be null
+ ***************************************************************************/
+PRIVATE int write_response(hgobj gobj, gbuffer_t *gbuf, json_t *jn_file)
+{
+    if(gobj_trace_level(gobj) & TRAFFIC) {
+        gobj_trace_dump_gbuf(
+            gobj,
+            gbuf,
+            "%s", gobj_short_name(gobj_bottom_gobj(gobj))
+        );
+    }
+
+    json_t *kw_response = json_pack("{s:I}",
+        "gbuffer", (json_int_t)(uintptr_t)gbuf
+    );
+    int ret = gobj_send_event(gobj_bottom_gobj(gobj), EV_TX_DATA, kw_response, gobj);
+    if(jn_file) {
+        ret += gobj_send_event(gobj_bottom_gobj(gobj), EV_TX_FILE, jn_file, gobj);
+    }
+    return ret;
+}
+
+/***************************************************************************
+ *  Write the response in the order of the requests.
+ *  seq 0: no request pending, write it now.
+ ***************************************************************************/
+PRIVATE int send_response(hgobj gobj, gbuffer_t *gbuf, json_t *jn_file, uint64_t seq)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    int ret = 0;
+
+    if(seq && (seq <= priv->tx_seq || seq > priv->rx_seq)) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PROTOCOL,
+            "msg",          "%s", "http response with __http_seq__ not pending",
+            "seq",          "%ld", (long)seq,
+            "tx_seq",       "%ld", (long)priv->tx_seq,
+            "rx_seq",       "%ld", (long)priv->rx_seq,
+            NULL
+        );
+        GBUFFER_DECREF(gbuf)
+        JSON_DECREF(jn_file)
+        return -1;
+    }
+
+    priv->responses++;
+
+    if(!seq) {
+        ret = write_response(gobj, gbuf, jn_file);
+
+    } else if(seq == priv->tx_seq + 1) {
+        ret = write_response(gobj, gbuf, jn_file);
+        priv->tx_seq++;
+
+        /*
+         *  Write the held responses that are now in turn
+         */
+        HELD_RESPONSE *held;
+        do {
+            DL_FOREACH(&priv->dl_held, held) {
+                if(held->seq == priv->tx_seq + 1) {
+                    break;
+                }
+            }
+            if(held) {
+                dl_delete(&priv->dl_held, held, 0);
+                ret += write_response(gobj, held->gbuf, held->jn_file);
+                priv->tx_seq++;
+                gbmem_free(held);
+            }
+        } while(held);
+
+    } else {
+        HELD_RESPONSE *held = GBMEM_MALLOC(sizeof(HELD_RESPONSE));
+        if(!held) {
+            // Error already logged
+            GBUFFER_DECREF(gbuf)
+            JSON_DECREF(jn_file)
+            return -1;
+        }
+        held->seq = seq;
+        held->gbuf = gbuf;
+        held->jn_file = jn_file;
+        dl_add(&priv->dl_held, held);
+    }
+
+    if(priv->responses >= priv->rx_seq) {
+        /*
+         *  Idle connection, waiting the next request
+         */
+        if(priv->timeout_keep_alive > 0) {
+            set_timeout(priv->timer, priv->timeout_keep_alive*1000);
+        }
+    }
+
+    return ret;
+}
+
+/***************************************************************************
+ *  Keep what a file response needs of the request:
+ *  HEAD method and the conditional/range headers, only if present.
+ ***************************************************************************/
+PRIVATE void remember_request(hgobj gobj, json_t *kw, uint64_t seq)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_t *jn_headers = kw_get_dict(gobj, kw, "headers", 0, 0);
+    BOOL head = (kw_get_int(gobj, kw, "request_method", 0, 0) == HTTP_HEAD)? TRUE:FALSE;
+    const char *keys[] = {"RANGE", "IF-RANGE", "IF-NONE-MATCH", 0};
+
+    json_t *jn_request = 0;
+    for(int i=0; keys[i] && jn_headers; i++) {
+        json_t *jn_value = json_object_get(jn_headers, keys[i]);
+        if(json_is_string(jn_value)) {
+            if(!jn_request) {
+                jn_request = json_object();
+            }
+            json_object_set(jn_request, keys[i], jn_value);
+        }
+    }
+    if(head) {
+        if(!jn_request) {
+            jn_request = json_object();
+        }
+        json_object_set_new(jn_request, "HEAD", json_true());
+    }
+    if(jn_request) {
+        char key[32];
+        snprintf(key, sizeof(key), "%lu", (unsigned long)seq);
+        json_object_set_new(priv->jn_requests, key, jn_request);
+    }
+}
+
+/***************************************************************************
+ *  Return (owned) and forget the request info of a response, can be null
+ ***************************************************************************/
+PRIVATE json_t *pop_request(hgobj gobj, uint64_t seq)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(!seq) {
+        return 0;
+    }
+    char key[32];
+    snprintf(key, sizeof(key), "%lu", (unsigned long)seq);
+    json_t *jn_request = json_object_get(priv->jn_requests, key);
+    if(jn_request) {
+        json_incref(jn_request);
+        json_object_del(priv->jn_requests, key);
+    }
+    return jn_request;
+}
+
+/***************************************************************************
+ *  Content type by the extension of the file
+ ***************************************************************************/
+PRIVATE const char *file_content_type(const char *path)
+{
+    static const struct {
+        const char *ext;
+        const char *content_type;
+    } types[] = {
+        {".html",   "text/html; charset=utf-8"},
+        {".htm",    "text/html; charset=utf-8"},
+        {".css",    "text/css; charset=utf-8"},
+        {".js",     "text/javascript; charset=utf-8"},
+        {".json",   "application/json; charset=utf-8"},
+        {".txt",    "text/plain; charset=utf-8"},
+        {".svg",    "image/svg+xml"},
+        {".png",    "image/png"},
+        {".jpg",    "image/jpeg"},
+        {".jpeg",   "image/jpeg"},
+        {".ico",    "image/x-icon"},
+        {".wasm",   "application/wasm"},
+        {".gz",     "application/gzip"},
+        {0, 0}
+    };
+
+    const char *ext = strrchr(path, '.');
+    if(ext && !strchr(ext, '/')) {
+        for(int i=0; types[i].ext; i++) {
+            if(strcasecmp(ext, types[i].ext)==0) {
+                return types[i].content_type;
+            }
+        }
+    }
+    return "application/octet-stream";
+}
+
+/***************************************************************************
+ *  Parse a "Range: bytes=" header, only one range.
+ *  Return 1 if partial content in [first,last],
+ *  0 if the range must be ignored (full content), -1 if not satisfiable.
+ ***************************************************************************/
+PRIVATE int parse_range(const char *range, uint64_t size, uint64_t *first, uint64_t *last)
+{
+    if(strncmp(range, "bytes=", 6)!=0 || strchr(range, ',')) {
+        // Unknown unit or several ranges (multipart/byteranges): send it all
+        return 0;
+    }
+    const char *p = range + 6;
+    char *end;
+
+    if(*p == '-') {
+        /*
+         *  Suffix: the last n bytes
+         */
+        unsigned long long n = strtoull(p+1, &end, 10);
+        if(end == p+1 || *end) {
+            return 0;
+        }
+        if(n == 0 || size == 0) {
+            return -1;
+        }
+        *first = (n >= size)? 0 : size - n;
+        *last = size - 1;
+        return 1;
+    }
+
+    unsigned long long a = strtoull(p, &end, 10);
+    if(end == p || *end != '-') {
+        return 0;
+    }
+    p = end + 1;
+    unsigned long long b = size? size - 1 : 0;
+    if(*p) {
+        b = strtoull(p, &end, 10);
+        if(end == p || *end || b < a) {
+            return 0;
+        }
+        if(b >= size) {
+            b = size - 1;
+        }
+    }
+    if(a >= size) {
+        return -1;
+    }
+    *first = a;
+    *last = b;
+    return 1;
+}
+
+/***************************************************************************
+ *  Build the headers of a file response,
+ *  return in *jn_file the kw of EV_TX_FILE with the range to send (null if no body)
+ ***************************************************************************/
+PRIVATE gbuffer_t *build_file_response(
+    hgobj gobj,
+    json_t *kw,             // not owned
+    json_t *jn_request,     // not owned, can be null
+    const char *connection,
+    json_t **jn_file
+)
+{
+    const char *path = kw_get_str(gobj, kw, "file", "", 0);
+    const char *headers = kw_get_str(gobj, kw, "headers", "", 0);
+    const char *content_type = kw_get_str(gobj, kw, "content_type", "", 0);
+    if(empty_string(content_type)) {
+        content_type = file_content_type(path);
+    }
+    *jn_file = 0;
+
+    gbuffer_t *gbuf = gbuffer_create(512 + strlen(headers), 512 + strlen(headers));
+    if(!gbuf) {
+        // Error already logged
+        return 0;
+    }
+
+    struct stat st;
+    if(stat(path, &st) < 0 || !S_ISREG(st.st_mode)) {
+        gobj_log_warning(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "File to send not found",
+            "path",         "%s", path,
+            NULL
+        );
+        gbuffer_printf(gbuf,
+            "HTTP/1.1 404 Not Found\r\n"
+            "%s"
+            "%s"
+            "Content-Length: 0\r\n\r\n",
+            connection,
+            headers
+        );
+        return gbuf;
+    }
+
+    uint64_t size = (uint64_t)st.st_size;
+    char etag[64];
+    snprintf(etag, sizeof(etag), "\"%lx-%lx\"", (unsigned long)st.st_mtime, (unsigned long)size);
+
+    const char *if_none_match = jn_request? kw_get_str(gobj, jn_request, "IF-NONE-MATCH", 0, 0):0;
+    const char *range = jn_request? kw_get_str(gobj, jn_request, "RANGE", 0, 0):0;
+    const char *if_range = jn_request? kw_get_str(gobj, jn_request, "IF-RANGE", 0, 0):0;
+    BOOL head = jn_request? kw_get_bool(gobj, jn_request, "HEAD", 0, 0):FALSE;
+
+    if(if_none_match && (strcmp(if_none_match, "*")==0 || strstr(if_none_match, etag))) {
+        gbuffer_printf(gbuf,
+            "HTTP/1.1 304 Not Modified\r\n"
+            "%s"
+            "%s"
+            "ETag: %s\r\n\r\n",
+            connection,
+            headers,
+            etag
+        );
+        return gbuf;
+    }
+
+    uint64_t first = 0;
+    uint64_t last = size? size - 1 : 0;
+    int partial = 0;
+    if(range && size > 0 && (!if_range || strcmp(if_range, etag)==0)) {
+        partial = parse_range(range, size, &first, &last);
+    }
+
+    if(partial < 0) {
+        gbuffer_printf(gbuf,
+            "HTTP/1.1 416 Range Not Satisfiable\r\n"
+            "%s"
+            "%s"
+            "Content-Range: bytes */%lu\r\n"
+            "Content-Length: 0\r\n\r\n",
+            connection,
+            headers,
+            (unsigned long)size
+        );
+        return gbuf;
+    }
+
+    uint64_t length = size? last - first + 1 : 0;
+    gbuffer_printf(gbuf,
+        "HTTP/1.1 %s\r\n"
+        "%s"
+        "%s"
+        "Content-Type: %s\r\n"
+        "ETag: %s\r\n"
+        "Accept-Ranges: bytes\r\n",
+        partial? "206 Partial Content" : "200 OK",
+        connection,
+        headers,
+        content_type,
+        etag
+    );
+    if(partial) {
+        gbuffer_printf(gbuf,
+            "Content-Range: bytes %lu-%lu/%lu\r\n",
+            (unsigned long)first,
+            (unsigned long)last,
+            (unsigned long)size
+        );
+    }
+    gbuffer_printf(gbuf,
+        "Content-Length: %lu\r\n\r\n",
+        (unsigned long)length
+    );
+
+    if(!head && length > 0) {
+        *jn_file = json_pack("{s:s, s:I, s:I}",
+            "path", path,
+            "offset", (json_int_t)first,
+            "length", (json_int_t)length
+        );
+    }
+    return gbuf;
+}
+
 /***************************************************************************
  *  Parse a http message
  *  Return -1 if error: you must close the socket.
@@ -221,14 +707,8 @@ PRIVATE int ac_connected(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
     if(priv->parsing_request) {
         ghttp_parser_destroy(priv->parsing_request);
     }
-    priv->parsing_request = ghttp_parser_create(
-        gobj,
-        HTTP_REQUEST,
-        NULL,                   // on_header_event
-        NULL,                   // on_body_event
-        EV_ON_MESSAGE,
-        gobj_is_service(gobj)?FALSE:TRUE
-    );
+    priv->parsing_request = create_request_parser(gobj);
+    reset_connection_state(gobj);
 
     gobj_publish_event(gobj, EV_ON_OPEN, 0);
 
@@ -255,6 +735,8 @@ PRIVATE int ac_disconnected(hgobj gobj, gobj_event_t event, json_t *kw, hgobj sr
     if(priv->parsing_request) {
         (void)ghttp_parser_finish(priv->parsing_request);
     }
+    dl_flush(&priv->dl_held, free_held_response);
+    json_object_clear(priv->jn_requests);
 
     if(gobj_is_volatil(src)) {
         gobj_set_bottom_gobj(gobj, 0);
@@ -266,10 +748,43 @@ PRIVATE int ac_disconnected(hgobj gobj, gobj_event_t event, json_t *kw, hgobj sr
 }
 
 /***************************************************************************
- *  Message completed
+ *  Message completed, or headers/body chunk if raw_body_data
  ***************************************************************************/
 PRIVATE int ac_on_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
 {
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(event == EV_ON_HEADER || !priv->raw_body_data) {
+        /*
+         *  New request
+         */
+        if(priv->close_pending) {
+            /*
+             *  Pipelined after the request closing the connection, ignore it
+             */
+            priv->ignoring_request = TRUE;
+            KW_DECREF(kw)
+            return 0;
+        }
+        priv->ignoring_request = FALSE;
+
+        priv->rx_seq++;
+        json_object_set_new(kw, "__http_seq__", json_integer((json_int_t)priv->rx_seq));
+        remember_request(gobj, kw, priv->rx_seq);
+
+        if(!kw_get_bool(gobj, kw, "should_keep_alive", TRUE, 0) ||
+            (priv->max_requests_per_connection > 0 &&
+                priv->rx_seq >= (uint64_t)priv->max_requests_per_connection)
+        ) {
+            priv->close_pending = TRUE;
+            priv->close_seq = priv->rx_seq;
+        }
+
+    } else if(priv->ignoring_request) {
+        KW_DECREF(kw)
+        return 0;
+    }
+
     gobj_publish_event(gobj, event, kw);
     return 0;
 }
@@ -298,14 +813,55 @@ PRIVATE int ac_rx_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
     return 0;
 }
 
+/***************************************************************************
+ *  Flow control: the consumer of the body chunks is slower than the peer,
+ *  stop/restart reading the transport (the tcp window does the rest).
+ ***************************************************************************/
+PRIVATE int ac_pause_rx(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    return gobj_send_event(gobj_bottom_gobj(gobj), event, kw, gobj);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_resume_rx(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    return gobj_send_event(gobj_bottom_gobj(gobj), event, kw, gobj);
+}
+
 /********************************************************************
  *
  ********************************************************************/
 PRIVATE int ac_send_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
 {
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
     gbuffer_t *gbuf = 0;
 
-    if(kw_has_key(kw, "body")) {
+    /*
+     *  Not echoed: it's the answer of the oldest request not answered.
+     *  tx_seq + 1 is never held, it would have been written.
+     */
+    uint64_t seq = (uint64_t)kw_get_int(gobj, kw, "__http_seq__", 0, 0);
+    if(!seq && priv->tx_seq < priv->rx_seq) {
+        seq = priv->tx_seq + 1;
+    }
+
+    /*
+     *  Is it the last response of the connection?
+     */
+    BOOL closing = FALSE;
+    if(priv->close_pending) {
+        closing = seq? (seq == priv->close_seq) : (priv->responses + 1 >= priv->rx_seq);
+    }
+    const char *connection = closing? "Connection: close\r\n" : "";
+    json_t *jn_request = pop_request(gobj, seq);
+    json_t *jn_file = 0;
+
+    if(kw_has_key(kw, "file")) {
+        gbuf = build_file_response(gobj, kw, jn_request, connection, &jn_file);
+
+    } else if(kw_has_key(kw, "body")) {
         // New method
         const char *code = kw_get_str(gobj, kw, "code", "200 OK", 0);
         const char *headers = kw_get_str(gobj, kw, "headers", "", 0);
@@ -332,17 +888,21 @@ PRIVATE int ac_send_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj sr
             gbuffer_printf(gbuf,
                 "HTTP/1.1 %s\r\n"
                 "%s"
+                "%s"
                 "\r\n",
                 code,
+                connection,
                 headers
             );
         } else {
             gbuffer_printf(gbuf,
                 "HTTP/1.1 %s\r\n"
                 "%s"
+                "%s"
                 "Content-Type: application/json; charset=utf-8\r\n"
                 "Content-Length: %d\r\n\r\n",
                 code,
+                connection,
                 headers,
                 body_len
             );
@@ -351,6 +911,7 @@ PRIVATE int ac_send_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj sr
         GBMEM_FREE(resp)
     } else  {
         // Old method
+        json_object_del(kw, "__http_seq__");
         msg_iev_clean_metadata(kw);
 
         char *resp = json2uglystr(kw);
@@ -359,27 +920,41 @@ PRIVATE int ac_send_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj sr
         gbuf = gbuffer_create(256+len, 256+len);
         gbuffer_printf(gbuf,
             "HTTP/1.1 200 OK\r\n"
+            "%s"
             "Content-Type: application/json; charset=utf-8\r\n"
             "Content-Length: %d\r\n\r\n",
+            connection,
             len
         );
         gbuffer_append(gbuf, resp, len);
         GBMEM_FREE(resp)
     }
 
-    if(gobj_trace_level(gobj) & TRAFFIC) {
-        gobj_trace_dump_gbuf(
-            gobj,
-            gbuf,
-            "%s", gobj_short_name(gobj_bottom_gobj(gobj))
-        );
+    JSON_DECREF(jn_request)
+    KW_DECREF(kw)
+    if(!gbuf) {
+        // Error already logged
+        return -1;
+    }
+    return send_response(gobj, gbuf, jn_file, seq);
+}
+
+/***************************************************************************
+ *  All written, close the connection if it was the last response
+ ***************************************************************************/
+PRIVATE int ac_tx_ready(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->close_pending &&
+        priv->responses >= priv->rx_seq &&
+        dl_size(&priv->dl_held) == 0
+    ) {
+        gobj_send_event(gobj_bottom_gobj(gobj), EV_DROP, 0, gobj);
     }
 
-    json_t *kw_response = json_pack("{s:I}",
-        "gbuffer", (json_int_t)(uintptr_t)gbuf
-    );
     KW_DECREF(kw)
-    return gobj_send_event(gobj_bottom_gobj(gobj), EV_TX_DATA, kw_response, gobj);
+    return 0;
 }
 
 /***************************************************************************
@@ -471,10 +1046,13 @@ PRIVATE int create_gclass(gclass_name_t gclass_name)
     };
     ev_action_t st_connected[] = {
         {EV_RX_DATA,            ac_rx_data,                 0},
+        {EV_ON_HEADER,          ac_on_message,              0},
         {EV_ON_MESSAGE,         ac_on_message,              0},
         {EV_SEND_MESSAGE,       ac_send_message,            0},
+        {EV_PAUSE_RX,           ac_pause_rx,                0},
+        {EV_RESUME_RX,          ac_resume_rx,               0},
         {EV_TIMEOUT,            ac_timeout_inactivity,      0},
-        {EV_TX_READY,           0,                          0},
+        {EV_TX_READY,           ac_tx_ready,                0},
         {EV_DROP,               ac_drop,                    0},
         {EV_DISCONNECTED,       ac_disconnected,            ST_DISCONNECTED},
         {EV_STOPPED,            ac_stopped,                 0},
@@ -487,7 +1065,10 @@ PRIVATE int create_gclass(gclass_name_t gclass_name)
     };
 
     event_type_t event_types[] = { // HACK System gclass, not public events
+        {EV_ON_HEADER,          EVF_PUBLIC_EVENT|EVF_OUTPUT_EVENT},
         {EV_ON_MESSAGE,         EVF_PUBLIC_EVENT|EVF_OUTPUT_EVENT},
+        {EV_PAUSE_RX,           EVF_PUBLIC_EVENT},
+        {EV_RESUME_RX,          EVF_PUBLIC_EVENT},
         {EV_RX_DATA,            0}, // TODO is necessary to define the internal or input events?
         {EV_SEND_MESSAGE,       EVF_PUBLIC_EVENT},
         {EV_CONNECTED,          0},
@@ -9,8 +9,12 @@
  *          All Rights Reserved.
  ****************************************************************************/
 #include <string.h>
+#include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <poll.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
 
 #include <gobj.h>
 #include <g_ev_kernel.h>
@@ -67,6 +71,31 @@
 #define IS_CLI      (!empty_string(priv->url))
 #define IS_CLISRV   (priv->__clisrv__)
 
+#define TX_FILE_LABEL       "__tx_file__"   // label of the EV_TX_FILE gbuffers in the tx queue
+#define TX_FILE_TLS_CHUNK   (64*1024)       // with TLS the file is read and encrypted by chunks
+#define TX_FILE_SENDFILE_MAX (1024*1024)    // max bytes by sendfile() call
+#define TX_SHARED_LABEL     "__tx_shared__" // label of the gbuffer_iov (shared body) gbuffers in the tx queue
+
+/***************************************************************
+ *              Structures
+ ***************************************************************/
+/*
+ *  Data of the EV_TX_FILE gbuffers, followed by the path (null terminated)
+ */
+typedef struct {
+    uint64_t offset;
+    uint64_t length;
+} tx_file_t;
+
+/*
+ *  Data of the gbuffer_iov gbuffers, followed by the head bytes.
+ *  The body is shared with other connections, it's read from tx_shared_offset,
+ *  never consumed.
+ */
+typedef struct {
+    gbuffer_t *body;    // a reference
+} tx_shared_t;
+
 /***************************************************************
  *              Prototypes
  ***************************************************************/
@@ -74,6 +103,12 @@ PRIVATE void try_to_stop_yevents(hgobj gobj); // IDEMPOTENT
 PRIVATE void set_connected(hgobj gobj, int fd);
 PRIVATE void set_inactivity_timeout(hgobj gobj);
 PRIVATE void start_pending_writes(hgobj gobj);
+PRIVATE int continue_tx_file(hgobj gobj);
+PRIVATE int continue_tx_shared(hgobj gobj);
+PRIVATE void tx_gbuffer_decref(gbuffer_t *gbuf);
+PRIVATE void try_more_writes(hgobj gobj);
+PRIVATE void start_tx_poll(hgobj gobj, int fd);
+PRIVATE void start_ktls_tx(hgobj gobj);
 PRIVATE int yev_callback(yev_event_h yev_event);
 PRIVATE int ytls_on_handshake_done_callback(hgobj gobj, int error);
 PUBLIC int ytls_on_clear_data_callback(hgobj gobj, gbuffer_t *gbuf);
@@ -168,6 +203,8 @@ typedef struct _PRIVATE_DATA {
     BOOL use_ssl;
     hytls ytls;
     hsskt sskt;
+    BOOL ktls_pending;          // kTLS tx will be set when the handshake is written, hold the tx
+    BOOL ktls_tx;               // The kernel encrypts: write clear data, sendfile() the files
 
     dl_list_t dl_tx;
     gbuffer_t *gbuf_txing;
@@ -175,6 +212,15 @@ typedef struct _PRIVATE_DATA {
 
     BOOL no_tx_ready_event;
     int tx_in_progress;
+
+    BOOL rx_paused;             // EV_PAUSE_RX: don't re-arm the read until EV_RESUME_RX
+
+    int tx_file_fd;             // EV_TX_FILE being transmitted, -1 none
+    uint64_t tx_file_offset;
+    uint64_t tx_file_left;
+    yev_event_h yev_tx_poll;    // POLLOUT, continue the sendfile()/writev() when the socket is writable
+    size_t tx_shared_offset;    // bytes of the shared body already written
+    BOOL tx_written;            // gbuf_txing written at once, the next write goes from the POLLOUT
 } PRIVATE_DATA;
 
 
@@ -197,6 +243,7 @@ PRIVATE void mt_create(hgobj gobj)
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
     dl_init(&priv->dl_tx, gobj);
+    priv->tx_file_fd = -1;
 
     if(IS_CLI) {
         priv->gobj_timer = gobj_create_pure_child(gobj_name(gobj), C_TIMER, 0, gobj);
@@ -410,8 +457,13 @@ PRIVATE int mt_stop(hgobj gobj)
         EXEC_AND_RESET(ytls_cleanup, priv->ytls)
     }
 
-    GBUFFER_DECREF(priv->gbuf_txing)
-    dl_flush(&priv->dl_tx, (fnfree)gbuffer_decref);
+    EXEC_AND_RESET(tx_gbuffer_decref, priv->gbuf_txing)
+    dl_flush(&priv->dl_tx, (fnfree)tx_gbuffer_decref);
+    if(priv->tx_file_fd >= 0) {
+        close(priv->tx_file_fd);
+        priv->tx_file_fd = -1;
+    }
+    priv->tx_written = FALSE;
 
     gobj_reset_volatil_attrs(gobj);
 
@@ -432,6 +484,7 @@ PRIVATE void mt_destroy(hgobj gobj)
     EXEC_AND_RESET(yev_destroy_event, priv->yev_connect)
     EXEC_AND_RESET(yev_destroy_event, priv->yev_reading)
     EXEC_AND_RESET(yev_destroy_event, priv->yev_accept)
+    EXEC_AND_RESET(yev_destroy_event, priv->yev_tx_poll)
 }
 
 /***************************************************************************
@@ -573,6 +626,7 @@ PRIVATE void set_connected(hgobj gobj, int fd)
             gbuffer_clear(yev_get_gbuf(priv->yev_reading));
         }
 
+        priv->rx_paused = FALSE;
         yev_start_event(priv->yev_reading);
     }
 
@@ -586,6 +640,8 @@ PRIVATE void set_connected(hgobj gobj, int fd)
         gobj_change_state(gobj, ST_WAIT_HANDSHAKE);
 
         priv->inform_disconnection = FALSE;
+        priv->ktls_pending = FALSE;
+        priv->ktls_tx = FALSE;
 
         priv->sskt = ytls_new_secure_filter(
             priv->ytls,
@@ -792,11 +848,16 @@ PRIVATE void set_disconnected(hgobj gobj)
     if(priv->yev_reading) {
         yev_set_fd(priv->yev_reading, -1);
     }
+    if(priv->yev_tx_poll) {
+        yev_set_fd(priv->yev_tx_poll, -1);
+    }
 
     if(priv->sskt) {
         ytls_free_secure_filter(priv->ytls, priv->sskt);
         priv->sskt = 0;
     }
+    priv->ktls_pending = FALSE;
+    priv->ktls_tx = FALSE;
 
     gobj_write_bool_attr(gobj, "connected", FALSE);
     gobj_write_bool_attr(gobj, "secure_connected", FALSE);
@@ -815,13 +876,18 @@ PRIVATE void set_disconnected(hgobj gobj)
      *  reconnect-on-tx model (timeout_inactivity) we KEEP them and a running
      *  client flushes them via start_pending_writes() once the retry connects.
      */
-    GBUFFER_DECREF(priv->gbuf_txing)
+    EXEC_AND_RESET(tx_gbuffer_decref, priv->gbuf_txing)
+    if(priv->tx_file_fd >= 0) {
+        close(priv->tx_file_fd);
+        priv->tx_file_fd = -1;
+    }
+    priv->tx_written = FALSE;
     BOOL keep_pending_tx =
         priv->timeout_inactivity > 0 &&
         !priv->inform_disconnection &&
         gobj_is_running(gobj);
     if(!keep_pending_tx) {
-        dl_flush(&priv->dl_tx, (fnfree)gbuffer_decref);
+        dl_flush(&priv->dl_tx, (fnfree)tx_gbuffer_decref);
     }
 
     /*
@@ -923,6 +989,390 @@ PRIVATE void set_disconnected(hgobj gobj)
     }
 }
 
+/***************************************************************************
+ *  Is it a file to transmit (EV_TX_FILE)?
+ ***************************************************************************/
+PRIVATE BOOL is_tx_file(gbuffer_t *gbuf)
+{
+    const char *label = gbuffer_getlabel(gbuf);
+    return (label && strcmp(label, TX_FILE_LABEL)==0)? TRUE:FALSE;
+}
+
+/***************************************************************************
+ *  Open the file of the current EV_TX_FILE gbuffer and start to send it
+ ***************************************************************************/
+PRIVATE int start_tx_file(hgobj gobj, gbuffer_t *gbuf)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    tx_file_t *tx_file = gbuffer_head_pointer(gbuf);
+    const char *path = (const char *)(tx_file + 1);
+
+    priv->tx_file_fd = open(path, O_RDONLY|O_CLOEXEC);
+    if(priv->tx_file_fd < 0) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_SYSTEM,
+            "msg",          "%s", "Cannot open file to transmit",
+            "path",         "%s", path,
+            "errno",        "%d", errno,
+            "serrno",       "%s", strerror(errno),
+            NULL
+        );
+        /*
+         *  The peer is waiting the announced bytes, the stream is broken
+         */
+        try_to_stop_yevents(gobj);
+        return -1;
+    }
+    priv->tx_file_offset = tx_file->offset;
+    priv->tx_file_left = tx_file->length;
+    priv->txMsgs++;
+
+    return continue_tx_file(gobj);
+}
+
+/***************************************************************************
+ *  Send the next part of the file.
+ *  Without TLS, or with kTLS, the bytes go from the page cache to the socket (sendfile),
+ *  with user space TLS they are read by chunks, encrypted and written as usual.
+ ***************************************************************************/
+PRIVATE int continue_tx_file(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->sskt && !priv->ktls_tx) {
+        if(priv->tx_file_left > 0) {
+            size_t chunk = (size_t)MIN(priv->tx_file_left, TX_FILE_TLS_CHUNK);
+            gbuffer_t *gbuf = gbuffer_create(chunk, chunk);
+            if(!gbuf) {
+                // Error already logged
+                try_to_stop_yevents(gobj);
+                return -1;
+            }
+            ssize_t n = pread(
+                priv->tx_file_fd,
+                gbuffer_cur_wr_pointer(gbuf),
+                chunk,
+                (off_t)priv->tx_file_offset
+            );
+            if(n <= 0) {
+                gobj_log_error(gobj, 0,
+                    "function",     "%s", __FUNCTION__,
+                    "msgset",       "%s", MSGSET_SYSTEM,
+                    "msg",          "%s", "read of file to transmit FAILED",
+                    "left",         "%lu", (unsigned long)priv->tx_file_left,
+                    "errno",        "%d", n<0? errno:0,
+                    "serrno",       "%s", n<0? strerror(errno):"file truncated",
+                    NULL
+                );
+                GBUFFER_DECREF(gbuf)
+                try_to_stop_yevents(gobj);
+                return -1;
+            }
+            gbuffer_set_wr(gbuf, (size_t)n);
+            priv->tx_file_offset += (uint64_t)n;
+            priv->tx_file_left -= (uint64_t)n;
+
+            /*
+             *  The next chunk is read when this one has been written (try_more_writes)
+             */
+            if(ytls_encrypt_data(priv->ytls, priv->sskt, gbuf)<0) {
+                gobj_log_error(gobj, 0,
+                    "function",     "%s", __FUNCTION__,
+                    "msgset",       "%s", MSGSET_SYSTEM,
+                    "msg",          "%s", "ytls_encrypt_data() FAILED",
+                    "error",        "%s", ytls_get_last_error(priv->ytls, priv->sskt),
+                    NULL
+                );
+                try_to_stop_yevents(gobj);
+                return -1;
+            }
+            return 0;
+        }
+
+    } else {
+        int fd = priv->__clisrv__? priv->fd_clisrv:yev_get_fd(priv->yev_connect);
+
+        while(priv->tx_file_left > 0) {
+            off_t offset = (off_t)priv->tx_file_offset;
+            ssize_t n = sendfile(
+                fd,
+                priv->tx_file_fd,
+                &offset,
+                (size_t)MIN(priv->tx_file_left, TX_FILE_SENDFILE_MAX)
+            );
+            if(n > 0) {
+                priv->txBytes += (json_int_t)n;
+                priv->tx_file_offset += (uint64_t)n;
+                priv->tx_file_left -= (uint64_t)n;
+                continue;
+            }
+            if(n < 0 && errno == EINTR) {
+                continue;
+            }
+            if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                /*
+                 *  Socket buffer full, continue when it's writable
+                 */
+                start_tx_poll(gobj, fd);
+                set_inactivity_timeout(gobj); // tx activity: reset timer
+                return 0;
+            }
+
+            gobj_log_set_last_message("%s", n<0? strerror(errno):"file truncated");
+            if(gobj_trace_level(gobj) & TRACE_URING) {
+                gobj_log_debug(gobj, 0,
+                    "function",     "%s", __FUNCTION__,
+                    "msgset",       "%s", MSGSET_CONNECT_DISCONNECT,
+                    "msg",          "%s", "TCP: sendfile FAILED",
+                    "msg2",         "%s", "🌐TCP: sendfile FAILED",
+                    "remote-addr",  "%s", gobj_read_str_attr(gobj, "peername"),
+                    "local-addr",   "%s", gobj_read_str_attr(gobj, "sockname"),
+                    "errno",        "%d", n<0? errno:0,
+                    "strerror",     "%s", n<0? strerror(errno):"file truncated",
+                    "left",         "%lu", (unsigned long)priv->tx_file_left,
+                    NULL
+                );
+            }
+            try_to_stop_yevents(gobj);
+            return -1;
+        }
+        set_inactivity_timeout(gobj); // tx activity: reset timer
+    }
+
+    /*
+     *  File transmitted
+     */
+    close(priv->tx_file_fd);
+    priv->tx_file_fd = -1;
+    if(priv->sskt && !priv->ktls_tx) {
+        // Here from the completion of the last chunk write, already in the loop
+        try_more_writes(gobj);
+    } else {
+        priv->tx_written = TRUE;
+        start_tx_poll(gobj, priv->__clisrv__? priv->fd_clisrv:yev_get_fd(priv->yev_connect));
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Is it a head with a shared body (gbuffer_iov payload)?
+ ***************************************************************************/
+PRIVATE BOOL is_tx_shared(gbuffer_t *gbuf)
+{
+    const char *label = gbuffer_getlabel(gbuf);
+    return (label && strcmp(label, TX_SHARED_LABEL)==0)? TRUE:FALSE;
+}
+
+/***************************************************************************
+ *  Release a gbuffer of the tx queue, with the shared body if any
+ ***************************************************************************/
+PRIVATE void tx_gbuffer_decref(gbuffer_t *gbuf)
+{
+    if(gbuf && gbuf->refcount == 1 && is_tx_shared(gbuf)) {
+        tx_shared_t *tx_shared = gbuffer_head_pointer(gbuf);
+        GBUFFER_DECREF(tx_shared->body)
+    }
+    gbuffer_decref(gbuf);
+}
+
+/***************************************************************************
+ *  Build the tx queue gbuffer of a gbuffer_iov payload:
+ *  the head is copied (it's small), the body is referenced.
+ ***************************************************************************/
+PRIVATE gbuffer_t *create_tx_shared(gbuffer_iov_t *iov)
+{
+    size_t head_len = iov->head? gbuffer_leftbytes(iov->head):0;
+    gbuffer_t *gbuf = gbuffer_create(sizeof(tx_shared_t) + head_len, sizeof(tx_shared_t) + head_len);
+    if(!gbuf) {
+        // Error already logged
+        return NULL;
+    }
+    tx_shared_t tx_shared = {
+        .body = iov->body? gbuffer_incref(iov->body):NULL
+    };
+    gbuffer_append(gbuf, &tx_shared, sizeof(tx_shared));
+    if(head_len) {
+        gbuffer_append(gbuf, gbuffer_cur_rd_pointer(iov->head), head_len);
+    }
+    gbuffer_get(gbuf, sizeof(tx_shared));  // the read pointer at the head bytes
+    gbuffer_setlabel(gbuf, TX_SHARED_LABEL);
+    return gbuf;
+}
+
+/***************************************************************************
+ *  Start to send the head and the shared body of the current gbuffer.
+ *  With user space TLS the bytes are encrypted in a new buffer anyway,
+ *  they are joined and written as usual.
+ ***************************************************************************/
+PRIVATE int start_tx_shared(hgobj gobj, gbuffer_t *gbuf)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    tx_shared_t *tx_shared = gbuffer_head_pointer(gbuf);
+    gbuffer_t *body = tx_shared->body;
+
+    uint32_t trace_level = gobj_trace_level(gobj);
+    if(trace_level & TRACE_TRAFFIC) {
+        gobj_trace_dump_gbuf(gobj, gbuf, "%s: %s%s%s (head)",
+            gobj_short_name(gobj),
+            gobj_read_str_attr(gobj, "sockname"),
+            " ⏩ ",
+            gobj_read_str_attr(gobj, "peername")
+        );
+        if(body) {
+            gobj_trace_dump_gbuf(gobj, body, "%s: %s%s%s (shared body)",
+                gobj_short_name(gobj),
+                gobj_read_str_attr(gobj, "sockname"),
+                " ⏩ ",
+                gobj_read_str_attr(gobj, "peername")
+            );
+        }
+    }
+
+    priv->tx_shared_offset = 0;
+
+    if(priv->sskt && !priv->ktls_tx) {
+        size_t head_len = gbuffer_leftbytes(gbuf);
+        size_t body_len = body? gbuffer_leftbytes(body):0;
+        gbuffer_t *gbuf_flat = gbuffer_create(head_len + body_len, head_len + body_len);
+        if(!gbuf_flat) {
+            // Error already logged
+            try_to_stop_yevents(gobj);
+            return -1;
+        }
+        gbuffer_append(gbuf_flat, gbuffer_cur_rd_pointer(gbuf), head_len);
+        if(body_len) {
+            gbuffer_append(gbuf_flat, gbuffer_cur_rd_pointer(body), body_len);
+        }
+        if(ytls_encrypt_data(priv->ytls, priv->sskt, gbuf_flat)<0) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_SYSTEM,
+                "msg",          "%s", "ytls_encrypt_data() FAILED",
+                "error",        "%s", ytls_get_last_error(priv->ytls, priv->sskt),
+                NULL
+            );
+            try_to_stop_yevents(gobj);
+            return -1;
+        }
+        return 0;
+    }
+
+    priv->txMsgs++;
+    return continue_tx_shared(gobj);
+}
+
+/***************************************************************************
+ *  Write the rest of head and shared body with writev(),
+ *  without TLS or with kTLS (the kernel encrypts).
+ ***************************************************************************/
+PRIVATE int continue_tx_shared(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gbuffer_t *gbuf = priv->gbuf_txing;
+    tx_shared_t *tx_shared = gbuffer_head_pointer(gbuf);
+    gbuffer_t *body = tx_shared->body;
+    int fd = priv->__clisrv__? priv->fd_clisrv:yev_get_fd(priv->yev_connect);
+
+    while(1) {
+        struct iovec iov[2];
+        int iovcnt = 0;
+
+        size_t head_left = gbuffer_leftbytes(gbuf);
+        if(head_left > 0) {
+            iov[iovcnt].iov_base = gbuffer_cur_rd_pointer(gbuf);
+            iov[iovcnt].iov_len = head_left;
+            iovcnt++;
+        }
+        size_t body_left = body? gbuffer_leftbytes(body) - priv->tx_shared_offset:0;
+        if(body_left > 0) {
+            iov[iovcnt].iov_base = (char *)gbuffer_cur_rd_pointer(body) + priv->tx_shared_offset;
+            iov[iovcnt].iov_len = body_left;
+            iovcnt++;
+        }
+        if(iovcnt == 0) {
+            break;
+        }
+
+        ssize_t n = writev(fd, iov, iovcnt);
+        if(n > 0) {
+            priv->txBytes += (json_int_t)n;
+            size_t from_head = MIN((size_t)n, head_left);
+            if(from_head > 0) {
+                gbuffer_get(gbuf, from_head);
+            }
+            priv->tx_shared_offset += (size_t)n - from_head;
+            continue;
+        }
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            /*
+             *  Socket buffer full, continue when it's writable
+             */
+            start_tx_poll(gobj, fd);
+            set_inactivity_timeout(gobj); // tx activity: reset timer
+            return 0;
+        }
+
+        gobj_log_set_last_message("%s", n<0? strerror(errno):"writev() returns 0");
+        if(gobj_trace_level(gobj) & TRACE_URING) {
+            gobj_log_debug(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_CONNECT_DISCONNECT,
+                "msg",          "%s", "TCP: writev FAILED",
+                "msg2",         "%s", "🌐TCP: writev FAILED",
+                "remote-addr",  "%s", gobj_read_str_attr(gobj, "peername"),
+                "local-addr",   "%s", gobj_read_str_attr(gobj, "sockname"),
+                "errno",        "%d", n<0? errno:0,
+                "strerror",     "%s", n<0? strerror(errno):"",
+                NULL
+            );
+        }
+        try_to_stop_yevents(gobj);
+        return -1;
+    }
+    set_inactivity_timeout(gobj); // tx activity: reset timer
+
+    /*
+     *  Head and body transmitted.
+     *  Don't call try_more_writes() here, we can be inside the EV_TX_DATA of the caller:
+     *  a queue of shared payloads would nest write_data() calls, one per message,
+     *  and EV_TX_READY would be published re-entrantly.
+     *  The next write goes from the loop, the POLLOUT is ready at once.
+     */
+    priv->tx_shared_offset = 0;
+    priv->tx_written = TRUE;
+    start_tx_poll(gobj, fd);
+    return 0;
+}
+
+/***************************************************************************
+ *  Wait for the socket writable (yev_tx_poll), the tx continues in yev_callback
+ ***************************************************************************/
+PRIVATE void start_tx_poll(hgobj gobj, int fd)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(!priv->yev_tx_poll) {
+        priv->yev_tx_poll = yev_create_poll_event(
+            yuno_event_loop(),
+            yev_callback,
+            gobj,
+            fd,
+            POLLOUT
+        );
+    } else {
+        yev_set_fd(priv->yev_tx_poll, fd);
+    }
+    priv->tx_in_progress++;
+    yev_start_event(priv->yev_tx_poll);
+}
+
 /***************************************************************************
  *  Write the current gbuffer
  ***************************************************************************/
@@ -932,6 +1382,20 @@ PRIVATE int write_data(hgobj gobj)
 
     gbuffer_t *gbuf = priv->gbuf_txing;
 
+    if(priv->ktls_pending) {
+        /*
+         *  Held until the kernel has the tx keys (start_ktls_tx)
+         */
+        return 0;
+    }
+
+    if(is_tx_file(gbuf)) {
+        return start_tx_file(gobj, gbuf);
+    }
+    if(is_tx_shared(gbuf)) {
+        return start_tx_shared(gobj, gbuf);
+    }
+
     uint32_t trace_level = gobj_trace_level(gobj);
     if(trace_level & TRACE_TRAFFIC) {
         gobj_trace_dump_gbuf(gobj, gbuf, "%s: %s%s%s",
@@ -942,7 +1406,7 @@ PRIVATE int write_data(hgobj gobj)
         );
     }
 
-    if(priv->sskt) {
+    if(priv->sskt && !priv->ktls_tx) {
         GBUFFER_INCREF(gbuf)
         if(ytls_encrypt_data(priv->ytls, priv->sskt, gbuf)<0) {
             gobj_log_error(gobj, 0,
@@ -990,10 +1454,20 @@ PRIVATE void try_more_writes(hgobj gobj)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
+    if(priv->tx_file_fd >= 0) {
+        /*
+         *  A file is being transmitted (TLS), next chunk when all the previous are written
+         */
+        if(priv->tx_in_progress == 0) {
+            continue_tx_file(gobj);
+        }
+        return;
+    }
+
     /*
      *  Clear the current tx msg
      */
-    GBUFFER_DECREF(priv->gbuf_txing)
+    EXEC_AND_RESET(tx_gbuffer_decref, priv->gbuf_txing)
 
     /*
      *  Get the next tx msg
@@ -1036,7 +1510,7 @@ PRIVATE int enqueue_write(hgobj gobj, gbuffer_t *gbuf)
          counter++;
          gbuffer_t *gbuf_first = dl_first(&priv->dl_tx);
          dl_delete(&priv->dl_tx, gbuf_first, 0);
-         gbuffer_decref(gbuf_first);
+         tx_gbuffer_decref(gbuf_first);
      }
 
     dl_add(&priv->dl_tx, gbuf);
@@ -1118,6 +1592,15 @@ PRIVATE void try_to_stop_yevents(hgobj gobj)  // IDEMPOTENT
         }
     }
 
+    if(priv->yev_tx_poll) {
+        if(!yev_event_is_stopped(priv->yev_tx_poll)) {
+            yev_stop_event(priv->yev_tx_poll);
+            if(!yev_event_is_stopped(priv->yev_tx_poll)) {
+                to_wait_stopped = TRUE;
+            }
+        }
+    }
+
     if(priv->tx_in_progress > 0) {
         to_wait_stopped = TRUE;
     }
@@ -1236,12 +1719,51 @@ PRIVATE int ytls_on_handshake_done_callback(hgobj gobj, int error)
          *  Don't stop here, will be stopped in return of ytls_decrypt_data()
          */
     } else {
+        PRIVATE_DATA *priv = gobj_priv_data(gobj);
+        if(ytls_ktls_tx_capable(priv->ytls, priv->sskt)) {
+            /*
+             *  kTLS: the tx record sequence must start in the kernel just after
+             *  the handshake records, the tx is held until they are written.
+             */
+            priv->ktls_pending = TRUE;
+            if(priv->tx_in_progress == 0) {
+                start_ktls_tx(gobj);
+            }
+        }
         set_secure_connected(gobj);
     }
 
     return 0;
 }
 
+/***************************************************************************
+ *  Offload the tx encryption to the kernel and release the held tx
+ ***************************************************************************/
+PRIVATE void start_ktls_tx(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->ktls_pending = FALSE;
+
+    int fd = priv->__clisrv__? priv->fd_clisrv:yev_get_fd(priv->yev_connect);
+    if(ytls_enable_ktls_tx(priv->ytls, priv->sskt, fd) > 0) {
+        priv->ktls_tx = TRUE;
+        if(gobj_trace_level(gobj) & TRACE_CONNECT_DISCONNECT) {
+            gobj_log_info(gobj, 0,
+                "msgset",       "%s", MSGSET_CONNECT_DISCONNECT,
+                "msg",          "%s", "kTLS tx enabled",
+                "peername",     "%s", gobj_read_str_attr(gobj, "peername"),
+                "sockname",     "%s", gobj_read_str_attr(gobj, "sockname"),
+                NULL
+            );
+        }
+    }
+
+    if(priv->gbuf_txing) {
+        write_data(gobj);
+    }
+}
+
 /***************************************************************************
  *  YTLS callbacks, called when receiving data has been decrypted
  ***************************************************************************/
@@ -1254,10 +1776,12 @@ PUBLIC int ytls_on_clear_data_callback(hgobj gobj, gbuffer_t *gbuf)
         gobj_trace_dump_gbuf(gobj, gbuf, "decrypted data");
     }
 
-    json_t *kw = json_pack("{s:I}",
-        "gbuffer", (json_int_t)(uintptr_t)gbuf
+    return gobj_publish_event_payload(
+        gobj,
+        EV_RX_DATA,
+        0,
+        gobj_payload_create_gbuffer(gbuf)
     );
-    return gobj_publish_event(gobj, EV_RX_DATA, kw);
 }
 
 /***************************************************************************
@@ -1359,10 +1883,12 @@ PRIVATE int yev_callback(yev_event_h yev_event)
 
                     } else {
                         GBUFFER_INCREF(gbuf)
-                        json_t *kw = json_pack("{s:I}",
-                            "gbuffer", (json_int_t)(uintptr_t)gbuf
+                        ret = gobj_publish_event_payload(
+                            gobj,
+                            EV_RX_DATA,
+                            0,
+                            gobj_payload_create_gbuffer(gbuf)
                         );
-                        ret = gobj_publish_event(gobj, EV_RX_DATA, kw);
                     }
 
                     /*
@@ -1372,11 +1898,14 @@ PRIVATE int yev_callback(yev_event_h yev_event)
                      *      or order to disconnect (EV_DROP)
                      *  If try_to_stop_yevents() has been called (mt_stop, EV_DROP,...)
                      *      this event will be in stopped state.
-                     *  If it's in idle then re-arm
+                     *  If it's in idle then re-arm, unless the upper layer
+                     *  has paused the reception (EV_PAUSE_RX), then EV_RESUME_RX re-arms.
                      */
                     if(ret == 0 && yev_event_is_idle(yev_event)) {
                         gbuffer_clear(gbuf);
-                        yev_start_event(yev_event);
+                        if(!priv->rx_paused) {
+                            yev_start_event(yev_event);
+                        }
                     }
 
                 } else {
@@ -1436,7 +1965,13 @@ PRIVATE int yev_callback(yev_event_h yev_event)
                         }
 
                         yev_destroy_event(yev_event);
-                        if(gobj_in_this_state(gobj, ST_CONNECTED)) {
+                        if(priv->ktls_pending) {
+                            if(priv->tx_in_progress == 0 &&
+                                    gobj_in_this_state(gobj, ST_CONNECTED)) {
+                                // The handshake is written, give the tx keys to the kernel
+                                start_ktls_tx(gobj);
+                            }
+                        } else if(gobj_in_this_state(gobj, ST_CONNECTED)) {
                             // Avoid while doing handshaking
                             try_more_writes(gobj);
                         } else if(gobj_in_this_state(gobj, ST_WAIT_STOPPED)) {
@@ -1557,6 +2092,30 @@ PRIVATE int yev_callback(yev_event_h yev_event)
             break;
 
         case YEV_POLL_TYPE:
+            if(yev_event == priv->yev_tx_poll) {
+                /*
+                 *  Socket writable again, continue the file or shared body transmission,
+                 *  or go with the next write if the current one was written at once.
+                 */
+                priv->tx_in_progress--;
+                if(yev_state == YEV_ST_IDLE &&
+                        gobj_in_this_state(gobj, ST_CONNECTED) &&
+                        priv->tx_written) {
+                    priv->tx_written = FALSE;
+                    try_more_writes(gobj);
+                } else if(yev_state == YEV_ST_IDLE &&
+                        gobj_in_this_state(gobj, ST_CONNECTED) &&
+                        priv->tx_file_fd >= 0) {
+                    continue_tx_file(gobj);
+                } else if(yev_state == YEV_ST_IDLE &&
+                        gobj_in_this_state(gobj, ST_CONNECTED) &&
+                        priv->gbuf_txing && is_tx_shared(priv->gbuf_txing)) {
+                    continue_tx_shared(gobj);
+                } else {
+                    try_to_stop_yevents(gobj);
+                }
+                break;
+            }
             {
                 /*
                  *  Disconnected
@@ -1699,6 +2258,21 @@ PRIVATE int ac_connect(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
     return 0;
 }
 
+/***************************************************************************
+ *  The gbuffer to queue of EV_TX_DATA, yours.
+ *  From kw "gbuffer" or a gbuffer payload, or from a gbuffer_iov payload
+ *  (head + body shared with other connections: the body is not copied).
+ ***************************************************************************/
+PRIVATE gbuffer_t *get_tx_gbuffer(hgobj gobj, json_t *kw)
+{
+    gbuffer_iov_t *iov = gobj_payload_ptr(gobj_event_payload(), gobj_payload_type_gbuffer_iov());
+    if(iov) {
+        return create_tx_shared(iov);
+    }
+    gbuffer_t *gbuf = gobj_event_gbuffer(gobj, kw);
+    return gbuf? gbuffer_incref(gbuf):NULL;
+}
+
 /***************************************************************************
  *  Sending data, if using TLS will be encrypted, else sent as is
  ***************************************************************************/
@@ -1706,7 +2280,7 @@ PRIVATE int ac_tx_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    gbuffer_t *gbuf = (gbuffer_t *)(uintptr_t)kw_get_int(gobj, kw, "gbuffer", 0, 0);
+    gbuffer_t *gbuf = get_tx_gbuffer(gobj, kw);
     if(!gbuf) {
         gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
             "function",     "%s", __FUNCTION__,
@@ -1719,10 +2293,65 @@ PRIVATE int ac_tx_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
     }
 
     if(!priv->gbuf_txing) {
-        priv->gbuf_txing = gbuffer_incref(gbuf);
+        priv->gbuf_txing = gbuf;
         write_data(gobj);
     } else {
-        enqueue_write(gobj, gbuffer_incref(gbuf));
+        enqueue_write(gobj, gbuf);
+    }
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Send a file, or a range of it, after the data already queued.
+ *  The file is opened when its turn arrives.
+ ***************************************************************************/
+PRIVATE int ac_tx_file(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    const char *path = kw_get_str(gobj, kw, "path", "", KW_REQUIRED);
+    json_int_t offset = kw_get_int(gobj, kw, "offset", 0, 0);
+    json_int_t length = kw_get_int(gobj, kw, "length", -1, KW_REQUIRED);
+    if(empty_string(path) || offset < 0 || length < 0) {
+        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "tx file with bad parameters",
+            "path",         "%s", path,
+            "offset",       "%ld", (long)offset,
+            "length",       "%ld", (long)length,
+            NULL
+        );
+        KW_DECREF(kw)
+        return -1;
+    }
+    if(length == 0) {
+        KW_DECREF(kw)
+        return 0;
+    }
+
+    size_t path_len = strlen(path) + 1;
+    gbuffer_t *gbuf = gbuffer_create(sizeof(tx_file_t) + path_len, sizeof(tx_file_t) + path_len);
+    if(!gbuf) {
+        // Error already logged
+        KW_DECREF(kw)
+        return -1;
+    }
+    tx_file_t tx_file = {
+        .offset = (uint64_t)offset,
+        .length = (uint64_t)length
+    };
+    gbuffer_append(gbuf, &tx_file, sizeof(tx_file));
+    gbuffer_append(gbuf, (void *)path, path_len);
+    gbuffer_setlabel(gbuf, TX_FILE_LABEL);
+
+    if(!priv->gbuf_txing) {
+        priv->gbuf_txing = gbuf;
+        write_data(gobj);
+    } else {
+        enqueue_write(gobj, gbuf);
     }
 
     KW_DECREF(kw)
@@ -1768,6 +2397,44 @@ PRIVATE int ac_drop(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
     return 0;
 }
 
+/***************************************************************************
+ *  Flow control: stop reading the socket, the data already received is
+ *  delivered, the next read is not re-armed until EV_RESUME_RX.
+ *  The kernel socket buffer fills and TCP closes the window to the peer.
+ ***************************************************************************/
+PRIVATE int ac_pause_rx(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->rx_paused = TRUE;
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Flow control: re-arm the read if it was left stopped by EV_PAUSE_RX
+ ***************************************************************************/
+PRIVATE int ac_resume_rx(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->rx_paused) {
+        priv->rx_paused = FALSE;
+        /*
+         *  If the read is still in flight there is nothing to do,
+         *  yev_callback() will re-arm it.
+         */
+        if(priv->yev_reading && yev_event_is_idle(priv->yev_reading)) {
+            gbuffer_clear(yev_get_gbuf(priv->yev_reading));
+            yev_start_event(priv->yev_reading);
+        }
+    }
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
 /***************************************************************************
  *  Inactivity timeout expired while connected: close the connection.
  *  The client reconnects on demand when new tx data arrives
@@ -1799,7 +2466,7 @@ PRIVATE int ac_tx_data_disconnected(hgobj gobj, gobj_event_t event, json_t *kw,
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    gbuffer_t *gbuf = (gbuffer_t *)(uintptr_t)kw_get_int(gobj, kw, "gbuffer", 0, 0);
+    gbuffer_t *gbuf = get_tx_gbuffer(gobj, kw);
     if(!gbuf) {
         gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
             "function",     "%s", __FUNCTION__,
@@ -1812,7 +2479,7 @@ PRIVATE int ac_tx_data_disconnected(hgobj gobj, gobj_event_t event, json_t *kw,
     }
 
     if(priv->timeout_inactivity > 0) {
-        enqueue_write(gobj, gbuffer_incref(gbuf));
+        enqueue_write(gobj, gbuf);
         clear_timeout(priv->gobj_timer);
         gobj_send_event(gobj, EV_CONNECT, 0, gobj);
     } else {
@@ -1826,6 +2493,7 @@ PRIVATE int ac_tx_data_disconnected(hgobj gobj, gobj_event_t event, json_t *kw,
             "msg",          "%s", "tcp tx data while disconnected, dropped",
             NULL
         );
+        tx_gbuffer_decref(gbuf);
     }
 
     KW_DECREF(kw)
@@ -1840,7 +2508,7 @@ PRIVATE int ac_tx_data_queued(hgobj gobj, gobj_event_t event, json_t *kw, hgobj
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    gbuffer_t *gbuf = (gbuffer_t *)(uintptr_t)kw_get_int(gobj, kw, "gbuffer", 0, 0);
+    gbuffer_t *gbuf = get_tx_gbuffer(gobj, kw);
     if(!gbuf) {
         gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
             "function",     "%s", __FUNCTION__,
@@ -1853,7 +2521,7 @@ PRIVATE int ac_tx_data_queued(hgobj gobj, gobj_event_t event, json_t *kw, hgobj
     }
 
     if(priv->timeout_inactivity > 0) {
-        enqueue_write(gobj, gbuffer_incref(gbuf));
+        enqueue_write(gobj, gbuf);
     } else {
         /*
          *  No inactivity model: not expected here, drop it (logged, not silent).
@@ -1864,6 +2532,7 @@ PRIVATE int ac_tx_data_queued(hgobj gobj, gobj_event_t event, json_t *kw, hgobj
             "msg",          "%s", "tcp tx data while connecting, dropped",
             NULL
         );
+        tx_gbuffer_decref(gbuf);
     }
 
     KW_DECREF(kw)
@@ -1978,14 +2647,19 @@ PRIVATE int create_gclass(gclass_name_t gclass_name)
     ev_action_t st_wait_handshake[] = {
         {EV_SEND_ENCRYPTED_DATA,    ac_send_encrypted_data,     0},
         {EV_TX_DATA,                ac_tx_data_queued,          0},
+        {EV_PAUSE_RX,               ac_pause_rx,                0},
+        {EV_RESUME_RX,              ac_resume_rx,               0},
         {EV_DROP,                   ac_drop,                    0},
         {0,0,0}
     };
 
     ev_action_t st_connected[] = {
         {EV_TX_DATA,                ac_tx_data,                 0},
+        {EV_TX_FILE,                ac_tx_file,                 0},
         {EV_SEND_ENCRYPTED_DATA,    ac_send_encrypted_data,     0},
         {EV_TIMEOUT,                ac_timeout_inactivity,      0},
+        {EV_PAUSE_RX,               ac_pause_rx,                0},
+        {EV_RESUME_RX,              ac_resume_rx,               0},
         {EV_DROP,                   ac_drop,                    0},
         {0,0,0}
     };
@@ -2004,7 +2678,8 @@ PRIVATE int create_gclass(gclass_name_t gclass_name)
 
     event_type_t event_types[] = {
         {EV_RX_DATA,            EVF_OUTPUT_EVENT},
-        {EV_TX_DATA,            0},
+        {EV_TX_DATA,            EVF_PAYLOAD},
+        {EV_TX_FILE,            0},
         {EV_SEND_ENCRYPTED_DATA,0},
         {EV_TX_READY,           EVF_OUTPUT_EVENT},
         {EV_CONNECT,            0},
@@ -2012,6 +2687,8 @@ PRIVATE int create_gclass(gclass_name_t gclass_name)
         {EV_DISCONNECTED,       EVF_OUTPUT_EVENT},
         {EV_STOPPED,            EVF_OUTPUT_EVENT},
         {EV_TIMEOUT,            0},
+        {EV_PAUSE_RX,           0},
+        {EV_RESUME_RX,          0},
         {EV_DROP,               0},
         {0, 0}
     };
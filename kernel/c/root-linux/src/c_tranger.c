@@ -345,6 +345,7 @@ SDATA (DTP_INTEGER,     "xpermission",      SDF_RD,             "02770",
 SDATA (DTP_INTEGER,     "rpermission",      SDF_RD,             "0660",         "Use in creation, default 0660"),
 SDATA (DTP_INTEGER,     "on_critical_error",SDF_RD,             "2",            "exit on error (Zero to avoid restart)"),
 SDATA (DTP_BOOLEAN,     "master",           SDF_RD,             "0",            "the master is the only that can write"),
+SDATA (DTP_BOOLEAN,     "sync_contents",    SDF_RD,             "0",            "fdatasync() the contents of the batch appends before their metadata"),
 SDATA (DTP_POINTER,     "user_data",        0,                  0,              "user data"),
 SDATA (DTP_POINTER,     "user_data2",       0,                  0,              "more user data"),
 SDATA (DTP_POINTER,     "subscriber",       0,                  0,              "subscriber of output-events. Not a child gobj."),
@@ -447,14 +448,15 @@ PRIVATE void mt_create(hgobj gobj)
     /*
      *  HACK low level service: tranger must be here in create method instead of mt_start.
      */
-    json_t *jn_tranger = json_pack("{s:s, s:s, s:s, s:i, s:i, s:i, s:b}",
+    json_t *jn_tranger = json_pack("{s:s, s:s, s:s, s:i, s:i, s:i, s:b, s:b}",
         "path", gobj_read_str_attr(gobj, "path"),
         "database", gobj_read_str_attr(gobj, "database"),
         "filename_mask", gobj_read_str_attr(gobj, "filename_mask"),
         "xpermission", (int)gobj_read_integer_attr(gobj, "xpermission"),
         "rpermission", (int)gobj_read_integer_attr(gobj, "rpermission"),
         "on_critical_error", (int)gobj_read_integer_attr(gobj, "on_critical_error"),
-        "master", gobj_read_bool_attr(gobj, "master")
+        "master", gobj_read_bool_attr(gobj, "master"),
+        "sync_contents", gobj_read_bool_attr(gobj, "sync_contents")
     );
 
     priv->tranger = tranger2_startup(
@@ -74,6 +74,7 @@ SDATA (DTP_BOOLEAN,     "exitOnError",      SDF_RD,  "1", "Exit if Listen failed
 SDATA (DTP_BOOLEAN,     "set_broadcast",    SDF_WR|SDF_PERSIST, 0, "Set udp broadcast"),
 SDATA (DTP_BOOLEAN,     "shared",           SDF_WR|SDF_PERSIST, 0, "Share the port"),
 SDATA (DTP_INTEGER,     "rx_buffer_size",   SDF_WR|SDF_PERSIST, "4096", "Rx buffer size"),
+SDATA (DTP_INTEGER,     "rx_events",        SDF_RD,  "1", "Outstanding recvmsg events (1..64): with more than one, a burst of datagrams is received in one loop cycle"),
 
 SDATA (DTP_INTEGER,     "txBytes",          SDF_RSTATS,     "0", "Messages transmitted"),
 SDATA (DTP_INTEGER,     "rxBytes",          SDF_RSTATS,     "0", "Messages received"),
@@ -103,6 +104,7 @@ PRIVATE const trace_level_t s_user_trace_level[16] = {
  *              Private data
  *---------------------------------------------*/
 #define BFINPUT_SIZE (2*1024)
+#define MAX_RX_EVENTS 64
 
 typedef struct _PRIVATE_DATA {
     // Conf
@@ -110,7 +112,8 @@ typedef struct _PRIVATE_DATA {
     BOOL exitOnError;
 
     yev_event_h yev_server_udp;
-    yev_event_h yev_reading;
+    yev_event_h yev_reading[MAX_RX_EVENTS];
+    int rx_events;
     hytls ytls;
     hsskt sskt;
     BOOL use_ssl;
@@ -157,6 +160,13 @@ PRIVATE void mt_create(hgobj gobj)
     SET_PRIV(exitOnError,       gobj_read_bool_attr)
     SET_PRIV(trace_tls,         gobj_read_bool_attr)
 
+    priv->rx_events = (int)gobj_read_integer_attr(gobj, "rx_events");
+    if(priv->rx_events < 1) {
+        priv->rx_events = 1;
+    } else if(priv->rx_events > MAX_RX_EVENTS) {
+        priv->rx_events = MAX_RX_EVENTS;
+    }
+
     /*
      *  CHILD subscription model
      */
@@ -203,7 +213,9 @@ PRIVATE void mt_destroy(hgobj gobj)
     }
 
     EXEC_AND_RESET(yev_destroy_event, priv->yev_server_udp)
-    EXEC_AND_RESET(yev_destroy_event, priv->yev_reading)
+    for(int i=0; i<MAX_RX_EVENTS; i++) {
+        EXEC_AND_RESET(yev_destroy_event, priv->yev_reading[i])
+    }
 
     GBUFFER_DECREF(priv->gbuf_txing);
     dl_flush(&priv->dl_tx, (fnfree)gbuffer_decref);
@@ -355,28 +367,32 @@ PRIVATE int mt_start(hgobj gobj)
     );
 
     /*-------------------------------*
-     *      Setup reading event
+     *      Setup reading events
+     *  With rx_events > 1 several recvmsg are outstanding on the socket,
+     *  a burst of datagrams completes them in the same loop cycle,
+     *  instead of one datagram per round trip to the kernel.
      *-------------------------------*/
-    if(!priv->yev_reading) {
-        json_int_t rx_buffer_size = gobj_read_integer_attr(gobj, "rx_buffer_size");
-        priv->yev_reading = yev_create_recvmsg_event(
-            yuno_event_loop(),
-            yev_callback,
-            gobj,
-            yev_get_fd(priv->yev_server_udp),
-            gbuffer_create(rx_buffer_size, rx_buffer_size)
-        );
-    }
-
-    if(priv->yev_reading) {
-        if(!yev_get_gbuf(priv->yev_reading)) {
-            json_int_t rx_buffer_size = gobj_read_integer_attr(gobj, "rx_buffer_size");
-            yev_set_gbuffer(priv->yev_reading, gbuffer_create(rx_buffer_size, rx_buffer_size));
-        } else {
-            gbuffer_clear(yev_get_gbuf(priv->yev_reading));
+    json_int_t rx_buffer_size = gobj_read_integer_attr(gobj, "rx_buffer_size");
+    for(int i=0; i<priv->rx_events; i++) {
+        if(!priv->yev_reading[i]) {
+            priv->yev_reading[i] = yev_create_recvmsg_event(
+                yuno_event_loop(),
+                yev_callback,
+                gobj,
+                yev_get_fd(priv->yev_server_udp),
+                gbuffer_create(rx_buffer_size, rx_buffer_size)
+            );
         }
 
-        yev_start_event(priv->yev_reading);
+        if(priv->yev_reading[i]) {
+            if(!yev_get_gbuf(priv->yev_reading[i])) {
+                yev_set_gbuffer(priv->yev_reading[i], gbuffer_create(rx_buffer_size, rx_buffer_size));
+            } else {
+                gbuffer_clear(yev_get_gbuf(priv->yev_reading[i]));
+            }
+
+            yev_start_event(priv->yev_reading[i]);
+        }
     }
 
     gobj_change_state(gobj, ST_IDLE);
@@ -733,11 +749,13 @@ PRIVATE void try_to_stop_yevents(hgobj gobj)  // IDEMPOTENT
         }
     }
 
-    if(priv->yev_reading) {
-        if(!yev_event_is_stopped(priv->yev_reading)) {
-            yev_stop_event(priv->yev_reading);
-            if(!yev_event_is_stopped(priv->yev_reading)) {
-                to_wait_stopped = TRUE;
+    for(int i=0; i<MAX_RX_EVENTS; i++) {
+        if(priv->yev_reading[i]) {
+            if(!yev_event_is_stopped(priv->yev_reading[i])) {
+                yev_stop_event(priv->yev_reading[i]);
+                if(!yev_event_is_stopped(priv->yev_reading[i])) {
+                    to_wait_stopped = TRUE;
+                }
             }
         }
     }
@@ -850,6 +868,13 @@ PRIVATE int yev_callback(yev_event_h yev_event)
                         }
 
                     } else {
+                        if(!peername[0]) {
+                            /*
+                             *  The label is the udp channel ("ip:port") for the subscriber,
+                             *  it's needed with or without traces.
+                             */
+                            print_socket_address(peername, sizeof(peername), yev_event->msghdr->msg_name);
+                        }
                         GBUFFER_INCREF(gbuf)
                         json_t *kw = json_pack("{s:I}",
                             "gbuffer", (json_int_t)(uintptr_t)gbuf
@@ -829,12 +829,11 @@ PRIVATE gbuffer_t * unmask_data(hgobj gobj, gbuffer_t *gbuf, uint8_t *h_mask)
  ***************************************************************************/
 PRIVATE BOOL check_utf8(gbuffer_t *gbuf)
 {
-    // Available in jannson library
-    extern int utf8_check_string(const char *string, size_t length);
-    size_t length = gbuffer_leftbytes(gbuf);
-    const char *string = gbuffer_cur_rd_pointer(gbuf);
-
-    return utf8_check_string(string, length);
+    /*
+     *  Vectorized, and the result is kept in the gbuffer:
+     *  gbuf2json() of the published text frame doesn't validate again.
+     */
+    return gbuffer_utf8_validate(gbuf);
 }
 
 /***************************************************************************
@@ -31,6 +31,7 @@ PRIVATE int on_url(llhttp_t* llhttp, const char* at, size_t length);
 PRIVATE int on_header_field(llhttp_t* llhttp, const char* at, size_t length);
 PRIVATE int on_header_value(llhttp_t* llhttp, const char* at, size_t length);
 PRIVATE int on_body(llhttp_t* llhttp, const char* at, size_t length);
+PRIVATE void reset_message_state(GHTTP_PARSER *parser);
 
 /****************************************************************
  *         Data
@@ -234,11 +235,12 @@ PRIVATE int on_headers_complete(llhttp_t* llhttp)
         parser->jn_headers = json_object();
     }
     if(parser->on_header_event) {
-        json_t *kw_http = json_pack("{s:i, s:s, s:i, s:i, s:O}",
+        json_t *kw_http = json_pack("{s:i, s:s, s:i, s:i, s:b, s:O}",
             "http_parser_type",     (int)parser->type,
             "url",                  parser->url?parser->url:"",
             "response_status_code", (int)llhttp_get_status_code(&parser->llhttp),
             "request_method",       (int)llhttp_get_method(&parser->llhttp),
+            "should_keep_alive",    llhttp_should_keep_alive(&parser->llhttp)?1:0,
             "headers",              parser->jn_headers
         );
         if(parser->send_event) {
@@ -319,6 +321,13 @@ PRIVATE int on_message_complete(llhttp_t* llhttp)
         json_t *kw_http = json_pack("{s:i}",
             "response_status_code", (int)llhttp_get_status_code(&parser->llhttp)
         );
+        if(!parser->on_message_event) {
+            /*
+             *  Streaming mode: nothing more to publish of this message,
+             *  clean it now, the next pipelined one can arrive in the same buffer.
+             */
+            reset_message_state(parser);
+        }
         if(parser->send_event) {
             gobj_send_event(gobj, parser->on_body_event, kw_http, gobj);
         } else {
@@ -330,11 +339,12 @@ PRIVATE int on_message_complete(llhttp_t* llhttp)
         /*
          *  The cur_request (with the body) is ready to use.
          */
-        json_t *kw_http = json_pack("{s:i, s:s, s:i, s:i, s:O}",
+        json_t *kw_http = json_pack("{s:i, s:s, s:i, s:i, s:b, s:O}",
             "http_parser_type",     (int)parser->type,
             "url",                  parser->url?parser->url:"",
             "response_status_code", (int)llhttp_get_status_code(&parser->llhttp),
             "request_method",       (int)llhttp_get_method(&parser->llhttp),
+            "should_keep_alive",    llhttp_should_keep_alive(&parser->llhttp)?1:0,
             "headers",              parser->jn_headers
         );
         const char *content_type = kw_get_str(gobj, parser->jn_headers, "CONTENT-TYPE", "", 0);
@@ -376,14 +386,7 @@ PRIVATE int on_message_complete(llhttp_t* llhttp)
          *  llhttp handles the message-to-message transition internally
          *  for keep-alive, so we just clear our own per-request fields.
          */
-        parser->headers_completed = 0;
-        parser->message_completed = 0;
-        parser->body_size = 0;
-        GBMEM_FREE(parser->url);
-        GBUFFER_DECREF(parser->gbuf_body)
-        JSON_DECREF(parser->jn_headers);
-        GBMEM_FREE(parser->cur_key);
-        GBMEM_FREE(parser->last_key);
+        reset_message_state(parser);
 
         if(parser->send_event) {
             gobj_send_event(gobj, parser->on_message_event, kw_http, gobj);
@@ -394,6 +397,21 @@ PRIVATE int on_message_complete(llhttp_t* llhttp)
     return 0;
 }
 
+/***************************************************************************
+ *  Clear the per-message application state, llhttp keeps its own.
+ ***************************************************************************/
+PRIVATE void reset_message_state(GHTTP_PARSER *parser)
+{
+    parser->headers_completed = 0;
+    parser->message_completed = 0;
+    parser->body_size = 0;
+    GBMEM_FREE(parser->url);
+    GBUFFER_DECREF(parser->gbuf_body)
+    JSON_DECREF(parser->jn_headers);
+    GBMEM_FREE(parser->cur_key);
+    GBMEM_FREE(parser->last_key);
+}
+
 /***************************************************************************
  *  Callbacks must return 0 on success.
  *  Returning a non-zero value indicates error to the parser,
@@ -45,6 +45,7 @@ PUBLIC GHTTP_PARSER *ghttp_parser_create(
                 "url":                  (string) "url",
                 "response_status_code": (int) status_code,
                 "request_method":       (int) method,
+                "should_keep_alive":    (bool) FALSE if the connection must be closed after this message,
                 "headers":              (json_object) jn_headers
             }
         */
@@ -65,6 +66,7 @@ PUBLIC GHTTP_PARSER *ghttp_parser_create(
                 "url":                  (string) "url",
                 "response_status_code": (int) status_code,
                 "request_method":       (int) method,
+                "should_keep_alive":    (bool) FALSE if the connection must be closed after this message,
                 "headers":              (json_object) jn_headers,
 
                 if content-type == application/json
@@ -20,6 +20,7 @@
 #include <fnmatch.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 
 #define PCRE2_STATIC
 #define PCRE2_CODE_UNIT_WIDTH 8
@@ -44,6 +45,10 @@ PRIVATE const char *topic_fields[] = {
     "directory",
     "wr_fd_files",
     "rd_fd_files",
+    "rd_md2_maps",
+    "md2_maps_lru",
+    "rd_time_indexes",
+    "content_cache",
     "lists",
     "filename_mask",
     "xpermission",
@@ -89,6 +94,102 @@ typedef struct { // Size: 32 bytes — fields are big-endian on disk
 
 #pragma pack()
 
+/*
+ *  Read-only mapping of a .md2 file, in topic`rd_md2_maps`{key}`{file_id}.md2
+ *  The mapping is longer than the file, in steps of MD2_MAP_GROWTH,
+ *  so the appends of the master are seen without remapping;
+ *  only the bytes below `size` (the file size last seen) are touched.
+ *  A file that cannot be mapped has `false` instead, it's read with read().
+ */
+typedef struct md2_map_s {
+    DL_ITEM_FIELDS
+
+    char *key;
+    char filename[NAME_MAX];
+    char *base;
+    size_t length;  // mapped length
+    size_t size;    // file size
+} md2_map_t;
+
+/*
+ *  The mappings of a topic, at most MD2_MAPS_MAX, in topic`md2_maps_lru`.
+ *  LRU: dl_lru goes from the least to the most recently used.
+ */
+typedef struct {
+    dl_list_t dl_lru;
+    size_t n_maps;
+} md2_maps_lru_t;
+
+#define MD2_MAP_GROWTH  (1024*1024)  // 32768 md2 records
+#define MD2_MAPS_MAX    256          // by topic, a key with many files or many keys
+
+/*
+ *  Row index of a filtered paging iterator, see build_iterator_index().
+ *  The matching rowids are kept as runs of consecutive rowids,
+ *  a run is 16 bytes however many rows it has.
+ */
+typedef struct {
+    json_int_t first_rowid; // first global rowid of the run
+    json_int_t position;    // position of first_rowid in the index, based 0
+} rowid_run_t;
+
+/*
+ *  Sparse time index of a .md2 file, see get_time_index().
+ *  One block every TIX_BLOCK_ROWS rows with the range of __t__ and __tm__
+ *  of its rows, plus the maximums of all the rows up to its end.
+ *  The complete blocks are saved by the master in <file_id>.tix
+ */
+#define TIX_BLOCK_ROWS  1024
+#define TIX_MAGIC       "TIX1"
+
+typedef struct {
+    uint64_t min_t;
+    uint64_t max_t;
+    uint64_t min_tm;
+    uint64_t max_tm;
+    uint64_t upto_max_t;    // max __t__ of rows 1 .. end of block
+    uint64_t upto_max_tm;   // max __tm__ of rows 1 .. end of block
+} tix_block_t;
+
+typedef struct {
+    tix_block_t *blocks;
+    size_t n_blocks;        // the last one can be partial
+    size_t max_blocks;
+    uint64_t rows;          // rows of the .md2 covered by the blocks
+    size_t saved_blocks;    // complete blocks in the .tix file
+} time_index_t;
+
+/*
+ *  Content cache of a topic, for lazy lists, see tranger2_read_record_cached().
+ *  LRU: dl_lru goes from the least to the most recently used.
+ */
+typedef struct content_cache_item_s {
+    DL_ITEM_FIELDS
+
+    char *id;           // key`__t__`__offset__
+    json_t *record;
+    size_t size;        // __size__ of the record on disk, what is charged
+} content_cache_item_t;
+
+typedef struct {
+    dl_list_t dl_lru;
+    json_t *jn_items;   // id: content_cache_item_t *
+    size_t size;
+    size_t max_size;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+} content_cache_t;
+
+#define DEFAULT_CONTENT_CACHE_SIZE  (16*1024*1024)
+
+typedef struct {
+    rowid_run_t *runs;
+    size_t n_runs;
+    size_t max_runs;
+    json_int_t rows;        // rows in the index
+} rowid_index_t;
+
 #define TIME_FLAG_MASK  0x00000FFFFFFFFFFFULL  /* Maximum date: UTC 559444-03-08T09:40:15+0000 */
 #define USER_FLAG_MASK  0x0FFFF00000000000ULL
 
@@ -153,6 +254,54 @@ PRIVATE int close_fd_rd_files(
     json_t *topic,
     const char *key
 );
+PRIVATE int close_md2_maps(
+    hgobj gobj,
+    json_t *topic,
+    const char *key
+);
+PRIVATE md2_map_t *get_md2_map(
+    hgobj gobj,
+    json_t *tranger,
+    json_t *topic,
+    const char *key,
+    const char *file_id,
+    size_t need_size
+);
+PRIVATE void advise_md2_map(
+    hgobj gobj,
+    json_t *tranger,
+    json_t *topic,
+    const char *key,
+    json_t *segment,
+    int advice
+);
+PRIVATE int md2_record_to_ex(
+    md2_record_t *md_record,
+    uint64_t rowid, // relative to 1
+    md2_record_ex_t *md_record_ex
+);
+PRIVATE int close_time_indexes(
+    hgobj gobj,
+    json_t *topic,
+    const char *key
+);
+PRIVATE void content_cache_drop(json_t *topic, const char *key);
+PRIVATE void content_cache_drop_record(
+    json_t *topic,
+    const char *key,
+    uint64_t __t__,
+    uint64_t __offset__
+);
+PRIVATE void content_cache_destroy(json_t *topic);
+PRIVATE json_int_t time_seek_row(
+    hgobj gobj,
+    json_t *tranger,
+    json_t *topic,
+    const char *key,
+    json_t *segment,
+    json_t *match_cond,
+    json_int_t rowid
+);
 
 PRIVATE int json_array_find_idx(
     json_t *jn_list,
@@ -226,7 +375,7 @@ PRIVATE json_t *get_cache_files(json_t *topic, const char *key);
 PRIVATE json_t *get_cache_total(json_t *topic, const char *key);
 
 PRIVATE BOOL match_cond_selects_records(json_t *match_cond);
-PRIVATE json_t *build_iterator_index(
+PRIVATE rowid_index_t *build_iterator_index(
     hgobj gobj,
     json_t *tranger,
     json_t *topic,
@@ -234,6 +383,8 @@ PRIVATE json_t *build_iterator_index(
     json_t *segments,
     json_t *match_cond
 );
+PRIVATE void rowid_index_destroy(rowid_index_t *index);
+PRIVATE json_int_t rowid_index_get(rowid_index_t *index, json_int_t position);
 PRIVATE json_t *segment_of_rowid(json_t *segments, json_int_t rowid);
 
 PRIVATE json_t *get_segments(
@@ -1153,6 +1304,8 @@ PUBLIC json_t *tranger2_open_topic( // WARNING returned json IS NOT YOURS
     kw_get_str(gobj, topic, "directory", directory, KW_CREATE);
     kw_get_dict(gobj, topic, "wr_fd_files", json_object(), KW_CREATE);
     kw_get_dict(gobj, topic, "rd_fd_files", json_object(), KW_CREATE);
+    kw_get_dict(gobj, topic, "rd_md2_maps", json_object(), KW_CREATE);
+    kw_get_dict(gobj, topic, "rd_time_indexes", json_object(), KW_CREATE);
     kw_get_dict(gobj, topic, "cache", json_object(), KW_CREATE);
     kw_get_dict(gobj, topic, "lists", json_array(), KW_CREATE);
     kw_get_dict(gobj, topic, "disks", json_array(), KW_CREATE);
@@ -1455,6 +1608,7 @@ PUBLIC int tranger2_close_topic(
     }
 
     close_fd_opened_files(gobj, topic, NULL);
+    content_cache_destroy(topic);
 
     // MONITOR Master Unwatching (MI) topic /disks/
     yev_loop_h yev_loop = (yev_loop_h)kw_get_int(gobj, tranger, "yev_loop", 0, KW_REQUIRED);
@@ -2463,164 +2617,733 @@ PRIVATE int close_fd_rd_files(
     const char *key
 )
 {
+    close_time_indexes(gobj, topic, key);
+    close_md2_maps(gobj, topic, key);
     json_t *fd_files = kw_get_dict(gobj, topic, "rd_fd_files", 0, KW_REQUIRED);
     return close_fd_files(gobj, fd_files, key);
 }
 
 /***************************************************************************
- *
+ *  LRU of the .md2 mappings of the topic, created on first use
  ***************************************************************************/
-PRIVATE int close_fd_opened_files(
-    hgobj gobj,
-    json_t *topic,
-    const char *key
-)
+PRIVATE md2_maps_lru_t *get_md2_maps_lru(json_t *topic, BOOL create)
 {
-    close_fd_wr_files(gobj, topic, key);
-    close_fd_rd_files(gobj, topic, key);
-    return 0;
+    md2_maps_lru_t *lru = (md2_maps_lru_t *)(size_t)json_integer_value(
+        json_object_get(topic, "md2_maps_lru")
+    );
+    if(!lru && create) {
+        lru = GBMEM_MALLOC(sizeof(md2_maps_lru_t));
+        if(!lru) {
+            return NULL;
+        }
+        dl_init(&lru->dl_lru, 0);
+        json_object_set_new(topic, "md2_maps_lru", json_integer((json_int_t)(size_t)lru));
+    }
+    return lru;
 }
 
 /***************************************************************************
- *  Return json object with record metadata
+ *  Unmap a .md2 file, the caller removes it from rd_md2_maps
  ***************************************************************************/
-PRIVATE json_t *md2json(
-    md2_record_ex_t *md_record_ex,
-    json_int_t rowid
+PRIVATE void free_md2_map(md2_maps_lru_t *lru, md2_map_t *md2_map)
+{
+    munmap(md2_map->base, md2_map->length);
+    if(lru) {
+        dl_delete(&lru->dl_lru, md2_map, 0);
+        lru->n_maps--;
+    }
+    GBMEM_FREE(md2_map->key)
+    GBMEM_FREE(md2_map)
+}
+
+/***************************************************************************
+ *  Unmap the .md2 files of a key, or of all keys if key is empty
+ ***************************************************************************/
+PRIVATE int close_md2_maps(
+    hgobj gobj,
+    json_t *topic,
+    const char *key_
 )
 {
-    json_t *jn_md = json_object();
-    json_object_set_new(jn_md, "g_rowid", json_integer(rowid));
-    json_object_set_new(jn_md, "i_rowid", json_integer((json_int_t)md_record_ex->rowid));
-    json_object_set_new(jn_md, "t", json_integer((json_int_t)md_record_ex->__t__));
-    json_object_set_new(jn_md, "tm", json_integer((json_int_t)md_record_ex->__tm__));
-    json_object_set_new(jn_md, "offset", json_integer((json_int_t)md_record_ex->__offset__));
-    json_object_set_new(jn_md, "size", json_integer((json_int_t)md_record_ex->__size__));
-    json_object_set_new(jn_md, "system_flag", json_integer(md_record_ex->system_flag));
-    json_object_set_new(jn_md, "user_flag", json_integer(md_record_ex->user_flag));
+    json_t *md2_maps = json_object_get(topic, "rd_md2_maps");
+    md2_maps_lru_t *lru = get_md2_maps_lru(topic, FALSE);
 
-    return jn_md;
+    json_t *jn_files;
+    const char *key;
+    void *tmp;
+
+    json_object_foreach_safe(md2_maps, tmp, key, jn_files) {
+        if(!empty_string(key_) && strcmp(key, key_)!=0) {
+            continue;
+        }
+        json_t *jn_value;
+        const char *filename;
+        void *tmp2;
+        json_object_foreach_safe(jn_files, tmp2, filename, jn_value) {
+            md2_map_t *md2_map = (md2_map_t *)(size_t)json_integer_value(jn_value);
+            if(md2_map) {
+                free_md2_map(lru, md2_map);
+            }
+            json_object_del(jn_files, filename);
+        }
+        json_object_del(md2_maps, key);
+    }
+
+    if(empty_string(key_) && lru) {
+        GBMEM_FREE(lru)
+        json_object_del(topic, "md2_maps_lru");
+    }
+
+    return 0;
 }
 
 /***************************************************************************
- *  A feed (rt_mem list or rt_disk) opened with only_md wants a record's
- *  metadata but not its body — the realtime paths honor it like the
- *  historical iterator (tranger2_open_iterator) already does.
+ *  Unmap the least recently used .md2 files beyond MD2_MAPS_MAX
  ***************************************************************************/
-PRIVATE BOOL feed_wants_only_md(json_t *feed)
+PRIVATE void trim_md2_maps(json_t *topic, md2_maps_lru_t *lru)
 {
-    json_t *match_cond = json_object_get(feed, "match_cond");
-    if(!match_cond) {
-        return FALSE;
+    json_t *md2_maps = json_object_get(topic, "rd_md2_maps");
+
+    md2_map_t *md2_map;
+    while(lru->n_maps > MD2_MAPS_MAX && (md2_map = dl_first(&lru->dl_lru))) {
+        json_t *key_dict = json_object_get(md2_maps, md2_map->key);
+        json_object_del(key_dict, md2_map->filename);
+        if(json_object_size(key_dict)==0) {
+            json_object_del(md2_maps, md2_map->key);
+        }
+        free_md2_map(lru, md2_map);
     }
-    return json_boolean_value(json_object_get(match_cond, "only_md"))? TRUE : FALSE;
 }
 
 /***************************************************************************
-    Append a new item to record.
-    The 'pkey' and 'tkey' are getting according to the topic schema.
-    Return the new record's metadata.
+ *  Get the mapping of a .md2 file covering at least need_size bytes.
+ *  Map it, or remap it if the file has grown beyond the mapped length.
+ *  At most MD2_MAPS_MAX files are mapped by topic, the least recently
+ *  used are unmapped: don't keep a mapping across another get_md2_map().
+ *
+ *  Return NULL if the file is shorter than need_size or cannot be mapped,
+ *  the caller must fall back to read().
  ***************************************************************************/
-PUBLIC int tranger2_append_record(
+PRIVATE md2_map_t *get_md2_map(
+    hgobj gobj,
     json_t *tranger,
-    const char *topic_name,
-    uint64_t __t__,         // if 0 then the time will be set by TimeRanger with now time
-    uint16_t user_flag,
-    md2_record_ex_t *md_record_ex, // required, to return the metadata
-    json_t *record       // JSON owned
+    json_t *topic,
+    const char *key,
+    const char *file_id,
+    size_t need_size
 )
 {
-    hgobj gobj = (hgobj)json_integer_value(json_object_get(tranger, "gobj"));
+    char filename[NAME_MAX];
+    snprintf(filename, sizeof(filename), "%s.md2", file_id);
 
-    if(!record || record->refcount <= 0) {
-        gobj_log_error(gobj, 0,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_INTERNAL,
-            "msg",          "%s", "Cannot append record, record NULL",
-            "topic",        "%s", topic_name,
-            NULL
-        );
-        return -1;
+    json_t *md2_maps = json_object_get(topic, "rd_md2_maps");
+    md2_maps_lru_t *lru = get_md2_maps_lru(topic, TRUE);
+    if(!md2_maps || !lru) {
+        return NULL;
+    }
+    json_t *key_dict = json_object_get(md2_maps, key);
+    json_t *jn_map = json_object_get(key_dict, filename);
+    if(json_is_false(jn_map)) {
+        return NULL;    // cannot be mapped, use read()
+    }
+    md2_map_t *md2_map = (md2_map_t *)(size_t)json_integer_value(jn_map);
+    if(md2_map && md2_map->size >= need_size) {
+        dl_delete(&lru->dl_lru, md2_map, 0);
+        dl_add(&lru->dl_lru, md2_map);
+        return md2_map;
     }
 
-    // TEST performance 800.000
+    int fd = get_topic_rd_fd(gobj, tranger, topic, key, file_id, FALSE);
+    if(fd<0) {
+        return NULL;
+    }
 
-    BOOL master = json_boolean_value(json_object_get(tranger, "master"));
-    if(!master) {
-        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER,
-            "msg",          "%s", "Cannot append record, NO master",
-            "topic",        "%s", topic_name,
-            NULL
-        );
-        gobj_trace_json(gobj, record, "Cannot append record, NO master");
-        JSON_DECREF(record)
-        return -1;
+    /*
+     *  Look it up again, get_topic_rd_fd() unmaps all on EMFILE
+     */
+    lru = get_md2_maps_lru(topic, TRUE);
+    if(!lru) {
+        return NULL;
     }
+    key_dict = json_object_get(md2_maps, key);
+    md2_map = (md2_map_t *)(size_t)json_integer_value(
+        json_object_get(key_dict, filename)
+    );
 
-    json_t *topic = tranger2_topic(tranger, topic_name);
-    if(!topic) {
+    struct stat st;
+    if(fstat(fd, &st)<0 || (size_t)st.st_size < need_size) {
+        return NULL;
+    }
+    size_t file_size = (size_t)st.st_size;
+
+    if(md2_map && file_size <= md2_map->length) {
+        /*
+         *  Grown inside the mapped length
+         */
+        md2_map->size = file_size;
+        dl_delete(&lru->dl_lru, md2_map, 0);
+        dl_add(&lru->dl_lru, md2_map);
+        return md2_map;
+    }
+
+    size_t length = (file_size/MD2_MAP_GROWTH + 1) * MD2_MAP_GROWTH;
+    void *base = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+    if(base == MAP_FAILED) {
         gobj_log_error(gobj, 0,
             "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_INTERNAL,
-            "msg",          "%s", "Cannot append record, topic not found",
-            "topic",        "%s", topic_name,
+            "msgset",       "%s", MSGSET_SYSTEM,
+            "msg",          "%s", "mmap() of md2 FAILED, using read()",
+            "topic",        "%s", tranger2_topic_name(topic),
+            "key",          "%s", key,
+            "file_id",      "%s", file_id,
+            "errno",        "%d", errno,
+            "serrno",       "%s", strerror(errno),
             NULL
         );
-        gobj_trace_json(gobj, record, "Cannot append record, topic not found");
-        JSON_DECREF(record)
-        return -1;
+        /*
+         *  Don't try again with this file, the others keep their mappings
+         */
+        if(md2_map) {
+            free_md2_map(lru, md2_map);
+        }
+        if(!key_dict) {
+            key_dict = json_object();
+            json_object_set_new(md2_maps, key, key_dict);
+        }
+        json_object_set_new(key_dict, filename, json_false());
+        return NULL;
     }
 
-    /*--------------------------------------------*
-     *  If time not specified, use the now time
-     *--------------------------------------------*/
-    system_flag2_t system_flag = json_integer_value(json_object_get(topic, "system_flag"));
-    if(!__t__) {
-        if(system_flag & (sf_t_ms)) {
-            __t__ = time_in_milliseconds();
-        } else {
-            __t__ = time_in_seconds();
+    if(md2_map) {
+        munmap(md2_map->base, md2_map->length);
+        dl_delete(&lru->dl_lru, md2_map, 0);
+    } else {
+        md2_map = GBMEM_MALLOC(sizeof(md2_map_t));
+        if(!md2_map) {
+            munmap(base, length);
+            return NULL;
+        }
+        md2_map->key = gbmem_strdup(key);
+        snprintf(md2_map->filename, sizeof(md2_map->filename), "%s", filename);
+        if(!key_dict) {
+            key_dict = json_object();
+            json_object_set_new(md2_maps, key, key_dict);
         }
+        json_object_set_new(key_dict, filename, json_integer((json_int_t)(size_t)md2_map));
+        lru->n_maps++;
     }
+    md2_map->base = base;
+    md2_map->length = length;
+    md2_map->size = file_size;
+    dl_add(&lru->dl_lru, md2_map);
 
-    /*--------------------------------------------*
-     *  Prepare new record metadata
-     *--------------------------------------------*/
-    md2_record_t md_record;
-    memset(&md_record, 0, sizeof(md2_record_t));
-    md_record.__t__ = __t__;
+    trim_md2_maps(topic, lru);
 
-    // TEST performance 700000
+    return md2_map;
+}
 
-    /*-----------------------------------*
-     *  Get the primary-key
-     *-----------------------------------*/
-    const char *pkey = json_string_value(json_object_get(topic, "pkey"));
-    system_flag2_t system_flag_key_type = system_flag & KEY_TYPE_MASK2;
+/***************************************************************************
+ *  madvise() the .md2 mapping of a segment,
+ *  MADV_SEQUENTIAL before walking all its rows, MADV_NORMAL after.
+ ***************************************************************************/
+PRIVATE void advise_md2_map(
+    hgobj gobj,
+    json_t *tranger,
+    json_t *topic,
+    const char *key,
+    json_t *segment,
+    int advice
+)
+{
+    const char *file_id = json_string_value(json_object_get(segment, "id"));
+    json_int_t first_row = json_integer_value(json_object_get(segment, "first_row"));
+    json_int_t last_row = json_integer_value(json_object_get(segment, "last_row"));
+    if(!file_id || last_row < first_row) {
+        return;
+    }
 
-    const char *key_value = NULL;
-    char key_int[NAME_MAX+1];
+    md2_map_t *md2_map = get_md2_map(
+        gobj,
+        tranger,
+        topic,
+        key,
+        file_id,
+        (size_t)(last_row - first_row + 1) * sizeof(md2_record_t)
+    );
+    if(md2_map) {
+        madvise(md2_map->base, md2_map->length, advice);
+    }
+}
 
-    switch(system_flag_key_type) {
-        case sf_string_key:
-            {
-                key_value = json_string_value(json_object_get(record, pkey));
-                if(empty_string(key_value)) {
-                    gobj_log_error(gobj, 0,
-                        "function",     "%s", __FUNCTION__,
-                        "msgset",       "%s", MSGSET_JSON,
-                        "msg",          "%s", "Cannot append record, no pkey",
-                        "topic",        "%s", topic_name,
-                        "pkey",         "%s", pkey,
-                        NULL
-                    );
-                    gobj_trace_json(gobj, record, "Cannot append record, no pkey");
-                    JSON_DECREF(record)
-                    return -1;
-                }
-                if(strlen(key_value) > NAME_MAX) {
+/***************************************************************************
+ *  Free the time indexes of a key, or of all keys if key is empty
+ ***************************************************************************/
+PRIVATE int close_time_indexes(
+    hgobj gobj,
+    json_t *topic,
+    const char *key_
+)
+{
+    json_t *time_indexes = json_object_get(topic, "rd_time_indexes");
+
+    json_t *jn_files;
+    const char *key;
+    void *tmp;
+
+    json_object_foreach_safe(time_indexes, tmp, key, jn_files) {
+        if(!empty_string(key_) && strcmp(key, key_)!=0) {
+            continue;
+        }
+        json_t *jn_value;
+        const char *file_id;
+        void *tmp2;
+        json_object_foreach_safe(jn_files, tmp2, file_id, jn_value) {
+            time_index_t *ti = (time_index_t *)(size_t)json_integer_value(jn_value);
+            if(ti) {
+                GBMEM_FREE(ti->blocks)
+                GBMEM_FREE(ti)
+            }
+            json_object_del(jn_files, file_id);
+        }
+        json_object_del(time_indexes, key);
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *  Add the times of a row to the time index, rows must come in order
+ ***************************************************************************/
+PRIVATE int time_index_add(time_index_t *ti, uint64_t t, uint64_t tm)
+{
+    size_t b = (size_t)(ti->rows / TIX_BLOCK_ROWS);
+    if(b == ti->n_blocks) {
+        if(ti->n_blocks == ti->max_blocks) {
+            size_t max_blocks = ti->max_blocks? ti->max_blocks * 2 : 16;
+            tix_block_t *blocks = GBMEM_REALLOC(ti->blocks, max_blocks * sizeof(tix_block_t));
+            if(!blocks) {
+                return -1;
+            }
+            ti->blocks = blocks;
+            ti->max_blocks = max_blocks;
+        }
+        tix_block_t *block = &ti->blocks[b];
+        block->min_t = block->max_t = t;
+        block->min_tm = block->max_tm = tm;
+        block->upto_max_t = (b > 0 && ti->blocks[b-1].upto_max_t > t)?
+            ti->blocks[b-1].upto_max_t : t;
+        block->upto_max_tm = (b > 0 && ti->blocks[b-1].upto_max_tm > tm)?
+            ti->blocks[b-1].upto_max_tm : tm;
+        ti->n_blocks++;
+    } else {
+        tix_block_t *block = &ti->blocks[b];
+        if(t < block->min_t) {
+            block->min_t = t;
+        }
+        if(t > block->max_t) {
+            block->max_t = t;
+        }
+        if(tm < block->min_tm) {
+            block->min_tm = tm;
+        }
+        if(tm > block->max_tm) {
+            block->max_tm = tm;
+        }
+        if(t > block->upto_max_t) {
+            block->upto_max_t = t;
+        }
+        if(tm > block->upto_max_tm) {
+            block->upto_max_tm = tm;
+        }
+    }
+    ti->rows++;
+    return 0;
+}
+
+/***************************************************************************
+ *  Load the complete blocks saved in <file_id>.tix
+ *  The header keeps the first md2 record of the file,
+ *  a .tix of another (re-created) .md2 is ignored.
+ ***************************************************************************/
+PRIVATE void load_time_index(
+    hgobj gobj,
+    json_t *topic,
+    const char *key,
+    const char *file_id,
+    md2_map_t *md2_map,
+    uint64_t rows,
+    time_index_t *ti
+)
+{
+    char path[PATH_MAX];
+    const char *topic_dir = json_string_value(json_object_get(topic, "directory"));
+    snprintf(path, sizeof(path), "%s/keys/%s/%s.tix", topic_dir, key, file_id);
+
+    int fd = open(path, O_RDONLY|O_CLOEXEC, 0);
+    if(fd < 0) {
+        return;
+    }
+
+    char header[4 + sizeof(uint32_t) + sizeof(md2_record_t)];
+    uint32_t block_rows;
+    if(read(fd, header, sizeof(header)) != sizeof(header) ||
+        memcmp(header, TIX_MAGIC, 4)!=0 ||
+        (memcpy(&block_rows, header + 4, sizeof(uint32_t)), ntohl(block_rows) != TIX_BLOCK_ROWS) ||
+        memcmp(header + 4 + sizeof(uint32_t), md2_map->base, sizeof(md2_record_t))!=0
+    ) {
+        close(fd);
+        return;
+    }
+
+    uint64_t saved[4];
+    while(ti->rows + TIX_BLOCK_ROWS <= rows) {
+        if(read(fd, saved, sizeof(saved)) != sizeof(saved)) {
+            break;
+        }
+        if(ti->n_blocks == ti->max_blocks) {
+            size_t max_blocks = ti->max_blocks? ti->max_blocks * 2 : 16;
+            tix_block_t *blocks = GBMEM_REALLOC(ti->blocks, max_blocks * sizeof(tix_block_t));
+            if(!blocks) {
+                break;
+            }
+            ti->blocks = blocks;
+            ti->max_blocks = max_blocks;
+        }
+        size_t b = ti->n_blocks;
+        tix_block_t *block = &ti->blocks[b];
+        block->min_t = ntohll(saved[0]);
+        block->max_t = ntohll(saved[1]);
+        block->min_tm = ntohll(saved[2]);
+        block->max_tm = ntohll(saved[3]);
+        block->upto_max_t = (b > 0 && ti->blocks[b-1].upto_max_t > block->max_t)?
+            ti->blocks[b-1].upto_max_t : block->max_t;
+        block->upto_max_tm = (b > 0 && ti->blocks[b-1].upto_max_tm > block->max_tm)?
+            ti->blocks[b-1].upto_max_tm : block->max_tm;
+        ti->n_blocks++;
+        ti->rows += TIX_BLOCK_ROWS;
+    }
+    ti->saved_blocks = ti->n_blocks;
+
+    close(fd);
+}
+
+/***************************************************************************
+ *  Append the new complete blocks to <file_id>.tix, only master
+ ***************************************************************************/
+PRIVATE void save_time_index(
+    hgobj gobj,
+    json_t *tranger,
+    json_t *topic,
+    const char *key,
+    const char *file_id,
+    md2_map_t *md2_map,
+    time_index_t *ti
+)
+{
+    size_t complete = (size_t)(ti->rows / TIX_BLOCK_ROWS);
+    if(complete <= ti->saved_blocks) {
+        return;
+    }
+
+    char path[PATH_MAX];
+    const char *topic_dir = json_string_value(json_object_get(topic, "directory"));
+    snprintf(path, sizeof(path), "%s/keys/%s/%s.tix", topic_dir, key, file_id);
+
+    int fd;
+    if(ti->saved_blocks == 0) {
+        fd = newfile(path, (int)kw_get_int(gobj, tranger, "rpermission", 0, KW_REQUIRED), TRUE);
+        if(fd >= 0) {
+            char header[4 + sizeof(uint32_t) + sizeof(md2_record_t)];
+            uint32_t block_rows = htonl(TIX_BLOCK_ROWS);
+            memcpy(header, TIX_MAGIC, 4);
+            memcpy(header + 4, &block_rows, sizeof(uint32_t));
+            memcpy(header + 4 + sizeof(uint32_t), md2_map->base, sizeof(md2_record_t));
+            if(write(fd, header, sizeof(header)) != sizeof(header)) {
+                close(fd);
+                fd = -1;
+            }
+        }
+    } else {
+        fd = open(path, O_WRONLY|O_APPEND|O_CLOEXEC, 0);
+    }
+    if(fd < 0) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_SYSTEM,
+            "msg",          "%s", "Cannot write time index",
+            "path",         "%s", path,
+            "errno",        "%d", errno,
+            "serrno",       "%s", strerror(errno),
+            NULL
+        );
+        ti->saved_blocks = complete;    // don't retry, it's only a cache
+        return;
+    }
+
+    for(size_t b = ti->saved_blocks; b < complete; b++) {
+        tix_block_t *block = &ti->blocks[b];
+        uint64_t saved[4] = {
+            htonll(block->min_t),
+            htonll(block->max_t),
+            htonll(block->min_tm),
+            htonll(block->max_tm)
+        };
+        if(write(fd, saved, sizeof(saved)) != sizeof(saved)) {
+            break;
+        }
+    }
+    ti->saved_blocks = complete;
+
+    close(fd);
+}
+
+/***************************************************************************
+ *  Get the time index of a segment covering all its rows.
+ *  Loaded from <file_id>.tix and completed from the .md2 mapping.
+ *  NULL if the .md2 cannot be mapped.
+ ***************************************************************************/
+PRIVATE time_index_t *get_time_index(
+    hgobj gobj,
+    json_t *tranger,
+    json_t *topic,
+    const char *key,
+    json_t *segment
+)
+{
+    const char *file_id = json_string_value(json_object_get(segment, "id"));
+    json_int_t first_row = json_integer_value(json_object_get(segment, "first_row"));
+    json_int_t last_row = json_integer_value(json_object_get(segment, "last_row"));
+    json_t *time_indexes = json_object_get(topic, "rd_time_indexes");
+    if(!file_id || last_row < first_row || !time_indexes) {
+        return NULL;
+    }
+    uint64_t rows = (uint64_t)(last_row - first_row + 1);
+
+    json_t *key_dict = json_object_get(time_indexes, key);
+    time_index_t *ti = (time_index_t *)(size_t)json_integer_value(
+        json_object_get(key_dict, file_id)
+    );
+    if(ti && ti->rows >= rows) {
+        return ti;
+    }
+
+    md2_map_t *md2_map = get_md2_map(
+        gobj, tranger, topic, key, file_id, (size_t)rows * sizeof(md2_record_t)
+    );
+    if(!md2_map) {
+        return NULL;
+    }
+
+    if(!ti) {
+        ti = GBMEM_MALLOC(sizeof(time_index_t));
+        if(!ti) {
+            return NULL;
+        }
+        if(!key_dict) {
+            key_dict = json_object();
+            json_object_set_new(time_indexes, key, key_dict);
+        }
+        json_object_set_new(key_dict, file_id, json_integer((json_int_t)(size_t)ti));
+
+        load_time_index(gobj, topic, key, file_id, md2_map, rows, ti);
+    }
+
+    /*
+     *  Complete it with the rows not indexed yet
+     */
+    for(uint64_t rowid = ti->rows + 1; rowid <= rows; rowid++) {
+        md2_record_t md_record;
+        md2_record_ex_t md_record_ex;
+        memcpy(
+            &md_record,
+            md2_map->base + (rowid - 1) * sizeof(md2_record_t),
+            sizeof(md2_record_t)
+        );
+        md2_record_to_ex(&md_record, rowid, &md_record_ex);
+        if(time_index_add(ti, md_record_ex.__t__, md_record_ex.__tm__)<0) {
+            return NULL;
+        }
+    }
+
+    if(json_boolean_value(json_object_get(tranger, "master"))) {
+        save_time_index(gobj, tranger, topic, key, file_id, md2_map, ti);
+    }
+
+    return ti;
+}
+
+/***************************************************************************
+ *  Skip the rows of a segment that cannot match the time range of match_cond
+ *
+ *  Forward: move rowid to the first block where the rows up to its end
+ *      reach from_t and from_tm (binary search, the maximums only grow).
+ *  Backward: move rowid to the last block whose rows go down to
+ *      to_t and to_tm.
+ *  Every skipped row fails tranger2_match_metadata(), the rows of the block
+ *  found are checked one by one as before.
+ ***************************************************************************/
+PRIVATE json_int_t time_seek_row(
+    hgobj gobj,
+    json_t *tranger,
+    json_t *topic,
+    const char *key,
+    json_t *segment,
+    json_t *match_cond,
+    json_int_t rowid
+)
+{
+    BOOL backward = json_boolean_value(json_object_get(match_cond, "backward"));
+    uint64_t cond_t = (uint64_t)json_integer_value(
+        json_object_get(match_cond, backward? "to_t" : "from_t")
+    );
+    uint64_t cond_tm = (uint64_t)json_integer_value(
+        json_object_get(match_cond, backward? "to_tm" : "from_tm")
+    );
+    if(!cond_t && !cond_tm) {
+        return rowid;
+    }
+
+    json_int_t first_row = json_integer_value(json_object_get(segment, "first_row"));
+    json_int_t last_row = json_integer_value(json_object_get(segment, "last_row"));
+    if(last_row - first_row + 1 <= TIX_BLOCK_ROWS) {
+        return rowid;
+    }
+
+    time_index_t *ti = get_time_index(gobj, tranger, topic, key, segment);
+    if(!ti || ti->n_blocks == 0) {
+        return rowid;
+    }
+
+    if(!backward) {
+        size_t lo = 0;
+        size_t hi = ti->n_blocks;   // first block reaching the range, n_blocks if none
+        while(lo < hi) {
+            size_t mid = lo + (hi - lo)/2;
+            tix_block_t *block = &ti->blocks[mid];
+            if((cond_t && block->upto_max_t < cond_t) ||
+                    (cond_tm && block->upto_max_tm < cond_tm)) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        json_int_t seek_row = first_row + (json_int_t)(lo * TIX_BLOCK_ROWS);
+        if(seek_row > last_row) {
+            seek_row = last_row;
+        }
+        return seek_row > rowid? seek_row : rowid;
+
+    } else {
+        size_t b = (size_t)((last_row - first_row + TIX_BLOCK_ROWS) / TIX_BLOCK_ROWS);
+        if(b > ti->n_blocks) {
+            b = ti->n_blocks;
+        }
+        while(b > 0) {
+            tix_block_t *block = &ti->blocks[b-1];
+            if((cond_t && block->min_t > cond_t) || (cond_tm && block->min_tm > cond_tm)) {
+                b--;
+            } else {
+                break;
+            }
+        }
+        json_int_t seek_row = first_row + (json_int_t)(b * TIX_BLOCK_ROWS) - 1;
+        if(seek_row < first_row) {
+            seek_row = first_row;
+        }
+        if(seek_row > last_row) {
+            seek_row = last_row;
+        }
+        return seek_row < rowid? seek_row : rowid;
+    }
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int close_fd_opened_files(
+    hgobj gobj,
+    json_t *topic,
+    const char *key
+)
+{
+    close_fd_wr_files(gobj, topic, key);
+    close_fd_rd_files(gobj, topic, key);
+    content_cache_drop(topic, key);
+    return 0;
+}
+
+/***************************************************************************
+ *  Return json object with record metadata
+ ***************************************************************************/
+PRIVATE json_t *md2json(
+    md2_record_ex_t *md_record_ex,
+    json_int_t rowid
+)
+{
+    json_t *jn_md = json_object();
+    json_object_set_new(jn_md, "g_rowid", json_integer(rowid));
+    json_object_set_new(jn_md, "i_rowid", json_integer((json_int_t)md_record_ex->rowid));
+    json_object_set_new(jn_md, "t", json_integer((json_int_t)md_record_ex->__t__));
+    json_object_set_new(jn_md, "tm", json_integer((json_int_t)md_record_ex->__tm__));
+    json_object_set_new(jn_md, "offset", json_integer((json_int_t)md_record_ex->__offset__));
+    json_object_set_new(jn_md, "size", json_integer((json_int_t)md_record_ex->__size__));
+    json_object_set_new(jn_md, "system_flag", json_integer(md_record_ex->system_flag));
+    json_object_set_new(jn_md, "user_flag", json_integer(md_record_ex->user_flag));
+
+    return jn_md;
+}
+
+/***************************************************************************
+ *  A feed (rt_mem list or rt_disk) opened with only_md wants a record's
+ *  metadata but not its body — the realtime paths honor it like the
+ *  historical iterator (tranger2_open_iterator) already does.
+ ***************************************************************************/
+PRIVATE BOOL feed_wants_only_md(json_t *feed)
+{
+    json_t *match_cond = json_object_get(feed, "match_cond");
+    if(!match_cond) {
+        return FALSE;
+    }
+    return json_boolean_value(json_object_get(match_cond, "only_md"))? TRUE : FALSE;
+}
+
+/***************************************************************************
+ *  Get the primary-key value of a record to append, according to the
+ *  topic schema. The int keys are formatted in `key_int`.
+ *  Return NULL (error logged) if the record has no valid key.
+ ***************************************************************************/
+PRIVATE const char *get_record_key_value(
+    hgobj gobj,
+    json_t *topic,
+    const char *topic_name,
+    system_flag2_t system_flag,
+    json_t *record, // not owned
+    char *key_int,
+    size_t key_int_size
+)
+{
+    const char *pkey = json_string_value(json_object_get(topic, "pkey"));
+    system_flag2_t system_flag_key_type = system_flag & KEY_TYPE_MASK2;
+
+    const char *key_value = NULL;
+
+    switch(system_flag_key_type) {
+        case sf_string_key:
+            {
+                key_value = json_string_value(json_object_get(record, pkey));
+                if(empty_string(key_value)) {
+                    gobj_log_error(gobj, 0,
+                        "function",     "%s", __FUNCTION__,
+                        "msgset",       "%s", MSGSET_JSON,
+                        "msg",          "%s", "Cannot append record, no pkey",
+                        "topic",        "%s", topic_name,
+                        "pkey",         "%s", pkey,
+                        NULL
+                    );
+                    gobj_trace_json(gobj, record, "Cannot append record, no pkey");
+                    return NULL;
+                }
+                if(strlen(key_value) > NAME_MAX) {
                     // Key will be a directory name, cannot be greater than NAME_MAX
                     gobj_log_error(gobj, 0,
                         "function",     "%s", __FUNCTION__,
@@ -2633,8 +3356,7 @@ PUBLIC int tranger2_append_record(
                         NULL
                     );
                     gobj_trace_json(gobj, record, "Cannot append record, pkey too long");
-                    JSON_DECREF(record)
-                    return -1;
+                    return NULL;
                 }
                 /*
                  *  The key becomes a single directory component under
@@ -2653,8 +3375,7 @@ PUBLIC int tranger2_append_record(
                         NULL
                     );
                     gobj_trace_json(gobj, record, "Cannot append record, invalid pkey (path traversal)");
-                    JSON_DECREF(record)
-                    return -1;
+                    return NULL;
                 }
             }
             break;
@@ -2662,31 +3383,208 @@ PUBLIC int tranger2_append_record(
         case sf_int_key:
             {
                 uint64_t i = json_integer_value(json_object_get(record, pkey));
-                snprintf(key_int, sizeof(key_int), "%0*"PRIu64, 19, i);
+                snprintf(key_int, key_int_size, "%0*"PRIu64, 19, i);
                 key_value = key_int;
             }
             break;
 
-        case sf_rowid_key:
-            {
-                key_value = "__rowid__";
-                json_object_set_new(record, "__rowid__", json_string("__rowid__"));
-            }
-            break;
+        case sf_rowid_key:
+            {
+                key_value = "__rowid__";
+                json_object_set_new(record, "__rowid__", json_string("__rowid__"));
+            }
+            break;
+
+        default:
+            // No pkey
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_JSON,
+                "msg",          "%s", "Cannot append record, no pkey type",
+                "topic",        "%s", topic_name,
+                "pkey",         "%s", pkey,
+                NULL
+            );
+            gobj_trace_json(gobj, record, "Cannot append record, no pkey type");
+            return NULL;
+    }
+
+    return key_value;
+}
+
+/***************************************************************************
+ *  Get the t-key value of a record to append, 0 if it has none.
+ ***************************************************************************/
+PRIVATE uint64_t get_record_tm(
+    json_t *topic,
+    system_flag2_t system_flag,
+    json_t *record // not owned
+)
+{
+    const char *tkey = json_string_value(json_object_get(topic, "tkey"));
+    if(empty_string(tkey)) {
+        return 0;  // No tkey value, mark with 0
+    }
+
+    json_t *jn_tval = json_object_get(record, tkey);
+    if(json_is_string(jn_tval)) {
+        timestamp_t timestamp = approxidate(json_string_value(jn_tval));
+        if(system_flag & sf_tm_ms) {
+            timestamp *= 1000;
+        }
+        return timestamp;
+    } else if(json_is_integer(jn_tval)) {
+        return json_integer_value(jn_tval);
+    }
+    return 0; // No tkey value, mark with 0
+}
+
+/***************************************************************************
+ *  Fill the metadata returned to the user from the written md2 record
+ ***************************************************************************/
+PRIVATE void set_md_record_ex(
+    md2_record_ex_t *md_record_ex,
+    md2_record_t *md_record,
+    json_int_t i_rowid
+)
+{
+    md_record_ex->__t__ = get_time_t(md_record);
+    md_record_ex->__tm__ = get_time_tm(md_record);
+    md_record_ex->__offset__ = md_record->__offset__;
+    md_record_ex->__size__ = md_record->__size__;
+    md_record_ex->system_flag = get_system_flag(md_record);
+    md_record_ex->user_flag = get_user_flag(md_record);
+    md_record_ex->rowid = i_rowid;
+}
+
+/***************************************************************************
+ *  Call the callbacks of the realtime lists with a new appended record
+ ***************************************************************************/
+PRIVATE void feed_lists_new_record(
+    json_t *tranger,
+    json_t *topic,
+    const char *key_value,
+    json_int_t g_rowid,
+    md2_record_ex_t *md_record_ex,
+    json_t *record // not owned
+)
+{
+    json_t *lists = json_object_get(topic, "lists");
+    int idx;
+    json_t *list;
+    json_array_foreach(lists, idx, list) {
+        if(list_wants_key(list, key_value)) {
+            tranger2_load_record_callback_t load_record_callback =
+                (tranger2_load_record_callback_t)(size_t)json_integer_value(
+                    json_object_get(list, "load_record_callback")
+                );
+
+            if(load_record_callback) {
+                // Inform to the user list: record real time from memory
+                load_record_callback(
+                    tranger,
+                    topic,
+                    key_value,
+                    list,
+                    g_rowid,
+                    md_record_ex,
+                    feed_wants_only_md(list)? NULL : json_incref(record)
+                );
+            }
+        }
+    }
+}
+
+/***************************************************************************
+    Append a new item to record.
+    The 'pkey' and 'tkey' are getting according to the topic schema.
+    Return the new record's metadata.
+ ***************************************************************************/
+PUBLIC int tranger2_append_record(
+    json_t *tranger,
+    const char *topic_name,
+    uint64_t __t__,         // if 0 then the time will be set by TimeRanger with now time
+    uint16_t user_flag,
+    md2_record_ex_t *md_record_ex, // required, to return the metadata
+    json_t *record       // JSON owned
+)
+{
+    hgobj gobj = (hgobj)json_integer_value(json_object_get(tranger, "gobj"));
+
+    if(!record || record->refcount <= 0) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "Cannot append record, record NULL",
+            "topic",        "%s", topic_name,
+            NULL
+        );
+        return -1;
+    }
+
+    // TEST performance 800.000
+
+    BOOL master = json_boolean_value(json_object_get(tranger, "master"));
+    if(!master) {
+        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "Cannot append record, NO master",
+            "topic",        "%s", topic_name,
+            NULL
+        );
+        gobj_trace_json(gobj, record, "Cannot append record, NO master");
+        JSON_DECREF(record)
+        return -1;
+    }
+
+    json_t *topic = tranger2_topic(tranger, topic_name);
+    if(!topic) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "Cannot append record, topic not found",
+            "topic",        "%s", topic_name,
+            NULL
+        );
+        gobj_trace_json(gobj, record, "Cannot append record, topic not found");
+        JSON_DECREF(record)
+        return -1;
+    }
+
+    /*--------------------------------------------*
+     *  If time not specified, use the now time
+     *--------------------------------------------*/
+    system_flag2_t system_flag = json_integer_value(json_object_get(topic, "system_flag"));
+    if(!__t__) {
+        if(system_flag & (sf_t_ms)) {
+            __t__ = time_in_milliseconds();
+        } else {
+            __t__ = time_in_seconds();
+        }
+    }
+
+    /*--------------------------------------------*
+     *  Prepare new record metadata
+     *--------------------------------------------*/
+    md2_record_t md_record;
+    memset(&md_record, 0, sizeof(md2_record_t));
+    md_record.__t__ = __t__;
+
+    // TEST performance 700000
 
-        default:
-            // No pkey
-            gobj_log_error(gobj, 0,
-                "function",     "%s", __FUNCTION__,
-                "msgset",       "%s", MSGSET_JSON,
-                "msg",          "%s", "Cannot append record, no pkey type",
-                "topic",        "%s", topic_name,
-                "pkey",         "%s", pkey,
-                NULL
-            );
-            gobj_trace_json(gobj, record, "Cannot append record, no pkey type");
-            JSON_DECREF(record)
-            return -1;
+    /*-----------------------------------*
+     *  Get the primary-key
+     *-----------------------------------*/
+    system_flag2_t system_flag_key_type = system_flag & KEY_TYPE_MASK2;
+    char key_int[NAME_MAX+1];
+    const char *key_value = get_record_key_value(
+        gobj, topic, topic_name, system_flag, record, key_int, sizeof(key_int)
+    );
+    if(!key_value) {
+        // Error already logged
+        JSON_DECREF(record)
+        return -1;
     }
 
     // TEST performance 630000
@@ -2694,27 +3592,7 @@ PUBLIC int tranger2_append_record(
     /*--------------------------------------------*
      *  Get and save the t-key if exists
      *--------------------------------------------*/
-    const char *tkey = json_string_value(json_object_get(topic, "tkey"));
-    if(!empty_string(tkey)) {
-        json_t *jn_tval = json_object_get(record, tkey);
-        if(!jn_tval) {
-            md_record.__tm__ = 0; // No tkey value, mark with 0
-        } else {
-            if(json_is_string(jn_tval)) {
-                timestamp_t timestamp = approxidate(json_string_value(jn_tval));
-                if(system_flag & sf_tm_ms) {
-                    timestamp *= 1000;
-                }
-                md_record.__tm__ = timestamp;
-            } else if(json_is_integer(jn_tval)) {
-                md_record.__tm__ = json_integer_value(jn_tval);
-            } else {
-                md_record.__tm__ = 0; // No tkey value, mark with 0
-            }
-        }
-    } else {
-        md_record.__tm__ = 0;  // No tkey value, mark with 0
-    }
+    md_record.__tm__ = get_record_tm(topic, system_flag, record);
 
     // TEST performance 600000
 
@@ -2912,13 +3790,7 @@ PUBLIC int tranger2_append_record(
      *  Could be useful for records with the same __t__
      *  for example, to distinguish them by the readers.
      *-----------------------------------------------------*/
-    md_record_ex->__t__ = get_time_t(&md_record);
-    md_record_ex->__tm__ = get_time_tm(&md_record);
-    md_record_ex->__offset__ = md_record.__offset__;
-    md_record_ex->__size__ = md_record.__size__;
-    md_record_ex->system_flag = get_system_flag(&md_record);
-    md_record_ex->user_flag = get_user_flag(&md_record);
-    md_record_ex->rowid = i_rowid;
+    set_md_record_ex(md_record_ex, &md_record, i_rowid);
 
     json_t *__md_tranger__ = md2json(md_record_ex, g_rowid);
     json_object_set_new(
@@ -2928,36 +3800,411 @@ PUBLIC int tranger2_append_record(
     );
 
     /*--------------------------------------------*
-     *      FEED the lists
-     *      Call callbacks of realtime lists
+     *      FEED the lists
+     *      Call callbacks of realtime lists
+     *--------------------------------------------*/
+    feed_lists_new_record(tranger, topic, key_value, g_rowid, md_record_ex, record);
+
+    JSON_DECREF(record)
+    return 0;
+}
+
+/***************************************************************************
+ *  Item of a batch of tranger2_append_records()
+ ***************************************************************************/
+typedef struct {
+    json_t *record;         // not owned, item of the batch
+    const char *key_value;  // NULL if the record cannot be appended
+    char key_int[NAME_MAX+1];
+    char *srecord;
+    md2_record_t md_record;
+} batch_record_t;
+
+/***************************************************************************
+ *  Write a whole buffer, a short write is an error.
+ ***************************************************************************/
+PRIVATE int write_all(
+    hgobj gobj,
+    json_t *tranger,
+    json_t *topic,
+    int fd,
+    const char *bf,
+    size_t len,
+    const char *what
+)
+{
+    size_t ln = write(fd, bf, len);
+    if(ln != len) {
+        gobj_log_critical(gobj, kw_get_int(gobj, tranger, "on_critical_error", 0, KW_REQUIRED),
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_SYSTEM,
+            "msg",          "%s", what,
+            "topic",        "%s", tranger2_topic_name(topic),
+            "errno",        "%d", errno,
+            "serrno",       "%s", strerror(errno),
+            NULL
+        );
+        return -1;
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Append the records of a batch with the same key and the same file:
+ *  one write of the contents and then one write of the md2 records, so a
+ *  crash between them leaves content without metadata (never read), never
+ *  metadata pointing to content that is not there.
+ *  With `sync_contents` the contents are fdatasync'ed before the md2 write,
+ *  the same holds on a power loss.
+ *  Return the number of records appended.
+ ***************************************************************************/
+PRIVATE int append_key_group(
+    hgobj gobj,
+    json_t *tranger,
+    json_t *topic,
+    batch_record_t *items,
+    json_t *jn_group,  // not owned, list of indexes of items
+    md2_record_ex_t *md_records_ex
+)
+{
+    size_t n = json_array_size(jn_group);
+    batch_record_t *first = &items[json_integer_value(json_array_get(jn_group, 0))];
+    const char *key_value = first->key_value;
+    uint64_t __t__ = first->md_record.__t__;   // all of the group go to the file of the first
+
+    /*--------------------------------------------*
+     *  Save the contents, at the end
+     *--------------------------------------------*/
+    int content_fp = get_topic_wr_fd(gobj, tranger, topic, key_value, TRUE, __t__);
+    if(content_fp < 0) {
+        // Error already logged by get_topic_wr_fd
+        return 0;
+    }
+    off_t __offset__ = lseek(content_fp, 0, SEEK_END);
+    if(__offset__ < 0) {
+        gobj_log_critical(gobj, kw_get_int(gobj, tranger, "on_critical_error", 0, KW_REQUIRED),
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_SYSTEM,
+            "msg",          "%s", "Cannot append records, lseek() FAILED",
+            "topic",        "%s", tranger2_topic_name(topic),
+            "errno",        "%d", errno,
+            "serrno",       "%s", strerror(errno),
+            NULL
+        );
+        return 0;
+    }
+
+    size_t content_size = 0;
+    int idx; json_t *jn_idx;
+    json_array_foreach(jn_group, idx, jn_idx) {
+        batch_record_t *item = &items[json_integer_value(jn_idx)];
+        item->md_record.__offset__ = (uint64_t)__offset__ + content_size;
+        content_size += item->md_record.__size__;
+    }
+
+    char *content = GBMEM_MALLOC(content_size);
+    md2_record_t *big_endians = GBMEM_MALLOC(n * sizeof(md2_record_t));
+    if(!content || !big_endians) {
+        // Error already logged
+        GBMEM_FREE(content)
+        GBMEM_FREE(big_endians)
+        return 0;
+    }
+
+    char *p = content;
+    json_array_foreach(jn_group, idx, jn_idx) {
+        batch_record_t *item = &items[json_integer_value(jn_idx)];
+        memcpy(p, item->srecord, item->md_record.__size__); // with the final null
+        p += item->md_record.__size__;
+    }
+
+    int ret = write_all(
+        gobj, tranger, topic, content_fp, content, content_size,
+        "Cannot append records, write FAILED"
+    );
+    GBMEM_FREE(content)
+    if(ret < 0) {
+        GBMEM_FREE(big_endians)
+        return 0;
+    }
+
+    /*
+     *  The contents must be on disk before the metadata that points to them
+     */
+    if(json_is_true(json_object_get(tranger, "sync_contents")) && fdatasync(content_fp) < 0) {
+        gobj_log_critical(gobj, kw_get_int(gobj, tranger, "on_critical_error", 0, KW_REQUIRED),
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_SYSTEM,
+            "msg",          "%s", "Cannot append records, fdatasync() FAILED",
+            "topic",        "%s", tranger2_topic_name(topic),
+            "errno",        "%d", errno,
+            "serrno",       "%s", strerror(errno),
+            NULL
+        );
+        GBMEM_FREE(big_endians)
+        return 0;
+    }
+
+    /*--------------------------------------------*
+     *  Save the metadata, in big endian
+     *--------------------------------------------*/
+    int md2_fd = get_topic_wr_fd(gobj, tranger, topic, key_value, FALSE, __t__);
+    if(md2_fd < 0) {
+        // Error already logged by get_topic_wr_fd
+        GBMEM_FREE(big_endians)
+        return 0;
+    }
+    off_t offset = lseek(md2_fd, 0, SEEK_END);
+    if(offset < 0) {
+        gobj_log_critical(gobj, kw_get_int(gobj, tranger, "on_critical_error", 0, KW_REQUIRED),
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_SYSTEM,
+            "msg",          "%s", "Cannot append records, lseek() FAILED",
+            "topic",        "%s", tranger2_topic_name(topic),
+            "errno",        "%d", errno,
+            "serrno",       "%s", strerror(errno),
+            NULL
+        );
+        GBMEM_FREE(big_endians)
+        return 0;
+    }
+    json_int_t i_rowid = (json_int_t)(offset/sizeof(md2_record_t)) + 1;
+
+    json_array_foreach(jn_group, idx, jn_idx) {
+        batch_record_t *item = &items[json_integer_value(jn_idx)];
+        big_endians[idx].__t__ = htonll(item->md_record.__t__);
+        big_endians[idx].__tm__ = htonll(item->md_record.__tm__);
+        big_endians[idx].__offset__ = htonll(item->md_record.__offset__);
+        big_endians[idx].__size__ = htonll(item->md_record.__size__);
+    }
+
+    ret = write_all(
+        gobj, tranger, topic, md2_fd, (const char *)big_endians, n * sizeof(md2_record_t),
+        "Cannot save records metadata, write FAILED"
+    );
+    GBMEM_FREE(big_endians)
+    if(ret < 0) {
+        return 0;
+    }
+
+    /*--------------------------------------------*
+     *  Update cache, metadata, and feed the lists,
+     *  in the order of the batch
+     *--------------------------------------------*/
+    system_flag2_t system_flag_key_type =
+        json_integer_value(json_object_get(topic, "system_flag")) & KEY_TYPE_MASK2;
+
+    json_array_foreach(jn_group, idx, jn_idx) {
+        json_int_t i = json_integer_value(jn_idx);
+        batch_record_t *item = &items[i];
+        md2_record_ex_t *md_record_ex = &md_records_ex[i];
+
+        json_int_t g_rowid = update_new_record_from_mem(
+            gobj, tranger, topic, key_value, &item->md_record
+        );
+        if(system_flag_key_type & sf_rowid_key) {
+            if(g_rowid != i_rowid + idx) {
+                gobj_log_error(gobj, 0,
+                    "function",     "%s", __FUNCTION__,
+                    "msgset",       "%s", MSGSET_JSON,
+                    "msg",          "%s", "g_rowid != i_rowid",
+                    "topic",        "%s", tranger2_topic_name(topic),
+                    "g_rowid",      "%lu", (unsigned long) g_rowid,
+                    "i_rowid",      "%lu", (unsigned long) (i_rowid + idx),
+                    NULL
+                );
+            }
+        }
+        set_md_record_ex(md_record_ex, &item->md_record, i_rowid + idx);
+
+        json_object_set_new(
+            item->record,
+            "__md_tranger__",
+            md2json(md_record_ex, g_rowid)  // owned
+        );
+
+        feed_lists_new_record(tranger, topic, key_value, g_rowid, md_record_ex, item->record);
+    }
+
+    return (int)n;
+}
+
+/***************************************************************************
+    Append a batch of records.
+    The records are grouped by key and file, each group written with one write
+    of contents and one write of metadata.
+    Return the number of records appended, -1 on error.
+ ***************************************************************************/
+PUBLIC int tranger2_append_records(
+    json_t *tranger,
+    const char *topic_name,
+    uint64_t __t__,         // if 0 then the time will be set by TimeRanger with now time
+    uint16_t user_flag,
+    md2_record_ex_t *md_records_ex, // required, one per record, rowid 0 if not appended
+    json_t *jn_records      // JSON owned, list of records
+)
+{
+    hgobj gobj = (hgobj)json_integer_value(json_object_get(tranger, "gobj"));
+
+    if(!json_is_array(jn_records)) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "Cannot append records, not a list",
+            "topic",        "%s", topic_name,
+            NULL
+        );
+        JSON_DECREF(jn_records)
+        return -1;
+    }
+
+    BOOL master = json_boolean_value(json_object_get(tranger, "master"));
+    if(!master) {
+        gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "Cannot append records, NO master",
+            "topic",        "%s", topic_name,
+            NULL
+        );
+        JSON_DECREF(jn_records)
+        return -1;
+    }
+
+    json_t *topic = tranger2_topic(tranger, topic_name);
+    if(!topic) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "Cannot append records, topic not found",
+            "topic",        "%s", topic_name,
+            NULL
+        );
+        JSON_DECREF(jn_records)
+        return -1;
+    }
+
+    size_t n = json_array_size(jn_records);
+    if(n == 0) {
+        JSON_DECREF(jn_records)
+        return 0;
+    }
+
+    batch_record_t *items = GBMEM_MALLOC(n * sizeof(batch_record_t));
+    if(!items) {
+        // Error already logged
+        memset(md_records_ex, 0, n * sizeof(md2_record_ex_t));
+        JSON_DECREF(jn_records)
+        return -1;
+    }
+    memset(items, 0, n * sizeof(batch_record_t));
+
+    /*--------------------------------------------*
+     *  If time not specified, the __t__ of each
+     *  md_records_ex, or the now time.
+     *--------------------------------------------*/
+    system_flag2_t system_flag = json_integer_value(json_object_get(topic, "system_flag"));
+    uint64_t now_t = (system_flag & sf_t_ms)? time_in_milliseconds() : time_in_seconds();
+    size_t i; json_t *record;
+    for(i=0; i<n; i++) {
+        uint64_t t = __t__? __t__ : md_records_ex[i].__t__;
+        items[i].md_record.__t__ = t? t : now_t;
+    }
+    memset(md_records_ex, 0, n * sizeof(md2_record_ex_t));
+
+    /*--------------------------------------------*
+     *  Prepare the records and group them by key
+     *  and by file (of their __t__), keeping the
+     *  order of arrival in each group.
+     *--------------------------------------------*/
+    json_t *jn_groups = json_object();
+
+    json_array_foreach(jn_records, i, record) {
+        batch_record_t *item = &items[i];
+        item->record = record;
+
+        if(!json_is_object(record)) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PARAMETER,
+                "msg",          "%s", "Cannot append record, not a dict",
+                "topic",        "%s", topic_name,
+                NULL
+            );
+            continue;
+        }
+
+        const char *key_value = get_record_key_value(
+            gobj, topic, topic_name, system_flag, record, item->key_int, sizeof(item->key_int)
+        );
+        if(!key_value) {
+            // Error already logged
+            continue;
+        }
+
+        item->md_record.__tm__ = get_record_tm(topic, system_flag, record);
+
+        item->srecord = json_dumps(record, JSON_COMPACT|JSON_ENCODE_ANY);
+        if(!item->srecord) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_JSON,
+                "msg",          "%s", "Cannot append record, json_dumps() FAILED",
+                "topic",        "%s", topic_name,
+                NULL
+            );
+            gobj_trace_json(gobj, record, "Cannot append record, json_dumps() FAILED");
+            continue;
+        }
+        item->md_record.__size__ = strlen(item->srecord) + 1; // put the final null
+        set_user_flag(&item->md_record, user_flag);
+        set_system_flag(&item->md_record, system_flag & ~NOT_INHERITED_MASK);
+        item->key_value = key_value;
+
+        char file_id[NAME_MAX];
+        get_file_id(
+            file_id,
+            sizeof(file_id),
+            tranger,
+            topic,
+            (system_flag & sf_t_ms)? item->md_record.__t__/1000:item->md_record.__t__
+        );
+        json_t *jn_key_groups = json_object_get(jn_groups, key_value);
+        if(!jn_key_groups) {
+            jn_key_groups = json_object();
+            json_object_set_new(jn_groups, key_value, jn_key_groups);
+        }
+        json_t *jn_group = json_object_get(jn_key_groups, file_id);
+        if(!jn_group) {
+            jn_group = json_array();
+            json_object_set_new(jn_key_groups, file_id, jn_group);
+        }
+        json_array_append_new(jn_group, json_integer((json_int_t)i));
+    }
+
+    /*--------------------------------------------*
+     *  Write the groups
      *--------------------------------------------*/
-    json_t *lists = json_object_get(topic, "lists");
-    int idx;
-    json_t *list;
-    json_array_foreach(lists, idx, list) {
-        if(list_wants_key(list, key_value)) {
-            tranger2_load_record_callback_t load_record_callback =
-                (tranger2_load_record_callback_t)(size_t)json_integer_value(
-                    json_object_get(list, "load_record_callback")
-                );
-
-            if(load_record_callback) {
-                // Inform to the user list: record real time from memory
-                load_record_callback(
-                    tranger,
-                    topic,
-                    key_value,
-                    list,
-                    g_rowid,
-                    md_record_ex,
-                    feed_wants_only_md(list)? NULL : json_incref(record)
-                );
-            }
+    int appended = 0;
+    const char *key_value; json_t *jn_key_groups;
+    json_object_foreach(jn_groups, key_value, jn_key_groups) {
+        const char *file_id; json_t *jn_group;
+        json_object_foreach(jn_key_groups, file_id, jn_group) {
+            appended += append_key_group(
+                gobj, tranger, topic, items, jn_group, md_records_ex
+            );
         }
     }
 
-    JSON_DECREF(record)
-    return 0;
+    for(i=0; i<n; i++) {
+        if(items[i].srecord) {
+            jsonp_free(items[i].srecord);
+        }
+    }
+    GBMEM_FREE(items)
+    JSON_DECREF(jn_groups)
+    JSON_DECREF(jn_records)
+    return appended;
 }
 
 /***************************************************************************
@@ -3755,6 +5002,7 @@ PUBLIC int tranger2_delete_instance(
         // Already dead. Nothing to do, but not an error.
         return 0;
     }
+    content_cache_drop_record(topic, key, __t__, payload_offset);
     system_flag |= sf_deleted_instance;
     set_system_flag(&md_record, system_flag);
 
@@ -6630,9 +7878,31 @@ PUBLIC json_t *tranger2_open_iterator( // LOADING: load data from disk, APPENDIN
 
         json_int_t total_rows = get_topic_key_rows(gobj, topic, key);
 
+        /*
+         *  Forward loads walk each .md2 from start to end
+         */
+        BOOL sequential = !json_boolean_value(json_object_get(match_cond, "backward"));
+        json_t *advised_segment = NULL;
+        json_t *sought_segment = NULL;
+
         BOOL end = FALSE;
         while(!end && cur_segment >= 0) {
             json_t *segment = json_array_get(segments, cur_segment);
+            if(segment != sought_segment) {
+                /*
+                 *  Entering a segment: skip the rows out of the time range
+                 */
+                rowid = time_seek_row(gobj, tranger, topic, key, segment, match_cond, rowid);
+                sought_segment = segment;
+            }
+            if(sequential && segment != advised_segment) {
+                if(advised_segment) {
+                    advise_md2_map(gobj, tranger, topic, key, advised_segment, MADV_NORMAL);
+                }
+                advise_md2_map(gobj, tranger, topic, key, segment, MADV_SEQUENTIAL);
+                advised_segment = segment;
+            }
+
             /*
              *  Get the metadata
              */
@@ -6722,6 +7992,9 @@ PUBLIC json_t *tranger2_open_iterator( // LOADING: load data from disk, APPENDIN
                 json_object_set_new(iterator, "cur_rowid", json_integer(rowid));
             }
         }
+        if(advised_segment) {
+            advise_md2_map(gobj, tranger, topic, key, advised_segment, MADV_NORMAL);
+        }
     } else if(match_cond_selects_records(match_cond)) {
         /*-------------------------------------------------------------------*
          *  PAGING, FILTERED (no callback, no data: the caller will pull
@@ -6733,7 +8006,7 @@ PUBLIC json_t *tranger2_open_iterator( // LOADING: load data from disk, APPENDIN
          *  granularity and total_rows/pages would count records the pages
          *  never return.
          *-------------------------------------------------------------------*/
-        json_t *index = build_iterator_index(
+        rowid_index_t *index = build_iterator_index(
             gobj, tranger, topic, key, segments, match_cond
         );
         if(!index) {
@@ -6745,7 +8018,7 @@ PUBLIC json_t *tranger2_open_iterator( // LOADING: load data from disk, APPENDIN
             tranger2_close_iterator(tranger, iterator);
             return NULL;
         }
-        json_object_set_new(iterator, "index", index);
+        json_object_set_new(iterator, "index", json_integer((json_int_t)(size_t)index));
     }
 
     json_array_append_new(
@@ -6786,6 +8059,14 @@ PUBLIC int tranger2_close_iterator(
         tranger2_close_rt_disk(tranger, rt_disk);
     }
 
+    rowid_index_t *index = (rowid_index_t *)(size_t)json_integer_value(
+        json_object_get(iterator, "index")
+    );
+    if(index) {
+        rowid_index_destroy(index);
+        json_object_del(iterator, "index");
+    }
+
     json_t *topic = tranger2_topic(tranger, kw_get_str(gobj, iterator, "topic_name", "", KW_REQUIRED));
 
     json_t *iterators = kw_get_list(gobj, topic, "iterators", 0, KW_REQUIRED);
@@ -6891,6 +8172,74 @@ PRIVATE BOOL match_cond_selects_records(json_t *match_cond)
     return FALSE;
 }
 
+/***************************************************************************
+ *  Add a rowid to the index, rowids must be added in ascending order
+ ***************************************************************************/
+PRIVATE int rowid_index_append(rowid_index_t *index, json_int_t rowid)
+{
+    if(index->n_runs > 0) {
+        rowid_run_t *last = &index->runs[index->n_runs - 1];
+        if(last->first_rowid + (index->rows - last->position) == rowid) {
+            index->rows++;
+            return 0;
+        }
+    }
+
+    if(index->n_runs == index->max_runs) {
+        size_t max_runs = index->max_runs? index->max_runs * 2 : 16;
+        rowid_run_t *runs = GBMEM_REALLOC(index->runs, max_runs * sizeof(rowid_run_t));
+        if(!runs) {
+            return -1;
+        }
+        index->runs = runs;
+        index->max_runs = max_runs;
+    }
+
+    index->runs[index->n_runs].first_rowid = rowid;
+    index->runs[index->n_runs].position = index->rows;
+    index->n_runs++;
+    index->rows++;
+    return 0;
+}
+
+/***************************************************************************
+ *  Global rowid at a position (based 0) of the index, -1 if out of range
+ ***************************************************************************/
+PRIVATE json_int_t rowid_index_get(rowid_index_t *index, json_int_t position)
+{
+    if(position < 0 || position >= index->rows) {
+        return -1;
+    }
+
+    /*
+     *  Last run starting at or before position
+     */
+    size_t lo = 0;
+    size_t hi = index->n_runs;
+    while(hi - lo > 1) {
+        size_t mid = lo + (hi - lo)/2;
+        if(index->runs[mid].position <= position) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    rowid_run_t *run = &index->runs[lo];
+    return run->first_rowid + (position - run->position);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void rowid_index_destroy(rowid_index_t *index)
+{
+    if(index) {
+        GBMEM_FREE(index->runs)
+        GBMEM_FREE(index)
+    }
+}
+
 /***************************************************************************
  *  Build the row INDEX of a paging iterator: the ordered list of the global
  *  rowids that actually match match_cond.
@@ -6906,10 +8255,14 @@ PRIVATE BOOL match_cond_selects_records(json_t *match_cond)
  *  unfiltered iterator indexes nothing, keeps its zero-cost open, and its
  *  page positions ARE the global rowids.
  *
- *  Return is owned by the caller. NULL (error already logged) if the metadata
- *  cannot be read.
+ *  The index is a list of runs of consecutive rowids (rowid_index_t), not a
+ *  json array: a filter that drops a few rows of a 10M-row key keeps a few
+ *  runs instead of 10M json integers.
+ *
+ *  Return is owned by the caller, free it with rowid_index_destroy().
+ *  NULL (error already logged) if the metadata cannot be read.
  ***************************************************************************/
-PRIVATE json_t *build_iterator_index(
+PRIVATE rowid_index_t *build_iterator_index(
     hgobj gobj,
     json_t *tranger,
     json_t *topic,
@@ -6928,7 +8281,11 @@ PRIVATE json_t *build_iterator_index(
     json_object_set_new(forward_cond, "backward", json_false());
 
     json_int_t total_rows = get_topic_key_rows(gobj, topic, key);
-    json_t *index = json_array();
+    rowid_index_t *index = GBMEM_MALLOC(sizeof(rowid_index_t));
+    if(!index) {
+        JSON_DECREF(forward_cond)
+        return NULL;
+    }
     md2_record_ex_t md_record_ex;
     BOOL end = FALSE;
 
@@ -6937,23 +8294,42 @@ PRIVATE json_t *build_iterator_index(
         json_int_t first_row = json_integer_value(json_object_get(segment, "first_row"));
         json_int_t last_row = json_integer_value(json_object_get(segment, "last_row"));
 
-        for(json_int_t rowid = first_row; rowid <= last_row; rowid++) {
+        advise_md2_map(gobj, tranger, topic, key, segment, MADV_SEQUENTIAL);
+        json_int_t seek_row = time_seek_row(
+            gobj, tranger, topic, key, segment, forward_cond, first_row
+        );
+        for(json_int_t rowid = seek_row; rowid <= last_row; rowid++) {
             if(get_md_by_rowid(gobj, tranger, topic, key, segment, rowid, &md_record_ex) < 0) {
                 // Error already logged
+                advise_md2_map(gobj, tranger, topic, key, segment, MADV_NORMAL);
                 JSON_DECREF(forward_cond)
-                JSON_DECREF(index)
+                rowid_index_destroy(index);
                 return NULL;
             }
             if(is_deleted_instance(&md_record_ex)) {
                 continue;
             }
             if(tranger2_match_metadata(forward_cond, total_rows, rowid, &md_record_ex, &end)) {
-                json_array_append_new(index, json_integer(rowid));
+                if(rowid_index_append(index, rowid)<0) {
+                    gobj_log_error(gobj, 0,
+                        "function",     "%s", __FUNCTION__,
+                        "msgset",       "%s", MSGSET_MEMORY,
+                        "msg",          "%s", "No memory for the iterator index",
+                        "topic",        "%s", tranger2_topic_name(topic),
+                        "key",          "%s", key,
+                        NULL
+                    );
+                    advise_md2_map(gobj, tranger, topic, key, segment, MADV_NORMAL);
+                    JSON_DECREF(forward_cond)
+                    rowid_index_destroy(index);
+                    return NULL;
+                }
             }
             if(end) {
                 break;
             }
         }
+        advise_md2_map(gobj, tranger, topic, key, segment, MADV_NORMAL);
         if(end) {
             break;
         }
@@ -6991,9 +8367,11 @@ PUBLIC size_t tranger2_iterator_size(
     json_t *iterator
 )
 {
-    json_t *index = json_object_get(iterator, "index");
+    rowid_index_t *index = (rowid_index_t *)(size_t)json_integer_value(
+        json_object_get(iterator, "index")
+    );
     if(index) {
-        return json_array_size(index);
+        return (size_t)index->rows;
     }
 
     size_t rows = 0;
@@ -7051,9 +8429,11 @@ PUBLIC json_t *tranger2_iterator_get_page( // return must be owned
      *  and keeps the original meaning (positions ARE global rowids) — nothing
      *  is filtered out, so the two coincide.
      */
-    json_t *index = json_object_get(iterator, "index");
+    rowid_index_t *index = (rowid_index_t *)(size_t)json_integer_value(
+        json_object_get(iterator, "index")
+    );
     if(index) {
-        json_int_t indexed_rows = (json_int_t)json_array_size(index);
+        json_int_t indexed_rows = index->rows;
         json_int_t indexed_pages = (limit > 0)? (indexed_rows / (json_int_t)limit) : 0;
         if(limit > 0 && (indexed_rows % (json_int_t)limit) != 0) {
             indexed_pages++;
@@ -7069,7 +8449,7 @@ PUBLIC json_t *tranger2_iterator_get_page( // return must be owned
                 if(pos < 0 || pos >= indexed_rows) {
                     break;
                 }
-                json_int_t rowid = json_integer_value(json_array_get(index, pos));
+                json_int_t rowid = rowid_index_get(index, pos);
                 json_t *segment = segment_of_rowid(segments, rowid);
                 if(!segment) {
                     gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
@@ -8409,10 +9789,6 @@ PRIVATE int read_md(
     md2_record_ex_t *md_record_ex
 )
 {
-    /*
-     *  TODO Find in the cache the range md
-     */
-
     /*
      *  Check parameters
      */
@@ -8433,7 +9809,27 @@ PRIVATE int read_md(
     md2_record_t md_record;
 
     /*
-     *  Get file handler
+     *  Read it from the mapping of the .md2 file
+     */
+    md2_map_t *md2_map = get_md2_map(
+        gobj,
+        tranger,
+        topic,
+        key,
+        file_id,
+        (size_t)rowid * sizeof(md2_record_t)
+    );
+    if(md2_map) {
+        memcpy(
+            &md_record,
+            md2_map->base + (rowid - 1) * sizeof(md2_record_t),
+            sizeof(md2_record_t)
+        );
+        return md2_record_to_ex(&md_record, rowid, md_record_ex);
+    }
+
+    /*
+     *  Not mapped: get file handler
      */
     int fd = get_topic_rd_fd(
         gobj,
@@ -8485,21 +9881,264 @@ PRIVATE int read_md(
         return -1;
     }
 
-    md_record.__t__ = ntohll(md_record.__t__);
-    md_record.__tm__ = ntohll(md_record.__tm__);
-    md_record.__offset__ = ntohll(md_record.__offset__);
-    md_record.__size__ = ntohll(md_record.__size__);
+    return md2_record_to_ex(&md_record, rowid, md_record_ex);
+}
+
+/***************************************************************************
+ *  Decode a md2 record as read from disk (big-endian)
+ ***************************************************************************/
+PRIVATE int md2_record_to_ex(
+    md2_record_t *md_record,
+    uint64_t rowid, // relative to 1
+    md2_record_ex_t *md_record_ex
+)
+{
+    md_record->__t__ = ntohll(md_record->__t__);
+    md_record->__tm__ = ntohll(md_record->__tm__);
+    md_record->__offset__ = ntohll(md_record->__offset__);
+    md_record->__size__ = ntohll(md_record->__size__);
 
-    md_record_ex->__t__ = get_time_t(&md_record);
-    md_record_ex->__tm__ = get_time_tm(&md_record);
-    md_record_ex->__offset__ = md_record.__offset__;
-    md_record_ex->__size__ = md_record.__size__;
-    md_record_ex->system_flag = get_system_flag(&md_record);
-    md_record_ex->user_flag = get_user_flag(&md_record);
+    md_record_ex->__t__ = get_time_t(md_record);
+    md_record_ex->__tm__ = get_time_tm(md_record);
+    md_record_ex->__offset__ = md_record->__offset__;
+    md_record_ex->__size__ = md_record->__size__;
+    md_record_ex->system_flag = get_system_flag(md_record);
+    md_record_ex->user_flag = get_user_flag(md_record);
     md_record_ex->rowid = rowid;
     return 0;
 }
 
+/***************************************************************************
+ *  Content cache of the topic, created on first use
+ ***************************************************************************/
+PRIVATE content_cache_t *get_content_cache(json_t *topic, BOOL create)
+{
+    content_cache_t *cache = (content_cache_t *)(size_t)json_integer_value(
+        json_object_get(topic, "content_cache")
+    );
+    if(!cache && create) {
+        cache = GBMEM_MALLOC(sizeof(content_cache_t));
+        if(!cache) {
+            return NULL;
+        }
+        dl_init(&cache->dl_lru, 0);
+        cache->jn_items = json_object();
+        cache->max_size = DEFAULT_CONTENT_CACHE_SIZE;
+        json_object_set_new(topic, "content_cache", json_integer((json_int_t)(size_t)cache));
+    }
+    return cache;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void content_cache_free_item(content_cache_t *cache, content_cache_item_t *item)
+{
+    json_object_del(cache->jn_items, item->id);
+    dl_delete(&cache->dl_lru, item, 0);
+    cache->size -= item->size;
+    JSON_DECREF(item->record)
+    GBMEM_FREE(item->id)
+    GBMEM_FREE(item)
+}
+
+/***************************************************************************
+ *  Evict the least recently used records until the cache fits in max_size
+ ***************************************************************************/
+PRIVATE void content_cache_trim(content_cache_t *cache)
+{
+    content_cache_item_t *item;
+    while(cache->size > cache->max_size && (item = dl_first(&cache->dl_lru))) {
+        content_cache_free_item(cache, item);
+        cache->evictions++;
+    }
+}
+
+/***************************************************************************
+ *  Drop the records of a key, or all if key is empty
+ ***************************************************************************/
+PRIVATE void content_cache_drop(json_t *topic, const char *key)
+{
+    content_cache_t *cache = get_content_cache(topic, FALSE);
+    if(!cache) {
+        return;
+    }
+    size_t ln = empty_string(key)? 0 : strlen(key);
+
+    content_cache_item_t *item = dl_first(&cache->dl_lru);
+    while(item) {
+        content_cache_item_t *next = dl_next(item);
+        if(!ln || (strncmp(item->id, key, ln)==0 && item->id[ln]=='`')) {
+            content_cache_free_item(cache, item);
+        }
+        item = next;
+    }
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void content_cache_drop_record(
+    json_t *topic,
+    const char *key,
+    uint64_t __t__,
+    uint64_t __offset__
+)
+{
+    content_cache_t *cache = get_content_cache(topic, FALSE);
+    if(!cache) {
+        return;
+    }
+    char id[NAME_MAX*2];
+    snprintf(id, sizeof(id), "%s`%"PRIu64"`%"PRIu64, key, __t__, __offset__);
+
+    content_cache_item_t *item = (content_cache_item_t *)(size_t)json_integer_value(
+        json_object_get(cache->jn_items, id)
+    );
+    if(item) {
+        content_cache_free_item(cache, item);
+    }
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void content_cache_destroy(json_t *topic)
+{
+    content_cache_t *cache = get_content_cache(topic, FALSE);
+    if(!cache) {
+        return;
+    }
+    content_cache_drop(topic, "");
+    JSON_DECREF(cache->jn_items)
+    GBMEM_FREE(cache)
+    json_object_del(topic, "content_cache");
+}
+
+/***************************************************************************
+ *  Read record content through the LRU content cache of the topic.
+ *  For lists opened with "lazy": they load only the metadata
+ *  and read the content when it's needed.
+ ***************************************************************************/
+PUBLIC json_t *tranger2_read_record_cached( // return is yours, but shared with the cache: don't modify it
+    json_t *tranger,
+    json_t *topic,
+    const char *key,
+    md2_record_ex_t *md_record_ex
+)
+{
+    if(!topic || empty_string(key) || !md_record_ex) {
+        // Let tranger2_read_record_content() log the error
+        return tranger2_read_record_content(tranger, topic, key, md_record_ex);
+    }
+
+    content_cache_t *cache = get_content_cache(topic, TRUE);
+    if(!cache) {
+        return tranger2_read_record_content(tranger, topic, key, md_record_ex);
+    }
+
+    char id[NAME_MAX*2];
+    snprintf(id, sizeof(id), "%s`%"PRIu64"`%"PRIu64,
+        key, md_record_ex->__t__, md_record_ex->__offset__
+    );
+
+    content_cache_item_t *item = (content_cache_item_t *)(size_t)json_integer_value(
+        json_object_get(cache->jn_items, id)
+    );
+    if(item) {
+        /*
+         *  Hit: move it to the most recently used end
+         */
+        cache->hits++;
+        dl_delete(&cache->dl_lru, item, 0);
+        dl_add(&cache->dl_lru, item);
+        return json_incref(item->record);
+    }
+
+    cache->misses++;
+    json_t *record = tranger2_read_record_content(tranger, topic, key, md_record_ex);
+    if(!record) {
+        return NULL;
+    }
+
+    size_t size = (size_t)md_record_ex->__size__;
+    if(size > cache->max_size) {
+        return record;  // too big to cache
+    }
+
+    item = GBMEM_MALLOC(sizeof(content_cache_item_t));
+    if(!item) {
+        return record;
+    }
+    item->id = gbmem_strdup(id);
+    item->record = json_incref(record);
+    item->size = size;
+    dl_add(&cache->dl_lru, item);
+    json_object_set_new(cache->jn_items, id, json_integer((json_int_t)(size_t)item));
+    cache->size += size;
+
+    content_cache_trim(cache);
+
+    return record;
+}
+
+/***************************************************************************
+ *  Set the memory budget of the content cache of a topic
+ ***************************************************************************/
+PUBLIC int tranger2_set_content_cache_size(
+    json_t *tranger,
+    const char *topic_name,
+    size_t max_size
+)
+{
+    json_t *topic = tranger2_topic(tranger, topic_name);
+    if(!topic) {
+        // Error already logged
+        return -1;
+    }
+    content_cache_t *cache = get_content_cache(topic, TRUE);
+    if(!cache) {
+        return -1;
+    }
+    cache->max_size = max_size;
+    content_cache_trim(cache);
+    return 0;
+}
+
+/***************************************************************************
+ *  Stats of the content cache of a topic
+ ***************************************************************************/
+PUBLIC json_t *tranger2_content_cache_stats( // return is yours
+    json_t *tranger,
+    const char *topic_name
+)
+{
+    json_t *topic = tranger2_topic(tranger, topic_name);
+    if(!topic) {
+        // Error already logged
+        return NULL;
+    }
+    content_cache_t *cache = get_content_cache(topic, FALSE);
+    if(!cache) {
+        return json_pack("{s:I, s:I, s:I, s:I, s:I, s:I}",
+            "records", (json_int_t)0,
+            "size", (json_int_t)0,
+            "max_size", (json_int_t)DEFAULT_CONTENT_CACHE_SIZE,
+            "hits", (json_int_t)0,
+            "misses", (json_int_t)0,
+            "evictions", (json_int_t)0
+        );
+    }
+    return json_pack("{s:I, s:I, s:I, s:I, s:I, s:I}",
+        "records", (json_int_t)cache->dl_lru.__itemsInContainer__,
+        "size", (json_int_t)cache->size,
+        "max_size", (json_int_t)cache->max_size,
+        "hits", (json_int_t)cache->hits,
+        "misses", (json_int_t)cache->misses,
+        "evictions", (json_int_t)cache->evictions
+    );
+}
+
 /***************************************************************************
  *  Read record data
  *
@@ -8844,13 +10483,35 @@ PUBLIC json_t *tranger2_open_list( // WARNING loading all records causes delay i
         realtime = TRUE;
     }
 
+    /*
+     *  Lazy list: the disk load delivers only the metadata (record NULL),
+     *  the callback reads the content when it needs it with tranger2_read_record_cached().
+     *  The realtime feed keeps delivering the full records, they are in hand anyway.
+     */
+    json_t *disk_match_cond = json_incref(match_cond);
+    if(kw_get_bool(gobj, match_cond, "lazy", 0, KW_WILD_NUMBER)) {
+        json_decref(disk_match_cond);
+        disk_match_cond = json_copy(match_cond);
+        json_object_set_new(disk_match_cond, "only_md", json_true());
+
+        json_int_t lazy_cache_size = kw_get_int(
+            gobj, match_cond, "lazy_cache_size", 0, KW_WILD_NUMBER
+        );
+        if(lazy_cache_size > 0) {
+            content_cache_t *cache = get_content_cache(topic, TRUE);
+            if(cache && (size_t)lazy_cache_size > cache->max_size) {
+                cache->max_size = (size_t)lazy_cache_size;
+            }
+        }
+    }
+
     const char *key = kw_get_str(gobj, match_cond, "key", "", 0);
     if(!empty_string(key)) {
         json_t *ll = tranger2_open_iterator(
             tranger,
             topic_name,
             key,
-            json_incref(match_cond),  // match_cond, owned
+            json_incref(disk_match_cond),  // match_cond, owned
             load_record_callback, // called on LOADING and APPENDING
             "",     // iterator id
             "",     // creator
@@ -8875,6 +10536,7 @@ PUBLIC json_t *tranger2_open_list( // WARNING loading all records causes delay i
         if(!empty_string(rkey)) {
             re = rkey_compile(gobj, rkey);
             if(!re) {
+                JSON_DECREF(disk_match_cond)
                 JSON_DECREF(match_cond)     // Error already logged
                 JSON_DECREF(extra)
                 return NULL;
@@ -8888,6 +10550,7 @@ PUBLIC json_t *tranger2_open_list( // WARNING loading all records causes delay i
                     "msg",          "%s", "pcre2_match_data_create_from_pattern() FAILED",
                     NULL
                 );
+                JSON_DECREF(disk_match_cond)
                 JSON_DECREF(match_cond)
                 JSON_DECREF(extra)
                 return NULL;
@@ -8918,7 +10581,7 @@ PUBLIC json_t *tranger2_open_list( // WARNING loading all records causes delay i
                     tranger,
                     topic_name,
                     key_,
-                    json_incref(match_cond),  // match_cond, owned
+                    json_incref(disk_match_cond),  // match_cond, owned
                     load_record_callback, // called on LOADING and APPENDING
                     "",     // iterator id
                     "",     // creator
@@ -8936,6 +10599,7 @@ PUBLIC json_t *tranger2_open_list( // WARNING loading all records causes delay i
             pcre2_code_free(re);
         }
     }
+    JSON_DECREF(disk_match_cond)
 
     /*-------------------------------*
      *  Open realtime for list
@@ -183,6 +183,7 @@ static const json_desc_t tranger2_json_desc[] = {
 // Volatil fields
 {"on_critical_error",   "int",  "2",        ""}, // Volatil, default LOG_OPT_EXIT_ZERO (Zero to avoid restart)
 {"master",              "bool", "false",    ""}, // Volatil, the master is the only that can write.
+{"sync_contents",       "bool", "false",    ""}, // Volatil, fdatasync() the contents of a batch append before its md2
 {"gobj",                "int",  "",         ""}, // Volatil, gobj of tranger
 {"trace_level",         "int",  "0",        ""}, // Volatil, trace level
 
@@ -530,6 +531,32 @@ PUBLIC int tranger2_append_record(
     json_t *jn_record       // JSON owned
 );
 
+/*
+    Append a batch of records to a topic, MASTER-ONLY. Same rules per record as
+    tranger2_append_record(), but the records are grouped by key and file (in
+    order of arrival within each group) and every group is written with ONE
+    write of the contents and ONE write of the md2 records, so a crash never
+    leaves metadata pointing to unwritten content. With `sync_contents` in the
+    tranger, the contents are fdatasync()'ed before the md2 write, the same
+    holds on a power loss.
+    All records get `__t__`; if it's 0, each record gets the `__t__` of its
+    `md_records_ex` (set by the caller, 0 is the now time).
+    `md_records_ex` is required, with room for one md per record of
+    `jn_records`, in the same order; the md of a record not appended has rowid 0.
+    `jn_records` (a list of dicts) is owned; each appended record gets
+    its `__md_tranger__` and feeds the realtime lists like a single append.
+    Return: number of records appended, -1 on error (not a list, not master,
+    topic not found).
+*/
+PUBLIC int tranger2_append_records(
+    json_t *tranger,
+    const char *topic_name,
+    uint64_t __t__,         // if 0 then the time will be set by TimeRanger with now time
+    uint16_t user_flag,
+    md2_record_ex_t *md_records_ex, // required, one per record: in __t__ if __t__ is 0, out the md, rowid 0 if not appended
+    json_t *jn_records      // JSON owned, list of records
+);
+
 /*
     Delete a whole record (= primary key) from a topic.
     Removes the `keys/<key>/` directory and every instance it
@@ -943,6 +970,12 @@ PUBLIC json_t *tranger2_get_rt_disk_by_id( // Silence inside. Check out.
         load_record_callback (tranger2_load_record_callback_t) REQUIRED
                             passed inside match_cond, not as a C argument.
                             Called on both LOADING (disk) and APPENDING (realtime).
+        lazy                (bool) the disk load passes only the metadata to the
+                            callback (record NULL, as with only_md); the callback
+                            reads the content on demand with tranger2_read_record_cached().
+                            The realtime feed still passes the full records.
+        lazy_cache_size     (int) raise the content cache budget of the topic
+                            to this size in bytes (default 16 MB).
 
     For the first-level match_cond (backward, from/to_rowid|t|tm, user_flag, ...) see:
 
@@ -1016,6 +1049,40 @@ PUBLIC json_t *tranger2_read_record_content( // return is yours
     md2_record_ex_t *md_record_ex
 );
 
+/*
+ *  Same as tranger2_read_record_content() but through the LRU content cache
+ *  of the topic, bounded by its byte budget (sum of __size__ on disk).
+ *  Meant for lists opened with "lazy". The returned record is shared with the
+ *  cache: decref it when done, but DON'T modify it.
+ *  The cached records of a key are dropped when its files are closed,
+ *  a deleted instance is dropped by tranger2_delete_instance().
+ */
+PUBLIC json_t *tranger2_read_record_cached( // return is yours, but shared with the cache: don't modify it
+    json_t *tranger,
+    json_t *topic,
+    const char *key,
+    md2_record_ex_t *md_record_ex
+);
+
+/*
+ *  Set the byte budget of the content cache of a topic (default 16 MB),
+ *  evicting the least recently used records if needed.
+ */
+PUBLIC int tranger2_set_content_cache_size(
+    json_t *tranger,
+    const char *topic_name,
+    size_t max_size
+);
+
+/*
+ *  Stats of the content cache of a topic:
+ *      {records, size, max_size, hits, misses, evictions}
+ */
+PUBLIC json_t *tranger2_content_cache_stats( // return is yours
+    json_t *tranger,
+    const char *topic_name
+);
+
 /*
  *  Format record metadata into caller buffer `bf` (bfsize):
  *    print_md0_record:      rowid, t, tm, key
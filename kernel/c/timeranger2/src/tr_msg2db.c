@@ -34,7 +34,8 @@
 PRIVATE json_t *record2tranger(
     json_t *tranger,
     const char *topic_name,
-    json_t *kw,  // not owned
+    json_t *cols,   // not owned
+    json_t *kw,     // not owned
     const char *options
 );
 PRIVATE json_t *md2json(
@@ -442,6 +443,11 @@ PUBLIC int msg2db_close_db(
 {
     hgobj gobj = (hgobj)json_integer_value(json_object_get(tranger, "gobj"));
 
+    /*------------------------------*
+     *  Write the pending messages
+     *------------------------------*/
+    msg2db_flush(tranger, msg2db_name);
+
     /*------------------------------*
      *  Close msg2db lists
      *------------------------------*/
@@ -461,7 +467,8 @@ PUBLIC int msg2db_close_db(
 
     const char *topic_name; json_t *topic_records;
     json_object_foreach(msg2db, topic_name, topic_records) {
-        if(strcmp(topic_name, "__schema_version__")==0) {
+        if(strcmp(topic_name, "__schema_version__")==0 ||
+                strcmp(topic_name, "__buffer__")==0) {
             continue;
         }
 
@@ -770,13 +777,11 @@ PRIVATE int set_volatil_field_value(
 }
 
 /***************************************************************************
- *
+ *  Return the topic's cols as dict, MUST be decref. NULL (logged) if none.
  ***************************************************************************/
-PRIVATE int _set_volatil_values(
+PRIVATE json_t *get_topic_cols(
     json_t *tranger,
-    const char *topic_name,
-    json_t *record,  // not owned
-    json_t *kw // not owned
+    const char *topic_name
 )
 {
     hgobj gobj = (hgobj)json_integer_value(json_object_get(tranger, "gobj"));
@@ -790,8 +795,21 @@ PRIVATE int _set_volatil_values(
             "topic_name",   "%s", topic_name,
             NULL
         );
-        return 0;
     }
+    return cols;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int _set_volatil_values(
+    json_t *tranger,
+    json_t *cols,    // not owned
+    json_t *record,  // not owned
+    json_t *kw // not owned
+)
+{
+    hgobj gobj = (hgobj)json_integer_value(json_object_get(tranger, "gobj"));
 
     const char *field; json_t *col;
     json_object_foreach(cols, field, col) {
@@ -828,7 +846,6 @@ PRIVATE int _set_volatil_values(
         );
     }
 
-    JSON_DECREF(cols)
     return 0;
 }
 
@@ -838,23 +855,13 @@ PRIVATE int _set_volatil_values(
 PRIVATE json_t *record2tranger(
     json_t *tranger,
     const char *topic_name,
-    json_t *kw,  // not owned
+    json_t *cols,   // not owned
+    json_t *kw,     // not owned
     const char *options // "permissive"
 )
 {
     hgobj gobj = (hgobj)json_integer_value(json_object_get(tranger, "gobj"));
 
-    json_t *cols = tranger2_dict_topic_desc_cols(tranger, topic_name);
-    if(!cols) {
-        gobj_log_error(gobj, 0,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_MSG2DB,
-            "msg",          "%s", "Topic without cols",
-            "topic_name",   "%s", topic_name,
-            NULL
-        );
-        return 0;
-    }
     json_t *new_record = json_object();
 
     const char *field; json_t *col;
@@ -869,7 +876,6 @@ PRIVATE json_t *record2tranger(
             )<0) {
             // Error already logged
             JSON_DECREF(new_record)
-            JSON_DECREF(cols)
             return 0;
         }
     }
@@ -879,7 +885,6 @@ PRIVATE json_t *record2tranger(
     }
     json_object_del(new_record, "__md_msg2db__");
 
-    JSON_DECREF(cols)
     return new_record;
 }
 
@@ -1018,12 +1023,16 @@ PRIVATE int load_record_callback(
         /*--------------------------------------------*
          *  Set volatil data
         *--------------------------------------------*/
-        _set_volatil_values(
-            tranger,
-            topic_name,
-            jn_record,  // not owned
-            jn_record // not owned
-        );
+        json_t *cols = get_topic_cols(tranger, topic_name);
+        if(cols) {
+            _set_volatil_values(
+                tranger,
+                cols,       // not owned
+                jn_record,  // not owned
+                jn_record // not owned
+            );
+            JSON_DECREF(cols)
+        }
 
         /*-------------------------------*
          *  Write node
@@ -1047,40 +1056,21 @@ PRIVATE int load_record_callback(
 }
 
 /***************************************************************************
- *
+ *  Validate a message and build its tranger record.
+ *  The id is created in kw if the id col is "uuid".
+ *  Return the new record, NULL (error logged) if the message is refused.
  ***************************************************************************/
-PUBLIC json_t *msg2db_append_message( // Return is NOT YOURS
+PRIVATE json_t *message2record(
     json_t *tranger,
-    const char *msg2db_name,
+    const char *path,
     const char *topic_name,
-    json_t *kw,    // owned
+    const char *pkey2_col,
+    json_t *cols,   // not owned
+    json_t *kw,     // not owned
     const char *options // "permissive"
 )
 {
     hgobj gobj = (hgobj)json_integer_value(json_object_get(tranger, "gobj"));
-    /*-------------------------------*
-     *      Get indexx
-     *-------------------------------*/
-    char path[NAME_MAX];
-    build_msg2db_index_path(path, sizeof(path), msg2db_name, topic_name, "id");
-    json_t *indexx = kw_get_dict(gobj,
-        tranger,
-        path,
-        0,
-        KW_REQUIRED
-    );
-    if(!indexx) {
-        gobj_log_error(gobj, 0,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_MSG2DB,
-            "msg",          "%s", "Msg2Db Topic indexx NOT FOUND",
-            "path",         "%s", path,
-            "topic_name",   "%s", topic_name,
-            NULL
-        );
-        JSON_DECREF(kw)
-        return 0;
-    }
 
     /*-------------------------------*
      *  Get the id, it's mandatory
@@ -1108,7 +1098,6 @@ PUBLIC json_t *msg2db_append_message( // Return is NOT YOURS
                 "kw",           "%j", kw,
                 NULL
             );
-            JSON_DECREF(kw)
             return 0;
         }
     }
@@ -1129,16 +1118,12 @@ PUBLIC json_t *msg2db_append_message( // Return is NOT YOURS
             "id",           "%s", id,
             NULL
         );
-        JSON_DECREF(kw)
         return 0;
     }
 
     /*-----------------------------------*
      *  Get the pkey2, it's mandatory
      *-----------------------------------*/
-    json_t *topic = tranger2_topic(tranger, topic_name);
-    const char *pkey2_col = kw_get_str(gobj, topic, "pkey2", 0, 0);
-
     /*
      *  The VALUE, not just the key.
      *
@@ -1163,21 +1148,306 @@ PUBLIC json_t *msg2db_append_message( // Return is NOT YOURS
             "kw",           "%j", kw,
             NULL
         );
-        JSON_DECREF(kw)
         return 0;
     }
-    const char *pkey2_value = kw_get_str(gobj, kw, pkey2_col, 0, 0);
 
     /*----------------------------------------*
      *  Create the tranger record to create
      *----------------------------------------*/
-    json_t *record = record2tranger(tranger, topic_name, kw, options);
+    return record2tranger(tranger, topic_name, cols, kw, options);
+}
+
+/***************************************************************************
+ *  Put a written record in the index, with its volatil data and metadata
+ ***************************************************************************/
+PRIVATE void index_message(
+    json_t *tranger,
+    const char *msg2db_name,
+    const char *topic_name,
+    const char *pkey2_col,
+    json_t *indexx,     // not owned
+    json_t *cols,       // not owned
+    md2_record_ex_t *md_record,
+    json_t *record,     // owned
+    json_t *kw          // not owned
+)
+{
+    hgobj gobj = (hgobj)json_integer_value(json_object_get(tranger, "gobj"));
+
+    /*--------------------------------------------*
+     *  Set volatil data
+     *--------------------------------------------*/
+    _set_volatil_values(
+        tranger,
+        cols,    // not owned
+        record,  // not owned
+        kw // not owned
+    );
+
+    /*--------------------------------------------*
+     *  Build metadata, creating node in memory
+     *--------------------------------------------*/
+    json_t *jn_record_md = md2json(
+        msg2db_name,
+        topic_name,
+        md_record
+    );
+    json_object_set_new(jn_record_md, "pkey2", json_string(pkey2_col));
+    json_object_set_new(record, "__md_msg2db__", jn_record_md);
+
+    /*-------------------------------*
+     *  Write node
+     *-------------------------------*/
+    kw_set_subdict_value(
+        gobj,
+        indexx,
+        kw_get_str(gobj, kw, "id", "", 0),
+        kw_get_str(gobj, kw, pkey2_col, "", 0),
+        record
+    );
+}
+
+/***************************************************************************
+ *  Write a batch of records of a topic with one grouped tranger append,
+ *  and index the written ones.
+ *  Return the number of messages written, -1 on error.
+ ***************************************************************************/
+PRIVATE int write_messages(
+    json_t *tranger,
+    const char *msg2db_name,
+    const char *topic_name,
+    json_t *records,    // owned
+    json_t *kws,        // owned, the messages of the records
+    json_t *ts          // owned, the __t__ of the records, NULL: the now time
+)
+{
+    hgobj gobj = (hgobj)json_integer_value(json_object_get(tranger, "gobj"));
+
+    size_t n = json_array_size(records);
+    if(n == 0) {
+        JSON_DECREF(records)
+        JSON_DECREF(kws)
+        JSON_DECREF(ts)
+        return 0;
+    }
+
+    char path[NAME_MAX];
+    build_msg2db_index_path(path, sizeof(path), msg2db_name, topic_name, "id");
+    json_t *indexx = kw_get_dict(gobj, tranger, path, 0, KW_REQUIRED);
+    json_t *topic = tranger2_topic(tranger, topic_name);
+    const char *pkey2_col = kw_get_str(gobj, topic, "pkey2", 0, 0);
+    json_t *cols = get_topic_cols(tranger, topic_name);
+    md2_record_ex_t *md_records = GBMEM_MALLOC(n * sizeof(md2_record_ex_t));
+    if(!indexx || !cols || !md_records) {
+        // Error already logged
+        GBMEM_FREE(md_records)
+        JSON_DECREF(cols)
+        JSON_DECREF(records)
+        JSON_DECREF(kws)
+        JSON_DECREF(ts)
+        return -1;
+    }
+
+    /*
+     *  The __t__ of each record, the time when it was appended, not the flush time
+     */
+    for(size_t i=0; i<n; i++) {
+        md_records[i].__t__ = (uint64_t)json_integer_value(json_array_get(ts, i));
+    }
+    JSON_DECREF(ts)
+
+    JSON_INCREF(records)
+    int ret = tranger2_append_records(
+        tranger,
+        topic_name,
+        0, // __t__,         // if 0 the __t__ of each md_records, 0 the now time
+        0, // user_flag,
+        md_records,
+        records // owned
+    );
+
+    if(ret > 0) {
+        size_t idx; json_t *record;
+        json_array_foreach(records, idx, record) {
+            if(md_records[idx].rowid == 0) {
+                // Not written, error already logged
+                continue;
+            }
+            index_message(
+                tranger,
+                msg2db_name,
+                topic_name,
+                pkey2_col,
+                indexx,
+                cols,
+                &md_records[idx],
+                json_incref(record),
+                json_array_get(kws, idx)
+            );
+        }
+    }
+
+    GBMEM_FREE(md_records)
+    JSON_DECREF(cols)
+    JSON_DECREF(records)
+    JSON_DECREF(kws)
+    return ret;
+}
+
+/***************************************************************************
+ *  Buffered mode: is it time to flush the pending messages?
+ ***************************************************************************/
+PRIVATE BOOL buffer_must_flush(json_t *buffer)
+{
+    json_int_t pending = json_integer_value(json_object_get(buffer, "pending"));
+    if(pending <= 0) {
+        return FALSE;
+    }
+    if(pending >= json_integer_value(json_object_get(buffer, "max_messages"))) {
+        return TRUE;
+    }
+    json_int_t flush_interval = json_integer_value(json_object_get(buffer, "flush_interval"));
+    json_int_t first_t = json_integer_value(json_object_get(buffer, "first_t"));
+    if(flush_interval > 0 &&
+            (json_int_t)time_in_milliseconds_monotonic() - first_t >= flush_interval) {
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/***************************************************************************
+ *  Buffered mode: queue a validated message, to be written at the flush
+ *  with the __t__ of now.
+ ***************************************************************************/
+PRIVATE void buffer_message(
+    json_t *tranger,
+    json_t *buffer,
+    const char *topic_name,
+    json_t *record, // owned
+    json_t *kw      // owned
+)
+{
+    json_t *topics = json_object_get(buffer, "topics");
+    json_t *queue = json_object_get(topics, topic_name);
+    if(!queue) {
+        queue = json_pack("{s:[], s:[], s:[]}", "records", "kws", "ts");
+        json_object_set_new(topics, topic_name, queue);
+    }
+    json_t *topic = tranger2_topic(tranger, topic_name);
+    system_flag2_t system_flag = json_integer_value(json_object_get(topic, "system_flag"));
+    uint64_t __t__ = (system_flag & sf_t_ms)? time_in_milliseconds() : time_in_seconds();
+
+    json_array_append_new(json_object_get(queue, "records"), record);
+    json_array_append_new(json_object_get(queue, "kws"), kw);
+    json_array_append_new(json_object_get(queue, "ts"), json_integer((json_int_t)__t__));
+
+    json_int_t pending = json_integer_value(json_object_get(buffer, "pending"));
+    if(pending == 0) {
+        json_object_set_new(buffer, "first_t", json_integer((json_int_t)time_in_milliseconds_monotonic()));
+    }
+    json_object_set_new(buffer, "pending", json_integer(pending + 1));
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE json_t *get_msg2db_buffer(
+    json_t *tranger,
+    const char *msg2db_name
+)
+{
+    json_t *msg2db = json_object_get(json_object_get(tranger, "msg2dbs"), msg2db_name);
+    return json_object_get(msg2db, "__buffer__");
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC json_t *msg2db_append_message( // Return is NOT YOURS
+    json_t *tranger,
+    const char *msg2db_name,
+    const char *topic_name,
+    json_t *kw,    // owned
+    const char *options // "permissive"
+)
+{
+    hgobj gobj = (hgobj)json_integer_value(json_object_get(tranger, "gobj"));
+    /*-------------------------------*
+     *      Get indexx
+     *-------------------------------*/
+    char path[NAME_MAX];
+    build_msg2db_index_path(path, sizeof(path), msg2db_name, topic_name, "id");
+    json_t *indexx = kw_get_dict(gobj,
+        tranger,
+        path,
+        0,
+        KW_REQUIRED
+    );
+    if(!indexx) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MSG2DB,
+            "msg",          "%s", "Msg2Db Topic indexx NOT FOUND",
+            "path",         "%s", path,
+            "topic_name",   "%s", topic_name,
+            NULL
+        );
+        JSON_DECREF(kw)
+        return 0;
+    }
+
+    json_t *topic = tranger2_topic(tranger, topic_name);
+    const char *pkey2_col = kw_get_str(gobj, topic, "pkey2", 0, 0);
+    json_t *cols = get_topic_cols(tranger, topic_name);
+    if(!cols) {
+        // Error already logged
+        JSON_DECREF(kw)
+        return 0;
+    }
+
+    json_t *record = message2record(tranger, path, topic_name, pkey2_col, cols, kw, options);
     if(!record) {
         // Error already logged
+        JSON_DECREF(cols)
         JSON_DECREF(kw)
         return 0;
     }
 
+    /*-------------------------------*
+     *  Buffered mode
+     *-------------------------------*/
+    json_t *buffer = get_msg2db_buffer(tranger, msg2db_name);
+    if(buffer) {
+        JSON_DECREF(cols)
+        if(buffer_must_flush(buffer)) {
+            msg2db_flush(tranger, msg2db_name);
+        }
+        buffer_message(tranger, buffer, topic_name, record, kw);
+        if(!buffer_must_flush(buffer)) {
+            /*
+             *  Queued, indexed at the flush. The record is owned by the buffer
+             *  and freed by the flush: don't return it, it would dangle.
+             */
+            return 0;
+        }
+
+        /*
+         *  The flush drops the record if it cannot be written,
+         *  return what the index has.
+         */
+        JSON_INCREF(kw)
+        msg2db_flush(tranger, msg2db_name);
+        record = kw_get_subdict_value(gobj,
+            indexx,
+            kw_get_str(gobj, kw, "id", "", 0),
+            kw_get_str(gobj, kw, pkey2_col, "", 0),
+            0,
+            0
+        );
+        JSON_DECREF(kw)
+        return record;
+    }
+
     /*-------------------------------*
      *  Write to tranger
      *-------------------------------*/
@@ -1193,45 +1463,217 @@ PUBLIC json_t *msg2db_append_message( // Return is NOT YOURS
     );
     if(ret < 0) {
         // Error already logged
+        JSON_DECREF(cols)
         JSON_DECREF(kw)
         JSON_DECREF(record)
         return 0;
     }
 
-    /*--------------------------------------------*
-     *  Set volatil data
-     *--------------------------------------------*/
-    _set_volatil_values(
+    index_message(
         tranger,
-        topic_name,
-        record,  // not owned
-        kw // not owned
-    );
-
-    /*--------------------------------------------*
-     *  Build metadata, creating node in memory
-     *--------------------------------------------*/
-    json_t *jn_record_md = md2json(
         msg2db_name,
         topic_name,
-        &md_record
+        pkey2_col,
+        indexx,
+        cols,
+        &md_record,
+        record, // owned
+        kw
     );
-    json_object_set_new(jn_record_md, "pkey2", json_string(pkey2_col));
-    json_object_set_new(record, "__md_msg2db__", jn_record_md);
 
+    JSON_DECREF(cols)
+    JSON_DECREF(kw)
+    return record;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC int msg2db_append_messages(
+    json_t *tranger,
+    const char *msg2db_name,
+    const char *topic_name,
+    json_t *kw_list,    // owned
+    const char *options // "permissive"
+)
+{
+    hgobj gobj = (hgobj)json_integer_value(json_object_get(tranger, "gobj"));
     /*-------------------------------*
-     *  Write node
+     *      Get indexx
      *-------------------------------*/
-    kw_set_subdict_value(
-        gobj,
-        indexx,
-        id,
-        pkey2_value,
-        record
+    char path[NAME_MAX];
+    build_msg2db_index_path(path, sizeof(path), msg2db_name, topic_name, "id");
+    json_t *indexx = kw_get_dict(gobj,
+        tranger,
+        path,
+        0,
+        KW_REQUIRED
     );
+    if(!indexx) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MSG2DB,
+            "msg",          "%s", "Msg2Db Topic indexx NOT FOUND",
+            "path",         "%s", path,
+            "topic_name",   "%s", topic_name,
+            NULL
+        );
+        JSON_DECREF(kw_list)
+        return -1;
+    }
+    if(!json_is_array(kw_list)) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MSG2DB,
+            "msg",          "%s", "kw_list must be a list",
+            "path",         "%s", path,
+            "topic_name",   "%s", topic_name,
+            NULL
+        );
+        JSON_DECREF(kw_list)
+        return -1;
+    }
 
-    JSON_DECREF(kw)
-    return record;
+    json_t *topic = tranger2_topic(tranger, topic_name);
+    const char *pkey2_col = kw_get_str(gobj, topic, "pkey2", 0, 0);
+    json_t *cols = get_topic_cols(tranger, topic_name);
+    if(!cols) {
+        // Error already logged
+        JSON_DECREF(kw_list)
+        return -1;
+    }
+
+    json_t *buffer = get_msg2db_buffer(tranger, msg2db_name);
+    json_t *records = json_array();
+    json_t *kws = json_array();
+    int queued = 0;
+
+    size_t idx; json_t *kw;
+    json_array_foreach(kw_list, idx, kw) {
+        json_t *record = message2record(tranger, path, topic_name, pkey2_col, cols, kw, options);
+        if(!record) {
+            // Error already logged
+            continue;
+        }
+        if(buffer) {
+            if(buffer_must_flush(buffer)) {
+                msg2db_flush(tranger, msg2db_name);
+            }
+            buffer_message(tranger, buffer, topic_name, record, json_incref(kw));
+            queued++;
+        } else {
+            json_array_append_new(records, record);
+            json_array_append(kws, kw);
+        }
+    }
+
+    JSON_DECREF(cols)
+    JSON_DECREF(kw_list)
+
+    if(buffer) {
+        JSON_DECREF(records)
+        JSON_DECREF(kws)
+        if(buffer_must_flush(buffer)) {
+            msg2db_flush(tranger, msg2db_name);
+        }
+        return queued;
+    }
+
+    /*-------------------------------*
+     *  Write to tranger, grouped
+     *-------------------------------*/
+    return write_messages(tranger, msg2db_name, topic_name, records, kws, NULL);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC int msg2db_set_buffering(
+    json_t *tranger,
+    const char *msg2db_name,
+    int max_messages,   // 0 disables the buffered mode, the pending messages are flushed
+    int flush_interval  // in milliseconds, 0 no flush by time
+)
+{
+    hgobj gobj = (hgobj)json_integer_value(json_object_get(tranger, "gobj"));
+
+    json_t *msg2db = json_object_get(json_object_get(tranger, "msg2dbs"), msg2db_name);
+    if(!msg2db) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MSG2DB,
+            "msg",          "%s", "Msg2db not found",
+            "msg2db_name",  "%s", msg2db_name,
+            NULL
+        );
+        return -1;
+    }
+
+    if(max_messages <= 0) {
+        msg2db_flush(tranger, msg2db_name);
+        json_object_del(msg2db, "__buffer__");
+        return 0;
+    }
+
+    json_t *buffer = json_object_get(msg2db, "__buffer__");
+    if(!buffer) {
+        buffer = json_pack("{s:I, s:I, s:{}}",
+            "pending", (json_int_t)0,
+            "first_t", (json_int_t)0,
+            "topics"
+        );
+        json_object_set_new(msg2db, "__buffer__", buffer);
+    }
+    json_object_set_new(buffer, "max_messages", json_integer(max_messages));
+    json_object_set_new(buffer, "flush_interval", json_integer(flush_interval));
+
+    if(buffer_must_flush(buffer)) {
+        msg2db_flush(tranger, msg2db_name);
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC int msg2db_flush(
+    json_t *tranger,
+    const char *msg2db_name
+)
+{
+    json_t *buffer = get_msg2db_buffer(tranger, msg2db_name);
+    if(!buffer || json_integer_value(json_object_get(buffer, "pending")) == 0) {
+        return 0;
+    }
+
+    /*
+     *  Detach the queues before writing:
+     *  the index callbacks can append new messages.
+     */
+    json_t *topics = json_object_get(buffer, "topics");
+    JSON_INCREF(topics)
+    json_object_set_new(buffer, "topics", json_object());
+    json_object_set_new(buffer, "pending", json_integer(0));
+    json_object_set_new(buffer, "first_t", json_integer(0));
+
+    int written = 0;
+    const char *topic_name; json_t *queue;
+    json_object_foreach(topics, topic_name, queue) {
+        int ret = write_messages(
+            tranger,
+            msg2db_name,
+            topic_name,
+            json_incref(json_object_get(queue, "records")),
+            json_incref(json_object_get(queue, "kws")),
+            json_incref(json_object_get(queue, "ts"))
+        );
+        if(ret > 0) {
+            written += ret;
+        }
+    }
+
+    JSON_DECREF(topics)
+    return written;
 }
 
 /***************************************************************************
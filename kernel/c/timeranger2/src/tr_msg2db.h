@@ -83,6 +83,58 @@ PUBLIC json_t *msg2db_append_message( // Return is NOT YOURS
     const char *options // "permissive"
 );
 
+/**rst**
+    Append a batch of messages of a topic.
+    Each message is validated like in msg2db_append_message(), the refused
+    ones are logged and skipped. The accepted ones are written with ONE
+    grouped append (tranger2_append_records()) and put in the index.
+    Return the number of messages written (or queued in buffered mode),
+    -1 on error.
+**rst**/
+PUBLIC int msg2db_append_messages(
+    json_t *tranger,
+    const char *msg2db_name,
+    const char *topic_name,
+    json_t *kw_list,    // owned
+    const char *options // "permissive"
+);
+
+/**rst**
+    Buffered mode (write-ahead buffer in memory).
+
+    With max_messages > 0 the appended messages are validated and queued,
+    and written per topic with one grouped append when:
+        - the buffer has max_messages,
+        - the oldest queued message is older than flush_interval
+          (milliseconds, checked at the next append; 0 = no time limit),
+        - msg2db_flush() is called (use it in your timer),
+        - the db is closed.
+    max_messages = 0 flushes and goes back to direct writes.
+
+    In buffered mode msg2db_append_message() returns NULL when the message
+    is only queued (the queue owns it until the flush), and the indexed
+    record when the append triggered the flush. Use msg2db_get_message()
+    after msg2db_flush() to get a queued one. The queued messages are not
+    seen by msg2db_list_messages()/msg2db_get_message(), and are LOST if the
+    process dies before the flush: don't ack what has not been flushed.
+    The contents of a flush are always written before their metadata.
+**rst**/
+PUBLIC int msg2db_set_buffering(
+    json_t *tranger,
+    const char *msg2db_name,
+    int max_messages,   // 0 disables the buffered mode, the pending messages are flushed
+    int flush_interval  // in milliseconds, 0 no flush by time
+);
+
+/**rst**
+    Write the pending messages of the buffered mode.
+    Return the number of messages written.
+**rst**/
+PUBLIC int msg2db_flush(
+    json_t *tranger,
+    const char *msg2db_name
+);
+
 PUBLIC json_t *msg2db_list_messages( // Return MUST be decref
     json_t *tranger,
     const char *msg2db_name,
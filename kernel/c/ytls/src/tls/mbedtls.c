@@ -173,7 +173,9 @@ PRIVATE api_tls_t api_tls = {
     set_trace,
     flush,
     shutdown_sskt,
-    set_peer_name
+    set_peer_name,
+    0,  // ktls_tx_capable, no kTLS
+    0   // enable_ktls_tx
 };
 
 /***************************************************************
@@ -77,7 +77,15 @@ socket write of encrypted data.
 #include <openssl/bn.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
+#include <openssl/kdf.h>
 #include <time.h>
+#include <errno.h>
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+#include <linux/tls.h>
+#endif
 
 #include <kwid.h>
 #include <helpers.h>
@@ -87,6 +95,15 @@ socket write of encrypted data.
 /***************************************************************
  *              Constants
  ***************************************************************/
+#if defined(__linux__) && defined(TLS_TX) && defined(TLS_1_3_VERSION)
+    #define YTLS_HAVE_KTLS
+    #ifndef TCP_ULP
+        #define TCP_ULP 31
+    #endif
+    #ifndef SOL_TLS
+        #define SOL_TLS 282
+    #endif
+#endif
 
 /***************************************************************
  *              Structures
@@ -98,6 +115,7 @@ typedef struct ytls_s {
     BOOL trace_tls;
     size_t rx_buffer_size;
     char ssl_server_name[256]; // Server name for SNI (client-side TLS only)
+    BOOL ktls;              // "ktls": offload the tx encryption to the kernel (TLS1.3)
     hgobj gobj;
 } ytls_t;
 
@@ -117,6 +135,9 @@ typedef struct sskt_s {
     BOOL *alive; // Points to stack var in flush_clear_data; set to FALSE when freed mid-callback
     char peername[64]; // Set by the transport via set_peer_name(), for self-contained logs ("" if unset)
     char sockname[64];
+    BOOL ktls_tx;           // The kernel encrypts the tx records, write clear data to the socket
+    unsigned char ktls_secret[EVP_MAX_MD_SIZE]; // Our tx traffic secret, until kTLS is set
+    size_t ktls_secret_len;
 } sskt_t;
 
 /***************************************************************
@@ -153,6 +174,8 @@ PRIVATE const char *last_error(hsskt sskt);
 PRIVATE void set_trace(hsskt sskt, BOOL set);
 PRIVATE int flush(hsskt sskt);
 PRIVATE void set_peer_name(hsskt sskt, const char *peername, const char *sockname);
+PRIVATE BOOL ktls_tx_capable(hsskt sskt);
+PRIVATE int enable_ktls_tx(hsskt sskt, int fd);
 
 PRIVATE api_tls_t api_tls = {
     "OPENSSL",
@@ -170,7 +193,9 @@ PRIVATE api_tls_t api_tls = {
     set_trace,
     flush,
     shutdown_sskt,
-    set_peer_name
+    set_peer_name,
+    ktls_tx_capable,
+    enable_ktls_tx
 };
 
 /***************************************************************************
@@ -702,6 +727,67 @@ PRIVATE SSL_CTX *build_ssl_ctx(
     return ctx;
 }
 
+#ifdef YTLS_HAVE_KTLS
+/***************************************************************************
+ *  Keylog callback, used only to catch our TLS1.3 tx traffic secret,
+ *  needed to give the record keys to the kernel (kTLS).
+ *  Line format: "<LABEL> <client_random hex> <secret hex>"
+ ***************************************************************************/
+PRIVATE void ktls_keylog_cb(const SSL *ssl, const char *line)
+{
+    sskt_t *sskt = SSL_get_app_data(ssl);
+    if(!sskt) {
+        return;
+    }
+    const char *label = sskt->ytls->server?
+        "SERVER_TRAFFIC_SECRET_0 " : "CLIENT_TRAFFIC_SECRET_0 ";
+    size_t label_len = strlen(label);
+    if(strncmp(line, label, label_len)!=0) {
+        return;
+    }
+    const char *hex = strchr(line + label_len, ' ');
+    if(!hex) {
+        return;
+    }
+    hex++;
+    size_t hex_len = strlen(hex);
+    if(hex_len == 0 || hex_len/2 > sizeof(sskt->ktls_secret)) {
+        return;
+    }
+    size_t len = 0;
+    hex2bin((char *)sskt->ktls_secret, sizeof(sskt->ktls_secret), hex, hex_len, &len);
+    sskt->ktls_secret_len = len;
+}
+#endif
+
+/***************************************************************************
+ *  Prepare the ctx for kTLS
+ ***************************************************************************/
+PRIVATE void setup_ktls_ctx(ytls_t *ytls, SSL_CTX *ctx)
+{
+    if(!ytls->ktls) {
+        return;
+    }
+#ifdef YTLS_HAVE_KTLS
+    SSL_CTX_set_keylog_callback(ctx, ktls_keylog_cb);
+    if(ytls->server) {
+        /*
+         *  TLS1.3 session tickets are sent after the handshake with the application
+         *  keys: the kernel would start with a wrong record sequence. No tickets.
+         */
+        SSL_CTX_set_num_tickets(ctx, 0);
+    }
+#else
+    gobj_log_warning(ytls->gobj, 0,
+        "function",         "%s", __FUNCTION__,
+        "msgset",           "%s", MSGSET_OPENSSL,
+        "msg",              "%s", "kTLS not available in this build, using user space TLS",
+        "ssl_server_name",  "%s", ytls->ssl_server_name,
+        NULL
+    );
+#endif
+}
+
 /***************************************************************************
  *
  ***************************************************************************/
@@ -734,6 +820,7 @@ PRIVATE hytls init(
     snprintf(ytls->ssl_server_name, sizeof(ytls->ssl_server_name), "%s",
         kw_get_str(gobj, jn_config, "ssl_server_name", "", 0)
     );
+    ytls->ktls = kw_get_bool(gobj, jn_config, "ktls", 0, KW_WILD_NUMBER);
 
     if(ytls->trace_tls) {
         gobj_log_debug(gobj, 0,
@@ -753,6 +840,7 @@ PRIVATE hytls init(
         GBMEM_FREE(ytls)
         return 0;
     }
+    setup_ktls_ctx(ytls, ytls->ctx);
 
     return (hytls)ytls;
 }
@@ -786,6 +874,7 @@ PRIVATE int reload_certificates(hytls ytls_, json_t *jn_config)
         );
         return -1;
     }
+    setup_ktls_ctx(ytls, new_ctx);
 
     SSL_CTX *old_ctx = ytls->ctx;
     ytls->ctx = new_ctx;
@@ -954,6 +1043,7 @@ PRIVATE hsskt new_secure_filter(
         GBMEM_FREE(sskt)
         return 0;
     }
+    SSL_set_app_data(sskt->ssl, sskt);
 
     if(ytls->trace_tls) {
         SSL_set_msg_callback(sskt->ssl, ssl_tls_trace);
@@ -1059,6 +1149,7 @@ PRIVATE void free_secure_filter(hsskt sskt_)
     }
 
     SSL_free(sskt->ssl);   /* free the SSL object and its BIO's */
+    OPENSSL_cleanse(sskt->ktls_secret, sizeof(sskt->ktls_secret));
     GBMEM_FREE(sskt)
 }
 
@@ -1243,6 +1334,15 @@ PRIVATE int flush_encrypted_data(sskt_t *sskt)
     that the application should retry the operation later.
     */
 
+    if(sskt->ktls_tx) {
+        /*
+         *  The kernel owns the tx records, what OpenSSL writes now (close_notify)
+         *  would go with a wrong key/sequence. Drop it.
+         */
+        (void)BIO_reset(sskt->wbio);
+        return 0;
+    }
+
     int pending;
     while((pending = BIO_pending(sskt->wbio))>0) {
         gbuffer_t *gbuf = gbuffer_create(pending, pending);
@@ -1295,6 +1395,17 @@ PRIVATE int encrypt_data(
         GBUFFER_DECREF(gbuf)
         return -1;
     }
+    if(sskt->ktls_tx) {
+        gobj_log_error(gobj, 0,
+            "function",         "%s", __FUNCTION__,
+            "msgset",           "%s", MSGSET_INTERNAL,
+            "msg",              "%s", "kTLS tx active, clear data must be written to the socket",
+            "ssl_server_name",  "%s", sskt->ytls->ssl_server_name,
+            NULL
+        );
+        GBUFFER_DECREF(gbuf)
+        return -1;
+    }
 
     size_t len;
     while(sskt->ssl && (len = gbuffer_chunk(gbuf))>0) {
@@ -1480,6 +1591,25 @@ PRIVATE int decrypt_data(
                 GBUFFER_DECREF(gbuf)
                 return ret;
             }
+            if(sskt->ktls_tx && BIO_pending(sskt->wbio)>0) {
+                /*
+                 *  OpenSSL has to answer (peer KeyUpdate requesting ours, alert),
+                 *  but the tx keys are in the kernel: the connection can't go on.
+                 */
+                snprintf(sskt->last_error, sizeof(sskt->last_error), "%s",
+                    "kTLS: OpenSSL needs to write a record"
+                );
+                gobj_log_error(gobj, 0,
+                    "function",         "%s", __FUNCTION__,
+                    "msgset",           "%s", MSGSET_OPENSSL,
+                    "msg",              "%s", "kTLS tx active but OpenSSL needs to write a record (KeyUpdate?)",
+                    "peername",         "%s", sskt->peername,
+                    "ssl_server_name",  "%s", sskt->ytls->ssl_server_name,
+                    NULL
+                );
+                GBUFFER_DECREF(gbuf)
+                return -1111; // Mark as TLS error
+            }
         }
     }
     GBUFFER_DECREF(gbuf)
@@ -1512,6 +1642,228 @@ PRIVATE int flush(hsskt sskt)
     return 0;
 }
 
+#ifdef YTLS_HAVE_KTLS
+/***************************************************************************
+ *  HKDF-Expand-Label of TLS1.3 (RFC 8446 7.1), empty context
+ ***************************************************************************/
+PRIVATE int hkdf_expand_label(
+    const EVP_MD *md,
+    const unsigned char *secret,
+    size_t secret_len,
+    const char *label,
+    unsigned char *out,
+    size_t out_len
+)
+{
+    unsigned char info[2 + 1 + 6 + 32 + 1];
+    size_t label_len = strlen(label);
+    if(label_len > 32) {
+        return -1;
+    }
+    size_t n = 0;
+    info[n++] = (unsigned char)(out_len >> 8);
+    info[n++] = (unsigned char)(out_len & 0xFF);
+    info[n++] = (unsigned char)(6 + label_len);
+    memcpy(info + n, "tls13 ", 6);
+    n += 6;
+    memcpy(info + n, label, label_len);
+    n += label_len;
+    info[n++] = 0; // context
+
+    EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, NULL);
+    int ok = pctx &&
+        EVP_PKEY_derive_init(pctx) > 0 &&
+        EVP_PKEY_CTX_set_hkdf_mode(pctx, EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) > 0 &&
+        EVP_PKEY_CTX_set_hkdf_md(pctx, md) > 0 &&
+        EVP_PKEY_CTX_set1_hkdf_key(pctx, secret, (int)secret_len) > 0 &&
+        EVP_PKEY_CTX_add1_hkdf_info(pctx, info, (int)n) > 0 &&
+        EVP_PKEY_derive(pctx, out, &out_len) > 0;
+    EVP_PKEY_CTX_free(pctx);
+    return ok? 0:-1;
+}
+
+/***************************************************************************
+ *  Kernel cipher of the negotiated suite, 0 if not supported
+ ***************************************************************************/
+PRIVATE int ktls_cipher(sskt_t *sskt, size_t *key_len, const EVP_MD **md)
+{
+    const SSL_CIPHER *cipher = SSL_get_current_cipher(sskt->ssl);
+    if(!cipher) {
+        return 0;
+    }
+    switch(SSL_CIPHER_get_protocol_id(cipher)) {
+        case 0x1301: // TLS_AES_128_GCM_SHA256
+            *key_len = TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+            *md = EVP_sha256();
+            return TLS_CIPHER_AES_GCM_128;
+        case 0x1302: // TLS_AES_256_GCM_SHA384
+            *key_len = TLS_CIPHER_AES_GCM_256_KEY_SIZE;
+            *md = EVP_sha384();
+            return TLS_CIPHER_AES_GCM_256;
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+        case 0x1303: // TLS_CHACHA20_POLY1305_SHA256
+            *key_len = TLS_CIPHER_CHACHA20_POLY1305_KEY_SIZE;
+            *md = EVP_sha256();
+            return TLS_CIPHER_CHACHA20_POLY1305;
+#endif
+        default:
+            return 0;
+    }
+}
+#endif
+
+/***************************************************************************
+ *  Can the tx encryption of this connection go to the kernel?
+ *  Only TLS1.3, after the handshake, with a kernel supported cipher.
+ ***************************************************************************/
+PRIVATE BOOL ktls_tx_capable(hsskt sskt_)
+{
+#ifdef YTLS_HAVE_KTLS
+    sskt_t *sskt = sskt_;
+    size_t key_len;
+    const EVP_MD *md;
+
+    if(!sskt->ytls->ktls || sskt->ktls_tx || sskt->ktls_secret_len == 0) {
+        return FALSE;
+    }
+    if(!SSL_is_init_finished(sskt->ssl) || SSL_version(sskt->ssl) != TLS1_3_VERSION) {
+        return FALSE;
+    }
+    return ktls_cipher(sskt, &key_len, &md)? TRUE:FALSE;
+#else
+    return FALSE;
+#endif
+}
+
+/***************************************************************************
+ *  Give the tx keys to the kernel: from now on the clear data is written
+ *  directly to the socket (write, sendfile) and the kernel encrypts it.
+ *  The caller must have written all the encrypted data (handshake) before,
+ *  and nothing can be encrypted by OpenSSL meanwhile: the record sequence starts at 0.
+ *  Return 1 if kTLS tx is active, 0 if not (user space TLS goes on).
+ ***************************************************************************/
+PRIVATE int enable_ktls_tx(hsskt sskt_, int fd)
+{
+#ifdef YTLS_HAVE_KTLS
+    sskt_t *sskt = sskt_;
+    hgobj gobj = sskt->ytls->gobj;
+    size_t key_len = 0;
+    const EVP_MD *md = NULL;
+    unsigned char key[32];
+    unsigned char iv[12];
+    int ret = 0;
+
+    if(!ktls_tx_capable(sskt)) {
+        return 0;
+    }
+    int cipher_type = ktls_cipher(sskt, &key_len, &md);
+
+    if(hkdf_expand_label(md, sskt->ktls_secret, sskt->ktls_secret_len, "key", key, key_len)<0 ||
+       hkdf_expand_label(md, sskt->ktls_secret, sskt->ktls_secret_len, "iv", iv, sizeof(iv))<0) {
+        gobj_log_error(gobj, 0,
+            "function",         "%s", __FUNCTION__,
+            "msgset",           "%s", MSGSET_OPENSSL,
+            "msg",              "%s", "kTLS: cannot derive the traffic keys",
+            "ssl_server_name",  "%s", sskt->ytls->ssl_server_name,
+            NULL
+        );
+        goto end;
+    }
+
+    if(setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) < 0) {
+        /*
+         *  ENOENT: tls module not loaded
+         */
+        gobj_log_warning(gobj, 0,
+            "function",         "%s", __FUNCTION__,
+            "msgset",           "%s", MSGSET_OPENSSL,
+            "msg",              "%s", "kTLS: setsockopt(TCP_ULP) FAILED, using user space TLS",
+            "errno",            "%d", errno,
+            "serrno",           "%s", strerror(errno),
+            "peername",         "%s", sskt->peername,
+            NULL
+        );
+        goto end;
+    }
+
+    union {
+        struct tls12_crypto_info_aes_gcm_128 aes128;
+        struct tls12_crypto_info_aes_gcm_256 aes256;
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+        struct tls12_crypto_info_chacha20_poly1305 chacha;
+#endif
+    } ci;
+    size_t ci_len = 0;
+    memset(&ci, 0, sizeof(ci));
+
+    switch(cipher_type) {
+        case TLS_CIPHER_AES_GCM_128:
+            ci.aes128.info.version = TLS_1_3_VERSION;
+            ci.aes128.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+            memcpy(ci.aes128.key, key, TLS_CIPHER_AES_GCM_128_KEY_SIZE);
+            memcpy(ci.aes128.salt, iv, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+            memcpy(ci.aes128.iv, iv + TLS_CIPHER_AES_GCM_128_SALT_SIZE, TLS_CIPHER_AES_GCM_128_IV_SIZE);
+            ci_len = sizeof(ci.aes128);
+            break;
+        case TLS_CIPHER_AES_GCM_256:
+            ci.aes256.info.version = TLS_1_3_VERSION;
+            ci.aes256.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+            memcpy(ci.aes256.key, key, TLS_CIPHER_AES_GCM_256_KEY_SIZE);
+            memcpy(ci.aes256.salt, iv, TLS_CIPHER_AES_GCM_256_SALT_SIZE);
+            memcpy(ci.aes256.iv, iv + TLS_CIPHER_AES_GCM_256_SALT_SIZE, TLS_CIPHER_AES_GCM_256_IV_SIZE);
+            ci_len = sizeof(ci.aes256);
+            break;
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+        case TLS_CIPHER_CHACHA20_POLY1305:
+            ci.chacha.info.version = TLS_1_3_VERSION;
+            ci.chacha.info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+            memcpy(ci.chacha.key, key, TLS_CIPHER_CHACHA20_POLY1305_KEY_SIZE);
+            memcpy(ci.chacha.iv, iv, TLS_CIPHER_CHACHA20_POLY1305_IV_SIZE);
+            ci_len = sizeof(ci.chacha);
+            break;
+#endif
+    }
+
+    if(setsockopt(fd, SOL_TLS, TLS_TX, &ci, (socklen_t)ci_len) < 0) {
+        /*
+         *  Without TLS_TX the tls ulp passes the data through, user space TLS goes on
+         */
+        gobj_log_warning(gobj, 0,
+            "function",         "%s", __FUNCTION__,
+            "msgset",           "%s", MSGSET_OPENSSL,
+            "msg",              "%s", "kTLS: setsockopt(TLS_TX) FAILED, using user space TLS",
+            "errno",            "%d", errno,
+            "serrno",           "%s", strerror(errno),
+            "cipher",           "%s", SSL_get_cipher_name(sskt->ssl),
+            "peername",         "%s", sskt->peername,
+            NULL
+        );
+        OPENSSL_cleanse(&ci, sizeof(ci));
+        goto end;
+    }
+    OPENSSL_cleanse(&ci, sizeof(ci));
+
+    sskt->ktls_tx = TRUE;
+    ret = 1;
+
+    if(sskt->ytls->trace_tls) {
+        gobj_trace_msg(gobj, "------- kTLS tx enabled, cipher %s, userp %p",
+            SSL_get_cipher_name(sskt->ssl),
+            sskt->user_data
+        );
+    }
+
+end:
+    OPENSSL_cleanse(key, sizeof(key));
+    OPENSSL_cleanse(iv, sizeof(iv));
+    OPENSSL_cleanse(sskt->ktls_secret, sizeof(sskt->ktls_secret));
+    sskt->ktls_secret_len = 0;
+    return ret;
+#else
+    return 0;
+#endif
+}
+
 
 
 
@@ -287,3 +287,27 @@ PUBLIC int ytls_flush(hytls ytls, hsskt sskt)
     api_tls_t *api_tls = ((__ytls_t__ *)ytls)->api_tls;
     return api_tls->flush(sskt);
 }
+
+/***************************************************************************
+    Can the tx encryption go to the kernel?
+ ***************************************************************************/
+PUBLIC BOOL ytls_ktls_tx_capable(hytls ytls, hsskt sskt)
+{
+    api_tls_t *api_tls = ((__ytls_t__ *)ytls)->api_tls;
+    if(!api_tls->ktls_tx_capable) {
+        return FALSE;
+    }
+    return api_tls->ktls_tx_capable(sskt);
+}
+
+/***************************************************************************
+    Offload the tx encryption to the kernel
+ ***************************************************************************/
+PUBLIC int ytls_enable_ktls_tx(hytls ytls, hsskt sskt, int fd)
+{
+    api_tls_t *api_tls = ((__ytls_t__ *)ytls)->api_tls;
+    if(!api_tls->enable_ktls_tx) {
+        return 0;
+    }
+    return api_tls->enable_ktls_tx(sskt, fd);
+}
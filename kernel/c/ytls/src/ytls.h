@@ -64,6 +64,7 @@ typedef void * hsskt;
  *              - "rx_buffer_size"              int, default 32*1024
  *              - "ssl_trusted_certificate"     str
  *              - "ssl_verify_depth"            int, default 2
+ *              - "ktls"                        bool, default false (kernel TLS tx, TLS1.3 only)
  *
  *          Fields for library "mbedtls"
  *              - "trace"                       bool
@@ -113,6 +114,8 @@ typedef struct api_tls_s {
     int (*flush)(hsskt sskt); // flush clear and encrypted data
     void (*shutdown)(hsskt sskt);
     void (*set_peer_name)(hsskt sskt, const char *peername, const char *sockname);
+    BOOL (*ktls_tx_capable)(hsskt sskt);        // NULL if the backend has no kTLS
+    int (*enable_ktls_tx)(hsskt sskt, int fd);  // return 1 kernel encrypts tx, 0 user space TLS
 } api_tls_t;
 
 typedef struct { // Common to all ytls_t types
@@ -137,6 +140,11 @@ typedef struct { // Common to all ytls_t types
         ssl_verify_depth        (integer, default:2)
         ssl_ciphers             (string, default: "HIGH:!aNULL:!kRSA:!PSK:!SRP:!MD5:!RC4")
         rx_buffer_size          (integer, default: 32*1024)
+        ktls                    (boolean, default: false)
+            Offload the tx encryption to the kernel (TCP_ULP "tls") after
+            a TLS1.3 handshake with AES-GCM or ChaCha20-Poly1305: the
+            transport then writes clear data, and files go with sendfile().
+            Server side disables the TLS1.3 session tickets.
 
 **rst**/
 PUBLIC hytls ytls_init(
@@ -268,6 +276,23 @@ PUBLIC void ytls_set_peer_name(hytls ytls, hsskt sskt, const char *peername, con
 **rst**/
 PUBLIC int ytls_flush(hytls ytls, hsskt sskt);
 
+/**rst**
+    TRUE if the tx encryption of this (handshaked) connection can be
+    offloaded to the kernel with ytls_enable_ktls_tx().
+**rst**/
+PUBLIC BOOL ytls_ktls_tx_capable(hytls ytls, hsskt sskt);
+
+/**rst**
+    Offload the tx encryption of the connection to the kernel (kTLS).
+    All the encrypted data (handshake) must be written to fd before,
+    and nothing encrypted with ytls_encrypt_data() meanwhile.
+    Return 1 if the kernel encrypts now: write clear data to fd,
+    don't use ytls_encrypt_data() anymore. Return 0 if not possible,
+    the user space TLS goes on.
+    The rx side is not affected, keep using ytls_decrypt_data().
+**rst**/
+PUBLIC int ytls_enable_ktls_tx(hytls ytls, hsskt sskt, int fd);
+
 /**rst**
     Locate a readable system CA bundle file, portable across Linux distros
     (Debian/Ubuntu, RHEL/Rocky/Alma/Fedora, SUSE, Alpine). Returns a static
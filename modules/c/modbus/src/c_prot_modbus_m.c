@@ -187,11 +187,6 @@ enum {
 
 #pragma pack(1)
 
-/*
-    Tabla de control: 4 * uint8_t[0xFFFF+1]     -> 262144
-    Tabla de datos:   2 * uint16_t[0xFFFF+1]    -> 262144
-    Total por nodo slave: 524288 bytes (1/2 mega)
-*/
 typedef struct { /* 1 word: 2 bytes */
     struct {
         uint16_t bit_value: 1;  // Valor para las variables bit (nos cabe en la palabra de control)
@@ -199,24 +194,53 @@ typedef struct { /* 1 word: 2 bytes */
         uint16_t compound_value: 1;
         uint16_t to_write: 1;
 
-        uint16_t free2: 3;
+        uint16_t has_value: 1;  // A value has been received, to detect changes from then
+        uint16_t free2: 2;
         uint16_t value_busy: 1;     // Si la celda (bit o word) está ocupada. Tamaño celdas: 0xFFFF
     } control;
     uint16_t input_register;
     uint16_t holding_register;
 } cell_control_t;
 
+#pragma pack()
+
+/*
+    Cells of a slave: by object type, the address space 0x0000-0xFFFF in pages
+    of 256 cells, allocated only for the pages with mapped cells.
+    Each page has a bitmap of the cells changed since the last publish.
+        Page:   256 * 6 bytes + 32 bytes of bitmap  -> 1568
+        Index:  4 * 256 pointers                    -> 8K (64 bits)
+*/
+#define CELLS_PAGE_BITS     8
+#define CELLS_PER_PAGE      (1 << CELLS_PAGE_BITS)
+#define CELLS_PAGES         ((0xFFFF+1) >> CELLS_PAGE_BITS)
+#define CELLS_TYPES         4
+
 typedef struct {
-//cell_control_t control[4][0xFFFF+1];    // 0x00000 control coil
-//                                        // 0x10000 control discrete input
-//                                        // 0x20000 control input register
-//                                        // 0x30000 control holding register
-//uint16_t input_register[0xFFFF+1];      // 0x40000 data input register
-//uint16_t holding_register[0xFFFF+0];    // 0x60000 data holding register HACK last addr to slave_id
-    json_t *x_control;
+    cell_control_t cells[CELLS_PER_PAGE];
+    uint64_t changed[CELLS_PER_PAGE/64];
+} cells_page_t;
+
+/*
+    Conversion variable of a slave, the cells it's made of
+*/
+typedef struct {
+    json_t *jn_variable;    // not owned
+    uint8_t object_type;
+    uint16_t address;
+    uint16_t n_cells;
+} conversion_t;
+
+typedef struct {
+    cells_page_t *pages[CELLS_TYPES][CELLS_PAGES];
+    int n_pages;
+    conversion_t *conversions;
+    int n_conversions;
     uint16_t slave_id;
 } slave_data_t;
 
+#pragma pack(1)
+
 typedef struct {
     uint8_t slave_id;
     uint8_t function;
@@ -236,6 +260,7 @@ typedef struct {
 
 typedef struct _FRAME_HEAD {
     // Common head
+    uint16_t t_id;  // TCP only
     unsigned slave_id;
     unsigned function;
     unsigned byte_count;
@@ -257,6 +282,30 @@ typedef enum {
     WAIT_PAYLOAD,
 } state_t;
 
+/*
+ *  Poll plan of a slave: its map entries coalesced in blocks, one request each
+ */
+typedef struct {
+    json_t *jn_slave;       // slave config, not owned
+    json_t *jn_blocks;      // [{type, address, size}]
+    int idx_block;          // next block to poll in the current cycle
+    int in_flight;          // requests of this slave waiting response
+} poll_slave_t;
+
+/*
+ *  Request waiting its response
+ */
+typedef struct {
+    BOOL busy;
+    uint16_t t_id;
+    int modbus_function;
+    poll_slave_t *poll_slave;   // NULL in write requests
+    json_t *jn_map;             // block polled, NULL in write requests
+    uint64_t t_timeout;         // msectimer of response timeout
+} transaction_t;
+
+#define MAX_PIPELINE_WINDOW 16
+
 #define RESET_MACHINE() \
     ISTREAM_DESTROY(priv->istream_payload);                     \
     if(priv->istream_head) istream_clear(priv->istream_head);   \
@@ -269,19 +318,29 @@ typedef enum {
  ***************************************************************************/
 PRIVATE const char *get_object_type_name(modbus_object_type_t object_type);
 PRIVATE int print_slave_data(hgobj gobj);
+PRIVATE void dump_slave_cells(hgobj gobj, slave_data_t *pslv, int address, int size);
 PRIVATE slave_data_t *get_slave_data(hgobj gobj, int slave_id, BOOL verbose);
 PRIVATE const char *modbus_function_name(int modbus_function);
 PRIVATE modbus_object_type_t get_object_type(hgobj gobj, const char *type);
 PRIVATE int build_slave_data(hgobj gobj);
 PRIVATE int free_slave_data(hgobj gobj);
 PRIVATE int load_modbus_config(hgobj gobj);
-PRIVATE int load_slave_mapping(hgobj gobj);
-PRIVATE int store_modbus_response_data(hgobj gobj, uint8_t *bf, int len);
+PRIVATE int build_poll_plan(hgobj gobj);
+PRIVATE void free_poll_plan(hgobj gobj);
+PRIVATE void clear_transactions(hgobj gobj);
+PRIVATE void start_cycle(hgobj gobj);
+PRIVATE void fill_pipeline(hgobj gobj);
+PRIVATE transaction_t *find_transaction(hgobj gobj, uint16_t t_id);
+PRIVATE void release_transaction(hgobj gobj, transaction_t *tr);
+PRIVATE int store_modbus_response_data(hgobj gobj, transaction_t *tr, uint8_t *bf, int len);
 PRIVATE endian_format_t get_endian_format(hgobj gobj, const char *format);
 PRIVATE variable_format_t get_variable_format(hgobj gobj, const char *format);
 PRIVATE int build_message_to_publish(hgobj gobj);
 PRIVATE int check_conversion_variables(hgobj gobj);
 
+PRIVATE void mark_cell_changed(slave_data_t *pslv, modbus_object_type_t object_type, int address);
+PRIVATE BOOL cells_changed(slave_data_t *pslv, modbus_object_type_t object_type, int address, int n);
+PRIVATE void clear_cells_changed(slave_data_t *pslv);
 PRIVATE cell_control_t *get_cell_control(
     hgobj gobj,
     slave_data_t *pslv,
@@ -397,6 +456,10 @@ SDATA (DTP_STRING,  "cert_pem",         SDF_PERSIST,    "",         "SSL server
 SDATA (DTP_JSON,    "slaves",           SDF_WR,         "[]",       "Modbus configuration"),
 SDATA (DTP_INTEGER, "timeout_polling",  SDF_PERSIST,    "1000",     "Polling modbus time in milliseconds"),
 SDATA (DTP_INTEGER, "timeout_response", SDF_PERSIST,    "10",       "Timeout response in seconds"),
+SDATA (DTP_INTEGER, "pipeline_window",  SDF_PERSIST,    "1",        "Modbus TCP: requests in flight per connection (1..16). RTU/ASCII always 1"),
+SDATA (DTP_INTEGER, "slave_window",     SDF_PERSIST,    "1",        "Requests in flight per slave"),
+SDATA (DTP_BOOLEAN, "coalesce",         SDF_PERSIST,    "1",        "Merge adjacent map entries of a slave in one request, up to the modbus limits"),
+SDATA (DTP_BOOLEAN, "publish_changes_only",SDF_PERSIST,  "0",        "Publish only the variables changed since the last publish, skip slaves without changes"),
 SDATA (DTP_POINTER, "subscriber",       0,              0,          "subscriber of output-events. If null then subscriber is the parent"),
 SDATA_END()
 };
@@ -434,14 +497,19 @@ typedef struct _PRIVATE_DATA {
     const char *modbus_protocol;
 
     json_t *slaves_;
-    int idx_slaves;
     int max_slaves;
-    json_t *cur_slave_;
 
-    json_t *mapping_;
-    int idx_mapping;
-    int max_mapping;
-    json_t *cur_map_;
+    BOOL is_tcp;
+    BOOL coalesce;
+    BOOL publish_changes_only;
+    int pipeline_window;
+    int slave_window;
+    poll_slave_t *poll_slaves;
+    int idx_poll_slave;     // round robin
+    BOOL cycle_running;
+    uint64_t t_next_cycle;
+    transaction_t transactions[MAX_PIPELINE_WINDOW];
+    int in_flight;
 
     /* Extract from MODBUS Messaging on TCP/IP Implementation Guide V1.0b
        (page 23/46):
@@ -500,7 +568,7 @@ PRIVATE void mt_create(hgobj gobj)
     SET_PRIV(url,                   gobj_read_str_attr)
     SET_PRIV(timeout_polling,       (int)gobj_read_integer_attr)
     SET_PRIV(timeout_response,      (int)gobj_read_integer_attr)
-
+    SET_PRIV(publish_changes_only,  gobj_read_bool_attr)
 }
 
 /***************************************************************************
@@ -512,6 +580,7 @@ PRIVATE void mt_writing(hgobj gobj, const char *path)
 
     IF_EQ_SET_PRIV(timeout_polling,         (int)gobj_read_integer_attr)
     ELIF_EQ_SET_PRIV(timeout_response,      (int)gobj_read_integer_attr)
+    ELIF_EQ_SET_PRIV(publish_changes_only,  gobj_read_bool_attr)
     ELIF_EQ_SET_PRIV(url,                   gobj_read_str_attr)
         if(gobj_bottom_gobj(gobj)) {
             gobj_write_str_attr(gobj_bottom_gobj(gobj), "url", priv->url);
@@ -528,13 +597,33 @@ PRIVATE int mt_start(hgobj gobj)
 
     priv->jn_request_queue = json_array();
 
+    /*
+     *  Pipelining needs the transaction id of Modbus TCP,
+     *  the serial protocols have one request in flight.
+     */
+    priv->is_tcp = (strcasecmp(priv->modbus_protocol, "TCP")==0)? TRUE:FALSE;
+    priv->coalesce = gobj_read_bool_attr(gobj, "coalesce");
+    priv->pipeline_window = (int)gobj_read_integer_attr(gobj, "pipeline_window");
+    if(!priv->is_tcp || priv->pipeline_window < 1) {
+        priv->pipeline_window = 1;
+    } else if(priv->pipeline_window > MAX_PIPELINE_WINDOW) {
+        priv->pipeline_window = MAX_PIPELINE_WINDOW;
+    }
+    priv->slave_window = (int)gobj_read_integer_attr(gobj, "slave_window");
+    if(priv->slave_window < 1) {
+        priv->slave_window = 1;
+    }
+
     load_modbus_config(gobj);
     build_slave_data(gobj);
+    build_poll_plan(gobj);
     check_conversion_variables(gobj);
 
     if(gobj_trace_level(gobj)) {
         gobj_trace_json(gobj, priv->slaves_, "slaves_ max: %d", priv->max_slaves);
-        gobj_trace_json(gobj, priv->mapping_, "mapping_ max: %d", priv->max_mapping);
+        for(int i=0; priv->poll_slaves && i<priv->max_slaves; i++) {
+            gobj_trace_json(gobj, priv->poll_slaves[i].jn_blocks, "poll blocks of slave idx %d", i);
+        }
         print_slave_data(gobj);
     }
 
@@ -625,6 +714,8 @@ PRIVATE int mt_stop(hgobj gobj)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
+    clear_transactions(gobj);
+    free_poll_plan(gobj);
     free_slave_data(gobj);
 
     RESET_MACHINE();
@@ -677,6 +768,31 @@ PRIVATE json_t *cmd_help(hgobj gobj, const char *cmd, json_t *kw, hgobj src)
     );
 }
 
+/***************************************************************************
+ *  Dump the mapped pages of the slave in the range [address, address+size)
+ ***************************************************************************/
+PRIVATE void dump_slave_cells(hgobj gobj, slave_data_t *pslv, int address, int size)
+{
+    int first_page = address >> CELLS_PAGE_BITS;
+    int last_page = (address + size - 1) >> CELLS_PAGE_BITS;
+
+    for(int t=0; t<CELLS_TYPES; t++) {
+        for(int pg=first_page; pg<=last_page && pg<CELLS_PAGES; pg++) {
+            cells_page_t *page = pslv->pages[t][pg];
+            if(!page) {
+                continue;
+            }
+            gobj_trace_dump(gobj, (const char *)page->cells, sizeof(page->cells),
+                "%d: %s, cells %04X-%04X (control, input register, holding register)",
+                pslv->slave_id,
+                get_object_type_name(t),
+                pg << CELLS_PAGE_BITS,
+                ((pg+1) << CELLS_PAGE_BITS) - 1
+            );
+        }
+    }
+}
+
 /***************************************************************************
  *
  ***************************************************************************/
@@ -687,7 +803,7 @@ PRIVATE json_t *cmd_dump_data(hgobj gobj, const char *cmd, json_t *kw, hgobj src
     int address = (int)kw_get_int(gobj, kw, "address", 0, KW_WILD_NUMBER);
     int size = (int)kw_get_int(gobj, kw, "size", 0, KW_WILD_NUMBER);           // -1 all data
 
-    if(address > 0xFFFF) {
+    if(address < 0 || address > 0xFFFF) {
         return msg_iev_build_response(
             gobj,
             -1,
@@ -698,23 +814,6 @@ PRIVATE json_t *cmd_dump_data(hgobj gobj, const char *cmd, json_t *kw, hgobj src
         );
     }
 
-    if(slave_id == -1 && size == -1) {
-        gobj_trace_dump(
-            gobj,
-            (const char *)priv->slave_data,
-            priv->max_slaves * sizeof(slave_data_t),
-            "slaves"
-        );
-        return msg_iev_build_response(
-            gobj,
-            0,
-            json_sprintf("FULL data dumped in log file"),
-            0,
-            0,
-            kw  // owned
-        );
-    }
-
     if(size == -1) {
         size = 0xFFFF + 1;
     }
@@ -741,48 +840,12 @@ PRIVATE json_t *cmd_dump_data(hgobj gobj, const char *cmd, json_t *kw, hgobj src
                 kw  // owned
             );
         }
-
-        gobj_trace_dump(gobj, (const char *)pslv + 0x00000 + address, size,
-            "%d: Control Coil", slave_id
-        );
-        gobj_trace_dump(gobj, (const char *)pslv + 0x10000 + address, size,
-            "%d: Control Discrete input", slave_id
-        );
-        gobj_trace_dump(gobj, (const char *)pslv + 0x20000 + address, size,
-            "%d: Control Input register", slave_id
-        );
-        gobj_trace_dump(gobj, (const char *)pslv + 0x30000 + address, size,
-            "%d: Control Holding register", slave_id
-        );
-        gobj_trace_dump(gobj, (const char *)pslv + 0x40000 + address*2, size*2,
-            "%d: Data Input register", slave_id
-        );
-        gobj_trace_dump(gobj, (const char *)pslv + 0x60000 + address*2, size*2,
-            "%d: Data Holding register", slave_id
-        );
+        dump_slave_cells(gobj, pslv, address, size);
 
     } else {
         slave_data_t *pslv = priv->slave_data;
         for(int i=0; i<priv->max_slaves; i++) {
-            slave_id = pslv->slave_id;
-            gobj_trace_dump(gobj, (const char *)pslv + 0x00000 + address, size,
-                "%d: Control Coil", slave_id
-            );
-            gobj_trace_dump(gobj, (const char *)pslv + 0x10000 + address, size,
-                "%d: Control Discrete input", slave_id
-            );
-            gobj_trace_dump(gobj, (const char *)pslv + 0x20000 + address, size,
-                "%d: Control Input register", slave_id
-            );
-            gobj_trace_dump(gobj, (const char *)pslv + 0x30000 + address, size,
-                "%d: Control Holding register", slave_id
-            );
-            gobj_trace_dump(gobj, (const char *)pslv + 0x40000 + address*2, size*2,
-                "%d: Data Input register", slave_id
-            );
-            gobj_trace_dump(gobj, (const char *)pslv + 0x60000 + address*2, size*2,
-                "%d: Data Holding register", slave_id
-            );
+            dump_slave_cells(gobj, pslv, address, size);
             // Next slave
             pslv++;
         }
@@ -1504,12 +1567,6 @@ PRIVATE int build_slave_data(hgobj gobj)
     json_array_foreach(priv->slaves_, idx_slaves, jn_slave) {
         int slave_id = (int)kw_get_int(gobj, jn_slave, "id", 0, KW_REQUIRED);
         pslv->slave_id = slave_id;
-        pslv->x_control = json_object();
-
-        json_object_set_new(pslv->x_control, get_object_type_name(TYPE_COIL), json_object());
-        json_object_set_new(pslv->x_control, get_object_type_name(TYPE_DISCRETE_INPUT), json_object());
-        json_object_set_new(pslv->x_control, get_object_type_name(TYPE_INPUT_REGISTER), json_object());
-        json_object_set_new(pslv->x_control, get_object_type_name(TYPE_HOLDING_REGISTER), json_object());
 
         json_t *jn_mapping = kw_get_list(gobj, jn_slave, "mapping", 0, KW_REQUIRED);
         size_t idx_map; json_t *jn_map;
@@ -1636,18 +1693,18 @@ PRIVATE int free_slave_data(hgobj gobj)
         return 0;
     }
     for(int i=0; i<priv->max_slaves; i++) {
-        const char *key; json_t *jn_v;
-        json_object_foreach(pslv->x_control, key, jn_v) {
-            const char *key2; json_t *jn_v2;
-            json_object_foreach(jn_v, key2, jn_v2) {
-                cell_control_t *cell_control = (cell_control_t *)(uintptr_t)json_integer_value(jn_v2);
-                if(cell_control) {
-                    GBMEM_FREE(cell_control);
+        for(int t=0; t<CELLS_TYPES; t++) {
+            for(int pg=0; pg<CELLS_PAGES; pg++) {
+                if(pslv->pages[t][pg]) {
+                    GBMEM_FREE(pslv->pages[t][pg]);
                 }
             }
         }
-
-        JSON_DECREF(pslv->x_control)
+        pslv->n_pages = 0;
+        if(pslv->conversions) {
+            GBMEM_FREE(pslv->conversions);
+        }
+        pslv->n_conversions = 0;
         pslv++;
     }
 
@@ -1673,21 +1730,32 @@ PRIVATE int print_slave_data(hgobj gobj)
         return -1;
     }
     for(int i=0; i<priv->max_slaves; i++) {
-        // Next slave
-        gobj_trace_json(gobj, pslv->x_control, "x_control of slave data %d", pslv->slave_id);
-        const char *key; json_t *jn_v;
-        json_object_foreach(pslv->x_control, key, jn_v) {
-            const char *key2; json_t *jn_v2;
-            json_object_foreach(jn_v, key2, jn_v2) {
-                cell_control_t *cell_control = (cell_control_t *)(uintptr_t)json_integer_value(jn_v2);
-                trace_msg0("slave %d, '%s', '%s':", pslv->slave_id, key, key2);
-                if(cell_control) {
+        trace_msg0("slave data %d: %d pages, %d conversions",
+            pslv->slave_id, pslv->n_pages, pslv->n_conversions
+        );
+        for(int t=0; t<CELLS_TYPES; t++) {
+            for(int pg=0; pg<CELLS_PAGES; pg++) {
+                cells_page_t *page = pslv->pages[t][pg];
+                if(!page) {
+                    continue;
+                }
+                for(int c=0; c<CELLS_PER_PAGE; c++) {
+                    cell_control_t *cell_control = &page->cells[c];
+                    if(!cell_control->control.value_busy) {
+                        continue;
+                    }
+                    trace_msg0("slave %d, '%s', '%04X':",
+                        pslv->slave_id,
+                        get_object_type_name(t),
+                        (pg << CELLS_PAGE_BITS) + c
+                    );
                     trace_msg0("    input_register: 0x%02X", cell_control->input_register);
                     trace_msg0("    holding_register: 0x%02X", cell_control->holding_register);
                     trace_msg0("    control.bit_value: %d", cell_control->control.bit_value);
                     trace_msg0("    control.updated: %d", cell_control->control.updated);
                     trace_msg0("    control.compound_value: %d", cell_control->control.compound_value);
                     trace_msg0("    control.to_write: %d", cell_control->control.to_write);
+                    trace_msg0("    control.has_value: %d", cell_control->control.has_value);
                     trace_msg0("    control.value_busy: %d", cell_control->control.value_busy);
                 }
             }
@@ -1706,174 +1774,307 @@ PRIVATE int load_modbus_config(hgobj gobj)
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
     priv->slaves_ = gobj_read_json_attr(gobj, "slaves");
-    priv->idx_slaves = 0;
-    priv->max_slaves = json_array_size(priv->slaves_);
+    priv->max_slaves = (int)json_array_size(priv->slaves_);
+
+    return 0;
+}
 
-    load_slave_mapping(gobj);
+/***************************************************************************
+ *  Order of map entries to coalesce: by object type and address
+ ***************************************************************************/
+typedef struct {
+    modbus_object_type_t object_type;
+    int32_t address;
+    int32_t size;
+} map_range_t;
 
+PRIVATE int cmp_map_range(const void *a_, const void *b_)
+{
+    const map_range_t *a = a_;
+    const map_range_t *b = b_;
+    if(a->object_type != b->object_type) {
+        return (a->object_type < b->object_type)? -1 : 1;
+    }
+    if(a->address != b->address) {
+        return (a->address < b->address)? -1 : 1;
+    }
     return 0;
 }
 
 /***************************************************************************
- *
+ *  Build the poll plan of each slave:
+ *  its enabled map entries, and with `coalesce` the adjacent entries
+ *  of the same object type merged in one request,
+ *  up to the modbus limit (125 registers, 2000 bits).
+ *  Only contiguous ranges are merged: all the cells read are mapped.
  ***************************************************************************/
-PRIVATE int load_slave_mapping(hgobj gobj)
+PRIVATE int build_poll_plan(hgobj gobj)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    priv->cur_slave_ = json_array_get(priv->slaves_, priv->idx_slaves);
-    if(!priv->cur_slave_) {
-        gobj_log_error(gobj, 0,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_INTERNAL,
-            "msg",          "%s", "cur_slave_ NULL",
-            "idx_slaves",   "%d", priv->idx_slaves,
-            "slaves_",      "%j", priv->slaves_?priv->slaves_:json_null(),
-            NULL
-        );
-        priv->idx_mapping = 0;
-        priv->max_mapping = 0;
+    if(!priv->max_slaves) {
         return -1;
     }
-    priv->mapping_ = kw_get_list(gobj, priv->cur_slave_, "mapping", 0, KW_REQUIRED);
-    priv->idx_mapping = -1;
-    priv->max_mapping = (int)json_array_size(priv->mapping_);
-    if(priv->max_mapping == 0) {
+
+    priv->poll_slaves = GBMEM_MALLOC(priv->max_slaves * sizeof(poll_slave_t));
+    if(!priv->poll_slaves) {
         gobj_log_error(gobj, 0,
             "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_INTERNAL,
-            "msg",          "%s", "slave without mapping",
-            "idx_slaves",   "%d", priv->idx_slaves,
-            "cur_slave_",   "%j", priv->cur_slave_,
+            "msgset",       "%s", MSGSET_MEMORY,
+            "msg",          "%s", "no memory for poll_slaves",
+            "max_slaves",   "%d", priv->max_slaves,
             NULL
         );
         return -1;
     }
+
+    int total_maps = 0;
+    int total_blocks = 0;
+
+    size_t idx_slaves; json_t *jn_slave;
+    json_array_foreach(priv->slaves_, idx_slaves, jn_slave) {
+        poll_slave_t *ps = &priv->poll_slaves[idx_slaves];
+        ps->jn_slave = jn_slave;
+        ps->jn_blocks = json_array();
+
+        json_t *jn_mapping = kw_get_list(gobj, jn_slave, "mapping", 0, 0);
+        size_t max_mapping = json_array_size(jn_mapping);
+        if(max_mapping == 0) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PARAMETER,
+                "msg",          "%s", "slave without mapping",
+                "slave",        "%j", jn_slave,
+                NULL
+            );
+            continue;
+        }
+
+        map_range_t *ranges = GBMEM_MALLOC(max_mapping * sizeof(map_range_t));
+        if(!ranges) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_MEMORY,
+                "msg",          "%s", "no memory for map ranges",
+                "max_mapping",  "%d", (int)max_mapping,
+                NULL
+            );
+            continue;
+        }
+
+        int n_ranges = 0;
+        size_t idx_map; json_t *jn_map;
+        json_array_foreach(jn_mapping, idx_map, jn_map) {
+            if(kw_get_bool(gobj, jn_map, "disabled", 0, 0)) {
+                continue;
+            }
+            const char *type = kw_get_str(gobj, jn_map, "type", "", KW_REQUIRED);
+            map_range_t *r = &ranges[n_ranges];
+            r->object_type = get_object_type(gobj, type);
+            r->address = (int32_t)kw_get_int(gobj, jn_map, "address", 0, KW_REQUIRED|KW_WILD_NUMBER);
+            r->size = (int32_t)kw_get_int(gobj, jn_map, "size", 0, KW_REQUIRED|KW_WILD_NUMBER);
+            if(r->object_type < 0 || r->size <= 0) {
+                continue;
+            }
+            n_ranges++;
+        }
+        total_maps += n_ranges;
+
+        if(priv->coalesce) {
+            qsort(ranges, (size_t)n_ranges, sizeof(map_range_t), cmp_map_range);
+        }
+
+        for(int i=0; i<n_ranges; i++) {
+            map_range_t block = ranges[i];
+            int32_t max_size =
+                (block.object_type == TYPE_COIL || block.object_type == TYPE_DISCRETE_INPUT)?
+                MODBUS_MAX_READ_BITS : MODBUS_MAX_READ_REGISTERS;
+
+            while(priv->coalesce && i+1 < n_ranges) {
+                map_range_t *next = &ranges[i+1];
+                if(next->object_type != block.object_type ||
+                        next->address != block.address + block.size ||
+                        block.size + next->size > max_size) {
+                    break;
+                }
+                block.size += next->size;
+                i++;
+            }
+
+            json_array_append_new(ps->jn_blocks, json_pack("{s:s, s:i, s:i}",
+                "type", get_object_type_name(block.object_type),
+                "address", (int)block.address,
+                "size", (int)block.size
+            ));
+        }
+        total_blocks += (int)json_array_size(ps->jn_blocks);
+
+        GBMEM_FREE(ranges);
+    }
+
+    gobj_log_info(gobj, 0,
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_INFO,
+        "msg",          "%s", "Modbus poll plan",
+        "slaves",       "%d", priv->max_slaves,
+        "maps",         "%d", total_maps,
+        "requests",     "%d", total_blocks,
+        "pipeline_window", "%d", priv->pipeline_window,
+        "slave_window", "%d", priv->slave_window,
+        NULL
+    );
+
     return 0;
 }
 
 /***************************************************************************
- *  Prepare next poll
- *  If end of cycle then publish and return -1
+ *
  ***************************************************************************/
-PRIVATE int next_map(hgobj gobj)
+PRIVATE void free_poll_plan(hgobj gobj)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    priv->cur_map_ = 0; // Reset cur map
-
-    if(priv->idx_mapping < 0) {
-        priv->idx_mapping = 0;
-    } else {
-        priv->idx_mapping++;
+    if(!priv->poll_slaves) {
+        return;
     }
-    if(priv->idx_mapping < priv->max_mapping) {
-        // Next map in current slave
-        if(gobj_trace_level(gobj) & TRACE_POLLING) {
-            gobj_trace_msg(gobj, "🔊🔊🔊🔊⏩ next map  : idx slave %d, idx map %d",
-                priv->idx_slaves, priv->idx_mapping
-            );
-        }
-        return 0; // do polling
+    for(int i=0; i<priv->max_slaves; i++) {
+        JSON_DECREF(priv->poll_slaves[i].jn_blocks)
     }
+    GBMEM_FREE(priv->poll_slaves);
+}
 
-    priv->idx_slaves++;
-    if(priv->idx_slaves < priv->max_slaves) {
-        load_slave_mapping(gobj);
-        priv->idx_mapping = 0;;
-        if(gobj_trace_level(gobj) & TRACE_POLLING) {
-            gobj_trace_msg(gobj, "🔊🔊🔊🔊🔊🔊🔊🔊⏩ next slave: idx slave %d, idx map %d",
-                priv->idx_slaves, priv->idx_mapping
-            );
+/***************************************************************************
+ *  Forget all the requests in flight (disconnection, stop)
+ ***************************************************************************/
+PRIVATE void clear_transactions(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    memset(priv->transactions, 0, sizeof(priv->transactions));
+    priv->in_flight = 0;
+    priv->cycle_running = FALSE;
+    if(priv->poll_slaves) {
+        for(int i=0; i<priv->max_slaves; i++) {
+            priv->poll_slaves[i].in_flight = 0;
         }
-        return 0; // do polling
     }
+}
 
-    if(gobj_trace_level(gobj) & TRACE_POLLING) {
-        gobj_trace_msg(gobj, "🔊🔊🔊🔊⏩⏩⏩ end cycle: idx slave %d, idx map %d",
-            priv->idx_slaves, priv->idx_mapping
-        );
+/***************************************************************************
+ *  Register the request just built (priv->t_id, priv->modbus_function)
+ ***************************************************************************/
+PRIVATE transaction_t *add_transaction(hgobj gobj, poll_slave_t *ps, json_t *jn_map)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    for(int i=0; i<priv->pipeline_window; i++) {
+        transaction_t *tr = &priv->transactions[i];
+        if(!tr->busy) {
+            tr->busy = TRUE;
+            tr->t_id = priv->t_id;
+            tr->modbus_function = priv->modbus_function;
+            tr->poll_slave = ps;
+            tr->jn_map = jn_map;
+            tr->t_timeout = start_msectimer((uint64_t)priv->timeout_response*1000);
+            priv->in_flight++;
+            if(ps) {
+                ps->in_flight++;
+            }
+            return tr;
+        }
     }
 
-    /*
-     *  End of cycle, publish variables
-     */
-    build_message_to_publish(gobj);
+    gobj_log_error(gobj, LOG_OPT_TRACE_STACK,
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_INTERNAL,
+        "msg",          "%s", "No free transaction",
+        "in_flight",    "%d", priv->in_flight,
+        NULL
+    );
+    return NULL;
+}
 
-    priv->idx_slaves = 0; // Begin cycle
-    load_slave_mapping(gobj);
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void release_transaction(hgobj gobj, transaction_t *tr)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    return -1; // End of cycle
+    if(tr->poll_slave) {
+        tr->poll_slave->in_flight--;
+    }
+    memset(tr, 0, sizeof(transaction_t));
+    priv->in_flight--;
 }
 
 /***************************************************************************
- *  Send current map
- *  If success return 0 and set response timeout
- *  If fails return -1 and don't set timeout
+ *  Find the request of the response:
+ *  by transaction id in TCP, the only one in flight in RTU.
  ***************************************************************************/
-PRIVATE int poll_modbus(hgobj gobj)
+PRIVATE transaction_t *find_transaction(hgobj gobj, uint16_t t_id)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    if(priv->cur_map_) {
-        gobj_log_error(gobj, 0,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_INTERNAL,
-            "msg",          "%s", "cur_map_ ALREADY loaded",
-            "idx_slaves",   "%d", priv->idx_slaves,
-            "idx_mapping",  "%d", priv->idx_mapping,
-            "cur_map_",     "%j", priv->cur_map_?priv->cur_map_:json_null(),
-            NULL
-        );
+    for(int i=0; i<priv->pipeline_window; i++) {
+        transaction_t *tr = &priv->transactions[i];
+        if(tr->busy && (!priv->is_tcp || tr->t_id == t_id)) {
+            return tr;
+        }
     }
+    return NULL;
+}
 
-    priv->cur_map_ = json_array_get(priv->mapping_, priv->idx_mapping);
-    if(!priv->cur_map_) {
-        gobj_log_error(gobj, 0,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_INTERNAL,
-            "msg",          "%s", "cur_map_ NULL",
-            "idx_slaves",   "%d", priv->idx_slaves,
-            "idx_mapping",  "%d", priv->idx_mapping,
-            "mapping_",     "%j", priv->mapping_?priv->mapping_:json_null(),
-            NULL
-        );
-        // Don't set timeout
-        return -1;
-    }
+/***************************************************************************
+ *  Next slave with blocks to poll in this cycle and room in its window,
+ *  round robin: a slow slave doesn't hold back the others.
+ ***************************************************************************/
+PRIVATE poll_slave_t *next_poll_slave(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    if(kw_get_bool(gobj, priv->cur_map_, "disabled", 0, 0)) {
-        gobj_log_error(gobj, 0,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_INTERNAL,
-            "msg",          "%s", "cur_map_ DISABLED",
-            "idx_slaves",   "%d", priv->idx_slaves,
-            "idx_mapping",  "%d", priv->idx_mapping,
-            "cur_map_",     "%j", priv->cur_map_,
-            NULL
-        );
-        // Don't set timeout
-        return -1;
+    for(int k=0; k<priv->max_slaves; k++) {
+        int i = (priv->idx_poll_slave + k) % priv->max_slaves;
+        poll_slave_t *ps = &priv->poll_slaves[i];
+        if(ps->idx_block < (int)json_array_size(ps->jn_blocks) &&
+                ps->in_flight < priv->slave_window) {
+            priv->idx_poll_slave = (i + 1) % priv->max_slaves;
+            return ps;
+        }
     }
+    return NULL;
+}
+
+/***************************************************************************
+ *  Send the next block of the slave
+ ***************************************************************************/
+PRIVATE int poll_modbus(hgobj gobj, poll_slave_t *ps)
+{
+    json_t *jn_map = json_array_get(ps->jn_blocks, ps->idx_block);
+    ps->idx_block++;
 
     if(gobj_trace_level(gobj) & TRACE_POLLING) {
-        gobj_trace_json(gobj, priv->cur_map_, "polling");
+        gobj_trace_json(gobj, jn_map, "polling");
     }
 
-    // Change state
-    gobj_change_state(gobj, ST_WAIT_RESPONSE);
-
-    // Set response timeout
-    set_timeout(priv->gobj_timer, priv->timeout_response*1000);
-
-    gbuffer_t *gbuf = build_modbus_request_read_message(gobj, priv->cur_slave_, priv->cur_map_);
+    gbuffer_t *gbuf = build_modbus_request_read_message(gobj, ps->jn_slave, jn_map);
+    if(!gbuf) {
+        // Error already logged
+        return -1;
+    }
+    if(!add_transaction(gobj, ps, jn_map)) {
+        // Error already logged
+        GBUFFER_DECREF(gbuf)
+        return -1;
+    }
     send_data(gobj, gbuf);
 
     return 0;
 }
 
 /***************************************************************************
- *
+ *  Send the first request of the write queue
+ *  Return TRUE if a request has been taken from the queue
  ***************************************************************************/
 PRIVATE BOOL send_request(hgobj gobj)
 {
@@ -1883,26 +2084,125 @@ PRIVATE BOOL send_request(hgobj gobj)
         return FALSE;
     }
 
-    json_t *jn_current_request = json_array_get(priv->jn_request_queue, 0);
+    json_t *jn_current_request = json_incref(json_array_get(priv->jn_request_queue, 0));
+    json_array_remove(priv->jn_request_queue, 0);
+
     if(gobj_trace_level(gobj) & TRACE_SEND) {
         gobj_trace_json(gobj, jn_current_request, "sending to %s",
            gobj_read_str_attr(gobj_bottom_gobj(gobj), "url")
         );
     }
 
-    // Change state
-    gobj_change_state(gobj, ST_WAIT_RESPONSE);
-
-    // Set response timeout
-    set_timeout(priv->gobj_timer, priv->timeout_response*1000);
-
     gbuffer_t *gbuf = build_modbus_request_write_message(gobj, jn_current_request);
     JSON_DECREF(jn_current_request);
+    if(!gbuf) {
+        // Error already logged
+        return TRUE;
+    }
+    if(!add_transaction(gobj, NULL, NULL)) {
+        // Error already logged
+        GBUFFER_DECREF(gbuf)
+        return TRUE;
+    }
     send_data(gobj, gbuf);
 
     return TRUE;
 }
 
+/***************************************************************************
+ *  Begin a poll cycle
+ ***************************************************************************/
+PRIVATE void start_cycle(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(gobj_trace_level(gobj) & TRACE_POLLING) {
+        gobj_trace_msg(gobj, "🔊🔊🔊🔊⏩ begin cycle");
+    }
+    for(int i=0; i<priv->max_slaves; i++) {
+        priv->poll_slaves[i].idx_block = 0;
+    }
+    priv->cycle_running = TRUE;
+}
+
+/***************************************************************************
+ *  Fill the pipeline: pending writes first, then the blocks of the cycle.
+ *  A cycle begins when it's due, with or without writes in flight.
+ *  When all the blocks are answered (or timed out) publish the variables.
+ *  Then set the state and the timer:
+ *      ST_WAIT_RESPONSE with the nearest response timeout or next cycle,
+ *      or ST_CONNECTED until the next cycle.
+ ***************************************************************************/
+PRIVATE void fill_pipeline(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(!priv->cycle_running && priv->poll_slaves && test_msectimer(priv->t_next_cycle)) {
+        start_cycle(gobj);
+    }
+
+    while(priv->in_flight < priv->pipeline_window && send_request(gobj)) {
+        // Writes first
+    }
+
+    poll_slave_t *ps;
+    while(priv->cycle_running && priv->in_flight < priv->pipeline_window &&
+            (ps = next_poll_slave(gobj))) {
+        poll_modbus(gobj, ps);
+    }
+
+    if(priv->cycle_running) {
+        BOOL pending = FALSE;
+        for(int i=0; i<priv->max_slaves; i++) {
+            poll_slave_t *ps_ = &priv->poll_slaves[i];
+            if(ps_->in_flight > 0 || ps_->idx_block < (int)json_array_size(ps_->jn_blocks)) {
+                pending = TRUE;
+                break;
+            }
+        }
+        if(!pending) {
+            if(gobj_trace_level(gobj) & TRACE_POLLING) {
+                gobj_trace_msg(gobj, "🔊🔊🔊🔊⏩⏩⏩ end cycle");
+            }
+            /*
+             *  End of cycle, publish variables
+             */
+            priv->cycle_running = FALSE;
+            priv->t_next_cycle = start_msectimer((uint64_t)priv->timeout_polling);
+            build_message_to_publish(gobj);
+        }
+    }
+
+    uint64_t now = time_in_milliseconds_monotonic();
+    uint64_t next = UINT64_MAX;
+    if(priv->in_flight > 0) {
+        gobj_change_state(gobj, ST_WAIT_RESPONSE);
+        for(int i=0; i<priv->pipeline_window; i++) {
+            transaction_t *tr = &priv->transactions[i];
+            if(tr->busy && tr->t_timeout < next) {
+                next = tr->t_timeout;
+            }
+        }
+    } else {
+        gobj_change_state(gobj, ST_CONNECTED);
+    }
+    if(!priv->cycle_running) {
+        /*
+         *  Between cycles wake up at the next one. If it's already due
+         *  (no slaves to poll) check again in timeout_polling, not in a busy loop.
+         */
+        uint64_t t_cycle = priv->t_next_cycle > now?
+            priv->t_next_cycle : now + (uint64_t)priv->timeout_polling;
+        if(t_cycle < next) {
+            next = t_cycle;
+        }
+    }
+    if(next == UINT64_MAX) {
+        next = now + (uint64_t)priv->timeout_polling;
+    }
+    set_timeout(priv->gobj_timer, (json_int_t)((next > now)? next - now : 1));
+}
+
 /***************************************************************************
  *  Reset variables for a new read.
  ***************************************************************************/
@@ -1976,6 +2276,7 @@ PRIVATE int framehead_consume(hgobj gobj, FRAME_HEAD *frame, istream_h istream,
         SWITCHS(priv->modbus_protocol) {
             CASES("TCP")
                 head_tcp_t *head = (head_tcp_t *)istream_extract_matched_data(istream, 0);
+                frame->t_id = ntohs(head->t_id);
                 frame->function = head->function;
                 frame->slave_id = head->slave_id;
                 frame->byte_count = head->byte_count;
@@ -2018,14 +2319,19 @@ PRIVATE int framehead_consume(hgobj gobj, FRAME_HEAD *frame, istream_h istream,
 
     if(frame->function & 0x80) {
         frame->error_code = priv->frame_head.byte_count;
-        frame->payload_length = sizeof(uint16_t); // + crc
+        if(!priv->is_tcp) {
+            frame->payload_length = sizeof(uint16_t); // + crc
+        }
+        transaction_t *tr = find_transaction(gobj, frame->t_id);
         gobj_log_error(gobj, 0,
             "function",         "%s", __FUNCTION__,
             "msgset",           "%s", MSGSET_PROTOCOL,
             "msg",              "%s", "modbus exception",
             "error_code",       "%d", frame->error_code,
             "error_name",       "%s", modbus_exception_name(frame->error_code),
-            "cur_map_",         "%j", priv->cur_map_,
+            "slave_id",         "%d", (int)frame->slave_id,
+            "t_id",             "%d", (int)frame->t_id,
+            "map",              "%j", (tr && tr->jn_map)? tr->jn_map:json_null(),
             NULL
         );
     } else {
@@ -2046,10 +2352,14 @@ PRIVATE int framehead_consume(hgobj gobj, FRAME_HEAD *frame, istream_h istream,
 /***************************************************************************
  *  Process the completed frame
  ***************************************************************************/
-PRIVATE int frame_completed(hgobj gobj)
+PRIVATE int frame_completed(hgobj gobj, transaction_t *tr)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
+    if(!tr) {
+        // Late response of a timed out request, or unknown: discard it
+        return 0;
+    }
     gbuffer_t *gbuf = istream_get_gbuffer(priv->istream_payload);
 
     SWITCHS(priv->modbus_protocol) {
@@ -2057,7 +2367,7 @@ PRIVATE int frame_completed(hgobj gobj)
             int len = gbuffer_leftbytes(gbuf);
             uint8_t *bf = gbuffer_get(gbuf, len);
             if(!priv->frame_head.error_code) {
-                store_modbus_response_data(gobj, bf, len);
+                store_modbus_response_data(gobj, tr, bf, len);
             }
             break;
 
@@ -2090,7 +2400,7 @@ PRIVATE int frame_completed(hgobj gobj)
                  return -1;
              }
              if(!priv->frame_head.error_code) {
-                 store_modbus_response_data(gobj, bf, len - 2);
+                 store_modbus_response_data(gobj, tr, bf, len - 2);
              }
              break;
 
@@ -2166,8 +2476,13 @@ PRIVATE int store_slave_bit(
         // Error already logged
         return -1;
     }
+    if(!cell_control->control.has_value ||
+            cell_control->control.bit_value != (value?1:0)) {
+        mark_cell_changed(pslv, object_type, address);
+    }
     cell_control->control.bit_value = value?1:0;
     cell_control->control.updated = 1;
+    cell_control->control.has_value = 1;
 
     if(gobj_trace_level(gobj) & TRACE_DECODE) {
         gobj_trace_msg(gobj,
@@ -2205,8 +2520,13 @@ PRIVATE int store_slave_word(
 
     switch(object_type) {
         case TYPE_INPUT_REGISTER:
+            if(!cell_control->control.has_value ||
+                    memcmp(&cell_control->input_register, bf, 2)!=0) {
+                mark_cell_changed(pslv, object_type, address);
+            }
             memmove(&cell_control->input_register, bf, 2);
             cell_control->control.updated = 1;
+            cell_control->control.has_value = 1;
 
             if(gobj_trace_level(gobj) & TRACE_DECODE) {
                 gobj_trace_dump(gobj,
@@ -2221,8 +2541,13 @@ PRIVATE int store_slave_word(
             break;
 
         case TYPE_HOLDING_REGISTER:
+            if(!cell_control->control.has_value ||
+                    memcmp(&cell_control->holding_register, bf, 2)!=0) {
+                mark_cell_changed(pslv, object_type, address);
+            }
             memmove(&cell_control->holding_register, bf, 2);
             cell_control->control.updated = 1;
+            cell_control->control.has_value = 1;
 
             if(gobj_trace_level(gobj) & TRACE_DECODE) {
                 gobj_trace_dump(gobj,
@@ -2254,7 +2579,7 @@ PRIVATE int store_slave_word(
 /***************************************************************************
  *
  ***************************************************************************/
-PRIVATE int store_modbus_response_data(hgobj gobj, uint8_t *bf, int len)
+PRIVATE int store_modbus_response_data(hgobj gobj, transaction_t *tr, uint8_t *bf, int len)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
@@ -2283,12 +2608,16 @@ PRIVATE int store_modbus_response_data(hgobj gobj, uint8_t *bf, int len)
         // TODO by now write functions not checked
         return 0;
     }
+    if(!tr->poll_slave || !tr->jn_map) {
+        // Response of a write request
+        return 0;
+    }
 
-    uint8_t req_slave_id = (uint8_t)kw_get_int(gobj, priv->cur_slave_, "id", 0, KW_REQUIRED);
+    uint8_t req_slave_id = (uint8_t)kw_get_int(gobj, tr->poll_slave->jn_slave, "id", 0, KW_REQUIRED);
     uint16_t req_address = (uint16_t)kw_get_int(
-        gobj, priv->cur_map_, "address", 0, KW_REQUIRED|KW_WILD_NUMBER
+        gobj, tr->jn_map, "address", 0, KW_REQUIRED|KW_WILD_NUMBER
     );
-    uint16_t req_size = (uint16_t)kw_get_int(gobj, priv->cur_map_, "size", 0, KW_REQUIRED|KW_WILD_NUMBER);
+    uint16_t req_size = (uint16_t)kw_get_int(gobj, tr->jn_map, "size", 0, KW_REQUIRED|KW_WILD_NUMBER);
 
     /*------------------------------*
      *      Check protocol
@@ -2305,12 +2634,12 @@ PRIVATE int store_modbus_response_data(hgobj gobj, uint8_t *bf, int len)
         return -1;
     }
 
-    if(priv->modbus_function != modbus_function) {
+    if(tr->modbus_function != modbus_function) {
         gobj_log_error(gobj, 0,
             "function",         "%s", __FUNCTION__,
             "msgset",           "%s", MSGSET_PROTOCOL,
             "msg",              "%s", "modbus function NOT MATCH",
-            "function esperada","%s", modbus_function_name(priv->modbus_function),
+            "function esperada","%s", modbus_function_name(tr->modbus_function),
             "function recibida","%s", modbus_function_name(modbus_function),
             NULL
         );
@@ -3218,23 +3547,34 @@ PRIVATE int build_message_to_publish(hgobj gobj)
         if(!pslv) {
             continue;
         }
-        json_t *jn_conversion = kw_get_list(gobj, jn_slave, "conversion", 0, KW_REQUIRED);
-        if(!jn_conversion) {
+        if(!pslv->conversions) {
             continue;
         }
 
         json_t *kw_data = json_object();
         json_object_set_new(kw_data, "slave_id", json_integer(slave_id));
 
-        size_t idx_conversion; json_t *jn_variable;
-        json_array_foreach(jn_conversion, idx_conversion, jn_variable) {
-            BOOL disabled = kw_get_bool(gobj, jn_variable, "disabled", 0, 0);
-            if(disabled) {
+        /*
+         *  The enabled variables, with their cells, are in the native
+         *  conversion table built by check_conversion_variables().
+         */
+        int published = 0;
+        for(int i=0; i<pslv->n_conversions; i++) {
+            conversion_t *conversion = &pslv->conversions[i];
+            if(priv->publish_changes_only &&
+                    !cells_changed(pslv, conversion->object_type, conversion->address, conversion->n_cells)) {
                 continue;
             }
-            const char *variable_id = kw_get_str(gobj, jn_variable, "id", "", KW_REQUIRED);
-            json_t *jn_value = get_variable_value(gobj, pslv, jn_variable);
+            const char *variable_id = kw_get_str(gobj, conversion->jn_variable, "id", "", KW_REQUIRED);
+            json_t *jn_value = get_variable_value(gobj, pslv, conversion->jn_variable);
             json_object_set_new(kw_data, variable_id, jn_value);
+            published++;
+        }
+        clear_cells_changed(pslv);
+
+        if(priv->publish_changes_only && published == 0) {
+            JSON_DECREF(kw_data)
+            continue;
         }
 
         if(gobj_trace_level(gobj) & TRACE_MESSAGES) {
@@ -3251,6 +3591,9 @@ PRIVATE int build_message_to_publish(hgobj gobj)
  ***************************************************************************/
 PRIVATE int check_conversion_variable(hgobj gobj, slave_data_t *pslv, json_t *jn_variable)
 {
+    /*
+     *  Return the number of cells of the variable, -1 if it's disabled
+     */
     int slave_id = pslv->slave_id;
 
     const char *type = kw_get_str(gobj, jn_variable, "type", "", KW_REQUIRED);
@@ -3388,7 +3731,7 @@ PRIVATE int check_conversion_variable(hgobj gobj, slave_data_t *pslv, json_t *jn
                 NULL
             );
             json_object_set_new(jn_variable, "disabled", json_true());
-            break;
+            return -1;
         }
         if(cell_control->control.compound_value) {
             gobj_log_error(gobj, 0,
@@ -3404,14 +3747,14 @@ PRIVATE int check_conversion_variable(hgobj gobj, slave_data_t *pslv, json_t *jn
                 NULL
             );
             json_object_set_new(jn_variable, "disabled", json_true());
-            break;
+            return -1;
         }
         if(compound_value > 1) {
             cell_control->control.compound_value = 1;
         }
     }
 
-    return 0;
+    return compound_value;
 }
 
 /***************************************************************************
@@ -3433,9 +3776,37 @@ PRIVATE int check_conversion_variables(hgobj gobj)
             continue;
         }
 
+        if(json_array_size(jn_conversion) == 0) {
+            continue;
+        }
+        pslv->n_conversions = 0;
+        pslv->conversions = GBMEM_MALLOC(json_array_size(jn_conversion) * sizeof(conversion_t));
+        if(!pslv->conversions) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_MEMORY,
+                "msg",          "%s", "no memory for conversions",
+                "slave_id",     "%d", slave_id,
+                "conversions",  "%d", (int)json_array_size(jn_conversion),
+                NULL
+            );
+            continue;
+        }
+
         size_t idx_conversion; json_t *jn_variable;
         json_array_foreach(jn_conversion, idx_conversion, jn_variable) {
-            check_conversion_variable(gobj, pslv, jn_variable);
+            int n_cells = check_conversion_variable(gobj, pslv, jn_variable);
+            if(n_cells <= 0) {
+                continue;
+            }
+            const char *type = kw_get_str(gobj, jn_variable, "type", "", KW_REQUIRED);
+            conversion_t *conversion = &pslv->conversions[pslv->n_conversions++];
+            conversion->jn_variable = jn_variable;
+            conversion->object_type = (uint8_t)get_object_type(gobj, type);
+            conversion->address = (uint16_t)kw_get_int(
+                gobj, jn_variable, "address", 0, KW_REQUIRED|KW_WILD_NUMBER
+            );
+            conversion->n_cells = (uint16_t)n_cells;
         }
     }
 
@@ -3443,7 +3814,56 @@ PRIVATE int check_conversion_variables(hgobj gobj)
 }
 
 /***************************************************************************
- *  XXX
+ *  Mark the cell as changed since the last publish
+ ***************************************************************************/
+PRIVATE void mark_cell_changed(slave_data_t *pslv, modbus_object_type_t object_type, int address)
+{
+    cells_page_t *page = pslv->pages[object_type][address >> CELLS_PAGE_BITS];
+    if(page) {
+        int c = address & (CELLS_PER_PAGE-1);
+        page->changed[c >> 6] |= ((uint64_t)1 << (c & 63));
+    }
+}
+
+/***************************************************************************
+ *  Some of the n cells from address changed since the last publish?
+ ***************************************************************************/
+PRIVATE BOOL cells_changed(slave_data_t *pslv, modbus_object_type_t object_type, int address, int n)
+{
+    for(int i=0; i<n && address+i <= 0xFFFF; i++) {
+        int a = address + i;
+        cells_page_t *page = pslv->pages[object_type][a >> CELLS_PAGE_BITS];
+        if(!page) {
+            continue;
+        }
+        int c = a & (CELLS_PER_PAGE-1);
+        if(page->changed[c >> 6] & ((uint64_t)1 << (c & 63))) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/***************************************************************************
+ *  Reset the change bitmaps of the slave, after publishing
+ ***************************************************************************/
+PRIVATE void clear_cells_changed(slave_data_t *pslv)
+{
+    for(int t=0; t<CELLS_TYPES; t++) {
+        for(int pg=0; pg<CELLS_PAGES; pg++) {
+            cells_page_t *page = pslv->pages[t][pg];
+            if(page) {
+                memset(page->changed, 0, sizeof(page->changed));
+            }
+        }
+    }
+}
+
+/***************************************************************************
+ *  Return the cell of object_type/address.
+ *  With create the page of the cell is allocated if it doesn't exist,
+ *  the cell is returned as is (check value_busy to detect overrides).
+ *  Without create the cell must be mapped.
  ***************************************************************************/
 PRIVATE cell_control_t *get_cell_control(
     hgobj gobj,
@@ -3452,27 +3872,59 @@ PRIVATE cell_control_t *get_cell_control(
     int32_t address,
     BOOL create
 ) {
-    json_t *jn_type = kw_get_dict(gobj, pslv->x_control, get_object_type_name(object_type), 0, KW_REQUIRED);
-    if(!jn_type) {
+    if(object_type < 0 || object_type >= CELLS_TYPES || address < 0 || address > 0xFFFF) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "Modbus cell OUT OF RANGE",
+            "slave_id",     "%d", pslv->slave_id,
+            "object_type",  "%d", object_type,
+            "address",      "%d", address,
+            NULL
+        );
         return NULL;
     }
-    char saddress[32];
-    snprintf(saddress, sizeof(saddress), "%04X", (int)address);
-    if(create) {
-        cell_control_t *new_cell_control = GBMEM_MALLOC(sizeof(cell_control_t));
-        json_object_set_new(
-            jn_type,
-            saddress,
-            json_integer((json_int_t)(uintptr_t)new_cell_control)
+
+    cells_page_t **ppage = &pslv->pages[object_type][address >> CELLS_PAGE_BITS];
+    if(!*ppage) {
+        if(!create) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PARAMETER,
+                "msg",          "%s", "Modbus cell NOT MAPPED",
+                "slave_id",     "%d", pslv->slave_id,
+                "type",         "%s", get_object_type_name(object_type),
+                "address",      "%d", address,
+                NULL
+            );
+            return NULL;
+        }
+        *ppage = GBMEM_MALLOC(sizeof(cells_page_t));
+        if(!*ppage) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_MEMORY,
+                "msg",          "%s", "No memory for modbus cells page",
+                NULL
+            );
+            return NULL;
+        }
+        pslv->n_pages++;
+    }
+
+    cell_control_t *cell_control = &(*ppage)->cells[address & (CELLS_PER_PAGE-1)];
+    if(!create && !cell_control->control.value_busy) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "Modbus cell NOT MAPPED",
+            "slave_id",     "%d", pslv->slave_id,
+            "type",         "%s", get_object_type_name(object_type),
+            "address",      "%d", address,
+            NULL
         );
+        return NULL;
     }
-    cell_control_t *cell_control = (cell_control_t *)(uintptr_t)kw_get_int(
-        gobj,
-        jn_type,
-        saddress,
-        0,
-        KW_REQUIRED
-    );
     return cell_control;
 }
 
@@ -3494,6 +3946,8 @@ PRIVATE int ac_connected(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
     RESET_MACHINE();
+    clear_transactions(gobj);
+    priv->t_next_cycle = start_msectimer(1*1000);   // first cycle
 
     gobj_change_state(gobj, ST_CONNECTED);
 
@@ -3514,6 +3968,7 @@ PRIVATE int ac_disconnected(hgobj gobj, gobj_event_t event, json_t *kw, hgobj sr
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
     RESET_MACHINE();
+    clear_transactions(gobj);
 
     clear_timeout(priv->gobj_timer);
 
@@ -3545,7 +4000,7 @@ PRIVATE int ac_rx_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
     /*---------------------------------------------*
      *
      *---------------------------------------------*/
-    BOOL response_completed = FALSE;
+    int responses = 0;
     int lnn;
     BOOL fin = FALSE;
     while(!fin && (lnn=(int)gbuffer_leftbytes(gbuf))>0) {
@@ -3574,7 +4029,15 @@ PRIVATE int ac_rx_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
                 if(priv->frame_head.header_complete) {
                     if(priv->frame_head.payload_length <= 0) {
                         // Error already logged. Can be an exception
-                        response_completed = TRUE;
+                        transaction_t *tr = find_transaction(gobj, priv->frame_head.t_id);
+                        if(tr) {
+                            release_transaction(gobj, tr);
+                        }
+                        RESET_MACHINE()
+                        responses++;
+                        if(!priv->is_tcp) {
+                            fin = TRUE;
+                        }
                         break;
                     }
 
@@ -3595,7 +4058,7 @@ PRIVATE int ac_rx_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
                             "payload_length", "%d", priv->frame_head.payload_length,
                             NULL
                         );
-                        response_completed = TRUE;
+                        fin = TRUE;
                         break;
                     }
                     istream_read_until_num_bytes(
@@ -3620,9 +4083,30 @@ PRIVATE int ac_rx_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
                            istream_get_gbuffer(priv->istream_payload), "%s", gobj_short_name(src)
                        );
                     }
-                    frame_completed(gobj);
-                    response_completed = TRUE;
-                    fin = TRUE;
+                    /*
+                     *  Match the response with its request,
+                     *  in TCP more responses can follow in the same data.
+                     */
+                    transaction_t *tr = find_transaction(gobj, priv->frame_head.t_id);
+                    if(!tr) {
+                        gobj_log_warning(gobj, 0,
+                            "function",     "%s", __FUNCTION__,
+                            "msgset",       "%s", MSGSET_PROTOCOL,
+                            "msg",          "%s", "Modbus response without request, timed out?",
+                            "slave_id",     "%d", (int)priv->frame_head.slave_id,
+                            "t_id",         "%d", (int)priv->frame_head.t_id,
+                            NULL
+                        );
+                    }
+                    frame_completed(gobj, tr);
+                    if(tr) {
+                        release_transaction(gobj, tr);
+                    }
+                    RESET_MACHINE()
+                    responses++;
+                    if(!priv->is_tcp) {
+                        fin = TRUE;
+                    }
                 }
             }
             break;
@@ -3630,10 +4114,10 @@ PRIVATE int ac_rx_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
     }
 
     /*---------------------------*
-     *      Next map
+     *      Next requests
      *---------------------------*/
-    if(response_completed) {
-        if(gbuffer_leftbytes(gbuf)>0) {
+    if(responses > 0) {
+        if(gbuffer_leftbytes(gbuf)>0 && !priv->is_tcp) {
             gobj_log_error(gobj, 0,
                 "function",     "%s", __FUNCTION__,
                 "msgset",       "%s", MSGSET_PROTOCOL,
@@ -3643,32 +4127,7 @@ PRIVATE int ac_rx_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
             gobj_trace_dump_full_gbuf(gobj, gbuf, "Modbus: response too large");
         }
 
-        /*---------------------------------------------*
-         *   Reset response gobj_timer
-         *---------------------------------------------*/
-        clear_timeout(priv->gobj_timer);
-
-        RESET_MACHINE()
-        gobj_change_state(gobj, ST_CONNECTED);
-
-        if(!send_request(gobj)) {
-            if(next_map(gobj)<0) {
-                /*
-                 *  NO map or end of cycle, wait timeout_polling
-                 */
-                set_timeout(priv->gobj_timer, priv->timeout_polling);
-            } else {
-                if(poll_modbus(gobj)<0) {
-                    /*
-                     *  Problemas con el query actual, pasa al siguiente después del timeout
-                     */
-                    next_map(gobj);
-                    set_timeout(priv->gobj_timer, priv->timeout_polling);
-                } else {
-                    // timeout set by poll_modbus
-                }
-            }
-        }
+        fill_pipeline(gobj);
     }
 
     KW_DECREF(kw)
@@ -3682,11 +4141,13 @@ PRIVATE int ac_enqueue_tx_message(hgobj gobj, gobj_event_t event, json_t *kw, hg
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    // TODO enqueue the message and send after poll cycle or between responses
-    // format output message or directly send
-    //gobj_send_event(gobj_bottom_gobj(gobj), EV_TX_DATA, kw, gobj);
-
+    /*
+     *  Writes go before the polls, as soon as there is room in the pipeline
+     */
     json_array_append_new(priv->jn_request_queue, json_deep_copy(kw));
+    if(priv->in_flight < priv->pipeline_window) {
+        fill_pipeline(gobj);
+    }
 
     KW_DECREF(kw)
     return 0;
@@ -3708,29 +4169,10 @@ PRIVATE int ac_drop(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
  ***************************************************************************/
 PRIVATE int ac_timeout_polling(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
 {
-    PRIVATE_DATA *priv = gobj_priv_data(gobj);
-
     /*
-     *  Next map
+     *  Next cycle, if it's due
      */
-    if(!send_request(gobj)) {
-        if(next_map(gobj)<0) {
-            /*
-             *  NO map or end of cycle, wait timeout_polling
-             */
-            set_timeout(priv->gobj_timer, priv->timeout_polling);
-        } else {
-            if(poll_modbus(gobj)<0) {
-                /*
-                 *  Problemas con el query actual, pasa al siguiente después del timeout
-                 */
-                next_map(gobj);
-                set_timeout(priv->gobj_timer, priv->timeout_polling);
-            } else {
-                // timeout set by poll_modbus
-            }
-        }
-    }
+    fill_pipeline(gobj);
 
     JSON_DECREF(kw)
     return 0;
@@ -3743,36 +4185,35 @@ PRIVATE int ac_timeout_response(hgobj gobj, gobj_event_t event, json_t *kw, hgob
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    gobj_log_error(gobj, 0,
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PROTOCOL,
-        "msg",          "%s", "Modbus Timeout",
-        NULL
-    );
-
-    RESET_MACHINE()
-    gobj_change_state(gobj, ST_CONNECTED);
-
     /*
-     *  Next map
+     *  Drop the requests with the response timeout expired,
+     *  the others slaves go on.
      */
-    if(next_map(gobj)<0) {
-        /*
-         *  NO map or end of cycle, wait timeout_polling
-         */
-        set_timeout(priv->gobj_timer, priv->timeout_response*1000);
-    } else {
-        if(poll_modbus(gobj)<0) {
-            /*
-             *  Problemas con el query actual, pasa al siguiente después del timeout
-             */
-            next_map(gobj);
-            set_timeout(priv->gobj_timer, priv->timeout_response*1000);
-        } else {
-            // timeout set by poll_modbus
+    for(int i=0; i<priv->pipeline_window; i++) {
+        transaction_t *tr = &priv->transactions[i];
+        if(tr->busy && test_msectimer(tr->t_timeout)) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PROTOCOL,
+                "msg",          "%s", "Modbus Timeout",
+                "slave_id",     "%d", tr->poll_slave?
+                    (int)kw_get_int(gobj, tr->poll_slave->jn_slave, "id", 0, 0):-1,
+                "t_id",         "%d", (int)tr->t_id,
+                "function_code","%s", modbus_function_name(tr->modbus_function),
+                "map",          "%j", tr->jn_map?tr->jn_map:json_null(),
+                NULL
+            );
+            release_transaction(gobj, tr);
         }
     }
 
+    if(priv->in_flight == 0) {
+        // Nothing expected: discard any partial frame
+        RESET_MACHINE()
+    }
+
+    fill_pipeline(gobj);
+
     JSON_DECREF(kw)
     return 0;
 }
@@ -3853,7 +4294,7 @@ PRIVATE int create_gclass(gclass_name_t gclass_name)
     ev_action_t st_wait_response[] = {
         {EV_RX_DATA,            ac_rx_data,             0},
         {EV_SEND_MESSAGE,       ac_enqueue_tx_message,  0},
-        {EV_TIMEOUT,            ac_timeout_response,    ST_CONNECTED},
+        {EV_TIMEOUT,            ac_timeout_response,    0},
         {EV_TX_READY,           0,                      0},
         {EV_DISCONNECTED,       ac_disconnected,        ST_DISCONNECTED},
         {EV_DROP,               ac_drop,            0},
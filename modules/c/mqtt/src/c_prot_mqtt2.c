@@ -32,6 +32,7 @@
 #include <helpers.h>
 
 #include "command_parser.h"
+#include "stats_parser.h"
 #include "msg_ievent.h"
 #include "c_timer.h"
 #include "c_tcp.h"
@@ -53,6 +54,7 @@
 #define MAX_LOG_DUMP_SIZE (256)     // Cap the data dump added to logs, for very large packets
 
 #define MQTT_MAX_PAYLOAD 268435455U
+#define MQTT_SHARED_PAYLOAD_MIN (1024)  // PUBLISH payloads from this size are shared, not copied in the packet
 
 /* Error values */
 typedef enum mosq_err_s {
@@ -94,10 +96,20 @@ typedef struct _FRAME_HEAD {
     size_t frame_length;    // byte2 & 0x7F;
 } FRAME_HEAD;
 
+/*
+ *  Outgoing topic alias, indexed by alias id
+ */
+typedef struct {
+    DL_ITEM_FIELDS
+    char *topic;
+} outgoing_alias_t;
+
 /***************************************************************************
  *              Prototypes
  ***************************************************************************/
 PRIVATE void restore_client_attributes(hgobj gobj);
+PRIVATE void reset_outgoing_aliases(hgobj gobj);
+PRIVATE void sample_queue_depths(hgobj gobj);
 PRIVATE int send__publish(
     hgobj gobj,
     uint16_t mid,
@@ -276,6 +288,40 @@ SDATA (DTP_POINTER,     "subscriber",       0,                  0,      "subscri
 SDATA_END()
 };
 
+/*---------------------------------------------*
+ *      Native stat slots
+ *---------------------------------------------*/
+PRIVATE const sdata_desc_t stats_table[] = {
+/*-STATS-type-----------name------------------------flag----------default-description----------*/
+SDATA (DTP_INTEGER,     "txTopicAliasHits",         SDF_RSTATS,     "0",    "PUBLISH sent with a known topic alias, without topic"),
+SDATA (DTP_INTEGER,     "txTopicAliasMisses",       SDF_RSTATS,     "0",    "PUBLISH sent with topic and a new or re-mapped topic alias"),
+SDATA (DTP_INTEGER,     "txTopicAliasEvictions",    SDF_RSTATS,     "0",    "Topic aliases re-mapped to another topic (LRU)"),
+SDATA (DTP_INTEGER,     "txTopicAliasBytesSaved",   SDF_RSTATS,     "0",    "Topic bytes not sent thanks to topic aliases"),
+SDATA (DTP_INTEGER,     "inInflightDepth",          SDF_STATS,      "0",    "Gauge, input messages inflight (sampled in timeout_periodic)"),
+SDATA (DTP_INTEGER,     "inQueuedDepth",            SDF_STATS,      "0",    "Gauge, input messages queued (sampled in timeout_periodic)"),
+SDATA (DTP_INTEGER,     "outInflightDepth",         SDF_STATS,      "0",    "Gauge, output messages inflight (sampled in timeout_periodic)"),
+SDATA (DTP_INTEGER,     "outQueuedDepth",           SDF_STATS,      "0",    "Gauge, output messages queued (sampled in timeout_periodic)"),
+SDATA (DTP_INTEGER,     "inInflightMax",            SDF_STATS,      "0",    "Maximum input messages inflight"),
+SDATA (DTP_INTEGER,     "inQueuedMax",              SDF_STATS,      "0",    "Maximum input messages queued"),
+SDATA (DTP_INTEGER,     "outInflightMax",           SDF_STATS,      "0",    "Maximum output messages inflight"),
+SDATA (DTP_INTEGER,     "outQueuedMax",             SDF_STATS,      "0",    "Maximum output messages queued"),
+SDATA_END()
+};
+enum { // index in stats_table
+    STAT_TX_ALIAS_HITS,
+    STAT_TX_ALIAS_MISSES,
+    STAT_TX_ALIAS_EVICTIONS,
+    STAT_TX_ALIAS_BYTES_SAVED,
+    STAT_IN_INFLIGHT_DEPTH,
+    STAT_IN_QUEUED_DEPTH,
+    STAT_OUT_INFLIGHT_DEPTH,
+    STAT_OUT_QUEUED_DEPTH,
+    STAT_IN_INFLIGHT_MAX,
+    STAT_IN_QUEUED_MAX,
+    STAT_OUT_INFLIGHT_MAX,
+    STAT_OUT_QUEUED_MAX,
+};
+
 /*---------------------------------------------*
  *      GClass trace levels
  *---------------------------------------------*/
@@ -322,6 +368,9 @@ typedef struct _PRIVATE_DATA {
     int client_topic_alias_max;         // server mode: max aliases client accepts (from CONNECT)
     int server_topic_alias_max;         // client mode: max aliases broker accepts (from CONNACK)
     int next_outgoing_alias;            // next alias number to assign for outgoing direction
+    outgoing_alias_t *outgoing_aliases; // alias_id -> topic, [1..outgoing_aliases_size]
+    int outgoing_aliases_size;
+    dl_list_t dl_alias_lru;             // aliases in use, from the least to the most recently used
 
     json_t *tranger_queues;
     tr2_queue_t *trq_in_msgs;
@@ -523,6 +572,30 @@ PRIVATE void mt_writing(hgobj gobj, const char *path)
     END_EQ_SET_PRIV()
 }
 
+/***************************************************************************
+ *      Framework Method stats
+ *
+ *  The default stats parser, but "__reset__" also restarts the high-water
+ *  marks of the queues from their current depths: the *Max gauges are
+ *  SDF_STATS, the reset doesn't touch them, they are sampled again here.
+ ***************************************************************************/
+PRIVATE json_t *mt_stats(hgobj gobj, const char *stats, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(stats && strcmp(stats, "__reset__")==0) {
+        if(priv->trq_in_msgs) {
+            tr2q_reset_depth_marks(priv->trq_in_msgs);
+        }
+        if(priv->trq_out_msgs) {
+            tr2q_reset_depth_marks(priv->trq_out_msgs);
+        }
+        sample_queue_depths(gobj);
+    }
+
+    return stats_parser(gobj, stats, kw, src);
+}
+
 /***************************************************************************
  *      Framework Method start
  *
@@ -596,6 +669,9 @@ PRIVATE void mt_destroy(hgobj gobj)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
+    reset_outgoing_aliases(gobj);
+    JSON_DECREF(priv->jn_outgoing_alias_map)
+
     if(priv->istream_frame) {
         istream_destroy(priv->istream_frame);
         priv->istream_frame = 0;
@@ -736,6 +812,8 @@ PRIVATE void close_queues(hgobj gobj)
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
     char queue_name[NAME_MAX];
 
+    sample_queue_depths(gobj);
+
     if(priv->trq_in_msgs) {
         tr2q_close(priv->trq_in_msgs);
 
@@ -854,7 +932,7 @@ PRIVATE int message__release_to_inflight(hgobj gobj, enum mqtt_msg_direction dir
                  *  Assign mid and update state
                  */
                 uint16_t mid = mqtt_mid_generate(gobj);
-                qmsg->mid = mid;
+                tr2q_set_mid(qmsg, mid);
 
                 /*
                  *  Get message content and send PUBLISH
@@ -930,7 +1008,7 @@ PRIVATE int message__release_to_inflight(hgobj gobj, enum mqtt_msg_direction dir
                  *  Assign new mid (original was not persisted) and resend with DUP=1
                  */
                 uint16_t mid = mqtt_mid_generate(gobj);
-                qmsg->mid = mid;
+                tr2q_set_mid(qmsg, mid);
 
                 json_t *kw_msg = tr2q_msg_json(qmsg);
                 if(!kw_msg) {
@@ -986,7 +1064,7 @@ PRIVATE int message__release_to_inflight(hgobj gobj, enum mqtt_msg_direction dir
                  *  [MQTT-4.4.0-1] Redeliver PUBREL on reconnect
                  */
                 if(qmsg->mid == 0) {
-                    qmsg->mid = mqtt_mid_generate(gobj);
+                    tr2q_set_mid(qmsg, mqtt_mid_generate(gobj));
                 }
                 send__pubrel(gobj, qmsg->mid, NULL);
                 tr2q_save_hard_mark(qmsg, qmsg->md_record.user_flag);
@@ -1384,25 +1462,22 @@ PRIVATE int db__message_remove_incoming_dup(hgobj gobj, uint16_t mid)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    q2_msg_t *qmsg, *tmp;
-
-    DL_FOREACH_SAFE(&priv->trq_in_msgs->dl_inflight, qmsg, tmp) {
-        if(qmsg->rowid == (uint64_t)mid) {
-            gobj_log_warning(gobj, 0,
-                "function",     "%s", __FUNCTION__,
-                "msgset",       "%s", MSGSET_INTERNAL,
-                "msg",          "%s", "removing an inflight qos2 dup message",
-                "client_id",    "%s", SAFE_PRINT(priv->client_id),
-                "mid",          "%d", (int)mid,
-                NULL
-            );
-            db__message_remove_from_inflight(
-                gobj,
-                priv->trq_in_msgs,
-                qmsg
-            );
-            return MOSQ_ERR_SUCCESS;
-        }
+    q2_msg_t *qmsg = tr2q_get_by_mid(priv->trq_in_msgs, mid);
+    if(qmsg && qmsg->inflight) {
+        gobj_log_warning(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "removing an inflight qos2 dup message",
+            "client_id",    "%s", SAFE_PRINT(priv->client_id),
+            "mid",          "%d", (int)mid,
+            NULL
+        );
+        db__message_remove_from_inflight(
+            gobj,
+            priv->trq_in_msgs,
+            qmsg
+        );
+        return MOSQ_ERR_SUCCESS;
     }
 
     // Silence please
@@ -1430,7 +1505,7 @@ PRIVATE int db__message_write_queued_in(hgobj gobj)
             }
             msg_flag_set_state(qmsg, mosq_ms_wait_for_pubrel);
             uint16_t mid = mqtt_mid_generate(gobj);
-            qmsg->mid = mid;
+            tr2q_set_mid(qmsg, mid);
             send__pubrec(gobj, mid, 0, NULL);
             tr2q_save_hard_mark(qmsg, qmsg->md_record.user_flag);
         }
@@ -1572,8 +1647,12 @@ PRIVATE const char *protocol_version_name(mosquitto_protocol_t mosquitto_protoco
 /***************************************************************************
  *
  ***************************************************************************/
-PRIVATE gbuffer_t *build_mqtt_packet(hgobj gobj, uint8_t command, uint32_t size)
-{
+PRIVATE gbuffer_t *build_mqtt_packet_head(
+    hgobj gobj,
+    uint8_t command,
+    uint32_t size,
+    uint32_t shared_size    // bytes of size sent apart (shared payload), not allocated
+) {
     uint32_t remaining_length = size;
     uint8_t remaining_bytes[5], byte;
 
@@ -1601,7 +1680,7 @@ PRIVATE gbuffer_t *build_mqtt_packet(hgobj gobj, uint8_t command, uint32_t size)
         return 0;
     }
 
-    uint32_t packet_length = size + 1 + (uint8_t)remaining_count;
+    uint32_t packet_length = size - shared_size + 1 + (uint8_t)remaining_count;
 
     gbuffer_t *gbuf = gbuffer_create(packet_length, packet_length);
     if(!gbuf) {
@@ -1622,6 +1701,14 @@ PRIVATE gbuffer_t *build_mqtt_packet(hgobj gobj, uint8_t command, uint32_t size)
     return gbuf;
 }
 
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE gbuffer_t *build_mqtt_packet(hgobj gobj, uint8_t command, uint32_t size)
+{
+    return build_mqtt_packet_head(gobj, command, size, 0);
+}
+
 /***************************************************************************
     Protocol limit: 4 bytes for Remaining Length field (not 5)
     Maximum value: 268,435,455 bytes (~256 MB)
@@ -3373,10 +3460,41 @@ PRIVATE int send_packet(hgobj gobj, gbuffer_t *gbuf)
             gobj_short_name(gobj_bottom_gobj(gobj))
         );
     }
-    json_t *kw = json_pack("{s:I}",
-        "gbuffer", (json_int_t)(uintptr_t)gbuf
+    return gobj_send_event_payload(
+        gobj_bottom_gobj(gobj),
+        EV_TX_DATA,
+        0,
+        gobj_payload_create_gbuffer(gbuf),
+        gobj
+    );
+}
+
+/***************************************************************************
+ *  Send the packet head followed by a payload shared with other sessions,
+ *  the bottom writes both without copying the payload.
+ ***************************************************************************/
+PRIVATE int send_packet_shared(
+    hgobj gobj,
+    gbuffer_t *gbuf_head,   // owned
+    gbuffer_t *gbuf_shared  // owned
+) {
+    if(gobj_trace_level(gobj) & TRAFFIC) {
+        gobj_trace_dump_gbuf(gobj, gbuf_head, "%s ==> %s (head)",
+            gobj_short_name(gobj),
+            gobj_short_name(gobj_bottom_gobj(gobj))
+        );
+        gobj_trace_dump_gbuf(gobj, gbuf_shared, "%s ==> %s (shared payload)",
+            gobj_short_name(gobj),
+            gobj_short_name(gobj_bottom_gobj(gobj))
+        );
+    }
+    return gobj_send_event_payload(
+        gobj_bottom_gobj(gobj),
+        EV_TX_DATA,
+        0,
+        gobj_payload_create_gbuffer_iov(gbuf_head, gbuf_shared),
+        gobj
     );
-    return gobj_send_event(gobj_bottom_gobj(gobj), EV_TX_DATA, kw, gobj);
 }
 
 /***************************************************************************
@@ -3968,6 +4086,112 @@ PRIVATE int send__pubrel(hgobj gobj, uint16_t mid, json_t *properties)
     return send_command_with_mid(gobj, CMD_PUBREL|2, mid, FALSE, 0, properties);
 }
 
+/***************************************************************************
+ *  Copy the depths of the persistent queues to the stat gauges
+ ***************************************************************************/
+PRIVATE void sample_queue_depths(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->trq_in_msgs) {
+        tr2_queue_t *trq = priv->trq_in_msgs;
+        gobj_set_stat_slot(gobj, STAT_IN_INFLIGHT_DEPTH, (json_int_t)tr2q_inflight_size(trq));
+        gobj_set_stat_slot(gobj, STAT_IN_QUEUED_DEPTH, (json_int_t)tr2q_queued_size(trq));
+        gobj_set_stat_slot(gobj, STAT_IN_INFLIGHT_MAX, (json_int_t)tr2q_max_inflight_seen(trq));
+        gobj_set_stat_slot(gobj, STAT_IN_QUEUED_MAX, (json_int_t)tr2q_max_queued_seen(trq));
+    }
+    if(priv->trq_out_msgs) {
+        tr2_queue_t *trq = priv->trq_out_msgs;
+        gobj_set_stat_slot(gobj, STAT_OUT_INFLIGHT_DEPTH, (json_int_t)tr2q_inflight_size(trq));
+        gobj_set_stat_slot(gobj, STAT_OUT_QUEUED_DEPTH, (json_int_t)tr2q_queued_size(trq));
+        gobj_set_stat_slot(gobj, STAT_OUT_INFLIGHT_MAX, (json_int_t)tr2q_max_inflight_seen(trq));
+        gobj_set_stat_slot(gobj, STAT_OUT_QUEUED_MAX, (json_int_t)tr2q_max_queued_seen(trq));
+    }
+}
+
+/***************************************************************************
+ *  Forget the outgoing topic aliases, a new connection starts without them
+ ***************************************************************************/
+PRIVATE void reset_outgoing_aliases(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->outgoing_aliases) {
+        for(int i=1; i<=priv->outgoing_aliases_size; i++) {
+            GBMEM_FREE(priv->outgoing_aliases[i].topic)
+        }
+        GBMEM_FREE(priv->outgoing_aliases)
+    }
+    dl_init(&priv->dl_alias_lru, gobj);
+    priv->outgoing_aliases_size = 0;
+    priv->next_outgoing_alias = 1;
+}
+
+/***************************************************************************
+ *  Return the outgoing topic alias of topic, 0 if none.
+ *  alias_known is TRUE when the peer has the alias already and
+ *  the topic can be omitted. When all the aliases that the peer accepts
+ *  are in use, the least recently used is re-mapped to this topic.
+ ***************************************************************************/
+PRIVATE int outgoing_topic_alias(
+    hgobj gobj,
+    const char *topic,
+    int alias_max,
+    BOOL *alias_known
+) {
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    *alias_known = FALSE;
+
+    if(!priv->outgoing_aliases) {
+        priv->outgoing_aliases = GBMEM_MALLOC((size_t)(alias_max + 1) * sizeof(outgoing_alias_t));
+        if(!priv->outgoing_aliases) {
+            // Error already logged
+            return 0;
+        }
+        priv->outgoing_aliases_size = alias_max;
+        dl_init(&priv->dl_alias_lru, gobj);
+    }
+    alias_max = MIN(alias_max, priv->outgoing_aliases_size);
+
+    json_t *jn_alias = json_object_get(priv->jn_outgoing_alias_map, topic);
+    if(jn_alias) {
+        int alias_id = (int)json_integer_value(jn_alias);
+        outgoing_alias_t *alias = &priv->outgoing_aliases[alias_id];
+        dl_delete(&priv->dl_alias_lru, alias, 0);
+        dl_add(&priv->dl_alias_lru, alias);
+        gobj_incr_stat_slot(gobj, STAT_TX_ALIAS_HITS, 1);
+        *alias_known = TRUE;
+        return alias_id;
+    }
+
+    int alias_id;
+    outgoing_alias_t *alias;
+    if(priv->next_outgoing_alias <= alias_max) {
+        alias_id = priv->next_outgoing_alias++;
+        alias = &priv->outgoing_aliases[alias_id];
+    } else {
+        /*
+         *  Re-map the least recently used alias, the head of the lru list
+         */
+        alias = dl_first(&priv->dl_alias_lru);
+        if(!alias) {
+            return 0;
+        }
+        alias_id = (int)(alias - priv->outgoing_aliases);
+        dl_delete(&priv->dl_alias_lru, alias, 0);
+        json_object_del(priv->jn_outgoing_alias_map, alias->topic);
+        GBMEM_FREE(alias->topic)
+        gobj_incr_stat_slot(gobj, STAT_TX_ALIAS_EVICTIONS, 1);
+    }
+
+    alias->topic = gbmem_strdup(topic);
+    dl_add(&priv->dl_alias_lru, alias);
+    json_object_set_new(priv->jn_outgoing_alias_map, topic, json_integer(alias_id));
+    gobj_incr_stat_slot(gobj, STAT_TX_ALIAS_MISSES, 1);
+    return alias_id;
+}
+
 /***************************************************************************
  *
  ***************************************************************************/
@@ -4056,29 +4280,22 @@ PRIVATE int send__publish(
         int outgoing_alias_max = priv->iamServer ?
             priv->client_topic_alias_max : priv->server_topic_alias_max;
         if(topic && outgoing_alias_max > 0) {
-            json_t *jn_existing = json_object_get(priv->jn_outgoing_alias_map, topic);
-            if(jn_existing) {
-                /*
-                 *  Topic already has an alias assigned, reuse it with empty topic
-                 */
-                int alias_id = (int)json_integer_value(jn_existing);
+            BOOL alias_known = FALSE;
+            int alias_id = outgoing_topic_alias(gobj, topic, outgoing_alias_max, &alias_known);
+            if(alias_id > 0) {
                 topic_alias_prop = json_object();
                 mqtt_property_add_int16(gobj, topic_alias_prop, MQTT_PROP_TOPIC_ALIAS, alias_id);
                 proplen += property__get_length_all(topic_alias_prop);
-                /* Send empty topic: subtract topic length from packetlen */
-                packetlen -= (unsigned int)strlen(topic);
-                topic = NULL;
-            } else if(priv->next_outgoing_alias <= outgoing_alias_max) {
+            }
+            if(alias_known) {
                 /*
-                 *  Assign a new alias for this topic
+                 *  The peer knows the alias, send empty topic:
+                 *  subtract topic length from packetlen
                  */
-                int alias_id = priv->next_outgoing_alias++;
-                json_object_set_new(
-                    priv->jn_outgoing_alias_map, topic, json_integer(alias_id)
-                );
-                topic_alias_prop = json_object();
-                mqtt_property_add_int16(gobj, topic_alias_prop, MQTT_PROP_TOPIC_ALIAS, alias_id);
-                proplen += property__get_length_all(topic_alias_prop);
+                size_t topic_len = strlen(topic);
+                packetlen -= (unsigned int)topic_len;
+                gobj_incr_stat_slot(gobj, STAT_TX_ALIAS_BYTES_SAVED, (json_int_t)topic_len);
+                topic = NULL;
             }
         }
 
@@ -4126,7 +4343,18 @@ PRIVATE int send__publish(
 
     uint8_t command = (uint8_t)(CMD_PUBLISH | (uint8_t)((dup&0x1)<<3) | (uint8_t)(qos<<1) | retain);
 
-    gbuffer_t *gbuf = build_mqtt_packet(gobj, command, packetlen);
+    /*
+     *  Big payloads are not copied: the packet is the head,
+     *  and the payload gbuffer is shared by all the sessions receiving it.
+     */
+    BOOL shared_payload = (payloadlen >= MQTT_SHARED_PAYLOAD_MIN)? TRUE:FALSE;
+
+    gbuffer_t *gbuf = build_mqtt_packet_head(
+        gobj,
+        command,
+        packetlen,
+        shared_payload? (uint32_t)payloadlen:0
+    );
     if(!gbuf) {
         // Error already logged
         return MOSQ_ERR_NOMEM;
@@ -4155,6 +4383,10 @@ PRIVATE int send__publish(
     JSON_DECREF(expiry_prop);
     JSON_DECREF(topic_alias_prop);
 
+    if(shared_payload) {
+        return send_packet_shared(gobj, gbuf, gbuffer_incref(gbuf_payload));
+    }
+
     /* Payload */
     if(payloadlen) {
         mqtt_write_bytes(gbuf, payload, payloadlen);
@@ -8254,9 +8486,9 @@ PRIVATE int ac_connected(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
     priv->jn_alias_list = json_object();
     JSON_DECREF(priv->jn_outgoing_alias_map)
     priv->jn_outgoing_alias_map = json_object();
+    reset_outgoing_aliases(gobj);
     priv->client_topic_alias_max = 0;
     priv->server_topic_alias_max = 0;
-    priv->next_outgoing_alias = 1;
 
     start_wait_handshake(gobj); // include the start of the timeout of handshake
 
@@ -8355,6 +8587,7 @@ PRIVATE int ac_disconnected(hgobj gobj, gobj_event_t event, json_t *kw, hgobj sr
 
     JSON_DECREF(priv->jn_alias_list)
     JSON_DECREF(priv->jn_outgoing_alias_map)
+    reset_outgoing_aliases(gobj);
     gobj_reset_volatil_attrs(gobj);
     restore_client_attributes(gobj);
 
@@ -8384,7 +8617,7 @@ PRIVATE int ac_timeout_waiting_disconnected(hgobj gobj, gobj_event_t event, json
 PRIVATE int ac_process_handshake(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
-    gbuffer_t *gbuf = (gbuffer_t *)(uintptr_t)kw_get_int(gobj, kw, "gbuffer", 0, FALSE);
+    gbuffer_t *gbuf = gobj_event_gbuffer(gobj, kw);
     FRAME_HEAD *frame = &priv->frame_head;
     istream_h istream = priv->istream_frame;
 
@@ -8513,7 +8746,9 @@ PRIVATE int ac_process_handshake(hgobj gobj, gobj_event_t event, json_t *kw, hgo
                 gobj_change_state(gobj, ST_WAIT_PAYLOAD);
                 set_timeout(priv->gobj_timer, priv->timeout_payload);
 
-                return gobj_send_event(gobj, EV_RX_DATA, kw, gobj);
+                return gobj_send_event_payload(
+                    gobj, EV_RX_DATA, kw, gobj_payload_incref(gobj_event_payload()), gobj
+                );
 
             } else {
                 if(frame_completed(gobj, src)<0) {
@@ -8552,7 +8787,7 @@ PRIVATE int ac_timeout_wait_handshake(hgobj gobj, gobj_event_t event, json_t *kw
 PRIVATE int ac_process_frame_header(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
-    gbuffer_t *gbuf = (gbuffer_t *)(uintptr_t)kw_get_int(gobj, kw, "gbuffer", 0, FALSE);
+    gbuffer_t *gbuf = gobj_event_gbuffer(gobj, kw);
     FRAME_HEAD *frame = &priv->frame_head;
     istream_h istream = priv->istream_frame;
 
@@ -8636,7 +8871,9 @@ PRIVATE int ac_process_frame_header(hgobj gobj, gobj_event_t event, json_t *kw,
                 gobj_change_state(gobj, ST_WAIT_PAYLOAD);
                 set_timeout(priv->gobj_timer, priv->timeout_payload);
 
-                return gobj_send_event(gobj, EV_RX_DATA, kw, gobj);
+                return gobj_send_event_payload(
+                    gobj, EV_RX_DATA, kw, gobj_payload_incref(gobj_event_payload()), gobj
+                );
 
             } else {
                 if(frame_completed(gobj, src)<0) {
@@ -8668,7 +8905,7 @@ PRIVATE int ac_timeout_waiting_frame_header(hgobj gobj, gobj_event_t event, json
 PRIVATE int ac_process_payload_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
-    gbuffer_t *gbuf = (gbuffer_t *)(uintptr_t)kw_get_int(gobj, kw, "gbuffer", 0, FALSE);
+    gbuffer_t *gbuf = gobj_event_gbuffer(gobj, kw);
 
     clear_timeout(priv->gobj_timer);
 
@@ -8703,7 +8940,9 @@ PRIVATE int ac_process_payload_data(hgobj gobj, gobj_event_t event, json_t *kw,
     }
 
     if(gbuffer_leftbytes(gbuf)) {
-        return gobj_send_event(gobj, EV_RX_DATA, kw, gobj);
+        return gobj_send_event_payload(
+            gobj, EV_RX_DATA, kw, gobj_payload_incref(gobj_event_payload()), gobj
+        );
     }
 
     KW_DECREF(kw)
@@ -9360,6 +9599,8 @@ PRIVATE int ac_timeout_periodic(hgobj gobj, gobj_event_t event, json_t *kw, hgob
         priv->t_backup = start_sectimer(priv->timeout_backup);
     }
 
+    sample_queue_depths(gobj);
+
     /*
      *  FUTURE: implement a cleaner for inflight messages whose ACK has timed out.
      *  Options: re-send with DUP flag, or drop and release quota (per MQTT spec §4.4).
@@ -9421,6 +9662,7 @@ PRIVATE int ac_stopped(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
 PRIVATE const GMETHODS gmt = {
     .mt_create  = mt_create,
     .mt_writing = mt_writing,
+    .mt_stats   = mt_stats,
     .mt_destroy = mt_destroy,
     .mt_start   = mt_start,
     .mt_stop    = mt_stop,
@@ -9519,7 +9761,7 @@ PRIVATE int create_gclass(gclass_name_t gclass_name)
     };
 
     event_type_t event_types[] = {
-        {EV_RX_DATA,            0},
+        {EV_RX_DATA,            EVF_PAYLOAD},
         {EV_SEND_MESSAGE,       0},
         {EV_MQTT_PUBLISH,       0},
         {EV_MQTT_SUBSCRIBE,     0},
@@ -9558,6 +9800,7 @@ PRIVATE int create_gclass(gclass_name_t gclass_name)
         // Error already logged
         return -1;
     }
+    gclass_set_stats_table(__gclass__, stats_table);
 
     /*----------------------------------------*
      *          Register comm protocol
@@ -13,6 +13,8 @@
  *              Prototypes
  ***************************************************************/
 PRIVATE void free_msg(void *msg_);
+PRIVATE int index_add(tr2_queue_t *trq, q2_msg_t *msg);
+PRIVATE void index_delete(tr2_queue_t *trq, q2_msg_t *msg);
 /**
     Mark a message.
     You must flag a message with TR2Q_MSG_PENDING after append it to queue
@@ -24,6 +26,7 @@ PRIVATE int tr2q_set_hard_flag(q2_msg_t *msg, uint16_t hard_mark, BOOL set);
 /***************************************************************
  *              Data
  ***************************************************************/
+#define TR2Q_INDEX_MIN_SIZE 64
 
 /********************************************************************
  * String Functions
@@ -190,6 +193,8 @@ PUBLIC void tr2q_close(tr2_queue_t *trq)
 {
     dl_flush(&((tr2_queue_t *)trq)->dl_inflight, free_msg);
     dl_flush(&((tr2_queue_t *)trq)->dl_queued, free_msg);
+    GBMEM_FREE(trq->mid_index);
+    GBMEM_FREE(trq->rowid_index);
     GBMEM_FREE(trq);
 }
 
@@ -226,6 +231,165 @@ PRIVATE void tr2q_set_first_rowid(tr2_queue_t *trq, uint64_t first_rowid)
     }
 }
 
+/***************************************************************************
+    Bucket of a mid or a rowid, index_size is a power of two
+ ***************************************************************************/
+static inline size_t mid_bucket(tr2_queue_t *trq, uint16_t mid)
+{
+    return (size_t)mid & (trq->index_size - 1);
+}
+static inline size_t rowid_bucket(tr2_queue_t *trq, json_int_t rowid)
+{
+    return (size_t)rowid & (trq->index_size - 1);
+}
+
+/***************************************************************************
+    Add a message to the mid index.
+    mid 0 is not a packet identifier: the outbound messages are queued
+    with mid 0 until they are released, they are not indexed by mid,
+    otherwise all of them would chain in bucket 0.
+ ***************************************************************************/
+static inline void mid_index_add(tr2_queue_t *trq, q2_msg_t *msg)
+{
+    if(msg->mid == 0) {
+        msg->mid_next = NULL;
+        return;
+    }
+    size_t b = mid_bucket(trq, msg->mid);
+    msg->mid_next = trq->mid_index[b];
+    trq->mid_index[b] = msg;
+}
+
+/***************************************************************************
+    Rebuild the indexes with a new size
+ ***************************************************************************/
+PRIVATE int index_resize(tr2_queue_t *trq, size_t new_size)
+{
+    hgobj gobj = 0;
+
+    q2_msg_t **mid_index = GBMEM_MALLOC(new_size * sizeof(q2_msg_t *));
+    q2_msg_t **rowid_index = GBMEM_MALLOC(new_size * sizeof(q2_msg_t *));
+    if(!mid_index || !rowid_index) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY,
+            "msg",          "%s", "Cannot resize tr_queue indexes. GBMEM_MALLOC() FAILED",
+            "topic",        "%s", trq->topic_name,
+            "size",         "%d", (int)new_size,
+            NULL
+        );
+        GBMEM_FREE(mid_index);
+        GBMEM_FREE(rowid_index);
+        return -1;
+    }
+
+    GBMEM_FREE(trq->mid_index);
+    GBMEM_FREE(trq->rowid_index);
+    trq->mid_index = mid_index;
+    trq->rowid_index = rowid_index;
+    trq->index_size = new_size;
+
+    /*
+     *  Every message is in one of the two lists
+     */
+    dl_list_t *lists[2] = {&trq->dl_inflight, &trq->dl_queued};
+    for(int i=0; i<2; i++) {
+        q2_msg_t *msg = dl_first(lists[i]);
+        while(msg) {
+            mid_index_add(trq, msg);
+
+            size_t b = rowid_bucket(trq, msg->rowid);
+            msg->rowid_next = trq->rowid_index[b];
+            trq->rowid_index[b] = msg;
+
+            msg = dl_next(msg);
+        }
+    }
+    trq->index_count = dl_size(&trq->dl_inflight) + dl_size(&trq->dl_queued);
+    return 0;
+}
+
+/***************************************************************************
+    Add a message to the indexes, it must be already in one of the lists
+ ***************************************************************************/
+PRIVATE int index_add(tr2_queue_t *trq, q2_msg_t *msg)
+{
+    if(trq->index_count >= trq->index_size) {
+        size_t new_size = trq->index_size? trq->index_size*2 : TR2Q_INDEX_MIN_SIZE;
+        if(index_resize(trq, new_size)<0) {
+            // Error already logged
+            return -1;
+        }
+        // The message is already in a list, the resize has indexed it
+        return 0;
+    }
+
+    mid_index_add(trq, msg);
+
+    size_t b = rowid_bucket(trq, msg->rowid);
+    msg->rowid_next = trq->rowid_index[b];
+    trq->rowid_index[b] = msg;
+
+    trq->index_count++;
+    return 0;
+}
+
+/***************************************************************************
+    Remove a message from the mid index
+ ***************************************************************************/
+PRIVATE void mid_index_delete(tr2_queue_t *trq, q2_msg_t *msg)
+{
+    if(!trq->mid_index || msg->mid == 0) {
+        return;
+    }
+    q2_msg_t **pp = &trq->mid_index[mid_bucket(trq, msg->mid)];
+    while(*pp) {
+        if(*pp == msg) {
+            *pp = msg->mid_next;
+            msg->mid_next = NULL;
+            return;
+        }
+        pp = &(*pp)->mid_next;
+    }
+}
+
+/***************************************************************************
+    Remove a message from the indexes
+ ***************************************************************************/
+PRIVATE void index_delete(tr2_queue_t *trq, q2_msg_t *msg)
+{
+    if(!trq->rowid_index) {
+        return;
+    }
+    mid_index_delete(trq, msg);
+
+    q2_msg_t **pp = &trq->rowid_index[rowid_bucket(trq, msg->rowid)];
+    while(*pp) {
+        if(*pp == msg) {
+            *pp = msg->rowid_next;
+            msg->rowid_next = NULL;
+            trq->index_count--;
+            return;
+        }
+        pp = &(*pp)->rowid_next;
+    }
+}
+
+/***************************************************************************
+    Update the high-water marks of the lists
+ ***************************************************************************/
+static inline void update_depth_marks(tr2_queue_t *trq)
+{
+    size_t n = tr2q_inflight_size(trq);
+    if(n > trq->max_inflight_seen) {
+        trq->max_inflight_seen = n;
+    }
+    n = tr2q_queued_size(trq);
+    if(n > trq->max_queued_seen) {
+        trq->max_queued_seen = n;
+    }
+}
+
 /***************************************************************************
     New msg in memory
  ***************************************************************************/
@@ -276,6 +440,8 @@ PRIVATE q2_msg_t *new_msg(
         msg->inflight = FALSE;
         KW_DECREF(kw_record)
     }
+    index_add(trq, msg);
+    update_depth_marks(trq);
 
     return msg;
 }
@@ -286,6 +452,7 @@ PRIVATE q2_msg_t *new_msg(
 PRIVATE void free_msg(void *msg_)
 {
     q2_msg_t *msg = msg_;
+    index_delete(msg->trq, msg);
     KW_DECREF(msg->kw_record)
     memset(msg, 0, sizeof(q2_msg_t));
     GBMEM_FREE(msg);
@@ -571,6 +738,7 @@ PUBLIC int tr2q_move_from_queued_to_inflight(q2_msg_t *msg)
     dl_add(&trq->dl_inflight, msg);
     json_t *kw_mqtt_msg = tr2q_msg_json(msg); // Load the message
     msg->inflight = TRUE;
+    update_depth_marks(trq);
 
     return kw_mqtt_msg?0:-1;
 }
@@ -596,19 +764,16 @@ PUBLIC int tr2q_unload_msg(q2_msg_t *msg, int32_t result)
  ***************************************************************************/
 PUBLIC q2_msg_t *tr2q_get_by_rowid(tr2_queue_t *trq, uint64_t rowid)
 {
-    register q2_msg_t *msg;
-
-    Q2MSG_FOREACH_FORWARD_INFLIGHT(trq, msg) {
-        if(msg->rowid == rowid) {
-            msg->inflight = TRUE;
-            return msg;
-        }
+    if(!trq->rowid_index) {
+        return NULL;
     }
-    Q2MSG_FOREACH_FORWARD_QUEUED(trq, msg) {
-        if(msg->rowid == rowid) {
-            msg->inflight = FALSE;
+
+    register q2_msg_t *msg = trq->rowid_index[rowid_bucket(trq, (json_int_t)rowid)];
+    while(msg) {
+        if((uint64_t)msg->rowid == rowid) {
             return msg;
         }
+        msg = msg->rowid_next;
     }
 
     return NULL;
@@ -619,22 +784,58 @@ PUBLIC q2_msg_t *tr2q_get_by_rowid(tr2_queue_t *trq, uint64_t rowid)
  ***************************************************************************/
 PUBLIC q2_msg_t *tr2q_get_by_mid(tr2_queue_t *trq, json_int_t mid)
 {
-    register q2_msg_t *msg;
+    if(!trq->mid_index || mid <= 0 || mid > 0xFFFF) {
+        return NULL;
+    }
 
-    Q2MSG_FOREACH_FORWARD_INFLIGHT(trq, msg) {
+    /*
+     *  Same choice as walking the inflight list and then the queued list:
+     *  inflight first, the older (lower rowid) first.
+     */
+    q2_msg_t *found = NULL;
+    register q2_msg_t *msg = trq->mid_index[mid_bucket(trq, (uint16_t)mid)];
+    while(msg) {
         if(msg->mid == mid) {
-            msg->inflight = TRUE;
-            return msg;
+            if(!found ||
+                (msg->inflight && !found->inflight) ||
+                (msg->inflight == found->inflight && msg->rowid < found->rowid)
+            ) {
+                found = msg;
+            }
         }
+        msg = msg->mid_next;
     }
-    Q2MSG_FOREACH_FORWARD_QUEUED(trq, msg) {
-        if(msg->mid == mid) {
-            msg->inflight = FALSE;
-            return msg;
-        }
+
+    return found;
+}
+
+/***************************************************************************
+    Change the mid of a message, keeping the mid index updated
+ ***************************************************************************/
+PUBLIC void tr2q_set_mid(q2_msg_t *msg, uint16_t mid)
+{
+    tr2_queue_t *trq = msg->trq;
+
+    if(msg->mid == mid) {
+        return;
+    }
+    if(!trq->mid_index) {
+        msg->mid = mid;
+        return;
     }
 
-    return NULL;
+    mid_index_delete(trq, msg);
+    msg->mid = mid;
+    mid_index_add(trq, msg);
+}
+
+/***************************************************************************
+    Reset the high-water marks of the lists to the current sizes
+ ***************************************************************************/
+PUBLIC void tr2q_reset_depth_marks(tr2_queue_t *trq)
+{
+    trq->max_inflight_seen = tr2q_inflight_size(trq);
+    trq->max_queued_seen = tr2q_queued_size(trq);
 }
 
 /***************************************************************************
@@ -30,15 +30,31 @@ typedef struct {
     dl_list_t dl_queued;    // Queue with messages in disk, avoiding overload of memory.
     uint64_t first_rowid;
     BOOL verbose;
+
+    /*
+     *  Indexes of the messages of both lists, by mid and by rowid.
+     *  Chained hash tables with a power of two buckets, sharing size and count.
+     *  mids are 16 bits: with 64K buckets the mid index is direct-mapped.
+     *  Messages with mid 0 (outbound, not released yet) are not in the mid index.
+     */
+    struct q2_msg_s **mid_index;
+    struct q2_msg_s **rowid_index;
+    size_t index_size;
+    size_t index_count;
+
+    size_t max_inflight_seen;   // High-water marks of the lists, see tr2q_reset_depth_marks()
+    size_t max_queued_seen;
 } tr2_queue_t;
 
-typedef struct {
+typedef struct q2_msg_s {
     DL_ITEM_FIELDS
 
     tr2_queue_t *trq;
+    struct q2_msg_s *mid_next;      // chain in trq->mid_index
+    struct q2_msg_s *rowid_next;    // chain in trq->rowid_index
     md2_record_ex_t md_record;
     json_int_t rowid;       // global rowid that it must match the rowid in md_record
-    uint16_t mid;           // Yes, it's an ease for mqtt protocol
+    uint16_t mid;           // Yes, it's an ease for mqtt protocol. Change it with tr2q_set_mid()
     BOOL inflight;          // True if it's in inflight dl_list, otherwise in the queued dl_list
     json_t *kw_record;      // It may have gbuffer
 } q2_msg_t;
@@ -167,9 +183,22 @@ PUBLIC q2_msg_t *tr2q_get_by_rowid(tr2_queue_t *trq, uint64_t rowid);
 
 /**
     Get a message from iter by his mid
+    If several messages have the same mid, the inflight one with the lowest rowid is returned.
+    mid 0 is not a packet identifier, it's never found.
 */
 PUBLIC q2_msg_t *tr2q_get_by_mid(tr2_queue_t *trq, json_int_t mid);
 
+/**
+    Change the mid of a message, keeping the mid index updated.
+    Don't write msg->mid directly.
+*/
+PUBLIC void tr2q_set_mid(q2_msg_t *msg, uint16_t mid);
+
+/**
+    Reset the high-water marks of the lists to the current sizes
+*/
+PUBLIC void tr2q_reset_depth_marks(tr2_queue_t *trq);
+
 /**
     Get the message content
  */
@@ -219,6 +248,22 @@ static inline size_t tr2q_queued_size(tr2_queue_t *trq)
     return dl_size(&trq->dl_queued);
 }
 
+/**
+    Return the maximum number of inflight messages seen
+*/
+static inline size_t tr2q_max_inflight_seen(tr2_queue_t *trq)
+{
+    return trq->max_inflight_seen;
+}
+
+/**
+    Return the maximum number of queued messages seen
+*/
+static inline size_t tr2q_max_queued_seen(tr2_queue_t *trq)
+{
+    return trq->max_queued_seen;
+}
+
 /**
     Return tranger of queue
 */
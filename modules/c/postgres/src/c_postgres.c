@@ -52,6 +52,7 @@ object ...  =>  text
  ***********************************************************************/
 #include <string.h>
 #include <stdio.h>
+#include <poll.h>
 #include <libpq-fe.h>
 #include "c_postgres.h"
 
@@ -68,6 +69,9 @@ object ...  =>  text
 #define NUMERICOID      1700    // numeric          NaN and infinity values are disallowed
 #define JSONOID         114     // json
 
+#define MAX_PIPELINE_DEPTH  256
+#define COPY_CHUNK_SIZE     (64*1024)
+
 /***************************************************************************
  *              Structures
  ***************************************************************************/
@@ -75,12 +79,11 @@ object ...  =>  text
 /***************************************************************************
  *              Prototypes
  ***************************************************************************/
-// TODO peding to migrated to V7
-//PRIVATE void on_poll_cb(uv_poll_t *req, int status, int events);
-// PRIVATE int process_result(hgobj gobj, PGresult* result);
-// PRIVATE int publish_result(hgobj gobj, json_t *kw);
+PRIVATE int yev_callback(yev_event_h yev_event);
+PRIVATE void stop_polls(hgobj gobj);
+PRIVATE void reset_connection_state(hgobj gobj);
+PRIVATE int publish_result(hgobj gobj, json_t *kw);
 PRIVATE int pull_queue(hgobj gobj);
-PRIVATE int send_cur_query(hgobj gobj);
 
 /***************************************************************************
  *          Data: config, public data, private data
@@ -128,6 +131,8 @@ SDATA (DTP_BOOLEAN,     "manual",                       SDF_RD,         0,
 SDATA (DTP_INTEGER,     "timeout_waiting_connected",    SDF_RD,         "10000",        ""),
 SDATA (DTP_INTEGER,     "timeout_between_connections",  SDF_RD,         "5000",         "Idle timeout to wait between attempts of connection"),
 SDATA (DTP_INTEGER,     "timeout_response",             SDF_WR,         "10000",        "Timeout response"),
+SDATA (DTP_INTEGER,     "pipeline_depth",               SDF_PERSIST|SDF_WR,"1",         "Queries in flight without waiting their results (libpq pipeline mode), 1 is one query at a time. Applied in the next connection"),
+SDATA (DTP_INTEGER,     "queries_pending",              SDF_RD|SDF_STATS,"0",           "Queries queued or in flight, without result yet"),
 
 SDATA (DTP_POINTER,     "user_data",        0,                          0,              "user data"),
 SDATA (DTP_POINTER,     "user_data2",       0,                          0,              "more user data"),
@@ -163,15 +168,29 @@ SDATA_END()
  *---------------------------------------------*/
 typedef struct _PRIVATE_DATA {
     int32_t timeout_response;
+    int32_t pipeline_depth;
     hgobj timer;
 
     PGconn *conn;
-    // uv_poll_t uv_poll;
+    yev_event_h yev_poll_rx;
+    yev_event_h yev_poll_tx;
     int pg_socket;
     BOOL inform_disconnected;
 
     json_t *dl_queries;
-    json_t *cur_query;
+    json_t *dl_in_flight;       // queries sent, in order, waiting their results
+    int queries_in_flight;
+    int max_in_flight;
+    BOOL pipeline_mode;
+    int pending_syncs;
+
+    json_t *jn_prepared;        // sql: statement name, prepared in this connection
+    int prepared_seq;
+
+    BOOL copy_in_progress;
+    const char *copy_data;
+    size_t copy_len;
+    size_t copy_offset;
 } PRIVATE_DATA;
 
 
@@ -193,6 +212,8 @@ PRIVATE void mt_create(hgobj gobj)
 
     priv->timer = gobj_create_pure_child(gobj_name(gobj), C_TIMER, 0, gobj);
     priv->dl_queries = json_array();
+    priv->dl_in_flight = json_array();
+    priv->jn_prepared = json_object();
 
     /*
      *  SERVICE subscription model
@@ -210,6 +231,7 @@ PRIVATE void mt_create(hgobj gobj)
      *  HACK The writable attributes must be repeated in mt_writing method.
      */
     SET_PRIV(timeout_response,            gobj_read_integer_attr)
+    SET_PRIV(pipeline_depth,              gobj_read_integer_attr)
 }
 
 /***************************************************************************
@@ -220,9 +242,26 @@ PRIVATE void mt_writing(hgobj gobj, const char *path)
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
     IF_EQ_SET_PRIV(timeout_response,              gobj_read_integer_attr)
+    ELIF_EQ_SET_PRIV(pipeline_depth,            gobj_read_integer_attr)
     END_EQ_SET_PRIV()
 }
 
+/***************************************************************************
+ *      Framework Method reading
+ ***************************************************************************/
+PRIVATE SData_Value_t mt_reading(hgobj gobj, const char *name)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    SData_Value_t v = {0,{0}};
+    if(strcmp(name, "queries_pending")==0) {
+        v.found = 1;
+        v.v.i = (json_int_t)json_array_size(priv->dl_queries) + priv->queries_in_flight;
+    }
+
+    return v;
+}
+
 /***************************************************************************
  *      Framework Method destroy
  ***************************************************************************/
@@ -230,17 +269,21 @@ PRIVATE void mt_destroy(hgobj gobj)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    if(json_array_size(priv->dl_queries)) {
+    if(json_array_size(priv->dl_queries) || json_array_size(priv->dl_in_flight)) {
         gobj_log_error(gobj, 0,
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_INTERNAL,
             "msg",          "%s", "records LOST",
             NULL
         );
+        gobj_trace_json(gobj, priv->dl_in_flight, "records LOST");
         gobj_trace_json(gobj, priv->dl_queries, "records LOST");
     }
+    EXEC_AND_RESET(yev_destroy_event, priv->yev_poll_rx)
+    EXEC_AND_RESET(yev_destroy_event, priv->yev_poll_tx)
     JSON_DECREF(priv->dl_queries);
-    JSON_DECREF(priv->cur_query);
+    JSON_DECREF(priv->dl_in_flight);
+    JSON_DECREF(priv->jn_prepared);
 }
 
 /***************************************************************************
@@ -267,14 +310,12 @@ PRIVATE int mt_stop(hgobj gobj)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
+    stop_polls(gobj);
     if(priv->conn) {
         PQfinish(priv->conn);
         priv->conn = 0;
-        if(priv->pg_socket != -1) {
-            // uv_poll_stop(&priv->uv_poll);
-            // uv_close((uv_handle_t*)&priv->uv_poll, on_close_cb);
-            priv->pg_socket = -1;
-        }
+        priv->pg_socket = -1;
+        reset_connection_state(gobj);
     }
     clear_timeout(priv->timer);
     return 0;
@@ -334,7 +375,10 @@ PRIVATE json_t *cmd_list_size(hgobj gobj, const char *cmd, json_t *kw, hgobj src
     return msg_iev_build_response(
         gobj,
         0,
-        json_sprintf("Messages in queue: %d", (int)json_array_size(priv->dl_queries)),
+        json_sprintf("Messages in queue: %d, in flight: %d",
+            (int)json_array_size(priv->dl_queries),
+            priv->queries_in_flight
+        ),
         0,
         0, // owned
         kw  // owned
@@ -412,12 +456,153 @@ PRIVATE void noticeProcessor(void *arg, const char *message)
 }
 
 /***************************************************************************
+ *  Arm the poll of the postgres socket: POLLOUT if tx else POLLIN
+ ***************************************************************************/
+PRIVATE void start_poll(hgobj gobj, BOOL tx)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(!priv->conn) {
+        return;
+    }
+    int fd = PQsocket(priv->conn); // can change while connecting
+    if(fd < 0) {
+        return;
+    }
+    priv->pg_socket = fd;
+
+    yev_event_h *pyev = tx? &priv->yev_poll_tx : &priv->yev_poll_rx;
+    if(!*pyev) {
+        *pyev = yev_create_poll_event(
+            yuno_event_loop(),
+            yev_callback,
+            gobj,
+            fd,
+            tx? POLLOUT:POLLIN
+        );
+        if(!*pyev) {
+            // Error already logged
+            return;
+        }
+    }
+    if(yev_event_is_idle(*pyev) || yev_event_is_stopped(*pyev)) {
+        yev_set_fd(*pyev, fd);
+        yev_start_event(*pyev);
+    }
+}
+
+/***************************************************************************
+ *  Stop the polls, libpq is going to close the socket
+ ***************************************************************************/
+PRIVATE void stop_polls(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->yev_poll_rx && yev_event_is_running(priv->yev_poll_rx)) {
+        yev_stop_event(priv->yev_poll_rx);
+    }
+    if(priv->yev_poll_tx && yev_event_is_running(priv->yev_poll_tx)) {
+        yev_stop_event(priv->yev_poll_tx);
+    }
+}
+
+/***************************************************************************
+ *  Answer a query with an error result
+ ***************************************************************************/
+PRIVATE int fail_query(hgobj gobj, json_t *kw_query, const char *comment) // owned
+{
+    json_object_set_new(kw_query, "result", json_integer(-1));
+    json_object_set_new(kw_query, "comment", json_string(comment));
+    json_object_del(kw_query, "copy_data"); // Don't return the data
+
+    if(gobj_trace_level(gobj) & TRACE_MESSAGES) {
+        const char *dst = kw_get_str(gobj, kw_query, "dst", "", 0);
+        gobj_trace_json(gobj, kw_query, "🗂🗂Postgres RESULT ⏪ 🔴 ERROR, dst '%s'", dst?dst:"");
+    }
+    return publish_result(gobj, kw_query);
+}
+
+/***************************************************************************
+ *  The connection is gone, prepared statements and pipeline belong to it.
  *
+ *  Only the queries never sent go back to the head of the queue. A query
+ *  sent has an unknown result (its commit can be done in the server), it's
+ *  answered with an error, never executed twice.
+ *  The queries of a "session" are answered with an error too, sent or not:
+ *  their transaction was in the lost connection.
+ *
+ *  Call it with the connection closed: the results are published here.
  ***************************************************************************/
-// PRIVATE void set_connected(hgobj gobj)
-// {
-//     gobj_send_event(gobj, EV_CONNECTED, 0, gobj);
-// }
+PRIVATE void reset_connection_state(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_t *dl_in_flight = priv->dl_in_flight;
+    priv->dl_in_flight = json_array();
+    priv->queries_in_flight = 0;
+
+    json_object_clear(priv->jn_prepared);
+    priv->pipeline_mode = FALSE;
+    priv->pending_syncs = 0;
+
+    priv->copy_in_progress = FALSE;
+    priv->copy_data = NULL;
+    priv->copy_len = 0;
+    priv->copy_offset = 0;
+
+    json_t *dl_unsent = json_array();
+    json_t *dl_lost = json_array();
+
+    size_t idx; json_t *kw_query;
+    json_array_foreach(dl_in_flight, idx, kw_query) {
+        if(kw_has_key(kw_query, "__prepare__")) {
+            /*
+             *  The queries waiting here their statement, not sent
+             */
+            size_t i; json_t *kw_waiting;
+            json_array_foreach(kw_get_list(gobj, kw_query, "__queries__", 0, 0), i, kw_waiting) {
+                if(kw_has_key(kw_waiting, "session")) {
+                    json_array_append(dl_lost, kw_waiting);
+                } else {
+                    json_array_append(dl_unsent, kw_waiting);
+                }
+            }
+            continue;
+        }
+        json_array_append(dl_lost, kw_query);
+    }
+    JSON_DECREF(dl_in_flight)
+
+    /*
+     *  The queued queries of a session don't go to the next connection
+     */
+    idx = 0;
+    while(idx < json_array_size(priv->dl_queries)) {
+        kw_query = json_array_get(priv->dl_queries, idx);
+        if(kw_has_key(kw_query, "session")) {
+            json_array_append(dl_lost, kw_query);
+            json_array_remove(priv->dl_queries, idx);
+            continue;
+        }
+        idx++;
+    }
+
+    json_array_foreach(dl_unsent, idx, kw_query) {
+        json_array_insert(priv->dl_queries, idx, kw_query);
+    }
+    JSON_DECREF(dl_unsent)
+
+    json_array_foreach(dl_lost, idx, kw_query) {
+        fail_query(
+            gobj,
+            json_incref(kw_query),
+            kw_has_key(kw_query, "session")?
+                "Connection lost, session transaction aborted" :
+                "Connection lost, result unknown"
+        );
+    }
+    JSON_DECREF(dl_lost)
+}
 
 /***************************************************************************
  *
@@ -426,204 +611,819 @@ PRIVATE void set_disconnected(hgobj gobj)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
+    stop_polls(gobj);
+
     if(priv->conn) {
         PQfinish(priv->conn);
         priv->conn = 0;
     }
-    if(priv->pg_socket != -1) {
-        // uv_poll_stop(&priv->uv_poll);
-        // uv_close((uv_handle_t*)&priv->uv_poll, on_close_cb);
-        priv->pg_socket = -1;
-    }
+    priv->pg_socket = -1;
 
     set_timeout(priv->timer, 5*1000);
     gobj_change_state(gobj, ST_WAIT_DISCONNECTED);
+
+    reset_connection_state(gobj);
+
     gobj_send_event(gobj, EV_DISCONNECTED, 0, gobj);
 }
 
 /***************************************************************************
- *  on poll callback
+ *  Pipeline mode: the queries are sent without waiting the results
+ *  of the previous ones, one sync point by query.
+ ***************************************************************************/
+PRIVATE int enter_pipeline_mode(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(!PQenterPipelineMode(priv->conn)) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_POSTGRES,
+            "msg",          "%s", "PQenterPipelineMode FAILED, one query at a time",
+            "error",        "%s", PQerrorMessage(priv->conn),
+            NULL
+        );
+        priv->max_in_flight = 1;
+        return -1;
+    }
+    priv->pipeline_mode = TRUE;
+    return 0;
+}
+
+/***************************************************************************
+ *  Send the buffered output
+ ***************************************************************************/
+PRIVATE int flush_output(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    int ret = PQflush(priv->conn);
+    if(ret < 0) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_POSTGRES,
+            "msg",          "%s", "PQflush() FAILED",
+            "error",        "%s", PQerrorMessage(priv->conn),
+            NULL
+        );
+        set_disconnected(gobj);
+        return -1;
+    }
+    if(ret > 0) {
+        // More data to send, continue when the socket is writable
+        start_poll(gobj, TRUE);
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Send the COPY FROM STDIN data of the query in progress
+ ***************************************************************************/
+PRIVATE int continue_copy(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    while(priv->copy_offset < priv->copy_len) {
+        int ln = (int)MIN(priv->copy_len - priv->copy_offset, COPY_CHUNK_SIZE);
+        int ret = PQputCopyData(priv->conn, priv->copy_data + priv->copy_offset, ln);
+        if(ret < 0) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_POSTGRES,
+                "msg",          "%s", "PQputCopyData FAILED",
+                "error",        "%s", PQerrorMessage(priv->conn),
+                NULL
+            );
+            set_disconnected(gobj);
+            return -1;
+        }
+        if(ret == 0) {
+            // Output buffer full, continue when the socket is writable
+            start_poll(gobj, TRUE);
+            return 0;
+        }
+        priv->copy_offset += (size_t)ln;
+    }
+
+    int ret = PQputCopyEnd(priv->conn, NULL);
+    if(ret < 0) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_POSTGRES,
+            "msg",          "%s", "PQputCopyEnd FAILED",
+            "error",        "%s", PQerrorMessage(priv->conn),
+            NULL
+        );
+        set_disconnected(gobj);
+        return -1;
+    }
+    if(ret == 0) {
+        start_poll(gobj, TRUE);
+        return 0;
+    }
+    priv->copy_data = NULL;
+    priv->copy_len = 0;
+    priv->copy_offset = 0;
+
+    return flush_output(gobj);
+}
+
+/***************************************************************************
+ *  Sync point of the last query sent in pipeline mode
+ ***************************************************************************/
+PRIVATE void pipeline_sync(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(PQpipelineSync(priv->conn)) {
+        priv->pending_syncs++;
+    } else {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_POSTGRES,
+            "msg",          "%s", "PQpipelineSync FAILED",
+            "error",        "%s", PQerrorMessage(priv->conn),
+            NULL
+        );
+    }
+}
+
+/***************************************************************************
+ *  The PREPARE of the sql waiting its result, NULL if none
+ ***************************************************************************/
+PRIVATE json_t *prepare_in_flight(hgobj gobj, const char *query)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    size_t idx; json_t *kw_prepare;
+    json_array_foreach(priv->dl_in_flight, idx, kw_prepare) {
+        if(kw_has_key(kw_prepare, "__prepare__") &&
+                strcmp(kw_get_str(gobj, kw_prepare, "query", "", 0), query)==0) {
+            return kw_prepare;
+        }
+    }
+    return NULL;
+}
+
+/***************************************************************************
+ *  Query parameters in text format, NULL for json null
  ***************************************************************************/
-// PRIVATE void on_poll_cb(uv_poll_t *req, int status, int events)
-// {
-//     hgobj gobj = req->data;
-//     PRIVATE_DATA *priv = gobj_priv_data(gobj);
-//
-//     if(gobj_trace_level(gobj) & TRACE_UV) {
-//         log_debug_printf(0, "<<<< on_poll_cb status %d, events %d, fd %d",
-//             status, events, priv->pg_socket
-//         );
-//     }
-//
-//     if(status < 0) {
-//         gobj_log_error(gobj, 0,
-//             "function",     "%s", __FUNCTION__,
-//             "msgset",       "%s", MSGSET_LIBURING,
-//             "msg",          "%s", "poll FAILED",
-//             "uv_error",     "%s", uv_err_name(status),
-//             NULL
-//         );
-//         set_disconnected(gobj);
-//         return;
-//     }
-//
-//     const char *state = gobj_current_state(gobj);
-//     SWITCHS(state) {
-//         CASES(ST_CONNECTED)
-//             if(PQstatus(priv->conn) != CONNECTION_OK) {
-//                 gobj_log_error(gobj, 0,
-//                     "function",     "%s", __FUNCTION__,
-//                     "msgset",       "%s", MSGSET_POSTGRES,
-//                     "msg",          "%s", "Postgres connection closed 1",
-//                     "error",        "%s", PQerrorMessage(priv->conn),
-//                     NULL
-//                 );
-//                 set_disconnected(gobj);
-//                 return;
-//             }
-//             if(events & UV_READABLE) {
-//                 do {
-//                     if(PQconsumeInput(priv->conn)) {
-//                         if(!PQisBusy(priv->conn)) {
-//                             PGresult* result = PQgetResult(priv->conn);
-//                             if(result) {
-//                                 // HACK Repeat PQgetResult, must return null
-//                                 // Don't use multiquery or PQsetSingleRowMode
-//                                 if(!PQgetResult(priv->conn)) {
-//                                     process_result(gobj, result);
-//                                     PQclear(result);
-//                                     pull_queue(gobj);
-//                                 } else {
-//                                     /*
-//                                      *  WARNING
-//                                      *  NO se puede usar multiquery
-//                                      */
-//                                     gobj_log_error(gobj, 0,
-//                                         "function",     "%s", __FUNCTION__,
-//                                         "msgset",       "%s", MSGSET_POSTGRES,
-//                                         "msg",          "%s", "Postgres Multiple Results or disconnected",
-//                                         NULL
-//                                     );
-//                                     /*
-//                                      *  WARNING
-//                                      *  Por aquí crash cuando se desconecta postgres
-//                                      */
-//                                     set_disconnected(gobj);
-//                                     return;
-//                                 }
-//                                 break;
-//                             } else {
-//                                 /*
-//                                  *  WARNING
-//                                  *  Por aquí se queda en bucle cuando se desconecta postgres
-//                                  */
-//                                 gobj_log_error(gobj, 0,
-//                                     "function",     "%s", __FUNCTION__,
-//                                     "msgset",       "%s", MSGSET_POSTGRES,
-//                                     "msg",          "%s", "Avoid LOOP?",
-//                                     NULL
-//                                 );
-//                                 set_disconnected(gobj);
-//                                 return;
-//                             }
-//                         }
-//
-//                         /*
-//                          *  After read try to write
-//                          */
-//                         int ret = PQflush(priv->conn);
-//                         if(ret < 0) {
-//                             gobj_log_error(gobj, 0,
-//                                 "function",     "%s", __FUNCTION__,
-//                                 "msgset",       "%s", MSGSET_POSTGRES,
-//                                 "msg",          "%s", "PQflush() FAILED",
-//                                 NULL
-//                             );
-//                             set_disconnected(gobj);
-//                         }
-//                     } else {
-//                         gobj_log_error(gobj, 0,
-//                             "function",     "%s", __FUNCTION__,
-//                             "msgset",       "%s", MSGSET_POSTGRES,
-//                             "msg",          "%s", "PQconsumeInput FAILED",
-//                             "error",        "%s", PQerrorMessage(priv->conn),
-//                             NULL
-//                         );
-//                         set_disconnected(gobj);
-//                         return;
-//                     }
-//                 } while(0);
-//             }
-//
-//             if(events & UV_WRITABLE) {
-//                 int ret = PQflush(priv->conn);
-//                 if(ret < 0) {
-//                     gobj_log_error(gobj, 0,
-//                         "function",     "%s", __FUNCTION__,
-//                         "msgset",       "%s", MSGSET_POSTGRES,
-//                         "msg",          "%s", "PQflush() FAILED",
-//                         NULL
-//                     );
-//                     set_disconnected(gobj);
-//                 } else if(ret == 0) {
-//                     // No more data to send, put off UV_WRITABLE
-//                     uv_poll_start(&priv->uv_poll, UV_READABLE, on_poll_cb);
-//                 } else {
-//                     // == 1 more data to send, continue with UV_WRITABLE
-//                 }
-//             }
-//
-//             break;
-//
-//         CASES(ST_WAIT_CONNECTED)
-//             PostgresPollingStatusType st = PQconnectPoll(priv->conn);
-//             if(gobj_trace_level(gobj) & TRACE_UV) {
-//                 log_debug_printf(0, "<<<< ST_WAIT_CONNECTED PQconnectPoll %d", st);
-//             }
-//             switch (st) {
-//             case PGRES_POLLING_OK:
-//                 uv_poll_start(&priv->uv_poll, UV_READABLE|UV_WRITABLE, on_poll_cb);
-//                 set_connected(gobj);
-//                 return;
-//
-//             case PGRES_POLLING_READING:
-//                 uv_poll_start(&priv->uv_poll, UV_READABLE, on_poll_cb);
-//                 return;
-//             case PGRES_POLLING_WRITING:
-//                 uv_poll_start(&priv->uv_poll, UV_WRITABLE, on_poll_cb);
-//                 return;
-//             case PGRES_POLLING_ACTIVE:
-//                 return;
-//             case PGRES_POLLING_FAILED:
-//                 gobj_log_error(gobj, 0,
-//                     "function",     "%s", __FUNCTION__,
-//                     "msgset",       "%s", MSGSET_LIBURING,
-//                     "msg",          "%s", "Postgres connection FAILED",
-//                     "error",        "%s", PQerrorMessage(priv->conn),
-//                     NULL
-//                 );
-//                 set_disconnected(gobj);
-//             }
-//             break;
-//
-//         CASES(ST_WAIT_DISCONNECTED)
-//             PostgresPollingStatusType st = PQconnectPoll(priv->conn);
-//             if(gobj_trace_level(gobj) & TRACE_UV) {
-//                 log_debug_printf(0, "<<<< ST_WAIT_DISCONNECTED PQconnectPoll %d", st);
-//             }
-//             break;
-//
-//         DEFAULTS
-//             gobj_log_error(gobj, 0,
-//                 "function",     "%s", __FUNCTION__,
-//                 "msgset",       "%s", MSGSET_PARAMETER,
-//                 "msg",          "%s", "state UNKNOWN",
-//                 "state",        "%s", state,
-//                 NULL
-//             );
-//             break;
-//     } SWITCHS_END;
-// }
+PRIVATE char **build_params(hgobj gobj, json_t *jn_params, int nparams)
+{
+    char **values = GBMEM_MALLOC((size_t)nparams * sizeof(char *));
+    if(!values) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY,
+            "msg",          "%s", "No memory for query params",
+            NULL
+        );
+        return NULL;
+    }
+
+    for(int i=0; i<nparams; i++) {
+        json_t *jn_value = json_array_get(jn_params, (size_t)i);
+        char temp[64];
+        switch(json_typeof(jn_value)) {
+            case JSON_NULL:
+                values[i] = NULL;
+                break;
+            case JSON_STRING:
+                values[i] = gbmem_strdup(json_string_value(jn_value));
+                break;
+            case JSON_INTEGER:
+                snprintf(temp, sizeof(temp), "%"JSON_INTEGER_FORMAT, json_integer_value(jn_value));
+                values[i] = gbmem_strdup(temp);
+                break;
+            case JSON_REAL:
+                snprintf(temp, sizeof(temp), "%.17g", json_real_value(jn_value));
+                values[i] = gbmem_strdup(temp);
+                break;
+            case JSON_TRUE:
+                values[i] = gbmem_strdup("t");
+                break;
+            case JSON_FALSE:
+                values[i] = gbmem_strdup("f");
+                break;
+            default:
+                values[i] = json2uglystr(jn_value);
+                break;
+        }
+    }
+    return values;
+}
+
+PRIVATE void free_params(char **values, int nparams)
+{
+    if(!values) {
+        return;
+    }
+    for(int i=0; i<nparams; i++) {
+        if(values[i]) {
+            gbmem_free(values[i]);
+        }
+    }
+    gbmem_free(values);
+}
+
+/***************************************************************************
+ *  Send a query and append it to the queries in flight.
+ *      "query":        sql
+ *      "params":       optional, values of $1, $2,... in the sql
+ *      "prepare":      TRUE to run it as a prepared statement,
+ *                      the sql is prepared once by connection, the queries
+ *                      of the sql wait the result of its PREPARE
+ *      "copy_data":    data of COPY FROM STDIN, in text format,
+ *                      then the sql is the COPY command
+ ***************************************************************************/
+PRIVATE int send_query(hgobj gobj, json_t *kw_query) // owned
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    const char *query = kw_get_str(gobj, kw_query, "query", "", KW_REQUIRED);
+    json_t *jn_params = kw_get_list(gobj, kw_query, "params", 0, 0);
+    BOOL prepare = kw_get_bool(gobj, kw_query, "prepare", 0, 0);
+    BOOL copy = kw_has_key(kw_query, "copy_data");
+    BOOL was_idle = (json_array_size(priv->dl_in_flight) == 0)? TRUE:FALSE;
+    int nparams = (int)json_array_size(jn_params);
+
+    if(gobj_trace_level(gobj) & TRACE_MESSAGES) {
+        const char *dst = kw_get_str(gobj, kw_query, "dst", "", 0);
+        gobj_trace_msg(gobj, "🗂🗂Postgres SEND QUERY ⏩ dst %s, params %d%s%s\n%s\n",
+            dst?dst:"",
+            nparams,
+            prepare?", prepared":"",
+            copy?", copy":"",
+            query
+        );
+    }
+
+    char **values = NULL;
+    if(nparams > 0 && !copy) {
+        values = build_params(gobj, jn_params, nparams);
+    }
+
+    if(prepare && !copy) {
+        json_t *kw_prepare = prepare_in_flight(gobj, query);
+        if(kw_prepare) {
+            /*
+             *  The statement is being prepared, wait its result
+             */
+            json_array_append_new(
+                kw_get_list(gobj, kw_prepare, "__queries__", 0, KW_REQUIRED),
+                kw_query
+            );
+            free_params(values, nparams);
+            return 0;
+        }
+    }
+
+    if(prepare && !copy && !kw_has_key(priv->jn_prepared, query)) {
+        /*
+         *  First use of the sql in this connection, prepare it
+         */
+        char name[32];
+        snprintf(name, sizeof(name), "yp%d", ++priv->prepared_seq);
+        if(!PQsendPrepare(priv->conn, name, query, nparams, NULL)) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_POSTGRES,
+                "msg",          "%s", "PQsendPrepare FAILED",
+                "error",        "%s", PQerrorMessage(priv->conn),
+                NULL
+            );
+            prepare = FALSE;
+
+        } else {
+            json_object_set_new(priv->jn_prepared, query, json_string(name));
+            json_t *kw_prepare = json_pack("{s:s, s:s, s:[o]}",
+                "__prepare__", name,
+                "query", query,
+                "__queries__", kw_query
+            );
+            json_array_append_new(priv->dl_in_flight, kw_prepare);
+
+            /*
+             *  The query is sent when the statement is prepared, also in
+             *  pipeline mode: if the PREPARE fails the queries of the sql
+             *  are answered with its error, not sent to fail one by one.
+             */
+            if(priv->pipeline_mode) {
+                pipeline_sync(gobj);
+            }
+            free_params(values, nparams);
+            if(was_idle && priv->timeout_response > 0) {
+                set_timeout(priv->timer, priv->timeout_response);
+            }
+            return flush_output(gobj);
+        }
+    }
+
+    int ok = 0;
+    if(copy) {
+        /*
+         *  COPY is not allowed in pipeline mode, it goes alone
+         */
+        if(priv->pipeline_mode) {
+            if(PQexitPipelineMode(priv->conn)) {
+                priv->pipeline_mode = FALSE;
+            }
+        }
+        if(!priv->pipeline_mode) {
+            priv->copy_in_progress = TRUE;
+            ok = PQsendQuery(priv->conn, query);
+        }
+
+    } else if(prepare) {
+        const char *stmt = kw_get_str(gobj, priv->jn_prepared, query, "", KW_REQUIRED);
+        ok = PQsendQueryPrepared(priv->conn, stmt, nparams, (const char * const *)values, NULL, NULL, 0);
+
+    } else if(nparams > 0 || priv->pipeline_mode) {
+        ok = PQsendQueryParams(priv->conn, query, nparams, NULL, (const char * const *)values, NULL, NULL, 0);
+
+    } else {
+        ok = PQsendQuery(priv->conn, query);
+    }
+    free_params(values, nparams);
+
+    if(!ok) {
+        const char *error = PQerrorMessage(priv->conn);
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_POSTGRES,
+            "msg",          "%s", "PQsendQuery FAILED",
+            "error",        "%s", error,
+            NULL
+        );
+        json_object_set_new(kw_query, "result", json_integer(-1));
+        json_object_set_new(kw_query, "comment", json_string(error));
+        json_object_del(kw_query, "copy_data");
+        priv->queries_in_flight--;
+        if(copy) {
+            priv->copy_in_progress = FALSE;
+            if(priv->max_in_flight > 1 && !priv->pipeline_mode) {
+                enter_pipeline_mode(gobj);
+            }
+        }
+        publish_result(gobj, kw_query);
+        return -1;
+    }
+
+    json_array_append_new(priv->dl_in_flight, kw_query);
+
+    if(priv->pipeline_mode) {
+        pipeline_sync(gobj);
+    }
+
+    if(was_idle && priv->timeout_response > 0) {
+        set_timeout(priv->timer, priv->timeout_response);
+    }
+
+    return flush_output(gobj);
+}
+
+/***************************************************************************
+ *  Move the result to the query
+ ***************************************************************************/
+PRIVATE int fill_result(hgobj gobj, json_t *kw_result, PGresult *result)
+{
+    if(kw_get_int(gobj, kw_result, "result", 0, 0) < 0) {
+        // Keep the first error
+        return 0;
+    }
+
+    ExecStatusType st = PQresultStatus(result);
+    BOOL with_binaries = PQbinaryTuples(result);
+    if(with_binaries) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "Postgres Binary response NOT SUPPORTED",
+            NULL
+        );
+    }
+
+    switch(st) {
+        case PGRES_TUPLES_OK:
+        case PGRES_SINGLE_TUPLE:
+            json_object_set_new(kw_result, "result", json_integer(0));
+            int rows = PQntuples(result);
+            int cols = PQnfields(result);
+            json_object_set_new(kw_result, "rows", json_integer(rows));
+            json_object_set_new(kw_result, "cols", json_integer(cols));
+            json_t *jn_data = json_array();
+            json_object_set_new(kw_result, "data", jn_data);
+            for(int r=0; r<rows; r++) {
+                json_t *row = json_object();
+                json_array_append_new(jn_data, row);
+                for(int c=0; c<cols; c++) {
+                    char *col_name = PQfname(result, c);
+
+                    char *v = PQgetvalue(result, r, c);
+                    if(empty_string(v)) {
+                        if(PQgetisnull(result, r, c)) {
+                            v = 0;
+                        }
+                    }
+                    if(!v) {
+                        json_object_set_new(row, col_name, json_null());
+                    } else {
+                        Oid oid = PQftype(result, c);
+                        switch(oid) {
+                            case INT4OID:       // integer
+                                json_object_set_new(row, col_name, json_integer(atoi(v)));
+                                break;
+                            case INT8OID:       // bigint
+                                json_object_set_new(row, col_name, json_integer(atol(v)));
+                                break;
+                            case TIMESTAMPOID:  // timestamp
+                                // TODO conver to time_t
+                                json_object_set_new(row, col_name, json_string(v));
+                                break;
+                            case BOOLOID:       // boolean
+                                if(strcmp(v, "t")==0) {
+                                    json_object_set_new(row, col_name, json_true());
+                                } else {
+                                    json_object_set_new(row, col_name, json_false());
+                                }
+                                break;
+                            case FLOAT4OID:     // real
+                                json_object_set_new(row, col_name, json_real(atof(v)));
+                                break;
+                            case FLOAT8OID:     // double precision
+                                json_object_set_new(row, col_name, json_real(atof(v)));
+                                break;
+                            case TEXTOID:       // text
+                                json_object_set_new(row, col_name, json_string(v));
+                                break;
+                            default:
+                                json_object_set_new(row, col_name, json_string(v));
+                                gobj_log_error(gobj, 0,
+                                    "function",     "%s", __FUNCTION__,
+                                    "msgset",       "%s", MSGSET_INTERNAL,
+                                    "msg",          "%s", "Postgres type NOT IMPLEMENTED",
+                                    "oid",          "%d", oid,
+                                    NULL
+                                );
+                                break;
+
+                        }
+                    }
+                }
+            }
+            break;
+
+        case PGRES_COMMAND_OK:
+            json_object_set_new(kw_result, "result", json_integer(0));
+            json_object_set_new(kw_result, "status", json_string(PQcmdStatus(result)));
+            json_object_set_new(kw_result, "rows", json_integer(atoi(PQcmdTuples(result))));
+            break;
+
+        case PGRES_BAD_RESPONSE: /* an unexpected response was recv'd from the backend */
+        case PGRES_NONFATAL_ERROR: /* notice or warning message */
+        case PGRES_FATAL_ERROR: /* query failed */
+            json_object_set_new(kw_result, "result", json_integer(-1));
+            json_object_set_new(kw_result, "comment", json_string(PQresultErrorMessage(result)));
+            break;
+
+        case PGRES_PIPELINE_ABORTED: /* a previous query of the sync point failed */
+            json_object_set_new(kw_result, "result", json_integer(-1));
+            json_object_set_new(kw_result, "comment", json_string("Pipeline aborted by a previous error"));
+            break;
+
+        default:
+            json_object_set_new(kw_result, "result", json_integer(-1));
+            json_object_set_new(kw_result, "comment", json_string("No result status supported"));
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_INTERNAL,
+                "msg",          "%s", "No result status supported",
+                "st",           "%d", st,
+                "status",       "%s", PQresStatus(st),
+                NULL
+            );
+            break;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *  NOTE Object with __queries_in_queue__
+ *  If in the query there is `dst` then use it to use gobj_send_event()
+ *  else use gobj_publish_event()
+ ***************************************************************************/
+PRIVATE int publish_result(hgobj gobj, json_t* kw)
+{
+    if(kw_has_key(kw, "dst")) {
+        json_t *jn_dst = kw_get_dict_value(gobj, kw, "dst", 0, 0);
+        if(json_is_integer(jn_dst)) {
+            // HACK WARNING don't use volatil gobj's
+            hgobj dst = (hgobj)(size_t)json_integer_value(jn_dst);
+            if(gobj_is_volatil(dst)) {
+                gobj_log_error(gobj, 0,
+                    "function",     "%s", __FUNCTION__,
+                    "msgset",       "%s", MSGSET_INTERNAL,
+                    "msg",          "%s", "WARNING don't use volatil gobjs",
+                    "dst",          "%s", gobj_name(dst),
+                    NULL
+                );
+            }
+            return gobj_send_event(dst, EV_ON_MESSAGE, kw, gobj);
+
+        } else if(json_is_string(jn_dst)) {
+            const char *sdst = json_string_value(jn_dst);
+            hgobj dst = gobj_find_service(sdst, TRUE);
+            if(dst) {
+                return gobj_send_event(dst, EV_ON_MESSAGE, kw, gobj);
+            } else {
+                // Error already logged
+                gobj_trace_json(gobj, kw, "Result LOST");
+                JSON_DECREF(kw);
+                return -1;
+            }
+
+        } else {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_INTERNAL,
+                "msg",          "%s", "dst UNKNOWN",
+                NULL
+            );
+            gobj_trace_json(gobj, kw, "dst UNKNOWN");
+            JSON_DECREF(kw);
+            return -1;
+        }
+    } else {
+        gobj_publish_event(gobj, EV_ON_MESSAGE, kw);
+        return 0;
+    }
+}
+
+/***************************************************************************
+ *  All the results of the head query are received
+ ***************************************************************************/
+PRIVATE int end_of_query(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_t *kw_result = json_incref(json_array_get(priv->dl_in_flight, 0));
+    json_array_remove(priv->dl_in_flight, 0);
+
+    if(kw_has_key(kw_result, "__prepare__")) {
+        int result = (int)kw_get_int(gobj, kw_result, "result", 0, 0);
+        const char *query = kw_get_str(gobj, kw_result, "query", "", 0);
+        if(result < 0) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_POSTGRES,
+                "msg",          "%s", "Postgres PREPARE FAILED",
+                "comment",      "%s", kw_get_str(gobj, kw_result, "comment", "", 0),
+                "query",        "%s", query,
+                NULL
+            );
+            json_object_del(priv->jn_prepared, query);
+        }
+
+        /*
+         *  Now send the queries waiting the statement, or answer them with its error
+         */
+        size_t n_unsent = 0;
+        size_t idx; json_t *kw_query;
+        json_array_foreach(kw_get_list(gobj, kw_result, "__queries__", 0, 0), idx, kw_query) {
+            json_incref(kw_query);
+            if(!priv->conn) {
+                /*
+                 *  Disconnected sending a previous one, as reset_connection_state()
+                 */
+                if(kw_has_key(kw_query, "session")) {
+                    fail_query(gobj, kw_query, "Connection lost, session transaction aborted");
+                } else {
+                    json_array_insert_new(priv->dl_queries, n_unsent++, kw_query);
+                }
+            } else if(result < 0) {
+                json_object_set_new(kw_query, "result", json_integer(-1));
+                json_object_set_new(kw_query, "comment",
+                    json_string(kw_get_str(gobj, kw_result, "comment", "", 0))
+                );
+                priv->queries_in_flight--;
+                publish_result(gobj, kw_query);
+            } else {
+                send_query(gobj, kw_query);
+            }
+        }
+        JSON_DECREF(kw_result)
+        return 0;
+    }
+
+    priv->queries_in_flight--;
+
+    if(kw_has_key(kw_result, "copy_data")) {
+        json_object_del(kw_result, "copy_data"); // Don't return the data
+        priv->copy_in_progress = FALSE;
+        if(priv->max_in_flight > 1 && !priv->pipeline_mode) {
+            enter_pipeline_mode(gobj);
+        }
+    }
+
+    if(!kw_has_key(kw_result, "result")) {
+        json_object_set_new(kw_result, "result", json_integer(-1));
+        json_object_set_new(kw_result, "comment", json_string("No result"));
+    }
+
+    if(json_array_size(priv->dl_in_flight) > 0 && priv->timeout_response > 0) {
+        set_timeout(priv->timer, priv->timeout_response);
+    } else {
+        clear_timeout(priv->timer);
+    }
+
+    if(gobj_trace_level(gobj) & TRACE_MESSAGES) {
+        const char *dst = kw_get_str(gobj, kw_result, "dst", "", 0);
+        int result = (int)kw_get_int(gobj, kw_result, "result", -1, KW_REQUIRED);
+        if(result < 0) {
+            gobj_trace_json(gobj, kw_result, "🗂🗂Postgres RESULT ⏪ 🔴 ERROR, dst '%s'", dst?dst:"");
+        } else {
+            gobj_trace_json(gobj, kw_result, "🗂🗂Postgres RESULT ⏪ 🔵 OK, dst '%s'", dst?dst:"");
+        }
+    }
+
+    return publish_result(gobj, kw_result);
+}
+
+/***************************************************************************
+ *  Get the received results, in the order of the queries in flight
+ ***************************************************************************/
+PRIVATE int process_results(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    while(priv->conn && !PQisBusy(priv->conn)) {
+        PGresult *result = PQgetResult(priv->conn);
+        if(!result) {
+            /*
+             *  End of the results of the head query
+             */
+            if(json_array_size(priv->dl_in_flight) == 0) {
+                break;
+            }
+            end_of_query(gobj);
+            continue;
+        }
+
+        ExecStatusType st = PQresultStatus(result);
+        if(st == PGRES_PIPELINE_SYNC) {
+            priv->pending_syncs--;
+            PQclear(result);
+            continue;
+        }
+
+        json_t *kw_query = json_array_get(priv->dl_in_flight, 0);
+        if(!kw_query) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_INTERNAL,
+                "msg",          "%s", "No query for result",
+                "status",       "%s", PQresStatus(st),
+                NULL
+            );
+            PQclear(result);
+            continue;
+        }
+
+        if(st == PGRES_COPY_IN) {
+            /*
+             *  Server ready for the data, the result comes after the copy end
+             */
+            PQclear(result);
+            if(!priv->copy_data && priv->copy_in_progress) {
+                priv->copy_data = kw_get_str(gobj, kw_query, "copy_data", "", 0);
+                priv->copy_len = strlen(priv->copy_data);
+                priv->copy_offset = 0;
+                continue_copy(gobj);
+            }
+            break;
+        }
+
+        fill_result(gobj, kw_query, result);
+        PQclear(result);
+    }
+
+    return priv->conn? 0:-1;
+}
+
+/***************************************************************************
+ *  Connection in progress
+ ***************************************************************************/
+PRIVATE void connect_poll(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    PostgresPollingStatusType st = PQconnectPoll(priv->conn);
+    switch(st) {
+        case PGRES_POLLING_OK:
+            gobj_send_event(gobj, EV_CONNECTED, 0, gobj);
+            break;
+
+        case PGRES_POLLING_READING:
+            start_poll(gobj, FALSE);
+            break;
+
+        case PGRES_POLLING_WRITING:
+        case PGRES_POLLING_ACTIVE:
+            start_poll(gobj, TRUE);
+            break;
+
+        case PGRES_POLLING_FAILED:
+        default:
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_POSTGRES,
+                "msg",          "%s", "Postgres connection FAILED",
+                "error",        "%s", PQerrorMessage(priv->conn),
+                NULL
+            );
+            set_disconnected(gobj);
+            break;
+    }
+}
+
+/***************************************************************************
+ *  Socket readable
+ ***************************************************************************/
+PRIVATE void on_readable(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(!PQconsumeInput(priv->conn)) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_POSTGRES,
+            "msg",          "%s", "PQconsumeInput FAILED",
+            "error",        "%s", PQerrorMessage(priv->conn),
+            NULL
+        );
+        set_disconnected(gobj);
+        return;
+    }
+
+    if(process_results(gobj) < 0) {
+        // Disconnected
+        return;
+    }
+
+    /*
+     *  Fill the room of the pipeline
+     */
+    pull_queue(gobj);
+
+    if(priv->conn) {
+        start_poll(gobj, FALSE);
+    }
+}
+
+/***************************************************************************
+ *  Socket writable
+ ***************************************************************************/
+PRIVATE void on_writable(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->copy_data) {
+        continue_copy(gobj);
+    } else {
+        flush_output(gobj);
+    }
+}
+
+/***************************************************************************
+ *  Poll callback of the postgres socket
+ ***************************************************************************/
+PRIVATE int yev_callback(yev_event_h yev_event)
+{
+    if(!yev_event) {
+        return 0;
+    }
+    hgobj gobj = yev_get_gobj(yev_event);
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(!yev_event_is_idle(yev_event) || !priv->conn) {
+        // Poll stopped, the connection is closed
+        return 0;
+    }
+
+    if(gobj_in_this_state(gobj, ST_WAIT_CONNECTED)) {
+        connect_poll(gobj);
+
+    } else if(gobj_in_this_state(gobj, ST_CONNECTED)) {
+        if(yev_event == priv->yev_poll_tx) {
+            on_writable(gobj);
+        } else {
+            on_readable(gobj);
+        }
+    }
+
+    return 0;
+}
 
 /***************************************************************************
  *
@@ -637,33 +1437,54 @@ PRIVATE int clear_queue(hgobj gobj, json_t *kw_)
     const char *id = kw_get_str(gobj, kw_, "id", "", 0);
     if(empty_string(id)) {
         if(gobj_trace_level(gobj) & TRACE_MESSAGES) {
-            if(priv->cur_query) {
-                gobj_trace_json(gobj, priv->cur_query, "🗂🗂Postgres CLEAR current query");
-            }
+            gobj_trace_json(gobj, priv->dl_in_flight, "🗂🗂Postgres CLEAR queries in flight");
             gobj_trace_json(gobj, priv->dl_queries, "🗂🗂Postgres CLEAR QUEUE");
         }
         json_array_clear(priv->dl_queries);
         found = TRUE;
-        if(priv->cur_query) {
-            json_decref(priv->cur_query);
-            priv->cur_query = 0;
+        if(json_array_size(priv->dl_in_flight) > 0) {
+            json_array_clear(priv->dl_in_flight);
+            priv->queries_in_flight = 0;
             pull = TRUE;
         }
 
     } else {
-        if(priv->cur_query) {
-            const char *id_ = kw_get_str(gobj, priv->cur_query, "id", 0, 0);
+        size_t idx; json_t *jn_query;
+        json_array_foreach(priv->dl_in_flight, idx, jn_query) {
+            if(kw_has_key(jn_query, "__prepare__")) {
+                /*
+                 *  Waiting its statement, not sent, there is no result to skip
+                 */
+                json_t *jn_waiting = kw_get_list(gobj, jn_query, "__queries__", 0, 0);
+                size_t i; json_t *kw_waiting;
+                json_array_foreach(jn_waiting, i, kw_waiting) {
+                    const char *id_ = kw_get_str(gobj, kw_waiting, "id", 0, 0);
+                    if(id_ && strcmp(id_, id)==0) {
+                        if(gobj_trace_level(gobj) & TRACE_MESSAGES) {
+                            gobj_trace_json(gobj, kw_waiting, "🗂🗂Postgres CLEAR query waiting its statement");
+                        }
+                        json_array_remove(jn_waiting, i);
+                        priv->queries_in_flight--;
+                        found = TRUE;
+                        break;
+                    }
+                }
+                if(found) {
+                    break;
+                }
+                continue;
+            }
+            const char *id_ = kw_get_str(gobj, jn_query, "id", 0, 0);
             if(id_ && strcmp(id_, id)==0) {
                 if(gobj_trace_level(gobj) & TRACE_MESSAGES) {
-                    gobj_trace_json(gobj, priv->cur_query, "🗂🗂Postgres CLEAR current query");
+                    gobj_trace_json(gobj, jn_query, "🗂🗂Postgres CLEAR query in flight");
                 }
-                json_decref(priv->cur_query);
-                priv->cur_query = 0;
+                json_array_remove(priv->dl_in_flight, idx);
                 pull = TRUE;
                 found = TRUE;
+                break;
             }
         }
-        int idx; json_t *jn_query;
         json_array_foreach(priv->dl_queries, idx, jn_query) {
             const char *id_ = kw_get_str(gobj, jn_query, "id", 0, 0);
             if(id_ && strcmp(id_, id)==0) {
@@ -687,8 +1508,11 @@ PRIVATE int clear_queue(hgobj gobj, json_t *kw_)
         );
     }
 
-    if(pull) {
-        // No podemos dejar que llegue respuesta pendiente, reconecta
+    if(pull && priv->conn) {
+        /*
+         *  No podemos dejar que llegue respuesta pendiente, reconecta.
+         *  The rest of queries in flight are answered with error.
+         */
         set_disconnected(gobj);
     }
 
@@ -725,294 +1549,43 @@ PRIVATE int push_queue(
 }
 
 /***************************************************************************
- *
+ *  Send queued queries while there is room in the pipeline
  ***************************************************************************/
 PRIVATE int pull_queue(hgobj gobj)
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    if(priv->cur_query) {
-        if(gobj_trace_level(gobj) & TRACE_MESSAGES) {
-            // query in progress
-            gobj_log_warning(gobj, 0,
-                "function",     "%s", __FUNCTION__,
-                "msgset",       "%s", MSGSET_DATABASE,
-                "msg",          "%s", "postgres query in progress",
-                "cur_query",    "%j", priv->cur_query,
-                NULL
-            );
-        }
+    if(!priv->conn || !gobj_in_this_state(gobj, ST_CONNECTED)) {
         return 0;
     }
 
-    /*
-     *  process enqueued data
-     */
-    if(json_array_size(priv->dl_queries)>0) {
-        priv->cur_query = json_incref(json_array_get(priv->dl_queries, 0));
-        json_array_remove(priv->dl_queries, 0);
-
-        send_cur_query(gobj);
-    }
-
-    return 0;
-}
-
-/***************************************************************************
- *
- ***************************************************************************/
-PRIVATE int send_cur_query(hgobj gobj)
-{
-    PRIVATE_DATA *priv = gobj_priv_data(gobj);
-
-    if(!priv->cur_query) {
-        gobj_log_error(gobj, 0,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_INTERNAL,
-            "msg",          "%s", "NO cur_query",
-            NULL
-        );
-        return -1;
-    }
-
-    const char *query = kw_get_str(gobj, priv->cur_query, "query", "", KW_REQUIRED);
-    if(gobj_trace_level(gobj) & TRACE_MESSAGES) {
-        const char *dst = kw_get_str(gobj, priv->cur_query, "dst", "", 0);
-        gobj_trace_msg(gobj, "🗂🗂Postgres SEND QUERY ⏩ dst %s\n%s\n", dst?dst:"", query);
-    }
+    while(json_array_size(priv->dl_queries) > 0 &&
+            priv->queries_in_flight < priv->max_in_flight &&
+            !priv->copy_in_progress) {
+
+        json_t *kw_query = json_array_get(priv->dl_queries, 0);
+        if(kw_has_key(kw_query, "copy_data") &&
+                (json_array_size(priv->dl_in_flight) > 0 || priv->pending_syncs > 0)) {
+            /*
+             *  COPY goes alone, wait the pipeline is empty
+             */
+            break;
+        }
 
-    if(!PQsendQuery(priv->conn, query)) {
-        gobj_log_error(gobj, 0,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_POSTGRES,
-            "msg",          "%s", "PQsendQuery FAILED",
-            "error",        "%s", PQerrorMessage(priv->conn),
-            NULL
-        );
-    }
+        json_incref(kw_query);
+        json_array_remove(priv->dl_queries, 0);
+        priv->queries_in_flight++;
 
-    // uv_poll_start(&priv->uv_poll, UV_READABLE|UV_WRITABLE, on_poll_cb);
-    if (priv->timeout_response > 0) {
-        set_timeout(priv->timer, priv->timeout_response);
+        send_query(gobj, kw_query);
+        if(!priv->conn) {
+            // Disconnected
+            break;
+        }
     }
 
     return 0;
 }
 
-/***************************************************************************
- *
- ***************************************************************************/
-// PRIVATE int process_result(hgobj gobj, PGresult* result)
-// {
-//     PRIVATE_DATA *priv = gobj_priv_data(gobj);
-//
-//     clear_timeout(priv->timer);
-//
-//     if(!priv->cur_query) {
-//         gobj_log_error(gobj, 0,
-//             "function",     "%s", __FUNCTION__,
-//             "msgset",       "%s", MSGSET_INTERNAL,
-//             "msg",          "%s", "No query for result",
-//             NULL
-//         );
-//         return 0;
-//     }
-//
-//     json_t *kw_result = priv->cur_query;
-//     priv->cur_query = 0;
-//
-//     if(!result) {
-//         char *error = PQerrorMessage(priv->conn);
-//         gobj_log_error(gobj, 0,
-//             "function",     "%s", __FUNCTION__,
-//             "msgset",       "%s", MSGSET_POSTGRES,
-//             "msg",          "%s", "Postgres connection closed 3",
-//             "error",        "%s", error,
-//             NULL
-//         );
-//         json_object_set_new(kw_result, "result", json_integer(-1));
-//         json_object_set_new(kw_result, "comment", json_string(error));
-//         if(gobj_trace_level(gobj) & TRACE_MESSAGES) {
-//             const char *dst = kw_get_str(gobj, kw_result, "dst", "", 0);
-//             gobj_trace_json(gobj, kw_result, "🗂🗂Postgres RESULT ⏪ 🔴 ERROR, dst '%s'", dst?dst:"");
-//         }
-//         return publish_result(gobj, kw_result);
-//     }
-//
-//     ExecStatusType st = PQresultStatus(result);
-//     BOOL with_binaries = PQbinaryTuples(result);
-//     if(with_binaries) {
-//         gobj_log_error(gobj, 0,
-//             "function",     "%s", __FUNCTION__,
-//             "msgset",       "%s", MSGSET_INTERNAL,
-//             "msg",          "%s", "Postgres Binary response NOT SUPPORTED",
-//             NULL
-//         );
-//     }
-//
-//     switch(st) {
-//         case PGRES_TUPLES_OK:
-//         case PGRES_SINGLE_TUPLE:
-//             json_object_set_new(kw_result, "result", json_integer(0));
-//             int rows = PQntuples(result);
-//             int cols = PQnfields(result);
-//             json_object_set_new(kw_result, "rows", json_integer(rows));
-//             json_object_set_new(kw_result, "cols", json_integer(cols));
-//             json_t *jn_data = json_array();
-//             json_object_set_new(kw_result, "data", jn_data);
-//             for(int r=0; r<rows; r++) {
-//                 json_t *row = json_object();
-//                 json_array_append_new(jn_data, row);
-//                 for(int c=0; c<cols; c++) {
-//                     char *col_name = PQfname(result, c);
-//                     //int format = PQfformat(result, c);
-//
-//                     char *v = PQgetvalue(result, r, c);
-//                     if(empty_string(v)) {
-//                         if(PQgetisnull(result, r, c)) {
-//                             v = 0;
-//                         }
-//                     }
-//                     if(!v) {
-//                         json_object_set_new(row, col_name, json_null());
-//                     } else {
-//                         Oid oid = PQftype(result, c);
-//                         switch(oid) {
-//                             case INT4OID:       // integer
-//                                 json_object_set_new(row, col_name, json_integer(atoi(v)));
-//                                 break;
-//                             case INT8OID:       // bigint
-//                                 json_object_set_new(row, col_name, json_integer(atol(v)));
-//                                 break;
-//                             case TIMESTAMPOID:  // timestamp
-//                                 // TODO conver to time_t
-//                                 json_object_set_new(row, col_name, json_string(v));
-//                                 break;
-//                             case BOOLOID:       // boolean
-//                                 if(strcmp(v, "t")==0) {
-//                                     json_object_set_new(row, col_name, json_true());
-//                                 } else {
-//                                     json_object_set_new(row, col_name, json_false());
-//                                 }
-//                                 break;
-//                             case FLOAT4OID:     // real
-//                                 json_object_set_new(row, col_name, json_real(atof(v)));
-//                                 break;
-//                             case FLOAT8OID:     // double precision
-//                                 json_object_set_new(row, col_name, json_real(atof(v)));
-//                                 break;
-//                             case TEXTOID:       // text
-//                                 json_object_set_new(row, col_name, json_string(v));
-//                                 break;
-//                             default:
-//                                 json_object_set_new(row, col_name, json_string(v));
-//                                 gobj_log_error(gobj, 0,
-//                                     "function",     "%s", __FUNCTION__,
-//                                     "msgset",       "%s", MSGSET_INTERNAL,
-//                                     "msg",          "%s", "Postgres type NOT IMPLEMENTED",
-//                                     "oid",          "%d", oid,
-//                                     NULL
-//                                 );
-//                                 break;
-//
-//                         }
-//                     }
-//                 }
-//             }
-//             break;
-//
-//         case PGRES_COMMAND_OK:
-//             json_object_set_new(kw_result, "result", json_integer(0));
-//             json_object_set_new(kw_result, "status", json_string(PQcmdStatus(result)));
-//             json_object_set_new(kw_result, "rows", json_integer(atoi(PQcmdTuples(result))));
-//             break;
-//
-//         case PGRES_BAD_RESPONSE: /* an unexpected response was recv'd from the backend */
-//         case PGRES_NONFATAL_ERROR: /* notice or warning message */
-//         case PGRES_FATAL_ERROR: /* query failed */
-//             json_object_set_new(kw_result, "result", json_integer(-1));
-//             json_object_set_new(kw_result, "comment", json_string(PQresultErrorMessage(result)));
-//             break;
-//
-//         default:
-//             json_object_set_new(kw_result, "result", json_integer(-1));
-//             json_object_set_new(kw_result, "comment", json_string("No result status supported"));
-//             gobj_log_error(gobj, 0,
-//                 "function",     "%s", __FUNCTION__,
-//                 "msgset",       "%s", MSGSET_INTERNAL,
-//                 "msg",          "%s", "No result status supported",
-//                 "st",           "%d", st,
-//                 "status",       "%s", PQresStatus(st),
-//                 NULL
-//             );
-//             break;
-//     }
-//
-//     if(gobj_trace_level(gobj) & TRACE_MESSAGES) {
-//         const char *dst = kw_get_str(gobj, kw_result, "dst", "", 0);
-//         int result = kw_get_int(gobj, kw_result, "result", -1, KW_REQUIRED);
-//         if(result < 0) {
-//             gobj_trace_json(gobj, kw_result, "🗂🗂Postgres RESULT ⏪ 🔴 ERROR, dst '%s'", dst?dst:"");
-//         } else {
-//             gobj_trace_json(gobj, kw_result, "🗂🗂Postgres RESULT ⏪ 🔵 OK, dst '%s'", dst?dst:"");
-//         }
-//     }
-//
-//     return publish_result(gobj, kw_result);
-// }
-
-/***************************************************************************
- *  NOTE Object with __queries_in_queue__
- *  If in the query there is `dst` then use it to use gobj_send_event()
- *  else use gobj_publish_event()
- ***************************************************************************/
-// PRIVATE int publish_result(hgobj gobj, json_t* kw)
-// {
-//     if(kw_has_key(kw, "dst")) {
-//         json_t *jn_dst = kw_get_dict_value(gobj, kw, "dst", 0, 0);
-//         if(json_is_integer(jn_dst)) {
-//             // HACK WARNING don't use volatil gobj's
-//             hgobj dst = (hgobj)(size_t)json_integer_value(jn_dst);
-//             if(gobj_is_volatil(dst)) {
-//                 gobj_log_error(gobj, 0,
-//                     "function",     "%s", __FUNCTION__,
-//                     "msgset",       "%s", MSGSET_INTERNAL,
-//                     "msg",          "%s", "WARNING don't use volatil gobjs",
-//                     "dst",          "%s", gobj_name(dst),
-//                     NULL
-//                 );
-//             }
-//             return gobj_send_event(dst, EV_ON_MESSAGE, kw, gobj);
-//
-//         } else if(json_is_string(jn_dst)) {
-//             const char *sdst = json_string_value(jn_dst);
-//             hgobj dst = gobj_find_service(sdst, TRUE);
-//             if(dst) {
-//                 return gobj_send_event(dst, EV_ON_MESSAGE, kw, gobj);
-//             } else {
-//                 // Error already logged
-//                 gobj_trace_json(gobj, kw, "Result LOST");
-//                 JSON_DECREF(kw);
-//                 return -1;
-//             }
-//
-//         } else {
-//             gobj_log_error(gobj, 0,
-//                 "function",     "%s", __FUNCTION__,
-//                 "msgset",       "%s", MSGSET_INTERNAL,
-//                 "msg",          "%s", "dst UNKNOWN",
-//                 NULL
-//             );
-//             gobj_trace_json(gobj, kw, "dst UNKNOWN");
-//             JSON_DECREF(kw);
-//             return -1;
-//         }
-//     } else {
-//         gobj_publish_event(gobj, EV_ON_MESSAGE, kw);
-//         return 0;
-//     }
-// }
-
 
 
 
@@ -1049,6 +1622,8 @@ PRIVATE int ac_connect(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
         PQfinish(priv->conn);
         priv->conn = 0;
     }
+    set_timeout(priv->timer, gobj_read_integer_attr(gobj, "timeout_waiting_connected"));
+
     priv->conn = PQconnectStart(url);
     if(priv->conn == NULL) {
         gobj_log_error(gobj, 0,
@@ -1057,18 +1632,17 @@ PRIVATE int ac_connect(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
             "msg",          "%s", "PQconnectStart FAILED",
             NULL
         );
+        KW_DECREF(kw);
+        return -1;
     }
 
     PQsetnonblocking(priv->conn, 1);
-    priv->pg_socket = PQsocket(priv->conn);
-    // uv_poll_init(yuno_uv_event_loop(), &priv->uv_poll, priv->pg_socket);
-    // priv->uv_poll.data = gobj;
-
     PQsetNoticeProcessor(priv->conn, noticeProcessor, gobj);
 
-    // uv_poll_start(&priv->uv_poll, UV_WRITABLE, on_poll_cb);
-
-    set_timeout(priv->timer, gobj_read_integer_attr(gobj, "timeout_waiting_connected"));
+    /*
+     *  Wait the socket is writable to continue with PQconnectPoll()
+     */
+    start_poll(gobj, TRUE);
 
     KW_DECREF(kw);
     return 0;
@@ -1137,13 +1711,28 @@ PRIVATE int ac_connected(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
 
     clear_timeout(priv->timer);
 
+    /*
+     *  Pipeline mode if more than one query in flight is configured
+     */
+    priv->max_in_flight = priv->pipeline_depth;
+    if(priv->max_in_flight < 1) {
+        priv->max_in_flight = 1;
+    } else if(priv->max_in_flight > MAX_PIPELINE_DEPTH) {
+        priv->max_in_flight = MAX_PIPELINE_DEPTH;
+    }
+    if(priv->max_in_flight > 1) {
+        enter_pipeline_mode(gobj);
+    }
+
     priv->inform_disconnected = TRUE;
     gobj_publish_event(gobj, EV_ON_OPEN, 0);
 
-    if(priv->cur_query) {
-        send_cur_query(gobj);
-    } else {
-        pull_queue(gobj);
+    /*
+     *  Send the queries waiting (the not sent by the previous connection too)
+     */
+    pull_queue(gobj);
+    if(priv->conn) {
+        start_poll(gobj, FALSE);
     }
 
     KW_DECREF(kw);
@@ -1157,8 +1746,7 @@ PRIVATE int ac_timeout_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj sr
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    json_t *kw_result = priv->cur_query;
-    priv->cur_query = 0;
+    json_t *kw_result = json_array_get(priv->dl_in_flight, 0);
 
     gobj_log_error(gobj, 0,
         "function",     "%s", __FUNCTION__,
@@ -1168,9 +1756,9 @@ PRIVATE int ac_timeout_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj sr
     );
     const char *dst = kw_get_str(gobj, kw_result, "dst", "", 0);
     gobj_trace_json(gobj, kw_result, "🗂🗂Postgres RESULT ⏪ ⏳TIMEOUT, dst '%s'", dst?dst:"");
-    JSON_DECREF(kw_result);
 
-    // No podemos dejar que llegue la respuesta pendiente, reconecta
+    // No podemos dejar que llegue la respuesta pendiente, reconecta.
+    // The queries in flight, this one too, are answered with error.
     set_disconnected(gobj);
 
     KW_DECREF(kw);
@@ -1182,9 +1770,17 @@ PRIVATE int ac_timeout_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj sr
  *  If it exists "dst" then use gobj_send_event() else use gobj_publish_event()
     {
         "dst": "unique-gobj" or 99999 (hgobj) // WARNING don't use volatiles hgobj
-        "query": "..."
+        "query": "...",
+        "params": [...],        // optional, values of $1, $2, ...
+        "prepare": true,        // optional, prepared statement cached by connection
+        "copy_data": "...",     // optional, data of "COPY ... FROM STDIN" query
+        "session": "..."        // optional, query of a transaction: if the connection
+                                // is lost it's answered with error, never sent again
     }
  *
+ *  A query already sent when the connection is lost is answered with error
+ *  (result unknown), only the queries not sent go to the next connection.
+ *
  ***************************************************************************/
 PRIVATE int ac_send_query(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
 {
@@ -1200,6 +1796,16 @@ PRIVATE int ac_send_query(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
  ***************************************************************************/
 PRIVATE int ac_enqueue_query(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
 {
+    if(kw_has_key(kw, "session")) {
+        /*
+         *  The transaction of the session was in the connection lost,
+         *  it cannot go on in the next one.
+         */
+        fail_query(gobj, json_incref(kw), "Connection lost, session transaction aborted");
+        KW_DECREF(kw);
+        return 0;
+    }
+
     push_queue(gobj, kw);
 
     if(gobj_in_this_state(gobj, ST_DISCONNECTED)) {
@@ -1252,6 +1858,7 @@ PRIVATE const GMETHODS gmt = {
     .mt_start   = mt_start,
     .mt_stop    = mt_stop,
     .mt_writing = mt_writing,
+    .mt_reading = mt_reading,
 };
 
 /*------------------------*
@@ -1320,6 +1927,8 @@ PRIVATE int create_gclass(gclass_name_t gclass_name)
     };
 
     ev_action_t st_wait_disconnected[] = {
+        {EV_SEND_QUERY,     ac_enqueue_query,           0},
+        {EV_CLEAR_QUEUE,    ac_clear_queue,             0},
         {EV_DISCONNECTED,   ac_disconnected,            ST_DISCONNECTED},
         {EV_STOPPED,        ac_stopped,                 ST_DISCONNECTED},
         {EV_TIMEOUT,        ac_stopped,                 ST_DISCONNECTED},
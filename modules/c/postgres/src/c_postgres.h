@@ -16,6 +16,8 @@ header lives in /usr/include/postgresql on Debian but in /usr/include on
 RHEL. CMakeLists.txt adds the right dir from `pg_config --includedir`, so
 the same include works on both distros.
 
+libpq >= 14 is required (pipeline mode: PQenterPipelineMode() and friends).
+
 
 Utils
 -----
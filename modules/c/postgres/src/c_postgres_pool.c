@@ -0,0 +1,991 @@
+/***********************************************************************
+ *          C_POSTGRES_POOL.C
+ *          Postgres_pool GClass.
+ *
+ *          Pool of Postgres connections.
+ *
+ *          Each connection is a C_POSTGRES child, with its own socket in the
+ *          yuno event loop. The queries are queued here and dispatched to the
+ *          least busy connection with room (pipeline_depth queries in flight),
+ *          so a slow query only holds back its own connection.
+ *
+ *          Transaction-affine routing: the queries with the same "session" go
+ *          to the same connection. The first query of a session pins a free
+ *          connection, reserved to the session until the result of the query
+ *          with "session_end": true (COMMIT, ROLLBACK).
+ *          If the connection is lost the session is failed: its queries are
+ *          answered with error, without sending them, until the "session_end".
+ *
+ *          Copyright (c) 2021 Niyamaka.
+ *          All Rights Reserved.
+ ***********************************************************************/
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include "c_postgres_pool.h"
+
+/***************************************************************************
+ *              Constants
+ ***************************************************************************/
+#define MAX_POOL_SIZE   64
+
+/***************************************************************************
+ *              Structures
+ ***************************************************************************/
+typedef struct {
+    hgobj gobj_conn;    // C_POSTGRES
+    BOOL connected;
+    BOOL pinned;        // reserved to a session
+    int in_flight;      // queries dispatched without result
+} pool_conn_t;
+
+/***************************************************************************
+ *              Prototypes
+ ***************************************************************************/
+PRIVATE int pull_queue(hgobj gobj);
+PRIVATE int publish_result(hgobj gobj, json_t* kw);
+
+/***************************************************************************
+ *          Data: config, public data, private data
+ ***************************************************************************/
+PRIVATE json_t *cmd_help(hgobj gobj, const char *cmd, json_t *kw, hgobj src);
+PRIVATE json_t *cmd_authzs(hgobj gobj, const char *cmd, json_t *kw, hgobj src);
+PRIVATE json_t *cmd_list_size(hgobj gobj, const char *cmd, json_t *kw, hgobj src);
+PRIVATE json_t *cmd_list_queue(hgobj gobj, const char *cmd, json_t *kw, hgobj src);
+PRIVATE json_t *cmd_view_channels(hgobj gobj, const char *cmd, json_t *kw, hgobj src);
+
+PRIVATE sdata_desc_t pm_help[] = {
+/*-PM----type-----------name------------flag------------default-----description---------- */
+SDATAPM (DTP_STRING,    "cmd",          0,              0,          "command about you want help."),
+SDATAPM (DTP_INTEGER,   "level",        0,              0,          "command search level in childs"),
+SDATA_END()
+};
+PRIVATE sdata_desc_t pm_authzs[] = {
+/*-PM----type-----------name------------flag------------default-----description---------- */
+SDATAPM (DTP_STRING,    "authz",        0,              0,          "permission to search"),
+SDATAPM (DTP_STRING,    "service",      0,              0,          "Service where to search the permission. If empty print all service's permissions"),
+SDATA_END()
+};
+
+PRIVATE const char *a_help[] = {"h", "?", 0};
+
+PRIVATE sdata_desc_t command_table[] = {
+/*-CMD---type-----------name----------------alias-------items-----------json_fn---------description---------- */
+SDATACM (DTP_SCHEMA,    "help",             a_help,     pm_help,        cmd_help,       "Command's help"),
+SDATACM (DTP_SCHEMA,    "authzs",           0,          pm_authzs,      cmd_authzs,     "Authorization's help"),
+SDATACM (DTP_SCHEMA,    "list-size",        0,          0,              cmd_list_size,  "Size of queue's messages"),
+SDATACM (DTP_SCHEMA,    "list-queue",       0,          0,              cmd_list_queue, "List queue's messages"),
+SDATACM (DTP_SCHEMA,    "view-channels",    0,          0,              cmd_view_channels, "View connections of the pool"),
+SDATA_END()
+};
+
+
+/*---------------------------------------------*
+ *      Attributes
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t attrs_table[] = {
+/*-ATTR-type------------name----------------------------flag------------default---------description---------- */
+SDATA (DTP_STRING,      "url",                          SDF_PERSIST|SDF_WR,0,           "Url"),
+SDATA (DTP_INTEGER,     "pool_size",                    SDF_RD,         "4",            "Number of connections"),
+SDATA (DTP_INTEGER,     "pipeline_depth",               SDF_RD,         "1",            "Queries in flight by connection"),
+SDATA (DTP_INTEGER,     "timeout_waiting_connected",    SDF_RD,         "10000",        ""),
+SDATA (DTP_INTEGER,     "timeout_between_connections",  SDF_RD,         "5000",         "Idle timeout to wait between attempts of connection"),
+SDATA (DTP_INTEGER,     "timeout_response",             SDF_RD,         "10000",        "Timeout response"),
+
+SDATA (DTP_POINTER,     "user_data",        0,                          0,              "user data"),
+SDATA (DTP_POINTER,     "user_data2",       0,                          0,              "more user data"),
+SDATA (DTP_POINTER,     "subscriber",       0,                          0,              "subscriber of output-events. Not a child gobj."),
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *      GClass trace levels
+ *  HACK strict ascendant value!
+ *  required paired correlative strings
+ *  in s_user_trace_level
+ *---------------------------------------------*/
+enum {
+    TRACE_MESSAGES = 0x0001,
+};
+PRIVATE const trace_level_t s_user_trace_level[16] = {
+{"messages",        "Trace messages"},
+{0, 0},
+};
+
+/*---------------------------------------------*
+ *      GClass authz levels
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t authz_table[] = {
+/*-AUTHZ-- type---------name------------flag----alias---items---------------description--*/
+SDATAAUTHZ (DTP_SCHEMA, "sample",       0,      0,      0,                  "Permission to ..."),
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *              Private data
+ *---------------------------------------------*/
+typedef struct _PRIVATE_DATA {
+    int32_t pipeline_depth;
+
+    pool_conn_t conns[MAX_POOL_SIZE];
+    int n_conns;
+    int cursor;                 // round robin between connections equally busy
+    int connected;              // connections open
+
+    json_t *dl_queries;         // queries waiting a connection
+    json_t *jn_sessions;        // session: index of the connection pinned
+    json_t *jn_failed_sessions; // session: lost with its connection, until session_end
+    json_t *jn_dispatched;      // id: index of the connection, to clear it
+} PRIVATE_DATA;
+
+
+
+
+            /******************************
+             *      Framework Methods
+             ******************************/
+
+
+
+
+/***************************************************************************
+ *      Framework Method create
+ ***************************************************************************/
+PRIVATE void mt_create(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->dl_queries = json_array();
+    priv->jn_sessions = json_object();
+    priv->jn_failed_sessions = json_object();
+    priv->jn_dispatched = json_object();
+
+    /*
+     *  SERVICE subscription model
+     */
+    hgobj subscriber = (hgobj)gobj_read_pointer_attr(gobj, "subscriber");
+    if(subscriber) {
+        gobj_subscribe_event(gobj, NULL, NULL, subscriber);
+    } else if(gobj_is_pure_child(gobj)) {
+        subscriber = gobj_parent(gobj);
+        gobj_subscribe_event(gobj, NULL, NULL, subscriber);
+    }
+
+    SET_PRIV(pipeline_depth,              gobj_read_integer_attr)
+    if(priv->pipeline_depth < 1) {
+        priv->pipeline_depth = 1;
+    }
+
+    /*
+     *  The connections, they publish to the pool (pure childs)
+     */
+    int pool_size = (int)gobj_read_integer_attr(gobj, "pool_size");
+    if(pool_size < 1) {
+        pool_size = 1;
+    } else if(pool_size > MAX_POOL_SIZE) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "pool_size too big",
+            "pool_size",    "%d", pool_size,
+            "max",          "%d", MAX_POOL_SIZE,
+            NULL
+        );
+        pool_size = MAX_POOL_SIZE;
+    }
+
+    const char *url = gobj_read_str_attr(gobj, "url");
+    for(int i=0; i<pool_size; i++) {
+        char name[NAME_MAX];
+        snprintf(name, sizeof(name), "%s-%d", gobj_name(gobj), i);
+
+        json_t *kw_conn = json_pack("{s:s, s:i, s:I, s:I, s:I}",
+            "url", url?url:"",
+            "pipeline_depth", (int)priv->pipeline_depth,
+            "timeout_waiting_connected",
+                (json_int_t)gobj_read_integer_attr(gobj, "timeout_waiting_connected"),
+            "timeout_between_connections",
+                (json_int_t)gobj_read_integer_attr(gobj, "timeout_between_connections"),
+            "timeout_response",
+                (json_int_t)gobj_read_integer_attr(gobj, "timeout_response")
+        );
+        hgobj gobj_conn = gobj_create_pure_child(name, C_POSTGRES, kw_conn, gobj);
+        if(!gobj_conn) {
+            // Error already logged
+            break;
+        }
+        priv->conns[priv->n_conns++].gobj_conn = gobj_conn;
+    }
+}
+
+/***************************************************************************
+ *      Framework Method writing
+ ***************************************************************************/
+PRIVATE void mt_writing(hgobj gobj, const char *path)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(strcmp(path, "url")==0) {
+        /*
+         *  Used by the connections in the next connection
+         */
+        const char *url = gobj_read_str_attr(gobj, "url");
+        for(int i=0; i<priv->n_conns; i++) {
+            gobj_write_str_attr(priv->conns[i].gobj_conn, "url", url);
+        }
+    }
+}
+
+/***************************************************************************
+ *      Framework Method destroy
+ ***************************************************************************/
+PRIVATE void mt_destroy(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(json_array_size(priv->dl_queries)) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "records LOST",
+            NULL
+        );
+        gobj_trace_json(gobj, priv->dl_queries, "records LOST");
+    }
+    JSON_DECREF(priv->dl_queries);
+    JSON_DECREF(priv->jn_sessions);
+    JSON_DECREF(priv->jn_failed_sessions);
+    JSON_DECREF(priv->jn_dispatched);
+}
+
+/***************************************************************************
+ *      Framework Method start
+ ***************************************************************************/
+PRIVATE int mt_start(hgobj gobj)
+{
+    gobj_start_children(gobj);
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method stop
+ ***************************************************************************/
+PRIVATE int mt_stop(hgobj gobj)
+{
+    gobj_stop_children(gobj);
+    return 0;
+}
+
+
+
+
+            /***************************
+             *      Commands
+             ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE json_t *cmd_help(hgobj gobj, const char *cmd, json_t *kw, hgobj src)
+{
+    KW_INCREF(kw);
+    json_t *jn_resp = gobj_build_cmds_doc(gobj, kw);
+    return msg_iev_build_response(
+        gobj,
+        0,
+        jn_resp,
+        0,
+        0,
+        kw  // owned
+    );
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE json_t *cmd_authzs(hgobj gobj, const char *cmd, json_t *kw, hgobj src)
+{
+    KW_INCREF(kw)
+    json_t *jn_resp = gobj_build_authzs_doc(gobj, cmd, kw);
+    return msg_iev_build_response(
+        gobj,
+        0,
+        0,
+        0,
+        jn_resp,
+        kw  // owned
+    );
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE json_t *cmd_list_size(hgobj gobj, const char *cmd, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    int in_flight = 0;
+    for(int i=0; i<priv->n_conns; i++) {
+        in_flight += priv->conns[i].in_flight;
+    }
+
+    return msg_iev_build_response(
+        gobj,
+        0,
+        json_sprintf("Messages in queue: %d, in flight: %d",
+            (int)json_array_size(priv->dl_queries),
+            in_flight
+        ),
+        0,
+        0, // owned
+        kw  // owned
+    );
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE json_t *cmd_list_queue(hgobj gobj, const char *cmd, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    return msg_iev_build_response(
+        gobj,
+        0,
+        json_sprintf("Messages in queue: %d", (int)json_array_size(priv->dl_queries)),
+        0,
+        json_incref(priv->dl_queries), // owned
+        kw  // owned
+    );
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE json_t *cmd_view_channels(hgobj gobj, const char *cmd, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_t *jn_data = json_array();
+    for(int i=0; i<priv->n_conns; i++) {
+        pool_conn_t *conn = &priv->conns[i];
+        json_t *jn_sessions = json_array();
+        const char *session; json_t *jn_idx;
+        json_object_foreach(priv->jn_sessions, session, jn_idx) {
+            if(json_integer_value(jn_idx) == i) {
+                json_array_append_new(jn_sessions, json_string(session));
+            }
+        }
+        json_array_append_new(jn_data, json_pack("{s:s, s:b, s:i, s:o}",
+            "name", gobj_name(conn->gobj_conn),
+            "connected", conn->connected,
+            "in_flight", conn->in_flight,
+            "sessions", jn_sessions
+        ));
+    }
+
+    return msg_iev_build_response(
+        gobj,
+        0,
+        json_sprintf(
+            "Channel: '%s', connections: %d/%d",
+            gobj_read_str_attr(gobj, "url"),
+            priv->connected,
+            priv->n_conns
+        ),
+        0,
+        jn_data, // owned
+        kw  // owned
+    );
+}
+
+
+
+
+            /***************************
+             *      Local Methods
+             ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int find_conn(hgobj gobj, hgobj gobj_conn)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    for(int i=0; i<priv->n_conns; i++) {
+        if(priv->conns[i].gobj_conn == gobj_conn) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/***************************************************************************
+ *  Release the sessions pinned to the connection.
+ *  Lost: the transaction is aborted by the server, the session is failed.
+ ***************************************************************************/
+PRIVATE void unpin_sessions(hgobj gobj, int idx, BOOL lost)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    const char *session; json_t *jn_idx; void *n;
+    json_object_foreach_safe(priv->jn_sessions, n, session, jn_idx) {
+        if(json_integer_value(jn_idx) == idx) {
+            if(lost) {
+                gobj_log_warning(gobj, 0,
+                    "function",     "%s", __FUNCTION__,
+                    "msgset",       "%s", MSGSET_POSTGRES,
+                    "msg",          "%s", "Postgres connection lost with session open, transaction aborted",
+                    "session",      "%s", session,
+                    "conn",         "%s", gobj_name(priv->conns[idx].gobj_conn),
+                    NULL
+                );
+                json_object_set_new(priv->jn_failed_sessions, session, json_true());
+            }
+            json_object_del(priv->jn_sessions, session);
+        }
+    }
+    priv->conns[idx].pinned = FALSE;
+}
+
+/***************************************************************************
+ *  The connection is lost: no more queries to it, its sessions are failed.
+ ***************************************************************************/
+PRIVATE void set_conn_lost(hgobj gobj, int idx)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    pool_conn_t *conn = &priv->conns[idx];
+
+    conn->connected = FALSE;
+    priv->connected--;
+
+    if(conn->pinned) {
+        unpin_sessions(gobj, idx, TRUE);
+    }
+
+    if(priv->connected == 0) {
+        gobj_publish_event(gobj, EV_ON_CLOSE, 0);
+    }
+}
+
+/***************************************************************************
+ *  The queries of the connection without result, as it counts them:
+ *  queued there to be sent in the next connection, or in flight.
+ ***************************************************************************/
+PRIVATE void sync_in_flight(hgobj gobj, int idx)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    pool_conn_t *conn = &priv->conns[idx];
+
+    conn->in_flight = (int)gobj_read_integer_attr(conn->gobj_conn, "queries_pending");
+}
+
+/***************************************************************************
+ *  Answer with error a query of a failed session, without sending it.
+ *  The session is closed by its "session_end" query.
+ ***************************************************************************/
+PRIVATE int fail_session_query(hgobj gobj, json_t *kw_query) // owned
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    const char *session = kw_get_str(gobj, kw_query, "session", "", 0);
+    if(kw_get_bool(gobj, kw_query, "session_end", 0, 0)) {
+        json_object_del(priv->jn_failed_sessions, session);
+    }
+
+    json_object_set_new(kw_query, "result", json_integer(-1));
+    json_object_set_new(kw_query, "comment",
+        json_string("Connection lost, session transaction aborted")
+    );
+    json_object_del(kw_query, "copy_data"); // Don't return the data
+
+    if(gobj_trace_level(gobj) & TRACE_MESSAGES) {
+        gobj_trace_json(gobj, kw_query, "🗂🗂Postgres pool RESULT ⏪ 🔴 session FAILED '%s'", session);
+    }
+    return publish_result(gobj, kw_query);
+}
+
+/***************************************************************************
+ *  Connection for the query, -1 if none has room:
+ *  the connection pinned by its session,
+ *  else the least busy of the connections free.
+ ***************************************************************************/
+PRIVATE int choose_conn(hgobj gobj, json_t *kw_query)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    const char *session = kw_get_str(gobj, kw_query, "session", 0, 0);
+    if(session) {
+        json_t *jn_idx = json_object_get(priv->jn_sessions, session);
+        if(jn_idx) {
+            // The connection queues the queries of its session
+            return (int)json_integer_value(jn_idx);
+        }
+    }
+
+    int best = -1;
+    for(int i=0; i<priv->n_conns; i++) {
+        int idx = (priv->cursor + i) % priv->n_conns;
+        pool_conn_t *conn = &priv->conns[idx];
+        if(!conn->connected || conn->pinned || conn->in_flight >= priv->pipeline_depth) {
+            continue;
+        }
+        if(best < 0 || conn->in_flight < priv->conns[best].in_flight) {
+            best = idx;
+        }
+    }
+    if(best >= 0) {
+        priv->cursor = (best + 1) % priv->n_conns;
+    }
+    return best;
+}
+
+/***************************************************************************
+ *  Send the query to the connection.
+ *  The `dst` is kept here, the connection publishes the result to the pool.
+ ***************************************************************************/
+PRIVATE int dispatch_query(hgobj gobj, int idx, json_t *kw_query) // owned
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    pool_conn_t *conn = &priv->conns[idx];
+
+    const char *session = kw_get_str(gobj, kw_query, "session", 0, 0);
+    if(session && !json_object_get(priv->jn_sessions, session)) {
+        json_object_set_new(priv->jn_sessions, session, json_integer(idx));
+        conn->pinned = TRUE;
+    }
+
+    json_t *jn_dst = json_object_get(kw_query, "dst");
+    if(jn_dst) {
+        json_object_set(kw_query, "__pool_dst__", jn_dst);
+        json_object_del(kw_query, "dst");
+    }
+
+    const char *id = kw_get_str(gobj, kw_query, "id", 0, 0);
+    if(!empty_string(id)) {
+        json_object_set_new(priv->jn_dispatched, id, json_integer(idx));
+    }
+
+    if(gobj_trace_level(gobj) & TRACE_MESSAGES) {
+        gobj_trace_msg(gobj, "🗂🗂Postgres pool DISPATCH ⏩ %s, in flight %d%s%s",
+            gobj_name(conn->gobj_conn),
+            conn->in_flight,
+            session?", session ":"",
+            session?session:""
+        );
+    }
+
+    conn->in_flight++;
+    return gobj_send_event(conn->gobj_conn, EV_SEND_QUERY, kw_query, gobj);
+}
+
+/***************************************************************************
+ *  Dispatch the queries waiting while there are connections with room.
+ *  With sessions pinned, the queries of the pinned sessions don't wait
+ *  behind the queries waiting a free connection,
+ *  neither the queries of the failed sessions, answered with error.
+ ***************************************************************************/
+PRIVATE int pull_queue(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    size_t idx = 0;
+    while(idx < json_array_size(priv->dl_queries)) {
+        json_t *kw_query = json_array_get(priv->dl_queries, idx);
+        const char *session = kw_get_str(gobj, kw_query, "session", 0, 0);
+        if(session && json_object_get(priv->jn_failed_sessions, session)) {
+            json_incref(kw_query);
+            json_array_remove(priv->dl_queries, idx);
+            fail_session_query(gobj, kw_query);
+            continue;
+        }
+        int i = choose_conn(gobj, kw_query);
+        if(i < 0) {
+            if(json_object_size(priv->jn_sessions) == 0 &&
+                    json_object_size(priv->jn_failed_sessions) == 0) {
+                break;
+            }
+            idx++;
+            continue;
+        }
+        json_incref(kw_query);
+        json_array_remove(priv->dl_queries, idx);
+        dispatch_query(gobj, i, kw_query);
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *  NOTE Object with __queries_in_queue__
+ *  If in the query there is `dst` then use it to use gobj_send_event()
+ *  else use gobj_publish_event()
+ ***************************************************************************/
+PRIVATE int publish_result(hgobj gobj, json_t* kw)
+{
+    if(kw_has_key(kw, "dst")) {
+        json_t *jn_dst = kw_get_dict_value(gobj, kw, "dst", 0, 0);
+        if(json_is_integer(jn_dst)) {
+            // HACK WARNING don't use volatil gobj's
+            hgobj dst = (hgobj)(size_t)json_integer_value(jn_dst);
+            return gobj_send_event(dst, EV_ON_MESSAGE, kw, gobj);
+
+        } else if(json_is_string(jn_dst)) {
+            const char *sdst = json_string_value(jn_dst);
+            hgobj dst = gobj_find_service(sdst, TRUE);
+            if(dst) {
+                return gobj_send_event(dst, EV_ON_MESSAGE, kw, gobj);
+            } else {
+                // Error already logged
+                gobj_trace_json(gobj, kw, "Result LOST");
+                JSON_DECREF(kw);
+                return -1;
+            }
+
+        } else {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_INTERNAL,
+                "msg",          "%s", "dst UNKNOWN",
+                NULL
+            );
+            gobj_trace_json(gobj, kw, "dst UNKNOWN");
+            JSON_DECREF(kw);
+            return -1;
+        }
+    } else {
+        gobj_publish_event(gobj, EV_ON_MESSAGE, kw);
+        return 0;
+    }
+}
+
+
+
+
+            /***************************
+             *      Actions
+             ***************************/
+
+
+
+
+/***************************************************************************
+ *  NOTE Object with __queries_in_queue__
+ *  Same kw as C_POSTGRES, and:
+    {
+        "session": "...",       // optional, queries of the session to the same connection
+        "session_end": true     // optional, release the connection after this query
+    }
+ ***************************************************************************/
+PRIVATE int ac_send_query(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    const char *query = kw_get_str(gobj, kw, "query", "", KW_REQUIRED);
+    if(empty_string(query)) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "query EMPTY",
+            NULL
+        );
+        KW_DECREF(kw);
+        return -1;
+    }
+
+    json_array_append(priv->dl_queries, kw);
+    pull_queue(gobj);
+
+    KW_DECREF(kw);
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_clear_queue(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    const char *id = kw_get_str(gobj, kw, "id", "", 0);
+    if(empty_string(id)) {
+        json_array_clear(priv->dl_queries);
+        json_object_clear(priv->jn_dispatched);
+        for(int i=0; i<priv->n_conns; i++) {
+            gobj_send_event(priv->conns[i].gobj_conn, EV_CLEAR_QUEUE, json_object(), gobj);
+            sync_in_flight(gobj, i);
+        }
+        KW_DECREF(kw);
+        return 0;
+    }
+
+    size_t idx; json_t *jn_query;
+    json_array_foreach(priv->dl_queries, idx, jn_query) {
+        const char *id_ = kw_get_str(gobj, jn_query, "id", 0, 0);
+        if(id_ && strcmp(id_, id)==0) {
+            json_array_remove(priv->dl_queries, idx);
+            KW_DECREF(kw);
+            return 0;
+        }
+    }
+
+    json_t *jn_idx = json_object_get(priv->jn_dispatched, id);
+    if(jn_idx) {
+        int i = (int)json_integer_value(jn_idx);
+        json_object_del(priv->jn_dispatched, id);
+        gobj_send_event(priv->conns[i].gobj_conn, EV_CLEAR_QUEUE, json_incref(kw), gobj);
+        sync_in_flight(gobj, i);
+        pull_queue(gobj);
+
+    } else {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "query to clear NOT FOUND",
+            "id",           "%s", id,
+            NULL
+        );
+    }
+
+    KW_DECREF(kw);
+    return 0;
+}
+
+/***************************************************************************
+ *  A connection is open
+ ***************************************************************************/
+PRIVATE int ac_on_open(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    int idx = find_conn(gobj, src);
+    if(idx < 0 || priv->conns[idx].connected) {
+        KW_DECREF(kw);
+        return 0;
+    }
+    priv->conns[idx].connected = TRUE;
+    priv->connected++;
+
+    if(priv->connected == 1) {
+        gobj_publish_event(gobj, EV_ON_OPEN, 0);
+    }
+
+    pull_queue(gobj);
+
+    KW_DECREF(kw);
+    return 0;
+}
+
+/***************************************************************************
+ *  A connection is closed.
+ *  It has answered with error its queries in flight and the queries of
+ *  its sessions, the rest are sent in the next connection.
+ *  The sessions are lost (the server aborts their transactions).
+ *  Already lost for the pool if it has failed some query before.
+ ***************************************************************************/
+PRIVATE int ac_on_close(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    int idx = find_conn(gobj, src);
+    if(idx < 0) {
+        KW_DECREF(kw);
+        return 0;
+    }
+    if(priv->conns[idx].connected) {
+        set_conn_lost(gobj, idx);
+    }
+
+    /*
+     *  The queries kept by the connection for the next one are still busy
+     */
+    sync_in_flight(gobj, idx);
+
+    KW_DECREF(kw);
+    return 0;
+}
+
+/***************************************************************************
+ *  Result of a connection
+ ***************************************************************************/
+PRIVATE int ac_on_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    int idx = find_conn(gobj, src);
+    if(idx < 0) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "Result from unknown connection",
+            "src",          "%s", gobj_full_name(src),
+            NULL
+        );
+        KW_DECREF(kw);
+        return -1;
+    }
+    pool_conn_t *conn = &priv->conns[idx];
+    if(conn->in_flight > 0) {
+        conn->in_flight--;
+    }
+
+    if(conn->connected &&
+            (!gobj_in_this_state(src, ST_CONNECTED) || !gobj_is_running(src))) {
+        /*
+         *  The connection is failing its queries, lost or stopped,
+         *  its EV_ON_CLOSE comes later: no more queries to it from now.
+         */
+        set_conn_lost(gobj, idx);
+    }
+
+    const char *id = kw_get_str(gobj, kw, "id", 0, 0);
+    if(!empty_string(id)) {
+        json_object_del(priv->jn_dispatched, id);
+    }
+
+    const char *session = kw_get_str(gobj, kw, "session", 0, 0);
+    if(session && kw_get_bool(gobj, kw, "session_end", 0, 0)) {
+        json_object_del(priv->jn_sessions, session);
+        json_object_del(priv->jn_failed_sessions, session);
+        conn->pinned = FALSE;
+    }
+
+    json_t *jn_dst = json_object_get(kw, "__pool_dst__");
+    if(jn_dst) {
+        json_object_set(kw, "dst", jn_dst);
+        json_object_del(kw, "__pool_dst__");
+    }
+
+    publish_result(gobj, kw);   // owned
+
+    pull_queue(gobj);
+
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_stopped(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    KW_DECREF(kw);
+    return 0;
+}
+
+/***************************************************************************
+ *                          FSM
+ ***************************************************************************/
+/*---------------------------------------------*
+ *          Global methods table
+ *---------------------------------------------*/
+PRIVATE const GMETHODS gmt = {
+    .mt_create  = mt_create,
+    .mt_destroy = mt_destroy,
+    .mt_start   = mt_start,
+    .mt_stop    = mt_stop,
+    .mt_writing = mt_writing,
+};
+
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DEFINE_GCLASS(C_POSTGRES_POOL);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int create_gclass(gclass_name_t gclass_name)
+{
+    static hgclass __gclass__ = 0;
+    if(__gclass__) {
+        gobj_log_error(0, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "GClass ALREADY created",
+            "gclass",       "%s", gclass_name,
+            NULL
+        );
+        return -1;
+    }
+
+    /*------------------------*
+     *      States
+     *------------------------*/
+    ev_action_t st_idle[] = {
+        {EV_SEND_QUERY,     ac_send_query,              0},
+        {EV_CLEAR_QUEUE,    ac_clear_queue,             0},
+        {EV_ON_OPEN,        ac_on_open,                 0},
+        {EV_ON_CLOSE,       ac_on_close,                0},
+        {EV_ON_MESSAGE,     ac_on_message,              0},
+        {EV_STOPPED,        ac_stopped,                 0},
+        {0,0,0}
+    };
+
+    states_t states[] = {
+        {ST_IDLE,               st_idle},
+        {0, 0}
+    };
+
+    /*------------------------*
+     *      Events
+     *------------------------*/
+    event_type_t event_types[] = {
+        // public input events first
+        {EV_SEND_QUERY,         EVF_PUBLIC_EVENT},
+        {EV_CLEAR_QUEUE,        EVF_PUBLIC_EVENT},
+
+        // public output events, inputs too from the connections
+        {EV_ON_OPEN,            EVF_PUBLIC_EVENT|EVF_OUTPUT_EVENT},
+        {EV_ON_CLOSE,           EVF_PUBLIC_EVENT|EVF_OUTPUT_EVENT},
+        {EV_ON_MESSAGE,         EVF_PUBLIC_EVENT|EVF_OUTPUT_EVENT},
+
+        // rest (internal/inputs)
+        {EV_STOPPED,            0},
+        {0, 0}
+    };
+
+    /*----------------------------------------*
+     *          Register GClass
+     *----------------------------------------*/
+    __gclass__ = gclass_create(
+        gclass_name,
+        event_types,
+        states,
+        &gmt,
+        0,                  // Local methods table (LMT) - none
+        attrs_table,
+        sizeof(PRIVATE_DATA),
+        authz_table,        // Authorization table
+        command_table,      // Command table
+        s_user_trace_level,
+        0                   // GClass flags
+    );
+    if(!__gclass__) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC int register_c_postgres_pool(void)
+{
+    return create_gclass(C_POSTGRES_POOL);
+}
@@ -0,0 +1,43 @@
+/****************************************************************************
+ *          C_POSTGRES_POOL.H
+ *          Postgres_pool GClass.
+ *
+ *          Pool of Postgres connections (C_POSTGRES children).
+ *          Same interface as C_POSTGRES: EV_SEND_QUERY, EV_CLEAR_QUEUE,
+ *          the results as EV_ON_MESSAGE (or sent to the `dst` of the query).
+ *
+ *          Copyright (c) 2021 Niyamaka.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#pragma once
+
+#include "c_postgres.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/***************************************************************
+ *              FSM
+ ***************************************************************/
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DECLARE_GCLASS(C_POSTGRES_POOL);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+
+/***************************************************************
+ *              Prototypes
+ ***************************************************************/
+PUBLIC int register_c_postgres_pool(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,11 +7,13 @@
 #include <string.h>
 
 #include <c_pepon.h>
+#include <perf_harness.h>
 #include "c_test4.h"
 
 /***************************************************************************
  *              Constants
  ***************************************************************************/
+#define MAX_ROUND_TRIPS 180000
 #define MESSAGE "{\"id\": 1, \"tm\": 1, \"content\": \"Pepe el alfa.Pepe el alfa.Pepe el alfa.Pepe el alfa.Pepe el alfa.Pepe el alfa.Pepe el alfa.Pepe el.\"}"
 
 /***************************************************************************
@@ -21,6 +23,7 @@
 /***************************************************************************
  *              Prototypes
  ***************************************************************************/
+PRIVATE void send_message(hgobj gobj, gbuffer_t *gbuf);
 
 /***************************************************************************
  *          Data: config, public data, private data
@@ -62,6 +65,10 @@ typedef struct _PRIVATE_DATA {
     hgobj gobj_output_side;
     json_int_t txMsgs;
     json_int_t rxMsgs;
+
+    perf_harness_t *harness;
+    uint64_t t_sent;
+    gbuffer_t *gbuf_pending;    // open loop, message waiting its scheduled time
 } PRIVATE_DATA;
 
 
@@ -87,6 +94,7 @@ PRIVATE void mt_create(hgobj gobj)
         "do_echo", 1
     );
     priv->pepon = gobj_create_pure_child("server", C_PEPON, kw_pepon, gobj);
+    priv->harness = perf_harness_create(gobj_yuno_role());
 
     /*
      *  Do copy of heavy-used parameters, for quick access.
@@ -95,6 +103,18 @@ PRIVATE void mt_create(hgobj gobj)
     SET_PRIV(timeout,               gobj_read_integer_attr)
 }
 
+/***************************************************************************
+ *      Framework Method destroy
+ ***************************************************************************/
+PRIVATE void mt_destroy(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    GBUFFER_DECREF(priv->gbuf_pending)
+    perf_harness_destroy(priv->harness);
+    priv->harness = 0;
+}
+
 /***************************************************************************
  *      Framework Method start
  ***************************************************************************/
@@ -169,6 +189,21 @@ PRIVATE int mt_pause(hgobj gobj)
 
 
 
+/***************************************************************************
+ *  Send a message and take the start time of its round-trip
+ ***************************************************************************/
+PRIVATE void send_message(hgobj gobj, gbuffer_t *gbuf)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_t *kw_send = json_pack("{s:I}",
+        "gbuffer", (json_int_t)(uintptr_t)gbuf
+    );
+    priv->t_sent = perf_harness_sent(priv->harness);
+    gobj_send_event(priv->gobj_output_side, EV_SEND_MESSAGE, kw_send, gobj);
+}
+
+
                     /***************************
                      *      Actions
                      ***************************/
@@ -212,13 +247,22 @@ PRIVATE int ac_timeout_send_messages(hgobj gobj, gobj_event_t event, json_t *kw,
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
+    if(priv->gbuf_pending) {
+        /*
+         *  Open loop, it's the scheduled time of the next message
+         */
+        gbuffer_t *gbuf = priv->gbuf_pending;
+        priv->gbuf_pending = 0;
+        send_message(gobj, gbuf);
+        JSON_DECREF(kw)
+        return 0;
+    }
+
     gbuf_to_send = gbuffer_create(1024, 1024);
     gbuffer_printf(gbuf_to_send, MESSAGE);
 
-    json_t *kw_send = json_pack("{s:I}",
-        "gbuffer", (json_int_t)(uintptr_t)gbuf_to_send
-    );
-    gobj_send_event(priv->gobj_output_side, EV_SEND_MESSAGE, kw_send, gobj);
+    perf_harness_start(priv->harness);
+    send_message(gobj, gbuf_to_send);
 
     JSON_DECREF(kw)
     return 0;
@@ -258,22 +302,30 @@ PRIVATE int ac_on_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
         );
     }
 
+    perf_harness_received(priv->harness, priv->t_sent, gbuffer_leftbytes(gbuf));
+
     static int i=0;
     i++;
 
     if(i==1) {
         MT_START_TIME(time_measure)
     }
-    if(i>180000) {
-        MT_INCREMENT_COUNT(time_measure, 180000)
+    if(i>MAX_ROUND_TRIPS) {
+        MT_INCREMENT_COUNT(time_measure, MAX_ROUND_TRIPS)
         MT_PRINT_TIME(time_measure, gobj_short_name(gobj))
+        perf_harness_stop(priv->harness);
+        perf_harness_print(priv->harness);
+        perf_harness_save(priv->harness);
         set_yuno_must_die();
     } else {
         GBUFFER_INCREF(gbuf)
-        json_t *kw_send = json_pack("{s:I}",
-            "gbuffer", (json_int_t)(uintptr_t)gbuf
-        );
-        gobj_send_event(priv->gobj_output_side, EV_SEND_MESSAGE, kw_send, gobj);
+        uint64_t wait_ms = perf_harness_wait_ms(priv->harness);
+        if(wait_ms > 0) {
+            priv->gbuf_pending = gbuf;
+            set_timeout(priv->timer, (json_int_t)wait_ms);
+        } else {
+            send_message(gobj, gbuf);
+        }
     }
 
     KW_DECREF(kw)
@@ -315,6 +367,7 @@ PRIVATE int ac_stopped(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
  *---------------------------------------------*/
 PRIVATE const GMETHODS gmt = {
     .mt_create = mt_create,
+    .mt_destroy = mt_destroy,
     .mt_start = mt_start,
     .mt_stop = mt_stop,
     .mt_play = mt_play,
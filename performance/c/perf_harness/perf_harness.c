@@ -0,0 +1,483 @@
+/****************************************************************************
+ *          PERF_HARNESS.C
+ *
+ *          Shared latency harness for the performance/c benchmarks.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <helpers.h>
+#include "perf_harness.h"
+
+/***************************************************************
+ *              Constants
+ ***************************************************************/
+/*
+ *  HDR-style layout: values < SUB_COUNT have their own bucket,
+ *  then every power of two is split in SUB_HALF linear sub-buckets.
+ *  The relative error is 1/SUB_HALF (0.78%).
+ */
+#define SUB_BITS        8
+#define SUB_COUNT       (1 << SUB_BITS)         // 256
+#define SUB_HALF        (SUB_COUNT / 2)         // 128
+#define MAX_VALUE_BITS  40                      // values up to 2^39 ns, ~9 minutes
+#define MAX_SHIFT       (MAX_VALUE_BITS - SUB_BITS)
+#define BUCKET_COUNT    (SUB_COUNT + (MAX_SHIFT - 1) * SUB_HALF)
+
+/***************************************************************
+ *              Structures
+ ***************************************************************/
+struct perf_histogram_s {
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+    uint64_t counts[BUCKET_COUNT];
+};
+
+struct perf_harness_s {
+    char name[80];
+    uint64_t rate;          // messages/sec, 0 closed loop
+    uint64_t interval_ns;   // 1e9/rate
+    uint64_t warmup;
+
+    uint64_t t_start;
+    uint64_t t_stop;
+    uint64_t scheduled;     // messages scheduled (open loop)
+    uint64_t count;         // round-trips received
+    uint64_t bytes;
+
+    perf_histogram_t *hist;
+    json_t *params;
+};
+
+
+
+
+                    /***************************
+                     *      Histogram
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Monotonic time in nanoseconds
+ ***************************************************************************/
+PUBLIC uint64_t perf_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/***************************************************************************
+ *  Bucket of a value
+ ***************************************************************************/
+static inline size_t bucket_index(uint64_t value)
+{
+    if(value < SUB_COUNT) {
+        return (size_t)value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - (SUB_BITS - 1);           // value >> shift is in [SUB_HALF, SUB_COUNT)
+    if(shift > MAX_SHIFT - 1) {
+        return BUCKET_COUNT - 1;
+    }
+    return SUB_COUNT + (size_t)(shift - 1) * SUB_HALF + (size_t)((value >> shift) - SUB_HALF);
+}
+
+/***************************************************************************
+ *  Middle value of a bucket
+ ***************************************************************************/
+static inline uint64_t bucket_value(size_t idx)
+{
+    if(idx < SUB_COUNT) {
+        return (uint64_t)idx;
+    }
+    size_t k = idx - SUB_COUNT;
+    int shift = (int)(k / SUB_HALF) + 1;
+    uint64_t low = ((uint64_t)(k % SUB_HALF) + SUB_HALF) << shift;
+    return low + ((1ULL << shift) >> 1);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC perf_histogram_t *perf_histogram_create(void)
+{
+    perf_histogram_t *hist = GBMEM_MALLOC(sizeof(perf_histogram_t));
+    if(!hist) {
+        gobj_log_error(0, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY,
+            "msg",          "%s", "GBMEM_MALLOC() FAILED",
+            NULL
+        );
+        return NULL;
+    }
+    perf_histogram_reset(hist);
+    return hist;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC void perf_histogram_destroy(perf_histogram_t *hist)
+{
+    GBMEM_FREE(hist);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC void perf_histogram_reset(perf_histogram_t *hist)
+{
+    memset(hist, 0, sizeof(perf_histogram_t));
+    hist->min = UINT64_MAX;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC void perf_histogram_record(perf_histogram_t *hist, uint64_t value)
+{
+    hist->counts[bucket_index(value)]++;
+    hist->count++;
+    hist->sum += value;
+    if(value < hist->min) {
+        hist->min = value;
+    }
+    if(value > hist->max) {
+        hist->max = value;
+    }
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC uint64_t perf_histogram_count(perf_histogram_t *hist)
+{
+    return hist->count;
+}
+
+PUBLIC uint64_t perf_histogram_min(perf_histogram_t *hist)
+{
+    return hist->count? hist->min : 0;
+}
+
+PUBLIC uint64_t perf_histogram_max(perf_histogram_t *hist)
+{
+    return hist->max;
+}
+
+PUBLIC uint64_t perf_histogram_mean(perf_histogram_t *hist)
+{
+    return hist->count? hist->sum / hist->count : 0;
+}
+
+/***************************************************************************
+ *  Value below which `percentile` % of the values fall
+ ***************************************************************************/
+PUBLIC uint64_t perf_histogram_percentile(perf_histogram_t *hist, double percentile)
+{
+    if(hist->count == 0) {
+        return 0;
+    }
+    if(percentile >= 100.0) {
+        return hist->max;
+    }
+    if(percentile < 0.0) {
+        percentile = 0.0;
+    }
+
+    uint64_t target = (uint64_t)((percentile / 100.0) * (double)hist->count + 0.5);
+    if(target < 1) {
+        target = 1;
+    }
+
+    uint64_t acc = 0;
+    for(size_t i=0; i<BUCKET_COUNT; i++) {
+        acc += hist->counts[i];
+        if(acc >= target) {
+            uint64_t value = bucket_value(i);
+            if(value > hist->max) {
+                value = hist->max;
+            }
+            if(value < hist->min) {
+                value = hist->min;
+            }
+            return value;
+        }
+    }
+    return hist->max;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC json_t *perf_histogram_json(perf_histogram_t *hist)
+{
+    return json_pack("{s:I, s:I, s:I, s:I, s:I, s:I, s:I}",
+        "min",      (json_int_t)perf_histogram_min(hist),
+        "mean",     (json_int_t)perf_histogram_mean(hist),
+        "p50",      (json_int_t)perf_histogram_percentile(hist, 50.0),
+        "p90",      (json_int_t)perf_histogram_percentile(hist, 90.0),
+        "p99",      (json_int_t)perf_histogram_percentile(hist, 99.0),
+        "p99_9",    (json_int_t)perf_histogram_percentile(hist, 99.9),
+        "max",      (json_int_t)perf_histogram_max(hist)
+    );
+}
+
+/***************************************************************************
+ *  Write json to $PERF_RESULTS_DIR/<name>.json
+ ***************************************************************************/
+PUBLIC int perf_save_json(const char *name, json_t *jn)
+{
+    const char *directory = getenv("PERF_RESULTS_DIR");
+    if(empty_string(directory)) {
+        JSON_DECREF(jn)
+        return 0;
+    }
+
+    char filename[NAME_MAX];
+    snprintf(filename, sizeof(filename), "%s.json", name);
+
+    return save_json_to_file(
+        0,
+        directory,
+        filename,
+        02775,
+        0664,
+        0,
+        TRUE,   // Create file if not exists or overwrite.
+        FALSE,  // only_read
+        jn      // owned
+    );
+}
+
+/***************************************************************************
+ *  Unsigned integer from the environment
+ ***************************************************************************/
+PUBLIC uint64_t perf_env_uint64(const char *name, uint64_t default_value)
+{
+    const char *s = getenv(name);
+    if(empty_string(s)) {
+        return default_value;
+    }
+    return strtoull(s, NULL, 10);
+}
+
+
+
+
+                    /***************************
+                     *      Harness
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC perf_harness_t *perf_harness_create(const char *name)
+{
+    perf_harness_t *h = GBMEM_MALLOC(sizeof(perf_harness_t));
+    if(!h) {
+        gobj_log_error(0, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY,
+            "msg",          "%s", "GBMEM_MALLOC() FAILED",
+            NULL
+        );
+        return NULL;
+    }
+    h->hist = perf_histogram_create();
+    if(!h->hist) {
+        GBMEM_FREE(h);
+        return NULL;
+    }
+
+    snprintf(h->name, sizeof(h->name), "%s", name);
+    h->rate = perf_env_uint64("PERF_RATE", 0);
+    h->interval_ns = h->rate? 1000000000ULL / h->rate : 0;
+    h->warmup = perf_env_uint64("PERF_WARMUP", 0);
+
+    return h;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC void perf_harness_destroy(perf_harness_t *h)
+{
+    if(!h) {
+        return;
+    }
+    perf_histogram_destroy(h->hist);
+    JSON_DECREF(h->params)
+    GBMEM_FREE(h);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC void perf_harness_start(perf_harness_t *h)
+{
+    h->t_start = perf_now_ns();
+    h->t_stop = 0;
+    h->scheduled = 0;
+    h->count = 0;
+    h->bytes = 0;
+    perf_histogram_reset(h->hist);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC void perf_harness_stop(perf_harness_t *h)
+{
+    h->t_stop = perf_now_ns();
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC uint64_t perf_harness_rate(perf_harness_t *h)
+{
+    return h->rate;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC void perf_harness_set_params(perf_harness_t *h, json_t *params)
+{
+    JSON_DECREF(h->params)
+    h->params = params;
+}
+
+/***************************************************************************
+ *  Milliseconds until the next scheduled send
+ ***************************************************************************/
+PUBLIC uint64_t perf_harness_wait_ms(perf_harness_t *h)
+{
+    if(!h->rate) {
+        return 0;
+    }
+    uint64_t intended = h->t_start + h->scheduled * h->interval_ns;
+    uint64_t now = perf_now_ns();
+    if(intended <= now) {
+        return 0;
+    }
+    return (intended - now) / 1000000ULL;
+}
+
+/***************************************************************************
+ *  Start time of the round-trip:
+ *  in open loop the scheduled time, unless the message goes out early.
+ ***************************************************************************/
+PUBLIC uint64_t perf_harness_sent(perf_harness_t *h)
+{
+    uint64_t now = perf_now_ns();
+    if(!h->rate) {
+        return now;
+    }
+    uint64_t intended = h->t_start + h->scheduled * h->interval_ns;
+    h->scheduled++;
+    return intended < now? intended : now;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC void perf_harness_received(perf_harness_t *h, uint64_t t_sent, size_t bytes)
+{
+    uint64_t now = perf_now_ns();
+    h->count++;
+    h->bytes += bytes;
+    if(h->count <= h->warmup) {
+        return;
+    }
+    perf_histogram_record(h->hist, now > t_sent? now - t_sent : 0);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC uint64_t perf_harness_count(perf_harness_t *h)
+{
+    return h->count;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC json_t *perf_harness_results(perf_harness_t *h)
+{
+    uint64_t t_stop = h->t_stop? h->t_stop : perf_now_ns();
+    uint64_t duration_ns = t_stop > h->t_start? t_stop - h->t_start : 1;
+    double seconds = (double)duration_ns / 1e9;
+    perf_histogram_t *hist = h->hist;
+
+    json_t *jn_latency = perf_histogram_json(hist);
+
+    json_t *jn_results = json_pack("{s:s, s:s, s:I, s:I, s:I, s:I, s:I, s:I, s:o}",
+        "name",             h->name,
+        "mode",             h->rate? "open-loop" : "closed-loop",
+        "rate",             (json_int_t)h->rate,
+        "duration_ms",      (json_int_t)(duration_ns / 1000000ULL),
+        "count",            (json_int_t)h->count,
+        "recorded",         (json_int_t)perf_histogram_count(hist),
+        "msgs_per_sec",     (json_int_t)((double)h->count / seconds),
+        "bytes_per_sec",    (json_int_t)((double)h->bytes / seconds),
+        "latency_ns",       jn_latency
+    );
+    if(h->params) {
+        json_object_set(jn_results, "params", h->params);
+    }
+    return jn_results;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC void perf_harness_print(perf_harness_t *h)
+{
+    json_t *jn = perf_harness_results(h);
+    json_t *jn_latency = json_object_get(jn, "latency_ns");
+
+    #define US(key_) ((double)json_integer_value(json_object_get(jn_latency, key_)) / 1000.0)
+
+    printf("%s (%s", h->name, h->rate? "open-loop" : "closed-loop");
+    if(h->rate) {
+        printf(", %llu msg/sec", (unsigned long long)h->rate);
+    }
+    printf(")\n");
+    printf("    Msg/sec    : %lld\n",
+        (long long)json_integer_value(json_object_get(jn, "msgs_per_sec")));
+    printf("    Bytes/sec  : %lld\n",
+        (long long)json_integer_value(json_object_get(jn, "bytes_per_sec")));
+    printf("    Latency us : p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f (%lld samples)\n",
+        US("p50"), US("p90"), US("p99"), US("p99_9"), US("max"),
+        (long long)json_integer_value(json_object_get(jn, "recorded"))
+    );
+
+    #undef US
+
+    json_decref(jn);
+}
+
+/***************************************************************************
+ *  Write the results to $PERF_RESULTS_DIR/<name>.json
+ ***************************************************************************/
+PUBLIC int perf_harness_save(perf_harness_t *h)
+{
+    return perf_save_json(h->name, perf_harness_results(h));
+}
@@ -0,0 +1,139 @@
+/****************************************************************************
+ *          PERF_HARNESS.H
+ *
+ *          Shared latency harness for the performance/c benchmarks.
+ *
+ *          Every benchmark is a round-trip echo.  The harness records the
+ *          round-trip latency of each message in an HDR-style histogram
+ *          (log2 buckets, linear sub-buckets, < 1% error), reports
+ *          p50/p90/p99/p99.9/max next to the throughput, and writes the
+ *          results as json for regression comparison.
+ *
+ *          Load modes:
+ *            - closed loop (default): send the next message when the
+ *              echo of the previous one arrives.
+ *            - open loop (fixed rate): messages are scheduled at a fixed
+ *              rate.  The latency is measured from the scheduled send
+ *              time, so a stalled echo is charged to every message that
+ *              should have been sent during the stall (no coordinated
+ *              omission).
+ *
+ *          Environment variables, read in perf_harness_create():
+ *              PERF_RATE           messages/sec of the open loop, 0 or unset is closed loop
+ *              PERF_WARMUP         number of first round-trips not recorded (default 0)
+ *              PERF_RESULTS_DIR    directory where perf_harness_save() writes <name>.json,
+ *                                  unset: nothing is written
+ *
+ *          Usage:
+ *              h = perf_harness_create("perf_yev_ping_pong");
+ *              perf_harness_start(h);
+ *              ...
+ *              wait = perf_harness_wait_ms(h);     // 0: send now, else arm a timer
+ *              t0 = perf_harness_sent(h);          // when sending
+ *              ...
+ *              perf_harness_received(h, t0, len);  // when the echo is complete
+ *              ...
+ *              perf_harness_stop(h);
+ *              perf_harness_print(h);
+ *              perf_harness_save(h);
+ *              perf_harness_destroy(h);
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#pragma once
+
+#include <gobj.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************
+ *      Types
+ ***************************************************************/
+typedef struct perf_histogram_s perf_histogram_t;
+typedef struct perf_harness_s perf_harness_t;
+
+/***************************************************************
+ *      Prototypes
+ ***************************************************************/
+/*
+ *  Monotonic time in nanoseconds
+ */
+PUBLIC uint64_t perf_now_ns(void);
+
+/*
+ *  Histogram of values in nanoseconds, up to ~9 minutes.
+ *  Bigger values are recorded in the last bucket (max is exact).
+ */
+PUBLIC perf_histogram_t *perf_histogram_create(void);
+PUBLIC void perf_histogram_destroy(perf_histogram_t *hist);
+PUBLIC void perf_histogram_reset(perf_histogram_t *hist);
+PUBLIC void perf_histogram_record(perf_histogram_t *hist, uint64_t value);
+PUBLIC uint64_t perf_histogram_count(perf_histogram_t *hist);
+PUBLIC uint64_t perf_histogram_min(perf_histogram_t *hist);
+PUBLIC uint64_t perf_histogram_max(perf_histogram_t *hist);
+PUBLIC uint64_t perf_histogram_mean(perf_histogram_t *hist);
+PUBLIC uint64_t perf_histogram_percentile(perf_histogram_t *hist, double percentile); // 0..100
+PUBLIC json_t *perf_histogram_json(perf_histogram_t *hist); // {"min", "mean", "p50", "p90", "p99", "p99_9", "max"}, return is yours
+
+/*
+ *  Write json to $PERF_RESULTS_DIR/<name>.json, nothing if PERF_RESULTS_DIR is unset.
+ */
+PUBLIC int perf_save_json(const char *name, json_t *jn); // jn owned
+
+/*
+ *  Unsigned integer from the environment, default_value if unset
+ */
+PUBLIC uint64_t perf_env_uint64(const char *name, uint64_t default_value);
+
+/*
+ *  Harness
+ */
+PUBLIC perf_harness_t *perf_harness_create(const char *name);
+PUBLIC void perf_harness_destroy(perf_harness_t *h);
+
+PUBLIC void perf_harness_start(perf_harness_t *h);  // start the clock and the schedule
+PUBLIC void perf_harness_stop(perf_harness_t *h);   // stop the clock
+
+PUBLIC uint64_t perf_harness_rate(perf_harness_t *h); // 0 closed loop
+
+/*
+ *  Parameters of the run, saved as "params" in the results.
+ */
+PUBLIC void perf_harness_set_params(perf_harness_t *h, json_t *params); // owned
+
+/*
+ *  Milliseconds until the next scheduled send, 0 if it's due (always 0 in closed loop).
+ */
+PUBLIC uint64_t perf_harness_wait_ms(perf_harness_t *h);
+
+/*
+ *  Call it when sending a message.
+ *  Return the start time of the round-trip, to pass to perf_harness_received().
+ */
+PUBLIC uint64_t perf_harness_sent(perf_harness_t *h);
+
+/*
+ *  Call it when the echo is complete.
+ */
+PUBLIC void perf_harness_received(perf_harness_t *h, uint64_t t_sent, size_t bytes);
+
+PUBLIC uint64_t perf_harness_count(perf_harness_t *h); // round-trips received, warmup included
+
+/*
+ *  Results:
+ *  {
+ *      "name", "mode" ("closed-loop"|"open-loop"), "rate",
+ *      "duration_ms", "count", "recorded" (count - warmup), "msgs_per_sec", "bytes_per_sec",
+ *      "latency_ns": {"min", "mean", "p50", "p90", "p99", "p99_9", "max"}
+ *  }
+ */
+PUBLIC json_t *perf_harness_results(perf_harness_t *h); // return is yours
+PUBLIC void perf_harness_print(perf_harness_t *h);
+PUBLIC int perf_harness_save(perf_harness_t *h);   // to $PERF_RESULTS_DIR/<name>.json
+
+#ifdef __cplusplus
+}
+#endif
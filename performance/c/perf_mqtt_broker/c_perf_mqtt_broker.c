@@ -0,0 +1,1042 @@
+/****************************************************************************
+ *          C_PERF_MQTT_BROKER.C
+ *
+ *          Load generator for the MQTT broker.
+ *
+ *          `publishers` + `subscribers` MQTT clients, each one its own
+ *          C_IOGATE -> C_CHANNEL -> C_PROT_MQTT2 (client) -> C_TCP tree,
+ *          connect to the embedded broker.  When all of them are connected
+ *          and subscribed, every publisher sends `messages` PUBLISHes and
+ *          the run ends when every expected delivery has arrived.
+ *
+ *          Topics are "perf/<t>/data", t in [0, topics).
+ *          The first `wildcard_ratio` % of the subscribers subscribe to
+ *          "perf/+/data" or "perf/#" (they receive every message), the rest
+ *          to one exact topic, round-robin.
+ *          `qos1_ratio`, `qos2_ratio` and `retain_ratio` are the % of the
+ *          publishes sent with QoS 1, QoS 2 and the retain flag.
+ *          `persistent_sessions` connects the clients with clean_session 0.
+ *
+ *          The payload carries the send time, the latency is measured from
+ *          the PUBLISH to each delivery (one sample per subscriber).
+ *          Closed loop: each publisher keeps at most `window` publishes
+ *          not yet delivered to all their subscribers.
+ *          Open loop (PERF_RATE): the publishes are sent round-robin over
+ *          the publishers at PERF_RATE publishes/sec.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <yunetas.h>
+#include <c_prot_mqtt2.h>
+#include <perf_harness.h>
+
+#include "c_perf_mqtt_broker.h"
+
+/***************************************************************************
+ *          Tunables
+ ***************************************************************************/
+#define PAYLOAD_HEADER_SIZE     24  // t_sent(8) run_id(4) publisher(4) seq(4) reserved(4)
+#define STARTUP_TIMEOUT_SECONDS 10
+#define STALL_SECONDS           5
+#define MAX_BURST               10000   // max publishes sent per open loop tick
+
+/***************************************************************************
+ *          Data: config, public data, private data
+ ***************************************************************************/
+PRIVATE sdata_desc_t attrs_table[] = {
+/*-ATTR-type----------name--------------------flag----default-----------------------description---------*/
+SDATA (DTP_STRING,    "url",                  SDF_RD, "tcp://127.0.0.1:18120",    "Broker url"),
+SDATA (DTP_INTEGER,   "max_clients",          SDF_RD, "128",  "Channels of the broker, publishers + subscribers can't exceed it"),
+SDATA (DTP_STRING,    "mqtt_protocol",        SDF_RD, "mqttv5", "MQTT Protocol of the clients: mqttv5, mqttv311 or mqttv31"),
+SDATA (DTP_INTEGER,   "publishers",           SDF_RD, "4",    "Number of publisher clients"),
+SDATA (DTP_INTEGER,   "subscribers",          SDF_RD, "4",    "Number of subscriber clients"),
+SDATA (DTP_INTEGER,   "messages",             SDF_RD, "20000","Publishes sent by each publisher"),
+SDATA (DTP_INTEGER,   "payload_size",         SDF_RD, "64",   "Payload size in bytes, minimum 24"),
+SDATA (DTP_INTEGER,   "topics",               SDF_RD, "16",   "Number of topics"),
+SDATA (DTP_INTEGER,   "wildcard_ratio",       SDF_RD, "25",   "% of subscribers using a wildcard filter"),
+SDATA (DTP_INTEGER,   "qos1_ratio",           SDF_RD, "0",    "% of publishes with QoS 1"),
+SDATA (DTP_INTEGER,   "qos2_ratio",           SDF_RD, "0",    "% of publishes with QoS 2"),
+SDATA (DTP_INTEGER,   "retain_ratio",         SDF_RD, "0",    "% of publishes with the retain flag"),
+SDATA (DTP_BOOLEAN,   "persistent_sessions",  SDF_RD, "0",    "Connect the clients with clean_session 0"),
+SDATA (DTP_INTEGER,   "window",               SDF_RD, "16",   "Closed loop: publishes of a publisher pending of delivery"),
+SDATA (DTP_POINTER,   "user_data",            0,      0,      "user data"),
+SDATA_END()
+};
+
+enum {
+    TRACE_MESSAGES = 0x0001,
+};
+PRIVATE const trace_level_t s_user_trace_level[16] = {
+    {"messages",    "Trace perf orchestrator flow"},
+    {0, 0}
+};
+
+typedef struct {
+    uint32_t seq;
+    uint32_t remaining;     // deliveries pending, 0 free slot
+} slot_t;
+
+typedef struct {
+    hgobj       iogate;
+    int         idx;        // index in publishers or subscribers
+    BOOL        publisher;
+    BOOL        ready;      // publisher connected, subscriber subscribed
+    uint32_t    next_seq;   // publisher
+    slot_t      *slots;     // publisher, closed loop
+} client_t;
+
+typedef struct _PRIVATE_DATA {
+    hgobj       timer;          // 1 s: startup timeout, stall detection, exit
+    hgobj       timer_send;     // warm-up and open loop pacing
+    hgobj       gobj_tranger_queues;
+    json_t      *tranger_queues;
+    perf_harness_t *harness;
+
+    int         publishers;
+    int         subscribers;
+    uint32_t    messages;
+    int         payload_size;
+    int         topics;
+    int         wildcard_ratio;
+    int         qos1_ratio;
+    int         qos2_ratio;
+    int         retain_ratio;
+    BOOL        persistent_sessions;
+    uint32_t    window;
+    int         max_qos;
+
+    client_t    *clients;       // publishers first, then subscribers
+    int         n_clients;
+    int         n_ready;
+    uint32_t    *fanout;        // deliveries of a publish, by topic
+    char        *filler;        // payload after the header
+
+    uint32_t    run_id;
+    BOOL        launched;
+    BOOL        running;
+    BOOL        dying;
+    int         next_publisher; // open loop round-robin
+    int         ticks;
+
+    uint64_t    total;          // publishes to send
+    uint64_t    published;
+    uint64_t    expected;       // deliveries expected of the published
+    uint64_t    delivered;
+    uint64_t    stale;          // deliveries of other runs, or unknown
+    uint64_t    last_published;
+    uint64_t    last_delivered;
+} PRIVATE_DATA;
+
+
+
+
+            /***************************
+             *      Prototypes
+             ***************************/
+
+
+
+
+PRIVATE int open_client_queues(hgobj gobj);
+PRIVATE void launch_clients(hgobj gobj);
+PRIVATE void stop_clients(hgobj gobj);
+PRIVATE void start_run(hgobj gobj);
+PRIVATE void finish_run(hgobj gobj);
+PRIVATE void pump_publisher(hgobj gobj, client_t *client);
+PRIVATE void send_due_publishes(hgobj gobj);
+PRIVATE void check_done(hgobj gobj);
+
+
+
+
+            /******************************
+             *      Framework Methods
+             ******************************/
+
+
+
+
+/***************************************************************************
+ *      Framework Method create
+ ***************************************************************************/
+PRIVATE void mt_create(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->timer = gobj_create_pure_child(gobj_name(gobj), C_TIMER0, 0, gobj);
+    priv->timer_send = gobj_create_pure_child(gobj_name(gobj), C_TIMER0, 0, gobj);
+
+    priv->publishers = (int)gobj_read_integer_attr(gobj, "publishers");
+    priv->subscribers = (int)gobj_read_integer_attr(gobj, "subscribers");
+    priv->messages = (uint32_t)gobj_read_integer_attr(gobj, "messages");
+    priv->payload_size = (int)gobj_read_integer_attr(gobj, "payload_size");
+    priv->topics = (int)gobj_read_integer_attr(gobj, "topics");
+    priv->wildcard_ratio = (int)gobj_read_integer_attr(gobj, "wildcard_ratio");
+    priv->qos1_ratio = (int)gobj_read_integer_attr(gobj, "qos1_ratio");
+    priv->qos2_ratio = (int)gobj_read_integer_attr(gobj, "qos2_ratio");
+    priv->retain_ratio = (int)gobj_read_integer_attr(gobj, "retain_ratio");
+    priv->persistent_sessions = gobj_read_bool_attr(gobj, "persistent_sessions");
+    priv->window = (uint32_t)gobj_read_integer_attr(gobj, "window");
+
+    int max_clients = (int)gobj_read_integer_attr(gobj, "max_clients");
+    if(priv->publishers < 1) {
+        priv->publishers = 1;
+    }
+    if(priv->subscribers < 0) {
+        priv->subscribers = 0;
+    }
+    if(priv->publishers + priv->subscribers > max_clients) {
+        gobj_log_warning(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER,
+            "msg",          "%s", "Too many clients, subscribers reduced",
+            "max_clients",  "%d", max_clients,
+            "publishers",   "%d", priv->publishers,
+            "subscribers",  "%d", priv->subscribers,
+            NULL
+        );
+        priv->subscribers = MAX(0, max_clients - priv->publishers);
+        priv->publishers = MIN(priv->publishers, max_clients);
+    }
+    if(priv->messages < 1) {
+        priv->messages = 1;
+    }
+    if(priv->payload_size < PAYLOAD_HEADER_SIZE) {
+        priv->payload_size = PAYLOAD_HEADER_SIZE;
+    }
+    if(priv->topics < 1) {
+        priv->topics = 1;
+    }
+    if(priv->window < 1) {
+        priv->window = 1;
+    }
+    priv->wildcard_ratio = MAX(0, MIN(100, priv->wildcard_ratio));
+    priv->qos2_ratio = MAX(0, MIN(100, priv->qos2_ratio));
+    priv->qos1_ratio = MAX(0, MIN(100 - priv->qos2_ratio, priv->qos1_ratio));
+    priv->retain_ratio = MAX(0, MIN(100, priv->retain_ratio));
+
+    priv->max_qos = priv->qos2_ratio? 2 : priv->qos1_ratio? 1 : 0;
+    priv->total = (uint64_t)priv->publishers * priv->messages;
+
+    priv->harness = perf_harness_create(gobj_yuno_role());
+}
+
+/***************************************************************************
+ *      Framework Method destroy
+ ***************************************************************************/
+PRIVATE void mt_destroy(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->clients) {
+        for(int i = 0; i < priv->n_clients; i++) {
+            GBMEM_FREE(priv->clients[i].slots);
+        }
+        GBMEM_FREE(priv->clients);
+    }
+    GBMEM_FREE(priv->fanout);
+    GBMEM_FREE(priv->filler);
+
+    perf_harness_destroy(priv->harness);
+    priv->harness = 0;
+}
+
+/***************************************************************************
+ *      Framework Method start
+ ***************************************************************************/
+PRIVATE int mt_start(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gobj_start(priv->timer);
+    gobj_start(priv->timer_send);
+
+    /*
+     *  Without queues the max qos of the clients is 0
+     */
+    if(priv->max_qos > 0 || priv->persistent_sessions) {
+        open_client_queues(gobj);
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method stop
+ ***************************************************************************/
+PRIVATE int mt_stop(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gobj_stop(priv->timer);
+    gobj_stop(priv->timer_send);
+    stop_clients(gobj);
+
+    if(priv->gobj_tranger_queues) {
+        gobj_stop(priv->gobj_tranger_queues);
+        EXEC_AND_RESET(gobj_destroy, priv->gobj_tranger_queues)
+        priv->tranger_queues = 0;
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method play
+ ***************************************************************************/
+PRIVATE int mt_play(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    /* Warm-up delay so the broker services are fully up. */
+    set_timeout0(priv->timer_send, 500);
+    set_timeout_periodic0(priv->timer, 1000);
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method pause
+ ***************************************************************************/
+PRIVATE int mt_pause(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    clear_timeout0(priv->timer);
+    clear_timeout0(priv->timer_send);
+    return 0;
+}
+
+
+
+
+            /***************************
+             *      Helpers
+             ***************************/
+
+
+
+
+/***************************************************************************
+ *  Queues of the clients for qos > 0 and persistent sessions
+ ***************************************************************************/
+PRIVATE int open_client_queues(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    char path[PATH_MAX];
+    yuneta_realm_store_dir(
+        path,
+        sizeof(path),
+        gobj_yuno_role(),
+        gobj_yuno_realm_owner(),
+        gobj_yuno_realm_id(),
+        "clients",  // tenant, the broker uses the yuno name
+        "qmsgs",
+        TRUE
+    );
+
+    json_t *kw_tranger_qmsgs = json_pack("{s:s, s:b, s:i}",
+        "path", path,
+        "master", 1,
+        "on_critical_error", (int)(LOG_OPT_EXIT_ZERO)
+    );
+    priv->gobj_tranger_queues = gobj_create_service(
+        "tranger_clients_queues",
+        C_TRANGER,
+        kw_tranger_qmsgs,
+        gobj
+    );
+    gobj_start(priv->gobj_tranger_queues);
+
+    priv->tranger_queues = gobj_read_pointer_attr(priv->gobj_tranger_queues, "tranger");
+    return 0;
+}
+
+/***************************************************************************
+ *  Broadcast the queues to the C_PROT_MQTT2 of a client
+ ***************************************************************************/
+PRIVATE int cb_set_pointer_attr(
+    hgobj child,
+    void *user_data,
+    void *user_data2,
+    void *user_data3)
+{
+    const char *attr = user_data;
+    void *value = user_data2;
+
+    if(gobj_has_attr(child, attr)) {
+        gobj_write_pointer_attr(child, attr, value);
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  One MQTT client
+ ***************************************************************************/
+PRIVATE char client_config[]= "\
+{                                                                   \n\
+    'name': '(^^__name__^^)',                                       \n\
+    'gclass': 'C_IOGATE',                                           \n\
+    'children': [                                                   \n\
+        {                                                           \n\
+            'name': '(^^__name__^^)',                               \n\
+            'gclass': 'C_CHANNEL',                                  \n\
+            'children': [                                           \n\
+                {                                                   \n\
+                    'name': '(^^__name__^^)',                       \n\
+                    'gclass': 'C_PROT_MQTT2',                       \n\
+                    'kw': {                                         \n\
+                        'mqtt_client_id': '(^^__mqtt_client_id__^^)',   \n\
+                        'mqtt_protocol': '(^^__mqtt_protocol__^^)',     \n\
+                        'mqtt_clean_session': '(^^__mqtt_clean_session__^^)', \n\
+                        'iamServer': false                          \n\
+                    },                                              \n\
+                    'children': [                                   \n\
+                        {                                           \n\
+                            'name': '(^^__name__^^)',               \n\
+                            'gclass': 'C_TCP',                      \n\
+                            'kw': {                                 \n\
+                                'url': '(^^__url__^^)'              \n\
+                            }                                       \n\
+                        }                                           \n\
+                    ]                                               \n\
+                }                                                   \n\
+            ]                                                       \n\
+        }                                                           \n\
+    ]                                                               \n\
+}                                                                   \n\
+";
+
+PRIVATE int create_client(hgobj gobj, client_t *client)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s-%d", client->publisher? "pub" : "sub", client->idx);
+    char client_id[80];
+    snprintf(client_id, sizeof(client_id), "perf-mqtt-%s", name);
+
+    json_t *jn_config_variables = json_pack("{s:s, s:s, s:s, s:s, s:s}",
+        "__name__", name,
+        "__url__", gobj_read_str_attr(gobj, "url"),
+        "__mqtt_client_id__", client_id,
+        "__mqtt_protocol__", gobj_read_str_attr(gobj, "mqtt_protocol"),
+        "__mqtt_clean_session__", priv->persistent_sessions? "0" : "1"
+    );
+
+    client->iogate = gobj_create_tree(
+        gobj,
+        client_config,
+        jn_config_variables
+    );
+    if(!client->iogate) {
+        // Error already logged
+        return -1;
+    }
+    gobj_write_pointer_attr(client->iogate, "user_data", client);
+
+    if(priv->tranger_queues) {
+        gobj_walk_gobj_children_tree(
+            client->iogate,
+            WALK_TOP2BOTTOM,
+            cb_set_pointer_attr,
+            "tranger_queues",
+            priv->tranger_queues,
+            NULL
+        );
+    }
+
+    gobj_start_tree(client->iogate);
+    return 0;
+}
+
+/***************************************************************************
+ *  Subscription of the subscriber `idx`, and the deliveries per topic
+ ***************************************************************************/
+PRIVATE void subscription_filter(hgobj gobj, int idx, char *bf, size_t bfsize)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    int n_wildcard = priv->subscribers * priv->wildcard_ratio / 100;
+    if(idx < n_wildcard) {
+        snprintf(bf, bfsize, "%s", (idx % 2)? "perf/#" : "perf/+/data");
+    } else {
+        snprintf(bf, bfsize, "perf/%d/data", (idx - n_wildcard) % priv->topics);
+    }
+}
+
+PRIVATE void compute_fanout(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    int n_wildcard = priv->subscribers * priv->wildcard_ratio / 100;
+    for(int t = 0; t < priv->topics; t++) {
+        priv->fanout[t] = (uint32_t)n_wildcard;
+    }
+    for(int idx = n_wildcard; idx < priv->subscribers; idx++) {
+        priv->fanout[(idx - n_wildcard) % priv->topics]++;
+    }
+}
+
+/***************************************************************************
+ *  Create and connect all the clients
+ ***************************************************************************/
+PRIVATE void launch_clients(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->launched) {
+        return;
+    }
+    priv->launched = TRUE;
+
+    priv->n_clients = priv->publishers + priv->subscribers;
+    priv->clients = GBMEM_MALLOC(sizeof(client_t) * (size_t)priv->n_clients);
+    priv->fanout = GBMEM_MALLOC(sizeof(uint32_t) * (size_t)priv->topics);
+    priv->filler = GBMEM_MALLOC((size_t)priv->payload_size);
+    if(!priv->clients || !priv->fanout || !priv->filler) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY,
+            "msg",          "%s", "GBMEM_MALLOC() FAILED",
+            NULL
+        );
+        priv->n_clients = 0;
+        return;
+    }
+    memset(priv->filler, 'x', (size_t)priv->payload_size);
+    compute_fanout(gobj);
+
+    for(int i = 0; i < priv->n_clients; i++) {
+        client_t *client = &priv->clients[i];
+        client->publisher = i < priv->publishers;
+        client->idx = client->publisher? i : i - priv->publishers;
+        if(client->publisher) {
+            client->slots = GBMEM_MALLOC(sizeof(slot_t) * priv->window);
+        }
+        create_client(gobj, client);
+    }
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void stop_clients(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    for(int i = 0; i < priv->n_clients; i++) {
+        client_t *client = &priv->clients[i];
+        if(client->iogate && gobj_is_running(client->iogate)) {
+            gobj_stop_tree(client->iogate);
+        }
+    }
+}
+
+/***************************************************************************
+ *  Send a PUBLISH
+ ***************************************************************************/
+PRIVATE void publish(hgobj gobj, client_t *client)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    uint32_t seq = client->next_seq++;
+    int t = (int)((client->idx + seq) % (uint32_t)priv->topics);
+    int r = (int)(seq % 100);
+    int qos = r < priv->qos2_ratio? 2 : r < priv->qos2_ratio + priv->qos1_ratio? 1 : 0;
+    BOOL retain = (int)((seq * 37 + 11) % 100) < priv->retain_ratio;
+
+    char topic[64];
+    snprintf(topic, sizeof(topic), "perf/%d/data", t);
+
+    uint64_t t_sent = perf_harness_sent(priv->harness);
+    uint32_t pub = (uint32_t)client->idx;
+    char header[PAYLOAD_HEADER_SIZE] = {0};
+    memcpy(header, &t_sent, 8);
+    memcpy(header + 8, &priv->run_id, 4);
+    memcpy(header + 12, &pub, 4);
+    memcpy(header + 16, &seq, 4);
+
+    gbuffer_t *gbuf = gbuffer_create((size_t)priv->payload_size, (size_t)priv->payload_size);
+    if(!gbuf) {
+        // Error already logged
+        return;
+    }
+    gbuffer_append(gbuf, header, PAYLOAD_HEADER_SIZE);
+    gbuffer_append(gbuf, priv->filler, (size_t)priv->payload_size - PAYLOAD_HEADER_SIZE);
+
+    uint32_t fanout = priv->fanout[t];
+    if(!perf_harness_rate(priv->harness) && fanout > 0) {
+        slot_t *slot = &client->slots[seq % priv->window];
+        slot->seq = seq;
+        slot->remaining = fanout;
+    }
+    priv->expected += fanout;
+    priv->published++;
+
+    json_t *kw_pub = json_pack("{s:s, s:i, s:i, s:b, s:I}",
+        "topic",            topic,
+        "qos",              qos,
+        "expiry_interval",  0,
+        "retain",           retain,
+        "gbuffer",          (json_int_t)(uintptr_t)gbuf
+    );
+    json_t *kw_iev = iev_create(gobj, EV_MQTT_PUBLISH, kw_pub);
+    gobj_send_event(client->iogate, EV_SEND_IEV, kw_iev, gobj);
+}
+
+/***************************************************************************
+ *  Closed loop: fill the window of the publisher
+ ***************************************************************************/
+PRIVATE void pump_publisher(hgobj gobj, client_t *client)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    while(priv->running && client->next_seq < priv->messages) {
+        slot_t *slot = &client->slots[client->next_seq % priv->window];
+        if(slot->remaining) {
+            break;
+        }
+        publish(gobj, client);
+    }
+}
+
+/***************************************************************************
+ *  Open loop: send the publishes that are due, round-robin over publishers
+ ***************************************************************************/
+PRIVATE void send_due_publishes(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    int burst = 0;
+    while(priv->running && priv->published < priv->total) {
+        uint64_t wait_ms = perf_harness_wait_ms(priv->harness);
+        if(wait_ms > 0) {
+            set_timeout0(priv->timer_send, (json_int_t)wait_ms);
+            return;
+        }
+        if(++burst > MAX_BURST) {
+            /* Let the deliveries in, we are late anyway */
+            set_timeout0(priv->timer_send, 1);
+            return;
+        }
+        client_t *client = &priv->clients[priv->next_publisher];
+        priv->next_publisher = (priv->next_publisher + 1) % priv->publishers;
+        publish(gobj, client);
+    }
+}
+
+/***************************************************************************
+ *  All clients ready: go
+ ***************************************************************************/
+PRIVATE void start_run(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    perf_harness_set_params(priv->harness, json_pack(
+        "{s:i, s:i, s:I, s:i, s:i, s:i, s:i, s:i, s:i, s:b, s:I, s:s}",
+        "publishers",           priv->publishers,
+        "subscribers",          priv->subscribers,
+        "messages",             (json_int_t)priv->messages,
+        "payload_size",         priv->payload_size,
+        "topics",               priv->topics,
+        "wildcard_ratio",       priv->wildcard_ratio,
+        "qos1_ratio",           priv->qos1_ratio,
+        "qos2_ratio",           priv->qos2_ratio,
+        "retain_ratio",         priv->retain_ratio,
+        "persistent_sessions",  priv->persistent_sessions,
+        "window",               (json_int_t)priv->window,
+        "mqtt_protocol",        gobj_read_str_attr(gobj, "mqtt_protocol")
+    ));
+
+    /*
+     *  Deliveries of previous runs (retained, persistent queues) are discarded
+     */
+    priv->run_id = (uint32_t)(perf_now_ns() ^ (uint64_t)getpid());
+    priv->running = TRUE;
+    priv->ticks = 0;
+    perf_harness_start(priv->harness);
+
+    if(perf_harness_rate(priv->harness)) {
+        send_due_publishes(gobj);
+    } else {
+        for(int i = 0; i < priv->publishers; i++) {
+            pump_publisher(gobj, &priv->clients[i]);
+        }
+    }
+    check_done(gobj);
+}
+
+/***************************************************************************
+ *  End of run: results, and stop the clients
+ ***************************************************************************/
+PRIVATE void finish_run(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->dying) {
+        return;
+    }
+    if(priv->running) {
+        priv->running = FALSE;
+        perf_harness_stop(priv->harness);
+        perf_harness_print(priv->harness);
+        printf("    Publishes  : %llu, deliveries %llu of %llu, stale %llu\n",
+            (unsigned long long)priv->published,
+            (unsigned long long)priv->delivered,
+            (unsigned long long)priv->expected,
+            (unsigned long long)priv->stale
+        );
+        fflush(stdout);
+        perf_harness_save(priv->harness);
+    }
+
+    clear_timeout0(priv->timer_send);
+    stop_clients(gobj);
+    priv->dying = TRUE;
+    /* Next tick (1 s away) fires set_yuno_must_die. */
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void check_done(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->running && priv->published == priv->total && priv->delivered >= priv->expected) {
+        finish_run(gobj);
+    }
+}
+
+
+
+
+            /***************************
+             *      Actions
+             ***************************/
+
+
+
+
+/***************************************************************************
+ *  Warm-up elapsed: launch the clients.
+ *  Open loop: next publishes are due.
+ ***************************************************************************/
+PRIVATE int ac_timeout(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(!priv->launched) {
+        launch_clients(gobj);
+    } else {
+        send_due_publishes(gobj);
+        check_done(gobj);
+    }
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  1 s tick: startup timeout, stall detection and exit
+ ***************************************************************************/
+PRIVATE int ac_timeout_periodic(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->dying) {
+        /*
+         *  Stop the broker side too, otherwise gobj_end finds
+         *  the channels running.
+         */
+        hgobj input_side = gobj_find_service("__input_side__", FALSE);
+        if(input_side) {
+            gobj_stop_tree(input_side);
+        }
+        JSON_DECREF(kw)
+        set_yuno_must_die();
+        return 0;
+    }
+
+    priv->ticks++;
+
+    if(!priv->running) {
+        if(priv->ticks > STARTUP_TIMEOUT_SECONDS) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_APP,
+                "msg",          "%s", "perf: clients not ready",
+                "clients",      "%d", priv->n_clients,
+                "ready",        "%d", priv->n_ready,
+                NULL
+            );
+            finish_run(gobj);
+        }
+        JSON_DECREF(kw)
+        return 0;
+    }
+
+    if(priv->published == priv->last_published && priv->delivered == priv->last_delivered) {
+        if(priv->ticks >= STALL_SECONDS) {
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_APP,
+                "msg",          "%s", "perf: deliveries stalled",
+                "published",    "%llu", (unsigned long long)priv->published,
+                "expected",     "%llu", (unsigned long long)priv->expected,
+                "delivered",    "%llu", (unsigned long long)priv->delivered,
+                NULL
+            );
+            finish_run(gobj);
+        }
+    } else {
+        priv->ticks = 0;
+        priv->last_published = priv->published;
+        priv->last_delivered = priv->delivered;
+    }
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  MQTT connected (CONNACK received)
+ ***************************************************************************/
+PRIVATE int ac_on_open(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    client_t *client = gobj_read_pointer_attr(src, "user_data");
+
+    if(!client || client->ready) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_APP,
+            "msg",          "%s", "perf: unexpected EV_ON_OPEN",
+            "src",          "%s", gobj_short_name(src),
+            NULL
+        );
+        JSON_DECREF(kw)
+        return 0;
+    }
+
+    if(client->publisher) {
+        client->ready = TRUE;
+        priv->n_ready++;
+    } else {
+        char filter[64];
+        subscription_filter(gobj, client->idx, filter, sizeof(filter));
+        json_t *kw_sub = json_pack("{s:[s], s:i, s:i}",
+            "subs",     filter,
+            "qos",      priv->max_qos,
+            "options",  0
+        );
+        json_t *kw_iev = iev_create(gobj, EV_MQTT_SUBSCRIBE, kw_sub);
+        gobj_send_event(src, EV_SEND_IEV, kw_iev, gobj);
+    }
+
+    if(priv->n_ready == priv->n_clients && !priv->running && !priv->dying) {
+        start_run(gobj);
+    }
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  SUBACK received
+ ***************************************************************************/
+PRIVATE int ac_suback(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    client_t *client = gobj_read_pointer_attr(src, "user_data");
+
+    if(client && !client->publisher && !client->ready) {
+        client->ready = TRUE;
+        priv->n_ready++;
+    }
+
+    if(priv->n_ready == priv->n_clients && !priv->running && !priv->dying) {
+        start_run(gobj);
+    }
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  PUBLISH sent (qos 0) or acknowledged (qos 1/2)
+ ***************************************************************************/
+PRIVATE int ac_publish_ack(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Delivery to a subscriber
+ ***************************************************************************/
+PRIVATE int ac_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gbuffer_t *gbuf = (gbuffer_t *)(uintptr_t)kw_get_int(gobj, kw, "gbuffer", 0, 0);
+    size_t len = gbuf? gbuffer_chunk(gbuf) : 0;
+    if(!priv->running || len < PAYLOAD_HEADER_SIZE) {
+        priv->stale++;
+        KW_DECREF(kw)
+        return 0;
+    }
+
+    const char *p = gbuffer_cur_rd_pointer(gbuf);
+    uint64_t t_sent;
+    uint32_t run_id, pub, seq;
+    memcpy(&t_sent, p, 8);
+    memcpy(&run_id, p + 8, 4);
+    memcpy(&pub, p + 12, 4);
+    memcpy(&seq, p + 16, 4);
+    KW_DECREF(kw)
+
+    if(run_id != priv->run_id || pub >= (uint32_t)priv->publishers) {
+        priv->stale++;
+        return 0;
+    }
+
+    priv->delivered++;
+    perf_harness_received(priv->harness, t_sent, len);
+
+    if(!perf_harness_rate(priv->harness)) {
+        client_t *client = &priv->clients[pub];
+        slot_t *slot = &client->slots[seq % priv->window];
+        if(slot->remaining && slot->seq == seq) {
+            slot->remaining--;
+            if(!slot->remaining) {
+                pump_publisher(gobj, client);
+            }
+        }
+    }
+
+    check_done(gobj);
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_on_close(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(!priv->dying) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_APP,
+            "msg",          "%s", "perf: MQTT client disconnected",
+            "src",          "%s", gobj_short_name(src),
+            NULL
+        );
+    }
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_stopped(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    JSON_DECREF(kw)
+    return 0;
+}
+
+
+
+
+            /***************************
+             *      FSM
+             ***************************/
+
+
+
+
+PRIVATE const GMETHODS gmt = {
+    .mt_create  = mt_create,
+    .mt_destroy = mt_destroy,
+    .mt_start   = mt_start,
+    .mt_stop    = mt_stop,
+    .mt_play    = mt_play,
+    .mt_pause   = mt_pause,
+};
+
+GOBJ_DEFINE_GCLASS(C_PERF_MQTT_BROKER);
+
+PRIVATE int create_gclass(gclass_name_t gclass_name)
+{
+    static hgclass __gclass__ = 0;
+    if(__gclass__) {
+        gobj_log_error(0, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "GClass ALREADY created",
+            "gclass",       "%s", gclass_name,
+            NULL
+        );
+        return -1;
+    }
+
+    ev_action_t st_idle[] = {
+        {EV_TIMEOUT,            ac_timeout,             0},
+        {EV_TIMEOUT_PERIODIC,   ac_timeout_periodic,    0},
+        {EV_ON_OPEN,            ac_on_open,             0},
+        {EV_MQTT_SUBSCRIBE,     ac_suback,              0},
+        {EV_MQTT_PUBLISH,       ac_publish_ack,         0},
+        {EV_MQTT_MESSAGE,       ac_message,             0},
+        {EV_ON_CLOSE,           ac_on_close,            0},
+        {EV_STOPPED,            ac_stopped,             0},
+        {0, 0, 0}
+    };
+
+    states_t states[] = {
+        {ST_IDLE, st_idle},
+        {0, 0}
+    };
+
+    event_type_t event_types[] = {
+        {EV_TIMEOUT,            0},
+        {EV_TIMEOUT_PERIODIC,   0},
+        {EV_ON_OPEN,            0},
+        {EV_MQTT_SUBSCRIBE,     0},
+        {EV_MQTT_PUBLISH,       0},
+        {EV_MQTT_MESSAGE,       0},
+        {EV_ON_CLOSE,           0},
+        {EV_STOPPED,            0},
+        {0, 0}
+    };
+
+    __gclass__ = gclass_create(
+        gclass_name,
+        event_types,
+        states,
+        &gmt,
+        0,              // lmt
+        attrs_table,
+        sizeof(PRIVATE_DATA),
+        0,              // authz_table
+        0,              // command_table
+        s_user_trace_level,
+        0               // gcflag_t
+    );
+    if(!__gclass__) {
+        return -1;
+    }
+    return 0;
+}
+
+PUBLIC int register_c_perf_mqtt_broker(void)
+{
+    return create_gclass(C_PERF_MQTT_BROKER);
+}
@@ -0,0 +1,25 @@
+/****************************************************************************
+ *          C_PERF_MQTT_BROKER.H
+ *
+ *          Load generator GClass for perf_mqtt_broker.  Drives N in-process
+ *          MQTT clients (C_PROT_MQTT2 in client mode) against the embedded
+ *          C_MQTT_BROKER and reports throughput and delivery latency.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#pragma once
+
+#include <yunetas.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+GOBJ_DECLARE_GCLASS(C_PERF_MQTT_BROKER);
+
+PUBLIC int register_c_perf_mqtt_broker(void);
+
+#ifdef __cplusplus
+}
+#endif
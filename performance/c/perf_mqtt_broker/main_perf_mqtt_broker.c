@@ -0,0 +1,272 @@
+/****************************************************************************
+ *          MAIN_PERF_MQTT_BROKER.C
+ *
+ *          Self-contained load benchmark for the MQTT broker.
+ *
+ *          - Embedded broker (C_AUTHZ + C_MQTT_BROKER) on port 18120,
+ *            the same service tree as yunos/c/mqtt_broker.
+ *          - C_PERF_MQTT_BROKER creates N in-process MQTT clients
+ *            (C_PROT_MQTT2 in client mode), publishers and subscribers,
+ *            pumps the messages through the broker and prints the
+ *            delivery throughput and latency percentiles.
+ *
+ *          The load is configured with the attributes of c_perf_mqtt_broker,
+ *          for example:
+ *
+ *              perf_mqtt_broker '{"global": {"c_perf_mqtt_broker.subscribers": 16}}'
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#include <yunetas.h>
+#include <c_mqtt_broker.h>
+#include <c_prot_mqtt2.h>
+#include "c_perf_mqtt_broker.h"
+
+/***************************************************************************
+ *                      Names
+ ***************************************************************************/
+#define APP_NAME        "perf_mqtt_broker"
+#define APP_DOC         "Load benchmark for the MQTT broker"
+
+#define APP_VERSION     "1.0.0"
+#define APP_SUPPORT     "<support@artgins.com>"
+#define APP_DATETIME    __DATE__ " " __TIME__
+
+#define USE_OWN_SYSTEM_MEMORY   FALSE
+#define MEM_MIN_BLOCK           0
+#define MEM_MAX_BLOCK           0
+#define MEM_SUPERBLOCK          0
+#define MEM_MAX_SYSTEM_MEMORY   0
+
+#define MQTT_PERF_PORT  "18120"
+#define MAX_CLIENTS     "128"   // broker channels, publishers + subscribers can't exceed it
+
+/***************************************************************************
+ *                      Default config
+ ***************************************************************************/
+PRIVATE char fixed_config[]= "\
+{                                                                   \n\
+    'yuno': {                                                       \n\
+        'yuno_role': '"APP_NAME"',                                  \n\
+        'tags': ['perf', 'yunetas']                                 \n\
+    }                                                               \n\
+}                                                                   \n\
+";
+
+PRIVATE char variable_config[]= "\
+{                                                                   \n\
+    'environment': {                                                \n\
+        'work_dir': '/tmp',                                         \n\
+        'console_log_handlers': {                                   \n\
+        },                                                          \n\
+        'daemon_log_handlers': {                                    \n\
+        }                                                           \n\
+    },                                                              \n\
+    'yuno': {                                                       \n\
+        'autoplay': true,                                           \n\
+        'required_services': [],                                    \n\
+        'public_services': [],                                      \n\
+        'service_descriptor': {                                     \n\
+        },                                                          \n\
+        'realm_owner': 'test',                                      \n\
+        'realm_id':    'test',                                      \n\
+        'trace_levels': {                                           \n\
+        }                                                           \n\
+    },                                                              \n\
+    'global': {                                                     \n\
+        'Authz.allow_anonymous_in_localhost': true,                 \n\
+        '__input_side__.__json_config_variables__': {               \n\
+            '__input_url__':  'mqtt://0.0.0.0:"MQTT_PERF_PORT"',   \n\
+            '__input_host__': '0.0.0.0',                           \n\
+            '__input_port__': '"MQTT_PERF_PORT"'                    \n\
+        }                                                           \n\
+    },                                                              \n\
+    'services': [                                                   \n\
+        {                                                           \n\
+            'name': 'authz',                                        \n\
+            'gclass': 'C_AUTHZ',                                    \n\
+            'priority': 0,                                          \n\
+            'default_service': false,                               \n\
+            'autostart': true,                                      \n\
+            'autoplay': true                                        \n\
+        },                                                          \n\
+        {                                                           \n\
+            'name': 'mqtt_broker',                                  \n\
+            'gclass': 'C_MQTT_BROKER',                              \n\
+            'default_service': false,                               \n\
+            'autostart': true,                                      \n\
+            'autoplay': true,                                       \n\
+            'kw': {                                                 \n\
+                'enable_new_clients': true                          \n\
+            }                                                       \n\
+        },                                                          \n\
+        {                                                           \n\
+            'name': 'c_perf_mqtt_broker',                           \n\
+            'gclass': 'C_PERF_MQTT_BROKER',                         \n\
+            'default_service': true,                                \n\
+            'autostart': true,                                      \n\
+            'autoplay': true,                                       \n\
+            'kw': {                                                 \n\
+                'url': 'tcp://127.0.0.1:"MQTT_PERF_PORT"',          \n\
+                'max_clients': "MAX_CLIENTS"                        \n\
+            }                                                       \n\
+        },                                                          \n\
+        {                                                           \n\
+            'name': '__input_side__',                               \n\
+            'gclass': 'C_IOGATE',                                   \n\
+            'autostart': true,                                      \n\
+            'autoplay': false,                                      \n\
+            'kw': {                                                 \n\
+            },                                                      \n\
+            'children': [                                           \n\
+                {                                                   \n\
+                    'name': 'server_port',                          \n\
+                    'gclass': 'C_TCP_S',                            \n\
+                    'kw': {                                         \n\
+                        'url': '(^^__input_url__^^)',               \n\
+                        'backlog': 256,                             \n\
+                        'use_dups': 0                               \n\
+                    }                                               \n\
+                }                                                   \n\
+            ],                                                      \n\
+            '[^^children^^]': {                                     \n\
+                '__range__': [1, "MAX_CLIENTS"],                    \n\
+                '__vars__': {                                       \n\
+                },                                                  \n\
+                '__content__': {                                    \n\
+                    'name': '(^^__input_port__^^)-(^^__range__^^)', \n\
+                    'gclass': 'C_CHANNEL',                          \n\
+                    'children': [                                   \n\
+                        {                                           \n\
+                            'name': '(^^__input_port__^^)-(^^__range__^^)', \n\
+                            'gclass': 'C_PROT_MQTT2',               \n\
+                            'kw': {                                 \n\
+                                'iamServer': true                   \n\
+                            },                                      \n\
+                            'children': [                           \n\
+                                {                                   \n\
+                                    'gclass': 'C_TCP'               \n\
+                                }                                   \n\
+                            ]                                       \n\
+                        }                                           \n\
+                    ]                                               \n\
+                }                                                   \n\
+            }                                                       \n\
+        },                                                          \n\
+        {                                                           \n\
+            'name': '__top_side__',                                 \n\
+            'gclass': 'C_IOGATE',                                   \n\
+            'autostart': false,                                     \n\
+            'autoplay': false,                                      \n\
+            'kw': {                                                 \n\
+            }                                                       \n\
+        }                                                           \n\
+    ]                                                               \n\
+}                                                                   \n\
+";
+
+/***************************************************************************
+ *  Authz checker: allow everything in the self-contained benchmark
+ ***************************************************************************/
+PRIVATE BOOL test_authz_checker(hgobj gobj, const char *authz, json_t *kw, hgobj src)
+{
+    KW_DECREF(kw)
+    return TRUE;
+}
+
+int result = 0;
+
+/***************************************************************************
+ *  HACK: runs on yunetas environment BEFORE creating the yuno
+ ***************************************************************************/
+static int register_yuno_and_more(void)
+{
+    int res = 0;
+
+    res += register_c_mqtt_broker();
+    res += register_c_prot_mqtt2();
+    res += register_c_perf_mqtt_broker();
+
+    gobj_set_gclass_no_trace(gclass_find_by_name(C_TIMER0), "machine", TRUE);
+    gobj_set_gclass_no_trace(gclass_find_by_name(C_TIMER),  "machine", TRUE);
+    gobj_set_global_no_trace("timer_periodic", TRUE);
+
+    /*
+     *  Watchdog: the orchestrator self-terminates when every message
+     *  is delivered, or when the deliveries stall;
+     *  this is just a safety net in case something wedges.
+     */
+    set_auto_kill_time(300);
+
+    set_expected_results(
+        APP_NAME,
+        json_array(),
+        NULL,
+        NULL,
+        TRUE
+    );
+
+    return res;
+}
+
+/***************************************************************************
+ *  HACK: runs on yunetas environment BEFORE destroying the yuno
+ ***************************************************************************/
+static void cleaning(void)
+{
+    result += test_json(NULL);
+}
+
+/***************************************************************************
+ *                      Main
+ ***************************************************************************/
+int main(int argc, char *argv[])
+{
+    glog_init();
+
+    gobj_log_add_handler("stdout", "stdout", LOG_OPT_UP_WARNING, 0);
+
+    gobj_log_register_handler(
+        "testing",
+        0,
+        capture_log_write,
+        0
+    );
+    gobj_log_add_handler("test_capture", "testing", LOG_OPT_UP_ERROR, 0);
+
+    unsigned long memory_check_list[] = {0, 0};
+    set_memory_check_list(memory_check_list);
+
+    helper_quote2doublequote(fixed_config);
+    helper_quote2doublequote(variable_config);
+    yuneta_setup(
+        NULL,
+        NULL,
+        NULL,
+        test_authz_checker,
+        NULL,
+        MEM_MAX_BLOCK,
+        MEM_MAX_SYSTEM_MEMORY,
+        USE_OWN_SYSTEM_MEMORY,
+        MEM_MIN_BLOCK,
+        MEM_SUPERBLOCK
+    );
+
+    result += yuneta_entry_point(
+        argc, argv,
+        APP_NAME, APP_VERSION, APP_SUPPORT, APP_DOC, APP_DATETIME,
+        fixed_config,
+        variable_config,
+        register_yuno_and_more,
+        cleaning
+    );
+
+    if(get_cur_system_memory() != 0) {
+        printf("%sERROR --> %s%s\n", On_Red BWhite, "system memory not free", Color_Off);
+        print_track_mem();
+        result += -1;
+    }
+
+    return result;
+}
@@ -0,0 +1,703 @@
+/****************************************************************************
+ *          perf_tranger2
+ *
+ *  Timeranger2 benchmark suite.
+ *
+ *      - append:       tranger2_append_record() by key cardinality and record size
+ *      - open_topic:   close and reopen the topic (key cache load)
+ *      - scan:         tranger2_open_iterator() with a callback, all the records of a key
+ *      - pages:        tranger2_iterator_get_page() over all the records of a key
+ *      - open_list:    tranger2_open_list() of all the keys of the topic
+ *      - rt_mem:       append -> rt_mem callback latency (master)
+ *      - rt_disk:      append -> rt_disk callback latency (in-process follower)
+ *
+ *  Every case reports ops/sec, bytes/sec and the latency percentiles of one op,
+ *  the results are written to $PERF_RESULTS_DIR/perf_tranger2.json.
+ *
+ *  Environment variables:
+ *      PERF_RECORDS    records appended by each append case (default 100000)
+ *      PERF_RT_RECORDS records of the rt_mem/rt_disk cases (default 2000)
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#include <string.h>
+#include <signal.h>
+#include <stdio.h>
+#include <limits.h>
+
+#include <gobj.h>
+#include <kwid.h>
+#include <timeranger2.h>
+#include <testing.h>
+#include <helpers.h>
+#include <yev_loop.h>
+#include <perf_harness.h>
+
+/***************************************************************
+ *              Constants
+ ***************************************************************/
+#define APP         "perf_tranger2"
+#define DATABASE    "perf_tranger2"
+#define RT_TOPIC    "perf_rt"
+#define BASE_T      946684800   // 2000-01-01T00:00:00+0000
+#define PAGE_SIZE   100
+
+PRIVATE const int key_cardinalities[] = {1, 100, 1000};
+PRIVATE const int record_sizes[] = {64, 1024};
+
+/***************************************************************
+ *              Prototypes
+ ***************************************************************/
+PRIVATE void yuno_catch_signals(void);
+
+/***************************************************************
+ *              Data
+ ***************************************************************/
+PRIVATE yev_loop_h yev_loop;
+PRIVATE json_t *jn_cases;           // results
+
+PRIVATE uint64_t loaded = 0;        // records given to load_callback
+PRIVATE uint64_t rt_t_append = 0;   // time of the last append, rt cases
+PRIVATE uint64_t rt_received = 0;
+PRIVATE perf_histogram_t *rt_hist = 0;
+
+
+
+
+                    /***************************
+                     *      Helpers
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Add a case to the results and print it
+ ***************************************************************************/
+PRIVATE void add_case(
+    const char *name,
+    json_t *jn_params,      // owned
+    uint64_t ops,
+    uint64_t bytes,
+    uint64_t duration_ns,
+    perf_histogram_t *hist  // latency of one op, optional
+)
+{
+    double seconds = duration_ns? (double)duration_ns / 1e9 : 1e-9;
+
+    json_t *jn_case = json_pack("{s:s, s:o, s:I, s:I, s:I, s:I}",
+        "name",             name,
+        "params",           jn_params,
+        "ops",              (json_int_t)ops,
+        "duration_us",      (json_int_t)(duration_ns / 1000),
+        "ops_per_sec",      (json_int_t)((double)ops / seconds),
+        "bytes_per_sec",    (json_int_t)((double)bytes / seconds)
+    );
+    if(hist) {
+        json_object_set_new(jn_case, "latency_ns", perf_histogram_json(hist));
+    }
+
+    char params[120];
+    json_t *jn_p = json_object_get(jn_case, "params");
+    const char *k; json_t *v;
+    int ln = 0;
+    params[0] = 0;
+    json_object_foreach(jn_p, k, v) {
+        ln += snprintf(params + ln, sizeof(params) - (size_t)ln, "%s%s=%lld",
+            ln? " " : "", k, (long long)json_integer_value(v));
+        if(ln >= (int)sizeof(params)) {
+            break;
+        }
+    }
+
+    printf("%-12s %-20s %12.0f ops/sec %10.1f MB/sec",
+        name,
+        params,
+        (double)ops / seconds,
+        (double)bytes / seconds / (1024.0*1024.0)
+    );
+    if(hist) {
+        printf("   p50 %.1f us, p99 %.1f us, max %.1f us",
+            (double)perf_histogram_percentile(hist, 50.0) / 1000.0,
+            (double)perf_histogram_percentile(hist, 99.0) / 1000.0,
+            (double)perf_histogram_max(hist) / 1000.0
+        );
+    }
+    printf("\n");
+    fflush(stdout);
+
+    json_array_append_new(jn_cases, jn_case);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE json_t *create_topic(json_t *tranger, const char *topic_name)
+{
+    return tranger2_create_topic(
+        tranger,
+        topic_name,
+        "id",
+        "tm",
+        json_pack("{s:i, s:s, s:i, s:i}",
+            "on_critical_error", 4,
+            "filename_mask", "%Y-%m-%d",
+            "xpermission" , 02700,
+            "rpermission", 0600
+        ),
+        sf_int_key,
+        json_pack("{s:s, s:I, s:s}",
+            "id", "",
+            "tm", (json_int_t)0,
+            "content", ""
+        ),
+        0
+    );
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE json_t *startup_tranger(const char *path_root, BOOL master)
+{
+    json_t *jn_tranger = json_pack("{s:s, s:s, s:b, s:i}",
+        "path", path_root,
+        "database", DATABASE,
+        "master", master?1:0,
+        "on_critical_error", LOG_OPT_TRACE_STACK
+    );
+    return tranger2_startup(0, jn_tranger, yev_loop);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int load_callback(
+    json_t *tranger,
+    json_t *topic,
+    const char *key,
+    json_t *list,
+    json_int_t rowid,
+    md2_record_ex_t *md_record,
+    json_t *record      // must be owned
+)
+{
+    loaded++;
+    JSON_DECREF(record)
+    return 0;
+}
+
+PRIVATE int rt_callback(
+    json_t *tranger,
+    json_t *topic,
+    const char *key,
+    json_t *list,
+    json_int_t rowid,
+    md2_record_ex_t *md_record,
+    json_t *record      // must be owned
+)
+{
+    uint64_t now = perf_now_ns();
+    rt_received++;
+    if(rt_hist) {
+        perf_histogram_record(rt_hist, now > rt_t_append? now - rt_t_append : 0);
+    }
+    JSON_DECREF(record)
+    return 0;
+}
+
+
+
+
+                    /***************************
+                     *      Cases
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Append `records` records of ~`record_size` bytes over `cardinality` keys
+ ***************************************************************************/
+PRIVATE int bench_append(
+    json_t *tranger,
+    const char *topic_name,
+    int cardinality,
+    int record_size,
+    uint64_t records
+)
+{
+    if(!create_topic(tranger, topic_name)) {
+        return -1;
+    }
+
+    /*
+     *  ~48 bytes of id, tm and json syntax
+     */
+    size_t content_size = record_size > 48? (size_t)record_size - 48 : 1;
+    char *content = GBMEM_MALLOC(content_size + 1);
+    if(!content) {
+        return -1;
+    }
+    memset(content, 'x', content_size);
+
+    perf_histogram_t *hist = perf_histogram_create();
+    int ret = 0;
+
+    uint64_t t0 = perf_now_ns();
+    for(uint64_t i=0; i<records; i++) {
+        json_int_t id = (json_int_t)(i % (uint64_t)cardinality) + 1;
+        uint64_t t = BASE_T + i;
+        json_t *jn_record = json_pack("{s:I, s:I, s:s}",
+            "id", id,
+            "tm", (json_int_t)t,
+            "content", content
+        );
+        md2_record_ex_t md_record = {0};
+
+        uint64_t t1 = perf_now_ns();
+        if(tranger2_append_record(tranger, topic_name, t, 0, &md_record, jn_record)<0) {
+            ret = -1;
+            break;
+        }
+        perf_histogram_record(hist, perf_now_ns() - t1);
+    }
+    uint64_t duration = perf_now_ns() - t0;
+
+    add_case(
+        "append",
+        json_pack("{s:i, s:i}", "keys", cardinality, "size", record_size),
+        records,
+        records * (uint64_t)record_size,
+        duration,
+        hist
+    );
+
+    perf_histogram_destroy(hist);
+    GBMEM_FREE(content);
+    return ret;
+}
+
+/***************************************************************************
+ *  Close and reopen a topic: desc, cols, var and the cache of keys
+ ***************************************************************************/
+PRIVATE int bench_open_topic(json_t *tranger, const char *topic_name, int cardinality)
+{
+    tranger2_close_topic(tranger, topic_name);
+
+    uint64_t t0 = perf_now_ns();
+    json_t *topic = tranger2_open_topic(tranger, topic_name, TRUE);
+    uint64_t duration = perf_now_ns() - t0;
+
+    add_case(
+        "open_topic",
+        json_pack("{s:i}", "keys", cardinality),
+        1,
+        0,
+        duration,
+        NULL
+    );
+    return topic? 0 : -1;
+}
+
+/***************************************************************************
+ *  Iterator over the first key: full scan with callback, then pages
+ ***************************************************************************/
+PRIVATE int bench_iterator(json_t *tranger, const char *topic_name, int cardinality, int record_size)
+{
+    const char *key = "0000000000000000001";
+
+    /*
+     *  Scan: the iterator loads every record of the key calling the callback
+     */
+    loaded = 0;
+    uint64_t t0 = perf_now_ns();
+    json_t *iterator = tranger2_open_iterator(
+        tranger,
+        topic_name,
+        key,
+        NULL,           // match_cond
+        load_callback,  // load_record_callback
+        "perf_scan",    // iterator_id
+        NULL,           // creator
+        NULL,           // data
+        NULL            // extra
+    );
+    uint64_t duration = perf_now_ns() - t0;
+    if(!iterator) {
+        return -1;
+    }
+    add_case(
+        "scan",
+        json_pack("{s:i, s:i}", "keys", cardinality, "size", record_size),
+        loaded,
+        loaded * (uint64_t)record_size,
+        duration,
+        NULL
+    );
+    tranger2_close_iterator(tranger, iterator);
+
+    /*
+     *  Pages of PAGE_SIZE records
+     */
+    iterator = tranger2_open_iterator(
+        tranger,
+        topic_name,
+        key,
+        NULL,           // match_cond
+        NULL,           // load_record_callback
+        "perf_pages",   // iterator_id
+        NULL,           // creator
+        NULL,           // data
+        NULL            // extra
+    );
+    if(!iterator) {
+        return -1;
+    }
+
+    perf_histogram_t *hist = perf_histogram_create();
+    size_t total = tranger2_iterator_size(iterator);
+    uint64_t records = 0;
+
+    t0 = perf_now_ns();
+    for(json_int_t from_rowid = 1; from_rowid <= (json_int_t)total; from_rowid += PAGE_SIZE) {
+        uint64_t t1 = perf_now_ns();
+        json_t *page = tranger2_iterator_get_page(tranger, iterator, from_rowid, PAGE_SIZE, FALSE);
+        perf_histogram_record(hist, perf_now_ns() - t1);
+        records += json_array_size(json_object_get(page, "data"));
+        JSON_DECREF(page)
+    }
+    duration = perf_now_ns() - t0;
+
+    add_case(
+        "pages",
+        json_pack("{s:i, s:i, s:i}", "keys", cardinality, "size", record_size, "page", PAGE_SIZE),
+        records,
+        records * (uint64_t)record_size,
+        duration,
+        hist    // latency of one page
+    );
+
+    perf_histogram_destroy(hist);
+    tranger2_close_iterator(tranger, iterator);
+    return 0;
+}
+
+/***************************************************************************
+ *  tranger2_open_list() of all the keys
+ ***************************************************************************/
+PRIVATE int bench_open_list(json_t *tranger, const char *topic_name, int cardinality, int record_size)
+{
+    loaded = 0;
+    json_t *match_cond = json_pack("{s:s, s:I}",
+        "rkey", "",
+        "load_record_callback", (json_int_t)(uintptr_t)load_callback
+    );
+
+    uint64_t t0 = perf_now_ns();
+    json_t *list = tranger2_open_list(
+        tranger,
+        topic_name,
+        match_cond, // owned
+        NULL,       // extra
+        NULL,       // rt_id
+        FALSE,      // rt_by_disk
+        NULL        // creator
+    );
+    uint64_t duration = perf_now_ns() - t0;
+    if(!list) {
+        return -1;
+    }
+
+    add_case(
+        "open_list",
+        json_pack("{s:i, s:i}", "keys", cardinality, "size", record_size),
+        loaded,
+        loaded * (uint64_t)record_size,
+        duration,
+        NULL
+    );
+
+    tranger2_close_list(tranger, list);
+    return 0;
+}
+
+/***************************************************************************
+ *  Latency from tranger2_append_record() to the realtime callback
+ *      rt_mem: on the master, the callback runs inside the append
+ *      rt_disk: on a follower, woken by the inotify of the master's append
+ ***************************************************************************/
+PRIVATE int bench_rt(json_t *tranger, json_t *follower, uint64_t records)
+{
+    int ret = 0;
+    perf_histogram_t *hist = perf_histogram_create();
+    json_t *rt = 0;
+
+    if(follower) {
+        if(!tranger2_open_topic(follower, RT_TOPIC, TRUE)) {
+            perf_histogram_destroy(hist);
+            return -1;
+        }
+        rt = tranger2_open_rt_disk(follower, RT_TOPIC, "", NULL, rt_callback, "perf_rt", "", NULL);
+        for(int i = 0; i < 10; i++) {
+            yev_loop_run_once(yev_loop);
+        }
+    } else {
+        rt = tranger2_open_rt_mem(tranger, RT_TOPIC, "", NULL, rt_callback, "perf_rt", "", NULL);
+    }
+    if(!rt) {
+        perf_histogram_destroy(hist);
+        return -1;
+    }
+
+    rt_hist = hist;
+    rt_received = 0;
+    uint64_t lost = 0;
+    static uint64_t t = BASE_T;
+
+    uint64_t t0 = perf_now_ns();
+    for(uint64_t i=0; i<records; i++) {
+        json_t *jn_record = json_pack("{s:I, s:I, s:s}",
+            "id", (json_int_t)1,
+            "tm", (json_int_t)t,
+            "content", "perf"
+        );
+        md2_record_ex_t md_record = {0};
+        uint64_t expected = rt_received + 1;
+
+        rt_t_append = perf_now_ns();
+        if(tranger2_append_record(tranger, RT_TOPIC, t++, 0, &md_record, jn_record)<0) {
+            ret = -1;
+            break;
+        }
+        for(int j = 0; j < 100 && rt_received < expected; j++) {
+            yev_loop_run_once(yev_loop);
+        }
+        if(rt_received < expected) {
+            lost++;
+        }
+    }
+    uint64_t duration = perf_now_ns() - t0;
+    rt_hist = 0;
+
+    add_case(
+        follower? "rt_disk" : "rt_mem",
+        json_pack("{s:I}", "lost", (json_int_t)lost),
+        rt_received,
+        0,
+        duration,
+        hist
+    );
+
+    if(follower) {
+        tranger2_close_rt_disk(follower, rt);
+    } else {
+        tranger2_close_rt_mem(tranger, rt);
+    }
+    perf_histogram_destroy(hist);
+    return ret;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int do_test(void)
+{
+    int result = 0;
+    uint64_t records = perf_env_uint64("PERF_RECORDS", 100000);
+    uint64_t rt_records = perf_env_uint64("PERF_RT_RECORDS", 2000);
+
+    /*
+     *  Write the database in ~/tests_yuneta/
+     */
+    const char *home = getenv("HOME");
+    char path_root[PATH_MAX];
+    char path_database[PATH_MAX];
+
+    build_path(path_root, sizeof(path_root), home, "tests_yuneta", NULL);
+    mkrdir(path_root, 02770);
+
+    build_path(path_database, sizeof(path_database), path_root, DATABASE, NULL);
+    rmrdir(path_database);
+
+    json_t *tranger = startup_tranger(path_root, TRUE);
+    if(!tranger) {
+        return -1;
+    }
+
+    jn_cases = json_array();
+
+    for(size_t k = 0; k < ARRAY_SIZE(key_cardinalities); k++) {
+        for(size_t s = 0; s < ARRAY_SIZE(record_sizes); s++) {
+            char topic_name[64];
+            snprintf(topic_name, sizeof(topic_name), "append_k%d_s%d",
+                key_cardinalities[k], record_sizes[s]);
+
+            result += bench_append(tranger, topic_name, key_cardinalities[k], record_sizes[s], records);
+            result += bench_open_topic(tranger, topic_name, key_cardinalities[k]);
+            result += bench_iterator(tranger, topic_name, key_cardinalities[k], record_sizes[s]);
+            result += bench_open_list(tranger, topic_name, key_cardinalities[k], record_sizes[s]);
+        }
+    }
+
+    if(!create_topic(tranger, RT_TOPIC)) {
+        result += -1;
+    } else {
+        result += bench_rt(tranger, NULL, rt_records);
+
+        json_t *follower = startup_tranger(path_root, FALSE);
+        if(!follower) {
+            result += -1;
+        } else {
+            result += bench_rt(tranger, follower, rt_records);
+            tranger2_shutdown(follower);
+        }
+    }
+
+    tranger2_shutdown(tranger);
+
+    /*
+     *  The watcher stops queued by the shutdowns complete asynchronously
+     */
+    for(int i = 0; i < 10; i++) {
+        yev_loop_run_once(yev_loop);
+    }
+
+    perf_save_json(APP, json_pack("{s:s, s:I, s:I, s:o}",
+        "name", APP,
+        "records", (json_int_t)records,
+        "rt_records", (json_int_t)rt_records,
+        "cases", jn_cases
+    ));
+    jn_cases = 0;
+
+    rmrdir(path_database);
+    return result;
+}
+
+/***************************************************************************
+ *              Main
+ ***************************************************************************/
+int main(int argc, char *argv[])
+{
+    /*----------------------------------*
+     *      Startup gobj system
+     *----------------------------------*/
+    sys_malloc_fn_t malloc_func;
+    sys_realloc_fn_t realloc_func;
+    sys_calloc_fn_t calloc_func;
+    sys_free_fn_t free_func;
+
+    gbmem_get_allocators(
+        &malloc_func,
+        &realloc_func,
+        &calloc_func,
+        &free_func
+    );
+
+    json_set_alloc_funcs(
+        malloc_func,
+        free_func
+    );
+
+    unsigned long memory_check_list[] = {0, 0};
+    set_memory_check_list(memory_check_list);
+
+    init_backtrace_with_backtrace(argv[0]);
+    set_show_backtrace_fn(show_backtrace_with_backtrace);
+
+    gobj_start_up(
+        argc,
+        argv,
+        NULL, NULL, NULL, NULL, NULL, NULL
+    );
+
+    yuno_catch_signals();
+
+    /*--------------------------------*
+     *      Log handlers
+     *--------------------------------*/
+    gobj_log_add_handler("stdout", "stdout", LOG_OPT_UP_WARNING, 0);
+
+    gobj_log_register_handler(
+        "testing",
+        0,
+        capture_log_write,
+        0
+    );
+    gobj_log_add_handler("test_capture", "testing", LOG_OPT_UP_ERROR, 0);
+
+    /*--------------------------------*
+     *  Create the event loop
+     *--------------------------------*/
+    yev_loop_create(
+        0,
+        2024,
+        10,
+        NULL,
+        &yev_loop
+    );
+
+    /*--------------------------------*
+     *      Test
+     *--------------------------------*/
+    set_expected_results( // Check that no errors happen
+        APP,
+        json_array(),
+        NULL,
+        NULL,
+        TRUE
+    );
+
+    int result = do_test();
+    result += test_json(NULL);
+
+    /*--------------------------------*
+     *  Stop the event loop
+     *--------------------------------*/
+    yev_loop_stop(yev_loop);
+    yev_loop_destroy(yev_loop);
+
+    gobj_end();
+
+    if(get_cur_system_memory()!=0) {
+        printf("%sERROR%s <-- %s\n", On_Red BWhite, Color_Off, "system memory not free");
+        print_track_mem();
+        result += -1;
+    }
+
+    if(result<0) {
+        printf("<-- %sTEST FAILED%s: %s\n", On_Red BWhite, Color_Off, APP);
+    }
+    return result<0?-1:0;
+}
+
+/***************************************************************************
+ *      Signal handlers
+ ***************************************************************************/
+PRIVATE void quit_sighandler(int sig)
+{
+    static int xtimes_once = 0;
+    xtimes_once++;
+    yev_loop_reset_running(yev_loop);
+    if(xtimes_once > 1) {
+        exit(-1);
+    }
+}
+
+PRIVATE void yuno_catch_signals(void)
+{
+    struct sigaction sigIntHandler;
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGTERM, SIG_IGN);
+
+    memset(&sigIntHandler, 0, sizeof(sigIntHandler));
+    sigIntHandler.sa_handler = quit_sighandler;
+    sigemptyset(&sigIntHandler.sa_mask);
+    sigIntHandler.sa_flags = SA_NODEFER|SA_RESTART;
+    sigaction(SIGALRM, &sigIntHandler, NULL);
+    sigaction(SIGQUIT, &sigIntHandler, NULL);
+    sigaction(SIGINT, &sigIntHandler, NULL);
+}
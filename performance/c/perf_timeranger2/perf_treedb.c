@@ -0,0 +1,541 @@
+/****************************************************************************
+ *          perf_treedb
+ *
+ *  Treedb benchmark suite, over a users/departments schema.
+ *
+ *      - create:       treedb_create_node() of departments and users
+ *      - update:       treedb_update_node() with save
+ *      - link:         treedb_link_nodes() user -> department
+ *      - list:         treedb_list_nodes() of all the users
+ *      - get:          treedb_get_node() by primary key
+ *      - open_db:      treedb_close_db() and treedb_open_db(), loading all the nodes
+ *
+ *  Every case reports ops/sec and the latency percentiles of one op,
+ *  the results are written to $PERF_RESULTS_DIR/perf_treedb.json.
+ *
+ *  Environment variables:
+ *      PERF_NODES      users created (default 10000)
+ *      PERF_LISTS      repetitions of the list case (default 20)
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#include <string.h>
+#include <signal.h>
+#include <stdio.h>
+#include <limits.h>
+
+#include <gobj.h>
+#include <kwid.h>
+#include <timeranger2.h>
+#include <tr_treedb.h>
+#include <testing.h>
+#include <helpers.h>
+#include <yev_loop.h>
+#include <perf_harness.h>
+
+/***************************************************************
+ *              Constants
+ ***************************************************************/
+#define APP         "perf_treedb"
+#define DATABASE    "perf_treedb"
+#define TREEDB_NAME "perf_treedb"
+#define DEPARTMENTS 100
+
+PRIVATE char schema[]= "\
+{                                                                   \n\
+    'topics': [                                                     \n\
+        {                                                           \n\
+            'topic_name': 'users',                                  \n\
+            'pkey': 'id',                                           \n\
+            'system_flag': 'sf_string_key',                         \n\
+            'cols': {                                               \n\
+                'id': {                                             \n\
+                    'header': 'Id',                                 \n\
+                    'type': 'string',                               \n\
+                    'flag': ['persistent','required']               \n\
+                },                                                  \n\
+                'username': {                                       \n\
+                    'header': 'User Name',                          \n\
+                    'type': 'string',                               \n\
+                    'flag': ['persistent','required']               \n\
+                },                                                  \n\
+                'email': {                                          \n\
+                    'header': 'Email',                              \n\
+                    'type': 'string',                               \n\
+                    'flag': ['persistent']                          \n\
+                },                                                  \n\
+                'departments': {                                    \n\
+                    'header': 'Department',                         \n\
+                    'type': 'array',                                \n\
+                    'flag': ['fkey']                                \n\
+                }                                                   \n\
+            }                                                       \n\
+        },                                                          \n\
+        {                                                           \n\
+            'topic_name': 'departments',                            \n\
+            'pkey': 'id',                                           \n\
+            'system_flag': 'sf_string_key',                         \n\
+            'cols': {                                               \n\
+                'id': {                                             \n\
+                    'header': 'Id',                                 \n\
+                    'type': 'string',                               \n\
+                    'flag': ['persistent','required']               \n\
+                },                                                  \n\
+                'name': {                                           \n\
+                    'header': 'Name',                               \n\
+                    'type': 'string',                               \n\
+                    'flag': ['persistent','required']               \n\
+                },                                                  \n\
+                'users': {                                          \n\
+                    'header': 'Users',                              \n\
+                    'type': 'array',                                \n\
+                    'flag': ['hook', 'fkey'],                       \n\
+                    'hook': {                                       \n\
+                        'users': 'departments'                      \n\
+                    }                                               \n\
+                }                                                   \n\
+            }                                                       \n\
+        }                                                           \n\
+    ]                                                               \n\
+}                                                                   \n\
+";
+
+/***************************************************************
+ *              Prototypes
+ ***************************************************************/
+PRIVATE void yuno_catch_signals(void);
+
+/***************************************************************
+ *              Data
+ ***************************************************************/
+PRIVATE yev_loop_h yev_loop;
+PRIVATE json_t *jn_cases;   // results
+
+
+
+
+                    /***************************
+                     *      Helpers
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Add a case to the results and print it
+ ***************************************************************************/
+PRIVATE void add_case(
+    const char *name,
+    uint64_t ops,
+    uint64_t duration_ns,
+    perf_histogram_t *hist  // latency of one op, optional
+)
+{
+    double seconds = duration_ns? (double)duration_ns / 1e9 : 1e-9;
+
+    json_t *jn_case = json_pack("{s:s, s:I, s:I, s:I}",
+        "name",             name,
+        "ops",              (json_int_t)ops,
+        "duration_us",      (json_int_t)(duration_ns / 1000),
+        "ops_per_sec",      (json_int_t)((double)ops / seconds)
+    );
+    if(hist) {
+        json_object_set_new(jn_case, "latency_ns", perf_histogram_json(hist));
+    }
+
+    printf("%-12s %10llu ops %12.0f ops/sec",
+        name,
+        (unsigned long long)ops,
+        (double)ops / seconds
+    );
+    if(hist) {
+        printf("   p50 %.1f us, p99 %.1f us, max %.1f us",
+            (double)perf_histogram_percentile(hist, 50.0) / 1000.0,
+            (double)perf_histogram_percentile(hist, 99.0) / 1000.0,
+            (double)perf_histogram_max(hist) / 1000.0
+        );
+    }
+    printf("\n");
+    fflush(stdout);
+
+    json_array_append_new(jn_cases, jn_case);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int open_db(json_t *tranger)
+{
+    json_t *jn_schema = legalstring2json(schema, TRUE);
+    if(!jn_schema) {
+        printf("Can't decode schema json\n");
+        return -1;
+    }
+    return treedb_open_db(tranger, TREEDB_NAME, jn_schema, 0)? 0 : -1;
+}
+
+
+
+
+                    /***************************
+                     *      Cases
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int bench_create(json_t *tranger, uint64_t nodes)
+{
+    int ret = 0;
+    perf_histogram_t *hist = perf_histogram_create();
+    char id[64];
+
+    uint64_t t0 = perf_now_ns();
+    for(int i=0; i<DEPARTMENTS; i++) {
+        snprintf(id, sizeof(id), "department-%d", i);
+        uint64_t t1 = perf_now_ns();
+        json_t *node = treedb_create_node(
+            tranger, TREEDB_NAME, "departments",
+            json_pack("{s:s, s:s}", "id", id, "name", id)
+        );
+        perf_histogram_record(hist, perf_now_ns() - t1);
+        if(!node) {
+            ret = -1;
+        }
+    }
+    for(uint64_t i=0; i<nodes; i++) {
+        snprintf(id, sizeof(id), "user-%llu", (unsigned long long)i);
+        uint64_t t1 = perf_now_ns();
+        json_t *node = treedb_create_node(
+            tranger, TREEDB_NAME, "users",
+            json_pack("{s:s, s:s, s:s}", "id", id, "username", id, "email", "")
+        );
+        perf_histogram_record(hist, perf_now_ns() - t1);
+        if(!node) {
+            ret = -1;
+        }
+    }
+    uint64_t duration = perf_now_ns() - t0;
+
+    add_case("create", nodes + DEPARTMENTS, duration, hist);
+    perf_histogram_destroy(hist);
+    return ret;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int bench_update(json_t *tranger, uint64_t nodes)
+{
+    int ret = 0;
+    perf_histogram_t *hist = perf_histogram_create();
+    char id[64];
+    char email[80];
+
+    uint64_t t0 = perf_now_ns();
+    for(uint64_t i=0; i<nodes; i++) {
+        snprintf(id, sizeof(id), "user-%llu", (unsigned long long)i);
+        snprintf(email, sizeof(email), "%s@example.com", id);
+        uint64_t t1 = perf_now_ns();
+        json_t *node = treedb_get_node(tranger, TREEDB_NAME, "users", id);
+        if(!node || !treedb_update_node(tranger, node, json_pack("{s:s}", "email", email), TRUE)) {
+            ret = -1;
+        }
+        perf_histogram_record(hist, perf_now_ns() - t1);
+    }
+    uint64_t duration = perf_now_ns() - t0;
+
+    add_case("update", nodes, duration, hist);
+    perf_histogram_destroy(hist);
+    return ret;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int bench_link(json_t *tranger, uint64_t nodes)
+{
+    int ret = 0;
+    perf_histogram_t *hist = perf_histogram_create();
+    char id[64];
+    char department_id[64];
+
+    uint64_t t0 = perf_now_ns();
+    for(uint64_t i=0; i<nodes; i++) {
+        snprintf(id, sizeof(id), "user-%llu", (unsigned long long)i);
+        snprintf(department_id, sizeof(department_id), "department-%d", (int)(i % DEPARTMENTS));
+        uint64_t t1 = perf_now_ns();
+        json_t *user = treedb_get_node(tranger, TREEDB_NAME, "users", id);
+        json_t *department = treedb_get_node(tranger, TREEDB_NAME, "departments", department_id);
+        if(!user || !department || treedb_link_nodes(tranger, "users", department, user)<0) {
+            ret = -1;
+        }
+        perf_histogram_record(hist, perf_now_ns() - t1);
+    }
+    uint64_t duration = perf_now_ns() - t0;
+
+    add_case("link", nodes, duration, hist);
+    perf_histogram_destroy(hist);
+    return ret;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int bench_list(json_t *tranger, uint64_t nodes, uint64_t lists)
+{
+    int ret = 0;
+    perf_histogram_t *hist = perf_histogram_create();
+    uint64_t listed = 0;
+
+    uint64_t t0 = perf_now_ns();
+    for(uint64_t i=0; i<lists; i++) {
+        uint64_t t1 = perf_now_ns();
+        json_t *list = treedb_list_nodes(tranger, TREEDB_NAME, "users", NULL, NULL);
+        perf_histogram_record(hist, perf_now_ns() - t1);
+        listed += json_array_size(list);
+        JSON_DECREF(list)
+    }
+    uint64_t duration = perf_now_ns() - t0;
+
+    if(listed != nodes * lists) {
+        ret = -1;
+    }
+
+    add_case("list", listed, duration, hist);   // ops: listed nodes, latency: one list
+    perf_histogram_destroy(hist);
+    return ret;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int bench_get(json_t *tranger, uint64_t nodes)
+{
+    int ret = 0;
+    perf_histogram_t *hist = perf_histogram_create();
+    char id[64];
+
+    uint64_t t0 = perf_now_ns();
+    for(uint64_t i=0; i<nodes; i++) {
+        snprintf(id, sizeof(id), "user-%llu", (unsigned long long)((i * 7919) % nodes));
+        uint64_t t1 = perf_now_ns();
+        if(!treedb_get_node(tranger, TREEDB_NAME, "users", id)) {
+            ret = -1;
+        }
+        perf_histogram_record(hist, perf_now_ns() - t1);
+    }
+    uint64_t duration = perf_now_ns() - t0;
+
+    add_case("get", nodes, duration, hist);
+    perf_histogram_destroy(hist);
+    return ret;
+}
+
+/***************************************************************************
+ *  Reload the db from disk: nodes and links are rebuilt from the topics
+ ***************************************************************************/
+PRIVATE int bench_open_db(json_t *tranger, uint64_t nodes)
+{
+    treedb_close_db(tranger, TREEDB_NAME);
+
+    uint64_t t0 = perf_now_ns();
+    int ret = open_db(tranger);
+    uint64_t duration = perf_now_ns() - t0;
+
+    add_case("open_db", nodes + DEPARTMENTS, duration, NULL);
+    return ret;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int do_test(void)
+{
+    int result = 0;
+    uint64_t nodes = perf_env_uint64("PERF_NODES", 10000);
+    uint64_t lists = perf_env_uint64("PERF_LISTS", 20);
+
+    /*
+     *  Write the database in ~/tests_yuneta/
+     */
+    const char *home = getenv("HOME");
+    char path_root[PATH_MAX];
+    char path_database[PATH_MAX];
+
+    build_path(path_root, sizeof(path_root), home, "tests_yuneta", NULL);
+    mkrdir(path_root, 02770);
+
+    build_path(path_database, sizeof(path_database), path_root, DATABASE, NULL);
+    rmrdir(path_database);
+
+    json_t *jn_tranger = json_pack("{s:s, s:s, s:b, s:i}",
+        "path", path_root,
+        "database", DATABASE,
+        "master", 1,
+        "on_critical_error", LOG_OPT_TRACE_STACK
+    );
+    json_t *tranger = tranger2_startup(0, jn_tranger, 0);
+    if(!tranger) {
+        return -1;
+    }
+
+    helper_quote2doublequote(schema);
+    if(open_db(tranger)<0) {
+        tranger2_shutdown(tranger);
+        return -1;
+    }
+
+    jn_cases = json_array();
+
+    result += bench_create(tranger, nodes);
+    result += bench_update(tranger, nodes);
+    result += bench_link(tranger, nodes);
+    result += bench_list(tranger, nodes, lists);
+    result += bench_get(tranger, nodes);
+    result += bench_open_db(tranger, nodes);
+
+    treedb_close_db(tranger, TREEDB_NAME);
+    tranger2_shutdown(tranger);
+
+    perf_save_json(APP, json_pack("{s:s, s:I, s:I, s:o}",
+        "name", APP,
+        "nodes", (json_int_t)nodes,
+        "departments", (json_int_t)DEPARTMENTS,
+        "cases", jn_cases
+    ));
+    jn_cases = 0;
+
+    rmrdir(path_database);
+    return result;
+}
+
+/***************************************************************************
+ *              Main
+ ***************************************************************************/
+int main(int argc, char *argv[])
+{
+    /*----------------------------------*
+     *      Startup gobj system
+     *----------------------------------*/
+    sys_malloc_fn_t malloc_func;
+    sys_realloc_fn_t realloc_func;
+    sys_calloc_fn_t calloc_func;
+    sys_free_fn_t free_func;
+
+    gbmem_get_allocators(
+        &malloc_func,
+        &realloc_func,
+        &calloc_func,
+        &free_func
+    );
+
+    json_set_alloc_funcs(
+        malloc_func,
+        free_func
+    );
+
+    unsigned long memory_check_list[] = {0, 0};
+    set_memory_check_list(memory_check_list);
+
+    init_backtrace_with_backtrace(argv[0]);
+    set_show_backtrace_fn(show_backtrace_with_backtrace);
+
+    gobj_start_up(
+        argc,
+        argv,
+        NULL, NULL, NULL, NULL, NULL, NULL
+    );
+
+    yuno_catch_signals();
+
+    /*--------------------------------*
+     *      Log handlers
+     *--------------------------------*/
+    gobj_log_add_handler("stdout", "stdout", LOG_OPT_UP_WARNING, 0);
+
+    gobj_log_register_handler(
+        "testing",
+        0,
+        capture_log_write,
+        0
+    );
+    gobj_log_add_handler("test_capture", "testing", LOG_OPT_UP_ERROR, 0);
+
+    /*--------------------------------*
+     *  Create the event loop
+     *--------------------------------*/
+    yev_loop_create(
+        0,
+        2024,
+        10,
+        NULL,
+        &yev_loop
+    );
+
+    /*--------------------------------*
+     *      Test
+     *--------------------------------*/
+    set_expected_results( // Check that no errors happen
+        APP,
+        json_array(),
+        NULL,
+        NULL,
+        TRUE
+    );
+
+    int result = do_test();
+    result += test_json(NULL);
+
+    /*--------------------------------*
+     *  Stop the event loop
+     *--------------------------------*/
+    yev_loop_stop(yev_loop);
+    yev_loop_destroy(yev_loop);
+
+    gobj_end();
+
+    if(get_cur_system_memory()!=0) {
+        printf("%sERROR%s <-- %s\n", On_Red BWhite, Color_Off, "system memory not free");
+        print_track_mem();
+        result += -1;
+    }
+
+    if(result<0) {
+        printf("<-- %sTEST FAILED%s: %s\n", On_Red BWhite, Color_Off, APP);
+    }
+    return result<0?-1:0;
+}
+
+/***************************************************************************
+ *      Signal handlers
+ ***************************************************************************/
+PRIVATE void quit_sighandler(int sig)
+{
+    static int xtimes_once = 0;
+    xtimes_once++;
+    yev_loop_reset_running(yev_loop);
+    if(xtimes_once > 1) {
+        exit(-1);
+    }
+}
+
+PRIVATE void yuno_catch_signals(void)
+{
+    struct sigaction sigIntHandler;
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGTERM, SIG_IGN);
+
+    memset(&sigIntHandler, 0, sizeof(sigIntHandler));
+    sigIntHandler.sa_handler = quit_sighandler;
+    sigemptyset(&sigIntHandler.sa_mask);
+    sigIntHandler.sa_flags = SA_NODEFER|SA_RESTART;
+    sigaction(SIGALRM, &sigIntHandler, NULL);
+    sigaction(SIGQUIT, &sigIntHandler, NULL);
+    sigaction(SIGINT, &sigIntHandler, NULL);
+}
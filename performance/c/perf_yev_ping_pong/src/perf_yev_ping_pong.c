@@ -19,6 +19,7 @@
 #include <ansi_escape_codes.h>
 #include <yev_loop.h>
 #include <helpers.h>
+#include <perf_harness.h>
 
 /***************************************************************
  *              Constants
@@ -41,6 +42,7 @@ int who_drop = 0; // 0 client, 1 srv_cli, 2 server
 PRIVATE void yuno_catch_signals(void);
 PRIVATE int yev_server_callback(yev_event_h event);
 PRIVATE int yev_client_callback(yev_event_h event);
+PRIVATE void client_send(void);
 
 /***************************************************************
  *              Data
@@ -67,6 +69,12 @@ yev_event_h yev_client_tx = 0;
 gbuffer_t *gbuf_client_rx = 0;
 yev_event_h yev_client_rx = 0;
 
+yev_event_h yev_client_timer = 0;   // open loop, wait the scheduled send time
+
+perf_harness_t *harness = 0;
+uint64_t client_t_sent = 0;
+size_t client_rx_bytes = 0;
+
 uint64_t t;
 uint64_t msg_per_second = 0;
 uint64_t bytes_per_second = 0;
@@ -303,23 +311,15 @@ PRIVATE int yev_client_callback(yev_event_h yev_event)
                     break;
                 }
 
-                /*
-                 *  Save received data to transmit: do echo
-                 */
                 if(dump) {
                     gobj_trace_dump_gbuf(gobj, yev_get_gbuf(yev_event), "Client receiving");
                 }
-                gbuffer_clear(gbuf_client_tx);
-                gbuffer_append_gbuf(gbuf_client_tx, yev_get_gbuf(yev_event));
 
                 /*
-                 *  Transmit
+                 *  The echo can arrive in several reads,
+                 *  the round-trip ends when the whole message is back.
                  */
-                if(dump) {
-                    gobj_trace_dump_gbuf(gobj, gbuf_client_tx, "Client transmitting");
-                }
-                yev_set_gbuffer(yev_client_tx, gbuf_client_tx);
-                yev_start_event(yev_client_tx);
+                client_rx_bytes += gbuffer_leftbytes(yev_get_gbuf(yev_event));
 
                 /*
                  *  Clear buffer
@@ -327,6 +327,33 @@ PRIVATE int yev_client_callback(yev_event_h yev_event)
                  */
                 gbuffer_clear(yev_get_gbuf(yev_event));
                 yev_start_event(yev_client_rx);
+
+                if(client_rx_bytes >= gbuffer_totalbytes(gbuf_client_tx)) {
+                    client_rx_bytes = 0;
+                    perf_harness_received(harness, client_t_sent, gbuffer_totalbytes(gbuf_client_tx));
+
+                    /*
+                     *  Next message, now or at its scheduled time (open loop)
+                     */
+                    uint64_t wait_ms = perf_harness_wait_ms(harness);
+                    if(wait_ms > 0) {
+                        yev_start_timer_event(yev_client_timer, (time_t)wait_ms, FALSE);
+                    } else {
+                        client_send();
+                    }
+                }
+            }
+            break;
+
+        case YEV_TIMER_TYPE:
+            {
+                if(yev_state != YEV_ST_IDLE) {
+                    /*
+                     *  Timer stopped
+                     */
+                    break;
+                }
+                client_send();
             }
             break;
 
@@ -400,15 +427,19 @@ PRIVATE int yev_client_callback(yev_event_h yev_event)
                         0
                     );
                 }
+                if(!yev_client_timer) {
+                    yev_client_timer = yev_create_timer_event(
+                        yev_get_loop(yev_event),
+                        yev_client_callback,
+                        NULL
+                    );
+                }
 
                 /*
                  *  Transmit
                  */
-                if(dump) {
-                    gobj_trace_dump_gbuf(gobj, yev_get_gbuf(yev_event), "Client transmitting");
-                }
-                yev_set_gbuffer(yev_client_tx, gbuf_client_tx);
-                yev_start_event(yev_client_tx);
+                perf_harness_start(harness);
+                client_send();
             }
             break;
         default:
@@ -425,6 +456,20 @@ PRIVATE int yev_client_callback(yev_event_h yev_event)
     return ret;
 }
 
+/***************************************************************************
+ *  Send the client message, always the whole buffer
+ ***************************************************************************/
+PRIVATE void client_send(void)
+{
+    gbuffer_reset_rd(gbuf_client_tx);
+    if(dump) {
+        gobj_trace_dump_gbuf(0, gbuf_client_tx, "Client transmitting");
+    }
+    client_t_sent = perf_harness_sent(harness);
+    yev_set_gbuffer(yev_client_tx, gbuf_client_tx);
+    yev_start_event(yev_client_tx);
+}
+
 /***************************************************************************
  *              Test
  ***************************************************************************/
@@ -482,6 +527,8 @@ PRIVATE int do_test(void)
 
     result += yev_start_event(yev_client_connect);
 
+    harness = perf_harness_create("perf_yev_ping_pong");
+
     printf("\n----------------> Quit in %d seconds <-----------------\n\n", time2exit);
 
     /*--------------------------------*
@@ -489,10 +536,12 @@ PRIVATE int do_test(void)
      *--------------------------------*/
     t = start_msectimer(1000);
     result += yev_loop_run(yev_loop, 10);
+    perf_harness_stop(harness);
 
     /*--------------------------------*
      *      Stop
      *--------------------------------*/
+    yev_stop_event(yev_client_timer);
     yev_stop_event(yev_server_tx);
     yev_stop_event(yev_server_rx);
     yev_stop_event(yev_client_tx);
@@ -508,6 +557,7 @@ PRIVATE int do_test(void)
     yev_destroy_event(yev_server_rx);
     yev_destroy_event(yev_client_tx);
     yev_destroy_event(yev_client_rx);
+    yev_destroy_event(yev_client_timer);
     yev_destroy_event(yev_server_accept);
     yev_destroy_event(yev_client_connect);
 
@@ -595,6 +645,10 @@ int main(int argc, char *argv[])
     result += do_test();
     printf(Cursor_Down "\n", 4);
 
+    perf_harness_print(harness);
+    perf_harness_save(harness);
+    perf_harness_destroy(harness);
+
     result += test_json(NULL);
 
     gobj_end();
@@ -0,0 +1,808 @@
+/***********************************************************************
+ *          C_TEST_HTTP_SR.C
+ *
+ *          Test of C_PROT_HTTP_SR, the http server protocol.
+ *          The protocol runs over C_MOCK_TRANSPORT: the requests are
+ *          injected with EV_RX_DATA and the responses are read from the
+ *          wire of the mock, all in the same turn of the loop.
+ *
+ *          What must hold:
+ *
+ *      1) Pipelined responses are written in the order of the requests,
+ *         whatever the order in which they are produced. A response
+ *         without "__http_seq__" answers the oldest request not
+ *         answered yet.
+ *
+ *      2) File responses: HEAD sends the headers only, a single Range
+ *         (and a suffix one) is a 206 with its bytes, several ranges are
+ *         the whole file, and a range out of the file is a 416. The
+ *         request is found by the seq, echoed or not.
+ *
+ *      3) raw_body_data: the headers come in EV_ON_HEADER with the seq,
+ *         the body in EV_ON_MESSAGE chunks (__pbf__) as they arrive, and
+ *         an EV_ON_MESSAGE without __pbf__ ends the request, also with
+ *         pipelined requests in the same buffer. EV_PAUSE_RX and
+ *         EV_RESUME_RX go down to the transport.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ***********************************************************************/
+#include <string.h>
+#include <unistd.h>
+
+#include "c_mock_transport.h"
+#include "c_test_http_sr.h"
+
+/***************************************************************************
+ *              Constants
+ ***************************************************************************/
+#define FILE_PATH       "/tmp/test_c_prot_http_sr.txt"
+#define FILE_CONTENT    "0123456789abcdefghij"
+
+/***************************************************************************
+ *              Structures
+ ***************************************************************************/
+
+/***************************************************************************
+ *              Prototypes
+ ***************************************************************************/
+PRIVATE int check(hgobj gobj, BOOL ok, const char *what);
+
+/***************************************************************************
+ *          Data: config, public data, private data
+ ***************************************************************************/
+/*---------------------------------------------*
+ *      Attributes
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t attrs_table[] = {
+/*-ATTR-type------------name----------------flag----------------default-----description--*/
+SDATA (DTP_POINTER,     "subscriber",       0,                  0,          "Subscriber of output-events"),
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *      GClass trace levels
+ *---------------------------------------------*/
+PRIVATE const trace_level_t s_user_trace_level[16] = {
+{0, 0},
+};
+
+/*---------------------------------------------*
+ *      GClass authz levels
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t authz_table[] = {
+/*-AUTHZ-- type---------name----------------flag----alias---items---description--*/
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *              Private data
+ *---------------------------------------------*/
+typedef struct _PRIVATE_DATA {
+    hgobj gobj_http;                // C_PROT_HTTP_SR under test
+    hgobj gobj_mock;                // its bottom, C_MOCK_TRANSPORT
+    json_t *jn_requests;            // EV_ON_MESSAGE published by gobj_http, in order
+                                    // (EV_ON_HEADER with raw_body_data)
+    gbuffer_t *gbuf_raw_body;       // raw_body_data: chunks of the current request
+    json_t *jn_raw_bodies;          // raw_body_data: body of each ended request
+} PRIVATE_DATA;
+
+
+
+
+                    /******************************
+                     *      Framework Methods
+                     ******************************/
+
+
+
+
+/***************************************************************************
+ *      Framework Method create
+ ***************************************************************************/
+PRIVATE void mt_create(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->jn_requests = json_array();
+    priv->jn_raw_bodies = json_array();
+
+    /*
+     *  SERVICE subscription model
+     */
+    hgobj subscriber = (hgobj)gobj_read_pointer_attr(gobj, "subscriber");
+    if(subscriber) {
+        gobj_subscribe_event(gobj, NULL, NULL, subscriber);
+    }
+}
+
+/***************************************************************************
+ *      Framework Method destroy
+ ***************************************************************************/
+PRIVATE void mt_destroy(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    JSON_DECREF(priv->jn_requests)
+    JSON_DECREF(priv->jn_raw_bodies)
+    GBUFFER_DECREF(priv->gbuf_raw_body)
+}
+
+/***************************************************************************
+ *      Framework Method start
+ ***************************************************************************/
+PRIVATE int mt_start(hgobj gobj)
+{
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method stop
+ ***************************************************************************/
+PRIVATE int mt_stop(hgobj gobj)
+{
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method play
+ *
+ *  The checks run from the event loop, like any action of a gclass.
+ ***************************************************************************/
+PRIVATE int mt_play(hgobj gobj)
+{
+    gobj_post_event(gobj, EV_TEST_RUN, 0, gobj);
+
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method pause
+ ***************************************************************************/
+PRIVATE int mt_pause(hgobj gobj)
+{
+    return 0;
+}
+
+
+
+
+                    /***************************
+                     *      Local Methods
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int check(hgobj gobj, BOOL ok, const char *what)
+{
+    if(ok) {
+        return 0;
+    }
+    gobj_log_error(gobj, 0,
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_INTERNAL,
+        "msg",          "%s", "http_sr check FAILED",
+        "what",         "%s", what,
+        NULL
+    );
+    return -1;
+}
+
+/***************************************************************************
+ *  A new connection: C_PROT_HTTP_SR over C_MOCK_TRANSPORT, connected
+ ***************************************************************************/
+PRIVATE void open_connection(hgobj gobj, json_t *kw_http)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->gobj_http = gobj_create_pure_child(
+        "http",
+        C_PROT_HTTP_SR,
+        kw_http? kw_http : json_object(),
+        gobj
+    );
+    priv->gobj_mock = gobj_create_pure_child("mock", C_MOCK_TRANSPORT, 0, priv->gobj_http);
+    gobj_set_bottom_gobj(priv->gobj_http, priv->gobj_mock);
+
+    gobj_start(priv->gobj_http);
+    gobj_send_event(priv->gobj_http, EV_CONNECTED, 0, priv->gobj_mock);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void close_connection(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gobj_stop(priv->gobj_http);
+    gobj_destroy(priv->gobj_http);
+    priv->gobj_http = 0;
+    priv->gobj_mock = 0;
+    json_array_clear(priv->jn_requests);
+    json_array_clear(priv->jn_raw_bodies);
+    GBUFFER_DECREF(priv->gbuf_raw_body)
+}
+
+/***************************************************************************
+ *  Bytes from the peer
+ ***************************************************************************/
+PRIVATE void rx(hgobj gobj, const char *data)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    size_t len = strlen(data);
+    gbuffer_t *gbuf = gbuffer_create(len, len);
+    gbuffer_append(gbuf, (void *)data, len);
+    gobj_send_event(
+        priv->gobj_http,
+        EV_RX_DATA,
+        json_pack("{s:I}", "gbuffer", (json_int_t)(uintptr_t)gbuf),
+        priv->gobj_mock
+    );
+}
+
+/***************************************************************************
+ *  Answer the request idx (in order of arrival) with a json body {"url":url}.
+ *  echo: echo the "__http_seq__" of the request.
+ ***************************************************************************/
+PRIVATE void respond_body(hgobj gobj, size_t idx, BOOL echo)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_t *request = json_array_get(priv->jn_requests, idx);
+    json_t *kw_response = json_pack("{s:s, s:{s:s}}",
+        "code", "200 OK",
+        "body",
+            "url", kw_get_str(gobj, request, "url", "", 0)
+    );
+    if(echo) {
+        json_object_set_new(kw_response, "__http_seq__",
+            json_integer(kw_get_int(gobj, request, "__http_seq__", 0, KW_REQUIRED))
+        );
+    }
+    gobj_send_event(priv->gobj_http, EV_SEND_MESSAGE, kw_response, gobj);
+}
+
+/***************************************************************************
+ *  The bodies {"url":url} of urls are on the wire, in this order
+ ***************************************************************************/
+PRIVATE BOOL wire_in_order(hgobj gobj, const char **urls)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    const char *p = mock_transport_wire(priv->gobj_mock);
+    for(int i=0; urls[i]; i++) {
+        char body[128];
+        snprintf(body, sizeof(body), "{\"url\":\"%s\"}", urls[i]);
+        p = strstr(p, body);
+        if(!p) {
+            return FALSE;
+        }
+        p += strlen(body);
+    }
+    return TRUE;
+}
+
+/***************************************************************************
+ *  Answer the request idx (in order of arrival) with FILE_PATH
+ ***************************************************************************/
+PRIVATE void respond_file(hgobj gobj, size_t idx, BOOL echo)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_t *request = json_array_get(priv->jn_requests, idx);
+    json_t *kw_response = json_pack("{s:s}",
+        "file", FILE_PATH
+    );
+    if(echo) {
+        json_object_set_new(kw_response, "__http_seq__",
+            json_integer(kw_get_int(gobj, request, "__http_seq__", 0, KW_REQUIRED))
+        );
+    }
+    gobj_send_event(priv->gobj_http, EV_SEND_MESSAGE, kw_response, gobj);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE BOOL wire_has(hgobj gobj, const char *str)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    return strstr(mock_transport_wire(priv->gobj_mock), str)? TRUE:FALSE;
+}
+
+/***************************************************************************
+ *  The wire ends with the end of the headers and then body
+ ***************************************************************************/
+PRIVATE BOOL wire_body_is(hgobj gobj, const char *body)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    const char *wire = mock_transport_wire(priv->gobj_mock);
+    size_t wire_len = mock_transport_wire_length(priv->gobj_mock);
+    char tail[128];
+    snprintf(tail, sizeof(tail), "\r\n\r\n%s", body);
+    size_t tail_len = strlen(tail);
+    return wire_len >= tail_len && memcmp(wire + wire_len - tail_len, tail, tail_len)==0;
+}
+
+/***************************************************************************
+ *  One request for the file, answered without echoing the seq
+ ***************************************************************************/
+PRIVATE void file_request(hgobj gobj, const char *method, const char *range)
+{
+    char request[256];
+    snprintf(request, sizeof(request),
+        "%s /f HTTP/1.1\r\nHost: h\r\n%s%s%s\r\n",
+        method,
+        range? "Range: " : "",
+        range? range : "",
+        range? "\r\n" : ""
+    );
+    open_connection(gobj, 0);
+    rx(gobj, request);
+    respond_file(gobj, 0, FALSE);
+}
+
+/***************************************************************************
+ *  1) Pipelined responses produced out of order
+ ***************************************************************************/
+PRIVATE int test_pipelining(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    int result = 0;
+    const char *urls[] = {"/1", "/2", "/3", 0};
+    const char *requests =
+        "GET /1 HTTP/1.1\r\nHost: h\r\n\r\n"
+        "GET /2 HTTP/1.1\r\nHost: h\r\n\r\n"
+        "GET /3 HTTP/1.1\r\nHost: h\r\n\r\n";
+
+    /*
+     *  Echoing the seq, the last request first
+     */
+    open_connection(gobj, 0);
+    rx(gobj, requests);
+    result += check(gobj, json_array_size(priv->jn_requests) == 3, "3 pipelined requests");
+    for(size_t i=0; i<json_array_size(priv->jn_requests); i++) {
+        json_t *request = json_array_get(priv->jn_requests, i);
+        result += check(gobj,
+            kw_get_int(gobj, request, "__http_seq__", 0, 0) == (json_int_t)(i + 1),
+            "__http_seq__ of the requests"
+        );
+    }
+
+    respond_body(gobj, 2, TRUE);
+    respond_body(gobj, 1, TRUE);
+    result += check(gobj, mock_transport_wire_length(priv->gobj_mock) == 0, "responses held");
+    respond_body(gobj, 0, TRUE);
+    result += check(gobj, wire_in_order(gobj, urls), "echoed: in order");
+    close_connection(gobj);
+
+    /*
+     *  The second echoing the seq, the first and the third without it
+     */
+    open_connection(gobj, 0);
+    rx(gobj, requests);
+    respond_body(gobj, 1, TRUE);
+    result += check(gobj, mock_transport_wire_length(priv->gobj_mock) == 0, "second held");
+    respond_body(gobj, 0, FALSE);
+    respond_body(gobj, 2, FALSE);
+    result += check(gobj, wire_in_order(gobj, urls), "not echoed: fifo");
+    close_connection(gobj);
+
+    /*
+     *  Nobody echoing the seq: each response answers the oldest request
+     */
+    open_connection(gobj, 0);
+    rx(gobj, requests);
+    respond_body(gobj, 0, FALSE);
+    const char *first[] = {"/1", 0};
+    result += check(gobj, wire_in_order(gobj, first), "not echoed: written at once");
+    respond_body(gobj, 1, FALSE);
+    respond_body(gobj, 2, FALSE);
+    result += check(gobj, wire_in_order(gobj, urls), "not echoed: in order");
+    result += check(gobj, gobj_read_integer_attr(priv->gobj_mock, "drops") == 0, "no drop");
+    close_connection(gobj);
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "pipelining ok",
+            NULL
+        );
+    }
+    return result;
+}
+
+/***************************************************************************
+ *  2) File responses
+ ***************************************************************************/
+PRIVATE int test_file_responses(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    int result = 0;
+
+    FILE *file = fopen(FILE_PATH, "w");
+    if(!file) {
+        return check(gobj, FALSE, "create " FILE_PATH);
+    }
+    fputs(FILE_CONTENT, file);
+    fclose(file);
+
+    /*
+     *  HEAD pipelined with a GET, no seq echoed: the HEAD response has
+     *  no body, so the GET response starts right after its headers.
+     */
+    open_connection(gobj, 0);
+    rx(gobj,
+        "HEAD /f HTTP/1.1\r\nHost: h\r\n\r\n"
+        "GET /f HTTP/1.1\r\nHost: h\r\n\r\n"
+    );
+    respond_file(gobj, 0, FALSE);
+    respond_file(gobj, 1, FALSE);
+    result += check(gobj, wire_has(gobj, "Content-Length: 20\r\n\r\nHTTP/1.1 200 OK\r\n"),
+        "HEAD: headers only"
+    );
+    result += check(gobj, wire_body_is(gobj, FILE_CONTENT), "GET after HEAD: body");
+    result += check(gobj, gobj_read_integer_attr(priv->gobj_mock, "tx_files") == 1,
+        "HEAD: no file sent"
+    );
+    close_connection(gobj);
+
+    /*
+     *  HEAD with the seq echoed
+     */
+    open_connection(gobj, 0);
+    rx(gobj, "HEAD /f HTTP/1.1\r\nHost: h\r\n\r\n");
+    respond_file(gobj, 0, TRUE);
+    result += check(gobj, wire_body_is(gobj, ""), "HEAD echoed: headers only");
+    result += check(gobj, gobj_read_integer_attr(priv->gobj_mock, "tx_files") == 0,
+        "HEAD echoed: no file sent"
+    );
+    close_connection(gobj);
+
+    /*
+     *  Single range
+     */
+    file_request(gobj, "GET", "bytes=2-5");
+    result += check(gobj, wire_has(gobj, "HTTP/1.1 206 Partial Content\r\n"), "range: 206");
+    result += check(gobj, wire_has(gobj, "Content-Range: bytes 2-5/20\r\n"), "range: Content-Range");
+    result += check(gobj, wire_has(gobj, "Content-Length: 4\r\n"), "range: Content-Length");
+    result += check(gobj, wire_body_is(gobj, "2345"), "range: body");
+    close_connection(gobj);
+
+    /*
+     *  Suffix range
+     */
+    file_request(gobj, "GET", "bytes=-3");
+    result += check(gobj, wire_has(gobj, "Content-Range: bytes 17-19/20\r\n"), "suffix: Content-Range");
+    result += check(gobj, wire_body_is(gobj, "hij"), "suffix: body");
+    close_connection(gobj);
+
+    /*
+     *  Several ranges: the whole file
+     */
+    file_request(gobj, "GET", "bytes=0-1,4-5");
+    result += check(gobj, wire_has(gobj, "HTTP/1.1 200 OK\r\n"), "multi-range: 200");
+    result += check(gobj, !wire_has(gobj, "Content-Range"), "multi-range: no Content-Range");
+    result += check(gobj, wire_body_is(gobj, FILE_CONTENT), "multi-range: body");
+    close_connection(gobj);
+
+    /*
+     *  Range out of the file
+     */
+    file_request(gobj, "GET", "bytes=50-60");
+    result += check(gobj, wire_has(gobj, "HTTP/1.1 416 Range Not Satisfiable\r\n"), "416");
+    result += check(gobj, wire_has(gobj, "Content-Range: bytes */20\r\n"), "416: Content-Range");
+    result += check(gobj, wire_body_is(gobj, ""), "416: no body");
+    result += check(gobj, gobj_read_integer_attr(priv->gobj_mock, "tx_files") == 0,
+        "416: no file sent"
+    );
+    close_connection(gobj);
+
+    /*
+     *  HEAD of a range
+     */
+    file_request(gobj, "HEAD", "bytes=2-5");
+    result += check(gobj, wire_has(gobj, "HTTP/1.1 206 Partial Content\r\n"), "HEAD range: 206");
+    result += check(gobj, wire_body_is(gobj, ""), "HEAD range: no body");
+    close_connection(gobj);
+
+    unlink(FILE_PATH);
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "file responses ok",
+            NULL
+        );
+    }
+    return result;
+}
+
+
+
+
+/***************************************************************************
+ *  3) raw_body_data and flow control
+ ***************************************************************************/
+PRIVATE int test_raw_body_data(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    int result = 0;
+
+    open_connection(gobj, json_pack("{s:b}", "raw_body_data", 1));
+
+    /*
+     *  The headers and the first part of the body
+     */
+    rx(gobj, "POST /up HTTP/1.1\r\nHost: h\r\nContent-Length: 10\r\n\r\n01234");
+    json_t *request = json_array_get(priv->jn_requests, 0);
+    result += check(gobj, json_array_size(priv->jn_requests) == 1, "raw: headers published");
+    result += check(gobj, strcmp(kw_get_str(gobj, request, "url", "", 0), "/up")==0, "raw: url");
+    result += check(gobj, kw_get_int(gobj, request, "__http_seq__", 0, 0) == 1, "raw: seq");
+    result += check(gobj, priv->gbuf_raw_body && gbuffer_leftbytes(priv->gbuf_raw_body) == 5,
+        "raw: first chunk"
+    );
+    result += check(gobj, json_array_size(priv->jn_raw_bodies) == 0, "raw: not ended");
+
+    /*
+     *  The consumer pauses the reading, the rest arrives anyway
+     */
+    gobj_send_event(priv->gobj_http, EV_PAUSE_RX, 0, gobj);
+    result += check(gobj, gobj_read_integer_attr(priv->gobj_mock, "pauses") == 1, "raw: paused");
+    rx(gobj, "56789");
+    result += check(gobj, json_array_size(priv->jn_raw_bodies) == 1, "raw: ended");
+    result += check(gobj,
+        strcmp(json_string_value(json_array_get(priv->jn_raw_bodies, 0)), "0123456789")==0,
+        "raw: body"
+    );
+    gobj_send_event(priv->gobj_http, EV_RESUME_RX, 0, gobj);
+    result += check(gobj, gobj_read_integer_attr(priv->gobj_mock, "resumes") == 1, "raw: resumed");
+
+    respond_body(gobj, 0, FALSE);
+    const char *up[] = {"/up", 0};
+    result += check(gobj, wire_in_order(gobj, up), "raw: response");
+
+    /*
+     *  Pipelined in the same buffer, one of them without body
+     */
+    rx(gobj,
+        "POST /a HTTP/1.1\r\nHost: h\r\nContent-Length: 3\r\n\r\nabc"
+        "GET /b HTTP/1.1\r\nHost: h\r\n\r\n"
+        "POST /c HTTP/1.1\r\nHost: h\r\nContent-Length: 2\r\n\r\nde"
+    );
+    result += check(gobj, json_array_size(priv->jn_requests) == 4, "raw pipelined: headers");
+    for(size_t i=0; i<json_array_size(priv->jn_requests); i++) {
+        request = json_array_get(priv->jn_requests, i);
+        result += check(gobj,
+            kw_get_int(gobj, request, "__http_seq__", 0, 0) == (json_int_t)(i + 1),
+            "raw pipelined: seq"
+        );
+    }
+    const char *bodies[] = {"0123456789", "abc", "", "de", 0};
+    result += check(gobj, json_array_size(priv->jn_raw_bodies) == 4, "raw pipelined: ended");
+    for(int i=0; bodies[i] && i < (int)json_array_size(priv->jn_raw_bodies); i++) {
+        result += check(gobj,
+            strcmp(json_string_value(json_array_get(priv->jn_raw_bodies, i)), bodies[i])==0,
+            "raw pipelined: body"
+        );
+    }
+
+    respond_body(gobj, 3, TRUE);
+    respond_body(gobj, 1, FALSE);
+    respond_body(gobj, 2, FALSE);
+    const char *urls[] = {"/up", "/a", "/b", "/c", 0};
+    result += check(gobj, wire_in_order(gobj, urls), "raw pipelined: responses in order");
+    close_connection(gobj);
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "raw body data ok",
+            NULL
+        );
+    }
+    return result;
+}
+
+
+
+
+                    /***************************
+                     *      Actions
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Run the checks and die
+ ***************************************************************************/
+PRIVATE int ac_test_run(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    test_pipelining(gobj);
+    test_file_responses(gobj);
+    test_raw_body_data(gobj);
+
+    set_yuno_must_die();
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  A request of gobj_http, keep it to answer it.
+ *  With raw_body_data: a chunk of the body (__pbf__),
+ *  or the end of the request (neither __pbf__ nor url).
+ ***************************************************************************/
+PRIVATE int ac_on_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(kw_has_key(kw, "__pbf__")) {
+        const char *pbf = (const char *)(uintptr_t)kw_get_int(gobj, kw, "__pbf__", 0, 0);
+        size_t pbf_size = (size_t)kw_get_int(gobj, kw, "__pbf_size__", 0, 0);
+        if(!priv->gbuf_raw_body) {
+            priv->gbuf_raw_body = gbuffer_create(256, 4*1024);
+        }
+        gbuffer_append(priv->gbuf_raw_body, (void *)pbf, pbf_size);
+
+    } else if(!kw_has_key(kw, "url")) {
+        size_t len = priv->gbuf_raw_body? gbuffer_leftbytes(priv->gbuf_raw_body) : 0;
+        json_array_append_new(priv->jn_raw_bodies, json_stringn(
+            len? gbuffer_cur_rd_pointer(priv->gbuf_raw_body) : "",
+            len
+        ));
+        GBUFFER_DECREF(priv->gbuf_raw_body)
+
+    } else {
+        json_array_append(priv->jn_requests, kw);
+    }
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  raw_body_data: headers of a request, keep it to answer it
+ ***************************************************************************/
+PRIVATE int ac_on_header(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_array_append(priv->jn_requests, kw);
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_on_open(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_on_close(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *                          FSM
+ ***************************************************************************/
+/*---------------------------------------------*
+ *          Global methods table
+ *---------------------------------------------*/
+PRIVATE const GMETHODS gmt = {
+    .mt_create  = mt_create,
+    .mt_destroy = mt_destroy,
+    .mt_start   = mt_start,
+    .mt_stop    = mt_stop,
+    .mt_play    = mt_play,
+    .mt_pause   = mt_pause,
+};
+
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DEFINE_GCLASS(C_TEST_HTTP_SR);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+GOBJ_DEFINE_EVENT(EV_TEST_RUN);
+
+/***************************************************************************
+ *          Create the GClass
+ ***************************************************************************/
+PRIVATE int create_gclass(gclass_name_t gclass_name)
+{
+    static hgclass __gclass__ = 0;
+    if(__gclass__) {
+        gobj_log_error(0, 0,
+            "function", "%s", __FUNCTION__,
+            "msgset",   "%s", MSGSET_INTERNAL,
+            "msg",      "%s", "GClass ALREADY created",
+            "gclass",   "%s", gclass_name,
+            NULL
+        );
+        return -1;
+    }
+
+    /*------------------------*
+     *      States
+     *------------------------*/
+    ev_action_t st_idle[] = {
+        {EV_TEST_RUN,               ac_test_run,            0},
+        {EV_ON_MESSAGE,             ac_on_message,          0},
+        {EV_ON_HEADER,              ac_on_header,           0},
+        {EV_ON_OPEN,                ac_on_open,             0},
+        {EV_ON_CLOSE,               ac_on_close,            0},
+        {0,0,0}
+    };
+
+    states_t states[] = {
+        {ST_IDLE,       st_idle},
+        {0, 0}
+    };
+
+    /*------------------------*
+     *      Events
+     *------------------------*/
+    event_type_t event_types[] = {
+        {EV_TEST_RUN,               0},
+        {EV_ON_MESSAGE,             0},
+        {EV_ON_HEADER,              0},
+        {EV_ON_OPEN,                0},
+        {EV_ON_CLOSE,               0},
+        {NULL, 0}
+    };
+
+    /*----------------------------------------*
+     *          Register GClass
+     *----------------------------------------*/
+    __gclass__ = gclass_create(
+        gclass_name,
+        event_types,
+        states,
+        &gmt,
+        0, // local methods
+        attrs_table,
+        sizeof(PRIVATE_DATA),
+        authz_table,
+        0, // command_table
+        s_user_trace_level,
+        0 // gcflags
+    );
+    if(!__gclass__) {
+        // Error already logged
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *              Public access
+ ***************************************************************************/
+PUBLIC int register_c_test_http_sr(void)
+{
+    return create_gclass(C_TEST_HTTP_SR);
+}
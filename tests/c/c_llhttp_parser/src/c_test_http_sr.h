@@ -0,0 +1,41 @@
+/****************************************************************************
+ *          C_TEST_HTTP_SR.H
+ *
+ *          A gclass to test C_PROT_HTTP_SR over C_MOCK_TRANSPORT
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#pragma once
+
+#include <yunetas.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/***************************************************************
+ *              FSM
+ ***************************************************************/
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DECLARE_GCLASS(C_TEST_HTTP_SR);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+GOBJ_DECLARE_EVENT(EV_TEST_RUN);        // posted from mt_play, the checks run in the loop
+
+/***************************************************************
+ *              Prototypes
+ ***************************************************************/
+PUBLIC int register_c_test_http_sr(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,215 @@
+/****************************************************************************
+ *          MAIN.C
+ *
+ *          Main of test_c_prot_http_sr
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#include <yunetas.h>
+#include "c_mock_transport.h"
+#include "c_test_http_sr.h"
+
+/***************************************************************************
+ *                      Names
+ ***************************************************************************/
+#define APP_NAME        "test_c_prot_http_sr"
+#define APP_DOC         "Test C_PROT_HTTP_SR over a mock transport"
+
+#define APP_VERSION     "1.0.0"
+#define APP_SUPPORT     "<support@artgins.com>"
+#define APP_DATETIME    __DATE__ " " __TIME__
+
+#define USE_OWN_SYSTEM_MEMORY   FALSE
+#define MEM_MIN_BLOCK           0       // use default
+#define MEM_MAX_BLOCK           0       // use default
+#define MEM_SUPERBLOCK          0       // use default
+#define MEM_MAX_SYSTEM_MEMORY   0       // use default
+
+/***************************************************************************
+ *                      Default config
+ ***************************************************************************/
+PRIVATE char fixed_config[]= "\
+{                                                                   \n\
+    'yuno': {                                                       \n\
+        'yuno_role': '"APP_NAME"',                                  \n\
+        'tags': ['test', 'yunetas']                                 \n\
+    }                                                               \n\
+}                                                                   \n\
+";
+PRIVATE char variable_config[]= "\
+{                                                                   \n\
+    'environment': {                                                \n\
+        'console_log_handlers': {                                   \n\
+        },                                                          \n\
+        'daemon_log_handlers': {                                    \n\
+        }                                                           \n\
+    },                                                              \n\
+    'yuno': {                                                       \n\
+        'autoplay': true,                                           \n\
+        'required_services': [],                                    \n\
+        'public_services': [],                                      \n\
+        'service_descriptor': {                                     \n\
+        },                                                          \n\
+        'trace_levels': {                                           \n\
+        }                                                           \n\
+    },                                                              \n\
+    'global': {                                                     \n\
+    },                                                              \n\
+    'services': [                                                   \n\
+        {                                                           \n\
+            'name': 'test_http_sr',                                 \n\
+            'gclass': 'C_TEST_HTTP_SR',                             \n\
+            'default_service': true,                                \n\
+            'autostart': true,                                      \n\
+            'autoplay': false,                                      \n\
+            'kw': {                                                 \n\
+            },                                                      \n\
+            'children': [                                            \n\
+            ]                                                       \n\
+        }                                                           \n\
+    ]                                                               \n\
+}                                                                   \n\
+";
+
+/***************************************************************************
+ *  HACK This function is executed on yunetas environment (mem, log, paths)
+ *  BEFORE creating the yuno
+ ***************************************************************************/
+int result = 0;
+
+static int register_yuno_and_more(void)
+{
+    int result = 0;
+
+    /*--------------------*
+     *  Register gclass
+     *--------------------*/
+    result += register_c_mock_transport();
+    result += register_c_test_http_sr();
+
+    /*--------------------------*
+     *  Check all gclass' FSM
+     *--------------------------*/
+    yunetas_register_c_core();
+    json_t *jn_gclasses = gclass_gclass_register();
+    int idx; json_t *jn_gclass;
+    json_array_foreach(jn_gclasses, idx, jn_gclass) {
+        const char *gclass_name = kw_get_str(0, jn_gclass, "gclass", "", KW_REQUIRED);
+        hgclass gclass = gclass_find_by_name(gclass_name);
+        result += gclass_check_fsm(gclass);
+    }
+    json_decref(jn_gclasses);
+
+    /*------------------------------------------------*
+     *          Traces
+     *------------------------------------------------*/
+    // Avoid timer trace, too much information
+    gobj_set_gclass_no_trace(gclass_find_by_name(C_TIMER0), "machine", TRUE);
+    gobj_set_global_no_trace("timer_periodic", TRUE);
+    gobj_set_global_no_trace("timer", TRUE);
+
+    // Samples of traces
+    // gobj_set_gobj_trace(0, "machine", TRUE, 0);
+    // gobj_set_gobj_trace(0, "ev_kw", TRUE, 0);
+    // gobj_set_gobj_trace(0, "create_delete", TRUE, 0);
+
+    /*------------------------------*
+     *  Start test
+     *------------------------------*/
+    set_expected_results( // Check that no logs happen
+        APP_NAME, // test name
+        json_pack("[{s:s}, {s:s}, {s:s}, {s:s}, {s:s}, {s:s}, {s:s}, {s:s}]", // errors_list
+            "msg", "Starting yuno",
+            "msg", "Playing yuno",
+            "msg", "pipelining ok",
+            "msg", "file responses ok",
+            "msg", "raw body data ok",
+            "msg", "Exit to die",
+            "msg", "Pausing yuno",
+            "msg", "Yuno stopped, gobj end"
+        ),
+        NULL,   // expected, NULL: we want to check only the logs
+        NULL,   // ignore_keys
+        1       // verbose
+    );
+
+    return result;
+}
+
+/***************************************************************************
+ *  HACK This function is executed on yunetas environment (mem, log, paths)
+ *  BEFORE creating the yuno
+ ***************************************************************************/
+static void cleaning(void)
+{
+    result += test_json(NULL);  // NULL: we want to check only the logs
+}
+
+/***************************************************************************
+ *                      Main
+ ***************************************************************************/
+int main(int argc, char *argv[])
+{
+    /*------------------------------*
+     *  Capture the logger output
+     *------------------------------*/
+    glog_init();
+
+    /*
+     *  Add all handlers very early
+     */
+    gobj_log_add_handler("stdout", "stdout", LOG_OPT_ALL, 0);
+
+    gobj_log_register_handler(
+        "testing",          // handler_name
+        0,                  // close_fn
+        capture_log_write,  // write_fn
+        0                   // fwrite_fn
+    );
+    gobj_log_add_handler("test_capture", "testing", LOG_OPT_UP_INFO, 0);
+
+    /*------------------------------------------------*
+     *      To check memory loss
+     *------------------------------------------------*/
+    unsigned long memory_check_list[] = {0, 0}; // WARNING: the list ended with 0
+    set_memory_check_list(memory_check_list);
+
+    /*------------------------------------------------*
+     *          Start yuneta
+     *------------------------------------------------*/
+    helper_quote2doublequote(fixed_config);
+    helper_quote2doublequote(variable_config);
+    yuneta_setup(
+        NULL,       // persistent_attrs, default internal dbsimple
+        NULL,       // command_parser, default internal command_parser
+        NULL,       // stats_parser, default internal stats_parser
+        NULL,       // authz_checker, default Monoclass C_AUTHZ
+        NULL,       // authentication_parser, default Monoclass C_AUTHZ
+        MEM_MAX_BLOCK,
+        MEM_MAX_SYSTEM_MEMORY,
+        USE_OWN_SYSTEM_MEMORY,
+        MEM_MIN_BLOCK,
+        MEM_SUPERBLOCK
+    );
+
+    result += yuneta_entry_point(
+        argc, argv,
+        APP_NAME, APP_VERSION, APP_SUPPORT, APP_DOC, APP_DATETIME,
+        fixed_config,
+        variable_config,
+        register_yuno_and_more,
+        cleaning
+    );
+
+    if(get_cur_system_memory()!=0) {
+        printf("%sERROR --> %s%s\n", On_Red BWhite, "system memory not free", Color_Off);
+        print_track_mem();
+        result += -1;
+    }
+
+    if(result<0) {
+        printf("<-- %sTEST FAILED%s: %s\n", On_Red BWhite, Color_Off, APP_NAME);
+    }
+    return result<0?-1:0;
+}
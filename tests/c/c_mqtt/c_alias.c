@@ -0,0 +1,531 @@
+/****************************************************************************
+ *          C_ALIAS.C
+ *
+ *          Self-contained MQTT outgoing topic alias test GClass.
+ *
+ *          The broker accepts 2 topic aliases (max_topic_alias in its
+ *          CONNACK), the client publishes to 3 topics and receives them back.
+ *
+ *          Test sequence:
+ *            1. Timer fires (500 ms) -> start MQTT client (output_side)
+ *            2. EV_ON_OPEN (CONNACK)  -> subscribe to "alias/#"
+ *            3. EV_MQTT_SUBSCRIBE (SUBACK) -> publish to
+ *                  alias/1     alias 1 assigned            (miss)
+ *                  alias/2     alias 2 assigned            (miss)
+ *                  alias/1     alias 1 used, no topic      (hit)
+ *                  alias/3     alias 2 re-mapped, LRU      (miss, eviction)
+ *                  alias/2     alias 1 re-mapped, LRU      (miss, eviction)
+ *            4. EV_MQTT_MESSAGE x5 -> verify the topics and the
+ *               txTopicAlias* stats, drop the link (C_TCP).
+ *            5. The client reconnects (EV_ON_OPEN), subscribe and publish to
+ *               alias/3: the aliases were reset, it's a miss, not a hit.
+ *            6. EV_MQTT_MESSAGE -> verify topic and stats, disconnect, die
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#include <yunetas.h>
+#include <c_mqtt_broker.h>
+#include <c_prot_mqtt2.h>
+#include "c_alias.h"
+
+/***************************************************************************
+ *              Constants
+ ***************************************************************************/
+PRIVATE const char *topics1[] = {
+    "alias/1",
+    "alias/2",
+    "alias/1",
+    "alias/3",
+    "alias/2",
+    0
+};
+PRIVATE const char *topics2[] = {
+    "alias/3",
+    0
+};
+
+/***************************************************************************
+ *          Data: config, public data, private data
+ ***************************************************************************/
+PRIVATE sdata_desc_t attrs_table[] = {
+/*-ATTR-type----------name-----------flag----default-----description---------*/
+SDATA (DTP_POINTER,   "user_data",   0,      0,          "user data"),
+SDATA (DTP_POINTER,   "subscriber",  0,      0,          "subscriber of output-events"),
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *      GClass trace levels
+ *---------------------------------------------*/
+enum {
+    TRACE_MESSAGES = 0x0001,
+};
+PRIVATE const trace_level_t s_user_trace_level[16] = {
+    {"messages",    "Trace messages"},
+    {0, 0},
+};
+
+/*---------------------------------------------*
+ *              Private data
+ *---------------------------------------------*/
+typedef struct _PRIVATE_DATA {
+    hgobj timer;
+    hgobj gobj_output_side;
+    hgobj gobj_prot;            // C_PROT_MQTT2 of the client
+    hgobj gobj_tcp;             // its C_TCP
+    int connections;
+    const char **topics;        // topics of the current connection
+    int received;
+    BOOL done;
+} PRIVATE_DATA;
+
+
+
+
+                    /******************************
+                     *      Framework Methods
+                     ******************************/
+
+
+
+
+/***************************************************************************
+ *      Framework Method create
+ ***************************************************************************/
+PRIVATE void mt_create(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->timer = gobj_create_pure_child(gobj_name(gobj), C_TIMER, 0, gobj);
+}
+
+/***************************************************************************
+ *      Framework Method start
+ ***************************************************************************/
+PRIVATE int mt_start(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gobj_start(priv->timer);
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method stop
+ ***************************************************************************/
+PRIVATE int mt_stop(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gobj_stop(priv->timer);
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method play
+ ***************************************************************************/
+PRIVATE int mt_play(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->gobj_output_side = gobj_find_service("__output_side__", TRUE);
+    gobj_subscribe_event(priv->gobj_output_side, NULL, 0, gobj);
+
+    set_timeout(priv->timer, 500);
+
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method pause
+ ***************************************************************************/
+PRIVATE int mt_pause(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    clear_timeout(priv->timer);
+    return 0;
+}
+
+
+
+
+                    /***************************
+                     *      Local Methods
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Check a native stat of the client's C_PROT_MQTT2
+ ***************************************************************************/
+PRIVATE int check_stat(hgobj gobj, const char *name, json_int_t expected)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_int_t value = gobj_get_stat_slot(
+        priv->gobj_prot,
+        gobj_stat_slot(priv->gobj_prot, name)
+    );
+    if(value != expected) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_APP,
+            "msg",          "%s", "MQTT test FAILED: wrong alias stat",
+            "stat",         "%s", name,
+            "expected",     "%d", (int)expected,
+            "got",          "%d", (int)value,
+            "connection",   "%d", priv->connections,
+            NULL
+        );
+        return -1;
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Check the alias stats, cumulative over the connections
+ ***************************************************************************/
+PRIVATE void check_stats(
+    hgobj gobj,
+    json_int_t hits,
+    json_int_t misses,
+    json_int_t evictions,
+    json_int_t bytes_saved
+)
+{
+    check_stat(gobj, "txTopicAliasHits", hits);
+    check_stat(gobj, "txTopicAliasMisses", misses);
+    check_stat(gobj, "txTopicAliasEvictions", evictions);
+    check_stat(gobj, "txTopicAliasBytesSaved", bytes_saved);
+}
+
+
+
+
+                    /***************************
+                     *      Actions
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Timer fired: start the MQTT client tree (initiate TCP connection)
+ ***************************************************************************/
+PRIVATE int ac_connect(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gobj_start_tree(priv->gobj_output_side);
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  MQTT connected (CONNACK received): subscribe to "alias/#"
+ ***************************************************************************/
+PRIVATE int ac_on_open(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    /*
+     *  Chase down to the client's C_PROT_MQTT2, owner of the alias stats
+     */
+    hgobj prot = src;
+    while(prot && !gobj_typeof_gclass(prot, C_PROT_MQTT2)) {
+        prot = gobj_bottom_gobj(prot);
+    }
+    priv->gobj_prot = prot;
+    hgobj transport = prot;
+    while(transport && gobj_bottom_gobj(transport)) {
+        transport = gobj_bottom_gobj(transport);
+    }
+    priv->gobj_tcp = transport;
+    if(!priv->gobj_prot) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_APP,
+            "msg",          "%s", "MQTT test FAILED: C_PROT_MQTT2 not found",
+            NULL
+        );
+        set_yuno_must_die();
+        JSON_DECREF(kw)
+        return -1;
+    }
+
+    priv->connections++;
+    priv->topics = (priv->connections == 1)? topics1 : topics2;
+    priv->received = 0;
+
+    json_t *kw_sub = json_pack("{s:[s], s:i, s:i}",
+        "subs",     "alias/#",
+        "qos",      0,
+        "options",  0
+    );
+    json_t *kw_iev = iev_create(gobj, EV_MQTT_SUBSCRIBE, kw_sub);
+    gobj_send_event(priv->gobj_output_side, EV_SEND_IEV, kw_iev, gobj);
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  SUBACK received: publish the topics of this connection
+ ***************************************************************************/
+PRIVATE int ac_suback(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    for(int i=0; priv->topics[i]; i++) {
+        gbuffer_t *gbuf = gbuffer_create(16, 16);
+        gbuffer_printf(gbuf, "%d", i);
+
+        json_t *kw_pub = json_pack("{s:s, s:i, s:i, s:b, s:I}",
+            "topic",            priv->topics[i],
+            "qos",              0,
+            "expiry_interval",  0,
+            "retain",           0,
+            "gbuffer",          (json_int_t)(uintptr_t)gbuf
+        );
+        json_t *kw_iev = iev_create(gobj, EV_MQTT_PUBLISH, kw_pub);
+        gobj_send_event(priv->gobj_output_side, EV_SEND_IEV, kw_iev, gobj);
+    }
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  MQTT message received: the topic must be the published one,
+ *  whether it was sent with the topic, with the alias or re-mapped.
+ ***************************************************************************/
+PRIVATE int ac_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    const char *topic = kw_get_str(gobj, kw, "topic", "", 0);
+    const char *expected = priv->topics[priv->received];
+    if(!expected || strcmp(topic, expected) != 0) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_APP,
+            "msg",          "%s", "MQTT test FAILED: wrong topic",
+            "expected",     "%s", expected?expected:"",
+            "got",          "%s", topic,
+            "connection",   "%d", priv->connections,
+            NULL
+        );
+        priv->done = TRUE;
+        gobj_send_event(priv->gobj_output_side, EV_DROP, json_object(), gobj);
+        set_yuno_must_die();
+        KW_DECREF(kw)
+        return -1;
+    }
+    priv->received++;
+    if(priv->topics[priv->received]) {
+        KW_DECREF(kw)
+        return 0;
+    }
+
+    if(priv->connections == 1) {
+        /*
+         *  1 hit of alias/1, 4 misses, 2 aliases re-mapped
+         */
+        check_stats(gobj, 1, 4, 2, (json_int_t)strlen("alias/1"));
+
+        /*
+         *  Drop the link, the client's C_TCP reconnects
+         */
+        gobj_send_event(priv->gobj_tcp, EV_DROP, 0, gobj);
+
+    } else {
+        /*
+         *  alias/3 had an alias in the previous connection: a miss now
+         */
+        check_stats(gobj, 1, 5, 2, (json_int_t)strlen("alias/1"));
+
+        priv->done = TRUE;
+        gobj_send_event(priv->gobj_output_side, EV_DROP, json_object(), gobj);
+        set_yuno_must_die();
+    }
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  MQTT connection closed: expected after the first round
+ ***************************************************************************/
+PRIVATE int ac_on_close(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    BOOL round_done = priv->topics && !priv->topics[priv->received];
+    if(!priv->done && !(priv->connections == 1 && round_done)) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_APP,
+            "msg",          "%s", "MQTT test FAILED: connection closed before messages received",
+            "connection",   "%d", priv->connections,
+            NULL
+        );
+        priv->done = TRUE;
+        set_yuno_must_die();
+    }
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  QoS 0 publish-sent confirmation: ignore silently
+ ***************************************************************************/
+PRIVATE int ac_publish_sent(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Volatil child stopped: destroy it
+ ***************************************************************************/
+PRIVATE int ac_stopped(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    if(gobj_is_volatil(src)) {
+        gobj_destroy(src);
+    }
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+
+
+
+                    /***************************
+                     *      FSM
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE const GMETHODS gmt = {
+    .mt_create  = mt_create,
+    .mt_start   = mt_start,
+    .mt_stop    = mt_stop,
+    .mt_play    = mt_play,
+    .mt_pause   = mt_pause,
+};
+
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DEFINE_GCLASS(C_ALIAS);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int create_gclass(gclass_name_t gclass_name)
+{
+    static hgclass __gclass__ = 0;
+    if(__gclass__) {
+        gobj_log_error(0, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "GClass ALREADY created",
+            "gclass",       "%s", gclass_name,
+            NULL
+        );
+        return -1;
+    }
+
+    /*----------------------------------------*
+     *          Define States
+     *----------------------------------------*/
+    /*
+     *  ST_IDLE: waiting for timer to fire (start MQTT connection)
+     *           and then waiting for CONNACK (EV_ON_OPEN), also on reconnection
+     */
+    ev_action_t st_idle[] = {
+        {EV_TIMEOUT,            ac_connect,         0},             // start client
+        {EV_ON_OPEN,            ac_on_open,         ST_CONNECTED},  // CONNACK → subscribe
+        {EV_ON_CLOSE,           ac_on_close,        0},
+        {EV_STOPPED,            ac_stopped,         0},
+        {0, 0, 0}
+    };
+
+    /*
+     *  ST_CONNECTED: MQTT CONNACK received, do subscribe/publish/receive
+     */
+    ev_action_t st_connected[] = {
+        {EV_MQTT_SUBSCRIBE,     ac_suback,          0},             // SUBACK → publish
+        {EV_MQTT_PUBLISH,       ac_publish_sent,    0},             // QoS 0 send confirmation
+        {EV_MQTT_MESSAGE,       ac_message,         0},             // message → verify
+        {EV_ON_CLOSE,           ac_on_close,        ST_IDLE},       // wait the reconnection
+        {EV_STOPPED,            ac_stopped,         0},
+        {0, 0, 0}
+    };
+
+    states_t states[] = {
+        {ST_IDLE,               st_idle},
+        {ST_CONNECTED,          st_connected},
+        {0, 0}
+    };
+
+    event_type_t event_types[] = {
+        {EV_TIMEOUT,            0},
+        {EV_ON_OPEN,            0},
+        {EV_ON_CLOSE,           0},
+        {EV_MQTT_SUBSCRIBE,     0},
+        {EV_MQTT_PUBLISH,       0},
+        {EV_MQTT_MESSAGE,       0},
+        {EV_STOPPED,            0},
+        {0, 0}
+    };
+
+    /*----------------------------------------*
+     *          Create the gclass
+     *----------------------------------------*/
+    __gclass__ = gclass_create(
+        gclass_name,
+        event_types,
+        states,
+        &gmt,
+        0,              // lmt
+        attrs_table,
+        sizeof(PRIVATE_DATA),
+        0,              // authz_table
+        0,              // command_table
+        s_user_trace_level,
+        0               // gcflag_t
+    );
+    if(!__gclass__) {
+        // Error already logged
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC int register_c_alias(void)
+{
+    return create_gclass(C_ALIAS);
+}
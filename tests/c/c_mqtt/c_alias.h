@@ -0,0 +1,41 @@
+/****************************************************************************
+ *          C_ALIAS.H
+ *
+ *          Self-contained MQTT outgoing topic alias test GClass.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#pragma once
+
+#include <yunetas.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/***************************************************************
+ *              FSM
+ ***************************************************************/
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DECLARE_GCLASS(C_ALIAS);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+
+/***************************************************************
+ *              Prototypes
+ ***************************************************************/
+PUBLIC int register_c_alias(void);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,332 @@
+/****************************************************************************
+ *          MAIN_ALIAS.C
+ *
+ *          Self-contained MQTT broker + client test of the outgoing
+ *          topic aliases.
+ *
+ *          Test: LRU of the outgoing topic aliases of the client
+ *          - Embedded MQTT broker on port 18112, with max_topic_alias 2:
+ *            its CONNACK lets the client use 2 topic aliases.
+ *          - The client publishes to 3 topics: aliases assigned, used and
+ *            re-mapped (LRU), checked with the txTopicAlias* stats and the
+ *            topics received back. After a reconnection the aliases start
+ *            again.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#include <yunetas.h>
+#include <c_mqtt_broker.h>
+#include <c_prot_mqtt2.h>
+#include "c_alias.h"
+
+/***************************************************************************
+ *                      Names
+ ***************************************************************************/
+#define APP_NAME        "test_mqtt_" "alias"
+#define APP_DOC         "Self-contained MQTT outgoing topic alias test"
+
+#define APP_VERSION     "1.0.0"
+#define APP_SUPPORT     "<support@artgins.com>"
+#define APP_DATETIME    __DATE__ " " __TIME__
+
+#define USE_OWN_SYSTEM_MEMORY   FALSE
+#define MEM_MIN_BLOCK           0
+#define MEM_MAX_BLOCK           0
+#define MEM_SUPERBLOCK          0
+#define MEM_MAX_SYSTEM_MEMORY   0
+
+/*
+ *  Default test port — change this define to use a different port
+ */
+#define MQTT_TEST_PORT  "18112"
+
+/***************************************************************************
+ *                      Default config
+ ***************************************************************************/
+PRIVATE char fixed_config[]= "\
+{                                                                   \n\
+    'yuno': {                                                       \n\
+        'yuno_role': '"APP_NAME"',                                  \n\
+        'tags': ['test', 'yunetas']                                 \n\
+    }                                                               \n\
+}                                                                   \n\
+";
+
+PRIVATE char variable_config[]= "\
+{                                                                   \n\
+    'environment': {                                                \n\
+        'work_dir': '/tmp',                                         \n\
+        'console_log_handlers': {                                   \n\
+        },                                                          \n\
+        'daemon_log_handlers': {                                    \n\
+        }                                                           \n\
+    },                                                              \n\
+    'yuno': {                                                       \n\
+        'autoplay': true,                                           \n\
+        'required_services': [],                                    \n\
+        'public_services': [],                                      \n\
+        'service_descriptor': {                                     \n\
+        },                                                          \n\
+        'realm_owner': 'test',                                      \n\
+        'realm_id':    'test',                                      \n\
+        'trace_levels': {                                           \n\
+        }                                                           \n\
+    },                                                              \n\
+    'global': {                                                     \n\
+        'Authz.allow_anonymous_in_localhost': true,                 \n\
+        '__input_side__.__json_config_variables__': {               \n\
+            '__input_url__':  'mqtt://0.0.0.0:"MQTT_TEST_PORT"',   \n\
+            '__input_host__': '0.0.0.0',                           \n\
+            '__input_port__': '"MQTT_TEST_PORT"'                    \n\
+        }                                                           \n\
+    },                                                              \n\
+    'services': [                                                   \n\
+        {                                                           \n\
+            'name': 'authz',                                        \n\
+            'gclass': 'C_AUTHZ',                                    \n\
+            'priority': 0,                                          \n\
+            'default_service': false,                               \n\
+            'autostart': true,                                      \n\
+            'autoplay': true                                        \n\
+        },                                                          \n\
+        {                                                           \n\
+            'name': 'mqtt_broker',                                  \n\
+            'gclass': 'C_MQTT_BROKER',                              \n\
+            'default_service': false,                               \n\
+            'autostart': true,                                      \n\
+            'autoplay': true,                                       \n\
+            'kw': {                                                 \n\
+                'enable_new_clients': true                          \n\
+            }                                                       \n\
+        },                                                          \n\
+        {                                                           \n\
+            'name': 'c_alias',                                      \n\
+            'gclass': 'C_ALIAS',                                    \n\
+            'default_service': true,                                \n\
+            'autostart': true,                                      \n\
+            'autoplay': false,                                      \n\
+            'kw': {                                                 \n\
+            }                                                       \n\
+        },                                                          \n\
+        {                                                           \n\
+            'name': '__input_side__',                               \n\
+            'gclass': 'C_IOGATE',                                   \n\
+            'autostart': true,                                      \n\
+            'autoplay': false,                                      \n\
+            'kw': {                                                 \n\
+            },                                                      \n\
+            'children': [                                           \n\
+                {                                                   \n\
+                    'name': 'server_port',                          \n\
+                    'gclass': 'C_TCP_S',                            \n\
+                    'kw': {                                         \n\
+                        'url': '(^^__input_url__^^)',               \n\
+                        'backlog': 4,                               \n\
+                        'use_dups': 0                               \n\
+                    }                                               \n\
+                }                                                   \n\
+            ],                                                      \n\
+            '[^^children^^]': {                                     \n\
+                '__range__': [1, 4],                                \n\
+                '__vars__': {                                       \n\
+                },                                                  \n\
+                '__content__': {                                    \n\
+                    'name': '(^^__input_port__^^)-(^^__range__^^)', \n\
+                    'gclass': 'C_CHANNEL',                          \n\
+                    'children': [                                   \n\
+                        {                                           \n\
+                            'name': '(^^__input_port__^^)-(^^__range__^^)', \n\
+                            'gclass': 'C_PROT_MQTT2',               \n\
+                            'kw': {                                 \n\
+                                'iamServer': true,                  \n\
+                                'max_topic_alias': 2                \n\
+                            },                                      \n\
+                            'children': [                           \n\
+                                {                                   \n\
+                                    'gclass': 'C_TCP'               \n\
+                                }                                   \n\
+                            ]                                       \n\
+                        }                                           \n\
+                    ]                                               \n\
+                }                                                   \n\
+            }                                                       \n\
+        },                                                          \n\
+        {                                                           \n\
+            'name': '__output_side__',                              \n\
+            'gclass': 'C_IOGATE',                                   \n\
+            'autostart': false,                                     \n\
+            'autoplay': false,                                      \n\
+            'children': [                                           \n\
+                {                                                   \n\
+                    'name': 'mqtt_client',                          \n\
+                    'gclass': 'C_CHANNEL',                          \n\
+                    'children': [                                   \n\
+                        {                                           \n\
+                            'name': 'mqtt_client',                  \n\
+                            'gclass': 'C_PROT_MQTT2',               \n\
+                            'kw': {                                 \n\
+                                'iamServer': false,                 \n\
+                                'mqtt_client_id': 'test_client_alias' \n\
+                            },                                      \n\
+                            'children': [                           \n\
+                                {                                   \n\
+                                    'name': 'mqtt_client',          \n\
+                                    'gclass': 'C_TCP',              \n\
+                                    'kw': {                         \n\
+                                        'url': 'tcp://127.0.0.1:"MQTT_TEST_PORT"', \n\
+                                        'timeout_between_connections': 300 \n\
+                                    }                               \n\
+                                }                                   \n\
+                            ]                                       \n\
+                        }                                           \n\
+                    ]                                               \n\
+                }                                                   \n\
+            ]                                                       \n\
+        },                                                          \n\
+        {                                                           \n\
+            'name': '__top_side__',                                 \n\
+            'gclass': 'C_IOGATE',                                   \n\
+            'autostart': false,                                     \n\
+            'autoplay': false,                                      \n\
+            'kw': {                                                 \n\
+            }                                                       \n\
+        }                                                           \n\
+    ]                                                               \n\
+}                                                                   \n\
+";
+
+/***************************************************************************
+ *  Authz checker: allow everything in the self-contained test
+ ***************************************************************************/
+PRIVATE BOOL test_authz_checker(hgobj gobj, const char *authz, json_t *kw, hgobj src)
+{
+    KW_DECREF(kw)
+    return TRUE;
+}
+
+time_measure_t time_measure;
+
+/***************************************************************************
+ *  HACK: runs on yunetas environment BEFORE creating the yuno
+ ***************************************************************************/
+int result = 0;
+
+static int register_yuno_and_more(void)
+{
+    int res = 0;
+
+    /*--------------------*
+     *  Register gclasses
+     *--------------------*/
+    res += register_c_mqtt_broker();
+    res += register_c_prot_mqtt2();
+    res += register_c_alias();
+
+    /*------------------------------------------------*
+     *  Suppress noisy traces
+     *------------------------------------------------*/
+    gobj_set_gclass_no_trace(gclass_find_by_name(C_TIMER0), "machine", TRUE);
+    gobj_set_gclass_no_trace(gclass_find_by_name(C_TIMER),  "machine", TRUE);
+    gobj_set_global_no_trace("timer_periodic", TRUE);
+
+    /*------------------------------------------------*
+     *  Safety: kill the yuno after 10 s if stuck
+     *------------------------------------------------*/
+    set_auto_kill_time(10);
+
+    /*------------------------------*
+     *  Capture only errors
+     *------------------------------*/
+    set_expected_results(
+        APP_NAME,
+        json_array(),   // empty — we expect no errors
+        NULL,           // no JSON comparison
+        NULL,           // no ignore_keys
+        TRUE            // verbose
+    );
+
+    MT_START_TIME(time_measure)
+
+    return res;
+}
+
+/***************************************************************************
+ *  HACK: runs on yunetas environment BEFORE destroying the yuno
+ ***************************************************************************/
+static void cleaning(void)
+{
+    MT_INCREMENT_COUNT(time_measure, 1)
+    MT_PRINT_TIME(time_measure, APP_NAME)
+
+    result += test_json(NULL);  // check captured error log
+}
+
+/***************************************************************************
+ *                      Main
+ ***************************************************************************/
+int main(int argc, char *argv[])
+{
+    /*------------------------------*
+     *  Init logger
+     *------------------------------*/
+    glog_init();
+
+    gobj_log_add_handler("stdout", "stdout", LOG_OPT_ALL, 0);
+
+    /*
+     *  Capture only ERROR+ logs for test verification.
+     *  Any unexpected error log will fail the test.
+     */
+    gobj_log_register_handler(
+        "testing",          // handler_name
+        0,                  // close_fn
+        capture_log_write,  // write_fn
+        0                   // fwrite_fn
+    );
+    gobj_log_add_handler("test_capture", "testing", LOG_OPT_UP_ERROR, 0);
+
+    /*------------------------------------------------*
+     *      Memory leak check
+     *------------------------------------------------*/
+    unsigned long memory_check_list[] = {0, 0};
+    set_memory_check_list(memory_check_list);
+
+    /*------------------------------------------------*
+     *          Start yuneta
+     *------------------------------------------------*/
+    helper_quote2doublequote(fixed_config);
+    helper_quote2doublequote(variable_config);
+    yuneta_setup(
+        NULL,       // persistent_attrs
+        NULL,       // command_parser
+        NULL,       // stats_parser
+        test_authz_checker, // authz_checker: allow all in self-contained test
+        NULL,       // authentication_parser
+        MEM_MAX_BLOCK,
+        MEM_MAX_SYSTEM_MEMORY,
+        USE_OWN_SYSTEM_MEMORY,
+        MEM_MIN_BLOCK,
+        MEM_SUPERBLOCK
+    );
+
+    result += yuneta_entry_point(
+        argc, argv,
+        APP_NAME, APP_VERSION, APP_SUPPORT, APP_DOC, APP_DATETIME,
+        fixed_config,
+        variable_config,
+        register_yuno_and_more,
+        cleaning
+    );
+
+    if(get_cur_system_memory() != 0) {
+        printf("%sERROR --> %s%s\n", On_Red BWhite, "system memory not free", Color_Off);
+        print_track_mem();
+        result += -1;
+    }
+
+    if(result < 0) {
+        printf("<-- %sTEST FAILED%s: %s\n", On_Red BWhite, Color_Off, APP_NAME);
+    }
+    return result < 0 ? -1 : 0;
+}
@@ -0,0 +1,474 @@
+/***********************************************************************
+ *          C_DBA_COPY.C
+ *
+ *          Test of the append only tables of C_DBA_POSTGRES (yuno
+ *          dba_postgres), with its C_POSTGRES against C_FAKE_PG.
+ *          This gclass is its __input_side__: it sends the messages of
+ *          the queue and keeps the acks.
+ *
+ *          What must hold (copy_max_rows 2):
+ *
+ *      1) The rows batched are inserted with a COPY, and acked when
+ *         the COPY is done.
+ *
+ *      2) A COPY failed (a bad row fails all of them) is not lost: the
+ *         rows are inserted one by one with the prepared INSERT, each
+ *         acked by its result.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ***********************************************************************/
+#include <string.h>
+#include <unistd.h>
+
+#include <c_postgres.h>
+#include "c_fake_pg.h"
+#include "c_dba_copy.h"
+
+/***************************************************************************
+ *              Constants
+ ***************************************************************************/
+#define STEP_TIMEOUT    5*1000
+#define STEP_END        3
+
+/***************************************************************************
+ *              Structures
+ ***************************************************************************/
+
+/***************************************************************************
+ *              Prototypes
+ ***************************************************************************/
+PRIVATE int check(hgobj gobj, BOOL ok, const char *what);
+
+/***************************************************************************
+ *          Data: config, public data, private data
+ ***************************************************************************/
+/*---------------------------------------------*
+ *      Attributes
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t attrs_table[] = {
+/*-ATTR-type------------name----------------flag----------------default-----description--*/
+SDATA (DTP_POINTER,     "subscriber",       0,                  0,          "Subscriber of output-events"),
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *      GClass trace levels
+ *---------------------------------------------*/
+PRIVATE const trace_level_t s_user_trace_level[16] = {
+{0, 0},
+};
+
+/*---------------------------------------------*
+ *      GClass authz levels
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t authz_table[] = {
+/*-AUTHZ-- type---------name----------------flag----alias---items---description--*/
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *              Private data
+ *---------------------------------------------*/
+typedef struct _PRIVATE_DATA {
+    hgobj timer;
+    hgobj gobj_server;              // C_FAKE_PG
+    hgobj gobj_postgres;            // __postgres__ service of the dba
+    char url[PATH_MAX + 128];
+    json_t *jn_schema;              // append only table
+    json_t *jn_acks;                // __msg_key__ of the acks, in order
+
+    int step;
+    uint64_t t_step;
+    int result;
+} PRIVATE_DATA;
+
+
+
+
+                    /******************************
+                     *      Framework Methods
+                     ******************************/
+
+
+
+
+/***************************************************************************
+ *      Framework Method create
+ ***************************************************************************/
+PRIVATE void mt_create(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->jn_acks = json_array();
+    priv->jn_schema = json_pack("{s:s, s:s, s:b, s:b, s:{s:{s:s, s:s}}}",
+        "id", "tracks",
+        "pkey", "",
+        "use_header", 0,
+        "append_only", 1,
+        "cols",
+            "v", "header", "v", "type", "str"
+    );
+    priv->timer = gobj_create_pure_child(gobj_name(gobj), C_TIMER, 0, gobj);
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "/tmp/yuneta_test_pg_%d", (int)getpid());
+
+    json_t *kw_server = json_pack("{s:s}",
+        "path", path
+    );
+    priv->gobj_server = gobj_create_pure_child("server", C_FAKE_PG, kw_server, gobj);
+
+    snprintf(priv->url, sizeof(priv->url),
+        "postgresql:///test?host=%s&port=5432&user=test&sslmode=disable&gssencmode=disable",
+        path
+    );
+
+    /*
+     *  SERVICE subscription model
+     */
+    hgobj subscriber = (hgobj)gobj_read_pointer_attr(gobj, "subscriber");
+    if(subscriber) {
+        gobj_subscribe_event(gobj, NULL, NULL, subscriber);
+    }
+}
+
+/***************************************************************************
+ *      Framework Method destroy
+ ***************************************************************************/
+PRIVATE void mt_destroy(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    JSON_DECREF(priv->jn_schema)
+    JSON_DECREF(priv->jn_acks)
+}
+
+/***************************************************************************
+ *      Framework Method start
+ *
+ *  Started by the dba before its __postgres__, the server is a child:
+ *  it's listening when __postgres__ connects.
+ ***************************************************************************/
+PRIVATE int mt_start(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->gobj_postgres = gobj_find_service("__postgres__", TRUE);
+    gobj_write_str_attr(priv->gobj_postgres, "url", priv->url);
+
+    priv->t_step = start_msectimer(STEP_TIMEOUT);
+    set_timeout_periodic(priv->timer, 10);
+
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method stop
+ ***************************************************************************/
+PRIVATE int mt_stop(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    clear_timeout(priv->timer);
+    if(gobj_is_running(priv->timer)) {
+        gobj_stop(priv->timer);
+    }
+    if(gobj_is_running(priv->gobj_server)) {
+        gobj_stop(priv->gobj_server);
+    }
+    return 0;
+}
+
+
+
+
+                    /***************************
+                     *      Local Methods
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int check(hgobj gobj, BOOL ok, const char *what)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(ok) {
+        return 0;
+    }
+    gobj_log_error(gobj, 0,
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_INTERNAL,
+        "msg",          "%s", "dba copy check FAILED",
+        "what",         "%s", what,
+        "step",         "%d", priv->step,
+        NULL
+    );
+    priv->result--;
+    return -1;
+}
+
+/***************************************************************************
+ *  Message of the queue to the dba, as the input gate does
+ ***************************************************************************/
+PRIVATE void send_msg(hgobj gobj, json_int_t msg_key, const char *value)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    char id[32];
+    snprintf(id, sizeof(id), "m%d", (int)msg_key);
+
+    json_t *jn_msg = json_pack("{s:s, s:s, s:{s:I}, s:{s:O}}",
+        "id", id,
+        "v", value,
+        "__md_trq__", "__msg_key__", msg_key,
+        "_dba_postgres", "schema", priv->jn_schema
+    );
+    gbuffer_t *gbuf = json2gbuf(0, jn_msg, JSON_COMPACT);
+
+    json_t *kw = json_pack("{s:I, s:{s:I}}",
+        "gbuffer", (json_int_t)(uintptr_t)gbuf,
+        "__temp__",
+            "channel_gobj", (json_int_t)(uintptr_t)gobj
+    );
+    gobj_publish_event(gobj, EV_ON_MESSAGE, kw);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE BOOL acked(hgobj gobj, size_t idx, json_int_t msg_key)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    return json_integer_value(json_array_get(priv->jn_acks, idx)) == msg_key;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int received(hgobj gobj, const char *msg)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    return fake_pg_count(priv->gobj_server, msg);
+}
+
+/***************************************************************************
+ *  Do the step if what it waits is done, return TRUE to go to the next one
+ ***************************************************************************/
+PRIVATE BOOL run_step(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    switch(priv->step) {
+        case 0:
+            /*
+             *  1) COPY of the rows batched
+             */
+            if(!gobj_in_this_state(priv->gobj_postgres, ST_CONNECTED)) {
+                return FALSE;
+            }
+            send_msg(gobj, 1, "1");
+            send_msg(gobj, 2, "2");
+            return TRUE;
+
+        case 1:
+            if(json_array_size(priv->jn_acks) < 2) {
+                return FALSE;
+            }
+            check(gobj, acked(gobj, 0, 1) && acked(gobj, 1, 2), "copy: rows acked");
+            check(gobj, received(gobj, "c") == 1, "copy: one COPY");
+            check(gobj, strcmp(fake_pg_copy_data(priv->gobj_server), "1\n2\n")==0, "copy: data");
+            check(gobj, received(gobj, "E") == 0, "copy: no INSERT");
+            if(priv->result == 0) {
+                gobj_log_info(gobj, 0,
+                    "msgset",       "%s", MSGSET_INFO,
+                    "msg",          "%s", "copy ok",
+                    NULL
+                );
+            }
+
+            /*
+             *  2) COPY failed by a bad row
+             */
+            send_msg(gobj, 3, "3");
+            send_msg(gobj, 4, "FAIL");
+            return TRUE;
+
+        case 2:
+            if(json_array_size(priv->jn_acks) < 4) {
+                return FALSE;
+            }
+            check(gobj, acked(gobj, 2, 3) && acked(gobj, 3, 4), "fallback: rows acked");
+            check(gobj, received(gobj, "c") == 2, "fallback: the COPY was sent");
+            check(gobj, received(gobj, "P:yp1") == 1, "fallback: INSERT prepared once");
+            check(gobj, received(gobj, "B:yp1") == 2, "fallback: an INSERT by row");
+            if(priv->result == 0) {
+                gobj_log_info(gobj, 0,
+                    "msgset",       "%s", MSGSET_INFO,
+                    "msg",          "%s", "copy fallback ok",
+                    NULL
+                );
+            }
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
+
+
+
+                    /***************************
+                     *      Actions
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Go on with the steps
+ ***************************************************************************/
+PRIVATE int ac_timeout(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    while(priv->step < STEP_END && run_step(gobj)) {
+        priv->step++;
+        priv->t_step = start_msectimer(STEP_TIMEOUT);
+    }
+
+    if(priv->step < STEP_END && test_msectimer(priv->t_step)) {
+        check(gobj, FALSE, "step timeout");
+        priv->step = STEP_END;
+    }
+
+    if(priv->step == STEP_END) {
+        clear_timeout(priv->timer);
+        set_yuno_must_die();
+    }
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Ack of the dba, keep its __msg_key__
+ ***************************************************************************/
+PRIVATE int ac_send_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gbuffer_t *gbuf = gobj_event_gbuffer(gobj, kw);
+    json_t *jn_ack = gbuf? gbuf2json(gbuffer_incref(gbuf), 2) : NULL;
+    json_array_append_new(priv->jn_acks,
+        json_integer(kw_get_int(gobj, jn_ack, "__md_trq__`__msg_key__", 0, KW_REQUIRED))
+    );
+    JSON_DECREF(jn_ack)
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *                          FSM
+ ***************************************************************************/
+/*---------------------------------------------*
+ *          Global methods table
+ *---------------------------------------------*/
+PRIVATE const GMETHODS gmt = {
+    .mt_create  = mt_create,
+    .mt_destroy = mt_destroy,
+    .mt_start   = mt_start,
+    .mt_stop    = mt_stop,
+};
+
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DEFINE_GCLASS(C_DBA_COPY);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+
+/***************************************************************************
+ *          Create the GClass
+ ***************************************************************************/
+PRIVATE int create_gclass(gclass_name_t gclass_name)
+{
+    static hgclass __gclass__ = 0;
+    if(__gclass__) {
+        gobj_log_error(0, 0,
+            "function", "%s", __FUNCTION__,
+            "msgset",   "%s", MSGSET_INTERNAL,
+            "msg",      "%s", "GClass ALREADY created",
+            "gclass",   "%s", gclass_name,
+            NULL
+        );
+        return -1;
+    }
+
+    /*------------------------*
+     *      States
+     *------------------------*/
+    ev_action_t st_idle[] = {
+        {EV_TIMEOUT_PERIODIC,       ac_timeout,             0},
+        {EV_SEND_MESSAGE,           ac_send_message,        0},
+        {0,0,0}
+    };
+
+    states_t states[] = {
+        {ST_IDLE,       st_idle},
+        {0, 0}
+    };
+
+    /*------------------------*
+     *      Events
+     *------------------------*/
+    event_type_t event_types[] = {
+        {EV_TIMEOUT_PERIODIC,       0},
+        {EV_SEND_MESSAGE,           0},
+        {EV_ON_MESSAGE,             EVF_OUTPUT_EVENT},
+        {NULL, 0}
+    };
+
+    /*----------------------------------------*
+     *          Register GClass
+     *----------------------------------------*/
+    __gclass__ = gclass_create(
+        gclass_name,
+        event_types,
+        states,
+        &gmt,
+        0, // local methods
+        attrs_table,
+        sizeof(PRIVATE_DATA),
+        authz_table,
+        0, // command_table
+        s_user_trace_level,
+        0 // gcflags
+    );
+    if(!__gclass__) {
+        // Error already logged
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *              Public access
+ ***************************************************************************/
+PUBLIC int register_c_dba_copy(void)
+{
+    return create_gclass(C_DBA_COPY);
+}
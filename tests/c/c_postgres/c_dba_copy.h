@@ -0,0 +1,40 @@
+/****************************************************************************
+ *          C_DBA_COPY.H
+ *
+ *          A gclass to test the COPY of C_DBA_POSTGRES, as its __input_side__
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#pragma once
+
+#include <yunetas.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/***************************************************************
+ *              FSM
+ ***************************************************************/
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DECLARE_GCLASS(C_DBA_COPY);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+
+/***************************************************************
+ *              Prototypes
+ ***************************************************************/
+PUBLIC int register_c_dba_copy(void);
+
+#ifdef __cplusplus
+}
+#endif
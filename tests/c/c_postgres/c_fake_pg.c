@@ -0,0 +1,664 @@
+/***********************************************************************
+ *          C_FAKE_PG.C
+ *
+ *          Postgres server of the tests, listening in the unix socket
+ *          `path`/.s.PGSQL.5432, one client at a time. Served from a
+ *          periodic timer with non blocking sockets, in the yuno's loop.
+ *
+ *          Answers of the protocol v3:
+ *              startup         AuthenticationOk, ParameterStatus,
+ *                              BackendKeyData, ReadyForQuery
+ *              Parse           ParseComplete, ErrorResponse if the sql
+ *                              has "FAIL" (the messages are skipped until Sync)
+ *              Bind            BindComplete
+ *              Describe        NoData
+ *              Execute         CommandComplete "INSERT 0 1"
+ *              Sync            ReadyForQuery
+ *              Query           "COPY ..." CopyInResponse, else
+ *                              CommandComplete and ReadyForQuery
+ *              CopyDone        CommandComplete "COPY <lines>", ErrorResponse
+ *                              if the data has "FAIL", and ReadyForQuery
+ *
+ *          With `hold` the answers are kept, they are sent when released.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ***********************************************************************/
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+#include "c_fake_pg.h"
+
+/***************************************************************************
+ *              Constants
+ ***************************************************************************/
+#define PG_SSL_REQUEST      80877103
+#define PG_GSSENC_REQUEST   80877104
+
+/***************************************************************************
+ *              Structures
+ ***************************************************************************/
+
+/***************************************************************************
+ *              Prototypes
+ ***************************************************************************/
+PRIVATE void close_client(hgobj gobj);
+PRIVATE void serve(hgobj gobj);
+
+/***************************************************************************
+ *          Data: config, public data, private data
+ ***************************************************************************/
+/*---------------------------------------------*
+ *      Attributes
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t attrs_table[] = {
+/*-ATTR-type------------name----------------flag----------------default-----description--*/
+SDATA (DTP_STRING,      "path",             SDF_RD|SDF_REQUIRED,"",         "Directory of the unix socket, created and removed here"),
+SDATA (DTP_BOOLEAN,     "hold",             SDF_WR,             0,          "Keep the answers, don't send them"),
+SDATA (DTP_INTEGER,     "connections",      SDF_RD,             "0",        "Clients accepted"),
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *      GClass trace levels
+ *---------------------------------------------*/
+PRIVATE const trace_level_t s_user_trace_level[16] = {
+{0, 0},
+};
+
+/*---------------------------------------------*
+ *              Private data
+ *---------------------------------------------*/
+typedef struct _PRIVATE_DATA {
+    hgobj timer;
+    char socket_path[PATH_MAX];
+    int fd_listen;
+    int fd_client;
+
+    BOOL started_up;        // startup message received
+    BOOL skip_to_sync;      // error in the extended query, skip until Sync
+    gbuffer_t *gbuf_rx;
+    gbuffer_t *gbuf_tx;
+    gbuffer_t *gbuf_copy;
+    json_t *jn_log;
+} PRIVATE_DATA;
+
+
+
+
+                    /******************************
+                     *      Framework Methods
+                     ******************************/
+
+
+
+
+/***************************************************************************
+ *      Framework Method create
+ ***************************************************************************/
+PRIVATE void mt_create(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->timer = gobj_create_pure_child(gobj_name(gobj), C_TIMER, 0, gobj);
+    priv->fd_listen = -1;
+    priv->fd_client = -1;
+    priv->gbuf_rx = gbuffer_create(4*1024, 1024*1024);
+    priv->gbuf_tx = gbuffer_create(4*1024, 1024*1024);
+    priv->gbuf_copy = gbuffer_create(4*1024, 1024*1024);
+    priv->jn_log = json_array();
+
+    snprintf(priv->socket_path, sizeof(priv->socket_path), "%s/.s.PGSQL.5432",
+        gobj_read_str_attr(gobj, "path")
+    );
+}
+
+/***************************************************************************
+ *      Framework Method destroy
+ ***************************************************************************/
+PRIVATE void mt_destroy(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    GBUFFER_DECREF(priv->gbuf_rx)
+    GBUFFER_DECREF(priv->gbuf_tx)
+    GBUFFER_DECREF(priv->gbuf_copy)
+    JSON_DECREF(priv->jn_log)
+}
+
+/***************************************************************************
+ *      Framework Method start
+ ***************************************************************************/
+PRIVATE int mt_start(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    const char *path = gobj_read_str_attr(gobj, "path");
+    mkdir(path, 0700);
+    unlink(priv->socket_path);
+
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", priv->socket_path);
+
+    priv->fd_listen = socket(AF_UNIX, SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC, 0);
+    if(priv->fd_listen < 0 ||
+            bind(priv->fd_listen, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+            listen(priv->fd_listen, 4) < 0) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_SYSTEM,
+            "msg",          "%s", "Cannot listen in the unix socket",
+            "path",         "%s", priv->socket_path,
+            "errno",        "%s", strerror(errno),
+            NULL
+        );
+        if(priv->fd_listen >= 0) {
+            close(priv->fd_listen);
+            priv->fd_listen = -1;
+        }
+        return -1;
+    }
+
+    set_timeout_periodic(priv->timer, 5);
+
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method stop
+ ***************************************************************************/
+PRIVATE int mt_stop(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    clear_timeout(priv->timer);
+    if(gobj_is_running(priv->timer)) {
+        gobj_stop(priv->timer);
+    }
+
+    close_client(gobj);
+    if(priv->fd_listen >= 0) {
+        close(priv->fd_listen);
+        priv->fd_listen = -1;
+    }
+    unlink(priv->socket_path);
+    rmdir(gobj_read_str_attr(gobj, "path"));
+
+    return 0;
+}
+
+
+
+
+                    /***************************
+                     *      Local Methods
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void close_client(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->fd_client >= 0) {
+        close(priv->fd_client);
+        priv->fd_client = -1;
+    }
+    priv->started_up = FALSE;
+    priv->skip_to_sync = FALSE;
+    gbuffer_reset_wr(priv->gbuf_rx);
+    gbuffer_reset_wr(priv->gbuf_tx);
+}
+
+/***************************************************************************
+ *  Message of the server: type, length (itself included) and body
+ ***************************************************************************/
+PRIVATE void send_msg(hgobj gobj, char type, const void *body, size_t len)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    uint32_t n = htonl((uint32_t)(len + 4));
+    gbuffer_append_char(priv->gbuf_tx, (uint8_t)type);
+    gbuffer_append(priv->gbuf_tx, &n, 4);
+    if(len > 0) {
+        gbuffer_append(priv->gbuf_tx, (void *)body, len);
+    }
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void send_str_msg(hgobj gobj, char type, const char *s)
+{
+    send_msg(gobj, type, s, strlen(s) + 1);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void send_parameter_status(hgobj gobj, const char *name, const char *value)
+{
+    char bf[128];
+    size_t ln = (size_t)snprintf(bf, sizeof(bf), "%s%c%s", name, 0, value) + 1;
+    send_msg(gobj, 'S', bf, ln);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void send_error(hgobj gobj, const char *message)
+{
+    char bf[256];
+    size_t ln = (size_t)snprintf(bf, sizeof(bf), "SERROR%cVERROR%cC42601%cM%s%c",
+        0, 0, 0, message, 0
+    );
+    bf[ln++] = 0;   // end of the fields
+    send_msg(gobj, 'E', bf, ln);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void send_ready(hgobj gobj)
+{
+    send_msg(gobj, 'Z', "I", 1);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void log_msg(hgobj gobj, const char *prefix, const char *s)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_array_append_new(priv->jn_log, json_sprintf("%s%s", prefix, s?s:""));
+}
+
+/***************************************************************************
+ *  Startup packet: no type, length and protocol code
+ ***************************************************************************/
+PRIVATE void process_startup(hgobj gobj, uint32_t code)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(code == PG_SSL_REQUEST || code == PG_GSSENC_REQUEST) {
+        gbuffer_append_char(priv->gbuf_tx, 'N');
+        return;
+    }
+
+    priv->started_up = TRUE;
+
+    uint32_t auth_ok = 0;
+    send_msg(gobj, 'R', &auth_ok, 4);
+    send_parameter_status(gobj, "server_version", "16.0");
+    send_parameter_status(gobj, "server_encoding", "UTF8");
+    send_parameter_status(gobj, "client_encoding", "UTF8");
+    send_parameter_status(gobj, "standard_conforming_strings", "on");
+    send_parameter_status(gobj, "integer_datetimes", "on");
+    send_parameter_status(gobj, "DateStyle", "ISO, MDY");
+    uint32_t key[2] = {htonl((uint32_t)getpid()), htonl(1)};
+    send_msg(gobj, 'K', key, sizeof(key));
+    send_ready(gobj);
+}
+
+/***************************************************************************
+ *  Message of the client
+ ***************************************************************************/
+PRIVATE void process_msg(hgobj gobj, char type, char *body, size_t len)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    switch(type) {
+        case 'P': // Parse: statement, query, parameter types
+            log_msg(gobj, "P:", body);
+            if(priv->skip_to_sync) {
+                break;
+            }
+            if(strstr(body + strlen(body) + 1, "FAIL")) {
+                send_error(gobj, "syntax error at or near \"FAIL\"");
+                priv->skip_to_sync = TRUE;
+                break;
+            }
+            send_msg(gobj, '1', NULL, 0);
+            break;
+
+        case 'B': // Bind: portal, statement, ...
+            log_msg(gobj, "B:", body + strlen(body) + 1);
+            if(priv->skip_to_sync) {
+                break;
+            }
+            send_msg(gobj, '2', NULL, 0);
+            break;
+
+        case 'D': // Describe
+            if(priv->skip_to_sync) {
+                break;
+            }
+            send_msg(gobj, 'n', NULL, 0);
+            break;
+
+        case 'E': // Execute
+            log_msg(gobj, "E", NULL);
+            if(priv->skip_to_sync) {
+                break;
+            }
+            send_str_msg(gobj, 'C', "INSERT 0 1");
+            break;
+
+        case 'S': // Sync
+            log_msg(gobj, "S", NULL);
+            priv->skip_to_sync = FALSE;
+            send_ready(gobj);
+            break;
+
+        case 'H': // Flush
+            break;
+
+        case 'Q': // Simple query
+            log_msg(gobj, "Q:", body);
+            if(strncmp(body, "COPY", 4)==0) {
+                gbuffer_reset_wr(priv->gbuf_copy);
+                char copy_in[3] = {0, 0, 0}; // text format, no columns
+                send_msg(gobj, 'G', copy_in, sizeof(copy_in));
+                break;
+            }
+            send_str_msg(gobj, 'C', "SELECT 0");
+            send_ready(gobj);
+            break;
+
+        case 'd': // CopyData
+            gbuffer_append(priv->gbuf_copy, body, len);
+            break;
+
+        case 'c': // CopyDone
+            {
+                log_msg(gobj, "c", NULL);
+                const char *data = gbuffer_cur_rd_pointer(priv->gbuf_copy); // nul-terminated
+                if(strstr(data, "FAIL")) {
+                    send_error(gobj, "invalid input syntax: \"FAIL\"");
+                } else {
+                    int lines = 0;
+                    for(const char *p = data; *p; p++) {
+                        if(*p == '\n') {
+                            lines++;
+                        }
+                    }
+                    char tag[32];
+                    snprintf(tag, sizeof(tag), "COPY %d", lines);
+                    send_str_msg(gobj, 'C', tag);
+                }
+                send_ready(gobj);
+            }
+            break;
+
+        case 'f': // CopyFail
+            send_error(gobj, "COPY from stdin failed");
+            send_ready(gobj);
+            break;
+
+        case 'X': // Terminate
+            close_client(gobj);
+            break;
+
+        default:
+            gobj_log_error(gobj, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PROTOCOL,
+                "msg",          "%s", "Postgres message NOT SUPPORTED",
+                "type",         "%c", type,
+                NULL
+            );
+            break;
+    }
+}
+
+/***************************************************************************
+ *  Process the complete messages received
+ ***************************************************************************/
+PRIVATE void process_rx(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    while(priv->fd_client >= 0) {
+        size_t left = gbuffer_leftbytes(priv->gbuf_rx);
+        uint8_t *p = gbuffer_cur_rd_pointer(priv->gbuf_rx);
+        size_t header = priv->started_up? 5 : 4;
+        if(left < header) {
+            break;
+        }
+        uint32_t n;
+        memcpy(&n, p + header - 4, 4);
+        size_t len = ntohl(n);         // itself included
+        if(len < 4 || left < header - 4 + len) {
+            break;
+        }
+        gbuffer_get(priv->gbuf_rx, header - 4 + len);
+
+        if(!priv->started_up) {
+            uint32_t code;
+            memcpy(&code, p + 4, 4);
+            process_startup(gobj, ntohl(code));
+        } else {
+            process_msg(gobj, (char)p[0], (char *)p + 5, len - 4);
+        }
+    }
+    if(gbuffer_leftbytes(priv->gbuf_rx) == 0) {
+        gbuffer_reset_wr(priv->gbuf_rx);
+    }
+}
+
+/***************************************************************************
+ *  Accept, receive and answer, without blocking
+ ***************************************************************************/
+PRIVATE void serve(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    int fd = accept4(priv->fd_listen, NULL, NULL, SOCK_NONBLOCK|SOCK_CLOEXEC);
+    if(fd >= 0) {
+        close_client(gobj);
+        priv->fd_client = fd;
+        gobj_write_integer_attr(gobj, "connections",
+            gobj_read_integer_attr(gobj, "connections") + 1
+        );
+    }
+    if(priv->fd_client < 0) {
+        return;
+    }
+
+    char bf[4096];
+    while(priv->fd_client >= 0) {
+        ssize_t r = read(priv->fd_client, bf, sizeof(bf));
+        if(r > 0) {
+            gbuffer_append(priv->gbuf_rx, bf, (size_t)r);
+            continue;
+        }
+        if(r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            process_rx(gobj);
+            close_client(gobj);
+        }
+        break;
+    }
+    process_rx(gobj);
+
+    if(gobj_read_bool_attr(gobj, "hold")) {
+        return;
+    }
+    while(priv->fd_client >= 0 && gbuffer_leftbytes(priv->gbuf_tx) > 0) {
+        ssize_t w = write(
+            priv->fd_client,
+            gbuffer_cur_rd_pointer(priv->gbuf_tx),
+            gbuffer_leftbytes(priv->gbuf_tx)
+        );
+        if(w <= 0) {
+            break;
+        }
+        gbuffer_get(priv->gbuf_tx, (size_t)w);
+    }
+    if(gbuffer_leftbytes(priv->gbuf_tx) == 0) {
+        gbuffer_reset_wr(priv->gbuf_tx);
+    }
+}
+
+
+
+
+                    /***************************
+                     *      Actions
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_timeout(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    serve(gobj);
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *                          FSM
+ ***************************************************************************/
+/*---------------------------------------------*
+ *          Global methods table
+ *---------------------------------------------*/
+PRIVATE const GMETHODS gmt = {
+    .mt_create  = mt_create,
+    .mt_destroy = mt_destroy,
+    .mt_start   = mt_start,
+    .mt_stop    = mt_stop,
+};
+
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DEFINE_GCLASS(C_FAKE_PG);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+
+/***************************************************************************
+ *          Create the GClass
+ ***************************************************************************/
+PRIVATE int create_gclass(gclass_name_t gclass_name)
+{
+    static hgclass __gclass__ = 0;
+    if(__gclass__) {
+        gobj_log_error(0, 0,
+            "function", "%s", __FUNCTION__,
+            "msgset",   "%s", MSGSET_INTERNAL,
+            "msg",      "%s", "GClass ALREADY created",
+            "gclass",   "%s", gclass_name,
+            NULL
+        );
+        return -1;
+    }
+
+    /*------------------------*
+     *      States
+     *------------------------*/
+    ev_action_t st_idle[] = {
+        {EV_TIMEOUT_PERIODIC,       ac_timeout,             0},
+        {0,0,0}
+    };
+
+    states_t states[] = {
+        {ST_IDLE,       st_idle},
+        {0, 0}
+    };
+
+    /*------------------------*
+     *      Events
+     *------------------------*/
+    event_type_t event_types[] = {
+        {EV_TIMEOUT_PERIODIC,       0},
+        {NULL, 0}
+    };
+
+    /*----------------------------------------*
+     *          Register GClass
+     *----------------------------------------*/
+    __gclass__ = gclass_create(
+        gclass_name,
+        event_types,
+        states,
+        &gmt,
+        0, // local methods
+        attrs_table,
+        sizeof(PRIVATE_DATA),
+        0, // authz_table
+        0, // command_table
+        s_user_trace_level,
+        0 // gcflags
+    );
+    if(!__gclass__) {
+        // Error already logged
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *              Public access
+ ***************************************************************************/
+PUBLIC int register_c_fake_pg(void)
+{
+    return create_gclass(C_FAKE_PG);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC json_t *fake_pg_log(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    return priv->jn_log;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC int fake_pg_count(hgobj gobj, const char *msg)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    int n = 0;
+    size_t idx; json_t *jn_msg;
+    json_array_foreach(priv->jn_log, idx, jn_msg) {
+        if(strcmp(json_string_value(jn_msg), msg)==0) {
+            n++;
+        }
+    }
+    return n;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC const char *fake_pg_copy_data(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    return gbuffer_cur_rd_pointer(priv->gbuf_copy); // gbuffer is nul-terminated
+}
@@ -0,0 +1,43 @@
+/****************************************************************************
+ *          C_FAKE_PG.H
+ *
+ *          Postgres server of the tests, in a unix socket:
+ *          speaks enough of the protocol v3 to libpq, keeps what it receives.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#pragma once
+
+#include <yunetas.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/***************************************************************
+ *              FSM
+ ***************************************************************/
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DECLARE_GCLASS(C_FAKE_PG);
+
+/***************************************************************
+ *              Prototypes
+ ***************************************************************/
+PUBLIC int register_c_fake_pg(void);
+
+/*
+ *  Messages received, in order, as strings:
+ *      "P:<statement>" Parse, "B:<statement>" Bind, "E" Execute, "S" Sync,
+ *      "Q:<sql>" simple query, "c" CopyDone.
+ *  NOT yours.
+ */
+PUBLIC json_t *fake_pg_log(hgobj gobj);
+PUBLIC int fake_pg_count(hgobj gobj, const char *msg); // messages equal to msg
+PUBLIC const char *fake_pg_copy_data(hgobj gobj); // CopyData of the last COPY, NOT yours
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,649 @@
+/***********************************************************************
+ *          C_PIPELINE.C
+ *
+ *          Test of C_POSTGRES with libpq, against C_FAKE_PG, the postgres
+ *          server of the tests. The steps go on from a periodic timer,
+ *          each one waiting what the previous one has sent.
+ *
+ *          What must hold (pipeline_depth 3):
+ *
+ *      1) Pipeline: the queries are sent without waiting the results
+ *         of the previous ones, the results come in order.
+ *
+ *      2) Prepared statements: the sql is prepared once by connection.
+ *         The queries of the sql wait the result of its PREPARE, no Bind
+ *         is sent before it.
+ *
+ *      3) A PREPARE failed: the queries waiting it are answered with its
+ *         error, without being sent; the query after them, of other sql,
+ *         is not aborted. The sql is prepared again in its next use.
+ *
+ *      4) COPY FROM STDIN: the data is sent, the result has the rows
+ *         copied, the pipeline goes on after it.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ***********************************************************************/
+#include <string.h>
+#include <unistd.h>
+
+#include <c_postgres.h>
+#include "c_fake_pg.h"
+#include "c_pipeline.h"
+
+/***************************************************************************
+ *              Constants
+ ***************************************************************************/
+#define SQL_INSERT      "INSERT INTO t (v) VALUES ($1)"
+#define SQL_FAIL        "INSERT INTO t (v) VALUES ($1) FAIL"
+#define COPY_DATA       "1\n2\n"
+#define STEP_TIMEOUT    5*1000
+#define STEP_END        9
+
+/***************************************************************************
+ *              Structures
+ ***************************************************************************/
+
+/***************************************************************************
+ *              Prototypes
+ ***************************************************************************/
+PRIVATE int check(hgobj gobj, BOOL ok, const char *what);
+
+/***************************************************************************
+ *          Data: config, public data, private data
+ ***************************************************************************/
+/*---------------------------------------------*
+ *      Attributes
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t attrs_table[] = {
+/*-ATTR-type------------name----------------flag----------------default-----description--*/
+SDATA (DTP_POINTER,     "subscriber",       0,                  0,          "Subscriber of output-events"),
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *      GClass trace levels
+ *---------------------------------------------*/
+PRIVATE const trace_level_t s_user_trace_level[16] = {
+{0, 0},
+};
+
+/*---------------------------------------------*
+ *      GClass authz levels
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t authz_table[] = {
+/*-AUTHZ-- type---------name----------------flag----alias---items---description--*/
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *              Private data
+ *---------------------------------------------*/
+typedef struct _PRIVATE_DATA {
+    hgobj timer;
+    hgobj gobj_server;              // C_FAKE_PG
+    hgobj gobj_postgres;            // C_POSTGRES under test
+    json_t *jn_results;             // EV_ON_MESSAGE published, in order
+    BOOL opened;
+
+    int step;
+    uint64_t t_step;
+    int result;
+} PRIVATE_DATA;
+
+
+
+
+                    /******************************
+                     *      Framework Methods
+                     ******************************/
+
+
+
+
+/***************************************************************************
+ *      Framework Method create
+ ***************************************************************************/
+PRIVATE void mt_create(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->jn_results = json_array();
+    priv->timer = gobj_create_pure_child(gobj_name(gobj), C_TIMER, 0, gobj);
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "/tmp/yuneta_test_pg_%d", (int)getpid());
+
+    json_t *kw_server = json_pack("{s:s}",
+        "path", path
+    );
+    priv->gobj_server = gobj_create_pure_child("server", C_FAKE_PG, kw_server, gobj);
+
+    char url[PATH_MAX + 128];
+    snprintf(url, sizeof(url),
+        "postgresql:///test?host=%s&port=5432&user=test&sslmode=disable&gssencmode=disable",
+        path
+    );
+    json_t *kw_postgres = json_pack("{s:s, s:i}",
+        "url", url,
+        "pipeline_depth", 3
+    );
+    priv->gobj_postgres = gobj_create_pure_child("postgres", C_POSTGRES, kw_postgres, gobj);
+
+    /*
+     *  SERVICE subscription model
+     */
+    hgobj subscriber = (hgobj)gobj_read_pointer_attr(gobj, "subscriber");
+    if(subscriber) {
+        gobj_subscribe_event(gobj, NULL, NULL, subscriber);
+    }
+}
+
+/***************************************************************************
+ *      Framework Method destroy
+ ***************************************************************************/
+PRIVATE void mt_destroy(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    JSON_DECREF(priv->jn_results)
+}
+
+/***************************************************************************
+ *      Framework Method start
+ ***************************************************************************/
+PRIVATE int mt_start(hgobj gobj)
+{
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method stop
+ ***************************************************************************/
+PRIVATE int mt_stop(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    clear_timeout(priv->timer);
+    if(gobj_is_running(priv->timer)) {
+        gobj_stop(priv->timer);
+    }
+    if(gobj_is_running(priv->gobj_postgres)) {
+        gobj_stop(priv->gobj_postgres);
+    }
+    if(gobj_is_running(priv->gobj_server)) {
+        gobj_stop(priv->gobj_server);
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method play
+ *
+ *  The server first, the connection is done 100 ms after the start.
+ ***************************************************************************/
+PRIVATE int mt_play(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gobj_start(priv->gobj_server);
+    gobj_start(priv->gobj_postgres);
+
+    priv->t_step = start_msectimer(STEP_TIMEOUT);
+    set_timeout_periodic(priv->timer, 10);
+
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method pause
+ ***************************************************************************/
+PRIVATE int mt_pause(hgobj gobj)
+{
+    return 0;
+}
+
+
+
+
+                    /***************************
+                     *      Local Methods
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int check(hgobj gobj, BOOL ok, const char *what)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(ok) {
+        return 0;
+    }
+    gobj_log_error(gobj, 0,
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_INTERNAL,
+        "msg",          "%s", "postgres pipeline check FAILED",
+        "what",         "%s", what,
+        "step",         "%d", priv->step,
+        NULL
+    );
+    priv->result--;
+    return -1;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void send_query(hgobj gobj, const char *id, const char *sql, BOOL prepare)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_t *kw_query = json_pack("{s:s, s:s, s:[s], s:b}",
+        "id", id,
+        "query", sql,
+        "params", id,
+        "prepare", prepare
+    );
+    gobj_send_event(priv->gobj_postgres, EV_SEND_QUERY, kw_query, gobj);
+}
+
+/***************************************************************************
+ *  Result published of the query `id`, NULL if none
+ ***************************************************************************/
+PRIVATE json_t *result_kw(hgobj gobj, const char *id)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    size_t idx; json_t *jn_result;
+    json_array_foreach(priv->jn_results, idx, jn_result) {
+        if(strcmp(kw_get_str(gobj, jn_result, "id", "", 0), id)==0) {
+            return jn_result;
+        }
+    }
+    return NULL;
+}
+
+/***************************************************************************
+ *  Result of the query `id`, -2 if none
+ ***************************************************************************/
+PRIVATE json_int_t result_of(hgobj gobj, const char *id)
+{
+    return kw_get_int(gobj, result_kw(gobj, id), "result", -2, 0);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE size_t results(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    return json_array_size(priv->jn_results);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int received(hgobj gobj, const char *msg)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    return fake_pg_count(priv->gobj_server, msg);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void hold(hgobj gobj, BOOL hold)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    gobj_write_bool_attr(priv->gobj_server, "hold", hold);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void test_ok(hgobj gobj, const char *msg)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", msg,
+            NULL
+        );
+    }
+}
+
+/***************************************************************************
+ *  Do the step if what it waits is done, return TRUE to go to the next one
+ ***************************************************************************/
+PRIVATE BOOL run_step(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    switch(priv->step) {
+        case 0:
+            /*
+             *  1) Pipeline: the answers held, all the queries are sent
+             */
+            if(!priv->opened) {
+                return FALSE;
+            }
+            hold(gobj, TRUE);
+            send_query(gobj, "q1", SQL_INSERT, FALSE);
+            send_query(gobj, "q2", SQL_INSERT, FALSE);
+            send_query(gobj, "q3", SQL_INSERT, FALSE);
+            return TRUE;
+
+        case 1:
+            if(received(gobj, "S") < 3) {
+                return FALSE;
+            }
+            check(gobj, received(gobj, "E") == 3, "pipeline: 3 queries sent");
+            check(gobj, results(gobj) == 0, "pipeline: no result yet");
+            check(gobj, gobj_read_integer_attr(priv->gobj_postgres, "queries_pending") == 3,
+                "pipeline: 3 in flight"
+            );
+            hold(gobj, FALSE);
+            return TRUE;
+
+        case 2:
+            if(results(gobj) < 3) {
+                return FALSE;
+            }
+            check(gobj, result_of(gobj, "q1") == 0 &&
+                result_of(gobj, "q2") == 0 &&
+                result_of(gobj, "q3") == 0, "pipeline: results"
+            );
+            check(gobj, strcmp(kw_get_str(gobj, json_array_get(priv->jn_results, 0), "id", "", 0), "q1")==0 &&
+                strcmp(kw_get_str(gobj, json_array_get(priv->jn_results, 2), "id", "", 0), "q3")==0,
+                "pipeline: results in order"
+            );
+            test_ok(gobj, "pipeline ok");
+
+            /*
+             *  2) Prepared statement, its PREPARE answer held
+             */
+            hold(gobj, TRUE);
+            send_query(gobj, "p1", SQL_INSERT, TRUE);
+            send_query(gobj, "p2", SQL_INSERT, TRUE);
+            send_query(gobj, "p3", SQL_INSERT, TRUE);
+            return TRUE;
+
+        case 3:
+            if(received(gobj, "P:yp1") < 1 || received(gobj, "S") < 4) {
+                return FALSE;
+            }
+            check(gobj, received(gobj, "B:yp1") == 0, "prepared: no Bind before the PREPARE result");
+            check(gobj, gobj_read_integer_attr(priv->gobj_postgres, "queries_pending") == 3,
+                "prepared: the queries wait"
+            );
+            hold(gobj, FALSE);
+            return TRUE;
+
+        case 4:
+            if(results(gobj) < 6) {
+                return FALSE;
+            }
+            check(gobj, result_of(gobj, "p1") == 0 &&
+                result_of(gobj, "p2") == 0 &&
+                result_of(gobj, "p3") == 0, "prepared: results"
+            );
+            check(gobj, received(gobj, "P:yp1") == 1, "prepared: one PREPARE");
+            check(gobj, received(gobj, "B:yp1") == 3, "prepared: 3 executions");
+
+            send_query(gobj, "p4", SQL_INSERT, TRUE);
+            return TRUE;
+
+        case 5:
+            if(results(gobj) < 7) {
+                return FALSE;
+            }
+            check(gobj, result_of(gobj, "p4") == 0, "prepared: p4 result");
+            check(gobj, received(gobj, "P:yp1") == 1, "prepared: cached");
+            check(gobj, received(gobj, "B:yp1") == 4, "prepared: p4 executed");
+            test_ok(gobj, "prepared ok");
+
+            /*
+             *  3) PREPARE failed
+             */
+            send_query(gobj, "f1", SQL_FAIL, TRUE);
+            send_query(gobj, "f2", SQL_FAIL, TRUE);
+            send_query(gobj, "n1", SQL_INSERT, FALSE);
+            return TRUE;
+
+        case 6:
+            if(results(gobj) < 10) {
+                return FALSE;
+            }
+            check(gobj, result_of(gobj, "f1") == -1, "prepare failed: f1 failed");
+            check(gobj, result_of(gobj, "f2") == -1, "prepare failed: f2 failed");
+            check(gobj, !empty_string(kw_get_str(gobj, result_kw(gobj, "f2"), "comment", "", 0)),
+                "prepare failed: with the error"
+            );
+            check(gobj, result_of(gobj, "n1") == 0, "prepare failed: n1 not aborted");
+            check(gobj, received(gobj, "B:yp2") == 0, "prepare failed: no Bind");
+
+            send_query(gobj, "f3", SQL_FAIL, TRUE);
+            return TRUE;
+
+        case 7:
+            if(results(gobj) < 11) {
+                return FALSE;
+            }
+            check(gobj, result_of(gobj, "f3") == -1, "prepare failed: f3 failed");
+            check(gobj, received(gobj, "P:yp3") == 1, "prepare failed: prepared again");
+            test_ok(gobj, "prepare failed ok");
+
+            /*
+             *  4) COPY, and a query after it
+             */
+            {
+                json_t *kw_copy = json_pack("{s:s, s:s, s:s}",
+                    "id", "c1",
+                    "query", "COPY t (v) FROM STDIN",
+                    "copy_data", COPY_DATA
+                );
+                gobj_send_event(priv->gobj_postgres, EV_SEND_QUERY, kw_copy, gobj);
+            }
+            send_query(gobj, "n2", SQL_INSERT, FALSE);
+            return TRUE;
+
+        case 8:
+            if(results(gobj) < 13) {
+                return FALSE;
+            }
+            check(gobj, result_of(gobj, "c1") == 0, "copy: result");
+            check(gobj, kw_get_int(gobj, result_kw(gobj, "c1"), "rows", 0, 0) == 2, "copy: rows");
+            check(gobj, strcmp(fake_pg_copy_data(priv->gobj_server), COPY_DATA)==0, "copy: data");
+            check(gobj, result_of(gobj, "n2") == 0, "copy: n2 after it");
+            test_ok(gobj, "copy ok");
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
+
+
+
+                    /***************************
+                     *      Actions
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Go on with the steps
+ ***************************************************************************/
+PRIVATE int ac_timeout(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    while(priv->step < STEP_END && run_step(gobj)) {
+        priv->step++;
+        priv->t_step = start_msectimer(STEP_TIMEOUT);
+    }
+
+    if(priv->step < STEP_END && test_msectimer(priv->t_step)) {
+        check(gobj, FALSE, "step timeout");
+        priv->step = STEP_END;
+    }
+
+    if(priv->step == STEP_END) {
+        clear_timeout(priv->timer);
+        set_yuno_must_die();
+    }
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Result of a query, keep it
+ ***************************************************************************/
+PRIVATE int ac_on_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_array_append(priv->jn_results, kw);
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_on_open(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->opened = TRUE;
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_on_close(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->opened = FALSE;
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *                          FSM
+ ***************************************************************************/
+/*---------------------------------------------*
+ *          Global methods table
+ *---------------------------------------------*/
+PRIVATE const GMETHODS gmt = {
+    .mt_create  = mt_create,
+    .mt_destroy = mt_destroy,
+    .mt_start   = mt_start,
+    .mt_stop    = mt_stop,
+    .mt_play    = mt_play,
+    .mt_pause   = mt_pause,
+};
+
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DEFINE_GCLASS(C_PIPELINE);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+
+/***************************************************************************
+ *          Create the GClass
+ ***************************************************************************/
+PRIVATE int create_gclass(gclass_name_t gclass_name)
+{
+    static hgclass __gclass__ = 0;
+    if(__gclass__) {
+        gobj_log_error(0, 0,
+            "function", "%s", __FUNCTION__,
+            "msgset",   "%s", MSGSET_INTERNAL,
+            "msg",      "%s", "GClass ALREADY created",
+            "gclass",   "%s", gclass_name,
+            NULL
+        );
+        return -1;
+    }
+
+    /*------------------------*
+     *      States
+     *------------------------*/
+    ev_action_t st_idle[] = {
+        {EV_TIMEOUT_PERIODIC,       ac_timeout,             0},
+        {EV_ON_MESSAGE,             ac_on_message,          0},
+        {EV_ON_OPEN,                ac_on_open,             0},
+        {EV_ON_CLOSE,               ac_on_close,            0},
+        {0,0,0}
+    };
+
+    states_t states[] = {
+        {ST_IDLE,       st_idle},
+        {0, 0}
+    };
+
+    /*------------------------*
+     *      Events
+     *------------------------*/
+    event_type_t event_types[] = {
+        {EV_TIMEOUT_PERIODIC,       0},
+        {EV_ON_MESSAGE,             0},
+        {EV_ON_OPEN,                0},
+        {EV_ON_CLOSE,               0},
+        {NULL, 0}
+    };
+
+    /*----------------------------------------*
+     *          Register GClass
+     *----------------------------------------*/
+    __gclass__ = gclass_create(
+        gclass_name,
+        event_types,
+        states,
+        &gmt,
+        0, // local methods
+        attrs_table,
+        sizeof(PRIVATE_DATA),
+        authz_table,
+        0, // command_table
+        s_user_trace_level,
+        0 // gcflags
+    );
+    if(!__gclass__) {
+        // Error already logged
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *              Public access
+ ***************************************************************************/
+PUBLIC int register_c_pipeline(void)
+{
+    return create_gclass(C_PIPELINE);
+}
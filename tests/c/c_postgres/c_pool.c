@@ -0,0 +1,675 @@
+/***********************************************************************
+ *          C_POOL.C
+ *
+ *          Test of C_POSTGRES_POOL, the pool of C_POSTGRES connections.
+ *          No postgres server is used: the connections are driven through
+ *          their FSM from here (EV_CONNECTED, EV_DROP), the queries sent
+ *          to them stay in their queue, and their results are sent to the
+ *          pool with EV_ON_MESSAGE, as the connection does.
+ *
+ *          What must hold:
+ *
+ *      1) A query by connection (pipeline_depth 1), to the connection
+ *         free, the rest wait in the pool. A result frees a place.
+ *
+ *      2) The queries of a session go to the connection pinned by its
+ *         first query, until the result of its "session_end" query.
+ *         The other queries don't use that connection meanwhile.
+ *
+ *      3) A connection failing its queries because it's lost is not
+ *         connected anymore for the pool: no query goes to it from its
+ *         results, before its EV_ON_CLOSE. Its session is failed: the
+ *         next queries of the session are answered with error by the
+ *         pool, until the "session_end".
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ***********************************************************************/
+#include <string.h>
+
+#include <c_postgres_pool.h>
+#include "c_pool.h"
+
+/***************************************************************************
+ *              Constants
+ ***************************************************************************/
+#define POOL_SIZE   2
+
+/***************************************************************************
+ *              Structures
+ ***************************************************************************/
+
+/***************************************************************************
+ *              Prototypes
+ ***************************************************************************/
+PRIVATE int check(hgobj gobj, BOOL ok, const char *what);
+
+/***************************************************************************
+ *          Data: config, public data, private data
+ ***************************************************************************/
+/*---------------------------------------------*
+ *      Attributes
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t attrs_table[] = {
+/*-ATTR-type------------name----------------flag----------------default-----description--*/
+SDATA (DTP_POINTER,     "subscriber",       0,                  0,          "Subscriber of output-events"),
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *      GClass trace levels
+ *---------------------------------------------*/
+PRIVATE const trace_level_t s_user_trace_level[16] = {
+{0, 0},
+};
+
+/*---------------------------------------------*
+ *      GClass authz levels
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t authz_table[] = {
+/*-AUTHZ-- type---------name----------------flag----alias---items---description--*/
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *              Private data
+ *---------------------------------------------*/
+typedef struct _PRIVATE_DATA {
+    hgobj gobj_pool;                // C_POSTGRES_POOL under test
+    hgobj gobj_conns[POOL_SIZE];    // its C_POSTGRES
+    json_t *jn_results;             // EV_ON_MESSAGE published, in order
+    int opens;                      // EV_ON_OPEN published
+    int closes;                     // EV_ON_CLOSE published
+} PRIVATE_DATA;
+
+
+
+
+                    /******************************
+                     *      Framework Methods
+                     ******************************/
+
+
+
+
+/***************************************************************************
+ *      Framework Method create
+ ***************************************************************************/
+PRIVATE void mt_create(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->jn_results = json_array();
+
+    /*
+     *  SERVICE subscription model
+     */
+    hgobj subscriber = (hgobj)gobj_read_pointer_attr(gobj, "subscriber");
+    if(subscriber) {
+        gobj_subscribe_event(gobj, NULL, NULL, subscriber);
+    }
+}
+
+/***************************************************************************
+ *      Framework Method destroy
+ ***************************************************************************/
+PRIVATE void mt_destroy(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    JSON_DECREF(priv->jn_results)
+}
+
+/***************************************************************************
+ *      Framework Method start
+ ***************************************************************************/
+PRIVATE int mt_start(hgobj gobj)
+{
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method stop
+ ***************************************************************************/
+PRIVATE int mt_stop(hgobj gobj)
+{
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method play
+ *
+ *  The checks run from the event loop, like any action of a gclass.
+ ***************************************************************************/
+PRIVATE int mt_play(hgobj gobj)
+{
+    gobj_post_event(gobj, EV_TEST_RUN, 0, gobj);
+
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method pause
+ ***************************************************************************/
+PRIVATE int mt_pause(hgobj gobj)
+{
+    return 0;
+}
+
+
+
+
+                    /***************************
+                     *      Local Methods
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int check(hgobj gobj, BOOL ok, const char *what)
+{
+    if(ok) {
+        return 0;
+    }
+    gobj_log_error(gobj, 0,
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_INTERNAL,
+        "msg",          "%s", "postgres pool check FAILED",
+        "what",         "%s", what,
+        NULL
+    );
+    return -1;
+}
+
+/***************************************************************************
+ *  The connection is open, as when libpq ends the connection
+ ***************************************************************************/
+PRIVATE void open_conn(hgobj gobj, hgobj gobj_conn)
+{
+    gobj_change_state(gobj_conn, ST_WAIT_CONNECTED);
+    gobj_send_event(gobj_conn, EV_CONNECTED, 0, gobj);
+}
+
+/***************************************************************************
+ *  The connection is lost, as when libpq fails
+ ***************************************************************************/
+PRIVATE void drop_conn(hgobj gobj, hgobj gobj_conn)
+{
+    gobj_send_event(gobj_conn, EV_DROP, 0, gobj);
+}
+
+/***************************************************************************
+ *  Queries in the queue of a connection or of the pool
+ ***************************************************************************/
+PRIVATE size_t queue_size(hgobj gobj, hgobj gobj_queue)
+{
+    json_t *resp = gobj_command(gobj_queue, "list-queue", json_object(), gobj);
+    size_t size = json_array_size(kw_get_list(gobj, resp, "data", 0, 0));
+    JSON_DECREF(resp)
+    return size;
+}
+
+/***************************************************************************
+ *  Copy of the query `id` queued in the connection, NULL if not there
+ ***************************************************************************/
+PRIVATE json_t *queued_query(hgobj gobj, hgobj gobj_conn, const char *id)
+{
+    json_t *resp = gobj_command(gobj_conn, "list-queue", json_object(), gobj);
+    json_t *jn_query = NULL;
+
+    size_t idx; json_t *jn_item;
+    json_array_foreach(kw_get_list(gobj, resp, "data", 0, 0), idx, jn_item) {
+        if(strcmp(kw_get_str(gobj, jn_item, "id", "", 0), id)==0) {
+            jn_query = json_deep_copy(jn_item);
+            break;
+        }
+    }
+    JSON_DECREF(resp)
+    return jn_query;
+}
+
+/***************************************************************************
+ *  Connection with the query `id`, NULL if none
+ ***************************************************************************/
+PRIVATE hgobj holder(hgobj gobj, const char *id)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    for(int i=0; i<POOL_SIZE; i++) {
+        json_t *jn_query = queued_query(gobj, priv->gobj_conns[i], id);
+        if(jn_query) {
+            JSON_DECREF(jn_query)
+            return priv->gobj_conns[i];
+        }
+    }
+    return NULL;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE json_int_t pending(hgobj gobj_conn)
+{
+    return gobj_read_integer_attr(gobj_conn, "queries_pending");
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void send_query(hgobj gobj, const char *id, const char *session, BOOL session_end)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_t *kw_query = json_pack("{s:s, s:s}",
+        "id", id,
+        "query", "SELECT 1"
+    );
+    if(session) {
+        json_object_set_new(kw_query, "session", json_string(session));
+    }
+    if(session_end) {
+        json_object_set_new(kw_query, "session_end", json_true());
+    }
+    gobj_send_event(priv->gobj_pool, EV_SEND_QUERY, kw_query, gobj);
+}
+
+/***************************************************************************
+ *  The connection with the query `id` answers it
+ ***************************************************************************/
+PRIVATE int answer(hgobj gobj, const char *id)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    hgobj gobj_conn = holder(gobj, id);
+    if(!gobj_conn) {
+        return check(gobj, FALSE, id);
+    }
+    json_t *kw_result = queued_query(gobj, gobj_conn, id);
+    gobj_send_event(gobj_conn, EV_CLEAR_QUEUE, json_pack("{s:s}", "id", id), gobj);
+
+    json_object_set_new(kw_result, "result", json_integer(0));
+    json_object_set_new(kw_result, "data", json_array());
+    return gobj_send_event(priv->gobj_pool, EV_ON_MESSAGE, kw_result, gobj_conn);
+}
+
+/***************************************************************************
+ *  Result published of the query `id`, -2 if none
+ ***************************************************************************/
+PRIVATE json_int_t result_of(hgobj gobj, const char *id)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    size_t idx; json_t *jn_result;
+    json_array_foreach(priv->jn_results, idx, jn_result) {
+        if(strcmp(kw_get_str(gobj, jn_result, "id", "", 0), id)==0) {
+            return kw_get_int(gobj, jn_result, "result", -2, 0);
+        }
+    }
+    return -2;
+}
+
+/***************************************************************************
+ *  1) Queries dispatched to the connections free
+ ***************************************************************************/
+PRIVATE int test_dispatch(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    int result = 0;
+
+    for(int i=0; i<POOL_SIZE; i++) {
+        open_conn(gobj, priv->gobj_conns[i]);
+    }
+    result += check(gobj, priv->opens == 1, "dispatch: pool open");
+
+    send_query(gobj, "q1", NULL, FALSE);
+    send_query(gobj, "q2", NULL, FALSE);
+    send_query(gobj, "q3", NULL, FALSE);
+
+    hgobj gobj_q1 = holder(gobj, "q1");
+    hgobj gobj_q2 = holder(gobj, "q2");
+    result += check(gobj, gobj_q1 && gobj_q2 && gobj_q1 != gobj_q2, "dispatch: a query by connection");
+    result += check(gobj, holder(gobj, "q3") == NULL, "dispatch: q3 waits");
+    result += check(gobj, queue_size(gobj, priv->gobj_pool) == 1, "dispatch: waiting in the pool");
+
+    answer(gobj, "q1");
+    result += check(gobj, result_of(gobj, "q1") == 0, "dispatch: q1 result");
+    result += check(gobj, holder(gobj, "q3") == gobj_q1, "dispatch: q3 to the connection free");
+    result += check(gobj, queue_size(gobj, priv->gobj_pool) == 0, "dispatch: nothing waiting");
+
+    answer(gobj, "q2");
+    answer(gobj, "q3");
+    result += check(gobj, json_array_size(priv->jn_results) == 3, "dispatch: 3 results");
+    for(int i=0; i<POOL_SIZE; i++) {
+        result += check(gobj, pending(priv->gobj_conns[i]) == 0, "dispatch: all answered");
+    }
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "dispatch ok",
+            NULL
+        );
+    }
+    return result;
+}
+
+/***************************************************************************
+ *  2) Sessions
+ ***************************************************************************/
+PRIVATE int test_session(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    int result = 0;
+
+    send_query(gobj, "b1", "t1", FALSE);    // BEGIN
+    hgobj gobj_pinned = holder(gobj, "b1");
+    result += check(gobj, gobj_pinned != NULL, "session: pinned");
+
+    send_query(gobj, "n1", NULL, FALSE);
+    hgobj gobj_other = holder(gobj, "n1");
+    result += check(gobj, gobj_other && gobj_other != gobj_pinned, "session: the other connection");
+
+    send_query(gobj, "n2", NULL, FALSE);
+    result += check(gobj, holder(gobj, "n2") == NULL, "session: n2 waits");
+
+    send_query(gobj, "i1", "t1", FALSE);    // INSERT
+    result += check(gobj, holder(gobj, "i1") == gobj_pinned, "session: to its connection");
+    result += check(gobj, pending(gobj_pinned) == 2, "session: queued behind");
+
+    answer(gobj, "b1");
+    answer(gobj, "i1");
+    result += check(gobj, holder(gobj, "n2") == NULL, "session: still pinned");
+
+    send_query(gobj, "c1", "t1", TRUE);     // COMMIT
+    result += check(gobj, holder(gobj, "c1") == gobj_pinned, "session: end to its connection");
+    answer(gobj, "c1");
+    result += check(gobj, holder(gobj, "n2") == gobj_pinned, "session: released");
+
+    answer(gobj, "n1");
+    answer(gobj, "n2");
+    result += check(gobj, result_of(gobj, "c1") == 0, "session: c1 result");
+    result += check(gobj, queue_size(gobj, priv->gobj_pool) == 0, "session: nothing waiting");
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "session ok",
+            NULL
+        );
+    }
+    return result;
+}
+
+/***************************************************************************
+ *  3) Connection lost
+ ***************************************************************************/
+PRIVATE int test_connection_lost(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    int result = 0;
+
+    /*
+     *  The result of the "session_end" query, failed by the connection
+     *  lost, doesn't release it to the queries waiting
+     */
+    send_query(gobj, "e2", "t2", TRUE);
+    hgobj gobj_lost = holder(gobj, "e2");
+    send_query(gobj, "n3", NULL, FALSE);
+    hgobj gobj_other = holder(gobj, "n3");
+    send_query(gobj, "n4", NULL, FALSE);
+    result += check(gobj, gobj_lost && gobj_other && gobj_lost != gobj_other, "lost: both busy");
+    result += check(gobj, queue_size(gobj, priv->gobj_pool) == 1, "lost: n4 waits");
+
+    drop_conn(gobj, gobj_lost);
+    result += check(gobj, result_of(gobj, "e2") == -1, "lost: session query failed");
+    result += check(gobj, holder(gobj, "n4") == NULL, "lost: n4 not to the connection lost");
+    result += check(gobj, pending(gobj_lost) == 0, "lost: nothing queued there");
+    result += check(gobj, queue_size(gobj, priv->gobj_pool) == 1, "lost: n4 still waits");
+    result += check(gobj, priv->closes == 0, "lost: the pool keeps open");
+
+    open_conn(gobj, gobj_lost);
+    result += check(gobj, holder(gobj, "n4") == gobj_lost, "lost: n4 to the connection again");
+    answer(gobj, "n3");
+    answer(gobj, "n4");
+
+    /*
+     *  The session of the connection lost fails until its "session_end"
+     */
+    send_query(gobj, "b4", "t4", FALSE);
+    gobj_lost = holder(gobj, "b4");
+    result += check(gobj, gobj_lost != NULL, "failed session: pinned");
+
+    drop_conn(gobj, gobj_lost);
+    result += check(gobj, result_of(gobj, "b4") == -1, "failed session: begin failed");
+
+    send_query(gobj, "i4", "t4", FALSE);
+    result += check(gobj, result_of(gobj, "i4") == -1, "failed session: answered by the pool");
+    result += check(gobj, holder(gobj, "i4") == NULL, "failed session: not sent");
+
+    send_query(gobj, "c4", "t4", TRUE);
+    result += check(gobj, result_of(gobj, "c4") == -1, "failed session: end answered");
+
+    open_conn(gobj, gobj_lost);
+    send_query(gobj, "b5", "t4", FALSE);
+    result += check(gobj, holder(gobj, "b5") != NULL, "failed session: closed by its end");
+    send_query(gobj, "c5", "t4", TRUE);
+    answer(gobj, "b5");
+    answer(gobj, "c5");
+
+    /*
+     *  All the connections lost: the pool is closed
+     */
+    for(int i=0; i<POOL_SIZE; i++) {
+        drop_conn(gobj, priv->gobj_conns[i]);
+    }
+    result += check(gobj, priv->closes == 1, "lost: pool closed");
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "connection lost ok",
+            NULL
+        );
+    }
+    return result;
+}
+
+
+
+
+                    /***************************
+                     *      Actions
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Run the checks and die
+ ***************************************************************************/
+PRIVATE int ac_test_run(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    /*
+     *  The connections don't connect by themselves during the test
+     */
+    json_t *kw_pool = json_pack("{s:s, s:i, s:i, s:i, s:i}",
+        "url", "postgresql://localhost/test",
+        "pool_size", POOL_SIZE,
+        "pipeline_depth", 1,
+        "timeout_waiting_connected", 60*1000,
+        "timeout_between_connections", 60*1000
+    );
+    priv->gobj_pool = gobj_create_pure_child("pool", C_POSTGRES_POOL, kw_pool, gobj);
+
+    int n = 0;
+    for(hgobj child = gobj_first_child(priv->gobj_pool); child; child = gobj_next_child(child)) {
+        if(gobj_typeof_gclass(child, C_POSTGRES) && n < POOL_SIZE) {
+            priv->gobj_conns[n++] = child;
+        }
+    }
+    gobj_start(priv->gobj_pool);
+
+    if(check(gobj, n == POOL_SIZE, "pool size") == 0) {
+        test_dispatch(gobj);
+        test_session(gobj);
+        test_connection_lost(gobj);
+    }
+
+    gobj_stop(priv->gobj_pool);
+    gobj_destroy(priv->gobj_pool);
+    priv->gobj_pool = 0;
+
+    set_yuno_must_die();
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Result of a query, keep it
+ ***************************************************************************/
+PRIVATE int ac_on_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_array_append(priv->jn_results, kw);
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_on_open(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->opens++;
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_on_close(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->closes++;
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *                          FSM
+ ***************************************************************************/
+/*---------------------------------------------*
+ *          Global methods table
+ *---------------------------------------------*/
+PRIVATE const GMETHODS gmt = {
+    .mt_create  = mt_create,
+    .mt_destroy = mt_destroy,
+    .mt_start   = mt_start,
+    .mt_stop    = mt_stop,
+    .mt_play    = mt_play,
+    .mt_pause   = mt_pause,
+};
+
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DEFINE_GCLASS(C_POOL);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+GOBJ_DEFINE_EVENT(EV_TEST_RUN);
+
+/***************************************************************************
+ *          Create the GClass
+ ***************************************************************************/
+PRIVATE int create_gclass(gclass_name_t gclass_name)
+{
+    static hgclass __gclass__ = 0;
+    if(__gclass__) {
+        gobj_log_error(0, 0,
+            "function", "%s", __FUNCTION__,
+            "msgset",   "%s", MSGSET_INTERNAL,
+            "msg",      "%s", "GClass ALREADY created",
+            "gclass",   "%s", gclass_name,
+            NULL
+        );
+        return -1;
+    }
+
+    /*------------------------*
+     *      States
+     *------------------------*/
+    ev_action_t st_idle[] = {
+        {EV_TEST_RUN,               ac_test_run,            0},
+        {EV_ON_MESSAGE,             ac_on_message,          0},
+        {EV_ON_OPEN,                ac_on_open,             0},
+        {EV_ON_CLOSE,               ac_on_close,            0},
+        {0,0,0}
+    };
+
+    states_t states[] = {
+        {ST_IDLE,       st_idle},
+        {0, 0}
+    };
+
+    /*------------------------*
+     *      Events
+     *------------------------*/
+    event_type_t event_types[] = {
+        {EV_TEST_RUN,               0},
+        {EV_ON_MESSAGE,             0},
+        {EV_ON_OPEN,                0},
+        {EV_ON_CLOSE,               0},
+        {NULL, 0}
+    };
+
+    /*----------------------------------------*
+     *          Register GClass
+     *----------------------------------------*/
+    __gclass__ = gclass_create(
+        gclass_name,
+        event_types,
+        states,
+        &gmt,
+        0, // local methods
+        attrs_table,
+        sizeof(PRIVATE_DATA),
+        authz_table,
+        0, // command_table
+        s_user_trace_level,
+        0 // gcflags
+    );
+    if(!__gclass__) {
+        // Error already logged
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *              Public access
+ ***************************************************************************/
+PUBLIC int register_c_pool(void)
+{
+    return create_gclass(C_POOL);
+}
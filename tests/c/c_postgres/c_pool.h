@@ -0,0 +1,41 @@
+/****************************************************************************
+ *          C_POOL.H
+ *
+ *          A gclass to test C_POSTGRES_POOL without postgres server
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#pragma once
+
+#include <yunetas.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/***************************************************************
+ *              FSM
+ ***************************************************************/
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DECLARE_GCLASS(C_POOL);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+GOBJ_DECLARE_EVENT(EV_TEST_RUN);        // posted from mt_play, the checks run in the loop
+
+/***************************************************************
+ *              Prototypes
+ ***************************************************************/
+PUBLIC int register_c_pool(void);
+
+#ifdef __cplusplus
+}
+#endif
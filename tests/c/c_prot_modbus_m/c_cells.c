@@ -0,0 +1,720 @@
+/***********************************************************************
+ *          C_CELLS.C
+ *
+ *          Test of the cells of C_PROT_MODBUS_M, the modbus master,
+ *          and of its publish of the variables.
+ *          The protocol runs over C_MOCK_TRANSPORT, like in C_PIPELINE:
+ *          the requests are read from the wire of the mock and the
+ *          responses are injected with EV_RX_DATA.
+ *
+ *          What must hold:
+ *
+ *      1) The cells are in pages, only the mapped pages exist. The
+ *         variables in several pages, or in two pages at once, are
+ *         read like the others.
+ *
+ *      2) With publish_changes_only the first cycle publishes all the
+ *         variables, a cycle without changes publishes nothing, and
+ *         later a slave publishes only its changed variables. A change
+ *         in any cell of a variable of several cells publishes it.
+ *
+ *      3) Without publish_changes_only all the variables are published
+ *         in every cycle, changed or not.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ***********************************************************************/
+#include <string.h>
+#include <unistd.h>
+
+#include <c_prot_modbus_m.h>
+#include "c_mock_transport.h"
+#include "c_cells.h"
+
+/***************************************************************************
+ *              Constants
+ ***************************************************************************/
+#define TIMEOUT_POLLING     100     // milliseconds
+#define MAX_REQUESTS        16
+#define MAX_REGISTERS       125
+
+/*
+ *  Slave 1, pages of 256 cells:
+ *      input register 0 (page 0), 255-256 (pages 0 and 1), 300 (page 1)
+ *      holding register 1000 (page 3)
+ *  Slave 2: input register 10
+ *
+ *  The config of both gobjs, publish_changes_only is set apart.
+ */
+PRIVATE char modbus_config[]= "\
+{                                                                   \n\
+    'modbus_protocol': 'TCP',                                       \n\
+    'pipeline_window': 4,                                           \n\
+    'slave_window': 4,                                              \n\
+    'timeout_polling': 100,                                         \n\
+    'timeout_response': 1,                                          \n\
+    'slaves': [                                                     \n\
+        {                                                           \n\
+            'id': 1,                                                \n\
+            'mapping': [                                            \n\
+                {'type': 'input_register', 'address': 0, 'size': 1},    \n\
+                {'type': 'input_register', 'address': 255, 'size': 2},  \n\
+                {'type': 'input_register', 'address': 300, 'size': 1},  \n\
+                {'type': 'holding_register', 'address': 1000, 'size': 1} \n\
+            ],                                                      \n\
+            'conversion': [                                         \n\
+                {'id': 'a', 'type': 'input_register', 'format': 'uint16', 'address': 0},   \n\
+                {'id': 'x', 'type': 'input_register', 'format': 'uint32', 'address': 255}, \n\
+                {'id': 'b', 'type': 'input_register', 'format': 'uint16', 'address': 300}, \n\
+                {'id': 'h', 'type': 'holding_register', 'format': 'uint16', 'address': 1000} \n\
+            ]                                                       \n\
+        },                                                          \n\
+        {                                                           \n\
+            'id': 2,                                                \n\
+            'mapping': [                                            \n\
+                {'type': 'input_register', 'address': 10, 'size': 1}    \n\
+            ],                                                      \n\
+            'conversion': [                                         \n\
+                {'id': 'c', 'type': 'input_register', 'format': 'uint16', 'address': 10}   \n\
+            ]                                                       \n\
+        }                                                           \n\
+    ]                                                               \n\
+}                                                                   \n\
+";
+
+/***************************************************************************
+ *              Structures
+ ***************************************************************************/
+/*
+ *  Request of modbus TCP read from the wire
+ */
+typedef struct {
+    uint16_t t_id;
+    uint8_t slave_id;
+    uint8_t function;
+    uint16_t address;
+    uint16_t quantity;
+} request_t;
+
+/***************************************************************************
+ *              Prototypes
+ ***************************************************************************/
+PRIVATE int check(hgobj gobj, BOOL ok, const char *what);
+
+/***************************************************************************
+ *          Data: config, public data, private data
+ ***************************************************************************/
+/*---------------------------------------------*
+ *      Attributes
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t attrs_table[] = {
+/*-ATTR-type------------name----------------flag----------------default-----description--*/
+SDATA (DTP_POINTER,     "subscriber",       0,                  0,          "Subscriber of output-events"),
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *      GClass trace levels
+ *---------------------------------------------*/
+PRIVATE const trace_level_t s_user_trace_level[16] = {
+{0, 0},
+};
+
+/*---------------------------------------------*
+ *      GClass authz levels
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t authz_table[] = {
+/*-AUTHZ-- type---------name----------------flag----alias---items---description--*/
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *              Private data
+ *---------------------------------------------*/
+typedef struct _PRIVATE_DATA {
+    hgobj gobj_changes;     // C_PROT_MODBUS_M with publish_changes_only
+    hgobj gobj_all;         // C_PROT_MODBUS_M publishing all the variables
+    json_t *jn_messages;    // EV_ON_MESSAGE published, in order
+    uint16_t a;             // slave 1, input register 0
+    uint16_t x_hi;          // slave 1, input register 255
+    uint16_t x_lo;          // slave 1, input register 256
+    uint16_t b;             // slave 1, input register 300
+    uint16_t h;             // slave 1, holding register 1000
+    uint16_t c;             // slave 2, input register 10
+} PRIVATE_DATA;
+
+
+
+
+                    /******************************
+                     *      Framework Methods
+                     ******************************/
+
+
+
+
+/***************************************************************************
+ *      Framework Method create
+ ***************************************************************************/
+PRIVATE void mt_create(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->jn_messages = json_array();
+
+    /*
+     *  SERVICE subscription model
+     */
+    hgobj subscriber = (hgobj)gobj_read_pointer_attr(gobj, "subscriber");
+    if(subscriber) {
+        gobj_subscribe_event(gobj, NULL, NULL, subscriber);
+    }
+}
+
+/***************************************************************************
+ *      Framework Method destroy
+ ***************************************************************************/
+PRIVATE void mt_destroy(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    JSON_DECREF(priv->jn_messages)
+}
+
+/***************************************************************************
+ *      Framework Method start
+ ***************************************************************************/
+PRIVATE int mt_start(hgobj gobj)
+{
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method stop
+ ***************************************************************************/
+PRIVATE int mt_stop(hgobj gobj)
+{
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method play
+ *
+ *  The checks run from the event loop, like any action of a gclass.
+ ***************************************************************************/
+PRIVATE int mt_play(hgobj gobj)
+{
+    gobj_post_event(gobj, EV_TEST_RUN, 0, gobj);
+
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method pause
+ ***************************************************************************/
+PRIVATE int mt_pause(hgobj gobj)
+{
+    return 0;
+}
+
+
+
+
+                    /***************************
+                     *      Local Methods
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int check(hgobj gobj, BOOL ok, const char *what)
+{
+    if(ok) {
+        return 0;
+    }
+    gobj_log_error(gobj, 0,
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_INTERNAL,
+        "msg",          "%s", "modbus cells check FAILED",
+        "what",         "%s", what,
+        NULL
+    );
+    return -1;
+}
+
+/***************************************************************************
+ *  A new C_PROT_MODBUS_M over C_MOCK_TRANSPORT, connected
+ ***************************************************************************/
+PRIVATE hgobj open_modbus(hgobj gobj, const char *name, json_t *kw_modbus)
+{
+    hgobj gobj_modbus = gobj_create_pure_child(name, C_PROT_MODBUS_M, kw_modbus, gobj);
+    hgobj gobj_mock = gobj_create_pure_child(name, C_MOCK_TRANSPORT, 0, gobj_modbus);
+    gobj_set_bottom_gobj(gobj_modbus, gobj_mock);
+
+    gobj_start(gobj_modbus);
+    gobj_send_event(gobj_modbus, EV_CONNECTED, 0, gobj_mock);
+    return gobj_modbus;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void close_modbus(hgobj gobj_modbus)
+{
+    gobj_stop(gobj_modbus);
+    gobj_destroy(gobj_modbus);
+}
+
+/***************************************************************************
+ *  Take the requests written in the wire
+ ***************************************************************************/
+PRIVATE int get_requests(hgobj gobj_modbus, request_t *requests, int max)
+{
+    hgobj gobj_mock = gobj_bottom_gobj(gobj_modbus);
+    const uint8_t *p = (const uint8_t *)mock_transport_wire(gobj_mock);
+    size_t len = mock_transport_wire_length(gobj_mock);
+
+    int n = 0;
+    while(len >= 12 && n < max) {
+        request_t *r = &requests[n++];
+        r->t_id = (uint16_t)((p[0] << 8) | p[1]);
+        r->slave_id = p[6];
+        r->function = p[7];
+        r->address = (uint16_t)((p[8] << 8) | p[9]);
+        r->quantity = (uint16_t)((p[10] << 8) | p[11]);
+        p += 12;
+        len -= 12;
+    }
+    mock_transport_clear(gobj_mock);
+    return n;
+}
+
+/***************************************************************************
+ *  Content of the registers of the slaves
+ ***************************************************************************/
+PRIVATE uint16_t register_value(hgobj gobj, int slave_id, int function, int address)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(slave_id == 1 && function == 0x04) {
+        switch(address) {
+            case 0: return priv->a;
+            case 255: return priv->x_hi;
+            case 256: return priv->x_lo;
+            case 300: return priv->b;
+            default: return 0;
+        }
+    }
+    if(slave_id == 1 && function == 0x03) {
+        return address == 1000? priv->h : 0;
+    }
+    if(slave_id == 2 && function == 0x04) {
+        return address == 10? priv->c : 0;
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Append the response of the read request, a modbus TCP frame
+ ***************************************************************************/
+PRIVATE void append_response(hgobj gobj, gbuffer_t *gbuf, request_t *r)
+{
+    uint8_t pdu[2 + 1 + 2*MAX_REGISTERS];
+    int pdu_len = 0;
+
+    pdu[pdu_len++] = r->slave_id;
+    pdu[pdu_len++] = r->function;
+    pdu[pdu_len++] = (uint8_t)(r->quantity * 2);    // byte count
+    for(int i=0; i<r->quantity && i<MAX_REGISTERS; i++) {
+        uint16_t v = register_value(gobj, r->slave_id, r->function, r->address + i);
+        pdu[pdu_len++] = (uint8_t)(v >> 8);
+        pdu[pdu_len++] = (uint8_t)(v & 0xFF);
+    }
+
+    uint8_t mbap[6];
+    mbap[0] = (uint8_t)(r->t_id >> 8);
+    mbap[1] = (uint8_t)(r->t_id & 0xFF);
+    mbap[2] = 0;
+    mbap[3] = 0;
+    mbap[4] = (uint8_t)(pdu_len >> 8);
+    mbap[5] = (uint8_t)(pdu_len & 0xFF);
+
+    gbuffer_append(gbuf, mbap, sizeof(mbap));
+    gbuffer_append(gbuf, pdu, (size_t)pdu_len);
+}
+
+/***************************************************************************
+ *  A whole cycle: due, all the requests answered, published
+ ***************************************************************************/
+PRIVATE int run_cycle(hgobj gobj, hgobj gobj_modbus)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    request_t requests[MAX_REQUESTS];
+
+    json_array_clear(priv->jn_messages);
+
+    usleep((TIMEOUT_POLLING + 50) * 1000);
+    gobj_send_event(gobj_modbus, EV_TIMEOUT, 0, gobj);
+
+    int n;
+    while((n = get_requests(gobj_modbus, requests, MAX_REQUESTS)) > 0) {
+        gbuffer_t *gbuf = gbuffer_create(256, 4*1024);
+        for(int i=0; i<n; i++) {
+            append_response(gobj, gbuf, &requests[i]);
+        }
+        gobj_send_event(
+            gobj_modbus,
+            EV_RX_DATA,
+            json_pack("{s:I}", "gbuffer", (json_int_t)(uintptr_t)gbuf),
+            gobj_bottom_gobj(gobj_modbus)
+        );
+    }
+
+    return check(gobj, gobj_in_this_state(gobj_modbus, ST_CONNECTED), "cycle ended");
+}
+
+/***************************************************************************
+ *  Message published of the slave in the last cycle
+ ***************************************************************************/
+PRIVATE json_t *published(hgobj gobj, int slave_id)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_t *message = NULL;
+    size_t idx; json_t *jn_message;
+    json_array_foreach(priv->jn_messages, idx, jn_message) {
+        if(kw_get_int(gobj, jn_message, "slave_id", 0, 0) == slave_id) {
+            message = jn_message;
+        }
+    }
+    return message;
+}
+
+/***************************************************************************
+ *  Variables in the message of the slave, without slave_id
+ ***************************************************************************/
+PRIVATE int variables_published(hgobj gobj, int slave_id)
+{
+    json_t *message = published(gobj, slave_id);
+    if(!message) {
+        return 0;
+    }
+    return (int)json_object_size(message) - 1;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE BOOL value_is(hgobj gobj, int slave_id, const char *variable, json_int_t value)
+{
+    json_t *message = published(gobj, slave_id);
+    if(!message) {
+        return FALSE;
+    }
+    json_t *jn_value = json_object_get(message, variable);
+    return (json_is_integer(jn_value) && json_integer_value(jn_value) == value)? TRUE:FALSE;
+}
+
+/***************************************************************************
+ *  1) Cells in several pages
+ ***************************************************************************/
+PRIVATE int test_cells(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    int result = 0;
+
+    priv->a = 1;
+    priv->x_hi = 0x0002;
+    priv->x_lo = 0x0003;
+    priv->b = 4;
+    priv->h = 5;
+    priv->c = 6;
+
+    /*
+     *  The first cycle publishes all, also with publish_changes_only
+     */
+    result += run_cycle(gobj, priv->gobj_changes);
+    result += check(gobj, json_array_size(priv->jn_messages) == 2, "first: a message by slave");
+    result += check(gobj, variables_published(gobj, 1) == 4, "first: all of slave 1");
+    result += check(gobj, variables_published(gobj, 2) == 1, "first: all of slave 2");
+    result += check(gobj, value_is(gobj, 1, "a", 1), "a, page 0");
+    result += check(gobj, value_is(gobj, 1, "x", 0x00020003), "x, pages 0 and 1");
+    result += check(gobj, value_is(gobj, 1, "b", 4), "b, page 1");
+    result += check(gobj, value_is(gobj, 1, "h", 5), "h, page 3 of the holding registers");
+    result += check(gobj, value_is(gobj, 2, "c", 6), "c");
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "cells ok",
+            NULL
+        );
+    }
+    return result;
+}
+
+/***************************************************************************
+ *  2) publish_changes_only
+ ***************************************************************************/
+PRIVATE int test_changes_only(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    hgobj gobj_modbus = priv->gobj_changes;
+    int result = 0;
+
+    /*
+     *  Same values: the slaves are skipped
+     */
+    result += run_cycle(gobj, gobj_modbus);
+    result += check(gobj, json_array_size(priv->jn_messages) == 0, "no changes: nothing published");
+
+    /*
+     *  The second cell of x changes, in the page 1: only x of slave 1
+     */
+    priv->x_lo = 0x0007;
+    result += run_cycle(gobj, gobj_modbus);
+    result += check(gobj, json_array_size(priv->jn_messages) == 1, "x: only slave 1");
+    result += check(gobj, variables_published(gobj, 1) == 1, "x: only x");
+    result += check(gobj, value_is(gobj, 1, "x", 0x00020007), "x: the new value");
+
+    /*
+     *  The changes are cleared at publish
+     */
+    result += run_cycle(gobj, gobj_modbus);
+    result += check(gobj, json_array_size(priv->jn_messages) == 0, "x: published once");
+
+    /*
+     *  A change by slave, in other pages
+     */
+    priv->h = 8;
+    priv->c = 9;
+    result += run_cycle(gobj, gobj_modbus);
+    result += check(gobj, json_array_size(priv->jn_messages) == 2, "h and c: both slaves");
+    result += check(gobj, variables_published(gobj, 1) == 1 && value_is(gobj, 1, "h", 8),
+        "h: only h"
+    );
+    result += check(gobj, variables_published(gobj, 2) == 1 && value_is(gobj, 2, "c", 9),
+        "c: only c"
+    );
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "changes only ok",
+            NULL
+        );
+    }
+    return result;
+}
+
+/***************************************************************************
+ *  3) Without publish_changes_only
+ ***************************************************************************/
+PRIVATE int test_publish_all(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    hgobj gobj_modbus = priv->gobj_all;
+    int result = 0;
+
+    for(int i=0; i<2; i++) {
+        result += run_cycle(gobj, gobj_modbus);
+        result += check(gobj, json_array_size(priv->jn_messages) == 2, "all: a message by slave");
+        result += check(gobj, variables_published(gobj, 1) == 4, "all: all of slave 1");
+        result += check(gobj, variables_published(gobj, 2) == 1, "all: all of slave 2");
+        result += check(gobj, value_is(gobj, 1, "x", 0x00020007), "all: x");
+    }
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "publish all ok",
+            NULL
+        );
+    }
+    return result;
+}
+
+
+
+
+                    /***************************
+                     *      Actions
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Run the checks and die
+ ***************************************************************************/
+PRIVATE int ac_test_run(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    helper_quote2doublequote(modbus_config);
+
+    json_t *kw_changes = string2json(modbus_config, TRUE);
+    json_object_set_new(kw_changes, "publish_changes_only", json_true());
+    priv->gobj_changes = open_modbus(gobj, "changes", kw_changes);
+
+    json_t *kw_all = string2json(modbus_config, TRUE);
+    priv->gobj_all = open_modbus(gobj, "all", kw_all);
+
+    /*
+     *  The first cycle begins a second after the connection
+     */
+    usleep(1100*1000);
+
+    test_cells(gobj);
+    test_changes_only(gobj);
+    test_publish_all(gobj);
+
+    close_modbus(priv->gobj_changes);
+    close_modbus(priv->gobj_all);
+    priv->gobj_changes = 0;
+    priv->gobj_all = 0;
+
+    set_yuno_must_die();
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Variables of a slave, keep them
+ ***************************************************************************/
+PRIVATE int ac_on_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_array_append(priv->jn_messages, kw);
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_on_open(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_on_close(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *                          FSM
+ ***************************************************************************/
+/*---------------------------------------------*
+ *          Global methods table
+ *---------------------------------------------*/
+PRIVATE const GMETHODS gmt = {
+    .mt_create  = mt_create,
+    .mt_destroy = mt_destroy,
+    .mt_start   = mt_start,
+    .mt_stop    = mt_stop,
+    .mt_play    = mt_play,
+    .mt_pause   = mt_pause,
+};
+
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DEFINE_GCLASS(C_CELLS);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+GOBJ_DEFINE_EVENT(EV_TEST_RUN);
+
+/***************************************************************************
+ *          Create the GClass
+ ***************************************************************************/
+PRIVATE int create_gclass(gclass_name_t gclass_name)
+{
+    static hgclass __gclass__ = 0;
+    if(__gclass__) {
+        gobj_log_error(0, 0,
+            "function", "%s", __FUNCTION__,
+            "msgset",   "%s", MSGSET_INTERNAL,
+            "msg",      "%s", "GClass ALREADY created",
+            "gclass",   "%s", gclass_name,
+            NULL
+        );
+        return -1;
+    }
+
+    /*------------------------*
+     *      States
+     *------------------------*/
+    ev_action_t st_idle[] = {
+        {EV_TEST_RUN,               ac_test_run,            0},
+        {EV_ON_MESSAGE,             ac_on_message,          0},
+        {EV_ON_OPEN,                ac_on_open,             0},
+        {EV_ON_CLOSE,               ac_on_close,            0},
+        {0,0,0}
+    };
+
+    states_t states[] = {
+        {ST_IDLE,       st_idle},
+        {0, 0}
+    };
+
+    /*------------------------*
+     *      Events
+     *------------------------*/
+    event_type_t event_types[] = {
+        {EV_TEST_RUN,               0},
+        {EV_ON_MESSAGE,             0},
+        {EV_ON_OPEN,                0},
+        {EV_ON_CLOSE,               0},
+        {NULL, 0}
+    };
+
+    /*----------------------------------------*
+     *          Register GClass
+     *----------------------------------------*/
+    __gclass__ = gclass_create(
+        gclass_name,
+        event_types,
+        states,
+        &gmt,
+        0, // local methods
+        attrs_table,
+        sizeof(PRIVATE_DATA),
+        authz_table,
+        0, // command_table
+        s_user_trace_level,
+        0 // gcflags
+    );
+    if(!__gclass__) {
+        // Error already logged
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *              Public access
+ ***************************************************************************/
+PUBLIC int register_c_cells(void)
+{
+    return create_gclass(C_CELLS);
+}
@@ -0,0 +1,41 @@
+/****************************************************************************
+ *          C_CELLS.H
+ *
+ *          A gclass to test the cells and the publish of C_PROT_MODBUS_M over C_MOCK_TRANSPORT
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#pragma once
+
+#include <yunetas.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/***************************************************************
+ *              FSM
+ ***************************************************************/
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DECLARE_GCLASS(C_CELLS);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+GOBJ_DECLARE_EVENT(EV_TEST_RUN);        // posted from mt_play, the checks run in the loop
+
+/***************************************************************
+ *              Prototypes
+ ***************************************************************/
+PUBLIC int register_c_cells(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,353 @@
+/***********************************************************************
+ *          C_MOCK_TRANSPORT.C
+ *
+ *          Bottom gobj of a protocol under test, in place of C_TCP.
+ *
+ *          EV_TX_DATA and EV_TX_FILE (the range read from the file) are
+ *          appended to the wire, in the order they are sent.
+ *          EV_DROP, EV_PAUSE_RX and EV_RESUME_RX are counted in the
+ *          attributes, nothing else is done with them.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ***********************************************************************/
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "c_mock_transport.h"
+
+/***************************************************************************
+ *              Constants
+ ***************************************************************************/
+
+/***************************************************************************
+ *              Structures
+ ***************************************************************************/
+
+/***************************************************************************
+ *              Prototypes
+ ***************************************************************************/
+PRIVATE int wire_append(hgobj gobj, const char *bf, size_t len);
+
+/***************************************************************************
+ *          Data: config, public data, private data
+ ***************************************************************************/
+/*---------------------------------------------*
+ *      Attributes
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t attrs_table[] = {
+/*-ATTR-type------------name----------------flag----------------default-----description--*/
+SDATA (DTP_INTEGER,     "drops",            SDF_RD,             "0",        "EV_DROP received"),
+SDATA (DTP_INTEGER,     "pauses",           SDF_RD,             "0",        "EV_PAUSE_RX received"),
+SDATA (DTP_INTEGER,     "resumes",          SDF_RD,             "0",        "EV_RESUME_RX received"),
+SDATA (DTP_INTEGER,     "tx_files",         SDF_RD,             "0",        "EV_TX_FILE received"),
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *      GClass trace levels
+ *---------------------------------------------*/
+PRIVATE const trace_level_t s_user_trace_level[16] = {
+{0, 0},
+};
+
+/*---------------------------------------------*
+ *              Private data
+ *---------------------------------------------*/
+typedef struct _PRIVATE_DATA {
+    char *wire;             // nul-terminated
+    size_t wire_length;
+} PRIVATE_DATA;
+
+
+
+
+                    /******************************
+                     *      Framework Methods
+                     ******************************/
+
+
+
+
+/***************************************************************************
+ *      Framework Method create
+ ***************************************************************************/
+PRIVATE void mt_create(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->wire = GBMEM_MALLOC(1);
+    if(priv->wire) {
+        priv->wire[0] = 0;
+    }
+}
+
+/***************************************************************************
+ *      Framework Method destroy
+ ***************************************************************************/
+PRIVATE void mt_destroy(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    GBMEM_FREE(priv->wire)
+}
+
+
+
+
+                    /***************************
+                     *      Local Methods
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int wire_append(hgobj gobj, const char *bf, size_t len)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    char *wire = GBMEM_REALLOC(priv->wire, priv->wire_length + len + 1);
+    if(!wire) {
+        // Error already logged
+        return -1;
+    }
+    memcpy(wire + priv->wire_length, bf, len);
+    priv->wire_length += len;
+    wire[priv->wire_length] = 0;
+    priv->wire = wire;
+    return 0;
+}
+
+
+
+
+                    /***************************
+                     *      Actions
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_tx_data(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    gbuffer_t *gbuf = gobj_event_gbuffer(gobj, kw);
+    if(gbuf) {
+        wire_append(gobj, gbuffer_cur_rd_pointer(gbuf), gbuffer_leftbytes(gbuf));
+    }
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  The range of the file goes to the wire, as sendfile() would do
+ ***************************************************************************/
+PRIVATE int ac_tx_file(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    const char *path = kw_get_str(gobj, kw, "path", "", KW_REQUIRED);
+    json_int_t offset = kw_get_int(gobj, kw, "offset", 0, 0);
+    json_int_t length = kw_get_int(gobj, kw, "length", 0, KW_REQUIRED);
+
+    gobj_write_integer_attr(gobj, "tx_files", gobj_read_integer_attr(gobj, "tx_files") + 1);
+
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_SYSTEM,
+            "msg",          "%s", "Cannot open file to send",
+            "path",         "%s", path,
+            NULL
+        );
+        KW_DECREF(kw)
+        return -1;
+    }
+
+    char bf[4096];
+    while(length > 0) {
+        size_t n = length < (json_int_t)sizeof(bf)? (size_t)length : sizeof(bf);
+        ssize_t r = pread(fd, bf, n, (off_t)offset);
+        if(r <= 0) {
+            break;
+        }
+        wire_append(gobj, bf, (size_t)r);
+        offset += r;
+        length -= r;
+    }
+    close(fd);
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_drop(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    gobj_write_integer_attr(gobj, "drops", gobj_read_integer_attr(gobj, "drops") + 1);
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_pause_rx(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    gobj_write_integer_attr(gobj, "pauses", gobj_read_integer_attr(gobj, "pauses") + 1);
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_resume_rx(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    gobj_write_integer_attr(gobj, "resumes", gobj_read_integer_attr(gobj, "resumes") + 1);
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *                          FSM
+ ***************************************************************************/
+/*---------------------------------------------*
+ *          Global methods table
+ *---------------------------------------------*/
+PRIVATE const GMETHODS gmt = {
+    .mt_create  = mt_create,
+    .mt_destroy = mt_destroy,
+};
+
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DEFINE_GCLASS(C_MOCK_TRANSPORT);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+
+/***************************************************************************
+ *          Create the GClass
+ ***************************************************************************/
+PRIVATE int create_gclass(gclass_name_t gclass_name)
+{
+    static hgclass __gclass__ = 0;
+    if(__gclass__) {
+        gobj_log_error(0, 0,
+            "function", "%s", __FUNCTION__,
+            "msgset",   "%s", MSGSET_INTERNAL,
+            "msg",      "%s", "GClass ALREADY created",
+            "gclass",   "%s", gclass_name,
+            NULL
+        );
+        return -1;
+    }
+
+    /*------------------------*
+     *      States
+     *------------------------*/
+    ev_action_t st_idle[] = {
+        {EV_TX_DATA,                ac_tx_data,             0},
+        {EV_TX_FILE,                ac_tx_file,             0},
+        {EV_DROP,                   ac_drop,                0},
+        {EV_PAUSE_RX,               ac_pause_rx,            0},
+        {EV_RESUME_RX,              ac_resume_rx,           0},
+        {0,0,0}
+    };
+
+    states_t states[] = {
+        {ST_IDLE,       st_idle},
+        {0, 0}
+    };
+
+    /*------------------------*
+     *      Events
+     *------------------------*/
+    event_type_t event_types[] = {
+        {EV_TX_DATA,                0},
+        {EV_TX_FILE,                0},
+        {EV_DROP,                   0},
+        {EV_PAUSE_RX,               0},
+        {EV_RESUME_RX,              0},
+        {NULL, 0}
+    };
+
+    /*----------------------------------------*
+     *          Register GClass
+     *----------------------------------------*/
+    __gclass__ = gclass_create(
+        gclass_name,
+        event_types,
+        states,
+        &gmt,
+        0, // local methods
+        attrs_table,
+        sizeof(PRIVATE_DATA),
+        0, // authz_table
+        0, // command_table
+        s_user_trace_level,
+        0 // gcflags
+    );
+    if(!__gclass__) {
+        // Error already logged
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *              Public access
+ ***************************************************************************/
+PUBLIC int register_c_mock_transport(void)
+{
+    return create_gclass(C_MOCK_TRANSPORT);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC const char *mock_transport_wire(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    return priv->wire? priv->wire : "";
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC size_t mock_transport_wire_length(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    return priv->wire_length;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC void mock_transport_clear(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    priv->wire_length = 0;
+    if(priv->wire) {
+        priv->wire[0] = 0;
+    }
+}
@@ -0,0 +1,41 @@
+/****************************************************************************
+ *          C_MOCK_TRANSPORT.H
+ *
+ *          Bottom gobj of a protocol under test, in place of C_TCP:
+ *          keeps what the protocol writes, as it would go on the wire.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#pragma once
+
+#include <yunetas.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/***************************************************************
+ *              FSM
+ ***************************************************************/
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DECLARE_GCLASS(C_MOCK_TRANSPORT);
+
+/***************************************************************
+ *              Prototypes
+ ***************************************************************/
+PUBLIC int register_c_mock_transport(void);
+
+/*
+ *  Bytes written (EV_TX_DATA, and the ranges of EV_TX_FILE read from the file),
+ *  as a nul-terminated string. NOT yours.
+ */
+PUBLIC const char *mock_transport_wire(hgobj gobj);
+PUBLIC size_t mock_transport_wire_length(hgobj gobj);
+PUBLIC void mock_transport_clear(hgobj gobj);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,872 @@
+/***********************************************************************
+ *          C_PIPELINE.C
+ *
+ *          Test of the pipeline of C_PROT_MODBUS_M, the modbus master.
+ *          The protocol runs over C_MOCK_TRANSPORT: the requests are
+ *          read from the wire of the mock and the responses are injected
+ *          with EV_RX_DATA. The timer of the protocol is replaced by
+ *          EV_TIMEOUT sent from here, once the time is due.
+ *
+ *          What must hold:
+ *
+ *      1) The adjacent map entries of a slave are polled in one request,
+ *         the others in a request each. Up to pipeline_window requests
+ *         are in flight, each response is matched with its request by
+ *         the transaction id, in any order, also several responses in
+ *         the same data. The variables are published at the end of the
+ *         cycle.
+ *
+ *      2) A request without response is dropped at timeout_response,
+ *         the others go on and the cycle ends. Its late response is
+ *         discarded.
+ *
+ *      3) A write goes at once, and a cycle due begins with the write
+ *         still in flight.
+ *
+ *      4) Without slaves there is nothing to poll: the timer is set to
+ *         timeout_polling, not in a loop.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ***********************************************************************/
+#include <string.h>
+#include <unistd.h>
+
+#include <c_prot_modbus_m.h>
+#include "c_mock_transport.h"
+#include "c_pipeline.h"
+
+/***************************************************************************
+ *              Constants
+ ***************************************************************************/
+#define TIMEOUT_POLLING     100     // milliseconds
+#define TIMEOUT_RESPONSE    1       // seconds
+#define MAX_REQUESTS        16
+#define MAX_REGISTERS       125
+
+/*
+ *  Slave 1: input registers 0-1 and 2-3 (adjacent), holding registers 100-101
+ *  Slave 2: input registers 10 and 12 (not adjacent)
+ */
+PRIVATE char modbus_config[]= "\
+{                                                                   \n\
+    'modbus_protocol': 'TCP',                                       \n\
+    'pipeline_window': 2,                                           \n\
+    'slave_window': 2,                                              \n\
+    'coalesce': true,                                               \n\
+    'timeout_polling': 100,                                         \n\
+    'timeout_response': 1,                                          \n\
+    'slaves': [                                                     \n\
+        {                                                           \n\
+            'id': 1,                                                \n\
+            'mapping': [                                            \n\
+                {'type': 'input_register', 'address': 0, 'size': 2},    \n\
+                {'type': 'input_register', 'address': 2, 'size': 2},    \n\
+                {'type': 'holding_register', 'address': 100, 'size': 2} \n\
+            ],                                                      \n\
+            'conversion': [                                         \n\
+                {'id': 'a', 'type': 'input_register', 'format': 'uint16', 'address': 0},   \n\
+                {'id': 'b', 'type': 'input_register', 'format': 'uint32', 'address': 2},   \n\
+                {'id': 'h', 'type': 'holding_register', 'format': 'uint16', 'address': 100} \n\
+            ]                                                       \n\
+        },                                                          \n\
+        {                                                           \n\
+            'id': 2,                                                \n\
+            'mapping': [                                            \n\
+                {'type': 'input_register', 'address': 10, 'size': 1},   \n\
+                {'type': 'input_register', 'address': 12, 'size': 1}    \n\
+            ],                                                      \n\
+            'conversion': [                                         \n\
+                {'id': 'c', 'type': 'input_register', 'format': 'int16', 'address': 10},   \n\
+                {'id': 'd', 'type': 'input_register', 'format': 'uint16', 'address': 12}   \n\
+            ]                                                       \n\
+        }                                                           \n\
+    ]                                                               \n\
+}                                                                   \n\
+";
+
+/***************************************************************************
+ *              Structures
+ ***************************************************************************/
+/*
+ *  Request of modbus TCP read from the wire
+ */
+typedef struct {
+    uint16_t t_id;
+    uint8_t slave_id;
+    uint8_t function;
+    uint16_t address;
+    uint16_t quantity;      // value in the write of a single register
+} request_t;
+
+/***************************************************************************
+ *              Prototypes
+ ***************************************************************************/
+PRIVATE int check(hgobj gobj, BOOL ok, const char *what);
+
+/***************************************************************************
+ *          Data: config, public data, private data
+ ***************************************************************************/
+/*---------------------------------------------*
+ *      Attributes
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t attrs_table[] = {
+/*-ATTR-type------------name----------------flag----------------default-----description--*/
+SDATA (DTP_POINTER,     "subscriber",       0,                  0,          "Subscriber of output-events"),
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *      GClass trace levels
+ *---------------------------------------------*/
+PRIVATE const trace_level_t s_user_trace_level[16] = {
+{0, 0},
+};
+
+/*---------------------------------------------*
+ *      GClass authz levels
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t authz_table[] = {
+/*-AUTHZ-- type---------name----------------flag----alias---items---description--*/
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *              Private data
+ *---------------------------------------------*/
+typedef struct _PRIVATE_DATA {
+    hgobj gobj_modbus;      // C_PROT_MODBUS_M under test, over a C_MOCK_TRANSPORT
+    hgobj gobj_empty;       // C_PROT_MODBUS_M without slaves
+    json_t *jn_messages;    // EV_ON_MESSAGE published, in order
+    json_t *jn_polled;      // "slave_id:function:address:quantity" of the read requests
+    uint16_t a;             // slave 1, input register 0
+    uint16_t h;             // slave 1, holding register 100
+} PRIVATE_DATA;
+
+
+
+
+                    /******************************
+                     *      Framework Methods
+                     ******************************/
+
+
+
+
+/***************************************************************************
+ *      Framework Method create
+ ***************************************************************************/
+PRIVATE void mt_create(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->jn_messages = json_array();
+    priv->jn_polled = json_array();
+
+    /*
+     *  SERVICE subscription model
+     */
+    hgobj subscriber = (hgobj)gobj_read_pointer_attr(gobj, "subscriber");
+    if(subscriber) {
+        gobj_subscribe_event(gobj, NULL, NULL, subscriber);
+    }
+}
+
+/***************************************************************************
+ *      Framework Method destroy
+ ***************************************************************************/
+PRIVATE void mt_destroy(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    JSON_DECREF(priv->jn_messages)
+    JSON_DECREF(priv->jn_polled)
+}
+
+/***************************************************************************
+ *      Framework Method start
+ ***************************************************************************/
+PRIVATE int mt_start(hgobj gobj)
+{
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method stop
+ ***************************************************************************/
+PRIVATE int mt_stop(hgobj gobj)
+{
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method play
+ *
+ *  The checks run from the event loop, like any action of a gclass.
+ ***************************************************************************/
+PRIVATE int mt_play(hgobj gobj)
+{
+    gobj_post_event(gobj, EV_TEST_RUN, 0, gobj);
+
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method pause
+ ***************************************************************************/
+PRIVATE int mt_pause(hgobj gobj)
+{
+    return 0;
+}
+
+
+
+
+                    /***************************
+                     *      Local Methods
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int check(hgobj gobj, BOOL ok, const char *what)
+{
+    if(ok) {
+        return 0;
+    }
+    gobj_log_error(gobj, 0,
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_INTERNAL,
+        "msg",          "%s", "modbus pipeline check FAILED",
+        "what",         "%s", what,
+        NULL
+    );
+    return -1;
+}
+
+/***************************************************************************
+ *  A new C_PROT_MODBUS_M over C_MOCK_TRANSPORT, connected
+ ***************************************************************************/
+PRIVATE hgobj open_modbus(hgobj gobj, const char *name, json_t *kw_modbus)
+{
+    hgobj gobj_modbus = gobj_create_pure_child(name, C_PROT_MODBUS_M, kw_modbus, gobj);
+    hgobj gobj_mock = gobj_create_pure_child(name, C_MOCK_TRANSPORT, 0, gobj_modbus);
+    gobj_set_bottom_gobj(gobj_modbus, gobj_mock);
+
+    gobj_start(gobj_modbus);
+    gobj_send_event(gobj_modbus, EV_CONNECTED, 0, gobj_mock);
+    return gobj_modbus;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void close_modbus(hgobj gobj_modbus)
+{
+    gobj_stop(gobj_modbus);
+    gobj_destroy(gobj_modbus);
+}
+
+/***************************************************************************
+ *  Take the requests written in the wire
+ ***************************************************************************/
+PRIVATE int get_requests(hgobj gobj, hgobj gobj_modbus, request_t *requests, int max)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    hgobj gobj_mock = gobj_bottom_gobj(gobj_modbus);
+    const uint8_t *p = (const uint8_t *)mock_transport_wire(gobj_mock);
+    size_t len = mock_transport_wire_length(gobj_mock);
+
+    int n = 0;
+    while(len >= 12 && n < max) {
+        request_t *r = &requests[n++];
+        r->t_id = (uint16_t)((p[0] << 8) | p[1]);
+        r->slave_id = p[6];
+        r->function = p[7];
+        r->address = (uint16_t)((p[8] << 8) | p[9]);
+        r->quantity = (uint16_t)((p[10] << 8) | p[11]);
+        if(r->function != 0x06) {
+            char polled[64];
+            snprintf(polled, sizeof(polled), "%d:%d:%d:%d",
+                r->slave_id, r->function, r->address, r->quantity
+            );
+            json_array_append_new(priv->jn_polled, json_string(polled));
+        }
+        p += 12;
+        len -= 12;
+    }
+    mock_transport_clear(gobj_mock);
+    return n;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE request_t *find_request(request_t *requests, int n, int slave_id, int function)
+{
+    for(int i=0; i<n; i++) {
+        if(requests[i].slave_id == slave_id && requests[i].function == function) {
+            return &requests[i];
+        }
+    }
+    return NULL;
+}
+
+/***************************************************************************
+ *  Content of the registers of the slaves
+ ***************************************************************************/
+PRIVATE uint16_t register_value(hgobj gobj, int slave_id, int function, int address)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(slave_id == 1 && function == 0x04) {
+        switch(address) {
+            case 0: return priv->a;
+            case 2: return 0x0001;  // b: 0x00010002
+            case 3: return 0x0002;
+            default: return 0;
+        }
+    }
+    if(slave_id == 1 && function == 0x03) {
+        return address == 100? priv->h : 0;
+    }
+    if(slave_id == 2 && function == 0x04) {
+        switch(address) {
+            case 10: return 0xFFFE; // c: -2
+            case 12: return 3;      // d
+            default: return 0;
+        }
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Append the response of the request, a modbus TCP frame
+ ***************************************************************************/
+PRIVATE void append_response(hgobj gobj, gbuffer_t *gbuf, request_t *r)
+{
+    uint8_t pdu[2 + 1 + 2*MAX_REGISTERS];
+    int pdu_len = 0;
+
+    pdu[pdu_len++] = r->slave_id;
+    pdu[pdu_len++] = r->function;
+    if(r->function == 0x06) {
+        /*
+         *  Write single register: the echo of the request
+         */
+        pdu[pdu_len++] = (uint8_t)(r->address >> 8);
+        pdu[pdu_len++] = (uint8_t)(r->address & 0xFF);
+        pdu[pdu_len++] = (uint8_t)(r->quantity >> 8);
+        pdu[pdu_len++] = (uint8_t)(r->quantity & 0xFF);
+    } else {
+        pdu[pdu_len++] = (uint8_t)(r->quantity * 2);    // byte count
+        for(int i=0; i<r->quantity && i<MAX_REGISTERS; i++) {
+            uint16_t v = register_value(gobj, r->slave_id, r->function, r->address + i);
+            pdu[pdu_len++] = (uint8_t)(v >> 8);
+            pdu[pdu_len++] = (uint8_t)(v & 0xFF);
+        }
+    }
+
+    uint8_t mbap[6];
+    mbap[0] = (uint8_t)(r->t_id >> 8);
+    mbap[1] = (uint8_t)(r->t_id & 0xFF);
+    mbap[2] = 0;
+    mbap[3] = 0;
+    mbap[4] = (uint8_t)(pdu_len >> 8);
+    mbap[5] = (uint8_t)(pdu_len & 0xFF);
+
+    gbuffer_append(gbuf, mbap, sizeof(mbap));
+    gbuffer_append(gbuf, pdu, (size_t)pdu_len);
+}
+
+/***************************************************************************
+ *  Bytes from the slaves
+ ***************************************************************************/
+PRIVATE void rx(hgobj gobj_modbus, gbuffer_t *gbuf)
+{
+    gobj_send_event(
+        gobj_modbus,
+        EV_RX_DATA,
+        json_pack("{s:I}", "gbuffer", (json_int_t)(uintptr_t)gbuf),
+        gobj_bottom_gobj(gobj_modbus)
+    );
+}
+
+/***************************************************************************
+ *  Answer the requests in the wire, and the new ones they bring.
+ *  The responses of each round go in the same data.
+ ***************************************************************************/
+PRIVATE void answer_all(hgobj gobj, hgobj gobj_modbus)
+{
+    request_t requests[MAX_REQUESTS];
+    int n;
+    while((n = get_requests(gobj, gobj_modbus, requests, MAX_REQUESTS)) > 0) {
+        gbuffer_t *gbuf = gbuffer_create(256, 4*1024);
+        for(int i=0; i<n; i++) {
+            append_response(gobj, gbuf, &requests[i]);
+        }
+        rx(gobj_modbus, gbuf);
+    }
+}
+
+/***************************************************************************
+ *  Last message published of the slave
+ ***************************************************************************/
+PRIVATE json_t *published(hgobj gobj, int slave_id)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_t *message = NULL;
+    size_t idx; json_t *jn_message;
+    json_array_foreach(priv->jn_messages, idx, jn_message) {
+        if(kw_get_int(gobj, jn_message, "slave_id", 0, 0) == slave_id) {
+            message = jn_message;
+        }
+    }
+    return message;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE BOOL value_is(hgobj gobj, int slave_id, const char *variable, json_int_t value)
+{
+    json_t *message = published(gobj, slave_id);
+    if(!message) {
+        return FALSE;
+    }
+    json_t *jn_value = json_object_get(message, variable);
+    return (json_is_integer(jn_value) && json_integer_value(jn_value) == value)? TRUE:FALSE;
+}
+
+/***************************************************************************
+ *  Timeout set in the timer of the protocol
+ ***************************************************************************/
+PRIVATE json_int_t timer_msec(hgobj gobj_modbus)
+{
+    for(hgobj child = gobj_first_child(gobj_modbus); child; child = gobj_next_child(child)) {
+        if(gobj_typeof_gclass(child, C_TIMER)) {
+            return gobj_read_integer_attr(child, "msec");
+        }
+    }
+    return -1;
+}
+
+/***************************************************************************
+ *  1) Coalescing, transactions, responses out of order
+ ***************************************************************************/
+PRIVATE int test_cycle(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    hgobj gobj_modbus = priv->gobj_modbus;
+    int result = 0;
+    request_t requests[MAX_REQUESTS];
+
+    priv->a = 5;
+    priv->h = 7;
+    json_array_clear(priv->jn_messages);
+    json_array_clear(priv->jn_polled);
+
+    /*
+     *  The first cycle is due: pipeline_window requests in flight
+     */
+    gobj_send_event(gobj_modbus, EV_TIMEOUT, 0, gobj);
+    int n = get_requests(gobj, gobj_modbus, requests, MAX_REQUESTS);
+    result += check(gobj, n == 2, "cycle: 2 requests in flight");
+    result += check(gobj, gobj_in_this_state(gobj_modbus, ST_WAIT_RESPONSE), "cycle: waiting");
+
+    request_t *r = find_request(requests, n, 1, 0x04);
+    result += check(gobj, r && r->address == 0 && r->quantity == 4,
+        "coalesced: adjacent map entries in one request"
+    );
+    request_t r_slave1 = r? *r : (request_t){0};
+    r = find_request(requests, n, 2, 0x04);
+    result += check(gobj, r && r->address == 10 && r->quantity == 1, "not adjacent: alone");
+    request_t r_slave2 = r? *r : (request_t){0};
+    result += check(gobj, r_slave1.t_id != r_slave2.t_id, "a t_id by request");
+
+    /*
+     *  The last request answered first, its room goes to the next block
+     */
+    gbuffer_t *gbuf = gbuffer_create(256, 4*1024);
+    append_response(gobj, gbuf, &r_slave2);
+    rx(gobj_modbus, gbuf);
+
+    n = get_requests(gobj, gobj_modbus, requests, MAX_REQUESTS);
+    result += check(gobj, n == 1, "the response frees a place");
+    r = find_request(requests, n, 1, 0x03);
+    result += check(gobj, r && r->address == 100 && r->quantity == 2, "next block of slave 1");
+    request_t r_holding = r? *r : (request_t){0};
+
+    /*
+     *  Two responses in the same data, the newer first
+     */
+    gbuf = gbuffer_create(256, 4*1024);
+    append_response(gobj, gbuf, &r_holding);
+    append_response(gobj, gbuf, &r_slave1);
+    rx(gobj_modbus, gbuf);
+    result += check(gobj, json_array_size(priv->jn_messages) == 0, "no publish before the end");
+
+    answer_all(gobj, gobj_modbus);
+    result += check(gobj, json_array_size(priv->jn_polled) == 4, "4 requests by cycle");
+    result += check(gobj, kw_find_str_in_list(gobj, priv->jn_polled, "2:4:12:1") >= 0,
+        "the map entry after the gap"
+    );
+    result += check(gobj, gobj_in_this_state(gobj_modbus, ST_CONNECTED), "cycle: ended");
+    result += check(gobj, json_array_size(priv->jn_messages) == 2, "cycle: a message by slave");
+    result += check(gobj, value_is(gobj, 1, "a", 5), "a");
+    result += check(gobj, value_is(gobj, 1, "b", 0x00010002), "b, two registers");
+    result += check(gobj, value_is(gobj, 1, "h", 7), "h");
+    result += check(gobj, value_is(gobj, 2, "c", -2), "c");
+    result += check(gobj, value_is(gobj, 2, "d", 3), "d");
+    json_int_t msec = timer_msec(gobj_modbus);
+    result += check(gobj, msec > TIMEOUT_POLLING - 10 && msec <= TIMEOUT_POLLING,
+        "next cycle in timeout_polling"
+    );
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "cycle ok",
+            NULL
+        );
+    }
+    return result;
+}
+
+/***************************************************************************
+ *  2) Response timeout
+ ***************************************************************************/
+PRIVATE int test_response_timeout(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    hgobj gobj_modbus = priv->gobj_modbus;
+    int result = 0;
+    request_t requests[MAX_REQUESTS];
+
+    priv->h = 8;
+    json_array_clear(priv->jn_messages);
+
+    usleep((TIMEOUT_POLLING + 50) * 1000);
+    gobj_send_event(gobj_modbus, EV_TIMEOUT, 0, gobj);
+    int n = get_requests(gobj, gobj_modbus, requests, MAX_REQUESTS);
+    request_t *r = find_request(requests, n, 1, 0x04);
+    result += check(gobj, r != NULL, "timeout: request of slave 1");
+    request_t r_lost = r? *r : (request_t){0};
+
+    /*
+     *  All answered but the input registers of slave 1
+     */
+    gbuffer_t *gbuf = gbuffer_create(256, 4*1024);
+    for(int i=0; i<n; i++) {
+        if(requests[i].t_id != r_lost.t_id) {
+            append_response(gobj, gbuf, &requests[i]);
+        }
+    }
+    rx(gobj_modbus, gbuf);
+    answer_all(gobj, gobj_modbus);
+    result += check(gobj, gobj_in_this_state(gobj_modbus, ST_WAIT_RESPONSE), "timeout: waiting");
+    result += check(gobj, json_array_size(priv->jn_messages) == 0, "timeout: cycle not ended");
+
+    /*
+     *  timeout_response: dropped and the cycle ends
+     */
+    usleep((TIMEOUT_RESPONSE * 1000 + 100) * 1000);
+    gobj_send_event(gobj_modbus, EV_TIMEOUT, 0, gobj);
+    result += check(gobj, gobj_in_this_state(gobj_modbus, ST_CONNECTED), "timeout: cycle ended");
+    result += check(gobj, json_array_size(priv->jn_messages) == 2, "timeout: published");
+    result += check(gobj, value_is(gobj, 1, "h", 8), "timeout: the other blocks stored");
+    result += check(gobj, value_is(gobj, 1, "a", 5), "timeout: previous value kept");
+
+    /*
+     *  The late response is discarded
+     */
+    priv->a = 99;
+    gbuf = gbuffer_create(256, 4*1024);
+    append_response(gobj, gbuf, &r_lost);
+    rx(gobj_modbus, gbuf);
+    result += check(gobj, gobj_in_this_state(gobj_modbus, ST_CONNECTED), "late: discarded");
+    result += check(gobj, get_requests(gobj, gobj_modbus, requests, MAX_REQUESTS) == 0, "late: no request");
+    result += check(gobj, json_array_size(priv->jn_messages) == 2, "late: no publish");
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "response timeout ok",
+            NULL
+        );
+    }
+    return result;
+}
+
+/***************************************************************************
+ *  3) Writes and polls
+ ***************************************************************************/
+PRIVATE int test_write_in_flight(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    hgobj gobj_modbus = priv->gobj_modbus;
+    int result = 0;
+    request_t requests[MAX_REQUESTS];
+
+    priv->a = 6;
+    json_array_clear(priv->jn_messages);
+
+    /*
+     *  The write goes at once, the cycle is not due
+     */
+    json_t *kw_write = json_pack("{s:i, s:s, s:i, s:i}",
+        "id", 1,
+        "type", "holding_register",
+        "address", 100,
+        "value", 9
+    );
+    gobj_send_event(gobj_modbus, EV_SEND_MESSAGE, kw_write, gobj);
+    int n = get_requests(gobj, gobj_modbus, requests, MAX_REQUESTS);
+    request_t *r = find_request(requests, n, 1, 0x06);
+    result += check(gobj, n == 1 && r && r->address == 100 && r->quantity == 9, "write sent");
+    request_t r_write = r? *r : (request_t){0};
+
+    /*
+     *  The cycle is due: it begins with the write in flight
+     */
+    usleep((TIMEOUT_POLLING + 50) * 1000);
+    gobj_send_event(gobj_modbus, EV_TIMEOUT, 0, gobj);
+    n = get_requests(gobj, gobj_modbus, requests, MAX_REQUESTS);
+    result += check(gobj, n == 1 && requests[0].function != 0x06, "poll with the write in flight");
+
+    gbuffer_t *gbuf = gbuffer_create(256, 4*1024);
+    append_response(gobj, gbuf, &r_write);
+    for(int i=0; i<n; i++) {
+        append_response(gobj, gbuf, &requests[i]);
+    }
+    rx(gobj_modbus, gbuf);
+    answer_all(gobj, gobj_modbus);
+
+    result += check(gobj, gobj_in_this_state(gobj_modbus, ST_CONNECTED), "write: cycle ended");
+    result += check(gobj, value_is(gobj, 1, "a", 6), "write: polled");
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "write in flight ok",
+            NULL
+        );
+    }
+    return result;
+}
+
+/***************************************************************************
+ *  4) Without slaves
+ ***************************************************************************/
+PRIVATE int test_no_slaves(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    hgobj gobj_empty = priv->gobj_empty;
+    int result = 0;
+
+    gobj_send_event(gobj_empty, EV_TIMEOUT, 0, gobj);
+    result += check(gobj, gobj_in_this_state(gobj_empty, ST_CONNECTED), "no slaves: connected");
+    result += check(gobj, mock_transport_wire_length(gobj_bottom_gobj(gobj_empty)) == 0,
+        "no slaves: nothing sent"
+    );
+    result += check(gobj, timer_msec(gobj_empty) == TIMEOUT_POLLING, "no slaves: timeout_polling");
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "no slaves ok",
+            NULL
+        );
+    }
+    return result;
+}
+
+
+
+
+                    /***************************
+                     *      Actions
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Run the checks and die
+ ***************************************************************************/
+PRIVATE int ac_test_run(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    helper_quote2doublequote(modbus_config);
+    json_t *kw_modbus = string2json(modbus_config, TRUE);
+    priv->gobj_modbus = open_modbus(gobj, "modbus", kw_modbus);
+
+    json_t *kw_empty = json_pack("{s:s, s:i, s:[]}",
+        "modbus_protocol", "TCP",
+        "timeout_polling", TIMEOUT_POLLING,
+        "slaves"
+    );
+    priv->gobj_empty = open_modbus(gobj, "empty", kw_empty);
+
+    /*
+     *  The first cycle begins a second after the connection
+     */
+    usleep(1100*1000);
+
+    test_cycle(gobj);
+    test_response_timeout(gobj);
+    test_write_in_flight(gobj);
+    test_no_slaves(gobj);
+
+    close_modbus(priv->gobj_modbus);
+    close_modbus(priv->gobj_empty);
+    priv->gobj_modbus = 0;
+    priv->gobj_empty = 0;
+
+    set_yuno_must_die();
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Variables of a slave, keep them
+ ***************************************************************************/
+PRIVATE int ac_on_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_array_append(priv->jn_messages, kw);
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_on_open(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_on_close(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *                          FSM
+ ***************************************************************************/
+/*---------------------------------------------*
+ *          Global methods table
+ *---------------------------------------------*/
+PRIVATE const GMETHODS gmt = {
+    .mt_create  = mt_create,
+    .mt_destroy = mt_destroy,
+    .mt_start   = mt_start,
+    .mt_stop    = mt_stop,
+    .mt_play    = mt_play,
+    .mt_pause   = mt_pause,
+};
+
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DEFINE_GCLASS(C_PIPELINE);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+GOBJ_DEFINE_EVENT(EV_TEST_RUN);
+
+/***************************************************************************
+ *          Create the GClass
+ ***************************************************************************/
+PRIVATE int create_gclass(gclass_name_t gclass_name)
+{
+    static hgclass __gclass__ = 0;
+    if(__gclass__) {
+        gobj_log_error(0, 0,
+            "function", "%s", __FUNCTION__,
+            "msgset",   "%s", MSGSET_INTERNAL,
+            "msg",      "%s", "GClass ALREADY created",
+            "gclass",   "%s", gclass_name,
+            NULL
+        );
+        return -1;
+    }
+
+    /*------------------------*
+     *      States
+     *------------------------*/
+    ev_action_t st_idle[] = {
+        {EV_TEST_RUN,               ac_test_run,            0},
+        {EV_ON_MESSAGE,             ac_on_message,          0},
+        {EV_ON_OPEN,                ac_on_open,             0},
+        {EV_ON_CLOSE,               ac_on_close,            0},
+        {0,0,0}
+    };
+
+    states_t states[] = {
+        {ST_IDLE,       st_idle},
+        {0, 0}
+    };
+
+    /*------------------------*
+     *      Events
+     *------------------------*/
+    event_type_t event_types[] = {
+        {EV_TEST_RUN,               0},
+        {EV_ON_MESSAGE,             0},
+        {EV_ON_OPEN,                0},
+        {EV_ON_CLOSE,               0},
+        {NULL, 0}
+    };
+
+    /*----------------------------------------*
+     *          Register GClass
+     *----------------------------------------*/
+    __gclass__ = gclass_create(
+        gclass_name,
+        event_types,
+        states,
+        &gmt,
+        0, // local methods
+        attrs_table,
+        sizeof(PRIVATE_DATA),
+        authz_table,
+        0, // command_table
+        s_user_trace_level,
+        0 // gcflags
+    );
+    if(!__gclass__) {
+        // Error already logged
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *              Public access
+ ***************************************************************************/
+PUBLIC int register_c_pipeline(void)
+{
+    return create_gclass(C_PIPELINE);
+}
@@ -0,0 +1,490 @@
+/***********************************************************************
+ *          C_TEST5.C
+ *
+ *          A class to test C_TCP / C_TCP_S
+ *          Test: a burst of messages with a shared body (gbuffer_iov payload)
+ *
+ *          Tasks
+ *          - Play pepon as server with echo
+ *          - Open __out_side__
+ *          - On open, send N messages to C_TCP at the same time,
+ *            all of them with the same shared body.
+ *            The 4 bytes header of C_PROT_TCP4H is the own head of each message.
+ *          - EV_TX_READY must come once, from the loop, not inside the EV_TX_DATA
+ *          - On N received messages shutdown
+ *
+ *          Copyright (c) 2026 by ArtGins.
+ *          All Rights Reserved.
+ ***********************************************************************/
+#include <string.h>
+#include <arpa/inet.h>
+
+#include <c_pepon.h>
+#include "c_test5.h"
+
+/***************************************************************************
+ *              Constants
+ ***************************************************************************/
+#define MESSAGE     "Holaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+#define N_MESSAGES  1000
+
+/***************************************************************************
+ *              Structures
+ ***************************************************************************/
+
+/***************************************************************************
+ *              Prototypes
+ ***************************************************************************/
+
+/***************************************************************************
+ *          Data: config, public data, private data
+ ***************************************************************************/
+
+/*---------------------------------------------*
+ *      Attributes
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t attrs_table[] = {
+/*-ATTR-type------------name----------------flag----------------default-----description--*/
+SDATA (DTP_INTEGER,     "timeout",          SDF_RD,             "1000",     "Timeout"),
+SDATA (DTP_POINTER,     "user_data",        0,                  0,          "user data"),
+SDATA (DTP_POINTER,     "user_data2",       0,                  0,          "more user data"),
+SDATA (DTP_POINTER,     "subscriber",       0,                  0,          "subscriber of output-events. Not a child gobj."),
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *      GClass trace levels
+ *---------------------------------------------*/
+enum {
+    TRACE_MESSAGES  = 0x0001,
+};
+PRIVATE const trace_level_t s_user_trace_level[16] = {
+{"messages",        "Trace messages"},
+{0, 0},
+};
+
+/*---------------------------------------------*
+ *              Private data
+ *---------------------------------------------*/
+typedef struct _PRIVATE_DATA {
+    json_int_t timeout;
+    hgobj timer;
+
+    hgobj pepon;
+
+    hgobj gobj_output_side;
+    json_int_t txMsgs;
+    json_int_t rxMsgs;
+    json_int_t tx_ready;
+    BOOL sending;           // inside the EV_TX_DATA of the burst
+} PRIVATE_DATA;
+
+
+
+
+
+                    /******************************
+                     *      Framework Methods
+                     ******************************/
+
+
+
+
+/***************************************************************************
+ *      Framework Method create
+ ***************************************************************************/
+PRIVATE void mt_create(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->timer = gobj_create_pure_child(gobj_name(gobj), C_TIMER, 0, gobj);
+    json_t *kw_pepon = json_pack("{s:b}",
+        "do_echo", 1
+    );
+    priv->pepon = gobj_create_pure_child("server", C_PEPON, kw_pepon, gobj);
+
+    /*
+     *  Do copy of heavy-used parameters, for quick access.
+     *  HACK The writable attributes must be repeated in mt_writing method.
+     */
+    SET_PRIV(timeout,               gobj_read_integer_attr)
+}
+
+/***************************************************************************
+ *      Framework Method start
+ ***************************************************************************/
+PRIVATE int mt_start(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gobj_start(priv->timer);
+    if(!gobj_is_running(priv->pepon)) {
+        gobj_start(priv->pepon);
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method stop
+ ***************************************************************************/
+PRIVATE int mt_stop(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gobj_stop(priv->timer);
+    gobj_stop(priv->pepon);
+
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method play
+ *  Yuneta rule:
+ *  If service has mt_play then start only the service gobj.
+ *      (Let mt_play be responsible to start their tree)
+ *  If service has not mt_play then start the tree with gobj_start_tree().
+ ***************************************************************************/
+PRIVATE int mt_play(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gobj_play(priv->pepon);
+    set_timeout(priv->timer, 1000); // timeout to connecting
+
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method pause
+ ***************************************************************************/
+PRIVATE int mt_pause(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    clear_timeout(priv->timer);
+    gobj_pause(priv->pepon);
+
+    return 0;
+}
+
+
+
+                    /***************************
+                     *      Commands
+                     ***************************/
+
+
+
+
+                    /***************************
+                     *      Local Methods
+                     ***************************/
+
+
+
+
+                    /***************************
+                     *      Actions
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Gps connected
+ ***************************************************************************/
+PRIVATE int ac_on_open(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    set_timeout(priv->timer, 1000); // timeout to start sending messages
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_timeout_to_connect(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->gobj_output_side = gobj_find_service("__output_side__", TRUE);
+    gobj_subscribe_event(priv->gobj_output_side, NULL, 0, gobj);
+    gobj_start_tree(priv->gobj_output_side);
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  All the messages are sent before returning to the loop,
+ *  the first is written at once, the rest go to the tx queue.
+ ***************************************************************************/
+PRIVATE int ac_timeout_send_messages(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    hgobj gobj_tcp = gobj_search_path(
+        priv->gobj_output_side,
+        "C_CHANNEL^output`C_PROT_TCP4H^output`C_TCP^output"
+    );
+    if(!gobj_tcp) {
+        gobj_log_error(0, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "C_TCP not found",
+            NULL
+        );
+        set_yuno_must_die();
+        JSON_DECREF(kw)
+        return -1;
+    }
+    gobj_subscribe_event(gobj_tcp, EV_TX_READY, 0, gobj);
+
+    size_t len = strlen(MESSAGE);
+    gbuffer_t *gbuf_body = gbuffer_create(len, len);
+    gbuffer_append(gbuf_body, MESSAGE, len);
+
+    priv->sending = TRUE;
+    for(int i=0; i<N_MESSAGES; i++) {
+        uint32_t header = htonl((uint32_t)(sizeof(header) + len));
+        gbuffer_t *gbuf_head = gbuffer_create(sizeof(header), sizeof(header));
+        gbuffer_append(gbuf_head, &header, sizeof(header));
+
+        gobj_send_event_payload(
+            gobj_tcp,
+            EV_TX_DATA,
+            0,
+            gobj_payload_create_gbuffer_iov(gbuf_head, gbuffer_incref(gbuf_body)),
+            gobj
+        );
+        priv->txMsgs++;
+    }
+    priv->sending = FALSE;
+
+    GBUFFER_DECREF(gbuf_body)
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_tx_ready(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->sending) {
+        gobj_log_error(0, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "EV_TX_READY inside EV_TX_DATA",
+            "txMsgs",       "%d", (int)priv->txMsgs,
+            NULL
+        );
+    }
+    priv->tx_ready++;
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_on_close(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_on_message(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->rxMsgs++;
+
+    gbuffer_t *gbuf = (gbuffer_t *)(uintptr_t)kw_get_int(gobj, kw, "gbuffer", 0, 0);
+
+    if(gobj_trace_level(gobj) & TRACE_MESSAGES) {
+        gobj_trace_dump_gbuf(gobj, gbuf, "%s <== %s", gobj_short_name(gobj), gobj_short_name(src));
+    }
+
+    size_t len = strlen(MESSAGE);
+    if(!gbuf || gbuffer_leftbytes(gbuf) != len ||
+            memcmp(gbuffer_cur_rd_pointer(gbuf), MESSAGE, len)!=0) {
+        gobj_log_error(0, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "Message is not the same",
+            "rxMsgs",       "%d", (int)priv->rxMsgs,
+            NULL
+        );
+    }
+
+    if(priv->rxMsgs == N_MESSAGES) {
+        if(priv->tx_ready != 1) {
+            gobj_log_error(0, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_INTERNAL,
+                "msg",          "%s", "EV_TX_READY must be published once",
+                "tx_ready",     "%d", (int)priv->tx_ready,
+                NULL
+            );
+        } else {
+            gobj_log_warning(0, 0,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_INTERNAL,
+                "msg",          "%s", "All shared messages are the same",
+                NULL
+            );
+        }
+        set_yuno_must_die();
+    }
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int ac_stopped(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    gobj_log_info(0, 0,
+        "msgset",           "%s", MSGSET_INFO,
+        "msg",              "%s", "child stopped",
+        "src",              "%s", gobj_full_name(src),
+        NULL
+    );
+
+    JSON_DECREF(kw)
+
+    if(gobj_is_volatil(src)) {
+        gobj_log_info(0, 0,
+            "msgset",           "%s", MSGSET_INFO,
+            "msg",              "%s", "child destroyed",
+            "src",              "%s", gobj_full_name(src),
+            NULL
+        );
+        gobj_destroy(src);
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *                          FSM
+ ***************************************************************************/
+/*---------------------------------------------*
+ *          Global methods table
+ *---------------------------------------------*/
+PRIVATE const GMETHODS gmt = {
+    .mt_create = mt_create,
+    .mt_start = mt_start,
+    .mt_stop = mt_stop,
+    .mt_play = mt_play,
+    .mt_pause = mt_pause,
+};
+
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DEFINE_GCLASS(C_TEST5);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int create_gclass(gclass_name_t gclass_name)
+{
+    static hgclass __gclass__ = 0;
+    if(__gclass__) {
+        gobj_log_error(0, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "GClass ALREADY created",
+            "gclass",       "%s", gclass_name,
+            NULL
+        );
+        return -1;
+    }
+
+    /*----------------------------------------*
+     *          Define States
+     *----------------------------------------*/
+    ev_action_t st_closed[] = {
+        {EV_STOPPED,                ac_stopped,                 0},
+        {EV_TIMEOUT,                ac_timeout_to_connect,      0},
+        {EV_ON_OPEN,                ac_on_open,                 ST_OPENED},
+        {0,0,0}
+    };
+    ev_action_t st_opened[] = {
+        {EV_ON_MESSAGE,             ac_on_message,              0},
+        {EV_ON_CLOSE,               ac_on_close,                ST_CLOSED},
+        {EV_TX_READY,               ac_tx_ready,                0},
+        {EV_TIMEOUT,                ac_timeout_send_messages,   0},
+        {0,0,0}
+    };
+
+    states_t states[] = {
+        {ST_CLOSED,                 st_closed},
+        {ST_OPENED,                 st_opened},
+        {0, 0}
+    };
+
+    event_type_t event_types[] = {
+        {EV_ON_OPEN,                0},
+        {EV_ON_MESSAGE,             0},
+        {EV_ON_CLOSE,               0},
+        {EV_TX_READY,               0},
+        {EV_TIMEOUT,                0},
+        {EV_STOPPED,                0},
+        {0, 0}
+    };
+
+    /*----------------------------------------*
+     *          Create the gclass
+     *----------------------------------------*/
+    __gclass__ = gclass_create(
+        gclass_name,
+        event_types,
+        states,
+        &gmt,
+        0,  // lmt,
+        attrs_table,
+        sizeof(PRIVATE_DATA),
+        0,  // authz_table,
+        0,  // command_table,
+        s_user_trace_level,  // s_user_trace_level,
+        0   // gcflag_t
+    );
+    if(!__gclass__) {
+        // Error already logged
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC int register_c_test5(void)
+{
+    return create_gclass(C_TEST5);
+}
@@ -0,0 +1,50 @@
+/****************************************************************************
+ *          C_TEST5.H
+ *
+ *          A class to test C_TCP / C_TCP_S
+ *          Test: a burst of messages with a shared body (gbuffer_iov payload)
+ *
+ *          Tasks
+ *          - Play pepon as server with echo
+ *          - Open __out_side__
+ *          - On open, send N messages to C_TCP at the same time,
+ *            all of them with the same shared body
+ *          - EV_TX_READY must come once, from the loop, not inside the EV_TX_DATA
+ *          - On N received messages shutdown
+ *
+ *          Copyright (c) 2026, Artgins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#pragma once
+
+#include <yunetas.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/***************************************************************
+ *              FSM
+ ***************************************************************/
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DECLARE_GCLASS(C_TEST5);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+
+/***************************************************************
+ *              Prototypes
+ ***************************************************************/
+PUBLIC int register_c_test5(void);
+
+
+#ifdef __cplusplus
+}
+#endif
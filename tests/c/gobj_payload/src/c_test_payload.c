@@ -0,0 +1,576 @@
+/***********************************************************************
+ *          C_TEST_PAYLOAD.C
+ *
+ *          Test of the typed event payloads: gobj_send_event_payload()
+ *          and gobj_publish_event_payload().
+ *
+ *          What must hold:
+ *
+ *      1) Registering a type is idempotent by name, and a payload gives
+ *         back its pointer only for its own type.
+ *
+ *      2) An EVF_PAYLOAD action gets the payload with
+ *         gobj_event_payload() and no kw is built for it. A plain send
+ *         from inside that action does not see the payload, and the
+ *         payload is visible again when it returns. Out of the dispatch
+ *         there is no payload.
+ *
+ *      3) An action not marked EVF_PAYLOAD gets the json view of the
+ *         payload as kw, so old receivers keep working.
+ *
+ *      4) gobj_event_gbuffer() gives the gbuffer of a payload, and the
+ *         "gbuffer" of the kw when the event came the old way.
+ *
+ *      5) Publishing, each subscriber gets a reference, and the pointer
+ *         is freed once, when the last one goes. The json view is built
+ *         when a subscription filter needs it.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ***********************************************************************/
+#include <string.h>
+
+#include "c_test_payload.h"
+
+/***************************************************************************
+ *              Constants
+ ***************************************************************************/
+#define BOX_N           7
+#define GBUFFER_DATA    "binary frame"
+
+/***************************************************************************
+ *              Structures
+ ***************************************************************************/
+typedef struct {
+    int n;
+} test_box_t;
+
+/***************************************************************************
+ *              Prototypes
+ ***************************************************************************/
+PRIVATE int check_int(hgobj gobj, const char *what, json_int_t value, json_int_t expected);
+
+/***************************************************************************
+ *          Data: config, public data, private data
+ ***************************************************************************/
+PRIVATE payload_type_t box_type = 0;
+PRIVATE int boxes_freed = 0;
+
+/*---------------------------------------------*
+ *      Attributes
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t attrs_table[] = {
+/*-ATTR-type------------name----------------flag----------------default-----description--*/
+SDATA (DTP_POINTER,     "subscriber",       0,                  0,          "Subscriber of output-events"),
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *      GClass trace levels
+ *---------------------------------------------*/
+PRIVATE const trace_level_t s_user_trace_level[16] = {
+{0, 0},
+};
+
+/*---------------------------------------------*
+ *      GClass authz levels
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t authz_table[] = {
+/*-AUTHZ-- type---------name----------------flag----alias---items---description--*/
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *              Private data
+ *---------------------------------------------*/
+typedef struct _PRIVATE_DATA {
+    int aware;                      // EV_TEST_AWARE received
+    int legacy;                     // EV_TEST_LEGACY received
+    int gbuffers;                   // EV_TEST_GBUFFER received with the expected data
+    int last_n;                     // n of the last box, by payload or by kw
+} PRIVATE_DATA;
+
+
+
+
+                    /******************************
+                     *      Framework Methods
+                     ******************************/
+
+
+
+
+/***************************************************************************
+ *      Framework Method create
+ ***************************************************************************/
+PRIVATE void mt_create(hgobj gobj)
+{
+    /*
+     *  SERVICE subscription model
+     */
+    hgobj subscriber = (hgobj)gobj_read_pointer_attr(gobj, "subscriber");
+    if(subscriber) {
+        gobj_subscribe_event(gobj, NULL, NULL, subscriber);
+    }
+}
+
+/***************************************************************************
+ *      Framework Method destroy
+ ***************************************************************************/
+PRIVATE void mt_destroy(hgobj gobj)
+{
+}
+
+/***************************************************************************
+ *      Framework Method start
+ ***************************************************************************/
+PRIVATE int mt_start(hgobj gobj)
+{
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method stop
+ ***************************************************************************/
+PRIVATE int mt_stop(hgobj gobj)
+{
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method play
+ *
+ *  The checks run from the event loop, like any action of a gclass.
+ ***************************************************************************/
+PRIVATE int mt_play(hgobj gobj)
+{
+    gobj_post_event(gobj, EV_TEST_RUN, 0, gobj);
+
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method pause
+ ***************************************************************************/
+PRIVATE int mt_pause(hgobj gobj)
+{
+    return 0;
+}
+
+
+
+
+                    /***************************
+                     *      Local Methods
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  The "test_box" payload type
+ ***************************************************************************/
+PRIVATE void box_free(void *ptr)
+{
+    boxes_freed++;
+    GBMEM_FREE(ptr)
+}
+
+PRIVATE json_t *box_json(void *ptr)
+{
+    test_box_t *box = ptr;
+    return json_pack("{s:i}",
+        "n", box->n
+    );
+}
+
+PRIVATE gobj_payload_t *new_box_payload(int n)
+{
+    test_box_t *box = GBMEM_MALLOC(sizeof(test_box_t));
+    box->n = n;
+    return gobj_payload_create(box_type, box);
+}
+
+/***************************************************************************
+ *  Log an error if the value is not the expected one
+ ***************************************************************************/
+PRIVATE int check_int(hgobj gobj, const char *what, json_int_t value, json_int_t expected)
+{
+    if(value == expected) {
+        return 0;
+    }
+
+    gobj_log_error(gobj, 0,
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_INTERNAL,
+        "msg",          "%s", "Unexpected value",
+        "what",         "%s", what,
+        "value",        "%ld", (long)value,
+        "expected",     "%ld", (long)expected,
+        NULL
+    );
+    return -1;
+}
+
+/***************************************************************************
+ *  1) to 4): types and gobj_send_event_payload()
+ ***************************************************************************/
+PRIVATE int test_send(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    int result = 0;
+
+    /*
+     *  1) Types
+     */
+    box_type = gobj_payload_type_register("test_box", box_free, box_json);
+    result += check_int(gobj, "box type registered", box_type > 0, TRUE);
+    result += check_int(gobj, "register is idempotent",
+        gobj_payload_type_register("test_box", box_free, box_json), box_type
+    );
+    result += check_int(gobj, "gbuffer type is not the box type",
+        gobj_payload_type_gbuffer() != box_type, TRUE
+    );
+
+    gobj_payload_t *payload = new_box_payload(BOX_N);
+    result += check_int(gobj, "payload type", gobj_payload_type(payload), box_type);
+    result += check_int(gobj, "ptr of another type",
+        gobj_payload_ptr(payload, gobj_payload_type_gbuffer()) == NULL, TRUE
+    );
+    gobj_payload_decref(payload);
+    result += check_int(gobj, "freed by the last decref", boxes_freed, 1);
+
+    /*
+     *  2) EVF_PAYLOAD receiver, nested send
+     */
+    boxes_freed = 0;
+    gobj_send_event_payload(gobj, EV_TEST_AWARE, 0, new_box_payload(BOX_N), gobj);
+    result += check_int(gobj, "aware received", priv->aware, 1);
+    result += check_int(gobj, "aware n", priv->last_n, BOX_N);
+    result += check_int(gobj, "freed after the aware send", boxes_freed, 1);
+    result += check_int(gobj, "no payload out of the dispatch", gobj_event_payload() == NULL, TRUE);
+
+    /*
+     *  3) Unmarked receiver: the json view as kw
+     */
+    boxes_freed = 0;
+    priv->last_n = 0;
+    gobj_send_event_payload(gobj, EV_TEST_LEGACY, 0, new_box_payload(BOX_N), gobj);
+    result += check_int(gobj, "legacy received", priv->legacy, 1);
+    result += check_int(gobj, "legacy n from the kw", priv->last_n, BOX_N);
+    result += check_int(gobj, "freed after the legacy send", boxes_freed, 1);
+
+    /*
+     *  4) gbuffer, by payload and the old way by kw
+     */
+    gbuffer_t *gbuf = gbuffer_create(256, 256);
+    gbuffer_append_string(gbuf, GBUFFER_DATA);
+
+    gbuffer_incref(gbuf);
+    gobj_send_event_payload(gobj, EV_TEST_GBUFFER, 0, gobj_payload_create_gbuffer(gbuf), gobj);
+    result += check_int(gobj, "gbuffer of the payload", priv->gbuffers, 1);
+    result += check_int(gobj, "gbuffer released by the payload", gbuf->refcount, 1);
+
+    gbuffer_incref(gbuf);
+    gobj_send_event(gobj, EV_TEST_GBUFFER, json_pack("{s:I}",
+        "gbuffer", (json_int_t)(uintptr_t)gbuf
+    ), gobj);
+    result += check_int(gobj, "gbuffer of the kw", priv->gbuffers, 2);
+    result += check_int(gobj, "gbuffer released by the kw", gbuf->refcount, 1);
+
+    GBUFFER_DECREF(gbuf)
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "payload send ok",
+            NULL
+        );
+    }
+
+    return result;
+}
+
+/***************************************************************************
+ *  5) gobj_publish_event_payload()
+ ***************************************************************************/
+PRIVATE int test_publish(hgobj gobj)
+{
+    int result = 0;
+
+    hgobj sub1 = gobj_create("sub1", C_TEST_PAYLOAD, 0, gobj);
+    hgobj sub2 = gobj_create("sub2", C_TEST_PAYLOAD, 0, gobj);
+    PRIVATE_DATA *priv1 = gobj_priv_data(sub1);
+    PRIVATE_DATA *priv2 = gobj_priv_data(sub2);
+
+    gobj_subscribe_event(gobj, EV_TEST_AWARE, 0, sub1);
+    gobj_subscribe_event(gobj, EV_TEST_AWARE, 0, sub2);
+    gobj_subscribe_event(gobj, EV_TEST_LEGACY, 0, sub1);
+    gobj_subscribe_event(gobj, EV_TEST_LEGACY, json_pack("{s:{s:i}}",
+        "__filter__",
+            "n", BOX_N + 1
+    ), sub2);
+
+    /*
+     *  A reference each, freed once
+     */
+    boxes_freed = 0;
+    gobj_publish_event_payload(gobj, EV_TEST_AWARE, 0, new_box_payload(BOX_N));
+    result += check_int(gobj, "aware sub1", priv1->aware, 1);
+    result += check_int(gobj, "aware sub2", priv2->aware, 1);
+    result += check_int(gobj, "aware n sub2", priv2->last_n, BOX_N);
+    result += check_int(gobj, "freed once after publish", boxes_freed, 1);
+
+    /*
+     *  The filter needs json: the view is built and sub2 filtered out
+     */
+    boxes_freed = 0;
+    gobj_publish_event_payload(gobj, EV_TEST_LEGACY, 0, new_box_payload(BOX_N));
+    result += check_int(gobj, "legacy sub1", priv1->legacy, 1);
+    result += check_int(gobj, "legacy n sub1", priv1->last_n, BOX_N);
+    result += check_int(gobj, "legacy sub2 filtered", priv2->legacy, 0);
+    result += check_int(gobj, "freed once after filtered publish", boxes_freed, 1);
+
+    gobj_destroy(sub1);
+    gobj_destroy(sub2);
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "payload publish ok",
+            NULL
+        );
+    }
+
+    return result;
+}
+
+
+
+
+                    /***************************
+                     *      Actions
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Run the checks and die
+ ***************************************************************************/
+PRIVATE int ac_test_run(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    test_send(gobj);
+    test_publish(gobj);
+
+    set_yuno_must_die();
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  EVF_PAYLOAD: the box comes by payload, no kw
+ ***************************************************************************/
+PRIVATE int ac_test_aware(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gobj_payload_t *payload = gobj_event_payload();
+    test_box_t *box = gobj_payload_ptr(payload, box_type);
+    if(!box || kw) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "An EVF_PAYLOAD action without its payload, or with a kw built",
+            NULL
+        );
+        KW_DECREF(kw)
+        return -1;
+    }
+    priv->aware++;
+    priv->last_n = box->n;
+
+    /*
+     *  A plain send doesn't see it, and it's back after
+     */
+    gobj_send_event(gobj, EV_TEST_NESTED, 0, gobj);
+    if(gobj_event_payload() != payload) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "The payload was not restored after a nested send",
+            NULL
+        );
+    }
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Not marked: the box comes as its json view
+ ***************************************************************************/
+PRIVATE int ac_test_legacy(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->legacy++;
+    priv->last_n = (int)kw_get_int(gobj, kw, "n", 0, KW_REQUIRED);
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Sent from inside ac_test_aware(), without payload
+ ***************************************************************************/
+PRIVATE int ac_test_nested(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    if(gobj_event_payload()) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "A nested send without payload sees the payload",
+            NULL
+        );
+    }
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  The gbuffer, by payload or by kw
+ ***************************************************************************/
+PRIVATE int ac_test_gbuffer(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    gbuffer_t *gbuf = gobj_event_gbuffer(gobj, kw);
+    if(gbuf && gbuffer_leftbytes(gbuf) == strlen(GBUFFER_DATA) &&
+            memcmp(gbuffer_cur_rd_pointer(gbuf), GBUFFER_DATA, strlen(GBUFFER_DATA))==0) {
+        priv->gbuffers++;
+    } else {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "The gbuffer of the event is not the one sent",
+            NULL
+        );
+    }
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *                          FSM
+ ***************************************************************************/
+/*---------------------------------------------*
+ *          Global methods table
+ *---------------------------------------------*/
+PRIVATE const GMETHODS gmt = {
+    .mt_create  = mt_create,
+    .mt_destroy = mt_destroy,
+    .mt_start   = mt_start,
+    .mt_stop    = mt_stop,
+    .mt_play    = mt_play,
+    .mt_pause   = mt_pause,
+};
+
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DEFINE_GCLASS(C_TEST_PAYLOAD);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+GOBJ_DEFINE_EVENT(EV_TEST_RUN);
+GOBJ_DEFINE_EVENT(EV_TEST_AWARE);
+GOBJ_DEFINE_EVENT(EV_TEST_LEGACY);
+GOBJ_DEFINE_EVENT(EV_TEST_NESTED);
+GOBJ_DEFINE_EVENT(EV_TEST_GBUFFER);
+
+/***************************************************************************
+ *          Create the GClass
+ ***************************************************************************/
+PRIVATE int create_gclass(gclass_name_t gclass_name)
+{
+    static hgclass __gclass__ = 0;
+    if(__gclass__) {
+        gobj_log_error(0, 0,
+            "function", "%s", __FUNCTION__,
+            "msgset",   "%s", MSGSET_INTERNAL,
+            "msg",      "%s", "GClass ALREADY created",
+            "gclass",   "%s", gclass_name,
+            NULL
+        );
+        return -1;
+    }
+
+    /*------------------------*
+     *      States
+     *------------------------*/
+    ev_action_t st_idle[] = {
+        {EV_TEST_RUN,               ac_test_run,            0},
+        {EV_TEST_AWARE,             ac_test_aware,          0},
+        {EV_TEST_LEGACY,            ac_test_legacy,         0},
+        {EV_TEST_NESTED,            ac_test_nested,         0},
+        {EV_TEST_GBUFFER,           ac_test_gbuffer,        0},
+        {0,0,0}
+    };
+
+    states_t states[] = {
+        {ST_IDLE,       st_idle},
+        {0, 0}
+    };
+
+    /*------------------------*
+     *      Events
+     *------------------------*/
+    event_type_t event_types[] = {
+        {EV_TEST_RUN,               0},
+        {EV_TEST_AWARE,             EVF_OUTPUT_EVENT|EVF_PAYLOAD},
+        {EV_TEST_LEGACY,            EVF_OUTPUT_EVENT},
+        {EV_TEST_NESTED,            0},
+        {EV_TEST_GBUFFER,           EVF_PAYLOAD},
+        {NULL, 0}
+    };
+
+    /*----------------------------------------*
+     *          Register GClass
+     *----------------------------------------*/
+    __gclass__ = gclass_create(
+        gclass_name,
+        event_types,
+        states,
+        &gmt,
+        0, // local methods
+        attrs_table,
+        sizeof(PRIVATE_DATA),
+        authz_table,
+        0, // command_table
+        s_user_trace_level,
+        0 // gcflags
+    );
+    if(!__gclass__) {
+        // Error already logged
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *              Public access
+ ***************************************************************************/
+PUBLIC int register_c_test_payload(void)
+{
+    return create_gclass(C_TEST_PAYLOAD);
+}
@@ -0,0 +1,45 @@
+/****************************************************************************
+ *          C_TEST_PAYLOAD.H
+ *
+ *          A gclass to test the typed event payloads
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#pragma once
+
+#include <yunetas.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/***************************************************************
+ *              FSM
+ ***************************************************************/
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DECLARE_GCLASS(C_TEST_PAYLOAD);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+GOBJ_DECLARE_EVENT(EV_TEST_RUN);        // posted from mt_play, the checks run in the loop
+GOBJ_DECLARE_EVENT(EV_TEST_AWARE);      // EVF_PAYLOAD: the action reads the payload
+GOBJ_DECLARE_EVENT(EV_TEST_LEGACY);     // not marked: the action reads the kw
+GOBJ_DECLARE_EVENT(EV_TEST_NESTED);     // plain send from inside EV_TEST_AWARE
+GOBJ_DECLARE_EVENT(EV_TEST_GBUFFER);    // EVF_PAYLOAD, with gobj_event_gbuffer()
+
+/***************************************************************
+ *              Prototypes
+ ***************************************************************/
+PUBLIC int register_c_test_payload(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,713 @@
+/***********************************************************************
+ *          C_TEST_SLOTS.C
+ *
+ *          Test of the native stat slots of a gclass
+ *          (gclass_set_stats_table()) and of the attribute slots
+ *          (gobj_attr_slot()).
+ *
+ *          What must hold for the stat slots:
+ *
+ *      1) The slot of a stat is its index in the stats table, the
+ *         default_value is the initial value, and a name not in the
+ *         table has no slot.
+ *
+ *      2) gobj_{set,incr,decr,get}_stat_slot() update the value in
+ *         place, and the name functions go to the slot when the name is
+ *         in the table, not to jn_stats.
+ *
+ *      3) A stat that is not in the table stays in jn_stats, and it is
+ *         updated in place: the json integer is the same one.
+ *
+ *      4) The default stats parser renders the slots, and "__reset__"
+ *         resets the SDF_RSTATS slots and leaves the SDF_STATS gauges.
+ *
+ *      5) A bad slot is an error, not a write out of the array.
+ *
+ *          And for the attribute slots:
+ *
+ *      6) The slot of an attribute is its index in attrs_table, and a
+ *         name not in the table has no slot.
+ *
+ *      7) What is written by slot is read by name, and what is written
+ *         by name is read by slot, for every type.
+ *
+ *      8) Integer and real writes are done in place, unless the json
+ *         value is shared: then the holder keeps its old value.
+ *
+ *      9) mt_writing is called on each slot write, and mt_reading serves
+ *         the slot reads as it serves the name ones.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ***********************************************************************/
+#include <string.h>
+
+#include "c_test_slots.h"
+
+/***************************************************************************
+ *              Constants
+ ***************************************************************************/
+#define QUEUE_DEPTH_DEFAULT     5
+#define READING_VALUE           42      // what mt_reading gives for "reading"
+
+/***************************************************************************
+ *              Structures
+ ***************************************************************************/
+
+/***************************************************************************
+ *              Prototypes
+ ***************************************************************************/
+PRIVATE int check_int(hgobj gobj, const char *what, json_int_t value, json_int_t expected);
+
+/***************************************************************************
+ *          Data: config, public data, private data
+ ***************************************************************************/
+/*---------------------------------------------*
+ *      Attributes
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t attrs_table[] = {
+/*-ATTR-type------------name----------------flag----------------default-----description--*/
+SDATA (DTP_POINTER,     "subscriber",       0,                  0,          "Subscriber of output-events"),
+SDATA (DTP_STRING,      "label",            SDF_RD,             "slots",    "A string"),
+SDATA (DTP_BOOLEAN,     "enabled",          SDF_RD,             "1",        "A boolean"),
+SDATA (DTP_INTEGER,     "counter",          SDF_RD,             "0",        "An integer, written in place"),
+SDATA (DTP_REAL,        "ratio",            SDF_RD,             "0.5",      "A real, written in place"),
+SDATA (DTP_POINTER,     "ptr",              0,                  0,          "A pointer, written in place"),
+SDATA (DTP_JSON,        "jn_data",          SDF_RD,             "{}",       "A json"),
+SDATA (DTP_INTEGER,     "reading",          SDF_RD,             "0",        "Served by mt_reading"),
+SDATA_END()
+};
+enum {
+    ATTR_SUBSCRIBER = 0,
+    ATTR_LABEL,
+    ATTR_ENABLED,
+    ATTR_COUNTER,
+    ATTR_RATIO,
+    ATTR_PTR,
+    ATTR_JN_DATA,
+    ATTR_READING,
+};
+
+/*---------------------------------------------*
+ *      Native stat slots
+ *---------------------------------------------*/
+enum {
+    STAT_RX_MSGS = 0,
+    STAT_QUEUE_DEPTH,
+};
+PRIVATE const sdata_desc_t stats_table[] = {
+/*-STAT-type------------name----------------flag----------------default-----description--*/
+SDATA (DTP_INTEGER,     "rxMsgs",           SDF_RSTATS,         "0",        "Messages received, a counter"),
+SDATA (DTP_INTEGER,     "queue_depth",      SDF_STATS,          "5",        "Messages queued, a gauge"),
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *      GClass trace levels
+ *---------------------------------------------*/
+PRIVATE const trace_level_t s_user_trace_level[16] = {
+{0, 0},
+};
+
+/*---------------------------------------------*
+ *      GClass authz levels
+ *---------------------------------------------*/
+PRIVATE sdata_desc_t authz_table[] = {
+/*-AUTHZ-- type---------name----------------flag----alias---items---description--*/
+SDATA_END()
+};
+
+/*---------------------------------------------*
+ *              Private data
+ *---------------------------------------------*/
+typedef struct _PRIVATE_DATA {
+    int stat_rx_msgs;               // resolved once, as a gclass would do in mt_create
+    int stat_queue_depth;
+
+    int writes;                     // calls to mt_writing
+    char last_written[32];          // name of the last one
+} PRIVATE_DATA;
+
+
+
+
+                    /******************************
+                     *      Framework Methods
+                     ******************************/
+
+
+
+
+/***************************************************************************
+ *      Framework Method create
+ ***************************************************************************/
+PRIVATE void mt_create(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->stat_rx_msgs = gobj_stat_slot(gobj, "rxMsgs");
+    priv->stat_queue_depth = gobj_stat_slot(gobj, "queue_depth");
+
+    /*
+     *  SERVICE subscription model
+     */
+    hgobj subscriber = (hgobj)gobj_read_pointer_attr(gobj, "subscriber");
+    if(subscriber) {
+        gobj_subscribe_event(gobj, NULL, NULL, subscriber);
+    }
+}
+
+/***************************************************************************
+ *      Framework Method writing
+ ***************************************************************************/
+PRIVATE void mt_writing(hgobj gobj, const char *path)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    priv->writes++;
+    snprintf(priv->last_written, sizeof(priv->last_written), "%s", path);
+}
+
+/***************************************************************************
+ *      Framework Method reading
+ ***************************************************************************/
+PRIVATE SData_Value_t mt_reading(hgobj gobj, const char *name)
+{
+    SData_Value_t v = {0,{0}};
+    if(strcmp(name, "reading")==0) {
+        v.found = 1;
+        v.v.i = READING_VALUE;
+    }
+
+    return v;
+}
+
+/***************************************************************************
+ *      Framework Method destroy
+ ***************************************************************************/
+PRIVATE void mt_destroy(hgobj gobj)
+{
+}
+
+/***************************************************************************
+ *      Framework Method start
+ ***************************************************************************/
+PRIVATE int mt_start(hgobj gobj)
+{
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method stop
+ ***************************************************************************/
+PRIVATE int mt_stop(hgobj gobj)
+{
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method play
+ *
+ *  The checks run from the event loop, like any action of a gclass.
+ ***************************************************************************/
+PRIVATE int mt_play(hgobj gobj)
+{
+    gobj_post_event(gobj, EV_TEST_RUN, 0, gobj);
+
+    return 0;
+}
+
+/***************************************************************************
+ *      Framework Method pause
+ ***************************************************************************/
+PRIVATE int mt_pause(hgobj gobj)
+{
+    return 0;
+}
+
+
+
+
+                    /***************************
+                     *      Local Methods
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Log an error if the value is not the expected one
+ ***************************************************************************/
+PRIVATE int check_int(hgobj gobj, const char *what, json_int_t value, json_int_t expected)
+{
+    if(value == expected) {
+        return 0;
+    }
+
+    gobj_log_error(gobj, 0,
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_INTERNAL,
+        "msg",          "%s", "Unexpected value",
+        "what",         "%s", what,
+        "value",        "%ld", (long)value,
+        "expected",     "%ld", (long)expected,
+        NULL
+    );
+    return -1;
+}
+
+/***************************************************************************
+ *  The value of a stat in the response of the stats parser
+ ***************************************************************************/
+PRIVATE json_int_t stats_value(hgobj gobj, const char *stats, const char *name)
+{
+    json_t *response = gobj_stats(gobj, stats, 0, gobj);
+    json_t *jn_data = kw_get_dict(gobj, response, "data", 0, KW_REQUIRED);
+    json_int_t value = kw_get_int(gobj, jn_data, name, -1, KW_REQUIRED);
+    JSON_DECREF(response)
+    return value;
+}
+
+/***************************************************************************
+ *  Native stat slots
+ ***************************************************************************/
+PRIVATE int test_stat_slots(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    int result = 0;
+
+    /*
+     *  1) Slots, defaults, unknown names
+     */
+    result += check_int(gobj, "slot of rxMsgs", priv->stat_rx_msgs, STAT_RX_MSGS);
+    result += check_int(gobj, "slot of queue_depth", priv->stat_queue_depth, STAT_QUEUE_DEPTH);
+    result += check_int(gobj, "slot of unknown", gobj_stat_slot(gobj, "unknown"), -1);
+
+    result += check_int(gobj, "default of rxMsgs",
+        gobj_get_stat_slot(gobj, priv->stat_rx_msgs), 0
+    );
+    result += check_int(gobj, "default of queue_depth",
+        gobj_get_stat_slot(gobj, priv->stat_queue_depth), QUEUE_DEPTH_DEFAULT
+    );
+    if(gobj_stats_desc(gobj) != stats_table) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "gobj_stats_desc() is not the stats table",
+            NULL
+        );
+        result += -1;
+    }
+
+    /*
+     *  2) The slot functions, and the name functions going to the slot
+     */
+    result += check_int(gobj, "incr slot",
+        gobj_incr_stat_slot(gobj, priv->stat_rx_msgs, 3), 3
+    );
+    result += check_int(gobj, "decr slot",
+        gobj_decr_stat_slot(gobj, priv->stat_rx_msgs, 1), 2
+    );
+    result += check_int(gobj, "set slot returns the old value",
+        gobj_set_stat_slot(gobj, priv->stat_rx_msgs, 10), 2
+    );
+    result += check_int(gobj, "incr by name",
+        gobj_incr_stat(gobj, "rxMsgs", 1), 11
+    );
+    result += check_int(gobj, "get by name",
+        gobj_get_stat(gobj, "rxMsgs"), 11
+    );
+    result += check_int(gobj, "incr gauge",
+        gobj_incr_stat_slot(gobj, priv->stat_queue_depth, 2), QUEUE_DEPTH_DEFAULT + 2
+    );
+
+    if(json_object_get(gobj_jn_stats(gobj), "rxMsgs")) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "A stat of the table went to jn_stats",
+            NULL
+        );
+        result += -1;
+    }
+
+    /*
+     *  3) Not in the table: jn_stats, in place
+     */
+    result += check_int(gobj, "incr jn_stats",
+        gobj_incr_stat(gobj, "other", 4), 4
+    );
+    json_t *jn_other = json_object_get(gobj_jn_stats(gobj), "other");
+    gobj_incr_stat(gobj, "other", 1);
+    if(json_object_get(gobj_jn_stats(gobj), "other") != jn_other) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "A stat of jn_stats was not updated in place",
+            NULL
+        );
+        result += -1;
+    }
+    result += check_int(gobj, "jn_stats in place", json_integer_value(jn_other), 5);
+
+    /*
+     *  4) The stats parser renders the slots, and resets only the counters
+     */
+    result += check_int(gobj, "rendered rxMsgs", stats_value(gobj, "", "rxMsgs"), 11);
+    result += check_int(gobj, "rendered queue_depth",
+        stats_value(gobj, "", "queue_depth"), QUEUE_DEPTH_DEFAULT + 2
+    );
+
+    result += check_int(gobj, "reset rxMsgs", stats_value(gobj, "__reset__", "rxMsgs"), 0);
+    result += check_int(gobj, "reset keeps the gauge",
+        gobj_get_stat_slot(gobj, priv->stat_queue_depth), QUEUE_DEPTH_DEFAULT + 2
+    );
+    result += check_int(gobj, "reset jn_stats", gobj_get_stat(gobj, "other"), 0);
+
+    /*
+     *  5) A bad slot: error logged, nothing written
+     */
+    gobj_incr_stat_slot(gobj, STAT_QUEUE_DEPTH + 1, 1);   // "stat slot NOT FOUND"
+    result += check_int(gobj, "bad slot", gobj_get_stat_slot(gobj, -1), 0); // "stat slot NOT FOUND"
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "stat slots ok",
+            NULL
+        );
+    }
+
+    return result;
+}
+
+/***************************************************************************
+ *  Log an error if mt_writing was not called for the attribute
+ ***************************************************************************/
+PRIVATE int check_written(hgobj gobj, const char *name, int writes)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    if(priv->writes == writes + 1 && strcmp(priv->last_written, name)==0) {
+        return 0;
+    }
+
+    gobj_log_error(gobj, 0,
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_INTERNAL,
+        "msg",          "%s", "mt_writing not called by a slot write",
+        "attr",         "%s", name,
+        "writes",       "%d", priv->writes - writes,
+        "last_written", "%s", priv->last_written,
+        NULL
+    );
+    return -1;
+}
+
+/***************************************************************************
+ *  Attribute slots
+ ***************************************************************************/
+PRIVATE int test_attr_slots(hgobj gobj)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+    int result = 0;
+    int writes;
+
+    /*
+     *  6) Slots and unknown names
+     */
+    result += check_int(gobj, "slot of label", gobj_attr_slot(gobj, "label"), ATTR_LABEL);
+    result += check_int(gobj, "slot of reading", gobj_attr_slot(gobj, "reading"), ATTR_READING);
+    result += check_int(gobj, "slot of unknown", gobj_attr_slot(gobj, "unknown"), -1);
+
+    /*
+     *  7) By slot <-> by name, with mt_writing called on each slot write
+     */
+    const char *label = gobj_read_str_attr_slot(gobj, ATTR_LABEL);
+    if(!label || strcmp(label, "slots")!=0) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "Default of a str attr slot",
+            "label",        "%s", label?label:"(null)",
+            NULL
+        );
+        result += -1;
+    }
+    writes = priv->writes;
+    gobj_write_str_attr_slot(gobj, ATTR_LABEL, "written by slot");
+    result += check_written(gobj, "label", writes);
+    if(strcmp(gobj_read_str_attr(gobj, "label"), "written by slot")!=0) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "A str written by slot is not read by name",
+            "label",        "%s", gobj_read_str_attr(gobj, "label"),
+            NULL
+        );
+        result += -1;
+    }
+    gobj_write_str_attr(gobj, "label", "written by name");
+    if(strcmp(gobj_read_str_attr_slot(gobj, ATTR_LABEL), "written by name")!=0) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "A str written by name is not read by slot",
+            "label",        "%s", gobj_read_str_attr_slot(gobj, ATTR_LABEL),
+            NULL
+        );
+        result += -1;
+    }
+
+    result += check_int(gobj, "default of bool slot", gobj_read_bool_attr_slot(gobj, ATTR_ENABLED), TRUE);
+    writes = priv->writes;
+    gobj_write_bool_attr_slot(gobj, ATTR_ENABLED, FALSE);
+    result += check_written(gobj, "enabled", writes);
+    result += check_int(gobj, "bool by name", gobj_read_bool_attr(gobj, "enabled"), FALSE);
+
+    writes = priv->writes;
+    gobj_write_integer_attr_slot(gobj, ATTR_COUNTER, 7);
+    result += check_written(gobj, "counter", writes);
+    result += check_int(gobj, "integer by name", gobj_read_integer_attr(gobj, "counter"), 7);
+    gobj_write_integer_attr(gobj, "counter", 8);
+    result += check_int(gobj, "integer by slot", gobj_read_integer_attr_slot(gobj, ATTR_COUNTER), 8);
+
+    writes = priv->writes;
+    gobj_write_real_attr_slot(gobj, ATTR_RATIO, 2.5);
+    result += check_written(gobj, "ratio", writes);
+    if(gobj_read_real_attr(gobj, "ratio") != 2.5) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "A real written by slot is not read by name",
+            "ratio",        "%f", gobj_read_real_attr(gobj, "ratio"),
+            NULL
+        );
+        result += -1;
+    }
+
+    writes = priv->writes;
+    gobj_write_pointer_attr_slot(gobj, ATTR_PTR, priv);
+    result += check_written(gobj, "ptr", writes);
+    if(gobj_read_pointer_attr(gobj, "ptr") != priv ||
+            gobj_read_pointer_attr_slot(gobj, ATTR_PTR) != priv) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "A pointer written by slot is not read back",
+            NULL
+        );
+        result += -1;
+    }
+
+    writes = priv->writes;
+    gobj_write_new_json_attr_slot(gobj, ATTR_JN_DATA, json_pack("{s:i}", "n", 1));
+    result += check_written(gobj, "jn_data", writes);
+    result += check_int(gobj, "json by name",
+        kw_get_int(gobj, gobj_read_json_attr(gobj, "jn_data"), "n", 0, KW_REQUIRED), 1
+    );
+    if(gobj_read_json_attr_slot(gobj, ATTR_JN_DATA) != gobj_read_json_attr(gobj, "jn_data")) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "A json attr slot is not the jn_attrs value",
+            NULL
+        );
+        result += -1;
+    }
+
+    /*
+     *  8) In place, unless shared
+     */
+    json_t *jn_counter = gobj_read_json_attr_slot(gobj, ATTR_COUNTER);
+    gobj_write_integer_attr_slot(gobj, ATTR_COUNTER, 9);
+    if(gobj_read_json_attr_slot(gobj, ATTR_COUNTER) != jn_counter) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "An integer attr slot was not written in place",
+            NULL
+        );
+        result += -1;
+    }
+
+    json_t *jn_ratio = gobj_read_json_attr_slot(gobj, ATTR_RATIO);
+    gobj_write_real_attr_slot(gobj, ATTR_RATIO, 3.5);
+    if(gobj_read_json_attr_slot(gobj, ATTR_RATIO) != jn_ratio) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "A real attr slot was not written in place",
+            NULL
+        );
+        result += -1;
+    }
+
+    json_t *jn_shared = json_incref(gobj_read_json_attr_slot(gobj, ATTR_COUNTER));
+    gobj_write_integer_attr_slot(gobj, ATTR_COUNTER, 10);
+    result += check_int(gobj, "shared value untouched", json_integer_value(jn_shared), 9);
+    result += check_int(gobj, "new value after shared",
+        gobj_read_integer_attr_slot(gobj, ATTR_COUNTER), 10
+    );
+    result += check_int(gobj, "new value after shared, by name",
+        gobj_read_integer_attr(gobj, "counter"), 10
+    );
+    JSON_DECREF(jn_shared)
+
+    /*
+     *  9) mt_reading
+     */
+    result += check_int(gobj, "mt_reading by slot",
+        gobj_read_integer_attr_slot(gobj, ATTR_READING), READING_VALUE
+    );
+    result += check_int(gobj, "mt_reading by name",
+        gobj_read_integer_attr(gobj, "reading"), READING_VALUE
+    );
+
+    /*
+     *  A bad slot: error logged, nothing written
+     */
+    result += check_int(gobj, "bad slot",
+        gobj_write_integer_attr_slot(gobj, ATTR_READING + 1, 1), -1  // "attr slot NOT FOUND"
+    );
+
+    if(result == 0) {
+        gobj_log_info(gobj, 0,
+            "msgset",       "%s", MSGSET_INFO,
+            "msg",          "%s", "attr slots ok",
+            NULL
+        );
+    }
+
+    return result;
+}
+
+
+
+
+                    /***************************
+                     *      Actions
+                     ***************************/
+
+
+
+
+/***************************************************************************
+ *  Run the checks and die
+ ***************************************************************************/
+PRIVATE int ac_test_run(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
+{
+    test_stat_slots(gobj);
+    test_attr_slots(gobj);
+
+    set_yuno_must_die();
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *                          FSM
+ ***************************************************************************/
+/*---------------------------------------------*
+ *          Global methods table
+ *---------------------------------------------*/
+PRIVATE const GMETHODS gmt = {
+    .mt_create  = mt_create,
+    .mt_writing = mt_writing,
+    .mt_reading = mt_reading,
+    .mt_destroy = mt_destroy,
+    .mt_start   = mt_start,
+    .mt_stop    = mt_stop,
+    .mt_play    = mt_play,
+    .mt_pause   = mt_pause,
+};
+
+/*------------------------*
+ *      GClass name
+ *------------------------*/
+GOBJ_DEFINE_GCLASS(C_TEST_SLOTS);
+
+/*------------------------*
+ *      States
+ *------------------------*/
+
+/*------------------------*
+ *      Events
+ *------------------------*/
+GOBJ_DEFINE_EVENT(EV_TEST_RUN);
+
+/***************************************************************************
+ *          Create the GClass
+ ***************************************************************************/
+PRIVATE int create_gclass(gclass_name_t gclass_name)
+{
+    static hgclass __gclass__ = 0;
+    if(__gclass__) {
+        gobj_log_error(0, 0,
+            "function", "%s", __FUNCTION__,
+            "msgset",   "%s", MSGSET_INTERNAL,
+            "msg",      "%s", "GClass ALREADY created",
+            "gclass",   "%s", gclass_name,
+            NULL
+        );
+        return -1;
+    }
+
+    /*------------------------*
+     *      States
+     *------------------------*/
+    ev_action_t st_idle[] = {
+        {EV_TEST_RUN,               ac_test_run,            0},
+        {0,0,0}
+    };
+
+    states_t states[] = {
+        {ST_IDLE,       st_idle},
+        {0, 0}
+    };
+
+    /*------------------------*
+     *      Events
+     *------------------------*/
+    event_type_t event_types[] = {
+        {EV_TEST_RUN,               0},
+        {NULL, 0}
+    };
+
+    /*----------------------------------------*
+     *          Register GClass
+     *----------------------------------------*/
+    __gclass__ = gclass_create(
+        gclass_name,
+        event_types,
+        states,
+        &gmt,
+        0, // local methods
+        attrs_table,
+        sizeof(PRIVATE_DATA),
+        authz_table,
+        0, // command_table
+        s_user_trace_level,
+        0 // gcflags
+    );
+    if(!__gclass__) {
+        // Error already logged
+        return -1;
+    }
+
+    if(gclass_set_stats_table(__gclass__, stats_table) < 0) {
+        // Error already logged
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+ *              Public access
+ ***************************************************************************/
+PUBLIC int register_c_test_slots(void)
+{
+    return create_gclass(C_TEST_SLOTS);
+}
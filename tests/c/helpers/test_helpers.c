@@ -4,6 +4,7 @@
  *          Unit tests for split2() / split_free2() (string split helper).
  *          Includes a reentrancy regression: split2() must NOT clobber a
  *          caller's in-progress strtok() parse (the strtok -> strtok_r fix).
+ *          Also utf8_validate() and its gbuffer cache.
  *
  *          Copyright (c) 2026, ArtGins.
  *          All Rights Reserved.
@@ -234,6 +235,81 @@ PRIVATE void test_version_cmp(void)
     }
 }
 
+/***************************************************************************
+ *  utf8_validate(): the vectorized paths must agree with the scalar one,
+ *  also when a multibyte sequence straddles a 16/32 bytes block boundary
+ *  or is truncated at the very end.
+ ***************************************************************************/
+PRIVATE void test_utf8_validate(void)
+{
+    struct { const char *s; BOOL valid; const char *why; } cases[] = {
+        {"",                            TRUE,   "empty"},
+        {"plain ascii",                 TRUE,   "ascii"},
+        {"caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80", TRUE, "2, 3 and 4 bytes"},
+        {"\xF4\x8F\xBF\xBF",            TRUE,   "U+10FFFF"},
+        {"\xC0\xAF",                    FALSE,  "overlong 2 bytes"},
+        {"\xE0\x80\xAF",                FALSE,  "overlong 3 bytes"},
+        {"\xF0\x80\x80\xAF",            FALSE,  "overlong 4 bytes"},
+        {"\xED\xA0\x80",                FALSE,  "surrogate"},
+        {"\xF4\x90\x80\x80",            FALSE,  "above U+10FFFF"},
+        {"\xF5\x80\x80\x80",            FALSE,  "bad lead byte"},
+        {"\x80",                        FALSE,  "lonely continuation"},
+        {"\xE2\x82",                    FALSE,  "truncated"},
+        {0, 0, 0}
+    };
+
+    int failed = 0;
+    char bf[200];
+    for(int i = 0; cases[i].s; i++) {
+        size_t len = strlen(cases[i].s);
+        /*
+         *  Slide the case over every position of a 64+ bytes ascii run
+         *  to cross all the block boundaries of the simd versions.
+         */
+        for(size_t pad = 0; pad < 70; pad++) {
+            memset(bf, 'a', pad);
+            memcpy(bf + pad, cases[i].s, len);
+            if(utf8_validate(bf, pad + len) != cases[i].valid) {
+                printf("FAIL %-40s %s at offset %d\n",
+                    "utf8_validate", cases[i].why, (int)pad
+                );
+                failed++;
+                break;
+            }
+            memset(bf + pad + len, 'b', 40);
+            if(utf8_validate(bf, pad + len + 40) != cases[i].valid) {
+                printf("FAIL %-40s %s at offset %d, followed by ascii\n",
+                    "utf8_validate", cases[i].why, (int)pad
+                );
+                failed++;
+                break;
+            }
+        }
+    }
+
+    /*
+     *  gbuffer caches the validation until the gbuffer changes
+     */
+    gbuffer_t *gbuf = gbuffer_create(256, 256);
+    gbuffer_append_string(gbuf, "caf\xC3\xA9");
+    if(!gbuffer_utf8_validate(gbuf) || !gbuffer_utf8_validate(gbuf)) {
+        printf("FAIL %-40s\n", "gbuffer_utf8_validate valid");
+        failed++;
+    }
+    gbuffer_append_string(gbuf, "\xC3");
+    if(gbuffer_utf8_validate(gbuf)) {
+        printf("FAIL %-40s\n", "gbuffer_utf8_validate after append");
+        failed++;
+    }
+    gbuffer_decref(gbuf);
+
+    if(!failed) {
+        printf("ok   %-40s\n", "utf8_validate");
+    } else {
+        global_result += -1;
+    }
+}
+
 /***************************************************************************
  *              Test
  *  HACK: return -1 to fail, 0 to ok
@@ -245,6 +321,7 @@ PRIVATE int do_test(void)
     test_split_null_size_arg();
     test_split_reentrancy();
     test_version_cmp();
+    test_utf8_validate();
 
     return global_result;
 }
@@ -693,6 +693,238 @@ static int test_kw_collapse_primitive_rejected(void)
     return result;
 }
 
+/***************************************************************************
+ *  kw_path_create(): the path is compiled once, kw_path_str() returns it.
+ *  The keys have no length limit (the string walker truncated at 256).
+ ***************************************************************************/
+static int test_kw_path_compile(void)
+{
+    int result = 0;
+
+    set_expected_results(
+        "kw_path_compile",
+        json_pack("[{s:s}]",
+            "msg", "path NULL"
+        ),
+        NULL,   // expected, NULL: we want to check only the logs
+        NULL,   // ignore_keys
+        1       // verbose
+    );
+
+    kw_path_t *kw_path = kw_path_create(0, "a`b`1`c");
+    if(!kw_path || strcmp(kw_path_str(kw_path), "a`b`1`c")!=0) {
+        result += -1;
+        printf("FAIL kw_path_create path\n");
+    }
+    kw_path_destroy(kw_path);
+
+    if(kw_path_create(0, NULL) != NULL) {
+        result += -1;   // logs "path NULL"
+    }
+
+    /* a key of 300 bytes, as string and compiled path */
+    char key[301];
+    memset(key, 'k', sizeof(key)-1);
+    key[sizeof(key)-1] = 0;
+    char path[320];
+    snprintf(path, sizeof(path), "d`%s", key);
+
+    json_t *kw = json_pack("{s:{s:i}}",
+        "d",
+            key, 7
+    );
+    kw_path = kw_path_create(0, path);
+    if(json_integer_value(kw_find_path(0, kw, path, FALSE)) != 7) {
+        result += -1;
+        printf("FAIL kw_find_path long key\n");
+    }
+    if(json_integer_value(kw_path_find(0, kw, kw_path, FALSE)) != 7) {
+        result += -1;
+        printf("FAIL kw_path_find long key\n");
+    }
+    kw_path_destroy(kw_path);
+    JSON_DECREF(kw)
+
+    result += test_json(NULL);
+    return result;
+}
+
+/***************************************************************************
+ *  Lookup through dicts and lists, the string and the compiled path
+ *  must find the same json.
+ ***************************************************************************/
+static int test_kw_path_find(void)
+{
+    int result = 0;
+
+    set_expected_results( // Check that no logs happen
+        "kw_path_find",
+        NULL,   // error's list, It must not be any log error
+        NULL,   // expected, NULL: we want to check only the logs
+        NULL,   // ignore_keys
+        1       // verbose
+    );
+
+    json_t *kw = json_pack("{s:{s:[{s:i}, {s:i}]}, s:{s:s, s:n}}",
+        "a",
+            "b",
+                "c", 1,
+                "c", 2,
+        "__temp__",
+            "channel", "ch1",
+            "null"
+    );
+
+    const char *paths[] = {
+        "a",
+        "a`b",
+        "a`b`1",
+        "a`b`1`c",
+        "__temp__`channel",
+        "a`x",          // not found
+        "a`b`5`c",      // list index out of range
+        "x`y`z",        // parent not found
+        "__temp__`null`x", // parent null
+        0
+    };
+    for(int i=0; paths[i]; i++) {
+        kw_path_t *kw_path = kw_path_create(0, paths[i]);
+        json_t *v1 = kw_find_path(0, kw, paths[i], FALSE);
+        json_t *v2 = kw_path_find(0, kw, kw_path, FALSE);
+        if(v1 != v2) {
+            result += -1;
+            printf("FAIL kw_path_find '%s'\n", paths[i]);
+        }
+        if(i < 5 && !v1) {
+            result += -1;
+            printf("FAIL kw_find_path '%s' not found\n", paths[i]);
+        }
+        if(i >= 5 && v1) {
+            result += -1;
+            printf("FAIL kw_find_path '%s' found\n", paths[i]);
+        }
+        kw_path_destroy(kw_path);
+    }
+
+    kw_path_t *p_int = kw_path_create(0, "a`b`1`c");
+    kw_path_t *p_str = kw_path_create(0, "__temp__`channel");
+    kw_path_t *p_none = kw_path_create(0, "__temp__`none");
+    if(kw_path_get_int(0, kw, p_int, -1, 0) != 2) {
+        result += -1;
+        printf("FAIL kw_path_get_int\n");
+    }
+    if(strcmp(kw_path_get_str(0, kw, p_str, "", 0), "ch1")!=0) {
+        result += -1;
+        printf("FAIL kw_path_get_str\n");
+    }
+    if(kw_path_get_int(0, kw, p_none, -1, 0) != -1) {
+        result += -1;
+        printf("FAIL kw_path_get_int default\n");
+    }
+
+    /* KW_EXTRACT goes by the string path */
+    if(kw_path_get_int(0, kw, p_int, -1, KW_EXTRACT) != 2 ||
+            kw_find_path(0, kw, "a`b`1`c", FALSE)) {
+        result += -1;
+        printf("FAIL kw_path_get_int KW_EXTRACT\n");
+    }
+    kw_path_destroy(p_int);
+    kw_path_destroy(p_str);
+    kw_path_destroy(p_none);
+
+    JSON_DECREF(kw)
+
+    result += test_json(NULL);
+    return result;
+}
+
+/***************************************************************************
+ *  kw_set_dict_value(), kw_path_set_dict_value() and kw_delete():
+ *  the missing dicts are created, an existing key is not overwritten,
+ *  __temp__ is set and deleted as the gates do.
+ ***************************************************************************/
+static int test_kw_path_set_delete(void)
+{
+    int result = 0;
+
+    set_expected_results(
+        "kw_path_set_delete",
+        json_pack("[{s:s}]",
+            "msg", "path not found"
+        ),
+        NULL,   // expected, NULL: we want to check only the logs
+        NULL,   // ignore_keys
+        1       // verbose
+    );
+
+    json_t *kw = json_pack("{s:s}",
+        "id", "x"
+    );
+
+    /* string path: creates __temp__ */
+    kw_set_dict_value(0, kw, "__temp__`channel_gobj", json_integer(5));
+    /* existing key: not overwritten */
+    kw_set_dict_value(0, kw, "__temp__`channel_gobj", json_integer(6));
+
+    /* compiled path: parent exists (hot case) */
+    kw_path_t *p_channel = kw_path_create(0, "__temp__`channel");
+    kw_path_t *p_gobj = kw_path_create(0, "__temp__`channel_gobj");
+    kw_path_t *p_deep = kw_path_create(0, "a`b`c");
+    kw_path_set_dict_value(0, kw, p_channel, json_string("ch1"));
+    kw_path_set_dict_value(0, kw, p_gobj, json_integer(7));
+    /* compiled path: missing parents, created by the string version */
+    kw_path_set_dict_value(0, kw, p_deep, json_true());
+
+    json_t *expected = json_pack("{s:s, s:{s:i, s:s}, s:{s:{s:b}}}",
+        "id", "x",
+        "__temp__",
+            "channel_gobj", 5,
+            "channel", "ch1",
+        "a",
+            "b",
+                "c", 1
+    );
+    if(!json_equal(kw, expected)) {
+        result += -1;
+        printf("FAIL kw_set_dict_value\n");
+    }
+    JSON_DECREF(expected)
+
+    /* delete: by parent path, at first level, and not found */
+    if(kw_delete(0, kw, "__temp__`channel_gobj")<0) {
+        result += -1;
+    }
+    if(kw_delete(0, kw, "a`b`c")<0) {
+        result += -1;
+    }
+    if(kw_delete(0, kw, "id")<0) {
+        result += -1;
+    }
+    if(kw_delete(0, kw, "__temp__`channel_gobj") != -1) {
+        result += -1;   // logs "path not found"
+    }
+
+    expected = json_pack("{s:{s:s}, s:{s:{}}}",
+        "__temp__",
+            "channel", "ch1",
+        "a",
+            "b"
+    );
+    if(!json_equal(kw, expected)) {
+        result += -1;
+        printf("FAIL kw_delete\n");
+    }
+    JSON_DECREF(expected)
+
+    kw_path_destroy(p_channel);
+    kw_path_destroy(p_gobj);
+    kw_path_destroy(p_deep);
+    JSON_DECREF(kw)
+
+    result += test_json(NULL);
+    return result;
+}
+
 /***************************************************************************
  *              Test
  *  Open as master, check main files, add records, open rt lists
@@ -715,6 +947,9 @@ PRIVATE int do_test(void)
     result += test_reg_f004_kwid_compare_records_depth();
     result += test_kw_collapse_toplevel_array();
     result += test_kw_collapse_primitive_rejected();
+    result += test_kw_path_compile();
+    result += test_kw_path_find();
+    result += test_kw_path_set_delete();
 
     /*-------------------------------*
      *      Shutdown timeranger
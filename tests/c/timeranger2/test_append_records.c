@@ -0,0 +1,491 @@
+/****************************************************************************
+ *          test_append_records.c
+ *
+ *  Regression coverage for tranger2_append_records (grouped batch appends):
+ *      - do_test_batch:    a batch with two keys interleaved and one item
+ *                          that is not a dict. The bad item is refused and
+ *                          logged, its md has rowid 0; every key gets its
+ *                          rowids in order of arrival, as single appends do.
+ *      - do_test_continue: a second batch continues the rowids of the first,
+ *                          and a cold reload reads every record back, in
+ *                          order, with its content.
+ *      - do_test_times:    with __t__ 0 each record takes the __t__ of its
+ *                          md_records_ex, the records of a key go to the
+ *                          file of their own day (sync_contents on).
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#include <string.h>
+#include <signal.h>
+#include <limits.h>
+
+#include <gobj.h>
+#include <kwid.h>
+#include <timeranger2.h>
+#include <helpers.h>
+#include <yev_loop.h>
+#include <testing.h>
+
+#define APP "test_append_records"
+
+/***************************************************************
+ *              Constants
+ ***************************************************************/
+#define DATABASE    "tr_append_records"
+#define TOPIC_NAME  "topic_append_records"
+#define KEY1_STR    "0000000000000000001"
+#define KEY2_STR    "0000000000000000002"
+#define BASE_T      946684800   // 2000-01-01T00:00:00+0000
+
+/***************************************************************
+ *              Data
+ ***************************************************************/
+PRIVATE yev_loop_h yev_loop;
+PRIVATE int global_result = 0;
+
+PRIVATE size_t history_seen = 0;
+PRIVATE json_int_t history_rowids[8];
+PRIVATE json_int_t history_tms[8];
+PRIVATE uint64_t history_ts[8];
+
+PRIVATE int history_record_callback(
+    json_t *tranger,
+    json_t *topic,
+    const char *key,
+    json_t *list,
+    json_int_t rowid,
+    md2_record_ex_t *md_record,
+    json_t *record
+)
+{
+    if(history_seen < sizeof(history_rowids)/sizeof(history_rowids[0])) {
+        history_rowids[history_seen] = (json_int_t)md_record->rowid;
+        history_tms[history_seen] = json_integer_value(json_object_get(record, "tm"));
+        history_ts[history_seen] = md_record->__t__;
+    }
+    history_seen++;
+    JSON_DECREF(record)
+    return 0;
+}
+
+/***************************************************************
+ *              Helpers
+ ***************************************************************/
+PRIVATE void build_paths(
+    char *path_root, size_t root_sz,
+    char *path_database, size_t db_sz
+)
+{
+    const char *home = getenv("HOME");
+    build_path(path_root, root_sz, home, "tests_yuneta", NULL);
+    mkrdir(path_root, 02770);
+    build_path(path_database, db_sz, path_root, DATABASE, NULL);
+}
+
+PRIVATE json_t *startup_master(const char *path_root, BOOL sync_contents)
+{
+    json_t *jn_tranger = json_pack("{s:s, s:s, s:b, s:i, s:s, s:i, s:i, s:b}",
+        "path", path_root,
+        "database", DATABASE,
+        "master", 1,
+        "on_critical_error", LOG_OPT_TRACE_STACK,
+        "filename_mask", "%Y",
+        "xpermission" , 02770,
+        "rpermission", 0600,
+        "sync_contents", sync_contents
+    );
+    return tranger2_startup(0, jn_tranger, 0);
+}
+
+PRIVATE int create_topic(json_t *tranger)
+{
+    json_t *topic = tranger2_create_topic(
+        tranger,
+        TOPIC_NAME,
+        "id",
+        "tm",
+        json_pack("{s:i, s:s, s:i, s:i}",
+            "on_critical_error", 4,
+            "filename_mask", "%Y-%m-%d",
+            "xpermission" , 02700,
+            "rpermission", 0600
+        ),
+        sf_int_key,
+        json_pack("{s:s, s:I, s:s}",
+            "id", "",
+            "tm", (json_int_t)0,
+            "content", ""
+        ),
+        0
+    );
+    return topic? 0 : -1;
+}
+
+PRIVATE json_t *new_record(json_int_t id, json_int_t tm)
+{
+    return json_pack("{s:I, s:I, s:s}",
+        "id", id,
+        "tm", tm,
+        "content", "batch-payload"
+    );
+}
+
+/***************************************************************************
+ *  Iterate a key from rowid 1, leave rowids and tms in history_*
+ ***************************************************************************/
+PRIVATE int iterate_key(json_t *tranger, const char *key, const char *id)
+{
+    history_seen = 0;
+    memset(history_rowids, 0, sizeof(history_rowids));
+    memset(history_tms, 0, sizeof(history_tms));
+    memset(history_ts, 0, sizeof(history_ts));
+
+    json_t *iterator = tranger2_open_iterator(
+        tranger, TOPIC_NAME, key,
+        json_pack("{s:i}", "from_rowid", 1),
+        history_record_callback,
+        id,
+        NULL, NULL, NULL
+    );
+    if(!iterator) {
+        return -1;
+    }
+    tranger2_close_iterator(tranger, iterator);
+    return 0;
+}
+
+/***************************************************************************
+ *  do_test_batch
+ *  Batch [k1, k2, k1, "bad", k2, k1]: 5 appended, k1 rowids 1,2,3 and
+ *  k2 rowids 1,2 in order of arrival, the bad item with rowid 0.
+ ***************************************************************************/
+PRIVATE int do_test_batch(void)
+{
+    int result = 0;
+    char path_root[PATH_MAX], path_database[PATH_MAX];
+    build_paths(path_root, sizeof(path_root), path_database, sizeof(path_database));
+    rmrdir(path_database);
+
+    set_expected_results(
+        "batch: startup + create + append",
+        json_pack("[{s:s},{s:s},{s:s}]",
+            "msg", "Creating __timeranger2__.json",
+            "msg", "Creating topic",
+            "msg", "Cannot append record, not a dict"
+        ),
+        NULL, NULL, 1
+    );
+
+    json_t *tranger = startup_master(path_root, FALSE);
+    if(!tranger) {
+        return -1;
+    }
+    if(create_topic(tranger) < 0) {
+        tranger2_shutdown(tranger);
+        return -1;
+    }
+
+    json_t *jn_records = json_array();
+    json_array_append_new(jn_records, new_record(1, BASE_T + 0));
+    json_array_append_new(jn_records, new_record(2, BASE_T + 1));
+    json_array_append_new(jn_records, new_record(1, BASE_T + 2));
+    json_array_append_new(jn_records, json_string("not a record"));
+    json_array_append_new(jn_records, new_record(2, BASE_T + 4));
+    json_array_append_new(jn_records, new_record(1, BASE_T + 5));
+
+    md2_record_ex_t md[6];
+    int appended = tranger2_append_records(
+        tranger, TOPIC_NAME, BASE_T, 0, md, jn_records
+    );
+    if(appended != 5) {
+        printf("%sERROR%s --> batch: expected 5 appended, got %d\n",
+            On_Red BWhite, Color_Off, appended);
+        result += -1;
+    }
+
+    uint64_t expected_rowids[6] = {1, 1, 2, 0, 2, 3};
+    for(int i=0; i<6; i++) {
+        if(md[i].rowid != expected_rowids[i]) {
+            printf("%sERROR%s --> batch: item %d, expected rowid %llu, got %llu\n",
+                On_Red BWhite, Color_Off, i,
+                (unsigned long long)expected_rowids[i], (unsigned long long)md[i].rowid);
+            result += -1;
+        }
+    }
+    result += test_json(NULL);
+
+    /*-------------------------------------*
+     *  The records are there, warm
+     *-------------------------------------*/
+    set_expected_results("batch: warm iterator", NULL, NULL, NULL, 1);
+
+    if(iterate_key(tranger, KEY1_STR, "warm1") < 0) {
+        result += -1;
+    }
+    if(history_seen != 3 ||
+            history_tms[0] != BASE_T + 0 ||
+            history_tms[1] != BASE_T + 2 ||
+            history_tms[2] != BASE_T + 5) {
+        printf("%sERROR%s --> batch: key1 expected 3 records in order, got %zu\n",
+            On_Red BWhite, Color_Off, history_seen);
+        result += -1;
+    }
+    if(iterate_key(tranger, KEY2_STR, "warm2") < 0) {
+        result += -1;
+    }
+    if(history_seen != 2 ||
+            history_tms[0] != BASE_T + 1 ||
+            history_tms[1] != BASE_T + 4) {
+        printf("%sERROR%s --> batch: key2 expected 2 records in order, got %zu\n",
+            On_Red BWhite, Color_Off, history_seen);
+        result += -1;
+    }
+    result += test_json(NULL);
+
+    set_expected_results("batch: shutdown", NULL, NULL, NULL, 1);
+    tranger2_shutdown(tranger);
+    result += test_json(NULL);
+    return result;
+}
+
+/***************************************************************************
+ *  do_test_continue
+ *  On the store of do_test_batch: a second batch to key1 gets rowids 4, 5,
+ *  and a cold reload reads the 5 records of key1 in order.
+ ***************************************************************************/
+PRIVATE int do_test_continue(void)
+{
+    int result = 0;
+    char path_root[PATH_MAX], path_database[PATH_MAX];
+    build_paths(path_root, sizeof(path_root), path_database, sizeof(path_database));
+
+    set_expected_results("continue: second batch", NULL, NULL, NULL, 1);
+
+    json_t *tranger = startup_master(path_root, FALSE);
+    if(!tranger) {
+        return -1;
+    }
+    if(create_topic(tranger) < 0) {
+        tranger2_shutdown(tranger);
+        return -1;
+    }
+
+    json_t *jn_records = json_array();
+    json_array_append_new(jn_records, new_record(1, BASE_T + 6));
+    json_array_append_new(jn_records, new_record(1, BASE_T + 7));
+
+    md2_record_ex_t md[2];
+    int appended = tranger2_append_records(
+        tranger, TOPIC_NAME, BASE_T, 0, md, jn_records
+    );
+    if(appended != 2 || md[0].rowid != 4 || md[1].rowid != 5) {
+        printf("%sERROR%s --> continue: expected rowids 4, 5, got %d records %llu, %llu\n",
+            On_Red BWhite, Color_Off, appended,
+            (unsigned long long)md[0].rowid, (unsigned long long)md[1].rowid);
+        result += -1;
+    }
+    tranger2_shutdown(tranger);
+    result += test_json(NULL);
+
+    /*-------------------------------------*
+     *  Cold reload
+     *-------------------------------------*/
+    set_expected_results("continue: cold reload", NULL, NULL, NULL, 1);
+
+    tranger = startup_master(path_root, FALSE);
+    if(!tranger) {
+        return -1;
+    }
+    if(create_topic(tranger) < 0) {
+        tranger2_shutdown(tranger);
+        return -1;
+    }
+    if(iterate_key(tranger, KEY1_STR, "cold1") < 0) {
+        result += -1;
+    }
+    json_int_t expected_tms[5] = {BASE_T+0, BASE_T+2, BASE_T+5, BASE_T+6, BASE_T+7};
+    if(history_seen != 5) {
+        printf("%sERROR%s --> cold: key1 expected 5 records, got %zu\n",
+            On_Red BWhite, Color_Off, history_seen);
+        result += -1;
+    }
+    for(int i=0; i<5 && i<(int)history_seen; i++) {
+        if(history_rowids[i] != i+1 || history_tms[i] != expected_tms[i]) {
+            printf("%sERROR%s --> cold: key1 record %d, rowid %lld tm %lld\n",
+                On_Red BWhite, Color_Off, i,
+                (long long)history_rowids[i], (long long)history_tms[i]);
+            result += -1;
+        }
+    }
+    result += test_json(NULL);
+
+    set_expected_results("continue: shutdown", NULL, NULL, NULL, 1);
+    tranger2_shutdown(tranger);
+    result += test_json(NULL);
+    return result;
+}
+
+/***************************************************************************
+ *  do_test_times
+ *  Batch to key1 with __t__ 0 and the times in md_records_ex: day 1, day 2,
+ *  day 1 again. The records of day 1 share a file (rowids 1, 2), the one of
+ *  day 2 goes to its own file (rowid 1); the key reads them by time.
+ ***************************************************************************/
+PRIVATE int do_test_times(void)
+{
+    int result = 0;
+    char path_root[PATH_MAX], path_database[PATH_MAX];
+    build_paths(path_root, sizeof(path_root), path_database, sizeof(path_database));
+    rmrdir(path_database);
+
+    set_expected_results(
+        "times: startup + create + append",
+        json_pack("[{s:s},{s:s}]",
+            "msg", "Creating __timeranger2__.json",
+            "msg", "Creating topic"
+        ),
+        NULL, NULL, 1
+    );
+
+    json_t *tranger = startup_master(path_root, TRUE);
+    if(!tranger) {
+        return -1;
+    }
+    if(create_topic(tranger) < 0) {
+        tranger2_shutdown(tranger);
+        return -1;
+    }
+
+    uint64_t ts[3] = {BASE_T + 10, BASE_T + 86400, BASE_T + 20};
+    json_t *jn_records = json_array();
+    md2_record_ex_t md[3];
+    for(int i=0; i<3; i++) {
+        json_array_append_new(jn_records, new_record(1, (json_int_t)ts[i]));
+        md[i].__t__ = ts[i];
+    }
+
+    int appended = tranger2_append_records(
+        tranger, TOPIC_NAME, 0, 0, md, jn_records
+    );
+    uint64_t expected_rowids[3] = {1, 1, 2};
+    if(appended != 3) {
+        printf("%sERROR%s --> times: expected 3 appended, got %d\n",
+            On_Red BWhite, Color_Off, appended);
+        result += -1;
+    }
+    for(int i=0; i<3; i++) {
+        if(md[i].__t__ != ts[i] || md[i].rowid != expected_rowids[i]) {
+            printf("%sERROR%s --> times: item %d, __t__ %llu rowid %llu\n",
+                On_Red BWhite, Color_Off, i,
+                (unsigned long long)md[i].__t__, (unsigned long long)md[i].rowid);
+            result += -1;
+        }
+    }
+    result += test_json(NULL);
+
+    set_expected_results("times: iterator", NULL, NULL, NULL, 1);
+    if(iterate_key(tranger, KEY1_STR, "times1") < 0) {
+        result += -1;
+    }
+    uint64_t expected_ts[3] = {BASE_T + 10, BASE_T + 20, BASE_T + 86400};
+    if(history_seen != 3) {
+        printf("%sERROR%s --> times: key1 expected 3 records, got %zu\n",
+            On_Red BWhite, Color_Off, history_seen);
+        result += -1;
+    }
+    for(int i=0; i<3 && i<(int)history_seen; i++) {
+        if(history_ts[i] != expected_ts[i] || history_tms[i] != (json_int_t)expected_ts[i]) {
+            printf("%sERROR%s --> times: key1 record %d, __t__ %llu tm %lld\n",
+                On_Red BWhite, Color_Off, i,
+                (unsigned long long)history_ts[i], (long long)history_tms[i]);
+            result += -1;
+        }
+    }
+    result += test_json(NULL);
+
+    set_expected_results("times: shutdown", NULL, NULL, NULL, 1);
+    tranger2_shutdown(tranger);
+    result += test_json(NULL);
+    return result;
+}
+
+/***************************************************************************
+ *              Main
+ ***************************************************************************/
+PRIVATE void quit_sighandler(int sig)
+{
+    static int xtimes_once = 0;
+    xtimes_once++;
+    yev_loop_reset_running(yev_loop);
+    if(xtimes_once > 1) {
+        exit(-1);
+    }
+}
+
+PRIVATE void yuno_catch_signals(void)
+{
+    struct sigaction sigIntHandler;
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGTERM, SIG_IGN);
+    memset(&sigIntHandler, 0, sizeof(sigIntHandler));
+    sigIntHandler.sa_handler = quit_sighandler;
+    sigemptyset(&sigIntHandler.sa_mask);
+    sigIntHandler.sa_flags = SA_NODEFER|SA_RESTART;
+    sigaction(SIGALRM, &sigIntHandler, NULL);
+    sigaction(SIGQUIT, &sigIntHandler, NULL);
+    sigaction(SIGINT, &sigIntHandler, NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    sys_malloc_fn_t malloc_func;
+    sys_realloc_fn_t realloc_func;
+    sys_calloc_fn_t calloc_func;
+    sys_free_fn_t free_func;
+    gbmem_get_allocators(&malloc_func, &realloc_func, &calloc_func, &free_func);
+    json_set_alloc_funcs(malloc_func, free_func);
+
+    unsigned long memory_check_list[] = {0, 0};
+    set_memory_check_list(memory_check_list);
+
+    init_backtrace_with_backtrace(argv[0]);
+    set_show_backtrace_fn(show_backtrace_with_backtrace);
+
+    gobj_start_up(
+        argc, argv,
+        NULL, NULL, NULL, NULL, NULL, NULL
+    );
+
+    yuno_catch_signals();
+
+    gobj_log_add_handler("stdout", "stdout", LOG_OPT_ALL, 0);
+    gobj_log_register_handler(
+        "testing", 0, capture_log_write, 0
+    );
+    gobj_log_add_handler("test_capture", "testing", LOG_OPT_UP_INFO, 0);
+
+    yev_loop_create(0, 2024, 10, NULL, &yev_loop);
+
+    int result = 0;
+    result += do_test_batch();
+    result += do_test_continue();
+    result += do_test_times();
+    result += global_result;
+
+    yev_loop_stop(yev_loop);
+    yev_loop_destroy(yev_loop);
+
+    gobj_end();
+
+    if(get_cur_system_memory()!=0) {
+        printf("%sERROR --> %s%s\n", On_Red BWhite, "system memory not free", Color_Off);
+        print_track_mem();
+        result += -1;
+    }
+
+    if(result<0) {
+        printf("<-- %sTEST FAILED%s: %s\n", On_Red BWhite, Color_Off, APP);
+    }
+    return result<0?-1:0;
+}
@@ -0,0 +1,389 @@
+/****************************************************************************
+ *          test_iterator_rowid_runs.c
+ *
+ *  Regression coverage for the row index of FILTERED iterators, kept as
+ *  runs of consecutive rowids:
+ *      - do_test_runs:     20 rows, the filter keeps rows 1-5 and 11-15
+ *                          (two runs). tranger2_iterator_size() counts 10,
+ *                          and tranger2_iterator_get_page() maps positions
+ *                          to rowids inside a run, across the gap between
+ *                          runs, and at the end of the index.
+ *      - do_test_single:   a filter that keeps every other row (one run per
+ *                          row, the worst case) returns the same rows.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#include <string.h>
+#include <signal.h>
+#include <limits.h>
+
+#include <gobj.h>
+#include <kwid.h>
+#include <timeranger2.h>
+#include <helpers.h>
+#include <yev_loop.h>
+#include <testing.h>
+
+#define APP "test_iterator_rowid_runs"
+
+/***************************************************************
+ *              Constants
+ ***************************************************************/
+#define DATABASE    "tr_iterator_rowid_runs"
+#define TOPIC_NAME  "topic_iterator_rowid_runs"
+#define KEY_ID      1
+#define KEY_STR     "0000000000000000001"
+#define BASE_T      946684800   // 2000-01-01T00:00:00+0000
+#define N_RECORDS   20
+
+/***************************************************************
+ *              Data
+ ***************************************************************/
+PRIVATE yev_loop_h yev_loop;
+PRIVATE int global_result = 0;
+
+/***************************************************************
+ *              Helpers
+ ***************************************************************/
+PRIVATE void build_paths(
+    char *path_root, size_t root_sz,
+    char *path_database, size_t db_sz
+)
+{
+    const char *home = getenv("HOME");
+    build_path(path_root, root_sz, home, "tests_yuneta", NULL);
+    mkrdir(path_root, 02770);
+    build_path(path_database, db_sz, path_root, DATABASE, NULL);
+}
+
+PRIVATE json_t *startup_master(const char *path_root)
+{
+    json_t *jn_tranger = json_pack("{s:s, s:s, s:b, s:i, s:s, s:i, s:i}",
+        "path", path_root,
+        "database", DATABASE,
+        "master", 1,
+        "on_critical_error", LOG_OPT_TRACE_STACK,
+        "filename_mask", "%Y",
+        "xpermission" , 02770,
+        "rpermission", 0600
+    );
+    return tranger2_startup(0, jn_tranger, 0);
+}
+
+PRIVATE int create_topic(json_t *tranger)
+{
+    json_t *topic = tranger2_create_topic(
+        tranger,
+        TOPIC_NAME,
+        "id",
+        "tm",
+        json_pack("{s:i, s:s, s:i, s:i}",
+            "on_critical_error", 4,
+            "filename_mask", "%Y-%m-%d",
+            "xpermission" , 02700,
+            "rpermission", 0600
+        ),
+        sf_int_key,
+        json_pack("{s:s, s:I, s:s}",
+            "id", "",
+            "tm", (json_int_t)0,
+            "content", ""
+        ),
+        0
+    );
+    return topic? 0 : -1;
+}
+
+/***************************************************************************
+ *  Append N_RECORDS, the user_flag of row j+1 is user_flags[j]
+ ***************************************************************************/
+PRIVATE int append_flagged(json_t *tranger, const uint16_t *user_flags)
+{
+    for(int j=0; j<N_RECORDS; j++) {
+        json_t *jn_record = json_pack("{s:I, s:I, s:s}",
+            "id", (json_int_t)KEY_ID,
+            "tm", (json_int_t)(BASE_T + j),
+            "content", "payload"
+        );
+        md2_record_ex_t md = {0};
+        if(tranger2_append_record(tranger, TOPIC_NAME, BASE_T + j, user_flags[j], &md, jn_record) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Check a page: its g_rowids must be `expected` (n of them)
+ ***************************************************************************/
+PRIVATE int check_page(
+    json_t *tranger,
+    json_t *iterator,
+    const char *label,
+    json_int_t from_position,
+    size_t limit,
+    const json_int_t *expected,
+    size_t n
+)
+{
+    int result = 0;
+    json_t *page = tranger2_iterator_get_page(tranger, iterator, from_position, limit, FALSE);
+    json_t *data = json_object_get(page, "data");
+
+    if(json_array_size(data) != n) {
+        printf("%sERROR%s --> %s: expected %zu records, got %zu\n",
+            On_Red BWhite, Color_Off, label, n, json_array_size(data));
+        result += -1;
+    }
+    int idx; json_t *record;
+    json_array_foreach(data, idx, record) {
+        json_int_t g_rowid = json_integer_value(
+            json_object_get(json_object_get(record, "__md_tranger__"), "g_rowid")
+        );
+        if((size_t)idx < n && g_rowid != expected[idx]) {
+            printf("%sERROR%s --> %s: record %d, expected rowid %lld, got %lld\n",
+                On_Red BWhite, Color_Off, label, idx,
+                (long long)expected[idx], (long long)g_rowid);
+            result += -1;
+        }
+    }
+    JSON_DECREF(page)
+    return result;
+}
+
+/***************************************************************************
+ *  do_test_runs
+ ***************************************************************************/
+PRIVATE int do_test_runs(void)
+{
+    int result = 0;
+    char path_root[PATH_MAX], path_database[PATH_MAX];
+    build_paths(path_root, sizeof(path_root), path_database, sizeof(path_database));
+    rmrdir(path_database);
+
+    set_expected_results(
+        "runs: startup + create + append",
+        json_pack("[{s:s},{s:s}]",
+            "msg", "Creating __timeranger2__.json",
+            "msg", "Creating topic"
+        ),
+        NULL, NULL, 1
+    );
+
+    json_t *tranger = startup_master(path_root);
+    if(!tranger) {
+        return -1;
+    }
+    if(create_topic(tranger) < 0) {
+        tranger2_shutdown(tranger);
+        return -1;
+    }
+
+    uint16_t user_flags[N_RECORDS];
+    for(int j=0; j<N_RECORDS; j++) {
+        user_flags[j] = (j < 5 || (j >= 10 && j < 15))? 1 : 2;
+    }
+    if(append_flagged(tranger, user_flags) < 0) {
+        tranger2_shutdown(tranger);
+        return -1;
+    }
+    result += test_json(NULL);
+
+    /*-------------------------------------*
+     *  Filtered iterator: rows 1-5, 11-15
+     *-------------------------------------*/
+    set_expected_results("runs: size and pages", NULL, NULL, NULL, 1);
+
+    json_t *iterator = tranger2_open_iterator(
+        tranger, TOPIC_NAME, KEY_STR,
+        json_pack("{s:i, s:i}", "from_rowid", 1, "user_flag", 1),
+        NULL,
+        "runs",
+        NULL, NULL, NULL
+    );
+    if(!iterator) {
+        tranger2_shutdown(tranger);
+        return -1;
+    }
+
+    size_t size = tranger2_iterator_size(iterator);
+    if(size != 10) {
+        printf("%sERROR%s --> runs: expected size 10, got %zu\n",
+            On_Red BWhite, Color_Off, size);
+        result += -1;
+    }
+
+    json_int_t inside_run[] = {2, 3, 4};
+    result += check_page(tranger, iterator, "runs: inside a run", 2, 3, inside_run, 3);
+
+    json_int_t across_gap[] = {4, 5, 11, 12};
+    result += check_page(tranger, iterator, "runs: across the gap", 4, 4, across_gap, 4);
+
+    json_int_t second_run[] = {11, 12, 13, 14, 15};
+    result += check_page(tranger, iterator, "runs: second run", 6, 5, second_run, 5);
+
+    json_int_t at_end[] = {15};
+    result += check_page(tranger, iterator, "runs: past the end", 10, 5, at_end, 1);
+
+    tranger2_close_iterator(tranger, iterator);
+    result += test_json(NULL);
+
+    set_expected_results("runs: shutdown", NULL, NULL, NULL, 1);
+    tranger2_shutdown(tranger);
+    result += test_json(NULL);
+    return result;
+}
+
+/***************************************************************************
+ *  do_test_single
+ ***************************************************************************/
+PRIVATE int do_test_single(void)
+{
+    int result = 0;
+    char path_root[PATH_MAX], path_database[PATH_MAX];
+    build_paths(path_root, sizeof(path_root), path_database, sizeof(path_database));
+    rmrdir(path_database);
+
+    set_expected_results(
+        "single: startup + create + append",
+        json_pack("[{s:s},{s:s}]",
+            "msg", "Creating __timeranger2__.json",
+            "msg", "Creating topic"
+        ),
+        NULL, NULL, 1
+    );
+
+    json_t *tranger = startup_master(path_root);
+    if(!tranger) {
+        return -1;
+    }
+    if(create_topic(tranger) < 0) {
+        tranger2_shutdown(tranger);
+        return -1;
+    }
+
+    uint16_t user_flags[N_RECORDS];
+    for(int j=0; j<N_RECORDS; j++) {
+        user_flags[j] = (j % 2 == 0)? 1 : 2;    // odd rowids
+    }
+    if(append_flagged(tranger, user_flags) < 0) {
+        tranger2_shutdown(tranger);
+        return -1;
+    }
+    result += test_json(NULL);
+
+    set_expected_results("single: size and pages", NULL, NULL, NULL, 1);
+
+    json_t *iterator = tranger2_open_iterator(
+        tranger, TOPIC_NAME, KEY_STR,
+        json_pack("{s:i, s:i}", "from_rowid", 1, "user_flag", 1),
+        NULL,
+        "single",
+        NULL, NULL, NULL
+    );
+    if(!iterator) {
+        tranger2_shutdown(tranger);
+        return -1;
+    }
+
+    size_t size = tranger2_iterator_size(iterator);
+    if(size != N_RECORDS/2) {
+        printf("%sERROR%s --> single: expected size %d, got %zu\n",
+            On_Red BWhite, Color_Off, N_RECORDS/2, size);
+        result += -1;
+    }
+
+    json_int_t odd_rows[] = {1, 3, 5, 7, 9, 11, 13, 15, 17, 19};
+    result += check_page(tranger, iterator, "single: all", 1, N_RECORDS, odd_rows, N_RECORDS/2);
+
+    json_int_t middle[] = {9, 11};
+    result += check_page(tranger, iterator, "single: middle", 5, 2, middle, 2);
+
+    tranger2_close_iterator(tranger, iterator);
+    result += test_json(NULL);
+
+    set_expected_results("single: shutdown", NULL, NULL, NULL, 1);
+    tranger2_shutdown(tranger);
+    result += test_json(NULL);
+    return result;
+}
+
+/***************************************************************************
+ *              Main
+ ***************************************************************************/
+PRIVATE void quit_sighandler(int sig)
+{
+    static int xtimes_once = 0;
+    xtimes_once++;
+    yev_loop_reset_running(yev_loop);
+    if(xtimes_once > 1) {
+        exit(-1);
+    }
+}
+
+PRIVATE void yuno_catch_signals(void)
+{
+    struct sigaction sigIntHandler;
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGTERM, SIG_IGN);
+    memset(&sigIntHandler, 0, sizeof(sigIntHandler));
+    sigIntHandler.sa_handler = quit_sighandler;
+    sigemptyset(&sigIntHandler.sa_mask);
+    sigIntHandler.sa_flags = SA_NODEFER|SA_RESTART;
+    sigaction(SIGALRM, &sigIntHandler, NULL);
+    sigaction(SIGQUIT, &sigIntHandler, NULL);
+    sigaction(SIGINT, &sigIntHandler, NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    sys_malloc_fn_t malloc_func;
+    sys_realloc_fn_t realloc_func;
+    sys_calloc_fn_t calloc_func;
+    sys_free_fn_t free_func;
+    gbmem_get_allocators(&malloc_func, &realloc_func, &calloc_func, &free_func);
+    json_set_alloc_funcs(malloc_func, free_func);
+
+    unsigned long memory_check_list[] = {0, 0};
+    set_memory_check_list(memory_check_list);
+
+    init_backtrace_with_backtrace(argv[0]);
+    set_show_backtrace_fn(show_backtrace_with_backtrace);
+
+    gobj_start_up(
+        argc, argv,
+        NULL, NULL, NULL, NULL, NULL, NULL
+    );
+
+    yuno_catch_signals();
+
+    gobj_log_add_handler("stdout", "stdout", LOG_OPT_ALL, 0);
+    gobj_log_register_handler(
+        "testing", 0, capture_log_write, 0
+    );
+    gobj_log_add_handler("test_capture", "testing", LOG_OPT_UP_INFO, 0);
+
+    yev_loop_create(0, 2024, 10, NULL, &yev_loop);
+
+    int result = 0;
+    result += do_test_runs();
+    result += do_test_single();
+    result += global_result;
+
+    yev_loop_stop(yev_loop);
+    yev_loop_destroy(yev_loop);
+
+    gobj_end();
+
+    if(get_cur_system_memory()!=0) {
+        printf("%sERROR --> %s%s\n", On_Red BWhite, "system memory not free", Color_Off);
+        print_track_mem();
+        result += -1;
+    }
+
+    if(result<0) {
+        printf("<-- %sTEST FAILED%s: %s\n", On_Red BWhite, Color_Off, APP);
+    }
+    return result<0?-1:0;
+}
@@ -0,0 +1,357 @@
+/****************************************************************************
+ *          test_lazy_list.c
+ *
+ *  Regression coverage for the lazy tranger2_open_list() and the LRU
+ *  content cache of the topic:
+ *      - the disk load of a "lazy" list gives only the metadata (record NULL),
+ *        the realtime feed still gives the full records;
+ *      - tranger2_read_record_cached() reads the content, a miss the first
+ *        time and a hit the next one;
+ *      - the cache keeps within its byte budget, evicting the least
+ *        recently used records;
+ *      - closing the topic drops the cache (no leak at the end).
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#include <string.h>
+#include <signal.h>
+#include <limits.h>
+
+#include <gobj.h>
+#include <kwid.h>
+#include <timeranger2.h>
+#include <helpers.h>
+#include <yev_loop.h>
+#include <testing.h>
+
+#define APP "test_lazy_list"
+
+/***************************************************************
+ *              Constants
+ ***************************************************************/
+#define DATABASE    "tr_lazy_list"
+#define TOPIC_NAME  "topic_lazy_list"
+#define KEY_ID      1
+#define KEY_STR     "0000000000000000001"
+#define BASE_T      946684800   // 2000-01-01T00:00:00+0000
+#define N_RECORDS   10
+
+/***************************************************************
+ *              Data
+ ***************************************************************/
+PRIVATE yev_loop_h yev_loop;
+PRIVATE int global_result = 0;
+
+PRIVATE size_t loaded_md_only = 0;      // callbacks with record NULL
+PRIVATE size_t loaded_full = 0;         // callbacks with record
+PRIVATE md2_record_ex_t loaded_md[N_RECORDS];
+
+PRIVATE int lazy_record_callback(
+    json_t *tranger,
+    json_t *topic,
+    const char *key,
+    json_t *list,
+    json_int_t rowid,
+    md2_record_ex_t *md_record,
+    json_t *record
+)
+{
+    if(record) {
+        loaded_full++;
+    } else {
+        if(loaded_md_only < N_RECORDS) {
+            loaded_md[loaded_md_only] = *md_record;
+        }
+        loaded_md_only++;
+    }
+    JSON_DECREF(record)
+    return 0;
+}
+
+/***************************************************************
+ *              Helpers
+ ***************************************************************/
+PRIVATE void build_paths(
+    char *path_root, size_t root_sz,
+    char *path_database, size_t db_sz
+)
+{
+    const char *home = getenv("HOME");
+    build_path(path_root, root_sz, home, "tests_yuneta", NULL);
+    mkrdir(path_root, 02770);
+    build_path(path_database, db_sz, path_root, DATABASE, NULL);
+}
+
+PRIVATE json_t *startup_master(const char *path_root)
+{
+    json_t *jn_tranger = json_pack("{s:s, s:s, s:b, s:i, s:s, s:i, s:i}",
+        "path", path_root,
+        "database", DATABASE,
+        "master", 1,
+        "on_critical_error", LOG_OPT_TRACE_STACK,
+        "filename_mask", "%Y",
+        "xpermission" , 02770,
+        "rpermission", 0600
+    );
+    return tranger2_startup(0, jn_tranger, 0);
+}
+
+PRIVATE int create_topic(json_t *tranger)
+{
+    json_t *topic = tranger2_create_topic(
+        tranger,
+        TOPIC_NAME,
+        "id",
+        "tm",
+        json_pack("{s:i, s:s, s:i, s:i}",
+            "on_critical_error", 4,
+            "filename_mask", "%Y-%m-%d",
+            "xpermission" , 02700,
+            "rpermission", 0600
+        ),
+        sf_int_key,
+        json_pack("{s:s, s:I, s:s}",
+            "id", "",
+            "tm", (json_int_t)0,
+            "content", ""
+        ),
+        0
+    );
+    return topic? 0 : -1;
+}
+
+PRIVATE int append_one(json_t *tranger, int j)
+{
+    json_t *jn_record = json_pack("{s:I, s:I, s:s}",
+        "id", (json_int_t)KEY_ID,
+        "tm", (json_int_t)(BASE_T + j),
+        "content", "lazy-payload"
+    );
+    md2_record_ex_t md = {0};
+    return tranger2_append_record(tranger, TOPIC_NAME, BASE_T + j, 0, &md, jn_record);
+}
+
+PRIVATE json_int_t cache_stat(json_t *tranger, const char *name)
+{
+    json_t *stats = tranger2_content_cache_stats(tranger, TOPIC_NAME);
+    json_int_t value = json_integer_value(json_object_get(stats, name));
+    JSON_DECREF(stats)
+    return value;
+}
+
+/***************************************************************************
+ *  Read all the loaded records through the cache, check their content
+ ***************************************************************************/
+PRIVATE int read_all(json_t *tranger, json_t *topic, const char *label)
+{
+    int result = 0;
+    for(size_t i=0; i<loaded_md_only && i<N_RECORDS; i++) {
+        json_t *record = tranger2_read_record_cached(tranger, topic, KEY_STR, &loaded_md[i]);
+        if(!record || json_integer_value(json_object_get(record, "tm")) != (json_int_t)(BASE_T + i)) {
+            printf("%sERROR%s --> %s: record %zu not read back\n",
+                On_Red BWhite, Color_Off, label, i);
+            result += -1;
+        }
+        JSON_DECREF(record)
+    }
+    return result;
+}
+
+/***************************************************************************
+ *  do_test_lazy
+ ***************************************************************************/
+PRIVATE int do_test_lazy(void)
+{
+    int result = 0;
+    char path_root[PATH_MAX], path_database[PATH_MAX];
+    build_paths(path_root, sizeof(path_root), path_database, sizeof(path_database));
+    rmrdir(path_database);
+
+    set_expected_results(
+        "lazy: startup + create + append",
+        json_pack("[{s:s},{s:s}]",
+            "msg", "Creating __timeranger2__.json",
+            "msg", "Creating topic"
+        ),
+        NULL, NULL, 1
+    );
+
+    json_t *tranger = startup_master(path_root);
+    if(!tranger) {
+        return -1;
+    }
+    if(create_topic(tranger) < 0) {
+        tranger2_shutdown(tranger);
+        return -1;
+    }
+    for(int j=0; j<N_RECORDS; j++) {
+        if(append_one(tranger, j) < 0) {
+            tranger2_shutdown(tranger);
+            return -1;
+        }
+    }
+    result += test_json(NULL);
+
+    /*-------------------------------------*
+     *  Lazy list: metadata only
+     *-------------------------------------*/
+    set_expected_results("lazy: open list", NULL, NULL, NULL, 1);
+
+    json_t *list = tranger2_open_list(
+        tranger,
+        TOPIC_NAME,
+        json_pack("{s:s, s:b, s:I}",
+            "key", KEY_STR,
+            "lazy", 1,
+            "load_record_callback", (json_int_t)(uintptr_t)lazy_record_callback
+        ),
+        NULL,       // extra
+        "lazy",     // rt_id
+        FALSE,      // rt_by_disk
+        NULL        // creator
+    );
+    if(!list) {
+        tranger2_shutdown(tranger);
+        return -1;
+    }
+    if(loaded_md_only != N_RECORDS || loaded_full != 0) {
+        printf("%sERROR%s --> lazy: expected %d md only loads, got %zu (and %zu full)\n",
+            On_Red BWhite, Color_Off, N_RECORDS, loaded_md_only, loaded_full);
+        result += -1;
+    }
+
+    /*
+     *  The realtime feed gives the full record
+     */
+    append_one(tranger, N_RECORDS);
+    if(loaded_full != 1) {
+        printf("%sERROR%s --> lazy: realtime feed expected 1 full record, got %zu\n",
+            On_Red BWhite, Color_Off, loaded_full);
+        result += -1;
+    }
+    result += test_json(NULL);
+
+    /*-------------------------------------*
+     *  Read through the cache
+     *-------------------------------------*/
+    set_expected_results("lazy: content cache", NULL, NULL, NULL, 1);
+
+    json_t *topic = tranger2_topic(tranger, TOPIC_NAME);
+
+    result += read_all(tranger, topic, "lazy: first read");
+    if(cache_stat(tranger, "misses") != N_RECORDS || cache_stat(tranger, "hits") != 0) {
+        printf("%sERROR%s --> lazy: first read, expected %d misses and no hit\n",
+            On_Red BWhite, Color_Off, N_RECORDS);
+        result += -1;
+    }
+
+    result += read_all(tranger, topic, "lazy: second read");
+    if(cache_stat(tranger, "hits") != N_RECORDS || cache_stat(tranger, "records") != N_RECORDS) {
+        printf("%sERROR%s --> lazy: second read, expected %d hits\n",
+            On_Red BWhite, Color_Off, N_RECORDS);
+        result += -1;
+    }
+
+    /*
+     *  A budget of two records: the least recently used go away
+     */
+    tranger2_set_content_cache_size(tranger, TOPIC_NAME, (size_t)(2 * loaded_md[0].__size__));
+    if(cache_stat(tranger, "records") != 2 || cache_stat(tranger, "evictions") != N_RECORDS - 2) {
+        printf("%sERROR%s --> lazy: expected 2 records and %d evictions\n",
+            On_Red BWhite, Color_Off, N_RECORDS - 2);
+        result += -1;
+    }
+
+    result += read_all(tranger, topic, "lazy: read after trim");
+    if(cache_stat(tranger, "size") > cache_stat(tranger, "max_size")) {
+        printf("%sERROR%s --> lazy: cache over its budget\n", On_Red BWhite, Color_Off);
+        result += -1;
+    }
+
+    tranger2_close_list(tranger, list);
+    result += test_json(NULL);
+
+    set_expected_results("lazy: shutdown", NULL, NULL, NULL, 1);
+    tranger2_shutdown(tranger);
+    result += test_json(NULL);
+    return result;
+}
+
+/***************************************************************************
+ *              Main
+ ***************************************************************************/
+PRIVATE void quit_sighandler(int sig)
+{
+    static int xtimes_once = 0;
+    xtimes_once++;
+    yev_loop_reset_running(yev_loop);
+    if(xtimes_once > 1) {
+        exit(-1);
+    }
+}
+
+PRIVATE void yuno_catch_signals(void)
+{
+    struct sigaction sigIntHandler;
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGTERM, SIG_IGN);
+    memset(&sigIntHandler, 0, sizeof(sigIntHandler));
+    sigIntHandler.sa_handler = quit_sighandler;
+    sigemptyset(&sigIntHandler.sa_mask);
+    sigIntHandler.sa_flags = SA_NODEFER|SA_RESTART;
+    sigaction(SIGALRM, &sigIntHandler, NULL);
+    sigaction(SIGQUIT, &sigIntHandler, NULL);
+    sigaction(SIGINT, &sigIntHandler, NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    sys_malloc_fn_t malloc_func;
+    sys_realloc_fn_t realloc_func;
+    sys_calloc_fn_t calloc_func;
+    sys_free_fn_t free_func;
+    gbmem_get_allocators(&malloc_func, &realloc_func, &calloc_func, &free_func);
+    json_set_alloc_funcs(malloc_func, free_func);
+
+    unsigned long memory_check_list[] = {0, 0};
+    set_memory_check_list(memory_check_list);
+
+    init_backtrace_with_backtrace(argv[0]);
+    set_show_backtrace_fn(show_backtrace_with_backtrace);
+
+    gobj_start_up(
+        argc, argv,
+        NULL, NULL, NULL, NULL, NULL, NULL
+    );
+
+    yuno_catch_signals();
+
+    gobj_log_add_handler("stdout", "stdout", LOG_OPT_ALL, 0);
+    gobj_log_register_handler(
+        "testing", 0, capture_log_write, 0
+    );
+    gobj_log_add_handler("test_capture", "testing", LOG_OPT_UP_INFO, 0);
+
+    yev_loop_create(0, 2024, 10, NULL, &yev_loop);
+
+    int result = 0;
+    result += do_test_lazy();
+    result += global_result;
+
+    yev_loop_stop(yev_loop);
+    yev_loop_destroy(yev_loop);
+
+    gobj_end();
+
+    if(get_cur_system_memory()!=0) {
+        printf("%sERROR --> %s%s\n", On_Red BWhite, "system memory not free", Color_Off);
+        print_track_mem();
+        result += -1;
+    }
+
+    if(result<0) {
+        printf("<-- %sTEST FAILED%s: %s\n", On_Red BWhite, Color_Off, APP);
+    }
+    return result<0?-1:0;
+}
@@ -0,0 +1,403 @@
+/****************************************************************************
+ *          test_time_index.c
+ *
+ *  Regression coverage for the sparse time index of the .md2 files
+ *  (one block per 1024 rows, used to seek time-bounded iterators):
+ *      - do_test_forward:   3000 rows in one file, from_t at row 2500: the
+ *                           history returns rows 2500-3000, the master saves
+ *                           the .tix, and a cold reload gives the same rows
+ *                           from the saved index.
+ *      - do_test_backward:  backward with to_t at row 500 returns rows 500-1.
+ *      - do_test_unordered: a row of the first block with a time past the
+ *                           range is still returned, the seek never skips a
+ *                           row that matches.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#include <string.h>
+#include <signal.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <gobj.h>
+#include <kwid.h>
+#include <timeranger2.h>
+#include <helpers.h>
+#include <yev_loop.h>
+#include <testing.h>
+
+#define APP "test_time_index"
+
+/***************************************************************
+ *              Constants
+ ***************************************************************/
+#define DATABASE    "tr_time_index"
+#define TOPIC_NAME  "topic_time_index"
+#define KEY_ID      1
+#define KEY_STR     "0000000000000000001"
+#define BASE_T      946684800   // 2000-01-01T00:00:00+0000, all rows in the same file
+#define FILE_ID     "2000-01-01"
+#define N_RECORDS   3000
+
+/***************************************************************
+ *              Data
+ ***************************************************************/
+PRIVATE yev_loop_h yev_loop;
+PRIVATE int global_result = 0;
+
+PRIVATE size_t history_seen = 0;
+PRIVATE json_int_t history_first_rowid = 0;
+PRIVATE json_int_t history_last_rowid = 0;
+
+PRIVATE int history_record_callback(
+    json_t *tranger,
+    json_t *topic,
+    const char *key,
+    json_t *list,
+    json_int_t rowid,
+    md2_record_ex_t *md_record,
+    json_t *record
+)
+{
+    if(history_seen == 0) {
+        history_first_rowid = (json_int_t)md_record->rowid;
+    }
+    history_last_rowid = (json_int_t)md_record->rowid;
+    history_seen++;
+    JSON_DECREF(record)
+    return 0;
+}
+
+/***************************************************************
+ *              Helpers
+ ***************************************************************/
+PRIVATE void build_paths(
+    char *path_root, size_t root_sz,
+    char *path_database, size_t db_sz
+)
+{
+    const char *home = getenv("HOME");
+    build_path(path_root, root_sz, home, "tests_yuneta", NULL);
+    mkrdir(path_root, 02770);
+    build_path(path_database, db_sz, path_root, DATABASE, NULL);
+}
+
+PRIVATE json_t *startup_master(const char *path_root)
+{
+    json_t *jn_tranger = json_pack("{s:s, s:s, s:b, s:i, s:s, s:i, s:i}",
+        "path", path_root,
+        "database", DATABASE,
+        "master", 1,
+        "on_critical_error", LOG_OPT_TRACE_STACK,
+        "filename_mask", "%Y",
+        "xpermission" , 02770,
+        "rpermission", 0600
+    );
+    return tranger2_startup(0, jn_tranger, 0);
+}
+
+PRIVATE int create_topic(json_t *tranger)
+{
+    json_t *topic = tranger2_create_topic(
+        tranger,
+        TOPIC_NAME,
+        "id",
+        "tm",
+        json_pack("{s:i, s:s, s:i, s:i}",
+            "on_critical_error", 4,
+            "filename_mask", "%Y-%m-%d",
+            "xpermission" , 02700,
+            "rpermission", 0600
+        ),
+        sf_int_key,
+        json_pack("{s:s, s:I, s:s}",
+            "id", "",
+            "tm", (json_int_t)0,
+            "content", ""
+        ),
+        0
+    );
+    return topic? 0 : -1;
+}
+
+/***************************************************************************
+ *  Append N_RECORDS, row j+1 with __t__ BASE_T + j,
+ *  but the row `unordered_row` (if any) with a __t__ past all the others.
+ ***************************************************************************/
+PRIVATE int append_n(json_t *tranger, int unordered_row)
+{
+    for(int j=0; j<N_RECORDS; j++) {
+        uint64_t t = BASE_T + j;
+        if(j + 1 == unordered_row) {
+            t = BASE_T + N_RECORDS + 100;
+        }
+        json_t *jn_record = json_pack("{s:I, s:I, s:s}",
+            "id", (json_int_t)KEY_ID,
+            "tm", (json_int_t)t,
+            "content", "payload"
+        );
+        md2_record_ex_t md = {0};
+        if(tranger2_append_record(tranger, TOPIC_NAME, t, 0, &md, jn_record) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Load the history of the key with match_cond (owned)
+ ***************************************************************************/
+PRIVATE int load_history(json_t *tranger, json_t *match_cond, const char *id)
+{
+    history_seen = 0;
+    history_first_rowid = 0;
+    history_last_rowid = 0;
+
+    json_t *iterator = tranger2_open_iterator(
+        tranger, TOPIC_NAME, KEY_STR,
+        match_cond,
+        history_record_callback,
+        id,
+        NULL, NULL, NULL
+    );
+    if(!iterator) {
+        return -1;
+    }
+    tranger2_close_iterator(tranger, iterator);
+    return 0;
+}
+
+PRIVATE int check_history(
+    const char *label,
+    size_t seen,
+    json_int_t first_rowid,
+    json_int_t last_rowid
+)
+{
+    if(history_seen != seen ||
+            history_first_rowid != first_rowid ||
+            history_last_rowid != last_rowid) {
+        printf("%sERROR%s --> %s: expected %zu rows %lld..%lld, got %zu rows %lld..%lld\n",
+            On_Red BWhite, Color_Off, label,
+            seen, (long long)first_rowid, (long long)last_rowid,
+            history_seen, (long long)history_first_rowid, (long long)history_last_rowid);
+        return -1;
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Fresh database with the rows of the test
+ ***************************************************************************/
+PRIVATE json_t *fill_database(const char *label, int unordered_row)
+{
+    char path_root[PATH_MAX], path_database[PATH_MAX];
+    build_paths(path_root, sizeof(path_root), path_database, sizeof(path_database));
+    rmrdir(path_database);
+
+    set_expected_results(
+        label,
+        json_pack("[{s:s},{s:s}]",
+            "msg", "Creating __timeranger2__.json",
+            "msg", "Creating topic"
+        ),
+        NULL, NULL, 1
+    );
+
+    json_t *tranger = startup_master(path_root);
+    if(!tranger) {
+        return NULL;
+    }
+    if(create_topic(tranger) < 0 || append_n(tranger, unordered_row) < 0) {
+        tranger2_shutdown(tranger);
+        return NULL;
+    }
+    return tranger;
+}
+
+/***************************************************************************
+ *  do_test_forward
+ ***************************************************************************/
+PRIVATE int do_test_forward(void)
+{
+    int result = 0;
+    json_t *tranger = fill_database("forward: startup + create + append", 0);
+    if(!tranger) {
+        return -1;
+    }
+    result += test_json(NULL);
+
+    set_expected_results("forward: from_t", NULL, NULL, NULL, 1);
+    if(load_history(tranger, json_pack("{s:I}", "from_t", (json_int_t)(BASE_T + 2499)), "fwd") < 0) {
+        result += -1;
+    }
+    result += check_history("forward: from_t", 501, 2500, 3000);
+    tranger2_shutdown(tranger);
+    result += test_json(NULL);
+
+    /*-------------------------------------*
+     *  The master saved the index
+     *-------------------------------------*/
+    char path_root[PATH_MAX], path_database[PATH_MAX], path_tix[PATH_MAX];
+    build_paths(path_root, sizeof(path_root), path_database, sizeof(path_database));
+    build_path(path_tix, sizeof(path_tix),
+        path_database, TOPIC_NAME, "keys", KEY_STR, FILE_ID ".tix", NULL
+    );
+    if(access(path_tix, F_OK) != 0) {
+        printf("%sERROR%s --> forward: %s not saved\n", On_Red BWhite, Color_Off, path_tix);
+        result += -1;
+    }
+
+    /*-------------------------------------*
+     *  Cold reload, from the saved index
+     *-------------------------------------*/
+    set_expected_results("forward: cold reload", NULL, NULL, NULL, 1);
+    tranger = startup_master(path_root);
+    if(!tranger) {
+        return -1;
+    }
+    if(create_topic(tranger) < 0) {
+        tranger2_shutdown(tranger);
+        return -1;
+    }
+    if(load_history(tranger, json_pack("{s:I}", "from_t", (json_int_t)(BASE_T + 2499)), "cold") < 0) {
+        result += -1;
+    }
+    result += check_history("forward: cold reload", 501, 2500, 3000);
+    tranger2_shutdown(tranger);
+    result += test_json(NULL);
+
+    return result;
+}
+
+/***************************************************************************
+ *  do_test_backward
+ ***************************************************************************/
+PRIVATE int do_test_backward(void)
+{
+    int result = 0;
+    json_t *tranger = fill_database("backward: startup + create + append", 0);
+    if(!tranger) {
+        return -1;
+    }
+    result += test_json(NULL);
+
+    set_expected_results("backward: to_t", NULL, NULL, NULL, 1);
+    if(load_history(tranger,
+            json_pack("{s:b, s:I}", "backward", 1, "to_t", (json_int_t)(BASE_T + 499)),
+            "bwd") < 0) {
+        result += -1;
+    }
+    result += check_history("backward: to_t", 500, 500, 1);
+    tranger2_shutdown(tranger);
+    result += test_json(NULL);
+
+    return result;
+}
+
+/***************************************************************************
+ *  do_test_unordered
+ ***************************************************************************/
+PRIVATE int do_test_unordered(void)
+{
+    int result = 0;
+    json_t *tranger = fill_database("unordered: startup + create + append", 10);
+    if(!tranger) {
+        return -1;
+    }
+    result += test_json(NULL);
+
+    set_expected_results("unordered: from_t", NULL, NULL, NULL, 1);
+    if(load_history(tranger, json_pack("{s:I}", "from_t", (json_int_t)(BASE_T + 2499)), "unordered") < 0) {
+        result += -1;
+    }
+    /*
+     *  Row 10 has the biggest __t__: it matches, first in rowid order
+     */
+    result += check_history("unordered: from_t", 502, 10, 3000);
+    tranger2_shutdown(tranger);
+    result += test_json(NULL);
+
+    return result;
+}
+
+/***************************************************************************
+ *              Main
+ ***************************************************************************/
+PRIVATE void quit_sighandler(int sig)
+{
+    static int xtimes_once = 0;
+    xtimes_once++;
+    yev_loop_reset_running(yev_loop);
+    if(xtimes_once > 1) {
+        exit(-1);
+    }
+}
+
+PRIVATE void yuno_catch_signals(void)
+{
+    struct sigaction sigIntHandler;
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGTERM, SIG_IGN);
+    memset(&sigIntHandler, 0, sizeof(sigIntHandler));
+    sigIntHandler.sa_handler = quit_sighandler;
+    sigemptyset(&sigIntHandler.sa_mask);
+    sigIntHandler.sa_flags = SA_NODEFER|SA_RESTART;
+    sigaction(SIGALRM, &sigIntHandler, NULL);
+    sigaction(SIGQUIT, &sigIntHandler, NULL);
+    sigaction(SIGINT, &sigIntHandler, NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    sys_malloc_fn_t malloc_func;
+    sys_realloc_fn_t realloc_func;
+    sys_calloc_fn_t calloc_func;
+    sys_free_fn_t free_func;
+    gbmem_get_allocators(&malloc_func, &realloc_func, &calloc_func, &free_func);
+    json_set_alloc_funcs(malloc_func, free_func);
+
+    unsigned long memory_check_list[] = {0, 0};
+    set_memory_check_list(memory_check_list);
+
+    init_backtrace_with_backtrace(argv[0]);
+    set_show_backtrace_fn(show_backtrace_with_backtrace);
+
+    gobj_start_up(
+        argc, argv,
+        NULL, NULL, NULL, NULL, NULL, NULL
+    );
+
+    yuno_catch_signals();
+
+    gobj_log_add_handler("stdout", "stdout", LOG_OPT_ALL, 0);
+    gobj_log_register_handler(
+        "testing", 0, capture_log_write, 0
+    );
+    gobj_log_add_handler("test_capture", "testing", LOG_OPT_UP_INFO, 0);
+
+    yev_loop_create(0, 2024, 10, NULL, &yev_loop);
+
+    int result = 0;
+    result += do_test_forward();
+    result += do_test_backward();
+    result += do_test_unordered();
+    result += global_result;
+
+    yev_loop_stop(yev_loop);
+    yev_loop_destroy(yev_loop);
+
+    gobj_end();
+
+    if(get_cur_system_memory()!=0) {
+        printf("%sERROR --> %s%s\n", On_Red BWhite, "system memory not free", Color_Off);
+        print_track_mem();
+        result += -1;
+    }
+
+    if(result<0) {
+        printf("<-- %sTEST FAILED%s: %s\n", On_Red BWhite, Color_Off, APP);
+    }
+    return result<0?-1:0;
+}
@@ -0,0 +1,402 @@
+/****************************************************************************
+ *          test_tr2q_index.c
+ *
+ *  The messages of a tr2q_mqtt queue are indexed by mid and by rowid,
+ *  over the inflight and the queued lists. What it must keep:
+ *
+ *      - every message is found by its rowid and its mid while the
+ *        indexes grow, and what is not there is not found;
+ *      - with a shared mid the lookup picks what the old list walk did:
+ *        the inflight one first, then the lowest rowid;
+ *      - tr2q_set_mid() moves the message in the mid index;
+ *      - unloading takes the message out of both indexes, and moving it
+ *        from queued to inflight keeps it in them;
+ *      - the high-water marks of the lists, and tr2q_reset_depth_marks();
+ *      - draining a large outbound backlog, queued with mid 0 and given a
+ *        mid when released, keeps the mid chains short: the messages
+ *        with mid 0 are not in the mid index.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+#include <signal.h>
+#include <yunetas.h>
+#include <tr2q_mqtt.h>
+
+#define APP             "test_tr2q_index"
+#define DATABASE        "tr2q_mqtt_index"
+#define TOPIC_NAME      "queue_index"
+#define TOPIC_BACKLOG   "queue_backlog"
+
+#define MAX_INFLIGHT    4
+#define N_MSGS          200     // more than the initial size of the indexes
+#define SHARED_MID      5000
+#define OTHER_MID       6000
+#define N_BACKLOG       10000   // outbound backlog drained MAX_INFLIGHT by MAX_INFLIGHT
+
+PRIVATE yev_loop_h yev_loop;
+PRIVATE int global_result = 0;
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int check(BOOL ok, const char *what)
+{
+    if(ok) {
+        return 0;
+    }
+    printf("%sERROR --> %s %s\n", On_Red BWhite, Color_Off, what);
+    return -1;
+}
+
+/***************************************************************************
+ *  Every message still in memory is found by its rowid and its mid
+ ***************************************************************************/
+PRIVATE int check_all_found(tr2_queue_t *trq, q2_msg_t **msgs, const char *phase)
+{
+    int result = 0;
+    for(int i = 0; i < N_MSGS; i++) {
+        q2_msg_t *msg = msgs[i];
+        if(!msg) {
+            continue;
+        }
+        if(tr2q_get_by_rowid(trq, (uint64_t)msg->rowid) != msg) {
+            printf("%sERROR --> %s %s: msg %d not found by rowid %d\n",
+                On_Red BWhite, Color_Off, phase, i, (int)msg->rowid
+            );
+            result += -1;
+        }
+        if(msg->mid != SHARED_MID && tr2q_get_by_mid(trq, msg->mid) != msg) {
+            printf("%sERROR --> %s %s: msg %d not found by mid %d\n",
+                On_Red BWhite, Color_Off, phase, i, (int)msg->mid
+            );
+            result += -1;
+        }
+    }
+    return result;
+}
+
+/***************************************************************************
+ *  Longest chain of the mid index
+ ***************************************************************************/
+PRIVATE size_t longest_mid_chain(tr2_queue_t *trq)
+{
+    size_t longest = 0;
+    for(size_t b = 0; b < trq->index_size; b++) {
+        size_t n = 0;
+        for(q2_msg_t *msg = trq->mid_index[b]; msg; msg = msg->mid_next) {
+            n++;
+        }
+        if(n > longest) {
+            longest = n;
+        }
+    }
+    return longest;
+}
+
+/***************************************************************************
+ *  Drain an outbound backlog like c_prot_mqtt2 does: the messages are
+ *  queued with mid 0, get a mid when released to inflight,
+ *  and are unloaded when acknowledged.
+ ***************************************************************************/
+PRIVATE int test_drain_backlog(json_t *tranger)
+{
+    int result = 0;
+
+    tr2_queue_t *trq = tr2q_open(
+        tranger,
+        TOPIC_BACKLOG,
+        "tm",
+        0,
+        MAX_INFLIGHT,
+        0
+    );
+
+    for(int i = 0; i < N_BACKLOG; i++) {
+        tr2q_append(
+            trq,
+            0,
+            json_pack("{s:i, s:i}",
+                "mid", 0,
+                "n", i
+            ),
+            0
+        );
+    }
+    result += check(tr2q_queued_size(trq) == N_BACKLOG - MAX_INFLIGHT, "backlog queued size");
+    result += check(trq->mid_index[0] == NULL, "mid 0 messages in the mid index");
+    result += check(tr2q_get_by_mid(trq, 0) == NULL, "mid 0 found");
+
+    uint16_t next_mid = 1;
+    int released = 0;
+    int acked = 0;
+    size_t longest = 0;
+    while(tr2q_inflight_size(trq) > 0) {
+        /*
+         *  Release: give a mid to the inflight messages without one
+         */
+        q2_msg_t *msg = dl_first(&trq->dl_inflight);
+        while(msg) {
+            if(msg->mid == 0) {
+                tr2q_set_mid(msg, next_mid);
+                if(tr2q_get_by_mid(trq, next_mid) != msg) {
+                    result += check(FALSE, "released msg not found by mid");
+                }
+                next_mid = (uint16_t)(next_mid % 0xFFFF + 1);
+                released++;
+            }
+            msg = dl_next(msg);
+        }
+        size_t chain = longest_mid_chain(trq);
+        if(chain > longest) {
+            longest = chain;
+        }
+
+        /*
+         *  Acknowledge the oldest, and refill inflight from the queued
+         */
+        msg = dl_first(&trq->dl_inflight);
+        uint16_t mid = msg->mid;
+        tr2q_unload_msg(msg, 0);
+        acked++;
+        if(tr2q_get_by_mid(trq, mid) != NULL) {
+            result += check(FALSE, "acked msg still found by mid");
+        }
+        q2_msg_t *queued = tr2q_first_queued_msg(trq);
+        if(queued) {
+            tr2q_move_from_queued_to_inflight(queued);
+        }
+    }
+
+    result += check(released == N_BACKLOG, "backlog released");
+    result += check(acked == N_BACKLOG, "backlog acked");
+    result += check(tr2q_queued_size(trq) == 0, "backlog queued left");
+    result += check(longest <= MAX_INFLIGHT, "mid chains longer than the inflight messages");
+    result += check(trq->index_count == 0, "backlog index count");
+
+    tr2q_close(trq);
+    return result;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int do_test(void)
+{
+    int result = 0;
+    char path_root[PATH_MAX];
+    char path_database[PATH_MAX];
+
+    if(!(getenv("YUNETA_STORE") && strlen(getenv("YUNETA_STORE")) > 0)) {
+        snprintf(path_root, sizeof(path_root), "/tmp");
+    } else {
+        snprintf(path_root, sizeof(path_root), "%s", getenv("YUNETA_STORE"));
+    }
+    build_path(path_database, sizeof(path_database), path_root, DATABASE, NULL);
+    rmrdir(path_database);
+
+    set_expected_results("index", json_pack("[{s:s}, {s:s}, {s:s}]",
+        "msg", "Creating __timeranger2__.json",
+        "msg", "Creating topic",
+        "msg", "Creating topic"
+    ), NULL, NULL, TRUE);
+
+    json_t *tranger = tranger2_startup(0, json_pack("{s:s, s:s, s:b, s:i}",
+        "path", path_root,
+        "database", DATABASE,
+        "master", 1,
+        "on_critical_error", 0
+    ), yev_loop);
+
+    tr2_queue_t *trq = tr2q_open(
+        tranger,
+        TOPIC_NAME,
+        "tm",
+        0,
+        MAX_INFLIGHT,
+        0
+    );
+
+    /*
+     *  Fill: MAX_INFLIGHT inflight, the rest queued, the indexes grow
+     */
+    q2_msg_t *msgs[N_MSGS];
+    for(int i = 0; i < N_MSGS; i++) {
+        msgs[i] = tr2q_append(
+            trq,
+            0,
+            json_pack("{s:i, s:i}",
+                "mid", i + 1,
+                "n", i
+            ),
+            0
+        );
+    }
+    result += check(tr2q_inflight_size(trq) == MAX_INFLIGHT, "inflight size");
+    result += check(tr2q_queued_size(trq) == N_MSGS - MAX_INFLIGHT, "queued size");
+    result += check_all_found(trq, msgs, "filled");
+
+    result += check(tr2q_get_by_rowid(trq, (uint64_t)msgs[N_MSGS-1]->rowid + 1) == NULL,
+        "unknown rowid found"
+    );
+    result += check(tr2q_get_by_mid(trq, N_MSGS + 1) == NULL, "unknown mid found");
+    result += check(tr2q_get_by_mid(trq, -1) == NULL, "negative mid found");
+    result += check(tr2q_get_by_mid(trq, 0x10000) == NULL, "mid out of 16 bits found");
+
+    /*
+     *  Shared mid: inflight first, then the lowest rowid
+     */
+    q2_msg_t *inflight = msgs[1];
+    q2_msg_t *queued_low = msgs[10];
+    q2_msg_t *queued_high = msgs[20];
+    result += check(inflight->inflight && !queued_low->inflight && !queued_high->inflight,
+        "lists of the shared mid messages"
+    );
+    uint16_t old_mid = inflight->mid;
+
+    tr2q_set_mid(queued_high, SHARED_MID);
+    tr2q_set_mid(inflight, SHARED_MID);
+    tr2q_set_mid(queued_low, SHARED_MID);
+    result += check(tr2q_get_by_mid(trq, SHARED_MID) == inflight, "shared mid: inflight first");
+    result += check(tr2q_get_by_mid(trq, old_mid) == NULL, "old mid still indexed");
+
+    tr2q_set_mid(inflight, OTHER_MID);
+    result += check(tr2q_get_by_mid(trq, SHARED_MID) == queued_low, "shared mid: lowest rowid");
+    result += check(tr2q_get_by_mid(trq, OTHER_MID) == inflight, "mid changed");
+
+    /*
+     *  Unload one inflight and one queued
+     */
+    json_int_t rowid = msgs[0]->rowid;
+    tr2q_unload_msg(msgs[0], 0);
+    msgs[0] = NULL;
+    result += check(tr2q_get_by_rowid(trq, (uint64_t)rowid) == NULL, "unloaded inflight still indexed");
+
+    tr2q_unload_msg(queued_low, 0);
+    msgs[10] = NULL;
+    result += check(tr2q_get_by_mid(trq, SHARED_MID) == queued_high, "shared mid after unload");
+
+    /*
+     *  Queued to inflight: still indexed, and now preferred
+     */
+    q2_msg_t *moved = tr2q_first_queued_msg(trq);
+    result += check(tr2q_move_from_queued_to_inflight(moved) == 0, "move to inflight");
+    result += check(moved->inflight, "moved is inflight");
+    result += check(tr2q_get_by_rowid(trq, (uint64_t)moved->rowid) == moved, "moved by rowid");
+    result += check_all_found(trq, msgs, "moved");
+
+    /*
+     *  High-water marks
+     */
+    result += check(tr2q_max_inflight_seen(trq) == MAX_INFLIGHT, "max inflight seen");
+    result += check(tr2q_max_queued_seen(trq) == N_MSGS - MAX_INFLIGHT, "max queued seen");
+
+    for(int i = N_MSGS/2; i < N_MSGS; i++) {
+        if(msgs[i] && !msgs[i]->inflight) {
+            tr2q_unload_msg(msgs[i], 0);
+            msgs[i] = NULL;
+        }
+    }
+    result += check(tr2q_max_queued_seen(trq) == N_MSGS - MAX_INFLIGHT, "max queued kept after unloads");
+    result += check_all_found(trq, msgs, "unloaded");
+
+    tr2q_reset_depth_marks(trq);
+    result += check(tr2q_max_inflight_seen(trq) == tr2q_inflight_size(trq), "reset max inflight");
+    result += check(tr2q_max_queued_seen(trq) == tr2q_queued_size(trq), "reset max queued");
+
+    tr2q_close(trq);
+
+    result += test_drain_backlog(tranger);
+
+    tranger2_shutdown(tranger);
+
+    result += test_json(NULL);
+
+    return result;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void quit_sighandler(int sig)
+{
+    yev_loop_reset_running(yev_loop);
+}
+
+PRIVATE void yuno_catch_signals(void)
+{
+    struct sigaction sigIntHandler;
+    signal(SIGPIPE, SIG_IGN);
+    sigIntHandler.sa_flags = SA_NODEFER|SA_RESTART;
+    sigIntHandler.sa_handler = quit_sighandler;
+    sigemptyset(&sigIntHandler.sa_mask);
+    sigaction(SIGALRM, &sigIntHandler, NULL);
+    sigaction(SIGQUIT, &sigIntHandler, NULL);
+    sigaction(SIGINT, &sigIntHandler, NULL);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+int main(int argc, char *argv[])
+{
+    setlocale(LC_ALL, "");
+
+    sys_malloc_fn_t malloc_func;
+    sys_realloc_fn_t realloc_func;
+    sys_calloc_fn_t calloc_func;
+    sys_free_fn_t free_func;
+
+    gbmem_get_allocators(&malloc_func, &realloc_func, &calloc_func, &free_func);
+    json_set_alloc_funcs(malloc_func, free_func);
+
+    unsigned long memory_check_list[] = {0}; // WARNING: list ended with 0
+    set_memory_check_list(memory_check_list);
+
+    init_backtrace_with_backtrace(argv[0]);
+    set_show_backtrace_fn(show_backtrace_with_backtrace);
+
+    gbmem_setup(
+        256*1024L,
+        1024*1024*1024L,
+        FALSE,
+        0,
+        0
+    );
+    gobj_start_up(argc, argv, NULL, NULL, NULL, NULL, NULL, NULL);
+
+    yuno_catch_signals();
+
+    gobj_log_add_handler("stdout", "stdout", LOG_OPT_ALL, 0);
+    gobj_log_register_handler(
+        "testing",
+        0,
+        capture_log_write,
+        0
+    );
+    gobj_log_add_handler("test_capture", "testing", LOG_OPT_UP_INFO, 0);
+
+    yev_loop_create(0, 2024, 10, NULL, &yev_loop);
+
+    int result = do_test();
+    result += global_result;
+
+    yev_loop_stop(yev_loop);
+    yev_loop_destroy(yev_loop);
+
+    gobj_end();
+
+    if(get_cur_system_memory() != 0) {
+        printf("%sERROR --> %s%s\n", On_Red BWhite, "system memory not free", Color_Off);
+        print_track_mem();
+        result += -1;
+    }
+    if(result < 0) {
+        printf("<-- %sTEST FAILED%s: %s\n", On_Red BWhite, Color_Off, APP);
+    }
+    return result < 0 ? -1 : 0;
+}
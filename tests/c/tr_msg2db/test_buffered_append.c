@@ -0,0 +1,349 @@
+/****************************************************************************
+ *          test_buffered_append.c
+ *
+ *  The buffered mode of msg2db holds the appends in memory and writes them
+ *  with one grouped append per topic. What it must keep:
+ *
+ *      - a queued message is not seen, and msg2db_append_message() gives
+ *        back NULL for it, not a record that the next flush will free;
+ *      - msg2db_flush() writes the queue and the index sees it, with the
+ *        __t__ of the append, not the one of the flush;
+ *      - reaching max_messages flushes by itself;
+ *      - msg2db_append_messages() queues a batch the same way;
+ *      - closing the db flushes what is left, nothing is lost on a clean
+ *        close, and the reload finds every message.
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+#include <signal.h>
+#include <unistd.h>
+#include <yunetas.h>
+
+#define APP             "test_buffered_append"
+#define DATABASE        "tr_msg2db_buffered"
+#define MSG2DB_NAME     "msg2db_test"
+#define TOPIC_NAME      "alarms"
+
+#define MAX_MESSAGES    4
+
+PRIVATE yev_loop_h yev_loop;
+PRIVATE int global_result = 0;
+
+PRIVATE char msg2db_schema[]= "\
+{                                                                   \n\
+    'id': '"MSG2DB_NAME"',                                          \n\
+    'schema_version': '1',                                          \n\
+    'topics': [                                                     \n\
+        {                                                           \n\
+            'id': '"TOPIC_NAME"',                                   \n\
+            'pkey': 'id',                                           \n\
+            'tkey': 'tm',                                           \n\
+            'system_flag': 'sf_string_key',                         \n\
+            'pkey2': 'alarm',                                       \n\
+            'topic_version': '1',                                   \n\
+            'cols': {                                               \n\
+                'id': {                                             \n\
+                    'header': 'Device Id',                          \n\
+                    'type': 'string',                               \n\
+                    'flag': ['persistent','required']               \n\
+                },                                                  \n\
+                'tm': {                                             \n\
+                    'header': 'Time',                               \n\
+                    'type': 'integer',                              \n\
+                    'flag': ['persistent','required','time']        \n\
+                },                                                  \n\
+                'alarm': {                                          \n\
+                    'header': 'Alarm',                              \n\
+                    'type': 'string',                               \n\
+                    'flag': ['persistent','required']               \n\
+                }                                                   \n\
+            }                                                       \n\
+        }                                                           \n\
+    ]                                                               \n\
+}                                                                   \n\
+";
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE json_t *new_message(int n)
+{
+    char alarm_name[32];
+    snprintf(alarm_name, sizeof(alarm_name), "alarm-%d", n);
+    return json_pack("{s:s, s:I, s:s}",
+        "id", "device-1",
+        "tm", (json_int_t)(1700000000 + n),
+        "alarm", alarm_name
+    );
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int check_listed(json_t *tranger, const char *phase, int expected)
+{
+    json_t *messages = msg2db_list_messages(
+        tranger,
+        MSG2DB_NAME,
+        TOPIC_NAME,
+        0,      // jn_ids, owned: all ids
+        0,      // jn_filter, owned
+        0       // match_fn
+    );
+    int listed = (int)json_array_size(messages);
+    JSON_DECREF(messages)
+
+    if(listed != expected) {
+        printf("%sERROR --> %s %s: listed %d messages, expected %d\n",
+            On_Red BWhite, Color_Off, phase, listed, expected
+        );
+        return -1;
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  The __t__ of the listed messages must be <= max_t
+ ***************************************************************************/
+PRIVATE int check_t(json_t *tranger, const char *phase, json_int_t max_t)
+{
+    int ret = 0;
+    json_t *messages = msg2db_list_messages(
+        tranger,
+        MSG2DB_NAME,
+        TOPIC_NAME,
+        0,      // jn_ids, owned: all ids
+        0,      // jn_filter, owned
+        0       // match_fn
+    );
+    size_t idx; json_t *message;
+    json_array_foreach(messages, idx, message) {
+        json_int_t t = kw_get_int(0, message, "__md_msg2db__`t", 0, 0);
+        if(t <= 0 || t > max_t) {
+            printf("%sERROR --> %s %s: message with __t__ %lld, expected <= %lld\n",
+                On_Red BWhite, Color_Off, phase, (long long)t, (long long)max_t
+            );
+            ret = -1;
+        }
+    }
+    JSON_DECREF(messages)
+    return ret;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int do_test(void)
+{
+    int result = 0;
+    char path_root[PATH_MAX];
+    char path_database[PATH_MAX];
+
+    if(!(getenv("YUNETA_STORE") && strlen(getenv("YUNETA_STORE")) > 0)) {
+        snprintf(path_root, sizeof(path_root), "/tmp");
+    } else {
+        snprintf(path_root, sizeof(path_root), "%s", getenv("YUNETA_STORE"));
+    }
+    build_path(path_database, sizeof(path_database), path_root, DATABASE, NULL);
+    rmrdir(path_database);
+
+    #define TRANGER_CONFIG() json_pack("{s:s, s:s, s:b, s:i}", \
+        "path", path_root, \
+        "database", DATABASE, \
+        "master", 1, \
+        "on_critical_error", 0 \
+    )
+
+    /*-------------------------------------------------------*
+     *  First run: buffered appends
+     *-------------------------------------------------------*/
+    set_expected_results("buffered", json_pack("[{s:s}, {s:s}]",
+        "msg", "Creating __timeranger2__.json",
+        "msg", "Creating topic"
+    ), NULL, NULL, TRUE);
+
+    json_t *tranger = tranger2_startup(0, TRANGER_CONFIG(), yev_loop);
+    helper_quote2doublequote(msg2db_schema);
+    json_t *jn_schema = legalstring2json(msg2db_schema, TRUE);
+    msg2db_open_db(tranger, MSG2DB_NAME, jn_schema, "");
+
+    msg2db_set_buffering(tranger, MSG2DB_NAME, MAX_MESSAGES, 0);
+
+    /*
+     *  Queued: nothing returned, nothing listed
+     */
+    for(int i = 0; i < 2; i++) {
+        json_t *record = msg2db_append_message(
+            tranger, MSG2DB_NAME, TOPIC_NAME, new_message(i), ""
+        );
+        if(record) {
+            printf("%sERROR --> %s queued append returned a record\n",
+                On_Red BWhite, Color_Off
+            );
+            result += -1;
+        }
+    }
+    result += check_listed(tranger, "queued", 0);
+    json_int_t appended_t = (json_int_t)time_in_seconds();
+
+    /*
+     *  Explicit flush, in a later second than the appends
+     */
+    while((json_int_t)time_in_seconds() <= appended_t) {
+        usleep(50*1000);
+    }
+    int flushed = msg2db_flush(tranger, MSG2DB_NAME);
+    if(flushed != 2) {
+        printf("%sERROR --> %s flush wrote %d messages, expected 2\n",
+            On_Red BWhite, Color_Off, flushed
+        );
+        result += -1;
+    }
+    result += check_listed(tranger, "flushed", 2);
+    result += check_t(tranger, "flushed", appended_t);
+
+    /*
+     *  The append reaching max_messages flushes, and returns the indexed record
+     */
+    json_t *record = 0;
+    for(int i = 2; i < 2 + MAX_MESSAGES; i++) {
+        record = msg2db_append_message(
+            tranger, MSG2DB_NAME, TOPIC_NAME, new_message(i), ""
+        );
+    }
+    if(!record || !kw_has_key(record, "__md_msg2db__")) {
+        printf("%sERROR --> %s flushing append didn't return the indexed record\n",
+            On_Red BWhite, Color_Off
+        );
+        result += -1;
+    }
+    result += check_listed(tranger, "max_messages", 2 + MAX_MESSAGES);
+
+    /*
+     *  A batch is queued too, and the close flushes it
+     */
+    json_t *kw_list = json_array();
+    json_array_append_new(kw_list, new_message(10));
+    json_array_append_new(kw_list, new_message(11));
+    int queued = msg2db_append_messages(
+        tranger, MSG2DB_NAME, TOPIC_NAME, kw_list, ""
+    );
+    if(queued != 2) {
+        printf("%sERROR --> %s batch queued %d messages, expected 2\n",
+            On_Red BWhite, Color_Off, queued
+        );
+        result += -1;
+    }
+    result += check_listed(tranger, "batch queued", 2 + MAX_MESSAGES);
+
+    msg2db_close_db(tranger, MSG2DB_NAME);
+    tranger2_shutdown(tranger);
+
+    result += test_json(NULL);
+
+    /*-------------------------------------------------------*
+     *  Second run: everything is there
+     *-------------------------------------------------------*/
+    set_expected_results("load", json_array(), NULL, NULL, TRUE);
+
+    tranger = tranger2_startup(0, TRANGER_CONFIG(), yev_loop);
+    helper_quote2doublequote(msg2db_schema);
+    json_t *jn_schema2 = legalstring2json(msg2db_schema, TRUE);
+    msg2db_open_db(tranger, MSG2DB_NAME, jn_schema2, "");
+
+    result += check_listed(tranger, "reload", 2 + MAX_MESSAGES + 2);
+
+    msg2db_close_db(tranger, MSG2DB_NAME);
+    tranger2_shutdown(tranger);
+
+    result += test_json(NULL);
+
+    return result;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void quit_sighandler(int sig)
+{
+    yev_loop_reset_running(yev_loop);
+}
+
+PRIVATE void yuno_catch_signals(void)
+{
+    struct sigaction sigIntHandler;
+    signal(SIGPIPE, SIG_IGN);
+    sigIntHandler.sa_flags = SA_NODEFER|SA_RESTART;
+    sigIntHandler.sa_handler = quit_sighandler;
+    sigemptyset(&sigIntHandler.sa_mask);
+    sigaction(SIGALRM, &sigIntHandler, NULL);
+    sigaction(SIGQUIT, &sigIntHandler, NULL);
+    sigaction(SIGINT, &sigIntHandler, NULL);
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+int main(int argc, char *argv[])
+{
+    setlocale(LC_ALL, "");
+
+    sys_malloc_fn_t malloc_func;
+    sys_realloc_fn_t realloc_func;
+    sys_calloc_fn_t calloc_func;
+    sys_free_fn_t free_func;
+
+    gbmem_get_allocators(&malloc_func, &realloc_func, &calloc_func, &free_func);
+    json_set_alloc_funcs(malloc_func, free_func);
+
+    unsigned long memory_check_list[] = {0}; // WARNING: list ended with 0
+    set_memory_check_list(memory_check_list);
+
+    init_backtrace_with_backtrace(argv[0]);
+    set_show_backtrace_fn(show_backtrace_with_backtrace);
+
+    gbmem_setup(
+        256*1024L,
+        1024*1024*1024L,
+        FALSE,
+        0,
+        0
+    );
+    gobj_start_up(argc, argv, NULL, NULL, NULL, NULL, NULL, NULL);
+
+    yuno_catch_signals();
+
+    gobj_log_add_handler("stdout", "stdout", LOG_OPT_ALL, 0);
+    gobj_log_register_handler(
+        "testing",
+        0,
+        capture_log_write,
+        0
+    );
+    gobj_log_add_handler("test_capture", "testing", LOG_OPT_UP_INFO, 0);
+
+    yev_loop_create(0, 2024, 10, NULL, &yev_loop);
+
+    int result = do_test();
+    result += global_result;
+
+    yev_loop_stop(yev_loop);
+    yev_loop_destroy(yev_loop);
+
+    gobj_end();
+
+    if(get_cur_system_memory() != 0) {
+        printf("%sERROR --> %s%s\n", On_Red BWhite, "system memory not free", Color_Off);
+        print_track_mem();
+        result += -1;
+    }
+    if(result < 0) {
+        printf("<-- %sTEST FAILED%s: %s\n", On_Red BWhite, Color_Off, APP);
+    }
+    return result < 0 ? -1 : 0;
+}
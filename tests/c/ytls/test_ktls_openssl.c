@@ -0,0 +1,480 @@
+/****************************************************************************
+ *          test_ktls_openssl.c
+ *
+ *          Verify the kernel TLS tx offload ("ktls") of the OpenSSL backend:
+ *          the server tx keys go to the kernel after a TLS1.3 handshake and
+ *          the client (user space OpenSSL) decrypts what the server writes
+ *          in clear to the socket. When the kernel refuses, the user space
+ *          TLS goes on, and it's logged.
+ *
+ *          Drives a real handshake between a client filter and a server
+ *          filter through a pair of connected sockets.
+ *
+ *          Test 1: TCP loopback, "ktls" on   -> kTLS tx: clear write() to the
+ *                  socket, ytls_encrypt_data() refused. If the kernel has no
+ *                  tls ulp, the fallback of test 2 (logged, not failed).
+ *          Test 2: unix socketpair, "ktls" on -> setsockopt(TCP_ULP) fails,
+ *                  warning logged, user space TLS goes on
+ *          Test 3: TCP loopback, "ktls" off  -> not capable, user space TLS
+ *
+ *          Copyright (c) 2026, ArtGins.
+ *          All Rights Reserved.
+ ****************************************************************************/
+#define APP "test_ktls_openssl"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#ifdef __linux__
+#include <linux/tls.h>
+#endif
+
+#include <yuneta_config.h>
+#include <gobj.h>
+#include <kwid.h>
+#include <gbuffer.h>
+#include <glogger.h>
+#include <ytls.h>
+
+#if !defined(CONFIG_HAVE_OPENSSL) || !defined(TLS_TX) || !defined(TLS_1_3_VERSION)
+
+int main(int argc, char *argv[])
+{
+    (void)argc; (void)argv;
+    printf("%s: SKIP (CONFIG_HAVE_OPENSSL not set or no kTLS headers)\n", APP);
+    return 0;
+}
+
+#else /* CONFIG_HAVE_OPENSSL */
+
+#define TMP_DIR   "/tmp/ytls_ktls_openssl"
+#define CERT_PATH (TMP_DIR "/cert.pem")
+#define KEY_PATH  (TMP_DIR "/key.pem")
+#define CAPTURE_BUFSZ (256 * 1024)
+
+#define MESSAGE "hello ktls"
+
+/***************************************************************
+ *              Data
+ ***************************************************************/
+PRIVATE char   *capture_buf = NULL;
+PRIVATE size_t  capture_len = 0;
+
+PRIVATE int     tag_client = 0;
+PRIVATE int     tag_server = 1;
+
+PRIVATE int     fds[2] = {-1, -1};      /* [tag] socket */
+PRIVATE int     hs_done[2]  = {0, 0};   /* [tag] handshake callback fired */
+PRIVATE int     hs_error[2] = {0, 0};   /* [tag] last handshake error */
+PRIVATE gbuffer_t *rx_clear[2] = {0, 0}; /* [tag] clear data received */
+
+/***************************************************************
+ *              Prototypes
+ ***************************************************************/
+PRIVATE int   generate_self_signed(void);
+PRIVATE void  cleanup_tmp(void);
+PRIVATE int   capture_write_fn(void *v, int priority, const char *bf, size_t len);
+PRIVATE void  capture_reset(void);
+
+PRIVATE int   on_handshake_done(void *user_data, int error);
+PRIVATE int   on_clear_data(void *user_data, gbuffer_t *gbuf);
+PRIVATE int   on_encrypted_data(void *user_data, gbuffer_t *gbuf);
+
+PRIVATE int   tcp_pair(int pair[2]);
+PRIVATE void  close_pair(void);
+PRIVATE void  pump(hytls ytls, hsskt sskt, int tag, int timeout_ms);
+PRIVATE int   run_handshake(hytls c_ytls, hsskt c, hytls s_ytls, hsskt s);
+PRIVATE BOOL  wait_clear_data(hytls c_ytls, hsskt c, const char *expected);
+
+/***************************************************************************
+ *  Modes of the tx of the server, result of attempt()
+ ***************************************************************************/
+#define TX_SETUP_FAILED     -1
+#define TX_USER_SPACE       0
+#define TX_KERNEL           1
+
+/***************************************************************************
+ *  Handshake over the socket pair, then the server sends MESSAGE twice
+ *  (two records, the kernel sequence must go on) with kTLS if possible.
+ *  Return the tx mode, or TX_SETUP_FAILED (already printed).
+ ***************************************************************************/
+PRIVATE int attempt(const char *label, BOOL ktls, BOOL *capable)
+{
+    int ret = TX_SETUP_FAILED;
+    json_t *server_cfg = json_pack("{s:s, s:s, s:s, s:b}",
+        "library",             "openssl",
+        "ssl_certificate",     CERT_PATH,
+        "ssl_certificate_key", KEY_PATH,
+        "ktls",                ktls
+    );
+    json_t *client_cfg = json_pack("{s:s, s:s, s:s}",
+        "library",                 "openssl",
+        "ssl_trusted_certificate", CERT_PATH,
+        "ssl_server_name",         "localhost"
+    );
+    hytls s_ytls = ytls_init(0, server_cfg, TRUE);
+    hytls c_ytls = ytls_init(0, client_cfg, FALSE);
+    JSON_DECREF(server_cfg);
+    JSON_DECREF(client_cfg);
+    if(!s_ytls || !c_ytls) {
+        fprintf(stderr, "%s[%s]: ytls_init FAILED\n", APP, label);
+        if(s_ytls) ytls_cleanup(s_ytls);
+        if(c_ytls) ytls_cleanup(c_ytls);
+        return TX_SETUP_FAILED;
+    }
+
+    hs_done[0] = hs_done[1] = 0;
+    hs_error[0] = hs_error[1] = 0;
+    rx_clear[0] = gbuffer_create(4*1024, 4*1024);
+    rx_clear[1] = gbuffer_create(4*1024, 4*1024);
+
+    hsskt s = ytls_new_secure_filter(s_ytls, on_handshake_done, on_clear_data, on_encrypted_data, &tag_server);
+    hsskt c = ytls_new_secure_filter(c_ytls, on_handshake_done, on_clear_data, on_encrypted_data, &tag_client);
+    if(!s || !c) {
+        fprintf(stderr, "%s[%s]: ytls_new_secure_filter FAILED\n", APP, label);
+        goto end;
+    }
+
+    if(run_handshake(c_ytls, c, s_ytls, s) != 0 || hs_error[1] != 0) {
+        fprintf(stderr, "%s[%s]: handshake FAILED, client error=%d, server error=%d\n",
+            APP, label, hs_error[0], hs_error[1]);
+        goto end;
+    }
+
+    /*
+     *  The server has written all its handshake records (TLS1.3, no tickets)
+     */
+    *capable = ytls_ktls_tx_capable(s_ytls, s);
+    if(ytls_enable_ktls_tx(s_ytls, s, fds[tag_server]) > 0) {
+        /*
+         *  The kernel encrypts: clear data to the socket
+         */
+        for(int i=0; i<2; i++) {
+            if(write(fds[tag_server], MESSAGE, strlen(MESSAGE)) != (ssize_t)strlen(MESSAGE)) {
+                fprintf(stderr, "%s[%s]: write() with kTLS FAILED\n", APP, label);
+                goto end;
+            }
+        }
+
+        /*
+         *  OpenSSL must not encrypt anymore, it's refused and logged
+         */
+        gbuffer_t *gbuf = gbuffer_create(strlen(MESSAGE), strlen(MESSAGE));
+        gbuffer_append_string(gbuf, MESSAGE);
+        if(ytls_encrypt_data(s_ytls, s, gbuf) != -1 ||
+                !strstr(capture_buf, "kTLS tx active")) {
+            fprintf(stderr, "%s[%s]: ytls_encrypt_data() NOT refused with kTLS tx\n", APP, label);
+            goto end;
+        }
+        ret = TX_KERNEL;
+
+    } else {
+        if(ytls_ktls_tx_capable(s_ytls, s)) {
+            fprintf(stderr, "%s[%s]: still kTLS capable after the fallback\n", APP, label);
+            goto end;
+        }
+        for(int i=0; i<2; i++) {
+            gbuffer_t *gbuf = gbuffer_create(strlen(MESSAGE), strlen(MESSAGE));
+            gbuffer_append_string(gbuf, MESSAGE);
+            if(ytls_encrypt_data(s_ytls, s, gbuf) < 0) {
+                fprintf(stderr, "%s[%s]: ytls_encrypt_data() FAILED\n", APP, label);
+                goto end;
+            }
+        }
+        ret = TX_USER_SPACE;
+    }
+
+    if(!wait_clear_data(c_ytls, c, MESSAGE MESSAGE)) {
+        fprintf(stderr, "%s[%s]: client did NOT receive the data (%s tx)\n",
+            APP, label, ret==TX_KERNEL? "kernel":"user space");
+        ret = TX_SETUP_FAILED;
+    }
+
+end:
+    if(c) ytls_free_secure_filter(c_ytls, c);
+    if(s) ytls_free_secure_filter(s_ytls, s);
+    GBUFFER_DECREF(rx_clear[0])
+    GBUFFER_DECREF(rx_clear[1])
+    ytls_cleanup(c_ytls);
+    ytls_cleanup(s_ytls);
+    return ret;
+}
+
+/***************************************************************************
+ *              Test
+ ***************************************************************************/
+int main(int argc, char *argv[])
+{
+    int result = 0;
+
+    gobj_start_up(argc, argv, NULL, NULL, NULL, NULL, NULL, NULL);
+
+    capture_buf = malloc(CAPTURE_BUFSZ);
+    if(!capture_buf) { gobj_end(); return 1; }
+    capture_reset();
+    gobj_log_register_handler("capture", 0, capture_write_fn, 0);
+    gobj_log_add_handler("capture", "capture", LOG_OPT_ALL, 0);
+
+    cleanup_tmp();
+    if(mkdir(TMP_DIR, 0700) != 0 || generate_self_signed() != 0) {
+        fprintf(stderr, "%s: cert setup FAILED (is `openssl` installed?)\n", APP);
+        result = 1;
+        goto out;
+    }
+
+    /* Test 1: TCP, ktls on -> kernel tx, or the logged fallback */
+    capture_reset();
+    if(tcp_pair(fds) < 0) {
+        fprintf(stderr, "%s[1]: tcp loopback FAILED\n", APP);
+        result++;
+    } else {
+        BOOL capable = FALSE;
+        int mode = attempt("1", TRUE, &capable);
+        if(mode == TX_SETUP_FAILED) {
+            result++;
+        } else if(!capable) {
+            fprintf(stderr, "%s[1]: TLS1.3 connection NOT kTLS capable\n", APP);
+            result++;
+        } else if(mode == TX_KERNEL) {
+            printf("%s[1]: ok - kTLS tx, clear write() decrypted by the peer\n", APP);
+        } else if(strstr(capture_buf, "using user space TLS")) {
+            printf("%s[1]: ok - kernel without tls ulp, user space fallback logged\n", APP);
+        } else {
+            fprintf(stderr, "%s[1]: kTLS NOT enabled and NOT logged\n", APP);
+            result++;
+        }
+        close_pair();
+    }
+
+    /* Test 2: unix socket, ktls on -> TCP_ULP refused, user space TLS */
+    capture_reset();
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        fprintf(stderr, "%s[2]: socketpair FAILED\n", APP);
+        result++;
+    } else {
+        BOOL capable = FALSE;
+        int mode = attempt("2", TRUE, &capable);
+        if(mode == TX_USER_SPACE && capable &&
+                strstr(capture_buf, "kTLS: setsockopt(TCP_ULP) FAILED")) {
+            printf("%s[2]: ok - TCP_ULP refused, logged, user space TLS goes on\n", APP);
+        } else {
+            fprintf(stderr, "%s[2]: expected the logged user space fallback, mode=%d capable=%d\n",
+                APP, mode, capable);
+            result++;
+        }
+        close_pair();
+    }
+
+    /* Test 3: TCP, ktls off -> user space TLS, nothing logged about kTLS */
+    capture_reset();
+    if(tcp_pair(fds) < 0) {
+        fprintf(stderr, "%s[3]: tcp loopback FAILED\n", APP);
+        result++;
+    } else {
+        BOOL capable = TRUE;
+        int mode = attempt("3", FALSE, &capable);
+        if(mode == TX_USER_SPACE && !capable && !strstr(capture_buf, "kTLS")) {
+            printf("%s[3]: ok - ktls off, user space TLS\n", APP);
+        } else {
+            fprintf(stderr, "%s[3]: expected user space TLS, mode=%d capable=%d\n",
+                APP, mode, capable);
+            result++;
+        }
+        close_pair();
+    }
+
+    printf("\n%s: %s\n", APP, result==0 ? "PASS" : "FAIL");
+
+out:
+    cleanup_tmp();
+    gobj_log_del_handler("capture");
+    free(capture_buf);
+    capture_buf = NULL;
+    gobj_end();
+    return result;
+}
+
+/***************************************************************
+ *              Local Methods
+ ***************************************************************/
+/***************************************************************************
+ *  Connected TCP sockets on 127.0.0.1: pair[tag_client], pair[tag_server]
+ ***************************************************************************/
+PRIVATE int tcp_pair(int pair[2])
+{
+    struct sockaddr_in addr;
+    socklen_t addrlen = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+
+    int fd_listen = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd_listen < 0) {
+        return -1;
+    }
+    if(bind(fd_listen, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+            listen(fd_listen, 1) < 0 ||
+            getsockname(fd_listen, (struct sockaddr *)&addr, &addrlen) < 0) {
+        close(fd_listen);
+        return -1;
+    }
+
+    pair[tag_client] = socket(AF_INET, SOCK_STREAM, 0);
+    if(pair[tag_client] < 0 ||
+            connect(pair[tag_client], (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        if(pair[tag_client] >= 0) close(pair[tag_client]);
+        close(fd_listen);
+        return -1;
+    }
+    pair[tag_server] = accept(fd_listen, NULL, NULL);
+    close(fd_listen);
+    if(pair[tag_server] < 0) {
+        close(pair[tag_client]);
+        return -1;
+    }
+    return 0;
+}
+
+PRIVATE void close_pair(void)
+{
+    for(int i=0; i<2; i++) {
+        if(fds[i] >= 0) {
+            close(fds[i]);
+            fds[i] = -1;
+        }
+    }
+}
+
+/***************************************************************************
+ *  Feed the filter with what its socket has received
+ ***************************************************************************/
+PRIVATE void pump(hytls ytls, hsskt sskt, int tag, int timeout_ms)
+{
+    struct pollfd pfd = {.fd = fds[tag], .events = POLLIN};
+    while(poll(&pfd, 1, timeout_ms) > 0 && (pfd.revents & POLLIN)) {
+        char bf[16*1024];
+        ssize_t n = read(fds[tag], bf, sizeof(bf));
+        if(n <= 0) {
+            return;
+        }
+        gbuffer_t *g = gbuffer_create((size_t)n, (size_t)n);
+        gbuffer_append(g, bf, (size_t)n);
+        ytls_decrypt_data(ytls, sskt, g);   /* takes ownership */
+        timeout_ms = 0;
+    }
+}
+
+PRIVATE int run_handshake(hytls c_ytls, hsskt c, hytls s_ytls, hsskt s)
+{
+    ytls_do_handshake(c_ytls, c);   /* client sends ClientHello */
+    for(int i=0; i<50 && (!hs_done[0] || !hs_done[1]); i++) {
+        pump(s_ytls, s, tag_server, 100);   /* server consumes client bytes */
+        ytls_do_handshake(s_ytls, s);
+        pump(c_ytls, c, tag_client, 100);   /* client consumes server bytes */
+        ytls_do_handshake(c_ytls, c);
+    }
+    return (hs_done[0] && hs_done[1]) ? hs_error[0] : -1;   /* client verdict */
+}
+
+PRIVATE BOOL wait_clear_data(hytls c_ytls, hsskt c, const char *expected)
+{
+    size_t len = strlen(expected);
+    for(int i=0; i<20 && gbuffer_leftbytes(rx_clear[tag_client]) < len; i++) {
+        pump(c_ytls, c, tag_client, 100);
+    }
+    return gbuffer_leftbytes(rx_clear[tag_client]) == len &&
+        memcmp(gbuffer_cur_rd_pointer(rx_clear[tag_client]), expected, len)==0;
+}
+
+PRIVATE void capture_reset(void)
+{
+    capture_len = 0;
+    if(capture_buf) capture_buf[0] = '\0';
+}
+
+PRIVATE int capture_write_fn(void *v, int priority, const char *bf, size_t len)
+{
+    (void)v; (void)priority;
+    if(!capture_buf || len == 0 || capture_len + len + 2 >= CAPTURE_BUFSZ) {
+        return 0;
+    }
+    memcpy(capture_buf + capture_len, bf, len);
+    capture_len += len;
+    capture_buf[capture_len++] = '\n';
+    capture_buf[capture_len] = '\0';
+    return 0;
+}
+
+PRIVATE int generate_self_signed(void)
+{
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd),
+        "openssl req -x509 -newkey rsa:2048 -nodes -sha256 -days 30 "
+        "-keyout '%s' -out '%s' -subj '/CN=localhost' "
+        "-addext 'subjectAltName=DNS:localhost' >/dev/null 2>&1",
+        KEY_PATH, CERT_PATH
+    );
+    if(system(cmd) != 0) return -1;
+    struct stat st;
+    if(stat(CERT_PATH, &st) != 0 || st.st_size == 0) return -1;
+    if(stat(KEY_PATH,  &st) != 0 || st.st_size == 0) return -1;
+    return 0;
+}
+
+PRIVATE void cleanup_tmp(void)
+{
+    unlink(CERT_PATH);
+    unlink(KEY_PATH);
+    rmdir(TMP_DIR);
+}
+
+/***************************************************************************
+ *  Filter callbacks
+ ***************************************************************************/
+PRIVATE int on_handshake_done(void *user_data, int error)
+{
+    int tag = *(int *)user_data;
+    hs_done[tag] = 1;
+    hs_error[tag] = error;
+    return 0;
+}
+
+PRIVATE int on_clear_data(void *user_data, gbuffer_t *gbuf)
+{
+    int tag = *(int *)user_data;
+    size_t n = gbuffer_leftbytes(gbuf);
+    if(n > 0) {
+        gbuffer_append(rx_clear[tag], gbuffer_cur_rd_pointer(gbuf), n);
+    }
+    GBUFFER_DECREF(gbuf)
+    return 0;
+}
+
+/*
+ *  The encrypted data goes to the socket of the filter
+ */
+PRIVATE int on_encrypted_data(void *user_data, gbuffer_t *gbuf)
+{
+    int tag = *(int *)user_data;
+    size_t n = gbuffer_leftbytes(gbuf);
+    const char *p = gbuffer_cur_rd_pointer(gbuf);
+    while(n > 0) {
+        ssize_t written = write(fds[tag], p, n);
+        if(written <= 0) {
+            break;
+        }
+        p += written;
+        n -= (size_t)written;
+    }
+    GBUFFER_DECREF(gbuf)
+    return 0;
+}
+
+#endif /* CONFIG_HAVE_OPENSSL */
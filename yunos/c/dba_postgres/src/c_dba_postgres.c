@@ -13,6 +13,7 @@
 #include <string.h>
 #include <limits.h>
 #include <stdio.h>
+#include <time.h>
 #include <c_postgres.h>
 #include "c_dba_postgres.h"
 
@@ -35,10 +36,18 @@ PRIVATE json_t *record2createtable(
 PRIVATE json_t *record2insertsql(
     hgobj gobj,
     json_t *schema, // not owned
-    json_t *record // not owned
+    json_t *record, // not owned
+    json_t *jn_params // not owned, filled with the values of the query
+);
+PRIVATE json_t *records2copy(
+    hgobj gobj,
+    json_t *schema, // not owned
+    json_t *records // not owned
 );
 PRIVATE void append_sql_identifier(gbuffer_t *gbuf, const char *s);
-PRIVATE void append_sql_literal(gbuffer_t *gbuf, const char *s);
+PRIVATE int flush_copy_batch(hgobj gobj, const char *topic_name);
+PRIVATE void release_copy_keys(hgobj gobj, json_t *msgs);
+PRIVATE int create_add_row_task(hgobj gobj, json_t *kw);
 
 PRIVATE int send_ack(
     hgobj gobj,
@@ -86,6 +95,7 @@ SDATA (DTP_INTEGER,     "maxtxMsgsec",  SDF_WR|SDF_RSTATS,      0,          "Max
 SDATA (DTP_INTEGER,     "maxrxMsgsec",  SDF_WR|SDF_RSTATS,      0,          "Max Rx Messages by second"),
 
 SDATA (DTP_INTEGER,     "timeout",      SDF_RD,                 "1000",     "Timeout"),
+SDATA (DTP_INTEGER,     "copy_max_rows",SDF_WR,                 "1000",     "Max rows by COPY of the append only tables, the rows waiting are copied in each timeout too"),
 SDATA (DTP_POINTER,     "user_data",    0,                      0,          "user data"),
 SDATA (DTP_POINTER,     "user_data2",   0,                      0,          "more user data"),
 SDATA_END()
@@ -115,6 +125,11 @@ typedef struct _PRIVATE_DATA {
 
     int32_t exit_on_error;
 
+    int32_t copy_max_rows;
+    json_t *jn_copy_batches;    // topic: {"schema", "msgs"}, rows of append only tables waiting COPY
+    json_t *jn_copy_keys;       // "id-__msg_key__": rows batched or being copied
+    uint32_t copy_seq;
+
     uint64_t txMsgs;
     uint64_t rxMsgs;
     uint64_t txMsgsec;
@@ -145,8 +160,11 @@ PRIVATE void mt_create(hgobj gobj)
      */
     SET_PRIV(timeout,               gobj_read_integer_attr)
     SET_PRIV(exit_on_error,             gobj_read_integer_attr)
+    SET_PRIV(copy_max_rows,             gobj_read_integer_attr)
 
     priv->timer = gobj_create_pure_child(gobj_name(gobj), C_TIMER, 0, gobj);
+    priv->jn_copy_batches = json_object();
+    priv->jn_copy_keys = json_object();
 }
 
 /***************************************************************************
@@ -157,6 +175,7 @@ PRIVATE void mt_writing(hgobj gobj, const char *path)
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
     IF_EQ_SET_PRIV(timeout,         gobj_read_integer_attr)
+    ELIF_EQ_SET_PRIV(copy_max_rows, gobj_read_integer_attr)
     END_EQ_SET_PRIV()
 }
 
@@ -165,6 +184,10 @@ PRIVATE void mt_writing(hgobj gobj, const char *path)
  ***************************************************************************/
 PRIVATE void mt_destroy(hgobj gobj)
 {
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    JSON_DECREF(priv->jn_copy_batches);
+    JSON_DECREF(priv->jn_copy_keys);
 }
 
 /***************************************************************************
@@ -238,6 +261,15 @@ PRIVATE int mt_pause(hgobj gobj)
 
     clear_timeout(priv->timer);
 
+    /*
+     *  Rows waiting COPY are not acked, the sender will send them again
+     */
+    const char *topic_name; json_t *jn_batch;
+    json_object_foreach(priv->jn_copy_batches, topic_name, jn_batch) {
+        release_copy_keys(gobj, kw_get_list(gobj, jn_batch, "msgs", 0, KW_REQUIRED));
+    }
+    json_object_clear(priv->jn_copy_batches);
+
     return 0;
 }
 
@@ -356,15 +388,29 @@ PRIVATE json_t *action_add_row(
     char id[NAME_MAX];
     snprintf(id, sizeof(id), "%s", gobj_name(src));
 
-    json_t *query = json_pack("{s:s, s:s, s:o}",
+    json_t *jn_params = json_array();
+    json_t *jn_sql = record2insertsql(
+        gobj,
+        schema_,
+        input_data,
+        jn_params
+    );
+    if(!jn_sql) {
+        // Error already logged
+        JSON_DECREF(jn_params);
+        KW_DECREF(kw);
+        STOP_TASK();
+    }
+
+    /*
+     *  Same sql for all the rows of a table: prepared once by connection
+     */
+    json_t *query = json_pack("{s:s, s:s, s:o, s:o, s:b}",
         "id", id,
         "dst", gobj_name(src),
-        "query",
-        record2insertsql(
-            gobj,
-            schema_,
-            input_data
-        )
+        "query", jn_sql,
+        "params", jn_params,
+        "prepare", 1
     );
     gobj_send_event(priv->gobj_postgres, EV_SEND_QUERY, query, gobj);
 
@@ -422,6 +468,102 @@ PRIVATE json_t *result_add_row(
     CONTINUE_TASK();
 }
 
+/***************************************************************************
+ *  COPY the rows batched of an append only table
+ ***************************************************************************/
+PRIVATE json_t *action_copy_rows(
+    hgobj gobj,
+    const char *lmethod,
+    json_t *kw,
+    hgobj src // Source is the GCLASS_TASK
+)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_t *input_data = gobj_read_json_attr(src, "input_data");
+    json_t *schema_ = kw_get_dict(gobj, input_data, "schema", 0, KW_REQUIRED);
+    json_t *msgs = kw_get_list(gobj, input_data, "msgs", 0, KW_REQUIRED);
+
+    json_t *query = records2copy(gobj, schema_, msgs);
+    json_object_set_new(query, "id", json_string(gobj_name(src)));
+    json_object_set_new(query, "dst", json_string(gobj_name(src)));
+    gobj_send_event(priv->gobj_postgres, EV_SEND_QUERY, query, gobj);
+
+    KW_DECREF(kw);
+    CONTINUE_TASK();
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE json_t *result_copy_rows(
+    hgobj gobj,
+    const char *lmethod,
+    json_t *kw,
+    hgobj src // Source is the GCLASS_TASK
+)
+{
+    int result = kw_get_int(gobj, kw, "result", -1, KW_REQUIRED);
+
+    json_t *input_data = gobj_read_json_attr(src, "input_data");
+    json_t *msgs = kw_get_list(gobj, input_data, "msgs", 0, KW_REQUIRED);
+
+    release_copy_keys(gobj, msgs);
+
+    if(result < 0) {
+        char temp[512];
+        const char *comment = kw_get_str(gobj, kw, "comment", "", 0);
+        snprintf(temp, sizeof(temp), "Postgres: cannot copy rows -> %s", comment);
+        char *p = strchr(temp, '\n');
+        if(p) {
+            *p = 0;
+        }
+        left_justify(temp);
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_POSTGRES,
+            "msg",          "%s", temp,
+            "rows",         "%d", (int)json_array_size(msgs),
+            NULL
+        );
+        gobj_trace_json(gobj, kw, "%s", temp);
+
+        /*
+         *  A bad row fails the whole COPY: insert the rows one by one,
+         *  each row is acked by result_add_row, the batch is not lost.
+         */
+        size_t idx; json_t *msg;
+        json_array_foreach(msgs, idx, msg) {
+            create_add_row_task(gobj, msg);
+        }
+
+        KW_DECREF(kw);
+        CONTINUE_TASK();
+    }
+
+    /*
+     *  Batch copied, ack all the rows
+     */
+    size_t idx; json_t *msg;
+    json_array_foreach(msgs, idx, msg) {
+        json_t *__temp__ = kw_get_dict_value(gobj, msg, "__temp__", 0, KW_REQUIRED|KW_EXTRACT);
+
+        json_t *kw_ack = trq_answer(
+            msg,  // not owned
+            0
+        );
+
+        send_ack(
+            gobj,
+            kw_ack, // owned
+            __temp__ // owned, Set the channel
+        );
+    }
+
+    KW_DECREF(kw);
+    CONTINUE_TASK();
+}
+
 // /***************************************************************************
 //  *
 //  ***************************************************************************/
@@ -614,13 +756,10 @@ PRIVATE json_t *record2createtable(
  ***************************************************************************/
 /***************************************************************************
  *  Conn-less SQL escaping. The PGconn lives in the C_POSTGRES child gobj, not
- *  here, so PQescapeLiteral/Identifier aren't reachable. Field values AND the
- *  schema arrive over the wire, so everything interpolated into the SQL must be
- *  escaped to prevent SQL injection.
+ *  here, so PQescapeIdentifier isn't reachable. The schema arrives over the
+ *  wire, so the identifiers interpolated into the SQL must be escaped to
+ *  prevent SQL injection. The values go as query parameters or COPY data.
  *    identifier: "x"  with any interior " doubled
- *    literal:    'x'  with any interior ' doubled (safe under PostgreSQL
- *                standard_conforming_strings, on by default, where backslash is
- *                an ordinary character)
  ***************************************************************************/
 PRIVATE void append_sql_identifier(gbuffer_t *gbuf, const char *s)
 {
@@ -633,35 +772,16 @@ PRIVATE void append_sql_identifier(gbuffer_t *gbuf, const char *s)
     }
     gbuffer_append_char(gbuf, '"');
 }
-PRIVATE void append_sql_literal(gbuffer_t *gbuf, const char *s)
-{
-    gbuffer_append_char(gbuf, '\'');
-    for(; s && *s; s++) {
-        if(*s == '\'') {
-            gbuffer_append_char(gbuf, '\'');
-        }
-        gbuffer_append_char(gbuf, (uint8_t)*s);
-    }
-    gbuffer_append_char(gbuf, '\'');
-}
 
-PRIVATE json_t *record2insertsql(
-    hgobj gobj,
-    json_t *schema, // not owned
-    json_t *record // not owned
-)
+/***************************************************************************
+ *  Column list of the table: ("col1","col2",...)
+ ***************************************************************************/
+PRIVATE void append_sql_columns(hgobj gobj, gbuffer_t *gbuf, json_t *schema)
 {
-    const char *topic_name = kw_get_str(gobj, schema, "id", "", KW_REQUIRED);
     BOOL use_header = kw_get_bool(gobj, schema, "use_header", 0, KW_REQUIRED);
-
-    gbuffer_t *gbuf = gbuffer_create(32*1024, 32*1024);
-
-    gbuffer_append_string(gbuf, "INSERT INTO ");
-    append_sql_identifier(gbuf, topic_name);
-    gbuffer_append_string(gbuf, " (");
-
     json_t *cols = kw_get_dict(gobj, schema, "cols", 0, KW_REQUIRED);
 
+    gbuffer_append_string(gbuf, " (");
     int idx = 0;
     const char *col_name; json_t *col;
     json_object_foreach(cols, col_name, col) {
@@ -675,84 +795,94 @@ PRIVATE json_t *record2insertsql(
 
         idx++;
     }
+    gbuffer_append_string(gbuf, ")");
+}
+
+/***************************************************************************
+ *  INSERT with parameters, the values are appended to jn_params.
+ *  The sql only depends of the schema, it's prepared once by connection.
+ ***************************************************************************/
+PRIVATE json_t *record2insertsql(
+    hgobj gobj,
+    json_t *schema, // not owned
+    json_t *record, // not owned
+    json_t *jn_params // not owned, filled with the values of the query
+)
+{
+    const char *topic_name = kw_get_str(gobj, schema, "id", "", KW_REQUIRED);
+
+    gbuffer_t *gbuf = gbuffer_create(4*1024, 32*1024);
+
+    gbuffer_append_string(gbuf, "INSERT INTO ");
+    append_sql_identifier(gbuf, topic_name);
+    append_sql_columns(gobj, gbuf, schema);
+    gbuffer_printf(gbuf, " VALUES (");
 
-    gbuffer_printf(gbuf, ") VALUES (");
+    json_t *cols = kw_get_dict(gobj, schema, "cols", 0, KW_REQUIRED);
 
-    idx = 0;
+    int idx = 0;
+    const char *col_name; json_t *col;
     json_object_foreach(cols, col_name, col) {
         if(idx > 0) {
             gbuffer_printf(gbuf, "," );
         }
+        int n = idx + 1;
 
         const char *type = kw_get_str(gobj, col, "type", "", KW_REQUIRED);
         SWITCHS(type) {
             CASES("str")
             CASES("string")
                 json_t *value = kw_get_dict_value(gobj, record, col_name, 0, KW_REQUIRED);
-                if(value) {
-                    /*
-                     *  Emit a properly-escaped SQL string literal. The previous
-                     *  json2uglystr + change_char('"','\'') did NOT double interior
-                     *  single quotes -> SQL injection.
-                     */
-                    if(json_is_string(value)) {
-                        append_sql_literal(gbuf, json_string_value(value));
-                    } else {
-                        char *s = json2uglystr(value);
-                        append_sql_literal(gbuf, s?s:"");
-                        gbmem_free(s);
-                    }
+                if(!value || json_is_null(value)) {
+                    json_array_append_new(jn_params, json_null());
+                } else if(json_is_string(value)) {
+                    json_array_append(jn_params, value);
+                } else {
+                    char *s = json2uglystr(value);
+                    json_array_append_new(jn_params, json_string(s?s:""));
+                    gbmem_free(s);
                 }
+                gbuffer_printf(gbuf, "$%d", n);
                 break;
 
             CASES("int")
             CASES("integer")
                 json_int_t value = kw_get_int(gobj, record, col_name, 0, KW_REQUIRED|KW_WILD_NUMBER);
-                gbuffer_printf(gbuf, "%"JSON_INTEGER_FORMAT, value);
+                json_array_append_new(jn_params, json_integer(value));
+                gbuffer_printf(gbuf, "$%d", n);
                 break;
 
             CASES("time")
                 json_t *value = kw_get_dict_value(gobj, record, col_name, 0, KW_REQUIRED);
-                if(value) {
-                    /*
-                     *  The time value is interpolated UNQUOTED into an arithmetic
-                     *  expression, so it must be numeric — a string here would be
-                     *  raw SQL injection. Coerce to a number; reject otherwise.
-                     */
-                    if(!json_is_number(value)) {
-                        gobj_log_error(gobj, 0,
-                            "function",     "%s", __FUNCTION__,
-                            "msgset",       "%s", MSGSET_POSTGRES,
-                            "msg",          "%s", "time column value is not numeric",
-                            "column",       "%s", col_name,
-                            NULL
-                        );
-                        GBUFFER_DECREF(gbuf)
-                        return NULL;
-                    }
-                    if(json_is_integer(value)) {
-                        gbuffer_printf(gbuf,
-                            "('epoch'::timestamp + %"JSON_INTEGER_FORMAT" * '1 second'::interval)",
-                            json_integer_value(value)
-                        );
-                    } else {
-                        gbuffer_printf(gbuf,
-                            "('epoch'::timestamp + %f * '1 second'::interval)",
-                            json_real_value(value)
-                        );
-                    }
+                if(value && !json_is_number(value)) {
+                    gobj_log_error(gobj, 0,
+                        "function",     "%s", __FUNCTION__,
+                        "msgset",       "%s", MSGSET_POSTGRES,
+                        "msg",          "%s", "time column value is not numeric",
+                        "column",       "%s", col_name,
+                        NULL
+                    );
+                    GBUFFER_DECREF(gbuf)
+                    return NULL;
                 }
+                json_array_append(jn_params, value?value:json_null());
+                gbuffer_printf(gbuf,
+                    "('epoch'::timestamp + $%d::double precision * '1 second'::interval)",
+                    n
+                );
                 break;
 
             CASES("real")
                 double value = kw_get_real(gobj, record, col_name, 0, KW_REQUIRED|KW_WILD_NUMBER);
-                gbuffer_printf(gbuf, "%f", value);
+                json_array_append_new(jn_params, json_real(value));
+                gbuffer_printf(gbuf, "$%d", n);
                 break;
 
             CASES("bool")
             CASES("boolean")
                 BOOL value = kw_get_bool(gobj, record, col_name, 0, KW_REQUIRED|KW_WILD_NUMBER);
-                gbuffer_printf(gbuf, "%s", value?"TRUE":"FALSE");
+                json_array_append_new(jn_params, json_boolean(value));
+                gbuffer_printf(gbuf, "$%d", n);
                 break;
 
             DEFAULTS
@@ -763,13 +893,15 @@ PRIVATE json_t *record2insertsql(
                     "type",         "%s", type,
                     NULL
                 );
+                json_array_append_new(jn_params, json_null());
+                gbuffer_printf(gbuf, "$%d", n);
                 break;
         } SWITCHS_END;
 
         idx++;
     }
 
-    gbuffer_printf(gbuf, ");");
+    gbuffer_printf(gbuf, ")");
     char *p = gbuffer_cur_rd_pointer(gbuf);
     json_t *jn_query = json_string(p);
 
@@ -779,32 +911,293 @@ PRIVATE json_t *record2insertsql(
 }
 
 /***************************************************************************
- *
+ *  Value in COPY text format: backslash, tab, newline and CR escaped
  ***************************************************************************/
-PRIVATE int process_msg(
+PRIVATE void append_copy_text(gbuffer_t *gbuf, const char *s)
+{
+    for(; s && *s; s++) {
+        switch(*s) {
+            case '\\':
+                gbuffer_append_string(gbuf, "\\\\");
+                break;
+            case '\t':
+                gbuffer_append_string(gbuf, "\\t");
+                break;
+            case '\n':
+                gbuffer_append_string(gbuf, "\\n");
+                break;
+            case '\r':
+                gbuffer_append_string(gbuf, "\\r");
+                break;
+            default:
+                gbuffer_append_char(gbuf, (uint8_t)*s);
+                break;
+        }
+    }
+}
+
+/***************************************************************************
+ *  Epoch seconds as timestamp (UTC, as 'epoch'::timestamp + n seconds)
+ ***************************************************************************/
+PRIVATE void append_copy_time(gbuffer_t *gbuf, double t)
+{
+    time_t secs = (time_t)t;
+    if((double)secs > t) {
+        secs--;
+    }
+    long usecs = (long)((t - (double)secs) * 1000000.0 + 0.5);
+    if(usecs >= 1000000) {
+        secs++;
+        usecs -= 1000000;
+    }
+
+    struct tm tm;
+    gmtime_r(&secs, &tm);
+    char temp[64];
+    strftime(temp, sizeof(temp), "%Y-%m-%d %H:%M:%S", &tm);
+    gbuffer_printf(gbuf, "%s.%06ld", temp, usecs);
+}
+
+/***************************************************************************
+ *  COPY FROM STDIN of the records, return the query for C_POSTGRES:
+ *      {"query": "COPY ...", "copy_data": "rows in text format"}
+ ***************************************************************************/
+PRIVATE json_t *records2copy(
     hgobj gobj,
-    json_t *kw,  // NOT owned
-    hgobj src
+    json_t *schema, // not owned
+    json_t *records // not owned
+)
+{
+    const char *topic_name = kw_get_str(gobj, schema, "id", "", KW_REQUIRED);
+    json_t *cols = kw_get_dict(gobj, schema, "cols", 0, KW_REQUIRED);
+
+    gbuffer_t *gbuf = gbuffer_create(1024, 1024);
+    gbuffer_append_string(gbuf, "COPY ");
+    append_sql_identifier(gbuf, topic_name);
+    append_sql_columns(gobj, gbuf, schema);
+    gbuffer_append_string(gbuf, " FROM STDIN");
+    json_t *jn_query = json_string(gbuffer_cur_rd_pointer(gbuf));
+    gbuffer_decref(gbuf);
+
+    gbuf = gbuffer_create(64*1024, 64*1024*1024);
+
+    size_t idx; json_t *record;
+    json_array_foreach(records, idx, record) {
+        int i = 0;
+        const char *col_name; json_t *col;
+        json_object_foreach(cols, col_name, col) {
+            if(i > 0) {
+                gbuffer_append_char(gbuf, '\t');
+            }
+            i++;
+
+            json_t *value = kw_get_dict_value(gobj, record, col_name, 0, KW_REQUIRED);
+            if(!value || json_is_null(value)) {
+                gbuffer_append_string(gbuf, "\\N");
+                continue;
+            }
+
+            const char *type = kw_get_str(gobj, col, "type", "", KW_REQUIRED);
+            SWITCHS(type) {
+                CASES("str")
+                CASES("string")
+                    if(json_is_string(value)) {
+                        append_copy_text(gbuf, json_string_value(value));
+                    } else {
+                        char *s = json2uglystr(value);
+                        append_copy_text(gbuf, s?s:"");
+                        gbmem_free(s);
+                    }
+                    break;
+
+                CASES("int")
+                CASES("integer")
+                    gbuffer_printf(gbuf, "%"JSON_INTEGER_FORMAT,
+                        kw_get_int(gobj, record, col_name, 0, KW_REQUIRED|KW_WILD_NUMBER)
+                    );
+                    break;
+
+                CASES("time")
+                    if(!json_is_number(value)) {
+                        gobj_log_error(gobj, 0,
+                            "function",     "%s", __FUNCTION__,
+                            "msgset",       "%s", MSGSET_POSTGRES,
+                            "msg",          "%s", "time column value is not numeric",
+                            "column",       "%s", col_name,
+                            NULL
+                        );
+                        gbuffer_append_string(gbuf, "\\N");
+                        break;
+                    }
+                    append_copy_time(gbuf, json_number_value(value));
+                    break;
+
+                CASES("real")
+                    gbuffer_printf(gbuf, "%.17g",
+                        kw_get_real(gobj, record, col_name, 0, KW_REQUIRED|KW_WILD_NUMBER)
+                    );
+                    break;
+
+                CASES("bool")
+                CASES("boolean")
+                    gbuffer_append_char(gbuf,
+                        kw_get_bool(gobj, record, col_name, 0, KW_REQUIRED|KW_WILD_NUMBER)?'t':'f'
+                    );
+                    break;
+
+                DEFAULTS
+                    gobj_log_error(gobj, 0,
+                        "function",     "%s", __FUNCTION__,
+                        "msgset",       "%s", MSGSET_POSTGRES,
+                        "msg",          "%s", "Type header UNKNOWN",
+                        "type",         "%s", type,
+                        NULL
+                    );
+                    gbuffer_append_string(gbuf, "\\N");
+                    break;
+            } SWITCHS_END;
+        }
+        gbuffer_append_char(gbuf, '\n');
+    }
+
+    json_t *jn_copy = json_stringn(
+        gbuffer_cur_rd_pointer(gbuf),
+        gbuffer_leftbytes(gbuf)
+    );
+    gbuffer_decref(gbuf);
+
+    return json_pack("{s:o, s:o}",
+        "query", jn_query,
+        "copy_data", jn_copy
+    );
+}
+
+/***************************************************************************
+ *  Append only tables: the rows are batched and inserted with COPY,
+ *  the acks are sent when the batch is copied.
+ ***************************************************************************/
+PRIVATE int batch_msg(
+    hgobj gobj,
+    json_t *schema, // not owned
+    json_t *kw  // not owned
 )
 {
     PRIVATE_DATA *priv = gobj_priv_data(gobj);
 
-    /*-----------------------------*
-     *      Build task name
-     *-----------------------------*/
-    const char *id = kw_get_str(gobj, kw, "id", "", KW_REQUIRED);
-    json_int_t __msg_key__ = kw_get_int(gobj, kw, "__md_trq__`__msg_key__", 0, KW_REQUIRED);
-    if(!__msg_key__) {
+    const char *topic_name = kw_get_str(gobj, schema, "id", "", KW_REQUIRED);
+
+    /*
+     *  Check if the msg is already batched or being copied (redelivered by the sender)
+     */
+    char copy_key[NAME_MAX];
+    snprintf(copy_key, sizeof(copy_key), "%s-%"JSON_INTEGER_FORMAT,
+        kw_get_str(gobj, kw, "id", "", KW_REQUIRED),
+        kw_get_int(gobj, kw, "__md_trq__`__msg_key__", 0, KW_REQUIRED)
+    );
+    if(json_object_get(priv->jn_copy_keys, copy_key)) {
         gobj_log_error(gobj, 0,
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_INTERNAL,
-            "msg",          "%s", "Not __msg_key__, free queue's msg",
-            "src",          "%s", gobj_full_name(src),
+            "msg",          "%s", "msg already batched",
+            "copy_key",     "%s", copy_key,
             NULL
         );
-        return 0; // free the queue's msg
+        return -1; // Don't send ack
+    }
+    json_object_set_new(priv->jn_copy_keys, copy_key, json_true());
+
+    json_t *jn_batch = kw_get_dict(gobj, priv->jn_copy_batches, topic_name, 0, 0);
+    if(!jn_batch) {
+        jn_batch = json_pack("{s:O, s:[]}",
+            "schema", schema,
+            "msgs"
+        );
+        json_object_set_new(priv->jn_copy_batches, topic_name, jn_batch);
+    }
+    json_t *msgs = kw_get_list(gobj, jn_batch, "msgs", 0, KW_REQUIRED);
+    json_array_append(msgs, kw);
+
+    if(json_array_size(msgs) >= (size_t)MAX(priv->copy_max_rows, 1)) {
+        flush_copy_batch(gobj, topic_name);
+    }
+
+    return -1; // Don't send ack
+}
+
+/***************************************************************************
+ *  Create the task to COPY the rows batched of the table
+ ***************************************************************************/
+PRIVATE int flush_copy_batch(hgobj gobj, const char *topic_name)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    json_t *jn_batch = kw_get_dict(gobj, priv->jn_copy_batches, topic_name, 0, 0);
+    if(!jn_batch) {
+        return 0;
     }
 
+    char task_name[NAME_MAX];
+    snprintf(task_name, sizeof(task_name), "task-copy-%s-%u", topic_name, ++priv->copy_seq);
+
+    json_t *kw_task = json_pack(
+        "{s:o, s:o, s:O, s:["
+            "{s:s, s:s, s:i}"
+            "]}",
+        "gobj_jobs", json_integer((json_int_t)(uintptr_t)gobj),
+        "gobj_results", json_integer((json_int_t)(uintptr_t)priv->gobj_postgres),
+        "input_data", jn_batch,
+        "jobs",
+            "exec_action", "action_copy_rows",
+            "exec_result", "result_copy_rows",
+            "exec_timeout", 60*1000
+    );
+
+    // WARNING topic_name can be the key, delete after using it
+    json_object_del(priv->jn_copy_batches, topic_name);
+
+    hgobj gobj_task = gobj_create_service(task_name, C_TASK, kw_task, gobj);
+    gobj_subscribe_event(gobj_task, EV_END_TASK, 0, gobj);
+    gobj_set_volatil(gobj_task, TRUE); // auto-destroy
+
+    gobj_start(gobj_task);
+
+    return 0;
+}
+
+/***************************************************************************
+ *  Forget the msgs of a batch, copied or not, they can be received again
+ ***************************************************************************/
+PRIVATE void release_copy_keys(hgobj gobj, json_t *msgs)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    size_t idx; json_t *msg;
+    json_array_foreach(msgs, idx, msg) {
+        char copy_key[NAME_MAX];
+        snprintf(copy_key, sizeof(copy_key), "%s-%"JSON_INTEGER_FORMAT,
+            kw_get_str(gobj, msg, "id", "", KW_REQUIRED),
+            kw_get_int(gobj, msg, "__md_trq__`__msg_key__", 0, KW_REQUIRED)
+        );
+        json_object_del(priv->jn_copy_keys, copy_key);
+    }
+}
+
+/***************************************************************************
+ *  Create the task to insert the row of the msg
+ ***************************************************************************/
+PRIVATE int create_add_row_task(
+    hgobj gobj,
+    json_t *kw  // NOT owned
+)
+{
+    PRIVATE_DATA *priv = gobj_priv_data(gobj);
+
+    /*-----------------------------*
+     *      Build task name
+     *-----------------------------*/
+    const char *id = kw_get_str(gobj, kw, "id", "", KW_REQUIRED);
+    json_int_t __msg_key__ = kw_get_int(gobj, kw, "__md_trq__`__msg_key__", 0, KW_REQUIRED);
+
     char task_name[NAME_MAX];
     snprintf(task_name, sizeof(task_name), "task-%s-%"JSON_INTEGER_FORMAT, id, __msg_key__);
 
@@ -819,7 +1212,7 @@ PRIVATE int process_msg(
             "task_name",    "%s", task_name,
             NULL
         );
-        return -1; // Don't send ack
+        return -1;
     }
 
     /*-----------------------------*
@@ -847,6 +1240,37 @@ PRIVATE int process_msg(
      *-----------------------*/
     gobj_start(gobj_task);
 
+    return 0;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE int process_msg(
+    hgobj gobj,
+    json_t *kw,  // NOT owned
+    hgobj src
+)
+{
+    json_int_t __msg_key__ = kw_get_int(gobj, kw, "__md_trq__`__msg_key__", 0, KW_REQUIRED);
+    if(!__msg_key__) {
+        gobj_log_error(gobj, 0,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_INTERNAL,
+            "msg",          "%s", "Not __msg_key__, free queue's msg",
+            "src",          "%s", gobj_full_name(src),
+            NULL
+        );
+        return 0; // free the queue's msg
+    }
+
+    json_t *schema_ = kw_get_dict(gobj, kw, "_dba_postgres`schema", 0, 0);
+    if(kw_get_bool(gobj, schema_, "append_only", 0, 0)) {
+        return batch_msg(gobj, schema_, kw);
+    }
+
+    create_add_row_task(gobj, kw);
+
     return -1; // Don't send ack
 }
 
@@ -1007,6 +1431,16 @@ PRIVATE int ac_end_task(
             json_object_set_new(kw_clear, "id", json_string(gobj_name(src)));
             gobj_send_event(priv->gobj_postgres, EV_CLEAR_QUEUE, kw_clear, gobj);
 
+            /*
+             *  The rows of a COPY without result are not acked,
+             *  let them be batched again when the sender resends them.
+             */
+            json_t *msgs = kw_get_list(
+                gobj, gobj_read_json_attr(src, "input_data"), "msgs", 0, 0
+            );
+            if(msgs) {
+                release_copy_keys(gobj, msgs);
+            }
             break;
         case 0:
             // Task end ok
@@ -1039,6 +1473,14 @@ PRIVATE int ac_timeout(hgobj gobj, gobj_event_t event, json_t *kw, hgobj src)
     priv->rxMsgsec = 0;
     priv->txMsgsec = 0;
 
+    /*
+     *  COPY the rows waiting of the append only tables
+     */
+    const char *topic_name; json_t *jn_batch; void *n;
+    json_object_foreach_safe(priv->jn_copy_batches, n, topic_name, jn_batch) {
+        flush_copy_batch(gobj, topic_name);
+    }
+
     KW_DECREF(kw);
     return 0;
 }
@@ -1118,6 +1560,8 @@ PRIVATE int create_gclass(gclass_name_t gclass_name)
     LMETHOD lmt[] = {
         {"action_add_row",                      action_add_row, 0},
         {"result_add_row",                      result_add_row, 0},
+        {"action_copy_rows",                    action_copy_rows, 0},
+        {"result_copy_rows",                    result_copy_rows, 0},
         {"action_create_table_if_not_exists",   action_create_table_if_not_exists, 0},
         {"result_create_table_if_not_exists",   result_create_table_if_not_exists, 0},
         {0, 0, 0}
@@ -11,6 +11,8 @@
  *          All Rights Reserved.
  ****************************************************************************/
 #include <yunetas.h>
+#include <c_postgres.h>
+#include <c_postgres_pool.h>
 #include "c_dba_postgres.h"
 
 /***************************************************************************
@@ -95,6 +97,8 @@ static int register_yuno_and_more(void)
     /*--------------------*
      *  Register gclass
      *--------------------*/
+    register_c_postgres();
+    register_c_postgres_pool();
     register_c_dba_postgres();
 
     /*------------------------------------------------*